@@ -0,0 +1,103 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __ANALYZER_TRACE_EXPORTER__
+#define __ANALYZER_TRACE_EXPORTER__
+
+#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+
+/* Converts the per host binary trace files written by pmlib (PMLIB_TRACE=1 or pmSetEventTracing) into one Chrome trace-event
+ * JSON file (viewable in chrome://tracing or Perfetto). Files are streamed record batch by record batch and events are written
+ * out as they are read, so memory use does not grow with the trace size. Hosts are aligned on the global barrier instant
+ * recorded in every file's header. */
+class TraceExporter
+{
+public:
+    TraceExporter(const std::string& pOutputPath);
+    
+    bool Export(const std::vector<std::string>& pTraceFiles);
+    void PrintSummary(std::ostream& pStream) const;
+
+private:
+    struct ThreadSummary
+    {
+        int deviceIndex;
+        size_t subtasksExecuted;
+        double subtaskExecutionTime;
+        double networkWaitTime;
+        double reductionTime;
+        
+        ThreadSummary(int pDeviceIndex = -1)
+        : deviceIndex(pDeviceIndex)
+        , subtasksExecuted(0)
+        , subtaskExecutionTime(0)
+        , networkWaitTime(0)
+        , reductionTime(0)
+        {}
+    };
+
+    struct HostSummary
+    {
+        size_t records;
+        size_t droppedRecords;
+        size_t stealRequests;
+        size_t stealSuccesses;
+        size_t stealFailures;
+        size_t bytesSent;
+        size_t bytesReceived;
+        std::map<unsigned int, ThreadSummary> threads;
+        
+        HostSummary()
+        : records(0)
+        , droppedRecords(0)
+        , stealRequests(0)
+        , stealSuccesses(0)
+        , stealFailures(0)
+        , bytesSent(0)
+        , bytesReceived(0)
+        {}
+    };
+
+    bool ExportFile(const std::string& pTraceFile);
+    void WriteEventSeparator();
+
+    std::string mOutputPath;
+    std::ofstream mOutputStream;
+    bool mFirstEvent;
+    std::map<unsigned int, HostSummary> mHostSummaries;
+};
+
+#endif
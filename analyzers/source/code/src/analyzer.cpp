@@ -37,6 +37,7 @@
 
 #include "analyzer.h"
 #include "benchmark.h"
+#include "traceExporter.h"
 
 #define PMLIB_INSTALL_PATH "/Users/tberi/Development/git-repositories/pmlib"
 
@@ -63,8 +64,28 @@ void Analyzer::Analyze()
     Benchmark::CopyResourceFiles();
 }
 
+/* analyzer.exe --export-trace <output json file> <pmlib trace files> exports pmlib's binary traces to Chrome trace-event JSON */
+int ExportTrace(int argc, const char* argv[])
+{
+    if(argc < 4)
+    {
+        std::cout << "Usage: " << argv[0] << " --export-trace <output json file> <pmlib_trace_*.bin files>" << std::endl;
+        return 1;
+    }
+
+    TraceExporter lExporter(argv[2]);
+    bool lSuccess = lExporter.Export(std::vector<std::string>(argv + 3, argv + argc));
+
+    lExporter.PrintSummary(std::cout);
+    
+    return (lSuccess ? 0 : 1);
+}
+
 int main(int argc, const char* argv[])
 {
+    if(argc > 1 && std::string(argv[1]) == "--export-trace")
+        return ExportTrace(argc, argv);
+
 #ifdef BUILD_FOR_DISTRIBUTION
     const char* lBasePath = DISTRIB_INSTALL_PATH;   // Macro defined in Makefile
 
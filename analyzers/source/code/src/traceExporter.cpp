@@ -0,0 +1,435 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include "traceExporter.h"
+#include "pmTraceFormat.h"
+
+using namespace pm::traceFormat;
+
+const size_t TRACE_READ_BUFFER_SIZE = (1024 * 1024);
+const size_t TRACE_READ_BATCH_RECORDS = 4096;
+
+enum TraceEventKind
+{
+    GENERIC_EVENT,
+    SUBTASK_EXECUTION_EVENT,
+    SUBTASK_REDUCTION_EVENT,
+    WAIT_ON_NETWORK_EVENT,
+    STEAL_REQUEST_EVENT,
+    STEAL_SUCCESS_EVENT,
+    STEAL_FAILURE_EVENT,
+    MEMORY_SEND_EVENT,
+    MEMORY_RECEIVE_EVENT
+};
+
+/* Names (as written by pmTracer) and argument meanings of the events pmlib records; other events export their raw arguments */
+struct TraceEventDescriptor
+{
+    const char* name;
+    TraceEventKind kind;
+    const char* arg1Name;   // Task keys are exported as "host:sequence number"
+    const char* arg2Name;
+    bool arg1IsTaskKey;
+};
+
+const TraceEventDescriptor TraceEventDescriptors[] =
+{
+    {"SubtaskExecution", SUBTASK_EXECUTION_EVENT, "task", "subtask", true},
+    {"SubtaskReduction", SUBTASK_REDUCTION_EVENT, "task", "subtask", true},
+    {"WaitOnNetwork", WAIT_ON_NETWORK_EVENT, "task", "subtask", true},
+    {"StealRequest", STEAL_REQUEST_EVENT, "task", "targetHost", true},
+    {"StealSuccessResponse", STEAL_SUCCESS_EVENT, "task", "subtasks", true},
+    {"StealFailureResponse", STEAL_FAILURE_EVENT, "task", "stealingHost", true},
+    {"MemorySend", MEMORY_SEND_EVENT, "destinationHost", "bytes", false},
+    {"MemoryReceive", MEMORY_RECEIVE_EVENT, "task", "bytes", true}
+};
+
+struct TraceEvent
+{
+    std::string name;
+    TraceEventKind kind;
+    std::string arg1Name;
+    std::string arg2Name;
+    bool arg1IsTaskKey;
+    
+    TraceEvent(const std::string& pName = std::string())
+    : name(pName)
+    , kind(GENERIC_EVENT)
+    , arg1Name("arg1")
+    , arg2Name("arg2")
+    , arg1IsTaskKey(false)
+    {
+        for(size_t i = 0; i < sizeof(TraceEventDescriptors) / sizeof(TraceEventDescriptors[0]); ++i)
+        {
+            if(name == TraceEventDescriptors[i].name)
+            {
+                kind = TraceEventDescriptors[i].kind;
+                arg1Name = TraceEventDescriptors[i].arg1Name;
+                arg2Name = TraceEventDescriptors[i].arg2Name;
+                arg1IsTaskKey = TraceEventDescriptors[i].arg1IsTaskKey;
+
+                break;
+            }
+        }
+    }
+};
+
+std::string EscapeJson(const std::string& pStr)
+{
+    std::string lEscapedStr;
+    lEscapedStr.reserve(pStr.length());
+
+    for(size_t i = 0; i < pStr.length(); ++i)
+    {
+        char lChar = pStr[i];
+
+        if(lChar == '"' || lChar == '\\')
+        {
+            lEscapedStr += '\\';
+            lEscapedStr += lChar;
+        }
+        else if((unsigned char)lChar < 0x20)
+        {
+            lEscapedStr += ' ';
+        }
+        else
+        {
+            lEscapedStr += lChar;
+        }
+    }
+    
+    return lEscapedStr;
+}
+
+template<typename T>
+bool ReadFromTrace(FILE* pFile, T* pData, size_t pCount = 1)
+{
+    return (fread(pData, sizeof(T), pCount, pFile) == pCount);
+}
+
+TraceExporter::TraceExporter(const std::string& pOutputPath)
+: mOutputPath(pOutputPath)
+, mFirstEvent(true)
+{
+}
+
+bool TraceExporter::Export(const std::vector<std::string>& pTraceFiles)
+{
+    mOutputStream.open(mOutputPath.c_str());
+    if(!mOutputStream.good())
+    {
+        std::cout << "Failed to open " << mOutputPath << std::endl;
+        return false;
+    }
+    
+    mOutputStream << std::fixed << std::setprecision(3);
+    mOutputStream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool lSuccess = true;
+
+    std::vector<std::string>::const_iterator lIter = pTraceFiles.begin(), lEndIter = pTraceFiles.end();
+    for(; lIter != lEndIter; ++lIter)
+        lSuccess &= ExportFile(*lIter);
+    
+    mOutputStream << std::endl << "]}" << std::endl;
+    mOutputStream.close();
+    
+    return lSuccess;
+}
+
+void TraceExporter::WriteEventSeparator()
+{
+    mOutputStream << (mFirstEvent ? "" : ",") << std::endl;
+    mFirstEvent = false;
+}
+
+bool TraceExporter::ExportFile(const std::string& pTraceFile)
+{
+    FILE* lFile = fopen(pTraceFile.c_str(), "rb");
+    if(!lFile)
+    {
+        std::cout << "Failed to open " << pTraceFile << std::endl;
+        return false;
+    }
+    
+    std::vector<char> lReadBuffer(TRACE_READ_BUFFER_SIZE);
+    setvbuf(lFile, &lReadBuffer[0], _IOFBF, lReadBuffer.size());
+
+    fileHeader lHeader;
+    if(!ReadFromTrace(lFile, &lHeader) || memcmp(lHeader.magic, TRACE_FILE_MAGIC, sizeof(lHeader.magic)) || lHeader.version != TRACE_FILE_VERSION || lHeader.recordSize != sizeof(eventRecord))
+    {
+        std::cout << pTraceFile << " is not a supported pmlib trace file" << std::endl;
+        fclose(lFile);
+
+        return false;
+    }
+    
+    HostSummary& lHostSummary = mHostSummaries[lHeader.hostId];
+
+    WriteEventSeparator();
+    mOutputStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << lHeader.hostId << ",\"args\":{\"name\":\"Host " << lHeader.hostId << "\"}}";
+
+    std::vector<TraceEvent> lEvents;
+    std::map<std::pair<unsigned int, uint16_t>, std::vector<uint64_t>> lOpenEvents;    // Begin timestamps of events yet to end on each thread
+    std::vector<eventRecord> lRecords(TRACE_READ_BATCH_RECORDS);
+    bool lTruncated = false;
+    
+    blockHeader lBlockHeader;
+    while(!lTruncated && ReadFromTrace(lFile, &lBlockHeader))
+    {
+        switch(lBlockHeader.type)
+        {
+            case EVENT_NAMES_BLOCK:
+            {
+                for(uint32_t i = 0; !lTruncated && i < lBlockHeader.count; ++i)
+                {
+                    uint16_t lEventId = 0, lLength = 0;
+                    std::string lName;
+
+                    lTruncated = !(ReadFromTrace(lFile, &lEventId) && ReadFromTrace(lFile, &lLength));
+                    
+                    if(!lTruncated)
+                    {
+                        lName.resize(lLength);
+                        lTruncated = (lLength && !ReadFromTrace(lFile, &lName[0], lLength));
+                    }
+                    
+                    if(!lTruncated)
+                    {
+                        if(lEvents.size() <= lEventId)
+                            lEvents.resize(lEventId + 1);
+
+                        lEvents[lEventId] = TraceEvent(lName);
+                    }
+                }
+                
+                break;
+            }
+                
+            case THREADS_BLOCK:
+            {
+                for(uint32_t i = 0; !lTruncated && i < lBlockHeader.count; ++i)
+                {
+                    threadEntry lEntry;
+                    lTruncated = !ReadFromTrace(lFile, &lEntry);
+                    
+                    if(!lTruncated)
+                    {
+                        lHostSummary.threads[lEntry.threadIndex] = ThreadSummary(lEntry.deviceIndex);
+
+                        WriteEventSeparator();
+                        mOutputStream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << lHeader.hostId << ",\"tid\":" << lEntry.threadIndex << ",\"args\":{\"name\":\"";
+                        
+                        if(lEntry.deviceIndex == NO_TRACE_DEVICE)
+                            mOutputStream << "Thread " << lEntry.threadIndex;
+                        else
+                            mOutputStream << "Device " << lEntry.deviceIndex;
+                        
+                        mOutputStream << "\"}}";
+                    }
+                }
+                
+                break;
+            }
+                
+            case RECORDS_BLOCK:
+            {
+                uint32_t lRemaining = lBlockHeader.count;
+
+                while(!lTruncated && lRemaining)
+                {
+                    size_t lBatch = std::min<size_t>(lRemaining, lRecords.size());
+                    size_t lRead = fread(&lRecords[0], sizeof(eventRecord), lBatch, lFile);
+                    
+                    lTruncated = (lRead != lBatch);     // Records preceding the truncation are still exported
+                    lBatch = lRead;
+                    
+                    lRemaining -= (uint32_t)lBatch;
+                    lHostSummary.records += lBatch;
+
+                    for(size_t i = 0; i < lBatch; ++i)
+                    {
+                        const eventRecord& lRecord = lRecords[i];
+                        
+                        if(lEvents.size() <= lRecord.eventId)
+                            lEvents.resize(lRecord.eventId + 1);
+
+                        TraceEvent& lEvent = lEvents[lRecord.eventId];
+                        if(lEvent.name.empty())
+                        {
+                            std::stringstream lStream;
+                            lStream << "Event " << lRecord.eventId;
+
+                            lEvent = TraceEvent(lStream.str());
+                        }
+
+                        // Align hosts on the global barrier instant (ts is in microseconds)
+                        double lTimeStamp = (double)((int64_t)(lRecord.timestamp - lHeader.monotonicBaseNs)) / 1000.0;
+                        
+                        WriteEventSeparator();
+                        mOutputStream << "{\"name\":\"" << EscapeJson(lEvent.name) << "\",\"cat\":\"pmlib\",\"ph\":\"" << ((lRecord.phase == PHASE_BEGIN) ? "B" : ((lRecord.phase == PHASE_END) ? "E" : "i")) << "\",\"ts\":" << lTimeStamp << ",\"pid\":" << lHeader.hostId << ",\"tid\":" << lRecord.threadIndex;
+                        
+                        if(lRecord.phase == PHASE_INSTANT)
+                            mOutputStream << ",\"s\":\"t\"";
+                        
+                        if(lRecord.phase != PHASE_END)
+                        {
+                            mOutputStream << ",\"args\":{\"" << lEvent.arg1Name << "\":";
+
+                            if(lEvent.arg1IsTaskKey)
+                                mOutputStream << "\"" << GetTaskKeyHost(lRecord.arg1) << ":" << GetTaskKeySequenceNumber(lRecord.arg1) << "\"";
+                            else
+                                mOutputStream << lRecord.arg1;
+
+                            mOutputStream << ",\"" << lEvent.arg2Name << "\":" << lRecord.arg2 << "}";
+                        }
+
+                        mOutputStream << "}";
+
+                        switch(lRecord.phase)
+                        {
+                            case PHASE_BEGIN:
+                                lOpenEvents[std::make_pair(lRecord.threadIndex, lRecord.eventId)].push_back(lRecord.timestamp);
+                                break;
+                                
+                            case PHASE_END:
+                            {
+                                std::vector<uint64_t>& lBeginTimeStamps = lOpenEvents[std::make_pair(lRecord.threadIndex, lRecord.eventId)];
+                                if(lBeginTimeStamps.empty())
+                                    break;
+                                
+                                double lDuration = (double)(lRecord.timestamp - lBeginTimeStamps.back()) / 1000000000.0;
+                                lBeginTimeStamps.pop_back();
+
+                                ThreadSummary& lThreadSummary = lHostSummary.threads[lRecord.threadIndex];
+
+                                if(lEvent.kind == SUBTASK_EXECUTION_EVENT)
+                                {
+                                    ++lThreadSummary.subtasksExecuted;
+                                    lThreadSummary.subtaskExecutionTime += lDuration;
+                                }
+                                else if(lEvent.kind == WAIT_ON_NETWORK_EVENT)
+                                {
+                                    lThreadSummary.networkWaitTime += lDuration;
+                                }
+                                else if(lEvent.kind == SUBTASK_REDUCTION_EVENT)
+                                {
+                                    lThreadSummary.reductionTime += lDuration;
+                                }
+                                
+                                break;
+                            }
+                                
+                            default:
+                            {
+                                if(lEvent.kind == STEAL_REQUEST_EVENT)
+                                    ++lHostSummary.stealRequests;
+                                else if(lEvent.kind == STEAL_SUCCESS_EVENT)
+                                    ++lHostSummary.stealSuccesses;
+                                else if(lEvent.kind == STEAL_FAILURE_EVENT)
+                                    ++lHostSummary.stealFailures;
+                                else if(lEvent.kind == MEMORY_SEND_EVENT)
+                                    lHostSummary.bytesSent += lRecord.arg2;
+                                else if(lEvent.kind == MEMORY_RECEIVE_EVENT)
+                                    lHostSummary.bytesReceived += lRecord.arg2;
+
+                                break;
+                            }
+                        }
+                    }
+                }
+                
+                break;
+            }
+                
+            case DROPPED_RECORDS_BLOCK:
+            {
+                for(uint32_t i = 0; !lTruncated && i < lBlockHeader.count; ++i)
+                {
+                    droppedEntry lEntry;
+                    lTruncated = !ReadFromTrace(lFile, &lEntry);
+                    
+                    if(!lTruncated)
+                        lHostSummary.droppedRecords += lEntry.count;
+                }
+
+                break;
+            }
+                
+            default:
+            {
+                std::cout << pTraceFile << " has an unknown block type " << lBlockHeader.type << "; ignoring rest of the file" << std::endl;
+                lTruncated = true;
+                
+                break;
+            }
+        }
+    }
+    
+    if(lTruncated)
+        std::cout << pTraceFile << " is truncated; exported the records preceding the truncation" << std::endl;
+
+    fclose(lFile);
+
+    return true;
+}
+
+void TraceExporter::PrintSummary(std::ostream& pStream) const
+{
+    std::map<unsigned int, HostSummary>::const_iterator lHostIter = mHostSummaries.begin(), lHostEndIter = mHostSummaries.end();
+    for(; lHostIter != lHostEndIter; ++lHostIter)
+    {
+        const HostSummary& lHostSummary = lHostIter->second;
+
+        pStream << "Host " << lHostIter->first << ": Records = " << lHostSummary.records << "; Dropped Records = " << lHostSummary.droppedRecords << "; Steal Requests = " << lHostSummary.stealRequests << "; Steal Successes = " << lHostSummary.stealSuccesses << "; Steal Failures = " << lHostSummary.stealFailures << "; Bytes Sent = " << lHostSummary.bytesSent << "; Bytes Received = " << lHostSummary.bytesReceived << std::endl;
+        
+        std::map<unsigned int, ThreadSummary>::const_iterator lThreadIter = lHostSummary.threads.begin(), lThreadEndIter = lHostSummary.threads.end();
+        for(; lThreadIter != lThreadEndIter; ++lThreadIter)
+        {
+            const ThreadSummary& lThreadSummary = lThreadIter->second;
+            
+            if(lThreadSummary.deviceIndex == NO_TRACE_DEVICE)
+                continue;
+
+            pStream << "    Device " << lThreadSummary.deviceIndex << ": Subtasks Executed = " << lThreadSummary.subtasksExecuted << "; Execution Time = " << lThreadSummary.subtaskExecutionTime << " secs; Network Wait Time = " << lThreadSummary.networkWaitTime << " secs; Reduction Time = " << lThreadSummary.reductionTime << " secs" << std::endl;
+        }
+    }
+}
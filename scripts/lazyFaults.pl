@@ -0,0 +1,285 @@
+#!/usr/bin/perl
+
+# Compares eager and lazy (demand paged) fetching of the dense input of the sparseSolver testsuite, by running it with
+# PMLIB_ENABLE_LAZY_MEM set to 0 and 1. The lazy faults reported in the task exec stats (when logged) are summed up over all hosts.
+# Usage: lazyFaults.pl [samples] [min procs] [max procs] [hosts file] [min pow dim] [max pow dim]
+
+use Cwd 'abs_path';
+my($script_path) = abs_path($0);
+
+$script_path =~ /(.*)\/.*\/.*$/;
+my($pm_base_path) = $1;
+
+my($linux) = `uname -a | grep Linux`;
+chomp($linux);
+
+my($samples, $minProcs, $maxProcs, $hostsFile, $minPowDim, $maxPowDim);
+
+main();
+
+sub main
+{
+    my($testSuite) = "sparseSolver";
+
+    my($exec_path) = "$pm_base_path/testSuite/$testSuite/build/linux/release/$testSuite.exe";
+    die "Invalid executable $exec_path" if(!-e $exec_path);
+
+    getInputs();
+
+    $benchmarkName = $testSuite;
+    $clusterHosts = "localhost";
+    if($hostsFile !~ /^$/)
+    {
+        open(FH, $hostsFile) || die "Invalid hostsfile $hostsFile";
+
+        $clusterHosts = "";
+        while(<FH>)
+        {
+            chomp;
+
+            if(!/^\s*$/)
+            {
+                if(!/^\s*\#/)
+                {
+                    $clusterHosts .= "$_ ";
+                }
+            }
+        }
+
+        close(FH);
+
+        if($clusterHosts =~ /^$/)
+        {
+            $clusterHosts = "localhost";
+        }
+    }
+
+    $~ = HEADER;
+    write;
+
+    computeResults($exec_path);
+}
+
+sub computeResults
+{
+    my($exec_path) = @_;
+
+    for($hosts = $minProcs; $hosts <= $maxProcs; ++$hosts)
+    {
+	$~ = SUBHEADER;
+	write;
+
+	for($powDim = $minPowDim; $powDim <= $maxPowDim; ++$powDim)
+	{
+	    execute($exec_path, $hosts, $powDim);
+	}
+
+	$~ = FOOTER;
+	write;
+    }
+}
+
+sub execute
+{
+    my($exec_path, $procs, $powDim) = @_;
+
+    $varying_str = sprintf("%d", 2 ** $powDim);
+
+    my($cmd_prefix) = "mpirun -x PMLIB_ENABLE_LAZY_MEM ";
+
+    if($linux !~ /^\s*$/)
+    {
+        $cmd_prefix .= "--mca btl_tcp_if_include lo,eth0 --mca mpi_preconnect_mpi 1 ";
+    }
+
+    if($hostsFile !~ /^$/)
+    {
+        $cmd_prefix .= "--hostfile $hostsFile ";
+    }
+
+    my($mode) = 4;  # Global CPU (only CPU subtasks access memory lazily)
+    my($schedModel) = 0;    # Push model
+    my($runLevel) = 0;  # Do not compare to serial
+
+    my(@means, @faults);
+    foreach $lazy(0, 1)
+    {
+	my(@times);
+	my($faultCount) = 0;
+
+	$ENV{'PMLIB_ENABLE_LAZY_MEM'} = $lazy;
+
+	my($cmd) = $cmd_prefix;
+	$cmd .= "-n $procs $exec_path $runLevel $mode $schedModel " . (2 ** $powDim);
+
+	my($k);
+	for($k=0; $k<$samples; ++$k)
+	{
+	    my(@output) = `$cmd 2>&1`;
+
+	    my($line);
+	    foreach $line(@output)
+	    {
+		if($line =~ /Parallel Task $mode Execution Time = ([0-9.]+)/)
+		{
+		    push(@times, $1);
+		}
+		elsif($line =~ /Lazy faults = ([0-9]+)/)
+		{
+		    $faultCount += $1;
+		}
+	    }
+	}
+
+	if($#times >= 0)
+	{
+	    push(@means, mean(\@times));
+	}
+	else
+	{
+	    push(@means, "XXX");
+	}
+
+	push(@faults, int($faultCount / $samples));
+    }
+
+    delete $ENV{'PMLIB_ENABLE_LAZY_MEM'};
+
+    ($eager_time, $lazy_time) = @means;
+    $lazy_faults = $faults[1];
+
+    $~ = DATA;
+    write;
+}
+
+sub getInputs
+{
+    $samples = getIntegralInput(0, "\nSamples ... ", "Invalid Samples", 1, 5);
+    $minProcs = getIntegralInput(1, "Min Procs ... ", "Invalid Min Procs", 2, 10000);
+    $maxProcs = getIntegralInput(2, "Max Procs ... ", "Invalid Max Procs", 2, 10000);
+
+    die "Min procs $minProcs can't be more than max procs $maxProcs" if($maxProcs < $minProcs);
+
+    $hostsFile = getHostsFile(3);
+
+    $minPowDim = getIntegralInput(4, "Min power of two matrix dimension ... ", "Invalid power", 11, 16);
+    $maxPowDim = getIntegralInput(5, "Max power of two matrix dimension ... ", "Invalid power", 11, 16);
+
+    die "Min power $minPowDim can't be more than max power $maxPowDim" if($maxPowDim < $minPowDim);
+}
+
+sub getIntegralInput
+{
+    my($commandLineIndex, $choiceMsg, $errorMsg, $minVal, $maxVal) = @_;
+    my($val) = -1;
+
+    if($#ARGV >= $commandLineIndex)
+    {
+        $val = $ARGV[$commandLineIndex];
+        verifyIntegerRange($val, $minVal, $maxVal) || die "$errorMsg $val";
+    }
+    else
+    {
+        print "$choiceMsg";
+        $val = readIntegerInput($minVal, $maxVal);
+    }
+
+    return $val;
+}
+
+sub getHostsFile
+{
+    my($commandLineIndex) = @_;
+
+    my($hostsFile) = "";
+
+    if($#ARGV >= $commandLineIndex)
+    {
+        $hostsFile = $ARGV[$commandLineIndex];
+    }
+    else
+    {
+        print "\nHosts File ... ";
+        $hostsFile = readStringInput();
+    }
+
+    if($hostsFile !~ /^$/ && !-f $hostsFile)
+    {
+        die "Illegal hosts file $hostsFile";
+    }
+
+    return $hostsFile;
+}
+
+sub readStringInput
+{
+    my $input = <STDIN>;
+    chomp($input);
+
+    return $input;
+}
+
+sub readIntegerInput
+{
+    my($lower_limit, $upper_limit) = @_;
+    my $selection = <STDIN>;
+    chomp($selection);
+
+    if($selection =~ /^[0-9]+$/ && verifyIntegerRange($selection, $lower_limit, $upper_limit))
+    {
+        return $selection;
+    }
+
+    die "Invalid Input";
+}
+
+sub verifyIntegerRange
+{
+    my($int_val, $lower_limit, $upper_limit) = @_;
+
+    if($lower_limit <= $int_val && $int_val <= $upper_limit)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+sub mean
+{
+        my ($array_ref) = @_;
+        my $sum = 0;
+        my $count = scalar @$array_ref;
+        foreach(@$array_ref) { $sum += $_; }
+
+        return sprintf("%.4f", $sum / $count);
+}
+
+
+format HEADER =
+===========================================================================
+MPI Cluster Hosts: @<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+$clusterHosts
+Benchmark: @<<<<<<<<<<<<<<<<<<<<<<     Samples: @<<<<<<<<<
+$benchmarkName, $samples
+===========================================================================
+.
+
+format SUBHEADER =
+===========================================================================
+                                 Hosts: @<<<<<<
+$hosts
+===========================================================================
+                    |  Global CPU Execution Time (in secs)  |
+   Matrix Dim       |     Eager     |     Lazy     | Lazy Faults  |
+===========================================================================
+.
+
+format DATA =
+@<<<<<<<<<<<<<<<<<<<    @<<<<<<<<<     @<<<<<<<<<     @<<<<<<<<<
+$varying_str, $eager_time, $lazy_time, $lazy_faults
+.
+
+format FOOTER =
+===========================================================================
+.
@@ -0,0 +1,176 @@
+#!/usr/bin/perl
+
+# Runs the library's microbenchmarks (make benchmarks in build/linux) and collects their machine readable PMBENCH lines.
+# Every result is the median over the given number of samples. Results are written one per line as
+# <benchmark>.<case> <value> <unit> <higher|lower>
+# (tab separated; lines starting with # are comments). If a baseline file written by an earlier run is given, every result is
+# compared against it and those worse by more than the tolerance are reported as regressions (the exit status is then 1).
+# The MPI benchmarks are started on localhost with the command in environment variable MPIRUN (default mpirun).
+# Usage: microbenchmarks.pl <results file> [baseline file or -] [tolerance percent] [samples] [steal benchmark hosts]
+
+use Cwd 'abs_path';
+my($script_path) = abs_path($0);
+
+$script_path =~ /(.*)\/.*\/.*$/;
+my($pm_base_path) = $1;
+
+my($exec_dir) = "$pm_base_path/build/linux/release";
+my($mpirun) = (defined $ENV{MPIRUN} && $ENV{MPIRUN} !~ /^\s*$/) ? $ENV{MPIRUN} : "mpirun";
+
+my($resultsFile, $baselineFile, $tolerance, $samples, $stealHosts);
+
+# Benchmark executable, its arguments, the number of MPI hosts (zero if it is not an MPI program; -1 for the steal benchmark
+# hosts) and mpirun options. The steal benchmarks run one CPU per host so that every steal crosses ranks.
+my(@benchmarks) = (
+    ["eventQueueBenchmark", "", 0, ""],
+    ["memoryDirectoryBenchmark", "4 256 5000", 0, ""],
+    ["allocatorBenchmark", "", 0, ""],
+    ["reductionBenchmark", "", 0, ""],
+    ["compressionBenchmark", "", 0, ""],
+    ["tracerBenchmark", "", 0, ""],
+    ["shadowMemoryBenchmark", "", 1, ""],
+    ["shadowMemoryBenchmark", "", 1, "-x PMLIB_SHADOW_MEM_REMAP=0"],
+    ["stealBenchmark", "", -1, "-x PMLIB_MAX_CPU_PER_HOST=1"],
+    ["prefetchStealBenchmark", "", -1, "-x PMLIB_MAX_CPU_PER_HOST=1"],
+    ["transferBandwidthBenchmark", "", 2, "-x PMLIB_MAX_CPU_PER_HOST=1"],
+);
+
+main();
+
+sub main
+{
+    getInputs();
+
+    my(%results, @order);
+
+    foreach my $benchmark(@benchmarks)
+    {
+        my($name, $args, $hosts, $mpiOptions) = @$benchmark;
+        my($exec_path) = "$exec_dir/$name.exe";
+        die "Invalid executable $exec_path (run make benchmarks in build/linux)" if(!-e $exec_path);
+
+        $hosts = $stealHosts if($hosts < 0);
+
+        my($cmd) = "$exec_path $args";
+        $cmd = "$mpirun -n $hosts $mpiOptions $cmd" if($hosts);
+
+        print "Running $name ...\n";
+
+        for(my $k = 0; $k < $samples; ++$k)
+        {
+            my(@output) = `$cmd 2>&1`;
+            die "$name failed with status $?" if($? != 0);
+
+            foreach my $line(@output)
+            {
+                if($line =~ /^PMBENCH\s+(\S+)\s+(\S+)\s+(\S+)\s+(\S+)\s+(higher|lower)\s*$/)
+                {
+                    my($key) = "$1.$2";
+                    if(!exists $results{$key})
+                    {
+                        push(@order, $key);
+                        $results{$key} = {values => [], unit => $4, better => $5};
+                    }
+
+                    push(@{$results{$key}{values}}, $3);
+                }
+            }
+        }
+    }
+
+    open(OUT, ">$resultsFile") || die "Can't write results file $resultsFile";
+    print OUT "# pmlib microbenchmarks; samples = $samples; " . localtime() . "\n";
+
+    foreach my $key(@order)
+    {
+        $results{$key}{median} = median(@{$results{$key}{values}});
+        print OUT "$key\t$results{$key}{median}\t$results{$key}{unit}\t$results{$key}{better}\n";
+    }
+
+    close(OUT);
+
+    print "\nWrote " . scalar(@order) . " results to $resultsFile\n";
+
+    exit(0) if($baselineFile =~ /^(-|)$/);
+
+    my(%baseline) = readResults($baselineFile);
+    my($regressions) = 0;
+
+    printf("\n%-50s %14s %14s %9s\n", "Result", "Baseline", "Current", "Change");
+
+    foreach my $key(@order)
+    {
+        next if(!exists $baseline{$key});
+
+        my($old) = $baseline{$key}{value};
+        my($new) = $results{$key}{median};
+        next if($old == 0);
+
+        # Positive changes are improvements irrespective of the direction of the metric
+        my($change) = ($new - $old) * 100.0 / abs($old);
+        $change = -$change if($results{$key}{better} eq "lower");
+
+        my($flag) = "";
+        if($change < -$tolerance)
+        {
+            $flag = " REGRESSION";
+            ++$regressions;
+        }
+
+        printf("%-50s %14.6g %14.6g %+8.1f%%%s\n", $key, $old, $new, $change, $flag);
+    }
+
+    foreach my $key(@order)
+    {
+        print "$key is not in the baseline\n" if(!exists $baseline{$key});
+    }
+
+    print "\n$regressions regression(s) beyond $tolerance%\n";
+
+    exit($regressions ? 1 : 0);
+}
+
+sub median
+{
+    my(@values) = sort { $a <=> $b } @_;
+    my($count) = scalar(@values);
+
+    return ($count % 2) ? $values[$count / 2] : (($values[$count / 2 - 1] + $values[$count / 2]) / 2);
+}
+
+sub readResults
+{
+    my($file) = @_;
+    my(%results);
+
+    open(FH, $file) || die "Invalid baseline file $file";
+
+    while(<FH>)
+    {
+        chomp;
+        next if(/^\s*$/ || /^\s*\#/);
+
+        my($key, $value, $unit, $better) = split(/\t/);
+        $results{$key} = {value => $value, unit => $unit, better => $better};
+    }
+
+    close(FH);
+
+    return %results;
+}
+
+sub getInputs
+{
+    die "Usage: microbenchmarks.pl <results file> [baseline file or -] [tolerance percent] [samples] [steal benchmark hosts]" if($#ARGV < 0);
+
+    $resultsFile = $ARGV[0];
+    $baselineFile = ($#ARGV >= 1) ? $ARGV[1] : "";
+    $tolerance = ($#ARGV >= 2) ? $ARGV[2] : 10;
+    $samples = ($#ARGV >= 3) ? $ARGV[3] : 3;
+    $stealHosts = ($#ARGV >= 4) ? $ARGV[4] : 2;
+
+    die "Invalid tolerance $tolerance" if($tolerance !~ /^[0-9.]+$/);
+    die "Invalid samples $samples" if($samples !~ /^[0-9]+$/ || $samples < 1);
+    die "Invalid hosts $stealHosts" if($stealHosts !~ /^[0-9]+$/ || $stealHosts < 2);
+    die "Invalid baseline file $baselineFile" if($baselineFile !~ /^(-|)$/ && !-f $baselineFile);
+}
@@ -0,0 +1,291 @@
+#!/usr/bin/perl
+
+# Compares cross machine reduction topologies (binomial tree, ring and recursive halving) along with the library's
+# automatic choice, by running the reductionBandwidth testsuite under each value of PMLIB_REDUCTION_TOPOLOGY.
+# Usage: reductionTopologies.pl [samples] [min procs] [max procs] [hosts file] [min pow elems] [max pow elems] [subtasks] [reduction op]
+
+use Cwd 'abs_path';
+my($script_path) = abs_path($0);
+
+$script_path =~ /(.*)\/.*\/.*$/;
+my($pm_base_path) = $1;
+
+my($linux) = `uname -a | grep Linux`;
+chomp($linux);
+
+my($samples, $minProcs, $maxProcs, $hostsFile, $minPowElems, $maxPowElems, $subtasks, $reductionOp);
+my(@topologies) = ("tree", "ring", "halving", "");
+
+main();
+
+sub main
+{
+    my($testSuite) = "reductionBandwidth";
+
+    my($exec_path) = "$pm_base_path/testSuite/$testSuite/build/linux/release/$testSuite.exe";
+    die "Invalid executable $exec_path" if(!-e $exec_path);
+
+    getInputs();
+
+    $benchmarkName = $testSuite;
+    $clusterHosts = "localhost";
+    if($hostsFile !~ /^$/)
+    {
+        open(FH, $hostsFile) || die "Invalid hostsfile $hostsFile";
+
+        $clusterHosts = "";
+        while(<FH>)
+        {
+            chomp;
+
+            if(!/^\s*$/)
+            {
+                if(!/^\s*\#/)
+                {
+                    $clusterHosts .= "$_ ";
+                }
+            }
+        }
+
+        close(FH);
+
+        if($clusterHosts =~ /^$/)
+        {
+            $clusterHosts = "localhost";
+        }
+    }
+
+    $~ = HEADER;
+    write;
+
+    computeResults($exec_path);
+}
+
+sub computeResults
+{
+    my($exec_path) = @_;
+
+    for($hosts = $minProcs; $hosts <= $maxProcs; ++$hosts)
+    {
+	$~ = SUBHEADER;
+	write;
+
+	for($powElems = $minPowElems; $powElems <= $maxPowElems; ++$powElems)
+	{
+	    execute($exec_path, $hosts, $powElems);
+	}
+
+	$~ = FOOTER;
+	write;
+    }
+}
+
+sub execute
+{
+    my($exec_path, $procs, $powElems) = @_;
+
+    $varying_str = sprintf("2^%d (%s)", $powElems, getSizeString((2 ** $powElems) * 4));
+
+    my($cmd_prefix) = "mpirun -x PMLIB_REDUCTION_TOPOLOGY ";
+
+    if($linux !~ /^\s*$/)
+    {
+        $cmd_prefix .= "--mca btl_tcp_if_include lo,eth0 --mca mpi_preconnect_mpi 1 ";
+    }
+
+    if($hostsFile !~ /^$/)
+    {
+        $cmd_prefix .= "--hostfile $hostsFile ";
+    }
+
+    my($mode) = 4;  # Global CPU
+    my($schedModel) = 0;    # Push model
+    my($runLevel) = 0;  # Do not compare to serial
+
+    my(@means);
+    foreach $topology(@topologies)
+    {
+	my(@times);
+
+	$ENV{'PMLIB_REDUCTION_TOPOLOGY'} = $topology;
+
+	my($cmd) = $cmd_prefix;
+	$cmd .= "-n $procs $exec_path $runLevel $mode $schedModel $powElems $subtasks $reductionOp";
+
+	my($k);
+	for($k=0; $k<$samples; ++$k)
+	{
+	    my(@output) = `$cmd`;
+
+	    my($line);
+	    foreach $line(@output)
+	    {
+		if($line =~ /Parallel Task $mode Execution Time = ([0-9.]+)/)
+		{
+		    push(@times, $1);
+		}
+	    }
+	}
+
+	if($#times >= 0)
+	{
+	    push(@means, mean(\@times));
+	}
+	else
+	{
+	    push(@means, "XXX");
+	}
+    }
+
+    delete $ENV{'PMLIB_REDUCTION_TOPOLOGY'};
+
+    ($tree_time, $ring_time, $halving_time, $auto_time) = @means;
+
+    $~ = DATA;
+    write;
+}
+
+sub getInputs
+{
+    $samples = getIntegralInput(0, "\nSamples ... ", "Invalid Samples", 1, 5);
+    $minProcs = getIntegralInput(1, "Min Procs ... ", "Invalid Min Procs", 2, 10000);
+    $maxProcs = getIntegralInput(2, "Max Procs ... ", "Invalid Max Procs", 2, 10000);
+
+    die "Min procs $minProcs can't be more than max procs $maxProcs" if($maxProcs < $minProcs);
+
+    $hostsFile = getHostsFile(3);
+
+    $minPowElems = getIntegralInput(4, "Min power of two elements reduced ... ", "Invalid power", 10, 28);
+    $maxPowElems = getIntegralInput(5, "Max power of two elements reduced ... ", "Invalid power", 10, 28);
+
+    die "Min power $minPowElems can't be more than max power $maxPowElems" if($maxPowElems < $minPowElems);
+
+    $subtasks = getIntegralInput(6, "Subtasks ... ", "Invalid subtasks", 1, 100000);
+    $reductionOp = getIntegralInput(7, "Reduction operation (see reductionBandwidth) ... ", "Invalid reduction operation", 0, 10);
+}
+
+sub getIntegralInput
+{
+    my($commandLineIndex, $choiceMsg, $errorMsg, $minVal, $maxVal) = @_;
+    my($val) = -1;
+
+    if($#ARGV >= $commandLineIndex)
+    {
+        $val = $ARGV[$commandLineIndex];
+        verifyIntegerRange($val, $minVal, $maxVal) || die "$errorMsg $val";
+    }
+    else
+    {
+        print "$choiceMsg";
+        $val = readIntegerInput($minVal, $maxVal);
+    }
+
+    return $val;
+}
+
+sub getHostsFile
+{
+    my($commandLineIndex) = @_;
+
+    my($hostsFile) = "";
+
+    if($#ARGV >= $commandLineIndex)
+    {
+        $hostsFile = $ARGV[$commandLineIndex];
+    }
+    else
+    {
+        print "\nHosts File ... ";
+        $hostsFile = readStringInput();
+    }
+
+    if($hostsFile !~ /^$/ && !-f $hostsFile)
+    {
+        die "Illegal hosts file $hostsFile";
+    }
+
+    return $hostsFile;
+}
+
+sub getSizeString
+{
+    my($bytes) = @_;
+
+    return sprintf("%d MB", $bytes / (1024 * 1024)) if($bytes >= 1024 * 1024);
+    return sprintf("%d KB", $bytes / 1024);
+}
+
+sub readStringInput
+{
+    my $input = <STDIN>;
+    chomp($input);
+
+    return $input;
+}
+
+sub readIntegerInput
+{
+    my($lower_limit, $upper_limit) = @_;
+    my $selection = <STDIN>;
+    chomp($selection);
+
+    if($selection =~ /^[0-9]+$/ && verifyIntegerRange($selection, $lower_limit, $upper_limit))
+    {
+        return $selection;
+    }
+
+    die "Invalid Input";
+}
+
+sub verifyIntegerRange
+{
+    my($int_val, $lower_limit, $upper_limit) = @_;
+
+    if($lower_limit <= $int_val && $int_val <= $upper_limit)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+sub mean
+{
+        my ($array_ref) = @_;
+        my $sum = 0;
+        my $count = scalar @$array_ref;
+        foreach(@$array_ref) { $sum += $_; }
+
+        return sprintf("%.4f", $sum / $count);
+}
+
+
+format HEADER =
+===========================================================================
+MPI Cluster Hosts: @<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+$clusterHosts
+Benchmark: @<<<<<<<<<<<<<<<<<<<<<<     Samples: @<<<<<<<<<
+$benchmarkName, $samples
+Subtasks: @<<<<<<<<<<     Reduction Operation: @<<<<<<<<<
+$subtasks, $reductionOp
+===========================================================================
+.
+
+format SUBHEADER =
+===========================================================================
+                                 Hosts: @<<<<<<
+$hosts
+===========================================================================
+                    |     Global CPU Execution Time (in secs)     |
+   Elements (Size)  |   Tree    |   Ring    |  Halving  |   Auto    |
+===========================================================================
+.
+
+format DATA =
+@<<<<<<<<<<<<<<<<<<< @<<<<<<<<<  @<<<<<<<<<  @<<<<<<<<<  @<<<<<<<<<
+$varying_str, $tree_time, $ring_time, $halving_time, $auto_time
+.
+
+format FOOTER =
+===========================================================================
+.
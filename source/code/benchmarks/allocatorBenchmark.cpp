@@ -0,0 +1,174 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark measuring allocation and deallocation through the library's allocators.
+ * Usage: allocatorBenchmark.exe [threads] [allocations per round] [rounds] [allocation size KB]
+ * pool       - pmPoolAllocator over heap memory; every thread allocates a batch of buffers and releases them (as stubs do
+ *              with their scratch buffers)
+ * pool paged - the same over page aligned memory checked out from the memory manager
+ * malloc     - the same through malloc/free, for reference
+ * chunk      - pmMemChunk sub-allocating buffers of varying sizes and alignments from one chunk with a window of live
+ *              allocations released out of order (as with device and pinned buffers)
+ */
+
+#include "pmBase.h"
+#include "pmPoolAllocator.h"
+#include "pmMemChunk.h"
+#include "benchmarkResults.h"
+
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+const uint CHUNK_LIVE_ALLOCATIONS = 64;
+const size_t CHUNK_ALIGNMENT = 256;
+
+template<typename allocateFunc, typename deallocateFunc>
+double BenchmarkBatches(uint pThreads, uint pAllocationsPerRound, uint pRounds, allocateFunc pAllocateFunc, deallocateFunc pDeallocateFunc)
+{
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    std::vector<std::thread> lThreads;
+    for(uint i = 0; i < pThreads; ++i)
+    {
+        lThreads.emplace_back([&] ()
+        {
+            std::vector<void*> lAllocations(pAllocationsPerRound);
+
+            for(uint j = 0; j < pRounds; ++j)
+            {
+                for(uint k = 0; k < pAllocationsPerRound; ++k)
+                {
+                    lAllocations[k] = pAllocateFunc();
+                    if(!lAllocations[k])
+                        exit(1);
+                }
+
+                for(uint k = 0; k < pAllocationsPerRound; ++k)
+                    pDeallocateFunc(lAllocations[k]);
+            }
+        });
+    }
+
+    for(uint i = 0; i < pThreads; ++i)
+        lThreads[i].join();
+
+    return pmBase::GetCurrentTimeInSecs() - lStartTime;
+}
+
+double BenchmarkPool(bool pPageAligned, uint pThreads, uint pAllocationsPerRound, uint pRounds, size_t pAllocationSize)
+{
+    pmPoolAllocator lPoolAllocator(pAllocationSize, (size_t)pThreads * pAllocationsPerRound, pPageAligned);
+
+    double lTime = BenchmarkBatches(pThreads, pAllocationsPerRound, pRounds, [&] () {return lPoolAllocator.Allocate(pAllocationSize);}, [&] (void* pMem) {lPoolAllocator.Deallocate(pMem);});
+
+    if(!lPoolAllocator.HasNoAllocations())
+        exit(1);
+
+    return lTime;
+}
+
+double BenchmarkMalloc(uint pThreads, uint pAllocationsPerRound, uint pRounds, size_t pAllocationSize)
+{
+    return BenchmarkBatches(pThreads, pAllocationsPerRound, pRounds, [&] () {return malloc(pAllocationSize);}, [] (void* pMem) {free(pMem);});
+}
+
+double BenchmarkChunk(uint pOperations, size_t pAllocationSize)
+{
+    size_t lChunkSize = CHUNK_LIVE_ALLOCATIONS * (pAllocationSize + CHUNK_ALIGNMENT) * 4;  // Leaves room for fragmentation
+    pmMemChunk lChunk(reinterpret_cast<void*>(0x10000000), lChunkSize);    // Chunk only does address arithmetic on it
+
+    std::vector<void*> lLiveAllocations(CHUNK_LIVE_ALLOCATIONS, NULL);
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    for(uint i = 0; i < pOperations; ++i)
+    {
+        uint lSlot = (i * 7919) % CHUNK_LIVE_ALLOCATIONS;
+        lChunk.Deallocate(lLiveAllocations[lSlot]);
+
+        size_t lSize = pAllocationSize / 2 + (i * 104729) % pAllocationSize;
+        size_t lAlignment = ((i % 3) ? CHUNK_ALIGNMENT : 8);
+
+        lLiveAllocations[lSlot] = lChunk.Allocate(lSize, lAlignment);
+        if(!lLiveAllocations[lSlot])
+            exit(1);
+    }
+
+    for(uint i = 0; i < CHUNK_LIVE_ALLOCATIONS; ++i)
+        lChunk.Deallocate(lLiveAllocations[i]);
+
+    double lTime = pmBase::GetCurrentTimeInSecs() - lStartTime;
+
+    if(!lChunk.HasNoAllocations())
+        exit(1);
+
+    return lTime;
+}
+
+void Report(const char* pName, const char* pCase, double pTime, ulong pOperations)
+{
+    printf("%s Time = %lf secs; Allocations/sec = %.0lf; ns/allocation = %.2lf\n", pName, pTime, (double)pOperations / pTime, pTime * 1e9 / pOperations);
+    ReportResult("allocator", pCase, pTime * 1e9 / pOperations, "ns/allocation", false);
+}
+
+int main(int argc, char** argv)
+{
+    uint lThreads = (argc > 1) ? atoi(argv[1]) : 4;
+    uint lAllocationsPerRound = (argc > 2) ? atoi(argv[2]) : 64;
+    uint lRounds = (argc > 3) ? atoi(argv[3]) : 20000;
+    size_t lAllocationSize = ((argc > 4) ? atol(argv[4]) : 16) * 1024;
+
+    if(!lThreads || !lAllocationsPerRound || !lRounds || !lAllocationSize)
+    {
+        fprintf(stderr, "Usage: %s [threads] [allocations per round] [rounds] [allocation size KB]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Threads = %u; Allocations per round = %u; Rounds = %u; Allocation size = %lu bytes\n", lThreads, lAllocationsPerRound, lRounds, lAllocationSize);
+
+    ulong lOperations = (ulong)lThreads * lAllocationsPerRound * lRounds;
+
+    Report("pool", "pool", BenchmarkPool(false, lThreads, lAllocationsPerRound, lRounds, lAllocationSize), lOperations);
+    Report("pool paged", "poolPageAligned", BenchmarkPool(true, lThreads, lAllocationsPerRound, lRounds, lAllocationSize), lOperations);
+    Report("malloc", "malloc", BenchmarkMalloc(lThreads, lAllocationsPerRound, lRounds, lAllocationSize), lOperations);
+
+    ulong lChunkOperations = (ulong)lAllocationsPerRound * lRounds;
+    Report("chunk", "memChunk", BenchmarkChunk((uint)lChunkOperations, lAllocationSize), lChunkOperations);
+
+    return 0;
+}
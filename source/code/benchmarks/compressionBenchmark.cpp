@@ -0,0 +1,140 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark measuring the throughput of the network compression codecs (pmNetworkCompression) on typical transfer data.
+ * Usage: compressionBenchmark.exe [buffer MB] [iterations] [percent non zero]
+ * sparse - 4 byte elements, the given percentage of which is non zero (as in sparsely updated output memory; what the
+ *          sentinel codec is meant for)
+ * smooth - slowly varying floats (as in stencils and images)
+ * Throughput counts uncompressed bytes per second; the ratio is compressed over uncompressed length.
+ */
+
+#include "pmBase.h"
+#include "pmNetworkCompression.h"
+#include "benchmarkResults.h"
+
+#include <math.h>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace pm;
+
+void RunBenchmark(const pmCompressionCodec& pCodec, const char* pCodecName, const char* pDataName, const std::vector<uint>& pData, uint pIterations)
+{
+    const char* lMem = reinterpret_cast<const char*>(&pData[0]);
+    ulong lLength = pData.size() * sizeof(uint);
+    std::string lCase = std::string(pCodecName) + "." + pDataName;
+
+    ulong lCompressedLength = 0;
+    std::shared_ptr<char> lCompressedPtr;
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    for(uint i = 0; i < pIterations; ++i)
+        lCompressedPtr = pCodec.Compress(lMem, lLength, lCompressedLength);
+
+    double lCompressionTime = pmBase::GetCurrentTimeInSecs() - lStartTime;
+    double lCompressionSpeed = (double)lLength * pIterations / (lCompressionTime * 1024 * 1024);
+
+    if(!lCompressedPtr.get())
+    {
+        printf("%s %s Compression = %.1lf MB/sec; Does not compress\n", pCodecName, pDataName, lCompressionSpeed);
+        ReportResult("compression", (lCase + ".compress").c_str(), lCompressionSpeed, "MB/sec", true);
+
+        return;
+    }
+
+    std::vector<uint> lDecompressed(pData.size());
+
+    lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    for(uint i = 0; i < pIterations; ++i)
+        pCodec.Decompress(lCompressedPtr.get(), lCompressedLength, reinterpret_cast<char*>(&lDecompressed[0]), lLength);
+
+    double lDecompressionTime = pmBase::GetCurrentTimeInSecs() - lStartTime;
+    double lDecompressionSpeed = (double)lLength * pIterations / (lDecompressionTime * 1024 * 1024);
+    double lRatio = (double)lCompressedLength / lLength;
+
+    if(lDecompressed != pData)
+        exit(1);
+
+    printf("%s %s Compression = %.1lf MB/sec; Decompression = %.1lf MB/sec; Ratio = %.4lf\n", pCodecName, pDataName, lCompressionSpeed, lDecompressionSpeed, lRatio);
+    ReportResult("compression", (lCase + ".compress").c_str(), lCompressionSpeed, "MB/sec", true);
+    ReportResult("compression", (lCase + ".decompress").c_str(), lDecompressionSpeed, "MB/sec", true);
+    ReportResult("compression", (lCase + ".ratio").c_str(), lRatio, "ratio", false);
+}
+
+int main(int argc, char** argv)
+{
+    size_t lBufferLength = ((argc > 1) ? atol(argv[1]) : 16) * 1024 * 1024;
+    uint lIterations = (argc > 2) ? atoi(argv[2]) : 8;
+    uint lPercentNonZero = (argc > 3) ? atoi(argv[3]) : 5;
+
+    if(!lBufferLength || !lIterations || lPercentNonZero > 100)
+    {
+        fprintf(stderr, "Usage: %s [buffer MB] [iterations] [percent non zero]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Buffer = %lu bytes; Iterations = %u; Sparse data non zero = %u%%\n", lBufferLength, lIterations, lPercentNonZero);
+
+    size_t lCount = lBufferLength / sizeof(uint);
+    std::vector<uint> lSparseData(lCount, 0), lSmoothData(lCount);
+
+    for(size_t i = 0; i < lCount; ++i)
+    {
+        if((i * 7919) % 100 < lPercentNonZero)
+            lSparseData[i] = (uint)(i * 104729 + 1);
+
+        float lValue = (float)(100.0 * sin(i / 4096.0));
+        memcpy(&lSmoothData[i], &lValue, sizeof(uint));
+    }
+
+    pmSentinelCodec lSentinelCodec;
+    pmFastCodec lFastCodec;
+    pmShuffleDeltaCodec lShuffleDeltaCodec(sizeof(uint));
+
+    RunBenchmark(lSentinelCodec, "sentinel", "sparse", lSparseData, lIterations);
+    RunBenchmark(lFastCodec, "fast", "sparse", lSparseData, lIterations);
+    RunBenchmark(lShuffleDeltaCodec, "shuffle32", "sparse", lSparseData, lIterations);
+
+    RunBenchmark(lSentinelCodec, "sentinel", "smooth", lSmoothData, lIterations);
+    RunBenchmark(lFastCodec, "fast", "smooth", lSmoothData, lIterations);
+    RunBenchmark(lShuffleDeltaCodec, "shuffle32", "smooth", lSmoothData, lIterations);
+
+    return 0;
+}
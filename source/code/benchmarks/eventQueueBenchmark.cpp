@@ -0,0 +1,206 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark comparing the event queues of internal threads (pmSafePQ and pmIndexedPQ).
+ * Usage: eventQueueBenchmark.exe [producers] [events per producer] [tasks] [queued events per task]
+ * submit - producers concurrently submit events which one consumer thread dequeues (as in pmPThread)
+ * lookup - HasMatchingItem for every task against a queue holding events of all tasks
+ * cancel - DeleteMatchingItems for every task (as on task cancellation/completion)
+ */
+
+#include "pmBase.h"
+#include "pmThread.h"
+#include "benchmarkResults.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+struct benchmarkEvent : public pmBasicThreadEvent
+{
+    const void* task;
+
+    benchmarkEvent(const void* pTask)
+    : task(pTask)
+    {}
+
+    const void* GetIndexKey() const
+    {
+        return task;
+    }
+};
+
+bool benchmarkEventMatchFunc(const benchmarkEvent& pEvent, const void* pCriterion)
+{
+    return (pEvent.task == pCriterion);
+}
+
+const ushort BENCHMARK_PRIORITY = DEFAULT_PRIORITY_LEVEL;
+
+const void* GetTask(uint pIndex)
+{
+    return reinterpret_cast<const void*>((size_t)(pIndex + 1) * 64);
+}
+
+template<typename Q>
+double BenchmarkSubmission(uint pProducers, uint pEventsPerProducer, uint pTasks)
+{
+    Q lQueue(NULL);
+    ulong lTotalEvents = (ulong)pProducers * pEventsPerProducer;
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    std::thread lConsumer([&] ()
+    {
+        ulong lConsumed = 0;
+
+        while(lConsumed < lTotalEvents)
+        {
+            std::shared_ptr<benchmarkEvent> lEvent;
+            if(lQueue.GetTopItem(lEvent) == pmSuccess)
+            {
+                lQueue.MarkProcessingFinished();
+                ++lConsumed;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::vector<std::thread> lProducers;
+    for(uint i = 0; i < pProducers; ++i)
+    {
+        lProducers.emplace_back([&, i] ()
+        {
+            for(uint j = 0; j < pEventsPerProducer; ++j)
+                lQueue.InsertItem(std::shared_ptr<benchmarkEvent>(new benchmarkEvent(GetTask((i + j) % pTasks))), BENCHMARK_PRIORITY);
+        });
+    }
+
+    for(uint i = 0; i < pProducers; ++i)
+        lProducers[i].join();
+
+    lConsumer.join();
+
+    return pmBase::GetCurrentTimeInSecs() - lStartTime;
+}
+
+template<typename Q>
+void FillQueue(Q& pQueue, uint pTasks, uint pEventsPerTask)
+{
+    for(uint j = 0; j < pEventsPerTask; ++j)
+        for(uint i = 0; i < pTasks; ++i)
+            pQueue.InsertItem(std::shared_ptr<benchmarkEvent>(new benchmarkEvent(GetTask(i))), BENCHMARK_PRIORITY);
+}
+
+template<typename Q>
+double BenchmarkLookup(uint pTasks, uint pEventsPerTask)
+{
+    Q lQueue(NULL);
+    FillQueue(lQueue, pTasks, pEventsPerTask);
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    for(uint i = 0; i < pTasks; ++i)
+    {
+        if(!lQueue.HasMatchingItem(BENCHMARK_PRIORITY, benchmarkEventMatchFunc, GetTask(i), GetTask(i)))
+            exit(1);
+    }
+
+    return pmBase::GetCurrentTimeInSecs() - lStartTime;
+}
+
+template<typename Q>
+double BenchmarkCancellation(uint pTasks, uint pEventsPerTask)
+{
+    Q lQueue(NULL);
+    FillQueue(lQueue, pTasks, pEventsPerTask);
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    for(uint i = 0; i < pTasks; ++i)
+        lQueue.DeleteMatchingItems(BENCHMARK_PRIORITY, benchmarkEventMatchFunc, GetTask(i), GetTask(i));
+
+    double lTime = pmBase::GetCurrentTimeInSecs() - lStartTime;
+
+    if(!lQueue.IsEmpty())
+        exit(1);
+
+    return lTime;
+}
+
+template<typename Q>
+void RunBenchmarks(const char* pQueueName, uint pProducers, uint pEventsPerProducer, uint pTasks, uint pEventsPerTask)
+{
+    std::string lQueueName(pQueueName);
+
+    double lTime = BenchmarkSubmission<Q>(pProducers, pEventsPerProducer, pTasks);
+    printf("%s submit Time = %lf secs; Events/sec = %.0lf\n", pQueueName, lTime, (double)pProducers * pEventsPerProducer / lTime);
+    ReportResult("eventQueue", (lQueueName + ".submit").c_str(), (double)pProducers * pEventsPerProducer / lTime, "events/sec", true);
+
+    lTime = BenchmarkLookup<Q>(pTasks, pEventsPerTask);
+    printf("%s lookup Time = %lf secs; Lookups/sec = %.0lf\n", pQueueName, lTime, (double)pTasks / lTime);
+    ReportResult("eventQueue", (lQueueName + ".lookup").c_str(), (double)pTasks / lTime, "lookups/sec", true);
+
+    lTime = BenchmarkCancellation<Q>(pTasks, pEventsPerTask);
+    printf("%s cancel Time = %lf secs; Cancellations/sec = %.0lf\n", pQueueName, lTime, (double)pTasks / lTime);
+    ReportResult("eventQueue", (lQueueName + ".cancel").c_str(), (double)pTasks / lTime, "cancellations/sec", true);
+}
+
+int main(int argc, char** argv)
+{
+    uint lProducers = (argc > 1) ? atoi(argv[1]) : 4;
+    uint lEventsPerProducer = (argc > 2) ? atoi(argv[2]) : 250000;
+    uint lTasks = (argc > 3) ? atoi(argv[3]) : 1024;
+    uint lEventsPerTask = (argc > 4) ? atoi(argv[4]) : 16;
+
+    if(!lProducers || !lEventsPerProducer || !lTasks || !lEventsPerTask)
+    {
+        fprintf(stderr, "Usage: %s [producers] [events per producer] [tasks] [queued events per task]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Producers = %u; Events per producer = %u; Tasks = %u; Queued events per task = %u\n", lProducers, lEventsPerProducer, lTasks, lEventsPerTask);
+
+    RunBenchmarks<pmSafePQ<benchmarkEvent>>("pmSafePQ", lProducers, lEventsPerProducer, lTasks, lEventsPerTask);
+    RunBenchmarks<pmIndexedPQ<benchmarkEvent>>("pmIndexedPQ", lProducers, lEventsPerProducer, lTasks, lEventsPerTask);
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark comparing the linear memory directory with a single shard (one lock over the whole address space) against the
+ * default sharded layout, and measuring the 2D memory directory on the same operations.
+ * Usage: memoryDirectoryBenchmark.exe [max threads] [address space MB] [operations per thread] [range KB]
+ * Every thread works on its own stripe of the address space (as stubs do on their subtasks) and repeatedly
+ * flush  - hands a range over to a remote host (SetRangeOwner, as in post task ownership updates)
+ * fetch  - plans the fetch of that range (SetupRemoteRegionsForFetching) and completes it (CopyOrUpdateReceivedMemory)
+ * lookup - queries the owners of the range (GetOwners)
+ * For the 2D directory, the address space is a matrix of DIRECTORY_2D_COLS byte rows, stripes are groups of columns and
+ * every range is a tile of the stripe (a scattered range of one row segment per matrix row it spans).
+ */
+
+#include "pmBase.h"
+#include "pmMemoryDirectory.h"
+#include "benchmarkResults.h"
+
+#include <set>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+const uint LOOKUPS_PER_OPERATION = 4;
+const ulong DIRECTORY_2D_COLS = 64 * 1024;
+
+double BenchmarkDirectory(uint pShardCount, uint pThreads, ulong pAddressSpaceLength, uint pOperationsPerThread, ulong pRangeLength, uint& pShardsUsed)
+{
+    communicator::memoryIdentifierStruct lMemoryIdentifier(0, 1);
+
+    pmMemoryDirectoryLinear lDirectory(pAddressSpaceLength, lMemoryIdentifier, pShardCount);
+    lDirectory.Reset(PM_LOCAL_MACHINE);
+
+    pShardsUsed = lDirectory.GetShardCount();
+
+    std::vector<char> lDummyHost(1);
+    const pmMachine* lRemoteHost = reinterpret_cast<const pmMachine*>(&lDummyHost[0]);  // Only compared, never dereferenced
+
+    ulong lStripeLength = pAddressSpaceLength / pThreads;
+    ulong lRangesPerStripe = std::max<ulong>(1, lStripeLength / pRangeLength);
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    std::vector<std::thread> lThreads;
+    for(uint i = 0; i < pThreads; ++i)
+    {
+        lThreads.emplace_back([&, i] ()
+        {
+            void* lBaseAddr = reinterpret_cast<void*>(0x10000000);  // Directory only does address arithmetic on it
+
+            for(uint j = 0; j < pOperationsPerThread; ++j)
+            {
+                ulong lOffset = i * lStripeLength + ((j * 7919) % lRangesPerStripe) * pRangeLength;
+                ulong lLength = std::min(pRangeLength, pAddressSpaceLength - lOffset);
+
+                lDirectory.SetRangeOwner(vmRangeOwner(lRemoteHost, lOffset, lMemoryIdentifier), lOffset, lLength);
+
+                std::vector<pmCommandPtr> lCommandVector;
+                pmLinearTransferVectorType lTransfers = lDirectory.SetupRemoteRegionsForFetching(pmSubscriptionInfo(lOffset, lLength), lBaseAddr, 0, lCommandVector);
+
+                for_each(lTransfers, [&] (const pmLinearTransferVectorType::value_type& pTransfer)
+                {
+                    const pmSubscriptionInfo& lSubscriptionInfo = std::get<0>(pTransfer);
+                    lDirectory.CopyOrUpdateReceivedMemory(NULL, lBaseAddr, NULL, lSubscriptionInfo.offset, lSubscriptionInfo.length, NULL);
+                });
+
+                for(uint k = 0; k < LOOKUPS_PER_OPERATION; ++k)
+                {
+                    pmMemOwnership lOwnerships;
+                    lDirectory.GetOwners(lOffset, lLength, lOwnerships);
+
+                    if(lOwnerships.empty() || lOwnerships.begin()->second.second.host != PM_LOCAL_MACHINE)
+                        exit(1);
+                }
+            }
+        });
+    }
+
+    for(uint i = 0; i < pThreads; ++i)
+        lThreads[i].join();
+
+    return pmBase::GetCurrentTimeInSecs() - lStartTime;
+}
+
+double BenchmarkDirectory2D(uint pThreads, ulong pAddressSpaceLength, uint pOperationsPerThread, ulong pRangeLength)
+{
+    communicator::memoryIdentifierStruct lMemoryIdentifier(0, 1);
+
+    ulong lRows = std::max<ulong>(1, pAddressSpaceLength / DIRECTORY_2D_COLS);
+    pmMemoryDirectory2D lDirectory(lRows, DIRECTORY_2D_COLS, lMemoryIdentifier);
+    lDirectory.Reset(PM_LOCAL_MACHINE);
+
+    std::vector<char> lDummyHost(1);
+    const pmMachine* lRemoteHost = reinterpret_cast<const pmMachine*>(&lDummyHost[0]);  // Only compared, never dereferenced
+
+    ulong lStripeCols = std::max<ulong>(1, DIRECTORY_2D_COLS / pThreads);
+    ulong lTileCols = std::min<ulong>(lStripeCols, 1024);
+    ulong lTileRows = std::min<ulong>(lRows, std::max<ulong>(1, pRangeLength / lTileCols));
+    ulong lTilesPerStripe = (lStripeCols / lTileCols) * (lRows / lTileRows);
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    std::vector<std::thread> lThreads;
+    for(uint i = 0; i < pThreads; ++i)
+    {
+        lThreads.emplace_back([&, i] ()
+        {
+            void* lBaseAddr = reinterpret_cast<void*>(0x10000000);  // Directory only does address arithmetic on it
+
+            for(uint j = 0; j < pOperationsPerThread; ++j)
+            {
+                ulong lTile = (j * 7919) % lTilesPerStripe;
+                ulong lTileRow = lTile / (lStripeCols / lTileCols);
+                ulong lTileCol = lTile % (lStripeCols / lTileCols);
+                ulong lOffset = lTileRow * lTileRows * DIRECTORY_2D_COLS + i * lStripeCols + lTileCol * lTileCols;
+
+                lDirectory.SetRangeOwner(vmRangeOwner(lRemoteHost, lOffset, lMemoryIdentifier), lOffset, lTileCols, DIRECTORY_2D_COLS, lTileRows);
+
+                std::set<pmCommandPtr> lCommandsAlreadyIssuedSet;
+                pmScatteredTransferMapType lTransfers = lDirectory.SetupRemoteRegionsForFetching(pmScatteredSubscriptionInfo(lOffset, lTileCols, DIRECTORY_2D_COLS, lTileRows), lBaseAddr, 0, lCommandsAlreadyIssuedSet);
+
+                for_each(lTransfers, [&] (const pmScatteredTransferMapType::value_type& pPair)
+                {
+                    for_each(pPair.second, [&] (const pmScatteredTransferMapType::mapped_type::value_type& pTransfer)
+                    {
+                        const pmScatteredSubscriptionInfo& lScatteredSubscriptionInfo = std::get<0>(pTransfer);
+                        lDirectory.UpdateReceivedMemory(NULL, lBaseAddr, NULL, lScatteredSubscriptionInfo.offset, lScatteredSubscriptionInfo.size, lScatteredSubscriptionInfo.step, lScatteredSubscriptionInfo.count);
+                    });
+                });
+
+                for(uint k = 0; k < LOOKUPS_PER_OPERATION; ++k)
+                {
+                    pmScatteredMemOwnership lScatteredOwnerships;
+                    lDirectory.GetOwners(lOffset, lTileCols, DIRECTORY_2D_COLS, lTileRows, lScatteredOwnerships);
+
+                    if(lScatteredOwnerships.empty() || lScatteredOwnerships.begin()->second.host != PM_LOCAL_MACHINE)
+                        exit(1);
+                }
+            }
+        });
+    }
+
+    for(uint i = 0; i < pThreads; ++i)
+        lThreads[i].join();
+
+    return pmBase::GetCurrentTimeInSecs() - lStartTime;
+}
+
+int main(int argc, char** argv)
+{
+    setenv("PMLIB_REMOTE_DATA_CACHE_SIZE", "0", 1);    // Received ranges are not backed by memory here, so they must not be cached
+
+    uint lMaxThreads = (argc > 1) ? atoi(argv[1]) : 8;
+    ulong lAddressSpaceLength = ((argc > 2) ? atol(argv[2]) : 256) * 1024 * 1024;
+    uint lOperationsPerThread = (argc > 3) ? atoi(argv[3]) : 20000;
+    ulong lRangeLength = ((argc > 4) ? atol(argv[4]) : 64) * 1024;
+
+    if(!lMaxThreads || !lAddressSpaceLength || !lOperationsPerThread || !lRangeLength)
+    {
+        fprintf(stderr, "Usage: %s [max threads] [address space MB] [operations per thread] [range KB]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Address space = %lu bytes; Operations per thread = %u; Range = %lu bytes\n", lAddressSpaceLength, lOperationsPerThread, lRangeLength);
+
+    for(uint lThreads = 1; lThreads <= lMaxThreads; lThreads *= 2)
+    {
+        uint lShardsUsed = 0;
+
+        char lCase[64];
+        double lRate = 0;
+
+        double lTime = BenchmarkDirectory(1, lThreads, lAddressSpaceLength, lOperationsPerThread, lRangeLength, lShardsUsed);
+        lRate = (double)lThreads * lOperationsPerThread / lTime;
+        printf("Threads = %u single lock Time = %lf secs; Operations/sec = %.0lf\n", lThreads, lTime, lRate);
+        sprintf(lCase, "linear.singleLock.threads%u", lThreads);
+        ReportResult("memoryDirectory", lCase, lRate, "operations/sec", true);
+
+        lTime = BenchmarkDirectory(0, lThreads, lAddressSpaceLength, lOperationsPerThread, lRangeLength, lShardsUsed);
+        lRate = (double)lThreads * lOperationsPerThread / lTime;
+        printf("Threads = %u sharded (%u shards) Time = %lf secs; Operations/sec = %.0lf\n", lThreads, lShardsUsed, lTime, lRate);
+        sprintf(lCase, "linear.sharded.threads%u", lThreads);
+        ReportResult("memoryDirectory", lCase, lRate, "operations/sec", true);
+
+        lTime = BenchmarkDirectory2D(lThreads, lAddressSpaceLength, lOperationsPerThread, lRangeLength);
+        lRate = (double)lThreads * lOperationsPerThread / lTime;
+        printf("Threads = %u 2D Time = %lf secs; Operations/sec = %.0lf\n", lThreads, lTime, lRate);
+        sprintf(lCase, "2D.threads%u", lThreads);
+        ReportResult("memoryDirectory", lCase, lRate, "operations/sec", true);
+    }
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+/**
+ * Microbenchmark (and check) of subtask prefetching under stealing. Every subtask reads its slice of a read only address space
+ * and writes the same slice of a lazy write only one (whose shadow memory is created while prefetching). Subtasks of four
+ * different lengths (and slower ones on the submitting host) make the stubs run dry at different times, so ranges whose tail has
+ * already been prefetched get stolen.
+ * Usage: mpirun -n <hosts> prefetchStealBenchmark.exe [tasks] [subtasks per task] [subtask usecs] [slice KB]
+ * The output is verified on the submitting host, which also reports how many of its stubs' prefetched subtasks were stolen
+ * (or negotiated away) and released unexecuted. Run with environment variable PMLIB_MAX_CPU_PER_HOST=1 to have every steal
+ * cross MPI ranks.
+ */
+
+#include "pmBase.h"
+#include "pmTask.h"
+#include "pmTaskExecStats.h"
+#include "pmStubManager.h"
+#include "pmPublicUtilities.h"
+#include "benchmarkResults.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+const uint INPUT_MEM_INDEX = 0;
+const uint OUTPUT_MEM_INDEX = 1;
+const uint SUBMITTING_HOST_SLOWDOWN = 4;   // So that the other hosts run dry and steal from the host whose stubs' statistics are read
+
+struct prefetchStealTaskConf
+{
+    uint subtaskUsecs;
+    size_t sliceLength;
+};
+
+uint GetInputValue(ulong pSubtaskId, size_t pIndex)
+{
+    return (uint)((pSubtaskId + 1) * 2654435761u) ^ (uint)pIndex;
+}
+
+pmStatus prefetchStealBenchmark_dataDistribution(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    prefetchStealTaskConf* lTaskConf = (prefetchStealTaskConf*)pTaskInfo.taskConf;
+    pmSubscriptionInfo lSubscriptionInfo(pSubtaskInfo.subtaskId * lTaskConf->sliceLength, lTaskConf->sliceLength);
+
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, INPUT_MEM_INDEX, READ_SUBSCRIPTION, lSubscriptionInfo);
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, OUTPUT_MEM_INDEX, WRITE_SUBSCRIPTION, lSubscriptionInfo);
+
+    return pmSuccess;
+}
+
+pmStatus prefetchStealBenchmark_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    prefetchStealTaskConf* lTaskConf = (prefetchStealTaskConf*)pTaskInfo.taskConf;
+    uint lSlowdown = (pDeviceInfo.host ? 1 : SUBMITTING_HOST_SLOWDOWN);
+    double lEndTime = pmBase::GetCurrentTimeInSecs() + lTaskConf->subtaskUsecs * lSlowdown * (1 + pSubtaskInfo.subtaskId % 4) / 1000000.0;
+
+    const uint* lInput = (const uint*)pSubtaskInfo.memInfo[INPUT_MEM_INDEX].ptr;
+    uint* lOutput = (uint*)pSubtaskInfo.memInfo[OUTPUT_MEM_INDEX].ptr;
+
+    for(size_t i = 0; i < lTaskConf->sliceLength / sizeof(uint); ++i)
+        lOutput[i] = ~lInput[i];
+
+    while(pmBase::GetCurrentTimeInSecs() < lEndTime);
+
+    return pmSuccess;
+}
+
+int main(int argc, char** argv)
+{
+    uint lTasks = (argc > 1) ? atoi(argv[1]) : 50;
+    ulong lSubtasks = (argc > 2) ? atol(argv[2]) : 16;
+    uint lSubtaskUsecs = (argc > 3) ? atoi(argv[3]) : 500;
+    size_t lSliceLength = ((argc > 4) ? atol(argv[4]) : 64) * 1024;
+
+    if(!lTasks || !lSubtasks || !lSliceLength)
+    {
+        fprintf(stderr, "Usage: %s [tasks] [subtasks per task] [subtask usecs] [slice KB]\n", argv[0]);
+        return 1;
+    }
+
+    pmInitialize();
+
+    pmCallbackHandle lCallbackHandle;
+    pmRegisterCallbacks((char*)"prefetchStealBenchmark", pmCallbacks(prefetchStealBenchmark_dataDistribution, prefetchStealBenchmark_cpu, (pmSubtaskCallback_GPU_CUDA)NULL), &lCallbackHandle);
+
+    if(pmGetHostId() == 0)
+    {
+        printf("Hosts = %u; Tasks = %u; Subtasks per task = %lu; Subtask usecs = %u; Slice = %lu bytes\n", pmGetHostCount(), lTasks, lSubtasks, lSubtaskUsecs, lSliceLength);
+
+        pmStubManager* lStubManager = pmStubManager::GetStubManager();
+
+        size_t lLength = lSubtasks * lSliceLength;
+        size_t lElems = lLength / sizeof(uint);
+
+        pmMemHandle lInputMemHandle, lOutputMemHandle;
+        pmRawMemPtr lInputPtr, lOutputPtr;
+
+        if(pmCreateMemory(lLength, &lInputMemHandle) != pmSuccess || pmCreateMemory(lLength, &lOutputMemHandle) != pmSuccess)
+            exit(1);
+
+        pmGetRawMemPtr(lInputMemHandle, &lInputPtr);
+
+        for(size_t i = 0; i < lElems; ++i)
+            ((uint*)lInputPtr)[i] = GetInputValue(i * sizeof(uint) / lSliceLength, i);
+
+        prefetchStealTaskConf lTaskConf = {lSubtaskUsecs, lSliceLength};
+
+        ulong lPrefetched = 0, lReleased = 0, lSteals = 0, lMismatches = 0;
+        double lTaskTime = 0;
+
+        for(uint i = 0; i < lTasks; ++i)
+        {
+            pmTaskMem lTaskMem[2] = {{lInputMemHandle, READ_ONLY}, {lOutputMemHandle, WRITE_ONLY_LAZY}};
+
+            pmTaskDetails lTaskDetails(&lTaskConf, sizeof(lTaskConf), lTaskMem, 2, lCallbackHandle, lSubtasks);
+            lTaskDetails.policy = RANDOM_STEAL;
+            lTaskDetails.suppressTaskLogs = true;
+
+            pmTaskHandle lTaskHandle = NULL;
+
+            double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+            if(pmSubmitTask(lTaskDetails, &lTaskHandle) != pmSuccess || pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
+                exit(1);
+
+            lTaskTime += pmBase::GetCurrentTimeInSecs() - lStartTime;
+
+            pmTaskExecStats& lTaskExecStats = static_cast<pmTask*>(lTaskHandle)->GetTaskExecStats();
+
+            for(uint j = 0; j < (uint)lStubManager->GetStubCount(); ++j)
+            {
+                pmExecutionStub* lStub = lStubManager->GetStub(j);
+
+                lPrefetched += lTaskExecStats.GetSubtasksPrefetched(lStub);
+                lReleased += lTaskExecStats.GetPrefetchedSubtasksReleased(lStub);
+                lSteals += lTaskExecStats.GetSuccessfulStealAttempts(lStub);
+            }
+
+            pmReleaseTask(lTaskHandle);
+
+            if(pmFetchMemory(lOutputMemHandle) != pmSuccess)
+                exit(1);
+
+            pmGetRawMemPtr(lOutputMemHandle, &lOutputPtr);
+
+            for(size_t k = 0; k < lElems; ++k)
+            {
+                if(((uint*)lOutputPtr)[k] != ~((uint*)lInputPtr)[k])
+                    ++lMismatches;
+
+                ((uint*)lOutputPtr)[k] = 0;
+            }
+        }
+
+        printf("Successful steals = %lu; Prefetched subtasks = %lu; Released unexecuted = %lu; Mismatches = %lu; Mean task time = %lf secs\n", lSteals, lPrefetched, lReleased, lMismatches, lTaskTime / lTasks);
+
+        pmReleaseMemory(lInputMemHandle);
+        pmReleaseMemory(lOutputMemHandle);
+
+        if(lMismatches)
+            exit(1);
+
+        ReportResult("prefetchSteal", "taskTime", lTaskTime * 1000 / lTasks, "msecs", false);
+
+        pmReleaseCallbacks(lCallbackHandle);    // Only on the submitting host (as in the testSuite apps), as others may still be executing
+    }
+
+    pmFinalize();
+
+    return 0;
+}
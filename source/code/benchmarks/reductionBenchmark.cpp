@@ -0,0 +1,101 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark measuring the bandwidth of the inbuilt reduction kernels (pmReductionKernels) used to reduce shadow memories.
+ * Usage: reductionBenchmark.exe [buffer MB] [iterations]
+ * Every case reduces a source buffer into a destination buffer of the given size as often as asked. Bandwidth counts the
+ * bytes of the destination buffer reduced per second. The instruction set in use (see PMLIB_REDUCTION_ISA) is printed.
+ */
+
+#include "pmBase.h"
+#include "pmReductionKernels.h"
+#include "benchmarkResults.h"
+
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+template<typename datatype>
+void RunBenchmark(const char* pTypeName, pmReductionOpType pReductionType, const char* pOpName, size_t pBufferLength, uint pIterations)
+{
+    size_t lCount = pBufferLength / sizeof(datatype);
+
+    std::vector<datatype> lDest(lCount), lSrc(lCount);
+    for(size_t i = 0; i < lCount; ++i)
+    {
+        lDest[i] = (datatype)(i % 7 + 1);
+        lSrc[i] = (datatype)(i % 5 + 1);
+    }
+
+    pmReductionKernels::Reduce<datatype>(&lDest[0], &lSrc[0], lCount, pReductionType);  // Warm up
+
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    for(uint i = 0; i < pIterations; ++i)
+        pmReductionKernels::Reduce<datatype>(&lDest[0], &lSrc[0], lCount, pReductionType);
+
+    double lTime = pmBase::GetCurrentTimeInSecs() - lStartTime;
+    double lBandwidth = (double)lCount * sizeof(datatype) * pIterations / (lTime * 1024 * 1024);
+
+    printf("%s %s Time = %lf secs; Bandwidth = %.1lf MB/sec\n", pTypeName, pOpName, lTime, lBandwidth);
+    ReportResult("reduction", (std::string(pTypeName) + "." + pOpName).c_str(), lBandwidth, "MB/sec", true);
+}
+
+int main(int argc, char** argv)
+{
+    size_t lBufferLength = ((argc > 1) ? atol(argv[1]) : 16) * 1024 * 1024;
+    uint lIterations = (argc > 2) ? atoi(argv[2]) : 32;
+
+    if(!lBufferLength || !lIterations)
+    {
+        fprintf(stderr, "Usage: %s [buffer MB] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Buffer = %lu bytes; Iterations = %u; Instruction set = %s\n", lBufferLength, lIterations, pmReductionKernels::GetInstructionSetName(pmReductionKernels::GetInstructionSet()));
+
+    RunBenchmark<int>("int", REDUCE_ADD, "add", lBufferLength, lIterations);
+    RunBenchmark<int>("int", REDUCE_MAX, "max", lBufferLength, lIterations);
+    RunBenchmark<uint>("uint", REDUCE_BITWISE_XOR, "xor", lBufferLength, lIterations);
+    RunBenchmark<long>("long", REDUCE_ADD, "add", lBufferLength, lIterations);
+    RunBenchmark<float>("float", REDUCE_ADD, "add", lBufferLength, lIterations);
+    RunBenchmark<float>("float", REDUCE_MIN, "min", lBufferLength, lIterations);
+    RunBenchmark<double>("double", REDUCE_ADD, "add", lBufferLength, lIterations);
+    RunBenchmark<double>("double", REDUCE_PRODUCT, "product", lBufferLength, lIterations);
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark measuring the cost of subtask shadow memory, i.e. creating a private copy of a subtask's read write
+ * subscription before it executes and committing it back into the address space afterwards.
+ * Usage: mpirun -n 1 shadowMemoryBenchmark.exe [subtasks] [subscription KB] [tasks]
+ * Every subtask subscribes to its own region of a READ_WRITE address space and increments one word per page of it.
+ * shadow - the task does not declare its read writes disjoint, so every subtask runs on shadow memory
+ * direct - the same task with the address space's disjointReadWritesAcrossSubtasks set, so subtasks work in the address space itself
+ * The difference between the two is the shadow memory create/commit overhead. Run on a single host so that no memory
+ * transfers are measured along with it. Subscriptions of MIN_REMAPPED_SHADOW_MEM_LENGTH or more are committed by moving
+ * the shadow memory's pages into the address space; run with environment variable PMLIB_SHADOW_MEM_REMAP=0 to measure
+ * committing them by copying instead (reported with a ".copy" suffix).
+ */
+
+#include "pmBase.h"
+#include "benchmarkResults.h"
+
+#include <string>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace pm;
+
+const size_t TOUCH_STRIDE = 4096;
+
+pmStatus shadowMemoryBenchmark_distribution(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    size_t lSubscriptionLength = *(size_t*)pTaskInfo.taskConf;
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, 0, READ_WRITE_SUBSCRIPTION, pmSubscriptionInfo(pSubtaskInfo.subtaskId * lSubscriptionLength, lSubscriptionLength));
+
+    return pmSuccess;
+}
+
+pmStatus shadowMemoryBenchmark_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    size_t lSubscriptionLength = *(size_t*)pTaskInfo.taskConf;
+    char* lMem = (char*)pSubtaskInfo.memInfo[0].ptr;
+
+    for(size_t i = 0; i < lSubscriptionLength; i += TOUCH_STRIDE)
+        ++(*(uint*)(lMem + i));
+
+    return pmSuccess;
+}
+
+double RunTasks(pmCallbackHandle pCallbackHandle, pmMemHandle pMemHandle, bool pDisjointReadWrites, ulong pSubtasks, size_t pSubscriptionLength, uint pTasks)
+{
+    double lTime = 0;
+
+    for(uint i = 0; i < pTasks; ++i)
+    {
+        pmTaskMem lTaskMem(pMemHandle, READ_WRITE, SUBSCRIPTION_NATURAL, pDisjointReadWrites);
+        pmTaskDetails lTaskDetails(&pSubscriptionLength, sizeof(size_t), &lTaskMem, 1, pCallbackHandle, pSubtasks);
+        lTaskDetails.suppressTaskLogs = true;
+
+        pmTaskHandle lTaskHandle = NULL;
+
+        double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+        if(pmSubmitTask(lTaskDetails, &lTaskHandle) != pmSuccess || pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
+            exit(1);
+
+        lTime += pmBase::GetCurrentTimeInSecs() - lStartTime;
+
+        pmReleaseTask(lTaskHandle);
+    }
+
+    return lTime;
+}
+
+int main(int argc, char** argv)
+{
+    ulong lSubtasks = (argc > 1) ? atol(argv[1]) : 256;
+    size_t lSubscriptionLength = ((argc > 2) ? atol(argv[2]) : 256) * 1024;
+    uint lTasks = (argc > 3) ? atoi(argv[3]) : 10;
+
+    if(!lSubtasks || !lSubscriptionLength || !lTasks)
+    {
+        fprintf(stderr, "Usage: %s [subtasks] [subscription KB] [tasks]\n", argv[0]);
+        return 1;
+    }
+
+    pmInitialize();
+
+    pmCallbackHandle lCallbackHandle;
+    pmRegisterCallbacks((char*)"shadowMemoryBenchmark", pmCallbacks(shadowMemoryBenchmark_distribution, shadowMemoryBenchmark_cpu, (pmSubtaskCallback_GPU_CUDA)NULL), &lCallbackHandle);
+
+    if(pmGetHostId() == 0)
+    {
+        printf("Hosts = %u; Subtasks = %lu; Subscription = %lu bytes; Tasks = %u\n", pmGetHostCount(), lSubtasks, lSubscriptionLength, lTasks);
+
+        size_t lLength = lSubtasks * lSubscriptionLength;
+
+        pmMemHandle lMemHandle;
+        pmCreateMemory(lLength, &lMemHandle);
+
+        pmRawMemPtr lRawMemPtr;
+        pmGetRawMemPtr(lMemHandle, &lRawMemPtr);
+        memset(lRawMemPtr, 0, lLength);
+
+        RunTasks(lCallbackHandle, lMemHandle, false, lSubtasks, lSubscriptionLength, 1);    // Warm up
+
+        double lShadowTime = RunTasks(lCallbackHandle, lMemHandle, false, lSubtasks, lSubscriptionLength, lTasks);
+        double lDirectTime = RunTasks(lCallbackHandle, lMemHandle, true, lSubtasks, lSubscriptionLength, lTasks);
+
+        pmFetchMemory(lMemHandle);
+        pmGetRawMemPtr(lMemHandle, &lRawMemPtr);
+
+        for(size_t i = 0; i < lLength; i += TOUCH_STRIDE)
+        {
+            if(*(uint*)((char*)lRawMemPtr + i) != 2 * lTasks + 1)
+                exit(1);
+        }
+
+        pmReleaseMemory(lMemHandle);
+
+        double lSubtaskCount = (double)lSubtasks * lTasks;
+        double lShadowUsecs = lShadowTime * 1000000 / lSubtaskCount;
+        double lDirectUsecs = lDirectTime * 1000000 / lSubtaskCount;
+        double lOverheadUsecs = lShadowUsecs - lDirectUsecs;
+
+        printf("shadow Time = %lf secs; usecs/subtask = %.2lf\n", lShadowTime, lShadowUsecs);
+        printf("direct Time = %lf secs; usecs/subtask = %.2lf\n", lDirectTime, lDirectUsecs);
+        printf("Shadow memory create/commit overhead = %.2lf usecs/subtask (%.1lf MB/sec)\n", lOverheadUsecs, (lOverheadUsecs > 0) ? (lSubscriptionLength / lOverheadUsecs) * (1000000.0 / (1024 * 1024)) : 0);
+
+        const char* lRemapVal = getenv("PMLIB_SHADOW_MEM_REMAP");
+        std::string lSuffix((lRemapVal && *lRemapVal && atoi(lRemapVal) == 0) ? ".copy" : "");
+
+        ReportResult("shadowMemory", ("shadow" + lSuffix).c_str(), lShadowUsecs, "usecs/subtask", false);
+        ReportResult("shadowMemory", ("direct" + lSuffix).c_str(), lDirectUsecs, "usecs/subtask", false);
+        ReportResult("shadowMemory", ("overhead" + lSuffix).c_str(), lOverheadUsecs, "usecs/subtask", false);
+
+        pmReleaseCallbacks(lCallbackHandle);    // Only on the submitting host (as in the testSuite apps), as others may still be executing
+    }
+
+    pmFinalize();
+
+    return 0;
+}
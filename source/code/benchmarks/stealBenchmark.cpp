@@ -0,0 +1,134 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark measuring the round trip latency of steal requests, from a stub issuing one to the response arriving.
+ * Usage: mpirun -n <hosts> stealBenchmark.exe [tasks] [subtasks per task] [subtask usecs]
+ * Tasks of busy waiting subtasks (of four different lengths, so that stubs run dry at different times) are submitted with
+ * the RANDOM_STEAL policy and the round trips are read from the task execution statistics of the submitting host's stubs.
+ * Run with environment variable PMLIB_MAX_CPU_PER_HOST=1 to have every steal cross MPI ranks.
+ */
+
+#include "pmBase.h"
+#include "pmTask.h"
+#include "pmTaskExecStats.h"
+#include "pmStubManager.h"
+#include "pmPublicUtilities.h"
+#include "benchmarkResults.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+pmStatus stealBenchmark_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    double lEndTime = pmBase::GetCurrentTimeInSecs() + (*(uint*)pTaskInfo.taskConf) * (1 + pSubtaskInfo.subtaskId % 4) / 1000000.0;
+
+    while(pmBase::GetCurrentTimeInSecs() < lEndTime);
+
+    return pmSuccess;
+}
+
+int main(int argc, char** argv)
+{
+    uint lTasks = (argc > 1) ? atoi(argv[1]) : 50;
+    ulong lSubtasks = (argc > 2) ? atol(argv[2]) : 256;
+    uint lSubtaskUsecs = (argc > 3) ? atoi(argv[3]) : 100;
+
+    if(!lTasks || !lSubtasks)
+    {
+        fprintf(stderr, "Usage: %s [tasks] [subtasks per task] [subtask usecs]\n", argv[0]);
+        return 1;
+    }
+
+    pmInitialize();
+
+    pmCallbackHandle lCallbackHandle;
+    pmRegisterCallbacks((char*)"stealBenchmark", pmCallbacks(NULL, stealBenchmark_cpu, (pmSubtaskCallback_GPU_CUDA)NULL), &lCallbackHandle);
+
+    if(pmGetHostId() == 0)
+    {
+        printf("Hosts = %u; Tasks = %u; Subtasks per task = %lu; Subtask usecs = %u\n", pmGetHostCount(), lTasks, lSubtasks, lSubtaskUsecs);
+
+        pmStubManager* lStubManager = pmStubManager::GetStubManager();
+
+        ulong lStealAttempts = 0, lStealResponses = 0;
+        double lRoundTripTime = 0, lTaskTime = 0;
+
+        for(uint i = 0; i < lTasks; ++i)
+        {
+            pmTaskDetails lTaskDetails(&lSubtaskUsecs, sizeof(uint), NULL, 0, lCallbackHandle, lSubtasks);
+            lTaskDetails.policy = RANDOM_STEAL;
+            lTaskDetails.suppressTaskLogs = true;
+
+            pmTaskHandle lTaskHandle = NULL;
+
+            double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+            if(pmSubmitTask(lTaskDetails, &lTaskHandle) != pmSuccess || pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
+                exit(1);
+
+            lTaskTime += pmBase::GetCurrentTimeInSecs() - lStartTime;
+
+            pmTaskExecStats& lTaskExecStats = static_cast<pmTask*>(lTaskHandle)->GetTaskExecStats();
+
+            for(uint j = 0; j < (uint)lStubManager->GetStubCount(); ++j)
+            {
+                pmExecutionStub* lStub = lStubManager->GetStub(j);
+                uint lResponses = lTaskExecStats.GetSuccessfulStealAttempts(lStub) + lTaskExecStats.GetFailedStealAttempts(lStub);
+
+                lStealAttempts += lTaskExecStats.GetStealAttempts(lStub);
+                lStealResponses += lResponses;
+                lRoundTripTime += lResponses * lTaskExecStats.GetMeanStealRoundTripTime(lStub);
+            }
+
+            pmReleaseTask(lTaskHandle);
+        }
+
+        double lMeanRoundTripUsecs = (lStealResponses ? (lRoundTripTime * 1000000 / lStealResponses) : 0);
+
+        printf("Steal attempts = %lu; Responses = %lu; Mean round trip = %.2lf usecs; Mean task time = %lf secs\n", lStealAttempts, lStealResponses, lMeanRoundTripUsecs, lTaskTime / lTasks);
+
+        if(lStealResponses)
+            ReportResult("steal", "roundTrip", lMeanRoundTripUsecs, "usecs", false);
+
+        ReportResult("steal", "taskTime", lTaskTime * 1000 / lTasks, "msecs", false);
+
+        pmReleaseCallbacks(lCallbackHandle);    // Only on the submitting host (as in the testSuite apps), as others may still be executing
+    }
+
+    pmFinalize();
+
+    return 0;
+}
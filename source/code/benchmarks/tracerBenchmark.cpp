@@ -0,0 +1,106 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Microbenchmark measuring the cost of recording runtime trace events (pmTracer) from concurrent threads.
+ * Usage: tracerBenchmark.exe [threads] [scopes per thread] [rounds]
+ * disabled - pmTraceScope with tracing switched off (the cost paid by every trace point in production)
+ * enabled  - pmTraceScope with tracing switched on; every scope appends a begin and an end record to the thread's ring
+ * Every round runs on fresh threads (and hence fresh rings); scopes per thread are capped so that no record is dropped.
+ */
+
+#include "pmBase.h"
+#include "pmTracer.h"
+#include "benchmarkResults.h"
+
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+double BenchmarkScopes(uint pThreads, uint pScopesPerThread)
+{
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    std::vector<std::thread> lThreads;
+    for(uint i = 0; i < pThreads; ++i)
+    {
+        lThreads.emplace_back([&, i] ()
+        {
+            for(uint j = 0; j < pScopesPerThread; ++j)
+                pmTraceScope lTraceScope(tracer::SUBTASK_EXECUTION, (ulong)i, (ulong)j);
+        });
+    }
+
+    for(uint i = 0; i < pThreads; ++i)
+        lThreads[i].join();
+
+    return pmBase::GetCurrentTimeInSecs() - lStartTime;
+}
+
+void RunBenchmark(const char* pName, bool pEnable, uint pThreads, uint pScopesPerThread, uint pRounds)
+{
+    pmTracer::GetTracer()->SetEnabled(pEnable);
+
+    double lTime = 0;
+    for(uint i = 0; i < pRounds; ++i)
+        lTime += BenchmarkScopes(pThreads, pScopesPerThread);
+
+    ulong lRecords = 2 * (ulong)pThreads * pScopesPerThread * pRounds;
+    printf("%s Time = %lf secs; Records/sec = %.0lf; Aggregate ns/record = %.2lf\n", pName, lTime, (double)lRecords / lTime, lTime * 1e9 / lRecords);
+    ReportResult("tracer", pName, lTime * 1e9 / lRecords, "ns/record", false);
+}
+
+int main(int argc, char** argv)
+{
+    uint lThreads = (argc > 1) ? atoi(argv[1]) : 4;
+    uint lScopesPerThread = (argc > 2) ? atoi(argv[2]) : (TRACE_BUFFER_RECORDS / 2);
+    uint lRounds = (argc > 3) ? atoi(argv[3]) : 8;
+
+    if(!lThreads || !lScopesPerThread || !lRounds || lScopesPerThread > TRACE_BUFFER_RECORDS / 2)
+    {
+        fprintf(stderr, "Usage: %s [threads] [scopes per thread (at most %u)] [rounds]\n", argv[0], TRACE_BUFFER_RECORDS / 2);
+        return 1;
+    }
+
+    printf("Threads = %u; Scopes per thread = %u; Rounds = %u\n", lThreads, lScopesPerThread, lRounds);
+
+    RunBenchmark("disabled", false, lThreads, lScopesPerThread, lRounds);
+    RunBenchmark("enabled", true, lThreads, lScopesPerThread, lRounds);
+    
+    pmTracer::GetTracer()->SetEnabled(false);
+
+    return 0;
+}
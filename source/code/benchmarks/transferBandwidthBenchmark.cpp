@@ -0,0 +1,187 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/**
+ * Round trip check of the network bandwidth measured by pmNetworkCompressor. An address space is split in two halves that
+ * are swapped between the first two hosts by tasks of two subtasks, statically assigned one per host (EQUAL_STATIC), each of
+ * which reads and writes the half the other host wrote last. Every task thus pulls one half from each host to the other. The
+ * bandwidth the submitting host measured from its sends is compared with the one observed on the wall clock for the tasks.
+ * Usage: mpirun -n 2 transferBandwidthBenchmark.exe [MB] [round trips]
+ * Run without environment variable PMLIB_NETWORK_BANDWIDTH (which fixes the bandwidth instead of measuring it) and with
+ * environment variable PMLIB_MAX_CPU_PER_HOST=1.
+ */
+
+#include "pmBase.h"
+#include "pmNetworkCompression.h"
+#include "pmPublicUtilities.h"
+#include "benchmarkResults.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+using namespace pm;
+
+// Task overheads (and the subtasks touching every byte received) make the wall clock bandwidth an underestimate. Each half moves
+// as one transfer, so the measured bandwidth approaches the link's; on hosts whose subtasks and transfers share a core, it is
+// up to six times the observed one.
+const double MAX_MEASURED_TO_OBSERVED_RATIO = 8.0;
+
+struct transferBandwidthTaskConf
+{
+    size_t halfLength;
+    uint iteration;
+};
+
+// Subtask s of iteration i works on half (s + i) % 2, so the two halves change hosts every iteration
+size_t GetHalfOffset(const transferBandwidthTaskConf* pTaskConf, ulong pSubtaskId)
+{
+    return ((pSubtaskId + pTaskConf->iteration) % 2) * pTaskConf->halfLength;
+}
+
+pmStatus transferBandwidthBenchmark_dataDistribution(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    transferBandwidthTaskConf* lTaskConf = (transferBandwidthTaskConf*)pTaskInfo.taskConf;
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, 0, READ_WRITE_SUBSCRIPTION, pmSubscriptionInfo(GetHalfOffset(lTaskConf, pSubtaskInfo.subtaskId), lTaskConf->halfLength));
+
+    return pmSuccess;
+}
+
+pmStatus transferBandwidthBenchmark_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    transferBandwidthTaskConf* lTaskConf = (transferBandwidthTaskConf*)pTaskInfo.taskConf;
+    uint* lMem = (uint*)pSubtaskInfo.memInfo[0].ptr;
+
+    // A subtask executing on the host that already has its half would not have transferred it (and poisons the half)
+    bool lSwapped = (pDeviceInfo.host == pSubtaskInfo.subtaskId);
+
+    for(size_t i = 0; i < lTaskConf->halfLength / sizeof(uint); ++i)
+        lMem[i] = (lSwapped ? lMem[i] + 1 : 0);
+
+    return pmSuccess;
+}
+
+uint GetInitialValue(size_t pIndex)
+{
+    return (uint)(pIndex * 2654435761u);   // Does not compress
+}
+
+int main(int argc, char** argv)
+{
+    size_t lLength = ((argc > 1) ? atol(argv[1]) : 64) * 1024 * 1024;
+    uint lRoundTrips = (argc > 2) ? atoi(argv[2]) : 8;
+
+    if(!lLength || !lRoundTrips)
+    {
+        fprintf(stderr, "Usage: %s [MB] [round trips]\n", argv[0]);
+        return 1;
+    }
+
+    pmInitialize();
+
+    pmCallbackHandle lCallbackHandle;
+    pmRegisterCallbacks((char*)"transferBandwidthBenchmark", pmCallbacks(transferBandwidthBenchmark_dataDistribution, transferBandwidthBenchmark_cpu, (pmSubtaskCallback_GPU_CUDA)NULL), &lCallbackHandle);
+
+    if(pmGetHostId() == 0)
+    {
+        if(pmGetHostCount() != 2)
+        {
+            fprintf(stderr, "%s needs exactly two hosts\n", argv[0]);
+            exit(1);
+        }
+
+        pmMemHandle lMemHandle;
+        pmRawMemPtr lMemPtr;
+
+        if(pmCreateMemory(lLength, &lMemHandle) != pmSuccess)
+            exit(1);
+
+        pmGetRawMemPtr(lMemHandle, &lMemPtr);
+
+        for(size_t i = 0; i < lLength / sizeof(uint); ++i)
+            ((uint*)lMemPtr)[i] = GetInitialValue(i);
+
+        double lTaskTime = 0;
+
+        for(uint i = 0; i < 2 * lRoundTrips; ++i)
+        {
+            transferBandwidthTaskConf lTaskConf = {lLength / 2, i};
+            pmTaskMem lTaskMem[1] = {{lMemHandle, READ_WRITE}};
+
+            pmTaskDetails lTaskDetails(&lTaskConf, sizeof(lTaskConf), lTaskMem, 1, lCallbackHandle, 2);
+            lTaskDetails.policy = EQUAL_STATIC;
+            lTaskDetails.suppressTaskLogs = true;
+
+            pmTaskHandle lTaskHandle = NULL;
+
+            double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+            if(pmSubmitTask(lTaskDetails, &lTaskHandle) != pmSuccess || pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
+                exit(1);
+
+            // The first task finds both halves on this host and only sends
+            if(i)
+                lTaskTime += pmBase::GetCurrentTimeInSecs() - lStartTime;
+
+            pmReleaseTask(lTaskHandle);
+        }
+
+        if(pmFetchMemory(lMemHandle) != pmSuccess)
+            exit(1);
+
+        ulong lMismatches = 0;
+        for(size_t i = 0; i < lLength / sizeof(uint); ++i)
+        {
+            if(((uint*)lMemPtr)[i] != GetInitialValue(i) + 2 * lRoundTrips)
+                ++lMismatches;
+        }
+
+        double lMeasured = pmNetworkCompressor::GetNetworkCompressor()->GetBandwidth() / (1024 * 1024);
+        double lObserved = (double)(lLength / 2) * (2 * lRoundTrips - 1) / (lTaskTime * 1024 * 1024);
+
+        printf("Length = %lu bytes; Round trips = %u; Mismatches = %lu; Measured bandwidth = %.1lf MB/sec; Observed bandwidth = %.1lf MB/sec\n", lLength, lRoundTrips, lMismatches, lMeasured, lObserved);
+
+        pmReleaseMemory(lMemHandle);
+
+        if(lMismatches || lMeasured < lObserved || lMeasured > lObserved * MAX_MEASURED_TO_OBSERVED_RATIO)
+            exit(1);
+
+        ReportResult("transferBandwidth", "measured", lMeasured, "MB/sec", true);
+        ReportResult("transferBandwidth", "observed", lObserved, "MB/sec", true);
+
+        pmReleaseCallbacks(lCallbackHandle);
+    }
+
+    pmFinalize();
+
+    return 0;
+}
@@ -37,6 +37,7 @@
 #include "pmBase.h"
 #include "pmResourceLock.h"
 #include "pmMemoryDirectory.h"
+#include "pmNetworkCompression.h"
 
 #include <vector>
 #include <map>
@@ -64,6 +65,19 @@ private:
     pmAddressSpace* mAddressSpace;
 };
 
+/* Handed out to the user for asynchronous fetches; wraps the command that accumulates all transfers of the fetch */
+class pmUserFetchHandle
+{
+public:
+    pmUserFetchHandle(const pmCommandPtr& pCommand);
+    
+    bool IsComplete();
+    void Wait();
+    
+private:
+    pmCommandPtr mCommand;
+};
+
 typedef std::map<const pmMachine*, std::shared_ptr<std::vector<communicator::ownershipChangeStruct>>> pmOwnershipTransferMap;
 typedef std::map<const pmMachine*, std::shared_ptr<std::vector<communicator::scatteredOwnershipChangeStruct>>> pmScatteredOwnershipTransferMap;
 
@@ -79,17 +93,22 @@ class pmAddressSpace : public pmBase
     friend void FetchCallback(const pmCommandPtr& pCommand);
     
 	public:
-        static pmAddressSpace* CreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner = GetNextGenerationNumber());
-        static pmAddressSpace* CreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner = GetNextGenerationNumber());
+        static pmAddressSpace* CreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner = GetNextGenerationNumber(), const pmMemAllocationPolicy& pAllocationPolicy = pmMemAllocationPolicy());
+        static pmAddressSpace* CreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner = GetNextGenerationNumber(), const pmMemAllocationPolicy& pAllocationPolicy = pmMemAllocationPolicy());
+        static pmAddressSpace* CreateAddressSpace(size_t pLength, const pmMachine* pOwner, const pmMemAllocationPolicy& pAllocationPolicy);
+        static pmAddressSpace* CreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, const pmMemAllocationPolicy& pAllocationPolicy);
+        static pmAddressSpace* CreateFileBackedAddressSpace(const char* pPath);
 
-        static pmAddressSpace* CheckAndCreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner);
-        static pmAddressSpace* CheckAndCreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner);
+        static pmAddressSpace* CheckAndCreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy = pmMemAllocationPolicy());
+        static pmAddressSpace* CheckAndCreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy = pmMemAllocationPolicy());
 
         ~pmAddressSpace();
     
 		void* GetMem() const;
         size_t GetLength() const;
         size_t GetAllocatedLength() const;
+        const pmMemAllocationPolicy& GetAllocationPolicy() const;
+        networkCompression::codecStatistics& GetNetworkCompressionStatistics();
     
         void DisposeMemory();
     
@@ -105,10 +124,15 @@ class pmAddressSpace : public pmBase
         void Fetch(ushort pPriority);
         void FetchAsync(ushort pPriority, pmCommandPtr pCommand);
         void FetchRange(ushort pPriority, ulong pOffset, ulong pLength);
+        void FetchRanges(ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges);
+        pmCommandPtr FetchRangesAsync(ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges);
     
         void EnqueueForLock(pmTask* pTask, pmMemType pMemType, pmCommandPtr& pCountDownCommand);
         void Unlock(pmTask* pTask);
-        pmTask* GetLockingTask();
+        bool IsLocked();
+        pmTask* GetExclusiveLockingTask();
+        bool IsLockedBy(pmTask* pTask);
+        ulong GetLockEpoch();
     
         ulong FindLocalDataSizeUnprotected(ulong pOffset, ulong pLength);
         std::set<const pmMachine*> FindRemoteDataSourcesUnprotected(ulong pOffset, ulong pLength);
@@ -121,6 +145,9 @@ class pmAddressSpace : public pmBase
         void ChangeOwnership(std::shared_ptr<std::vector<communicator::ownershipChangeStruct>>& pOwnershipData);
         void ChangeOwnership(std::shared_ptr<std::vector<communicator::scatteredOwnershipChangeStruct>>& pScatteredOwnershipData);
     
+        ulong GetDataGeneration();
+        void ValidateRemoteDataCache(ulong pDataGeneration, bool pWritable);
+
         void UserDelete();
         void SetUserMemHandle(pmUserMemHandle* pUserMemHandle);
         pmUserMemHandle* GetUserMemHandle();
@@ -129,10 +156,10 @@ class pmAddressSpace : public pmBase
 
 #ifdef SUPPORT_LAZY_MEMORY
         void* GetReadOnlyLazyMemoryMapping();
-        uint GetLazyForwardPrefetchPageCount();
 #endif
             
         void GetPageAlignedAddresses(size_t& pOffset, size_t& pLength);
+        std::vector<std::pair<size_t, size_t>> ClaimUnplacedPages(size_t pFirstPage, size_t pLastPage);   // Sub-ranges (first page, last page) not claimed before
 
 #ifdef ENABLE_MEM_PROFILING
         void RecordMemReceive(size_t pReceiveSize);
@@ -157,15 +184,16 @@ class pmAddressSpace : public pmBase
         const char* GetName();
     
         pmAddressSpaceType GetAddressSpaceType() const;
+        bool IsFileBacked() const;
         size_t GetRows() const;
         size_t GetCols() const;
     
-        void CopyOrUpdateReceivedMemory(pmTask* pRequestingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource);
-        void UpdateReceivedMemory(pmTask* pRequestingTask, ulong pOffset, ulong pLength, ulong pStep, ulong pCount);
+        void CopyOrUpdateReceivedMemory(pmTask* pRequestingTask, ulong pLockEpoch, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource);
+        void UpdateReceivedMemory(pmTask* pRequestingTask, ulong pLockEpoch, ulong pOffset, ulong pLength, ulong pStep, ulong pCount);
 
     private:
-        pmAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner);
-        pmAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner);
+        pmAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy);
+        pmAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy);
     
         static ulong GetNextGenerationNumber();
     
@@ -174,6 +202,8 @@ class pmAddressSpace : public pmBase
         void SetRangeOwner(const vmRangeOwner& pRangeOwner, ulong pOffset, ulong pSize, ulong pStep, ulong pCount);
         void SendRemoteOwnershipChangeMessages(pmOwnershipTransferMap& pOwnershipTransferMap);
         void SendRemoteOwnershipChangeMessages(pmScatteredOwnershipTransferMap& pScatteredOwnershipTransferMap);
+        std::vector<std::pair<ulong, ulong>> GetCoalescedWrittenRanges();
+        void InvalidateRemoteDataCacheForWrites(pmTask* pTask);
     
         void SetWaitingForOwnershipChange();
         bool IsWaitingForOwnershipChange();
@@ -184,8 +214,11 @@ class pmAddressSpace : public pmBase
         void FetchCompletionCallback(const pmCommandPtr& pCommand);
     
         void ScanLockQueue();
+        bool IsLockAvailable(pmMemType pMemType);
+        bool IsLockAvailableUnprotected(pmMemType pMemType);
+        bool IsReceivedDataAcceptable(pmTask* pRequestingTask, ulong pLockEpoch);
 
-        std::vector<uint> GetMachinesForDistribution(bool pRandomize);
+        std::vector<uint> GetMachinesForDistribution(pmTask* pTask, bool pRandomize);
 
         const pmMachine* mOwner;
         ulong mGenerationNumberOnOwner;
@@ -195,8 +228,11 @@ class pmAddressSpace : public pmBase
         size_t mRequestedRows;
         size_t mRequestedCols;
 		size_t mVMPageCount;
+        pmMemAllocationPolicy mAllocationPolicy;
+        networkCompression::codecStatistics mNetworkCompressionStatistics;
         pmAddressSpaceType mAddressSpaceType;
         bool mLazy;
+        bool mFileBacked;
         void* mMem;
         void* mReadOnlyLazyMapping;
         std::string mName;
@@ -221,11 +257,19 @@ class pmAddressSpace : public pmBase
         bool mWaitingForOwnershipChange;  // The address space owner may have sent ownership change message that must be processed before allowing any lock on address space
         RESOURCE_LOCK_IMPLEMENTATION_CLASS mOwnershipTransferLock;
 
-        pmTask* mLockingTask;
+        ulong mDataGeneration;          // On owner, the number of writable locks flushed so far; elsewhere, the latest such count known (guarded by mOwnershipTransferLock)
+        ulong mWriterDataGeneration;    // Data generation carried by the last writable task on a non owner host
+
+        std::vector<pmTask*> mLockingTasks;   // Either a single writer or any number of read only tasks (all with mLockingMemType)
+        pmMemType mLockingMemType;
+        ulong mLockEpoch;   // Incremented whenever the address space gets locked after being free and vice versa
         RESOURCE_LOCK_IMPLEMENTATION_CLASS mTaskLock;
     
         bool mUserDelete;
         RESOURCE_LOCK_IMPLEMENTATION_CLASS mDeleteLock;
+
+        std::map<size_t, size_t> mPlacedPages;  // First page versus last page of coalesced ranges already bound to a NUMA node (PLACEMENT_FIRST_TOUCH)
+        RESOURCE_LOCK_IMPLEMENTATION_CLASS mPlacedPagesLock;
     
     protected:
 #ifdef ENABLE_MEM_PROFILING
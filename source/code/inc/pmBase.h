@@ -37,6 +37,7 @@
 #include "pmDataTypes.h"
 #include "pmPublicUtilities.h"
 #include <assert.h>
+#include <random>
 
 #include <string>
 #include <iostream>
@@ -60,7 +61,9 @@ class pmBase
 //		void* operator new [] (size_t pSize);	//implicitly declared as a static member function
 //		void operator delete [] (void* pPtr);	//implicitly declared as a static member function
 
-		uint GetRandomInt(uint pMaxLimit);
+		static uint GetRandomInt(uint pMaxLimit);
+        static double GetRandomDouble(double pMaxLimit);
+        static std::mt19937& GetRandomGenerator();  // One generator per thread; seeded on first use in the thread
     
         static ulong GetIntegralCurrentTimeInSecs();
         static double GetCurrentTimeInSecs();
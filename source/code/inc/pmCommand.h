@@ -170,7 +170,7 @@ public:
     virtual void* GetData() const = 0;
     virtual ulong GetDataUnits() const = 0;
     virtual ulong GetDataLength() const = 0;
-    virtual pmCommunicatorCommandPtr Clone() = 0;   /* Creates a copy of the command. The data is not copied, however */
+    virtual pmCommunicatorCommandPtr Clone() = 0;   /* Creates a copy of the command. The data is not copied, however. External data is shared with the copy */
 
     void HoldExternalDataForLifetimeOfCommand(const std::shared_ptr<void>& pExternalDataPtr)
     {
@@ -198,6 +198,12 @@ public:
     }
     
 protected:
+    const std::shared_ptr<void>& GetExternalDataPtr() const
+    {
+        return mExternalDataPtr;
+    }
+
+
     pmCommunicatorCommandBase(ushort pPriority, ushort pType, communicator::communicatorCommandTags pTag, communicator::communicatorDataTypes pDataType, const pmHardware* pDestination, pmCommandCompletionCallbackType pCallback, const void* pUserIdentifier = NULL)
     : pmCommand(pPriority, pType, pCallback, pUserIdentifier)
     , mTag(pTag)
@@ -282,7 +288,11 @@ class pmCommunicatorCommand : public pmCommunicatorCommandBase
         pmCommunicatorCommandPtr Clone()
         {
             pmCommunicatorCommandCloner<T, D, std::is_default_constructible<T>::value && std::is_copy_constructible<T>::value> lCloner;
-            return lCloner(this);
+            pmCommunicatorCommandPtr lClonePtr = lCloner(this);
+
+            lClonePtr->HoldExternalDataForLifetimeOfCommand(GetExternalDataPtr());
+
+            return lClonePtr;
         }
 
     protected:
@@ -151,12 +151,13 @@ struct taskMemoryStruct
     ulong cols;
     ushort memType;     // enum pmMemType
     ushort subscriptionVisibility;  // enum pmSubscriptionVisibilityType
-    ushort flags;       // LSB 1 - disjointReadWriteSubscriptionsAcrossSubtasks
+    ushort flags;       // LSB 1 - disjointReadWriteSubscriptionsAcrossSubtasks; Bits 2-9 - pmMemAllocationPolicy (see TASK_MEM_*_FLAG_VAL)
     ushort addressSpaceType;    // enum pmAddressSpaceType
+    ulong dataGeneration;       // Owner's count of writes to the address space (see pmAddressSpace::ValidateRemoteDataCache)
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 7
+        FIELD_COUNT_VALUE = 8
     } fieldCount;
     
     taskMemoryStruct()
@@ -167,9 +168,10 @@ struct taskMemoryStruct
     , subscriptionVisibility(SUBSCRIPTION_NATURAL)
     , flags(0)
     , addressSpaceType(MAX_ADDRESS_SPACE_TYPES)
+    , dataGeneration(std::numeric_limits<ulong>::max())
     {}
 
-    taskMemoryStruct(const memoryIdentifierStruct& pMemStruct, ulong pMemLength, pmMemType pMemType, pmSubscriptionVisibilityType pSubscriptionVisibility, ushort pFlags)
+    taskMemoryStruct(const memoryIdentifierStruct& pMemStruct, ulong pMemLength, pmMemType pMemType, pmSubscriptionVisibilityType pSubscriptionVisibility, ushort pFlags, ulong pDataGeneration)
     : memIdentifier(pMemStruct)
     , memLength(pMemLength)
     , cols(std::numeric_limits<ulong>::max())
@@ -177,9 +179,10 @@ struct taskMemoryStruct
     , subscriptionVisibility(pSubscriptionVisibility)
     , flags(pFlags)
     , addressSpaceType(ADDRESS_SPACE_LINEAR)
+    , dataGeneration(pDataGeneration)
     {}
 
-    taskMemoryStruct(const memoryIdentifierStruct& pMemStruct, ulong pRows, ulong pCols, pmMemType pMemType, pmSubscriptionVisibilityType pSubscriptionVisibility, ushort pFlags)
+    taskMemoryStruct(const memoryIdentifierStruct& pMemStruct, ulong pRows, ulong pCols, pmMemType pMemType, pmSubscriptionVisibilityType pSubscriptionVisibility, ushort pFlags, ulong pDataGeneration)
     : memIdentifier(pMemStruct)
     , memLength(pRows)
     , cols(pCols)
@@ -187,6 +190,7 @@ struct taskMemoryStruct
     , subscriptionVisibility(pSubscriptionVisibility)
     , flags(pFlags)
     , addressSpaceType(ADDRESS_SPACE_2D)
+    , dataGeneration(pDataGeneration)
     {}
 };
 
@@ -449,11 +453,12 @@ struct stealRequestStruct
     uint originatingHost;
     ulong sequenceNumber;	// sequence number of local task object (on originating host)
     double stealingDeviceExecutionRate;
+    double stealRoundTripTime;  // in secs; stealer's mean round trip to this target (zero if not known yet)
     ushort shouldMultiAssign;
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 5
+        FIELD_COUNT_VALUE = 6
     } fieldCount;
 
     stealRequestStruct()
@@ -461,14 +466,16 @@ struct stealRequestStruct
     , originatingHost(std::numeric_limits<uint>::max())
     , sequenceNumber(std::numeric_limits<ulong>::max())
     , stealingDeviceExecutionRate(0)
+    , stealRoundTripTime(0)
     , shouldMultiAssign(1)
     {}
     
-    stealRequestStruct(uint pStealingDeviceGlobalIndex, uint pOriginatingHost, ulong pSequenceNumber, double pStealingDeviceExecutionRate, bool pShouldMultiAssign)
+    stealRequestStruct(uint pStealingDeviceGlobalIndex, uint pOriginatingHost, ulong pSequenceNumber, double pStealingDeviceExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign)
     : stealingDeviceGlobalIndex(pStealingDeviceGlobalIndex)
     , originatingHost(pOriginatingHost)
     , sequenceNumber(pSequenceNumber)
     , stealingDeviceExecutionRate(pStealingDeviceExecutionRate)
+    , stealRoundTripTime(pStealRoundTripTime)
     , shouldMultiAssign(pShouldMultiAssign)
     {}
 };
@@ -480,11 +487,12 @@ struct stealRequestStruct
     uint originatingHost;
     ulong sequenceNumber;	// sequence number of local task object (on originating host)
     double stealingDeviceExecutionRate;
+    double stealRoundTripTime;  // in secs; stealer's mean round trip to this target (zero if not known yet)
     ushort shouldMultiAssign;
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 6
+        FIELD_COUNT_VALUE = 7
     } fieldCount;
 
     stealRequestStruct()
@@ -493,15 +501,17 @@ struct stealRequestStruct
     , originatingHost(std::numeric_limits<uint>::max())
     , sequenceNumber(std::numeric_limits<ulong>::max())
     , stealingDeviceExecutionRate(0)
+    , stealRoundTripTime(0)
     , shouldMultiAssign(1)
     {}
     
-    stealRequestStruct(uint pStealingDeviceGlobalIndex, uint pTargetDeviceGlobalIndex, uint pOriginatingHost, ulong pSequenceNumber, double pStealingDeviceExecutionRate, bool pShouldMultiAssign)
+    stealRequestStruct(uint pStealingDeviceGlobalIndex, uint pTargetDeviceGlobalIndex, uint pOriginatingHost, ulong pSequenceNumber, double pStealingDeviceExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign)
     : stealingDeviceGlobalIndex(pStealingDeviceGlobalIndex)
     , targetDeviceGlobalIndex(pTargetDeviceGlobalIndex)
     , originatingHost(pOriginatingHost)
     , sequenceNumber(pSequenceNumber)
     , stealingDeviceExecutionRate(pStealingDeviceExecutionRate)
+    , stealRoundTripTime(pStealRoundTripTime)
     , shouldMultiAssign(pShouldMultiAssign)
     {}
 };
@@ -557,22 +567,25 @@ struct ownershipChangeStruct
     ulong offset;
     ulong length;
     uint newOwnerHost;
+    uint notificationOnly;  // The range was written but its ownership on the receiver does not change
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 3
+        FIELD_COUNT_VALUE = 4
     } fieldCount;
     
     ownershipChangeStruct()
     : offset(std::numeric_limits<ulong>::max())
     , length(std::numeric_limits<ulong>::max())
     , newOwnerHost(std::numeric_limits<uint>::max())
+    , notificationOnly(0)
     {}
 
-    ownershipChangeStruct(ulong pOffset, ulong pLength, uint pNewOwnerHost)
+    ownershipChangeStruct(ulong pOffset, ulong pLength, uint pNewOwnerHost, bool pNotificationOnly = false)
     : offset(pOffset)
     , length(pLength)
     , newOwnerHost(pNewOwnerHost)
+    , notificationOnly(pNotificationOnly ? 1 : 0)
     {}
 };
 
@@ -875,20 +888,33 @@ struct subtaskReducePacked
     subtaskReducePacked(pmExecutionStub* pReducingStub, pmTask* pTask, ulong pSubtaskId, pmSplitInfo* pSplitInfo);
 };
 
+enum subtaskMemoryReduceMessageType
+{
+    REDUCE_SEGMENT,                 // Memory that follows is reduced into the receiver's copy of the segment
+    GATHER_SEGMENT,                 // Memory that follows replaces the receiver's copy of the segment
+    PARTICIPATION_WITH_DATA,        // No memory follows; sender has implicitly reducible data
+    PARTICIPATION_WITH_PACKED_DATA, // No memory follows; sender has data that needs packed (tree) reduction
+    PARTICIPATION_WITHOUT_DATA,     // No memory follows; sender has not executed any subtask
+    MAX_SUBTASK_MEMORY_REDUCE_MESSAGE_TYPES
+};
+
 struct subtaskMemoryReduceStruct
 {
     uint originatingHost;
     ulong sequenceNumber;	// sequence number of local task object (on originating host)
     ulong subtaskId;        // Currently, split info does not travel with reduction struct
-    ulong offset;
-    ulong length;
+    ulong offset;           // Offset of the segment within the reduced subscription
+    ulong length;           // Length of the memory that follows (compressed length, if compressed)
     int mpiTag;             // MPI tag of the upcoming message that contains actual memory
     uint senderHost;        // Id of the host sending this message
     ushort compressed;
+    ulong segmentLength;    // Uncompressed length of the segment
+    uint reductionStep;     // Step of the reduction topology this message belongs to
+    ushort messageType;     // subtaskMemoryReduceMessageType
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 8
+        FIELD_COUNT_VALUE = 11
     } fieldCount;
     
     subtaskMemoryReduceStruct()
@@ -900,9 +926,12 @@ struct subtaskMemoryReduceStruct
     , mpiTag(0)
     , senderHost(std::numeric_limits<uint>::max())
     , compressed(0)
+    , segmentLength(0)
+    , reductionStep(0)
+    , messageType(REDUCE_SEGMENT)
     {}
 
-    subtaskMemoryReduceStruct(uint pOriginatingHost, ulong pSequenceNumber, ulong pSubtaskId, ulong pOffset, ulong pLength, int pMpiTag, uint pSenderHost, bool pCompressed)
+    subtaskMemoryReduceStruct(uint pOriginatingHost, ulong pSequenceNumber, ulong pSubtaskId, ulong pOffset, ulong pLength, int pMpiTag, uint pSenderHost, bool pCompressed, ulong pSegmentLength, uint pReductionStep, subtaskMemoryReduceMessageType pMessageType)
     : originatingHost(pOriginatingHost)
     , sequenceNumber(pSequenceNumber)
     , subtaskId(pSubtaskId)
@@ -911,6 +940,9 @@ struct subtaskMemoryReduceStruct
     , mpiTag(pMpiTag)
     , senderHost(pSenderHost)
     , compressed((ushort)pCompressed)
+    , segmentLength(pSegmentLength)
+    , reductionStep(pReductionStep)
+    , messageType((ushort)pMessageType)
     {}
 };
 
@@ -928,10 +960,12 @@ struct memoryReceiveStruct
     ulong sequenceNumber;       // Valid only if isTaskOriginated is true; sequence number of local task object (on originating host)
     int mpiTag;                 // MPI tag of the upcoming message that contains actual memory
     uint senderHost;            // Id of the host sending this message (memory can come from forwarded messages, this is the host that is actually transmitting memory)
+    ushort codec;               // enum networkCompression::codecType of the upcoming memory message
+    ulong compressedLength;     // Length of the upcoming memory message if it is compressed
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 12
+        FIELD_COUNT_VALUE = 14
     } fieldCount;
 
     memoryReceiveStruct()
@@ -947,6 +981,8 @@ struct memoryReceiveStruct
     , sequenceNumber(0)
     , mpiTag(0)
     , senderHost(std::numeric_limits<uint>::max())
+    , codec(0)
+    , compressedLength(0)
     {}
 
     memoryReceiveStruct(uint pMemOwnerHost, ulong pGenerationNumber, ulong pOffset, ulong pLength, ushort pIsTaskOriginated, uint pOriginatingHost, ulong pSequenceNumber, int pMpiTag, uint pSenderHost)
@@ -962,6 +998,8 @@ struct memoryReceiveStruct
     , sequenceNumber(pSequenceNumber)
     , mpiTag(pMpiTag)
     , senderHost(pSenderHost)
+    , codec(0)
+    , compressedLength(0)
     {}
 
     memoryReceiveStruct(uint pMemOwnerHost, ulong pGenerationNumber, ulong pOffset, ulong pLength, ulong pStep, ulong pCount, ushort pIsTaskOriginated, uint pOriginatingHost, ulong pSequenceNumber, int pMpiTag, uint pSenderHost)
@@ -977,6 +1015,8 @@ struct memoryReceiveStruct
     , sequenceNumber(pSequenceNumber)
     , mpiTag(pMpiTag)
     , senderHost(pSenderHost)
+    , codec(0)
+    , compressedLength(0)
     {}
     
     memoryReceiveStruct(const memoryReceiveStruct& pStruct)
@@ -992,6 +1032,8 @@ struct memoryReceiveStruct
     , sequenceNumber(pStruct.sequenceNumber)
     , mpiTag(pStruct.mpiTag)
     , senderHost(pStruct.senderHost)
+    , codec(pStruct.codec)
+    , compressedLength(pStruct.compressedLength)
     {}
 };
 
@@ -1158,7 +1200,9 @@ enum fileOperations
     MMAP_FILE,
     MUNMAP_FILE,
     MMAP_ACK,
-    MUNMAP_ACK
+    MUNMAP_ACK,
+    OPEN_FILE_BACKED_ADDRESS_SPACE,     // Acknowledged by MMAP_ACK
+    CLOSE_FILE_BACKED_ADDRESS_SPACE     // Not acknowledged
 };
 
 struct fileOperationsStruct
@@ -1166,22 +1210,25 @@ struct fileOperationsStruct
     char fileName[MAX_FILE_SIZE_LEN];
     ushort fileOp;  // enum fileOperations
     uint sourceHost;    // host to which ack needs to be sent
+    ulong generationNumber;     // For file backed address spaces (owned by sourceHost)
 
     typedef enum fieldCount
     {
-        FIELD_COUNT_VALUE = 3
+        FIELD_COUNT_VALUE = 4
     } fieldCount;
 
     fileOperationsStruct()
     : fileOp(std::numeric_limits<ushort>::max())
     , sourceHost(std::numeric_limits<uint>::max())
+    , generationNumber(0)
     {
         fileName[0] = '\0';
     }
     
-    fileOperationsStruct(const char* pFileName, fileOperations pFileOp, uint pSourceHost)
+    fileOperationsStruct(const char* pFileName, fileOperations pFileOp, uint pSourceHost, ulong pGenerationNumber = 0)
     : fileOp((ushort)pFileOp)
     , sourceHost(pSourceHost)
+    , generationNumber(pGenerationNumber)
     {
         if(strlen(pFileName) >= MAX_FILE_SIZE_LEN)
             PMTHROW(pmFatalErrorException());
@@ -54,6 +54,7 @@ namespace pm
 
 class pmSignalWait;
 class pmCluster;
+class pmLocalTask;
 extern pmCluster* PM_GLOBAL_CLUSTER;
 
 /**
@@ -79,13 +80,24 @@ class pmController : public pmBase
 		/* User API Functions */
 		void RegisterCallbacks_Public(const char* pKey, pmCallbacks pCallbacks, pmCallbackHandle* pCallbackHandle);
 		void ReleaseCallbacks_Public(pmCallbackHandle pCallbackHandle);
-        void CreateMemory_Public(size_t pLength, pmMemHandle* pMem);
-        void CreateMemory2D_Public(size_t pRows, size_t pCols, pmMemHandle* pMem);
+        void CreateMemory_Public(size_t pLength, pmMemHandle* pMem, const pmMemAllocationPolicy& pAllocationPolicy);
+        void CreateMemory2D_Public(size_t pRows, size_t pCols, pmMemHandle* pMem, const pmMemAllocationPolicy& pAllocationPolicy);
+        void CreateFileBackedMemory_Public(const char* pPath, pmMemHandle* pMem);
+        void SetEventTracing_Public(bool pEnable);
         void ReleaseMemory_Public(pmMemHandle pMem);
         void FetchMemory_Public(pmMemHandle pMem);
         void FetchMemoryRange_Public(pmMemHandle pMem, size_t pOffset, size_t pLength);
+        void FetchMemoryRanges_Public(pmMemHandle pMem, const pmSubscriptionInfo* pRanges, uint pRangeCount, pmFetchHandle* pFetchHandle);
+        void TestFetch_Public(pmFetchHandle pFetchHandle, bool* pComplete);
+        void WaitForFetch_Public(pmFetchHandle pFetchHandle);
+        void ReleaseFetch_Public(pmFetchHandle pFetchHandle);
         void GetRawMemPtr_Public(pmMemHandle pMem, void** pPtr);
 		void SubmitTask_Public(pmTaskDetails pTaskDetails, pmTaskHandle* pTaskHandle, const std::set<const pmMachine*>& pRestrictToMachinesSet = std::set<const pmMachine*>());
+        void SubmitTaskGraph_Public(pmTaskDetails* pTaskDetails, uint pTaskCount, const pmTaskDependency* pDependencies, uint pDependencyCount, pmTaskHandle* pTaskHandles);
+        void SubmitTaskAfter_Public(pmTaskDetails pTaskDetails, const pmTaskHandle* pPrerequisiteTasks, uint pPrerequisiteCount, pmTaskHandle* pTaskHandle);
+        void CreatePersistentTask_Public(pmTaskDetails pTaskDetails, pmPersistentTaskHandle* pPersistentTaskHandle);
+        void LaunchPersistentTask_Public(pmPersistentTaskHandle pPersistentTaskHandle, pmTaskMem* pTaskMem, void* pTaskConf, pmTaskHandle* pTaskHandle);
+        void ReleasePersistentTask_Public(pmPersistentTaskHandle pPersistentTaskHandle);
 		void ReleaseTask_Public(pmTaskHandle pTaskHandle);
 		void WaitForTaskCompletion_Public(pmTaskHandle pTaskHandle);
 		void GetTaskExecutionTimeInSecs_Public(pmTaskHandle pTaskHandle, double* pTime);
@@ -103,6 +115,9 @@ class pmController : public pmBase
 		uint GetHostCount_Public();
     
         void pmReduceSubtasks_Public(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handle, ulong pSubtask1Id, pmSplitInfo* pSplitInfo1, pmDeviceHandle pDevice2Handle, ulong pSubtask2Id, pmSplitInfo* pSplitInfo2, pmReductionOpType pReductionOperation, pmReductionDataType pReductionDataType);
+        void pmReduceSubtasks_Public(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handle, ulong pSubtask1Id, pmSplitInfo* pSplitInfo1, pmDeviceHandle pDevice2Handle, ulong pSubtask2Id, pmSplitInfo* pSplitInfo2, pmReductionOpHandle pReductionOpHandle);
+        void RegisterReductionOperation_Public(const char* pKey, const pmReductionOperation& pOperation, pmReductionOpHandle* pReductionOpHandle);
+        pmDataReductionCallback GetSubtaskReductionCallback_Public(pmReductionOpHandle pReductionOpHandle);
     
         void* GetMappedFile_Public(const char* pPath);
         void MapFile_Public(const char* pPath);
@@ -114,6 +129,9 @@ class pmController : public pmBase
 		pmController();
     
 		void DestroyController();
+    
+        void ValidateTaskDetails(const pmTaskDetails& pTaskDetails);
+        pmLocalTask* CreateLocalTask(pmTaskDetails& pTaskDetails, const std::set<const pmMachine*>& pRestrictToMachinesSet);
 	
         uint mLastErrorCode;
 		uint mFinalizedHosts;
@@ -365,7 +365,8 @@ typedef unsigned long ulong;
 			{
 				MPI_MAX_MACHINES,
 				MPI_MAX_TRANSFER_LENGTH,
-                ARITHMETIC_OVERFLOW
+                ARITHMETIC_OVERFLOW,
+                MAX_USER_REDUCTION_OPERATIONS_REACHED
 			} failureTypes;
 
 			pmBeyondComputationalLimitsException(failureTypes pFailureId) {mFailureId = pFailureId;}
@@ -54,6 +54,7 @@
 #include <string.h>
 
 #include <queue>
+#include <set>
 
 namespace pm
 {
@@ -105,6 +106,8 @@ struct stubEvent : public pmBasicBlockableThreadEvent
     {}
     
     virtual bool BlocksSecondaryOperations();
+
+    const void* GetIndexKey() const;
 };
     
 struct threadBindEvent : public stubEvent
@@ -313,7 +316,7 @@ struct directExternalReductionPlaceHolderEvent : public stubEvent
 
 }
 
-class pmExecutionStub : public THREADING_IMPLEMENTATION_CLASS<execStub::stubEvent>
+class pmExecutionStub : public THREADING_IMPLEMENTATION_CLASS<execStub::stubEvent, ushort, EVENT_QUEUE_IMPLEMENTATION_CLASS<execStub::stubEvent>>
 {
 #ifdef SUPPORT_SPLIT_SUBTASKS
     friend class pmSplitGroup;
@@ -346,7 +349,7 @@ class pmExecutionStub : public THREADING_IMPLEMENTATION_CLASS<execStub::stubEven
     #endif
 		void ReduceSubtasks(pmTask* pTask, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2);
         void ReduceExternalMemory(pmTask* pTask, const pmCommandPtr& pCommand);
-		void StealSubtasks(pmTask* pTask, const pmProcessingElement* pRequestingDevice, double pRequestingDeviceExecutionRate, bool pShouldMultiAssign);
+		void StealSubtasks(pmTask* pTask, const pmProcessingElement* pRequestingDevice, double pRequestingDeviceExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign);
 		void CancelAllSubtasks(pmTask* pTask, bool pTaskListeningOnCancellation);
         void CancelSubtaskRange(const pmSubtaskRange& pRange);
         void ProcessNegotiatedRange(const pmSubtaskRange& pRange);
@@ -366,6 +369,7 @@ class pmExecutionStub : public THREADING_IMPLEMENTATION_CLASS<execStub::stubEven
         void NegotiateRange(const pmProcessingElement* pRequestingDevice, const pmSubtaskRange& pRange);
 
         bool RequiresPrematureExit();
+        pmTask* GetCurrentTask();   // Task of the subtask range being executed; NULL if none
 
         void MarkInsideLibraryCode();
         void MarkInsideUserCode();
@@ -373,7 +377,7 @@ class pmExecutionStub : public THREADING_IMPLEMENTATION_CLASS<execStub::stubEven
         void SetupJmpBuf(sigjmp_buf* pJmpBuf);
         void UnsetupJmpBuf(bool pHasJumped);
     
-        void WaitForNetworkFetch(const std::vector<pmCommandPtr>& pNetworkCommands);
+        void WaitForNetworkFetch(const std::vector<pmCommandPtr>& pNetworkCommands, bool pLazyFault = false);   // Lazy faults (possibly many per subtask) are not recorded in the event timeline
 
         void CommitRange(pmSubtaskRange& pRange, pmStatus pExecStatus);
 
@@ -445,10 +449,10 @@ class pmExecutionStub : public THREADING_IMPLEMENTATION_CLASS<execStub::stubEven
                 pmExecutionStub* mStub;
         } currentSubtaskRangeTerminus;
 
-        ulong GetStealCount(pmTask* pTask, const pmProcessingElement* pRequestingDevice, ulong pAvailableSubtasks, double pLocalExecutionRate, double pRequestingDeviceExecutionRate);
+        ulong GetStealCount(pmTask* pTask, const pmProcessingElement* pRequestingDevice, ulong pAvailableSubtasks, double pLocalExecutionRate, double pRequestingDeviceExecutionRate, double pStealRoundTripTime);
     
         void ProcessEvent(execStub::stubEvent& pEvent);
-        virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ulong* pPreftechSubtaskIdPtr, pmSplitInfo* pSplitInfo = NULL) = 0;
+        virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, const pmSubtaskRange* pPrefetchRange, pmSplitInfo* pSplitInfo = NULL) = 0;
 
     #ifdef DUMP_EVENT_TIMELINE
         ulong ExecuteWrapper(const pmSubtaskRange& pCurrentRange, const execStub::subtaskExecEvent& pEvent, bool pIsMultiAssign, pmSubtaskRangeExecutionTimelineAutoPtr& pRangeExecTimelineAutoPtr, bool& pReassigned, bool& pForceAckFlag, bool& pPrematureTermination, pmStatus& pStatus);
@@ -536,7 +540,7 @@ class pmStubGPU : public pmExecutionStub
 		virtual void FreeResources() = 0;
 		virtual void FreeExecutionResources() = 0;
 
-		virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ulong* pPreftechSubtaskIdPtr, pmSplitInfo* pmSplitInfo = NULL) = 0;
+		virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, const pmSubtaskRange* pPrefetchRange, pmSplitInfo* pmSplitInfo = NULL) = 0;
 
         virtual void PurgeAddressSpaceEntriesFromGpuCache(const pmAddressSpace* pAddressSpace) = 0;
 
@@ -563,7 +567,7 @@ class pmStubCPU : public pmExecutionStub
 
 		virtual pmDeviceType GetType() const;
     
-		virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ulong* pPreftechSubtaskIdPtr, pmSplitInfo* pmSplitInfo = NULL);
+		virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, const pmSubtaskRange* pPrefetchRange, pmSplitInfo* pmSplitInfo = NULL);
 
     protected:
         virtual ulong FindCollectivelyExecutableSubtaskRangeEnd(const pmSubtaskRange& pSubtaskRange, pmSplitInfo* pSplitInfo, bool pMultiAssign);
@@ -572,7 +576,18 @@ class pmStubCPU : public pmExecutionStub
         virtual void TerminateUserModeExecution();
     
 	private:
+        static ulong GetSubtaskPrefetchDepth();
+        void PrefetchSubtasks(const pmSubtaskRange& pPrefetchRange, bool pIsMultiAssign);
+        void ReleasePrefetchedSubtasks(pmTask* pTask, ulong pFirstSubtaskId, ulong pLastSubtaskId);
+        bool IsPrefetchTask(pmTask* pTask) const;
+
  		size_t mCoreId;
+
+        // The task being prefetched is identified as in pmStubCUDA's task resources, as a finished task's address may be reused by a later one
+        const pmMachine* mPrefetchTaskOriginatingHost;
+        ulong mPrefetchTaskSequenceNumber;
+        ulong mPrefetchedUptoSubtask;   // Last subtask of the prefetch task whose subscriptions have been prefetched by this stub
+        std::set<ulong> mPrefetchedSubtasks;    // Subtasks of the prefetch task prefetched by this stub but not executed yet
 };
 
 #ifdef SUPPORT_CUDA
@@ -595,7 +610,7 @@ class pmStubCUDA : public pmStubGPU
 		virtual void FreeResources();
 		virtual void FreeExecutionResources();
 
-		virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ulong* pPreftechSubtaskIdPtr, pmSplitInfo* pmSplitInfo = NULL);
+		virtual void Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, const pmSubtaskRange* pPrefetchRange, pmSplitInfo* pmSplitInfo = NULL);
     
         void* GetDeviceInfoCudaPtr();
         void FreeTaskResources(const pmMachine* pOriginatingHost, ulong pSequenceNumber);
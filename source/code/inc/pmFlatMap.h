@@ -0,0 +1,93 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_FLAT_MAP__
+#define __PM_FLAT_MAP__
+
+#include "pmBase.h"
+
+#include <vector>
+
+namespace pm
+{
+
+/* An ordered map kept as a sorted vector. It mirrors the subset of the std::map interface used across the library, so it can
+ * replace small, frequently rebuilt maps whose nodes would otherwise be allocated one by one. Unlike std::map, insertions and
+ * erasures invalidate all iterators. Appending keys in increasing order is amortized constant time. */
+template<typename keyType, typename valueType>
+class pmFlatMap
+{
+public:
+    typedef keyType key_type;
+    typedef valueType mapped_type;
+    typedef std::pair<keyType, valueType> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+    typedef typename std::vector<value_type>::size_type size_type;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    bool empty() const;
+    size_type size() const;
+
+    void clear();
+    void reserve(size_type pCount);
+
+    iterator find(const keyType& pKey);
+    const_iterator find(const keyType& pKey) const;
+
+    iterator lower_bound(const keyType& pKey);
+    const_iterator lower_bound(const keyType& pKey) const;
+
+    valueType& operator[](const keyType& pKey);
+
+    template<typename inputIterator>
+    void insert(inputIterator pFirst, inputIterator pLast);     // Like std::map, keys already present are not overwritten
+
+    iterator erase(iterator pIter);
+
+private:
+    static bool KeyLess(const value_type& pElem1, const value_type& pElem2);
+    static bool KeyEqual(const value_type& pElem1, const value_type& pElem2);
+
+    std::vector<value_type> mElements;
+};
+
+} // end namespace pm
+
+#include "../src/pmFlatMap.cpp"
+
+#endif
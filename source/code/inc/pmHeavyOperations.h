@@ -41,8 +41,11 @@
 #include "pmHardware.h"
 #include "pmCommunicator.h"
 #include "pmAddressSpace.h"
+#include "pmReducer.h"
 
 #include <vector>
+#include <map>
+#include <algorithm>
 
 namespace pm
 {
@@ -71,12 +74,28 @@ enum networkRequestType
     NETWORK_RECEIVE_REQUEST
 };
 
+/* Events sharing an ordered dispatch key are always executed by the same thread (in submission order) as long as any of them is outstanding.
+ Events with address space locality prefer the thread that last worked on that address space, unless it is overloaded. */
+enum dispatchAffinityType
+{
+    NO_DISPATCH_AFFINITY,
+    ORDERED_BY_PEER,            // Network requests to/from a machine (key is the pmHardware pointer)
+    ORDERED_BY_SOURCE_HOST,     // Packed data received from a host (key is the host id)
+    ORDERED_FILE_OPERATIONS,    // File mapping/unmapping requests and acknowledgements
+    ADDRESS_SPACE_LOCALITY,     // Memory transfers (key is derived from the address space identifier)
+    MAX_DISPATCH_AFFINITY_TYPE
+};
+
 struct heavyOperationsEvent : public pmBasicThreadEvent
 {
 	eventIdentifier eventId;
+    dispatchAffinityType affinityType;
+    ulong affinityKey;
     
     heavyOperationsEvent(eventIdentifier pEventId = MAX_HEAVY_OPERATIONS_EVENT)
     : eventId(pEventId)
+    , affinityType(NO_DISPATCH_AFFINITY)
+    , affinityKey(0)
     {}
 };
     
@@ -121,14 +140,16 @@ struct subtaskReduceEvent : public heavyOperationsEvent
     pmExecutionStub* reducingStub;
 	ulong subtaskId;
     pmSplitData splitData;
+    reducer::reductionSegment segment;
     
-    subtaskReduceEvent(eventIdentifier pEventId, pmTask* pTask, const pmMachine* pMachine, pmExecutionStub* pReducingStub, ulong pSubtaskId, pmSplitData& pSplitData)
+    subtaskReduceEvent(eventIdentifier pEventId, pmTask* pTask, const pmMachine* pMachine, pmExecutionStub* pReducingStub, ulong pSubtaskId, pmSplitData& pSplitData, const reducer::reductionSegment& pSegment)
     : heavyOperationsEvent(pEventId)
     , task(pTask)
     , machine(pMachine)
     , reducingStub(pReducingStub)
     , subtaskId(pSubtaskId)
     , splitData(pSplitData)
+    , segment(pSegment)
     {}
 };
 
@@ -174,9 +195,9 @@ struct memTransferEvent : public heavyOperationsEvent
 struct memTransferCancelEvent : public heavyOperationsEvent
 {
     pmAddressSpace* addressSpace;
-    SIGNAL_WAIT_IMPLEMENTATION_CLASS* signalWaitArray;
+    std::vector<std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>> signalWaitArray;    // One per thread in pool
 
-    memTransferCancelEvent(eventIdentifier pEventId, pmAddressSpace* pAddressSpace, SIGNAL_WAIT_IMPLEMENTATION_CLASS* pSignalWaitArray)
+    memTransferCancelEvent(eventIdentifier pEventId, pmAddressSpace* pAddressSpace, const std::vector<std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>>& pSignalWaitArray)
     : heavyOperationsEvent(pEventId)
     , addressSpace(pAddressSpace)
     , signalWaitArray(pSignalWaitArray)
@@ -203,6 +224,26 @@ struct commandCompletionEvent : public heavyOperationsEvent
     {}
 };
 
+struct heavyOperationsThreadStats
+{
+    ulong eventsProcessed[MAX_HEAVY_OPERATIONS_EVENT];
+    ulong orderedDispatches;        // Events routed to this thread by an ordered dispatch key
+    ulong localityDispatches;       // Events routed to this thread because it last served the address space
+    ulong loadBalancedDispatches;   // Events routed to this thread because it had the least outstanding events
+    uint maxOutstandingEvents;
+    double busyTime;    // in secs
+    
+    heavyOperationsThreadStats()
+    : orderedDispatches(0)
+    , localityDispatches(0)
+    , loadBalancedDispatches(0)
+    , maxOutstandingEvents(0)
+    , busyTime(0)
+    {
+        std::fill_n(eventsProcessed, (size_t)MAX_HEAVY_OPERATIONS_EVENT, 0);
+    }
+};
+
 }
     
 class pmHeavyOperationsThread : public THREADING_IMPLEMENTATION_CLASS<heavyOperations::heavyOperationsEvent>
@@ -211,6 +252,9 @@ public:
     pmHeavyOperationsThread(size_t pThreadIndex);
     virtual ~pmHeavyOperationsThread();
     
+    heavyOperations::heavyOperationsThreadStats GetStatistics();
+    void RecordDispatch(heavyOperations::dispatchAffinityType pAffinityType, bool pAffinityHonoured, uint pOutstandingEvents);
+
 private:
     virtual void ThreadSwitchCallback(std::shared_ptr<heavyOperations::heavyOperationsEvent>& pEvent);
     void ProcessEvent(heavyOperations::heavyOperationsEvent& pEvent);
@@ -224,6 +268,9 @@ private:
     void HandleCommandCompletion(pmCommandPtr& pCommand);
     
     size_t mThreadIndex;
+
+    heavyOperations::heavyOperationsThreadStats mStats;
+    RESOURCE_LOCK_IMPLEMENTATION_CLASS mStatsLock;
 };
 
 class pmHeavyOperationsThreadPool
@@ -237,28 +284,42 @@ public:
 
     void QueueNetworkRequest(pmCommunicatorCommandPtr& pCommand, heavyOperations::networkRequestType pType);
     void PackAndSendData(const pmCommunicatorCommandPtr& pCommand);
-    void UnpackDataEvent(finalize_ptr<char, deleteArrayDeallocator<char>>&& pPackedData, int pPackedLength, ushort pPriority);
-    void ReduceRequestEvent(pmExecutionStub* pReducingStub, pmTask* pTask, const pmMachine* pDestMachine, ulong pSubtaskId, pmSplitInfo* pSplitInfo);
+    void UnpackDataEvent(finalize_ptr<char, deleteArrayDeallocator<char>>&& pPackedData, int pPackedLength, uint pSourceHost, ushort pPriority);
+    void ReduceRequestEvent(pmExecutionStub* pReducingStub, pmTask* pTask, const pmMachine* pDestMachine, ulong pSubtaskId, pmSplitInfo* pSplitInfo, const reducer::reductionSegment& pSegment = reducer::reductionSegment());
     void MemTransferEvent(communicator::memoryIdentifierStruct& pSrcMemIdentifier, communicator::memoryIdentifierStruct& pDestMemIdentifier, communicator::memoryTransferType pTransferType, ulong pOffset, ulong pLength, ulong pStep, ulong pCount, const pmMachine* pDestMachine, ulong pReceiverOffset, bool pIsForwarded, ushort pPriority, bool pIsTaskOriginated, uint pTaskOriginatingHost, ulong pTaskSequenceNumber);
     void CancelMemoryTransferEvents(pmAddressSpace* pAddressSpace);
     void CancelTaskSpecificMemoryTransferEvents(pmTask* pTask);
     
     pmCommandCompletionCallbackType GetHeavyOperationsCommandCompletionCallback();
     
+    size_t GetThreadCount() const;
+    heavyOperations::heavyOperationsThreadStats GetThreadStatistics(size_t pThreadIndex) const;
+
     static pmHeavyOperationsThreadPool* GetHeavyOperationsThreadPool();
 
 private:
     pmHeavyOperationsThreadPool(size_t pThreadCount);
 
-    void SubmitToThreadPool(const std::shared_ptr<heavyOperations::heavyOperationsEvent>& pEvent, ushort pPriority);
-    void SubmitToAllThreadsInPool(const std::shared_ptr<heavyOperations::heavyOperationsEvent>& pEvent, ushort pPriority) const;
+    void SubmitToThreadPool(const std::shared_ptr<heavyOperations::heavyOperationsEvent>& pEvent, ushort pPriority, heavyOperations::dispatchAffinityType pAffinityType = heavyOperations::NO_DISPATCH_AFFINITY, ulong pAffinityKey = 0);
+    void SubmitToAllThreadsInPool(const std::shared_ptr<heavyOperations::heavyOperationsEvent>& pEvent, ushort pPriority);
+    size_t GetLeastLoadedThread();
+    void EventsRetired(size_t pThreadIndex, const heavyOperations::heavyOperationsEvent& pEvent, size_t pCount = 1);
+
+#ifdef DUMP_HEAVY_OPERATIONS_STATS
+    void DumpThreadStatistics() const;
+#endif
+
 	void SetupPersistentCommunicationCommands();
 	void DestroyPersistentCommunicationCommands();
 
     void CommandCompletionEvent(pmCommandPtr pCommand);
     
     std::vector<std::unique_ptr<pmHeavyOperationsThread>> mThreadVector;
-    size_t mCurrentThread;
+    std::vector<uint> mOutstandingEvents;   // Events submitted to but not yet retired by each thread
+    size_t mCurrentThread;  // Thread from where the search for the least loaded thread begins (rotated to break ties)
+
+    std::map<std::pair<heavyOperations::dispatchAffinityType, ulong>, std::pair<size_t, uint>> mOrderedDispatchMap;   // ordered key vs. pair of thread index and outstanding events
+    std::map<ulong, size_t> mLocalityMap;  // address space key vs. thread that last served it
     
     pmCommunicatorCommandPtr mFileOperationsRecvCommand;
     pmCommunicatorCommandPtr mMemTransferRequestCommand;
@@ -0,0 +1,172 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_INDEXED_PRIORITY_QUEUE__
+#define __PM_INDEXED_PRIORITY_QUEUE__
+
+#include "pmBase.h"
+#include "pmResourceLock.h"
+#include "pmSignalWait.h"
+
+#include <map>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+
+namespace pm
+{
+
+/**
+ * \brief A thread safe priority queue with lock free submission and a per key index
+ * Drop-in alternative to pmSafePQ (same priority semantics). Items of the first EVENT_QUEUE_RING_PRIORITY_LEVELS
+ * priorities are submitted to bounded multi producer single consumer ring buffers without taking the queue lock.
+ * Whoever holds the lock (the consumer thread or a secondary operation) moves them into per priority lists built
+ * from pooled nodes. Submitters fall back to the lock if a ring buffer is full or the priority is lower.
+ * Items also return an index key (T::GetIndexKey; typically the task they belong to). Matching operations given
+ * a key only look at items with that key, so a match function used along with a key must never match items
+ * having another key.
+ */
+
+template<typename T, typename P = ushort>
+class pmIndexedPQ : public pmBase
+{
+	public:
+		typedef bool (*matchFuncPtr)(const T& pItem, const void* pMatchCriterion);
+
+		pmIndexedPQ(void* pEventNotificationIdentifier);
+
+        void InsertItem(const std::shared_ptr<T>& pItem, P pPriority);
+        pmStatus GetTopItem(std::shared_ptr<T>& pItem);
+
+        void MarkProcessingFinished();
+    
+        void UnblockSecondaryOperations();
+        void BlockSecondaryOperations();
+    
+        void CallWhenSecondaryOperationsUnblocked(const std::function<void ()>& pFunc);
+
+        void WaitForCurrentItem();
+        void WaitIfMatchingItemBeingProcessed(matchFuncPtr pMatchFunc, void* pMatchCriterion);
+    
+        pmStatus DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pItem, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey = NULL);
+        void DeleteAndGetAllMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pItems, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey = NULL);
+		void DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey = NULL);
+        bool HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey = NULL);
+
+		bool IsHighPriorityElementPresent(P pPriority);
+
+		bool IsEmpty();
+		uint GetSize();
+
+	private:
+        struct queueNode
+        {
+            std::shared_ptr<T> item;
+            const void* indexKey;
+            queueNode* older;
+            queueNode* newer;
+            queueNode* olderWithKey;
+            queueNode* newerWithKey;
+        };
+
+        struct nodeList
+        {
+            queueNode* oldest;
+            queueNode* newest;
+            
+            nodeList()
+            : oldest(NULL)
+            , newest(NULL)
+            {}
+        };
+
+        struct priorityLevel
+        {
+            nodeList nodes;
+            std::unordered_map<const void*, nodeList> index;
+        };
+
+        /* Bounded MPSC ring buffer (sequence numbered cells as in Dmitry Vyukov's bounded queue).
+         * Any number of threads may push; pop is only called with the queue lock held. */
+        class ringBuffer
+        {
+            public:
+                ringBuffer();
+            
+                bool Push(const std::shared_ptr<T>& pItem);
+                bool Pop(std::shared_ptr<T>& pItem);
+            
+            private:
+                struct ringCell
+                {
+                    std::atomic<ulong> sequence;
+                    std::shared_ptr<T> item;
+                };
+
+                ringCell mCells[EVENT_QUEUE_RING_CAPACITY];
+                char mPadding1[64];
+                std::atomic<ulong> mEnqueuePosition;
+                char mPadding2[64];
+                ulong mDequeuePosition;
+        };
+
+        typedef std::map<P, priorityLevel> priorityQueueType;
+
+        void DrainRingBuffers();
+        void AddNode(std::shared_ptr<T> pItem, P pPriority);
+        void RemoveNode(typename priorityQueueType::iterator pLevelIter, queueNode* pNode);
+        queueNode* FindMatchingNode(priorityLevel& pLevel, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey, queueNode* pNewerNode);
+        typename priorityQueueType::iterator GetTopLevel();
+
+        queueNode* AllocateNode();
+        void FreeNode(queueNode* pNode);
+
+        void* mEventNotificationIdentifier;
+        std::unique_ptr<ringBuffer[]> mRingBuffers;
+        priorityQueueType mQueue;
+        uint mItemCount;
+        std::vector<std::unique_ptr<queueNode[]>> mNodeChunks;
+        queueNode* mFreeNodes;
+        std::shared_ptr<T> mCurrentItem;
+        std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS> mCurrentSignalWait;
+        bool mSecondaryOperationsBlocked;
+    
+		RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
+        SIGNAL_WAIT_IMPLEMENTATION_CLASS mSecondaryOperationsWait;
+};
+
+} // end namespace pm
+
+#include "../src/pmIndexedPriorityQueue.cpp"
+
+#endif
@@ -114,6 +114,43 @@ const unsigned short DEFAULT_TASK_FLAGS_VAL = (TASK_MULTI_ASSIGN_FLAG_VAL | TASK
 const unsigned short DEFAULT_TASK_FLAGS_VAL = (TASK_MULTI_ASSIGN_FLAG_VAL | TASK_SHOULD_OVERLAP_COMPUTE_COMMUNICATION_FLAG_VAL | TASK_CAN_FORCIBLY_CANCEL_SUBTASKS_FLAG_VAL);
 #endif
 
+/* Packing of communicator::taskMemoryStruct::flags */
+const unsigned short TASK_MEM_DISJOINT_READ_WRITES_FLAG_VAL = 0x0001;   // LSB
+const unsigned short TASK_MEM_PLACEMENT_POLICY_SHIFT = 1;
+const unsigned short TASK_MEM_PLACEMENT_POLICY_MASK = 0x0006;  // enum pmMemPlacementPolicy
+const unsigned short TASK_MEM_PAGE_SIZE_SHIFT = 3;
+const unsigned short TASK_MEM_PAGE_SIZE_MASK = 0x0018;  // enum pmMemPageSize
+const unsigned short TASK_MEM_ADVISE_ACCESS_PATTERN_FLAG_VAL = 0x0020;
+const unsigned short TASK_MEM_NETWORK_COMPRESSION_SHIFT = 6;
+const unsigned short TASK_MEM_NETWORK_COMPRESSION_MASK = 0x01C0;    // enum pmNetworkCompression
+
+/* NUMA and huge page allocation */
+const size_t HUGE_PAGE_SIZE = (2 * 1024 * 1024);    // Size assumed for transparent and explicit huge pages on x86_64
+const size_t MIN_ADVISED_SUBSCRIPTION_LENGTH = (64 * 1024); // Read subscriptions smaller than this are not advised to the kernel
+const unsigned long MAX_NUMA_NODES = 1024;    // Size of the node masks passed to the kernel's memory policy calls
+
+/* Shadow memory commit by page remapping */
+const size_t MIN_REMAPPED_SHADOW_MEM_LENGTH = (256 * 1024);  // Whole pages of write subscriptions shorter than this are copied (and not remapped) into the address space
+const unsigned long MAX_SHADOW_MEM_REMAPS_PER_ADDRESS_SPACE = 8192;  // Every remap may split the address space's mapping; this bounds them within vm.max_map_count
+
+/* Subtask bookkeeping */
+const size_t SUBTASK_SLAB_CHUNK_OBJECTS = 64;    // Per stub subtask entries are carved out of chunks holding these many entries each
+
+/* Linear memory directory sharding (PMLIB_MEMORY_DIRECTORY_SHARDS overrides the shard count; 1 restores a single lock) */
+const unsigned long MIN_MEMORY_DIRECTORY_SHARD_LENGTH = (4 * 1024 * 1024);
+const unsigned int MAX_MEMORY_DIRECTORY_SHARDS = 64;
+
+/* Cross task cache of remote read only data (PMLIB_REMOTE_DATA_CACHE_SIZE overrides the size in MB; 0 disables the cache) */
+const size_t REMOTE_DATA_CACHE_SIZE = (256 * 1024 * 1024);
+
+/* Non-owners of file backed address spaces read subscribed ranges from the file; this many ranges following the predicted
+ * next one are advised to the kernel for readahead. Pages read are dropped from page cache (PMLIB_FILE_BACKED_KEEP_PAGE_CACHE=1 retains them). */
+const unsigned int FILE_BACKED_READAHEAD_RANGES = 2;
+
+/* Runtime event tracing (PMLIB_TRACE=1 enables it at startup; PMLIB_TRACE_DIR is where per host trace files are written) */
+const unsigned int TRACE_BUFFER_RECORDS = 65536;    // Per thread ring capacity (must be a power of 2); records arriving at a full ring are dropped and counted
+const unsigned int TRACE_FLUSH_INTERVAL = 1;        // in seconds
+
 #ifdef SUPPORT_CUDA
 const unsigned int CUDA_CHUNK_SIZE_MULTIPLIER_PER_GB = (64 * 1024 * 1024); // minimum 64 MB chunk per GB
 const unsigned int PINNED_CHUNK_SIZE_MULTIPLIER_PER_GB = CUDA_CHUNK_SIZE_MULTIPLIER_PER_GB; // minimum 64 MB chunk per GB
@@ -133,6 +170,12 @@ const double SUBTASK_TRANSFER_OVERHEAD = 1.05;  // Assuming 5% overhead for stea
 
 #define MAX_SUBTASK_MULTI_ASSIGN_COUNT 2    // Max no. of devices to which a subtask may be assigned at any given time
 #define MAX_STEAL_CYCLES_PER_DEVICE 5   // Max no. of steal attempts from a device to any other device
+const double CROSS_NUMA_DOMAIN_STEAL_PENALTY = 2.0;    // A local CPU stub prefers a victim in its own NUMA domain unless one elsewhere has this many times more stealable subtasks
+const double STEAL_TARGET_YIELD_DECAY = 0.5;    // Weight of the latest response in a steal target's expected yield (subtasks granted per attempt)
+const double MIN_STEAL_TARGET_YIELD = 0.25;     // Floor on the expected yield, so that a target which has failed lately is still picked occasionally
+
+#define DEFAULT_HEAVY_OPERATIONS_THREADS 1  // Overridden by environment variable PMLIB_HEAVY_OPERATIONS_THREADS
+#define HEAVY_OPERATIONS_LOCALITY_SLACK 4   // Max. extra outstanding events tolerated on a heavy operations thread to keep serving an address space it last served
 
 #define GET_VM_PAGE_START_ADDRESS(memAddr, pageSize) (memAddr - (memAddr % pageSize))
 
@@ -141,17 +184,35 @@ const double SUBTASK_TRANSFER_OVERHEAD = 1.05;  // Assuming 5% overhead for stea
 //#define RANDOMIZE_PULL_ASSIGNMENTS
 
 
-/* Lazy address space controls */
-//#define SUPPORT_LAZY_MEMORY
+/* Event queue controls */
+#define USE_INDEXED_EVENT_QUEUES    // Scheduler and execution stubs queue their events in pmIndexedPQ instead of pmSafePQ
+#ifdef USE_INDEXED_EVENT_QUEUES
+    #define EVENT_QUEUE_IMPLEMENTATION_CLASS pmIndexedPQ
+#else
+    #define EVENT_QUEUE_IMPLEMENTATION_CLASS pmSafePQ
+#endif
+#define EVENT_QUEUE_RING_PRIORITY_LEVELS 4  // Priorities below this are submitted to pmIndexedPQ without locking
+#define EVENT_QUEUE_RING_CAPACITY 256       // Events per priority buffered without locking (must be a power of 2)
+#define EVENT_QUEUE_NODE_CHUNK_SIZE 256     // pmIndexedPQ allocates queue nodes in chunks of these many
+
+
+/* Lazy address space controls (disabled by environment variable PMLIB_LAZY_MEMORY=0, in which case lazy memory types behave as eager ones) */
+#define SUPPORT_LAZY_MEMORY
 #ifdef SUPPORT_LAZY_MEMORY
-    #define LAZY_FORWARD_PREFETCH_PAGE_COUNT 5
+    #define LAZY_FORWARD_PREFETCH_PAGE_COUNT 5      // Initial prefetch window; it doubles on every sequential or strided fault and halves on random ones
+    #define LAZY_MAX_PREFETCH_PAGE_COUNT 128
 #endif
 
 
+/* Shadow memory controls */
+#define SUPPORT_SHADOW_MEM_REMAP    // Page aligned natural view shadow memory is committed by swapping pages into the address space (disabled by environment variable PMLIB_SHADOW_MEM_REMAP=0)
+
+
 /* Memory transfer controls */
 //#define GROUP_SCATTERED_REQUESTS
 #define PROCESS_METADATA_RECEIVE_IN_NETWORK_THREAD
-#define BLOCK_PREFETCH_OF_ANTICIPATED_SUBTASKS
+#define BLOCK_PREFETCH_OF_ANTICIPATED_SUBTASKS  // Only affects GPU stubs; CPU stubs prefetch as per DEFAULT_CPU_SUBTASK_PREFETCH_DEPTH
+#define DEFAULT_CPU_SUBTASK_PREFETCH_DEPTH 2    // Overridden by environment variable PMLIB_CPU_SUBTASK_PREFETCH_DEPTH (0 disables prefetch)
 
 
 /* Subtask splitting controls */
@@ -218,8 +279,23 @@ const double SUBTASK_TRANSFER_OVERHEAD = 1.05;  // Assuming 5% overhead for stea
 #endif
 #endif
 
+#define REDUCTION_KERNEL_CHUNK_SIZE (256 * 1024)   // Bytes of an uncompressed reduction processed by one OpenMP iteration
+
+/* Cross machine reductions use a binomial tree unless the reduced address space is large (see pmReducer::SelectTopology).
+ * Overridden by environment variable PMLIB_REDUCTION_TOPOLOGY (tree, ring or halving) */
+#define SEGMENTED_REDUCTION_MIN_LENGTH (256 * 1024)
+#define RING_REDUCTION_MIN_LENGTH (16 * 1024 * 1024)
+
 //#define TURN_OFF_GPU_SENTINEL_COMPRESSION
 //#define TURN_OFF_NETWORK_SENTINEL_COMPRESSION
+#define SENTINEL_COMPRESSION_CHUNK_SIZE (256 * 1024)    // Bytes of uncompressed data per frame of network sentinel compression (frames are encoded and decoded in parallel)
+
+/* Codecs for memory transfers (see pmNetworkCompressor) */
+#define NETWORK_COMPRESSION_BLOCK_SIZE (1024 * 1024)    // Bytes compressed independently (and in parallel) by the LZ4 style codecs
+#define NETWORK_COMPRESSION_MIN_LENGTH (64 * 1024)      // Smaller memory transfers are never compressed
+#define NETWORK_COMPRESSION_PROBE_LENGTH (256 * 1024)   // Prefix of a transfer on which COMPRESSION_ADAPTIVE measures the codecs
+#define NETWORK_COMPRESSION_PROBE_INTERVAL 32           // Transfers of an address space after which COMPRESSION_ADAPTIVE measures the codecs again
+#define DEFAULT_NETWORK_BANDWIDTH 1024                  // MB/s; assumed till memory transfers are measured
 const unsigned int CUDA_SENTINEL_COMPRESSION_THRESHOLD = (1024 * 1024 * 1024);  // 1 GB
 const float CUDA_SENTINEL_COMPRESSION_MAX_NON_SENTINELS = 0.4;
 
@@ -247,6 +323,7 @@ const float CUDA_SENTINEL_COMPRESSION_MAX_NON_SENTINELS = 0.4;
 //#define DUMP_THREADS
 //#define DUMP_SHADOW_MEM
 //#define DUMP_NETWORK_STATS
+//#define DUMP_HEAVY_OPERATIONS_STATS
 //#define DUMP_TASK_EXEC_STATS
 //#define DUMP_SCHEDULER_EVENT
 //#define DUMP_EVENT_TIMELINE
@@ -255,6 +332,7 @@ const float CUDA_SENTINEL_COMPRESSION_MAX_NON_SENTINELS = 0.4;
 #define DUMP_SUBTASK_EXECUTION_PROFILE
 #define DUMP_EXCEPTION_BACKTRACE
 //#define DUMP_CUDA_CACHE_STATISTICS
+//#define DUMP_REMOTE_DATA_CACHE_STATISTICS
 //#define DUMP_AFFINITY_DATA
 //#define DUMP_DATA_COMPRESSION_STATISTICS
 
@@ -272,6 +350,7 @@ const float CUDA_SENTINEL_COMPRESSION_MAX_NON_SENTINELS = 0.4;
     #define DUMP_EVENT_TIMELINE
     #define DUMP_SUBTASK_EXECUTION_PROFILE
     #define DUMP_CUDA_CACHE_STATISTICS
+    #define DUMP_REMOTE_DATA_CACHE_STATISTICS
     #define DUMP_DATA_COMPRESSION_STATISTICS
 #endif
 
@@ -283,6 +362,12 @@ const float CUDA_SENTINEL_COMPRESSION_MAX_NON_SENTINELS = 0.4;
     #define DUMP_EXCEPTION_BACKTRACE
 #endif
 
+#define REMOTE_DATA_CACHE_EVICTION_POLICY LEAST_RECENTLY_USED
+//#define REMOTE_DATA_CACHE_EVICTION_POLICY MOST_RECENTLY_USED
+//#define REMOTE_DATA_CACHE_EVICTION_POLICY LEAST_FREQUENTLY_USED
+//#define REMOTE_DATA_CACHE_EVICTION_POLICY MOST_FREQUENTLY_USED
+//#define REMOTE_DATA_CACHE_EVICTION_POLICY RANDOM_EVICTION
+
 #ifdef SUPPORT_CUDA
     //#define CREATE_EXPLICIT_CUDA_CONTEXTS
 
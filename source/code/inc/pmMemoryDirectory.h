@@ -185,8 +185,40 @@ class pmMemoryDirectoryLinear : public pmMemoryDirectory
 
     typedef std::map<void*, std::pair<size_t, regionFetchData>> pmInFlightRegions;
 
+    /* The address space is split into contiguous shards, each with its own lock, ownership intervals and in flight regions.
+     * Intervals and in flight regions are stored split at shard boundaries, but the ownership lists handed out (and hence the
+     * fetches) are merged across them. The sharding is local to a host; hosts need not agree on the shard count. */
+    struct ownershipShard
+    {
+        ulong offset;   // Address space offset of the first byte in the shard
+        ulong length;
+
+        pmMemOwnership ownershipMap;    // offset versus pair of length of region and vmRangeOwner
+        pmInFlightRegions inFlightMap;  // Map for regions being fetched; pair is length of region and regionFetchData
+
+        RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS lock;
+
+        ownershipShard()
+        : offset(0)
+        , length(0)
+        , lock __LOCK_NAME__("pmMemoryDirectoryLinear::ownershipShard::lock")
+        {}
+    };
+
+    /* Locks (in increasing order) all shards overlapping a range for the lifetime of the object */
+    class shardLockScope
+    {
+    public:
+        shardLockScope(pmMemoryDirectoryLinear* pDirectory, ulong pOffset, ulong pLength, bool pWriteLock);
+        ~shardLockScope();
+
+    private:
+        pmMemoryDirectoryLinear* mDirectory;
+        uint mFirstShard, mLastShard;
+    };
+
 public:
-    pmMemoryDirectoryLinear(ulong pAddressSpaceLength, const communicator::memoryIdentifierStruct& pMemoryIdentifierStruct);
+    pmMemoryDirectoryLinear(ulong pAddressSpaceLength, const communicator::memoryIdentifierStruct& pMemoryIdentifierStruct, uint pShardCount = 0);    // pShardCount 0 picks a count from the address space length
 
     virtual void Reset(const pmMachine* pOwner);
 
@@ -213,26 +245,44 @@ public:
     virtual void CopyOrUpdateReceivedMemory(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource);
     virtual void UpdateReceivedMemory(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, ulong pStep, ulong pCount);
 
+    uint GetShardCount() const;
+
 private:
+    static uint GetDefaultShardCount(ulong pAddressSpaceLength);
+
+    uint GetShardIndex(ulong pOffset) const;
+
+    template<typename functor_type>
+    void ForEachShardPiece(ulong pOffset, ulong pLength, const functor_type& pFunctor);  // pFunctor(ownershipShard&, ulong pPieceOffset, ulong pPieceLength)
+
     void SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ulong pOffset, ulong pLength);
+    void SetRangeOwnerInShard(ownershipShard& pShard, vmRangeOwner pRangeOwner, ulong pOffset, ulong pLength);
     void GetOwnersInternal(ulong pOffset, ulong pLength, pmMemOwnership& pOwnerships);
+    void GetOwnersInShard(ownershipShard& pShard, ulong pOffset, ulong pLength, pmMemOwnership& pOwnerships);
+
+    template<typename consumer_type>
+    void FindRegionsNotInFlight(void* pMem, size_t pOffset, size_t pLength, consumer_type& pRegionsToBeFetched, std::vector<pmCommandPtr>& pCommandVector);
 
     template<typename consumer_type>
-    void FindRegionsNotInFlight(pmInFlightRegions& pInFlightMap, void* pMem, size_t pOffset, size_t pLength, consumer_type& pRegionsToBeFetched, std::vector<pmCommandPtr>& pCommandVector);
+    void FindRegionsNotInFlightInShard(pmInFlightRegions& pInFlightMap, void* pMem, size_t pOffset, size_t pLength, consumer_type& pRegionsToBeFetched, std::vector<pmCommandPtr>& pCommandVector);
+
+    uint GetShardPieceCount(ulong pOffset, ulong pLength) const;
+    void AddInFlightRegion(void* pMem, ulong pOffset, ulong pLength, pmCommandPtr& pCommand);
 
     void AcquireOwnershipImmediateInternal(ulong pOffset, ulong pLength);
-    bool CopyOrUpdateReceivedMemoryInternal(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmInFlightRegions& pInFlightMap, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource = NULL);
+    bool CopyOrUpdateReceivedMemoryInternal(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource = NULL);
+    bool CopyOrUpdateReceivedMemoryInShard(ownershipShard& pShard, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource);
 
 #ifdef _DEBUG
     void CheckMergability(const pmMemOwnership::const_iterator& pRange1, const pmMemOwnership::const_iterator& pRange2) const;
-    void SanitizeOwnerships() const;
+    void SanitizeOwnerships(const ownershipShard& pShard) const;
     void PrintOwnerships() const;
 #endif
 
     ulong mAddressSpaceLength;
-    
-    pmMemOwnership mOwnershipMap;       // offset versus pair of length of region and vmRangeOwner
-    pmInFlightRegions mInFlightLinearMap;	// Map for regions being fetched; pair is length of region and regionFetchData
+    ulong mShardLength;
+
+    std::vector<ownershipShard> mShards;
 };
     
 class pmMemoryDirectory2D : public pmMemoryDirectory
@@ -364,7 +414,7 @@ private:
         {}
     };
 
-    const pmScatteredSubscriptionInfo& mScatteredSubscriptionInfo;
+    const pmScatteredSubscriptionInfo mScatteredSubscriptionInfo;
     
     std::list<blockData> mCurrentBlocks;   // computed till last row processed
     std::map<const pmMachine*, std::vector<std::pair<pmScatteredSubscriptionInfo, vmRangeOwner>>> mBlocksToBeFetched;
@@ -58,9 +58,8 @@ namespace pm
 class pmMachine;
 extern pmMachine* PM_LOCAL_MACHINE;
 
-#ifdef SUPPORT_LAZY_MEMORY
 	void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext);
-#endif
+    void PassOnSegFault(int pSignalNum);
     
 /**
  * \brief Memory Management Routines and Virtual Memory Optimizations
@@ -78,6 +77,7 @@ class pmMemoryManager : public pmBase
         virtual uint GetMemoryFetchEvents(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength) = 0;
         virtual ulong GetMemoryFetchPages(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength) = 0;
         virtual void FetchMemoryRegion(pmAddressSpace* pAddressSpace, ushort pPriority, size_t pOffset, size_t pLength, std::vector<pmCommandPtr>& pCommandVector) = 0;
+        virtual void FetchMemoryRegions(pmAddressSpace* pAddressSpace, ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges, std::vector<pmCommandPtr>& pCommandVector) = 0;
 
         virtual uint GetScatteredMemoryFetchEvents(pmAddressSpace* pAddressSpace, const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo) = 0;
         virtual ulong GetScatteredMemoryFetchPages(pmAddressSpace* pAddressSpace, const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo) = 0;
@@ -93,8 +93,20 @@ class pmMemoryManager : public pmBase
         virtual size_t FindAllocationSize(size_t pLength, size_t& pPageCount) = 0;
 
         virtual void* CreateCheckOutMemory(size_t pLength) = 0;
+
+        virtual void PlaceMemoryRegion(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength, const pmExecutionStub* pStub) = 0;
+        virtual void AdviseMemoryRegion(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength, bool pSequential) = 0;
+
+        /* Moves pLength bytes (whole pages) of checked out memory pMem into the address space at pOffset, atomically replacing its pages there.
+         * pMem stays mapped but its contents are lost. Returns false (leaving both unchanged) if the pages can not be moved; the caller then copies them instead. */
+        virtual bool SwapPagesIntoAddressSpace(pmAddressSpace* pAddressSpace, size_t pOffset, void* pMem, size_t pLength) = 0;
+
+        /* The address space's memory stays mapped while the returned handle lives, even if the address space is deallocated meanwhile.
+         * Commands sending directly out of the memory hold one, as they may complete after the address space is released. */
+        virtual std::shared_ptr<void> HoldMemory(pmAddressSpace* pAddressSpace) = 0;
     
 #ifdef SUPPORT_LAZY_MEMORY
+        virtual bool SupportsLazyAccess(pmAddressSpace* pAddressSpace) = 0;
         virtual void* CreateReadOnlyMemoryMapping(pmAddressSpace* pAddressSpace) = 0;
         virtual void DeleteReadOnlyMemoryMapping(void* pReadOnlyMemoryMapping, size_t pLength) = 0;
         virtual void SetLazyProtection(void* pAddr, size_t pLength, bool pReadAllowed, bool pWriteAllowed) = 0;
@@ -112,13 +124,30 @@ namespace linuxMemManager
         addressSpaceSpecifics();
 
         int mSharedMemDescriptor;
+        size_t mMappedLength;   // Non-zero if the memory is privately mapped (as per address space's allocation policy) instead of being allocated from heap
+        ulong mSwappedRegions;  // Regions swapped in by SwapPagesIntoAddressSpace
+        std::shared_ptr<void> mMemoryHold;  // The memory is released when the last of this and the handles given out by HoldMemory goes away
     } addressSpaceSpecifics;
+
+#ifdef SUPPORT_LAZY_MEMORY
+    /* Recent lazy faults of an execution stub, used to predict the pages it accesses next */
+    typedef struct lazyFaultHistory
+    {
+        lazyFaultHistory();
+
+        const pmAddressSpace* mAddressSpace;
+        size_t mLastPage;
+        long mStride;           // Distance (in pages) between the last two faults
+        size_t mPrefetchPages;
+    } lazyFaultHistory;
+#endif
 }
     
 class pmLinuxMemoryManager : public pmMemoryManager
 {
     private:
         friend void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext);
+        friend void PassOnSegFault(int pSignalNum);
 
         class sharedMemAutoPtr
         {
@@ -140,6 +169,7 @@ class pmLinuxMemoryManager : public pmMemoryManager
         virtual uint GetMemoryFetchEvents(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength);
         virtual ulong GetMemoryFetchPages(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength);
         virtual void FetchMemoryRegion(pmAddressSpace* pAddressSpace, ushort pPriority, size_t pOffset, size_t pLength, std::vector<pmCommandPtr>& pCommandVector);
+        virtual void FetchMemoryRegions(pmAddressSpace* pAddressSpace, ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges, std::vector<pmCommandPtr>& pCommandVector);
 
         virtual uint GetScatteredMemoryFetchEvents(pmAddressSpace* pAddressSpace, const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo);
         virtual ulong GetScatteredMemoryFetchPages(pmAddressSpace* pAddressSpace, const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo);
@@ -154,6 +184,13 @@ class pmLinuxMemoryManager : public pmMemoryManager
         virtual size_t GetVirtualMemoryPageSize() const;
 
         virtual size_t FindAllocationSize(size_t pLength, size_t& pPageCount);	// Allocation size must be a multiple of page size
+
+        virtual void PlaceMemoryRegion(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength, const pmExecutionStub* pStub);
+        virtual void AdviseMemoryRegion(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength, bool pSequential);
+
+        virtual bool SwapPagesIntoAddressSpace(pmAddressSpace* pAddressSpace, size_t pOffset, void* pMem, size_t pLength);
+
+        virtual std::shared_ptr<void> HoldMemory(pmAddressSpace* pAddressSpace);
     
         void InstallSegFaultHandler();
 		void UninstallSegFaultHandler();
@@ -162,29 +199,41 @@ class pmLinuxMemoryManager : public pmMemoryManager
 		pmLinuxMemoryManager();
 		virtual ~pmLinuxMemoryManager();
 
-        void CreateAddressSpaceSpecifics(pmAddressSpace* pAddressSpace, int pSharedMemDescriptor);
+        void CreateAddressSpaceSpecifics(pmAddressSpace* pAddressSpace, void* pMem, size_t pLength, int pSharedMemDescriptor, size_t pMappedLength);
         linuxMemManager::addressSpaceSpecifics& GetAddressSpaceSpecifics(pmAddressSpace* pAddressSpace);
     
-        void* AllocatePageAlignedMemoryInternal(pmAddressSpace* pAddressSpace, size_t& pLength, size_t& pPageCount, int& pSharedMemDescriptor);
+        void* AllocatePageAlignedMemoryInternal(pmAddressSpace* pAddressSpace, size_t& pLength, size_t& pPageCount, int& pSharedMemDescriptor, size_t& pMappedLength);
+        void ReleaseAddressSpaceMemory(void* pMem, size_t pLength, int pSharedMemDescriptor, size_t pMappedLength);
+        void* AllocatePrivateMapping(size_t pLength, const pmMemAllocationPolicy& pAllocationPolicy, size_t& pMappedLength);
+        void ApplyAllocationPolicy(void* pMem, size_t pLength, const pmMemAllocationPolicy& pAllocationPolicy);
+        void BindMemoryToNumaNodes(void* pMem, size_t pLength, int pMode, const std::vector<uint>& pNodes);
+
+    #ifdef SUPPORT_SHADOW_MEM_REMAP
+        bool ProbeShadowMemRemap();
+        bool IsPrivatelyMappedCheckOutMemory(void* pMem, size_t pLength);
+    #endif
 
         void FetchNonOverlappingMemoryRegion(ushort pPriority, pmAddressSpace* pAddressSpace, void* pMem, communicator::memoryTransferType pTransferType, size_t pOffset, size_t pLength, size_t pStep, size_t pCount, const vmRangeOwner& pRangeOwner, const pmCommandPtr& pCommand);
 
         void FetchNonOverlappingScatteredMemoryRegions(ushort pPriority, pmAddressSpace* pAddressSpace, void* pMem, std::vector<std::tuple<pmScatteredSubscriptionInfo, vmRangeOwner, pmCommandPtr>>& pVector, std::vector<pmCommandPtr>& pCommandVector);
+        void FetchCoalescedMemoryRegions(ushort pPriority, pmAddressSpace* pAddressSpace, communicator::memoryTransferType pSingleTransferType, pmScatteredTransferMapType& pMachineVersusTupleVectorMap, std::vector<pmCommandPtr>& pCommandVector);
 
         virtual void* CreateCheckOutMemory(size_t pLength);
 
 #ifdef SUPPORT_LAZY_MEMORY
     public:
+        virtual bool SupportsLazyAccess(pmAddressSpace* pAddressSpace);
         virtual void* CreateReadOnlyMemoryMapping(pmAddressSpace* pAddressSpace);
         virtual void DeleteReadOnlyMemoryMapping(void* pReadOnlyMemoryMapping, size_t pLength);
         virtual void SetLazyProtection(void* pAddr, size_t pLength, bool pReadAllowed, bool pWriteAllowed);
 
     private:
         void LoadLazyMemoryPage(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, void* pLazyMemAddr);
-        void LoadLazyMemoryPage(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, void* pLazyMemAddr, uint pForwardPrefetchPageCount);
+        void PredictLazyMemoryPages(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, size_t pPage, size_t pPageCount, std::vector<pmSubscriptionInfo>& pRanges);
         void CopyLazyInputMemPage(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, void* pFaultAddr);
         void CopyShadowMemPage(pmExecutionStub* pStub, ulong pSubtaskId, pmSplitInfo* pSplitInfo, pmAddressSpace* pAddressSpace, pmTask* pTask, size_t pShadowMemOffset, void* pShadowMemBaseAddr, void* pFaultAddr);
 
+        int CreateSharedMemory(const char* pName, size_t pLength);
         void* CreateMemoryMapping(int pSharedMemDescriptor, size_t pLength, bool pReadAllowed, bool pWriteAllowed);
         void DeleteMemoryMapping(void* pMem, size_t pLength);
 #endif
@@ -192,6 +241,20 @@ class pmLinuxMemoryManager : public pmMemoryManager
     private:
         RESOURCE_LOCK_IMPLEMENTATION_CLASS mAddressSpaceSpecificsMapLock;
         std::map<pmAddressSpace*, linuxMemManager::addressSpaceSpecifics> mAddressSpaceSpecificsMap;  // Singleton class (one instance of this map exists)
+
+#ifdef SUPPORT_LAZY_MEMORY
+        bool mLazyMemoryEnabled;
+        RESOURCE_LOCK_IMPLEMENTATION_CLASS mLazyFaultHistoryLock;
+        std::map<const pmExecutionStub*, linuxMemManager::lazyFaultHistory> mLazyFaultHistoryMap;    // An entry is only used by its stub's thread
+#endif
+
+        struct sigaction mPreviousSegFaultAction;   // Faults outside lazy memory are passed on to it
+
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+        bool mShadowMemRemapEnabled;
+        RESOURCE_LOCK_IMPLEMENTATION_CLASS mCheckOutMappingsLock;
+        std::map<void*, size_t> mCheckOutMappings;  // Checked out memory privately mapped (so that its pages may be swapped) instead of being allocated from heap
+#endif
  
 #ifdef TRACK_MEMORY_ALLOCATIONS
 		ulong mTotalAllocatedMemory;	// Lazy + Non-Lazy
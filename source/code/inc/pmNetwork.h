@@ -106,6 +106,7 @@ class pmNetwork : public pmBase
         virtual void StartReceiving() = 0;
     
         virtual bool IsImplicitlyReducible(pmTask* pTask) const = 0;
+        virtual void RegisterUserReductionOperation(uint pSlot, const pmReductionOperation& pOperation) = 0;
 
 		pmNetwork();
 		virtual ~pmNetwork();
@@ -210,6 +211,7 @@ class pmMPI : public pmNetwork, public THREADING_IMPLEMENTATION_CLASS<network::n
 		virtual void TerminatePersistentCommand(pmCommunicatorCommandPtr& pCommand);
     
         virtual bool IsImplicitlyReducible(pmTask* pTask) const;
+        virtual void RegisterUserReductionOperation(uint pSlot, const pmReductionOperation& pOperation);
 
 		virtual void GlobalBarrier();
         virtual void StartReceiving();
@@ -235,6 +237,8 @@ class pmMPI : public pmNetwork, public THREADING_IMPLEMENTATION_CLASS<network::n
         MPI_Datatype GetReducibleDataTypeAndSize(pmTask* pTask, size_t& pSize) const;
         MPI_Op GetReductionMpiOperation(pmTask* pTask) const;
 
+        static void UserReductionMpiOperation(void* pInVec, void* pInOutVec, int* pLength, MPI_Datatype* pDataType);
+
         void SetupDummyRequest();
 		void CancelDummyRequest();
 
@@ -242,24 +246,53 @@ class pmMPI : public pmNetwork, public THREADING_IMPLEMENTATION_CLASS<network::n
     
         void CleanupFinishedSendRequests(bool pTerminating);
 
+        void AddProgressRequest(MPI_Request pRequest, pmCommunicatorCommandPtr& pCommand);
+        void RemoveProgressRequest(MPI_Request pRequest);
+        void FreePersistentRequest(MPI_Request pRequest, const pmCommunicatorCommandPtr& pCommand);
+        void FreeTerminatedProgressRequests();
+        void MergePendingProgressRequests();
+        void ProcessCompletedProgressRequests(int pCompletedCount);
+
+    #ifdef DUMP_NETWORK_STATS
+        void DumpProgressStatistics();
+    #endif
+
 		uint mTotalHosts;
 		uint mHostId;
 
-        std::list<std::pair<MPI_Request, pmCommunicatorCommandPtr>> mOngoingSendRequests;  // This list exists only to free memory associated with buffers in commandPtr after the send operations complete
-		std::map<MPI_Request, pmCommunicatorCommandPtr> mNonBlockingRequestMap;	// Map of MPI_Request objects and corresponding pmCommunicatorCommand objects
+        std::vector<MPI_Request> mOngoingSendRequests;  // This array exists only to free memory associated with buffers in commandPtr after the send operations complete
+        std::vector<pmCommunicatorCommandPtr> mOngoingSendCommands;    // Commands corresponding to the entries in mOngoingSendRequests
+
+        std::vector<MPI_Request> mProgressRequests;    // Array waited upon by the network thread (accessed only by it); slot 0 is the dummy request
+        std::vector<pmCommunicatorCommandPtr> mProgressCommands;   // Commands corresponding to the entries in mProgressRequests
+        std::vector<int> mCompletedProgressIndices;    // Output array of MPI_Waitsome
+        std::vector<std::pair<MPI_Request, pmCommunicatorCommandPtr>> mPendingProgressRequests;  // Requests issued after the network thread last entered MPI_Waitsome
+        std::vector<std::pair<MPI_Request, pmCommunicatorCommandPtr>> mTerminatedProgressRequests;   // Persistent requests terminated while the network thread waits on them; freed by it
+        bool mWaitingOnProgressRequests;    // The network thread is in MPI_Waitsome on mProgressRequests
         std::map<pmCommunicatorCommandPtr, size_t> mRequestCountMap;	// Maps MpiCommunicatorCommand object to the number of MPI_Requests issued
 
-        bool mDummyRequestInitiated;
+        bool mDummyRequestInitiated;    // Dummy receive is posted and no cancellation message has been sent for it
+        bool mDummyRequestActive;   // Dummy receive is posted and MPI_Waitsome has not yet reported its completion
         MPI_Request mPersistentDummyRecvRequest;
 
+        ulong mProgressWakeups;     // Number of times MPI_Waitsome returned in the network thread
+        ulong mProgressCompletions;    // Number of non-dummy requests completed across all wakeups
+        ulong mDummyOnlyWakeups;    // Wakeups that completed only the dummy request
+        uint mMaxCompletionsPerWakeup;
+
         std::map<pmCommunicatorCommandPtr, MPI_Request> mPersistentSendRequest;
         std::map<pmCommunicatorCommandPtr, MPI_Request> mPersistentRecvRequest;
 
-        RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;	   // Resource lock on mOngoingSendRequests, mDummyRequestInitiated, mPersistentDummyRecvRequest, mNonBlockingRequestMap, mResourceCountMap, mPersistentSendRequest, mPersistentRecvRequest
+        RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;	   // Resource lock on mOngoingSendRequests, mDummyRequestInitiated, mDummyRequestActive, mPersistentDummyRecvRequest, mPendingProgressRequests, mTerminatedProgressRequests, mWaitingOnProgressRequests, mResourceCountMap, mPersistentSendRequest, mPersistentRecvRequest, progress counters
 
 		std::map<communicator::communicatorDataTypes, MPI_Datatype> mRegisteredDataTypes;
 		RESOURCE_LOCK_IMPLEMENTATION_CLASS mDataTypesResourceLock;	   // Resource lock on mRegisteredDataTypes
 
+        /* Indexed by slot of the user reduction operator; an element is a contiguous type of the operator's element size */
+        std::vector<MPI_Datatype> mUserReductionDataTypes;
+        std::vector<MPI_Op> mUserReductionOperations;
+        std::vector<pmReductionOperation> mUserReductionOperationDefinitions;
+
         finalize_ptr<pmSignalWait> mSignalWait;
     
 		bool mThreadTerminationFlag;
@@ -0,0 +1,166 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_NETWORK_COMPRESSION__
+#define __PM_NETWORK_COMPRESSION__
+
+#include "pmBase.h"
+#include "pmResourceLock.h"
+
+#include <memory>
+
+namespace pm
+{
+
+class pmAddressSpace;
+
+namespace networkCompression
+{
+    enum codecType
+    {
+        CODEC_NONE,
+        CODEC_FAST,
+        CODEC_SHUFFLE_DELTA_32,
+        CODEC_SHUFFLE_DELTA_64,
+        CODEC_SENTINEL,
+        MAX_CODECS
+    };
+
+    /* Running averages used to choose a codec for an address space under COMPRESSION_ADAPTIVE.
+     * Ratio is compressed over uncompressed length and speeds are in uncompressed bytes per second. */
+    struct codecStatistics
+    {
+        double ratio[MAX_CODECS];
+        double compressionSpeed[MAX_CODECS];
+        double decompressionSpeed[MAX_CODECS];
+        ulong samples[MAX_CODECS];
+        ulong transfers;
+        RESOURCE_LOCK_IMPLEMENTATION_CLASS lock;
+
+        codecStatistics();
+    };
+}
+
+/**
+ * Codecs for memory sent over the network. Data is compressed in independent blocks of
+ * NETWORK_COMPRESSION_BLOCK_SIZE bytes which are processed in parallel.
+ */
+class pmCompressionCodec
+{
+public:
+    virtual ~pmCompressionCodec() {}
+
+    /* Returns an empty pointer if the data does not compress */
+    virtual std::shared_ptr<char> Compress(const char* pMem, ulong pLength, ulong& pCompressedLength) const = 0;
+    virtual void Decompress(const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength) const = 0;
+};
+
+/* Compresses each block with an LZ4 style compressor (the block format is that of LZ4) */
+class pmFastCodec : public pmCompressionCodec
+{
+public:
+    virtual std::shared_ptr<char> Compress(const char* pMem, ulong pLength, ulong& pCompressedLength) const;
+    virtual void Decompress(const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength) const;
+
+protected:
+    /* Returns zero if the block does not fit in pDestCapacity bytes */
+    static ulong CompressBlock(const char* pSrc, ulong pLength, char* pDest, ulong pDestCapacity);
+    static void DecompressBlock(const char* pSrc, ulong pCompressedLength, char* pDest, ulong pLength);
+
+    virtual ulong EncodeBlock(const char* pSrc, ulong pLength, char* pDest, ulong pDestCapacity) const;
+    virtual void DecodeBlock(const char* pSrc, ulong pCompressedLength, char* pDest, ulong pLength) const;
+};
+
+/* Groups the i'th bytes of all elements of a block together and replaces every byte by its difference from the previous
+ * one before the LZ4 style compression. Slowly varying numeric arrays turn into long runs of small values this way. */
+class pmShuffleDeltaCodec : public pmFastCodec
+{
+public:
+    pmShuffleDeltaCodec(size_t pElemSize);
+
+protected:
+    virtual ulong EncodeBlock(const char* pSrc, ulong pLength, char* pDest, ulong pDestCapacity) const;
+    virtual void DecodeBlock(const char* pSrc, ulong pCompressedLength, char* pDest, ulong pLength) const;
+
+private:
+    size_t mElemSize;
+};
+
+/* Wraps pmUtility::CompressForSentinel over 4 byte elements with zero as the sentinel */
+class pmSentinelCodec : public pmCompressionCodec
+{
+public:
+    virtual std::shared_ptr<char> Compress(const char* pMem, ulong pLength, ulong& pCompressedLength) const;
+    virtual void Decompress(const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength) const;
+};
+
+/**
+ * Chooses and applies the codec for memory transfers. The codec of an address space comes from its allocation
+ * policy (or environment variable PMLIB_NETWORK_COMPRESSION - none, adaptive, fast, shuffle32, shuffle64 or sentinel -
+ * if the policy has COMPRESSION_DEFAULT). Under COMPRESSION_ADAPTIVE, every codec is periodically tried on a prefix
+ * of the transfer and the one minimizing the estimated time to compress, send and decompress is used. The network
+ * bandwidth is measured from outgoing memory transfers (timed from the post of the send to its completion) unless
+ * environment variable PMLIB_NETWORK_BANDWIDTH (in MB/s) fixes it.
+ */
+class pmNetworkCompressor : public pmBase
+{
+public:
+    static pmNetworkCompressor* GetNetworkCompressor();
+
+    /* Compresses pCount rows of pLength bytes each, pStep bytes apart. Returns an empty pointer (and CODEC_NONE in pCodec)
+     * if the memory should be sent uncompressed. */
+    std::shared_ptr<char> Compress(pmAddressSpace* pAddressSpace, const char* pMem, ulong pLength, ulong pStep, ulong pCount, ulong& pCompressedLength, networkCompression::codecType& pCodec);
+    void Decompress(networkCompression::codecType pCodec, const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength, ulong pStep, ulong pCount);
+
+    void RecordTransfer(ulong pLength, double pTimeInSecs);
+    double GetBandwidth();  // bytes per second
+
+    static const char* GetCodecName(networkCompression::codecType pCodec);
+
+private:
+    pmNetworkCompressor();
+
+    pmNetworkCompression GetCompression(const pmAddressSpace* pAddressSpace) const;
+    networkCompression::codecType SelectAdaptiveCodec(pmAddressSpace* pAddressSpace, const char* pMem, ulong pLength);
+    void Probe(networkCompression::codecStatistics& pStatistics, networkCompression::codecType pCodec, const char* pMem, ulong pLength);
+
+    std::unique_ptr<pmCompressionCodec> mCodecs[networkCompression::MAX_CODECS];
+    pmNetworkCompression mDefaultCompression;
+    bool mFixedBandwidth;
+    double mBandwidth;  // bytes per second
+    RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
+};
+
+} // end namespace pm
+
+#endif
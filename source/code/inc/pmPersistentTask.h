@@ -0,0 +1,98 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_PERSISTENT_TASK__
+#define __PM_PERSISTENT_TASK__
+
+#include "pmBase.h"
+#include "pmCommand.h"
+#include "pmResourceLock.h"
+#include "pmSubtaskManager.h"
+
+#include <map>
+#include <vector>
+
+namespace pm
+{
+
+class pmLocalTask;
+class pmAddressSpace;
+class pmExecutionStub;
+
+/**
+ * \brief A task definition that is launched repeatedly (e.g. once per iteration of an iterative algorithm).
+ * Every launch is an independent pmLocalTask and starts only after the previous launch has finished. The scheduling
+ * state learnt by a successful launch (subtask manager history, execution rates of local stubs and the affinity
+ * mapping along with the affinity address space it was computed from) seeds the next launch.
+ */
+class pmPersistentTask : public pmBase
+{
+public:
+    pmPersistentTask(const pmTaskDetails& pTaskDetails);
+
+    pmTaskDetails PrepareLaunch(pmTaskMem* pTaskMem, void* pTaskConf);
+    std::vector<pmCommandPtr> RegisterLaunch(pmLocalTask* pLocalTask);
+
+    void SeedLaunch(pmLocalTask* pLocalTask);
+    void RecordLaunchCompletion(pmLocalTask* pLocalTask, pmStatus pStatus);
+
+    const pmSchedulingHistory* GetSchedulingHistory() const;
+    bool HasAffinityMappings() const;
+
+    void UserDelete();
+
+private:
+    ~pmPersistentTask();
+
+    pmTaskDetails mTaskDetails;
+    std::vector<char> mTaskConf;
+    std::vector<pmTaskMem> mTaskMem;
+    std::vector<size_t> mAddressSpaceLengths;
+
+    pmCommandPtr mLastLaunchCommand;
+    ulong mPendingLaunches;
+    bool mUserDelete;
+
+    bool mHasSchedulingHistory;
+    pmSchedulingHistory mSchedulingHistory;
+    std::map<pmExecutionStub*, std::pair<double, double>> mExecutionRates;    // Local stub versus subtasks executed and execution time (in secs)
+
+    std::vector<ulong> mLogicalToPhysicalSubtaskMappings;
+    pmAddressSpace* mAffinityAddressSpace;
+
+    RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
+};
+
+} // end namespace pm
+
+#endif
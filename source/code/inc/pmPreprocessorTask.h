@@ -67,6 +67,7 @@ public:
 
     static size_t GetSampleSizeForAffinityCriterion(pmAffinityCriterion pAffinityCriterion);
     static bool IsAffinityTask(pmTask* pTask);
+    static void DestroyPreprocessorTask(pmLocalTask* pUserTask);
 
 private:
     pmPreprocessorTask();
@@ -80,7 +81,6 @@ private:
 pmStatus preprocessorTask_dataDistributionCallback(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo);
 pmStatus preprocessorTask_cpuCallback(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo);
 pmStatus preprocessorTask_taskCompletionCallback(pmTaskInfo pTaskInfo);
-pmStatus userTask_auxillaryTaskCompletionCallback(pmTaskInfo pTaskInfo);
     
 } // end namespace pm
 
@@ -115,6 +115,8 @@ namespace pm
     typedef void* pmDeviceHandle;
 	typedef void* pmCallbackHandle;
 	typedef void* pmClusterHandle;
+	typedef void* pmFetchHandle;
+	typedef void* pmPersistentTaskHandle;
 
 	typedef enum pmMemType
 	{
@@ -142,6 +144,51 @@ namespace pm
         MAX_SUBSCRIPTION_VISBILITY_TYPE
     } pmSubscriptionVisibilityType;
 
+    typedef enum pmMemPlacementPolicy
+    {
+        PLACEMENT_DEFAULT,              // Operating system's default page placement (default option)
+        PLACEMENT_INTERLEAVED,          // Pages are interleaved across the NUMA nodes hosting the machine's CPU devices
+        PLACEMENT_FIRST_TOUCH,          // Pages are placed in the NUMA node of the CPU device whose subtasks subscribe them first
+        MAX_MEM_PLACEMENT_POLICY
+    } pmMemPlacementPolicy;
+
+    typedef enum pmMemPageSize
+    {
+        PAGES_DEFAULT,                  // Base virtual memory pages (default option)
+        PAGES_TRANSPARENT_HUGE,         // Huge page aligned allocation advised for transparent huge pages
+        PAGES_EXPLICIT_HUGE,            // Allocation from the hugetlbfs pool (falls back to transparent huge pages if the pool is exhausted)
+        MAX_MEM_PAGE_SIZE
+    } pmMemPageSize;
+
+    typedef enum pmNetworkCompression
+    {
+        COMPRESSION_DEFAULT,            // As per environment variable PMLIB_NETWORK_COMPRESSION; no compression if it is not set (default option)
+        COMPRESSION_NONE,               // Memory is transferred uncompressed
+        COMPRESSION_ADAPTIVE,           // A codec is chosen per transfer from the measured compression ratios, codec speeds and network bandwidth
+        COMPRESSION_FAST,               // LZ4 style byte oriented compression
+        COMPRESSION_SHUFFLE_DELTA_32,   // Byte shuffle and delta coding of 4 byte elements (e.g. int, float) followed by COMPRESSION_FAST
+        COMPRESSION_SHUFFLE_DELTA_64,   // Byte shuffle and delta coding of 8 byte elements (e.g. long, double) followed by COMPRESSION_FAST
+        COMPRESSION_SENTINEL,           // Elimination of runs of zero valued 4 byte elements
+        MAX_NETWORK_COMPRESSION
+    } pmNetworkCompression;
+
+    /** Allocation policy for memory created by pmCreateMemory and pmCreateMemory2D.
+     *  The policy applies on every host that allocates the memory. Huge pages are not used with lazy memory.
+     *  The compression codec applies whenever a host sends the memory to another host.
+     */
+    typedef struct pmMemAllocationPolicy
+    {
+        pmMemPlacementPolicy placement;     /* By default, this is PLACEMENT_DEFAULT */
+        pmMemPageSize pageSize;             /* By default, this is PAGES_DEFAULT */
+        bool adviseAccessPattern;           /* By default, this is false. If true, read subscriptions are advised to the kernel (MADV_WILLNEED/MADV_SEQUENTIAL) before subtask execution */
+        pmNetworkCompression compression;   /* By default, this is COMPRESSION_DEFAULT */
+
+        pmMemAllocationPolicy();
+        pmMemAllocationPolicy(pmMemPlacementPolicy, pmMemPageSize);
+        pmMemAllocationPolicy(pmMemPlacementPolicy, pmMemPageSize, bool);
+        pmMemAllocationPolicy(pmMemPlacementPolicy, pmMemPageSize, bool, pmNetworkCompression);
+    } pmMemAllocationPolicy;
+
 	/** Structures for memory subscription */
 	typedef struct pmSubscriptionInfo
 	{
@@ -349,6 +396,10 @@ namespace pm
      */
 	pmStatus pmCreateMemory2D(size_t pRows, size_t pCols, pmMemHandle* pMemHandle);
 
+	/** Variants of the above memory creation APIs which place the allocated memory as per pAllocationPolicy */
+	pmStatus pmCreateMemory(size_t pLength, pmMemHandle* pMemHandle, const pmMemAllocationPolicy& pAllocationPolicy);
+	pmStatus pmCreateMemory2D(size_t pRows, size_t pCols, pmMemHandle* pMemHandle, const pmMemAllocationPolicy& pAllocationPolicy);
+
     /* The memory destruction API. The same interface is used for both input and output memory */
 	pmStatus pmReleaseMemory(pmMemHandle pMemHandle);
     
@@ -362,6 +413,27 @@ namespace pm
      */
     pmStatus pmFetchMemoryRange(pmMemHandle pMemHandle, size_t pOffset, size_t pLength);
 
+    /** This routine fetches the pRangeCount ranges in pRanges into the local buffer. Ranges owned by the same
+     *  remote host are requested from it in a single message. This is a blocking call.
+     */
+    pmStatus pmFetchMemoryRanges(pmMemHandle pMemHandle, const pmSubscriptionInfo* pRanges, uint pRangeCount);
+
+    /** Non-blocking variants of pmFetchMemoryRange and pmFetchMemoryRanges. These issue the fetch and return a handle in
+     *  pFetchHandle, which may be polled with pmTestFetch or waited upon with pmWaitForFetch. Every handle must be released
+     *  with pmReleaseFetch. The memory must not be released while a fetch on it is outstanding.
+     */
+    pmStatus pmFetchMemoryRangeAsync(pmMemHandle pMemHandle, size_t pOffset, size_t pLength, pmFetchHandle* pFetchHandle);
+    pmStatus pmFetchMemoryRangesAsync(pmMemHandle pMemHandle, const pmSubscriptionInfo* pRanges, uint pRangeCount, pmFetchHandle* pFetchHandle);
+
+    /** Sets pComplete to true if all data requested by the fetch is locally available. This call never blocks. */
+    pmStatus pmTestFetch(pmFetchHandle pFetchHandle, bool* pComplete);
+
+    /** Blocks until all data requested by the fetch is locally available */
+    pmStatus pmWaitForFetch(pmFetchHandle pFetchHandle);
+
+    /** Releases the fetch handle. This waits for the fetch if it is still in progress. */
+    pmStatus pmReleaseFetch(pmFetchHandle pFetchHandle);
+
     /** This routine returns the naked memory pointer associated with pMem handle.
      *  This pointer may be used in memcpy and related functions.
      */
@@ -464,6 +536,51 @@ namespace pm
 	/** The task submission API. Returns the task handle in variable pTaskHandle on success. */
 	pmStatus pmSubmitTask(pmTaskDetails pTaskDetails, pmTaskHandle* pTaskHandle);
 
+    /** An explicit dependency between two tasks of a task graph. Both members are indices into the array of
+     *  tasks passed to pmSubmitTaskGraph and the prerequisite must appear before the dependent in that array.
+     */
+    typedef struct pmTaskDependency
+    {
+        uint prerequisite;
+        uint dependent;
+        
+        pmTaskDependency();
+        pmTaskDependency(uint, uint);
+    } pmTaskDependency;
+
+    /** The task graph submission API. Submits pTaskCount tasks in one call and returns their handles in pTaskHandles
+     *  (which must have space for pTaskCount handles). A task starts as soon as all tasks it depends upon have finished,
+     *  without any host side synchronization in between; tasks with no dependency path between them may run concurrently.
+     *  Besides the explicit pDependencies, dependencies are derived from the address spaces in the order of the array -
+     *  a task depends upon the last earlier task writing an address space it uses, and a task writing an address space
+     *  also depends upon all earlier tasks reading it since its last writer. A dependent task starts even if its
+     *  prerequisites fail; the exit status of each task is reported by pmWaitForTaskCompletion. All handles must be
+     *  released individually with pmReleaseTask.
+     */
+    pmStatus pmSubmitTaskGraph(pmTaskDetails* pTaskDetails, uint pTaskCount, const pmTaskDependency* pDependencies, uint pDependencyCount, pmTaskHandle* pTaskHandles);
+
+    /** Submits a task that starts once the already submitted tasks pPrerequisiteTasks have finished. This allows
+     *  growing a task graph incrementally. The prerequisite tasks must not be released before this call returns.
+     */
+    pmStatus pmSubmitTaskAfter(pmTaskDetails pTaskDetails, const pmTaskHandle* pPrerequisiteTasks, uint pPrerequisiteCount, pmTaskHandle* pTaskHandle);
+
+    /** Persistent tasks suit iterative algorithms that run the same task over and over (often with input and output
+     *  address spaces swapped between iterations). pmCreatePersistentTask validates and stores pTaskDetails (including a
+     *  copy of the task configuration) without submitting anything. Each pmLaunchPersistentTask submits one execution
+     *  and returns an ordinary task handle, which is waited upon and released like any other task. A launch starts
+     *  only after the previous launch of the same persistent task has finished. The scheduling state learnt by a
+     *  launch is carried into the next one - subtask allotments and slow start allocation sizes of devices, subtask
+     *  execution rates of the local devices and, for RANDOM_STEAL_WITH_AFFINITY, the affinity mapping (the affinity
+     *  preprocessing is done only once).
+     *  pTaskMem (if not NULL) must have taskMemCount entries; their memory types must match pTaskDetails and every
+     *  address space must be as long as the one it replaces. A NULL pTaskMem launches with the address spaces of the
+     *  previous launch. pTaskConf (if not NULL) replaces the stored task configuration (of length taskConfLength).
+     *  The handles passed in pTaskDetails must stay valid till the persistent task is released.
+     */
+    pmStatus pmCreatePersistentTask(pmTaskDetails pTaskDetails, pmPersistentTaskHandle* pPersistentTaskHandle);
+    pmStatus pmLaunchPersistentTask(pmPersistentTaskHandle pPersistentTaskHandle, pmTaskMem* pTaskMem, void* pTaskConf, pmTaskHandle* pTaskHandle);
+    pmStatus pmReleasePersistentTask(pmPersistentTaskHandle pPersistentTaskHandle);
+
 	/** The submitted tasks must be released by the application using the following API.
 	 *	The API automatically blocks till task completion. Returns the task's exit status.
 	 */
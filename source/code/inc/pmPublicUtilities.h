@@ -74,6 +74,41 @@ namespace pm
     /**  The following function can be called from within a custom implementation of pmDataReductionCallback. */
     pmStatus pmReduceSubtasks(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handle, unsigned long pSubtask1Id, pmSplitInfo& pSplitInfo1, pmDeviceHandle pDevice2Handle, unsigned long pSubtask2Id, pmSplitInfo& pSplitInfo2, pmReductionOpType pOperation, pmReductionDataType pDataType);
 
+    /** User defined reduction operators. The function must combine pCount elements of pIn into pInOut element-wise
+     *  (i.e. pInOut[i] = pInOut[i] op pIn[i]) and the operation must be associative. An element may be any trivially
+     *  copyable type (including compound types like structs) of size elemSize bytes. Set commutative to false if the
+     *  order of operands matters. Set zeroIdentity if an element with all bytes zero is the identity of the operation
+     *  (e.g. addition); this allows PMLIB to compress such elements while sending reduction data over the network.
+     */
+    typedef void (*pmReductionFunction)(void* pInOut, const void* pIn, unsigned long pCount);
+
+    typedef struct pmReductionOperation
+    {
+        size_t elemSize;
+        pmReductionFunction function;
+        bool commutative;
+        bool zeroIdentity;
+        
+        pmReductionOperation();
+        pmReductionOperation(size_t pElemSize, pmReductionFunction pFunction, bool pCommutative = true, bool pZeroIdentity = false);
+    } pmReductionOperation;
+
+    typedef void* pmReductionOpHandle;
+    
+    const size_t MAX_USER_REDUCTION_OPERATIONS = 32;
+
+    /** The user defined reduction operator registeration API. Like pmRegisterCallbacks, this must be called on all machines
+     *  using the same key and in the same order. At most MAX_USER_REDUCTION_OPERATIONS operators can be registered.
+     *  Registered operators live till pmFinalize.
+     */
+    pmStatus pmRegisterReductionOperation(const char* pKey, pmReductionOperation pOperation, pmReductionOpHandle* pReductionOpHandle);
+
+    /** The following function returns the inbuilt reduction callback for a user defined reduction operator. */
+    pmDataReductionCallback pmGetSubtaskReductionCallbackImpl(pmReductionOpHandle pReductionOpHandle);
+
+    /**  The following function can be called from within a custom implementation of pmDataReductionCallback. */
+    pmStatus pmReduceSubtasks(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handle, unsigned long pSubtask1Id, pmSplitInfo& pSplitInfo1, pmDeviceHandle pDevice2Handle, unsigned long pSubtask2Id, pmSplitInfo& pSplitInfo2, pmReductionOpHandle pReductionOpHandle);
+
     const size_t MAX_FILE_SIZE_LEN = 2048;
 
     /** This function returns the starting address of the file specified by pPath and memory mapped by the call pmMapFile.
@@ -96,6 +131,17 @@ namespace pm
      The number of bytes in each pPaths entry must be less than MAX_FILE_SIZE_LEN. */
     pmStatus pmUnmapFiles(const char* const* pPaths, uint pFileCount);
 
+    /** This function creates a read only address space holding the contents of the file specified by pPath. Unlike pmMapFile, the file
+     is not mapped in its entirety on all machines; other machines read (from their own view of pPath) only the byte ranges subscribed
+     by the subtasks they execute. The memory is released using pmReleaseMemory and can only be used as READ_ONLY(_LAZY) task memory.
+     The number of bytes in pPath must be less than MAX_FILE_SIZE_LEN. */
+    pmStatus pmCreateFileBackedMemory(const char* pPath, pmMemHandle* pMemHandle);
+
+    /** This function turns binary event tracing on or off on the calling machine. Tracing can also be turned on at startup by setting
+     the environment variable PMLIB_TRACE=1. Events are written to pmlib_trace_<host id>.bin in the directory named by the environment
+     variable PMLIB_TRACE_DIR (current directory by default); the file is completed by pmFinalize. */
+    pmStatus pmSetEventTracing(bool pEnable);
+
 }   // end namespace pm
 
 #endif
@@ -40,6 +40,8 @@
 
 #include <vector>
 #include <limits>
+#include <string>
+#include <algorithm>
 
 namespace pm
 {
@@ -69,6 +71,70 @@ struct lastSubtaskData
     {}
 };
 
+struct userReductionOperation
+{
+    std::string key;
+    pmReductionOperation operation;
+    uint slot;
+};
+
+enum reductionTopology
+{
+    BINOMIAL_TREE,
+    RING,               // Ring reduce-scatter followed by a gather of the reduced segments at the originating host
+    RECURSIVE_HALVING,  // Recursive halving reduce-scatter followed by a gather of the reduced segments at the originating host
+    MAX_REDUCTION_TOPOLOGIES
+};
+
+/* The reduced subscription is split into count nearly equal segments (the first few being one element longer).
+ * A segment descriptor names the range [begin, end) of these segments.
+ */
+struct reductionSegment
+{
+    uint step;
+    uint begin;
+    uint end;
+    uint count;
+    bool gather;
+
+    reductionSegment()
+    : step(0)
+    , begin(0)
+    , end(1)
+    , count(1)
+    , gather(false)
+    {}
+
+    reductionSegment(uint pStep, uint pBegin, uint pEnd, uint pCount, bool pGather)
+    : step(pStep)
+    , begin(pBegin)
+    , end(pEnd)
+    , count(pCount)
+    , gather(pGather)
+    {}
+
+    void GetElementRange(ulong pElemCount, ulong& pFirstElem, ulong& pElems) const
+    {
+        ulong lBase = pElemCount / count;
+        ulong lExtra = pElemCount % count;
+
+        pFirstElem = begin * lBase + std::min<ulong>(begin, lExtra);
+        pElems = end * lBase + std::min<ulong>(end, lExtra) - pFirstElem;
+    }
+};
+
+struct reductionStep
+{
+    const pmMachine* sendToMachine;     // NULL, if nothing is sent in this step
+    reductionSegment segment;
+    uint receives;                      // Segments received in this step; all of them are reduced before the next step begins
+
+    reductionStep()
+    : sendToMachine(NULL)
+    , receives(0)
+    {}
+};
+
 }
     
 class pmReducer : public pmBase
@@ -90,15 +156,30 @@ class pmReducer : public pmBase
 
         void ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, pmReductionOpType pReductionOperation, pmReductionDataType pReductionDataType);
     
+        void ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, const pmReductionOperation& pOperation);
+
         void ReduceExternalMemory(pmExecutionStub* pStub, const pmCommandPtr& pCommand);
 
         void PerformDirectExternalReductions();
         void RegisterExternalReductionFinish();
     
+        static const reducer::userReductionOperation* RegisterUserReductionOperation(const char* pKey, const pmReductionOperation& pOperation);
+        static const reducer::userReductionOperation* FindUserReductionOperation(pmDataReductionCallback pCallback);
+        static pmDataReductionCallback GetUserReductionCallback(uint pSlot);
+    
+        static const char* GetTopologyName(reducer::reductionTopology pTopology);
+    
 	private:
 		void PopulateExternalMachineList();
 		ulong GetMaxPossibleExternalReductionReceives(uint pFollowingMachineCount);
+        reducer::reductionTopology SelectTopology(uint pMachineCount);
         void CheckReductionFinishInternal();
+        void CheckTopologyReductionProgressInternal();
+        void RegisterParticipationInternal(const pmMachine* pMachine, communicator::subtaskMemoryReduceMessageType pMessageType);
+        void BuildTopologyScheduleInternal();
+        void BuildRingSchedule(const std::vector<const pmMachine*>& pParticipants, uint pRank);
+        void BuildRecursiveHalvingSchedule(const std::vector<const pmMachine*>& pParticipants, uint pRank);
+        void FallbackToBinomialTreeInternal();
         void AddReductionFinishEvent();
 
         void SignalSendToMachineAboutNoLocalReductionInternal();
@@ -106,11 +187,17 @@ class pmReducer : public pmBase
         template<typename datatype>
         void ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, pmReductionOpType pReductionType);
 
+        template<typename reductionFunction>
+        void ReduceSubtaskAddressSpaces(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, size_t pElemSize, reductionFunction pFunction);
+
         template<typename datatype>
         void ReduceMemories(datatype* pShadowMem1, datatype* pShadowMem2, size_t pDataCount, pmReductionOpType pReductionType);
 
         template<typename datatype>
-        void ReduceMemoriesCompressed(datatype* pShadowMem1, datatype* pShadowMem2, size_t pDataCount, pmReductionOpType pReductionType, datatype pSentinel);
+        void ReduceMemoriesCompressed(datatype* pShadowMem1, const void* pCompressedMem, ulong pCompressedLength, pmReductionOpType pReductionType);
+
+        void ReduceMemories(void* pShadowMem1, void* pShadowMem2, size_t pDataCount, const pmReductionOperation& pOperation);
+        void ReduceMemoriesCompressed(void* pShadowMem1, const void* pCompressedMem, ulong pCompressedLength, const pmReductionOperation& pOperation);
 
         reducer::lastSubtaskData mLastSubtask;
 
@@ -125,6 +212,20 @@ class pmReducer : public pmBase
 
         bool mReductionTerminated;
     
+        /* Ring and recursive halving topologies run among the machines holding reduction data. These are known once every
+         * machine has announced its participation (after its subtask execution finishes).
+         */
+        reducer::reductionTopology mTopology;
+        std::vector<const pmMachine*> mMachines;    // Originating host first
+        std::vector<ushort> mParticipation;         // Indexed like mMachines; MAX_SUBTASK_MEMORY_REDUCE_MESSAGE_TYPES if not yet known
+        uint mPendingParticipations;
+        bool mParticipationAnnounced;
+        bool mScheduleBuilt;
+        std::vector<reducer::reductionStep> mSchedule;
+        uint mCurrentStep;
+        bool mCurrentStepSent;
+        ulong mScheduledReceives;                   // Receives in the schedule up to and including the current step
+    
 		RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
 };
 
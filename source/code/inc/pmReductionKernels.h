@@ -0,0 +1,72 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_REDUCTION_KERNELS__
+#define __PM_REDUCTION_KERNELS__
+
+#include "pmBase.h"
+
+namespace pm
+{
+
+/**
+ * Element wise kernels for the inbuilt reduction operations (pDest[i] = pDest[i] <op> pSrc[i]).
+ * Every operation/data type pair is compiled once per instruction set and the widest one supported
+ * by the executing processor is used. PMLIB_REDUCTION_ISA (generic, sse2, avx2, avx512) may be set
+ * to lower the choice for benchmarking or debugging.
+ */
+class pmReductionKernels
+{
+public:
+    typedef enum instructionSet
+    {
+        GENERIC_ISA,    // Compiler generated code for the build target
+        SSE2_ISA,
+        AVX2_ISA,
+        AVX512_ISA,
+        MAX_INSTRUCTION_SETS
+    } instructionSet;
+
+    template<typename datatype>
+    static void Reduce(datatype* pDest, const datatype* pSrc, size_t pCount, pmReductionOpType pReductionType);
+
+    static instructionSet GetInstructionSet();
+    static const char* GetInstructionSetName(instructionSet pInstructionSet);
+
+private:
+    static instructionSet GetSupportedInstructionSet();
+};
+
+} // end namespace pm
+
+#endif
@@ -0,0 +1,165 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_REMOTE_DATA_CACHE__
+#define __PM_REMOTE_DATA_CACHE__
+
+#include "pmBase.h"
+#include "pmCache.h"
+#include "pmCommunicator.h"
+
+#include <map>
+#include <vector>
+
+namespace pm
+{
+
+class pmRemoteDataCache;
+
+struct pmRemoteDataCacheKey
+{
+    communicator::memoryIdentifierStruct memIdentifier;
+    ulong offset;
+
+    pmRemoteDataCacheKey(const communicator::memoryIdentifierStruct& pMemIdentifier, ulong pOffset)
+    : memIdentifier(pMemIdentifier)
+    , offset(pOffset)
+    {}
+
+    bool operator== (const pmRemoteDataCacheKey& pKey) const
+    {
+        return (memIdentifier == pKey.memIdentifier && offset == pKey.offset);
+    }
+};
+
+struct pmRemoteDataCacheHasher
+{
+    std::size_t operator() (const pmRemoteDataCacheKey& pKey) const
+    {
+        return (std::hash<ulong>()(pKey.memIdentifier.generationNumber) ^ (std::hash<uint>()(pKey.memIdentifier.memOwnerHost) << 1) ^ (std::hash<ulong>()(pKey.offset) << 2));
+    }
+};
+
+struct pmRemoteDataCacheValue
+{
+    pmRemoteDataCacheKey key;
+    std::vector<char> data;
+
+    pmRemoteDataCacheValue(const pmRemoteDataCacheKey& pKey, const void* pData, ulong pLength)
+    : key(pKey)
+    , data(static_cast<const char*>(pData), static_cast<const char*>(pData) + pLength)
+    {}
+};
+
+struct pmRemoteDataCacheEvictor
+{
+    pmRemoteDataCacheEvictor(pmRemoteDataCache* pCache)
+    : mCache(pCache)
+    {}
+
+    void operator() (const std::shared_ptr<pmRemoteDataCacheValue>& pValue);
+
+private:
+    pmRemoteDataCache* mCache;
+};
+
+struct pmRemoteDataCacheStatistics
+{
+    ulong hits;             // Remote regions (or parts thereof) served from the cache
+    ulong misses;           // Remote regions (or parts thereof) fetched over the network
+    ulong evictions;        // Entries purged to make room for new ones
+    ulong invalidations;    // Entries dropped because their data was written or the address space was deleted
+    size_t hitBytes;
+    size_t missBytes;
+
+    pmRemoteDataCacheStatistics()
+    : hits(0)
+    , misses(0)
+    , evictions(0)
+    , invalidations(0)
+    , hitBytes(0)
+    , missBytes(0)
+    {}
+};
+
+/**
+ * \brief Bounded host memory cache of remote data received for read only access.
+ * Remote regions received while an address space is not exclusively locked (i.e. for read only tasks or user fetches)
+ * are copied here. Later fetches of these regions (by tasks of any type) are served from the cache instead of the
+ * network, even after the copies in the address space have been dropped from its directory. Entries are invalidated
+ * as soon as any task writes to them. Entries never overlap and are keyed by address space and offset; an ordered
+ * index per address space allows range lookups and invalidations. The capacity is REMOTE_DATA_CACHE_SIZE bytes,
+ * overridden by environment variable PMLIB_REMOTE_DATA_CACHE_SIZE (in MB; zero turns the cache off).
+ */
+class pmRemoteDataCache : public pmBase
+{
+    friend struct pmRemoteDataCacheEvictor;
+
+public:
+    typedef pmCache<pmRemoteDataCacheKey, pmRemoteDataCacheValue, pmRemoteDataCacheHasher, pmRemoteDataCacheEvictor, REMOTE_DATA_CACHE_EVICTION_POLICY> pmRemoteDataCacheType;
+
+    static pmRemoteDataCache* GetRemoteDataCache();
+
+    bool IsEnabled() const;
+
+    void Insert(const communicator::memoryIdentifierStruct& pMemIdentifier, const void* pData, ulong pOffset, ulong pLength);
+    void Serve(const communicator::memoryIdentifierStruct& pMemIdentifier, void* pAddressSpaceBaseAddr, ulong pOffset, ulong pLength, std::vector<std::pair<ulong, ulong>>& pServedRanges, std::vector<std::pair<ulong, ulong>>& pMissedRanges);
+
+    void Invalidate(const communicator::memoryIdentifierStruct& pMemIdentifier);
+    void Invalidate(const communicator::memoryIdentifierStruct& pMemIdentifier, ulong pOffset, ulong pLength);
+
+    pmRemoteDataCacheStatistics GetStatistics();
+    
+private:
+    typedef std::map<std::pair<uint, ulong>, std::map<ulong, ulong>> indexType;    // Address space (owner host, generation number) versus offset versus length of cached regions
+
+    pmRemoteDataCache();
+    ~pmRemoteDataCache();
+
+    static std::pair<uint, ulong> GetIndexKey(const communicator::memoryIdentifierStruct& pMemIdentifier);
+    
+    ulong InvalidateInternal(const communicator::memoryIdentifierStruct& pMemIdentifier, ulong pOffset, ulong pLength);
+    void RecordRemoval(const pmRemoteDataCacheValue& pValue);
+
+    size_t mCapacity;
+    size_t mOccupancy;
+    indexType mIndex;
+    pmRemoteDataCacheStatistics mStatistics;
+    pmRemoteDataCacheType mCache;
+
+    RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
+};
+
+} // end namespace pm
+
+#endif
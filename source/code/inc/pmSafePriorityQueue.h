@@ -73,10 +73,11 @@ class pmSafePQ : public pmBase
         void WaitForCurrentItem();
         void WaitIfMatchingItemBeingProcessed(matchFuncPtr pMatchFunc, void* pMatchCriterion);
     
-        pmStatus DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pItem, bool pTemporarilyUnblockSecondaryOperations);
-        void DeleteAndGetAllMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pItems, bool pTemporarilyUnblockSecondaryOperations);
-		void DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion);
-        bool HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion);
+        /* pIndexKey is only meaningful for pmIndexedPQ; all items of the priority are matched here */
+        pmStatus DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pItem, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey = NULL);
+        void DeleteAndGetAllMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pItems, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey = NULL);
+		void DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey = NULL);
+        bool HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey = NULL);
 
 		bool IsHighPriorityElementPresent(P pPriority);
 
@@ -97,6 +97,7 @@ enum eventIdentifier
 	TASK_FINISH,
     TASK_COMPLETE,
     NO_REDUCTION_REQD,
+    REDUCTION_PARTICIPATION,
 	COMMAND_COMPLETION,
     HOST_FINALIZATION,
     SUBTASK_RANGE_CANCEL,
@@ -124,6 +125,8 @@ struct schedulerEvent : public pmBasicThreadEvent
     schedulerEvent(eventIdentifier pEventId = MAX_SCHEDULER_EVENTS)
     : eventId(pEventId)
     {}
+
+    const void* GetIndexKey() const;
 };
 
 struct taskSubmissionEvent : public schedulerEvent
@@ -186,14 +189,16 @@ struct stealProcessEvent : public schedulerEvent
 	const pmProcessingElement* targetDevice;
 	pmTask* task;
 	double stealingDeviceExecutionRate;
+    double stealRoundTripTime;
     bool shouldMultiAssign;
     
-    stealProcessEvent(eventIdentifier pEventId, const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pStealingDeviceExecutionRate, bool pShouldMultiAssign)
+    stealProcessEvent(eventIdentifier pEventId, const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pStealingDeviceExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign)
     : schedulerEvent(pEventId)
     , stealingDevice(pStealingDevice)
     , targetDevice(pTargetDevice)
     , task(pTask)
     , stealingDeviceExecutionRate(pStealingDeviceExecutionRate)
+    , stealRoundTripTime(pStealRoundTripTime)
     , shouldMultiAssign(pShouldMultiAssign)
     {}
 };
@@ -401,6 +406,20 @@ struct noReductionRequiredEvent : public schedulerEvent
     {}
 };
 
+struct reductionParticipationEvent : public schedulerEvent
+{
+    pmTask* task;
+    std::vector<const pmMachine*> machines;
+    communicator::subtaskMemoryReduceMessageType messageType;
+    
+    reductionParticipationEvent(eventIdentifier pEventId, pmTask* pTask, std::vector<const pmMachine*>&& pMachines, communicator::subtaskMemoryReduceMessageType pMessageType)
+    : schedulerEvent(pEventId)
+    , task(pTask)
+    , machines(std::move(pMachines))
+    , messageType(pMessageType)
+    {}
+};
+
 struct commandCompletionEvent : public schedulerEvent
 {
 	const pmCommandPtr command;
@@ -548,7 +567,7 @@ struct externalReductionFinishEvent : public schedulerEvent
  * Only one object of this class is created for each machine. This class is thread safe.
  */
 
-class pmScheduler : public THREADING_IMPLEMENTATION_CLASS<scheduler::schedulerEvent>
+class pmScheduler : public THREADING_IMPLEMENTATION_CLASS<scheduler::schedulerEvent, ushort, EVENT_QUEUE_IMPLEMENTATION_CLASS<scheduler::schedulerEvent>>
 {
 	friend void SchedulerCommandCompletionCallback(const pmCommandPtr& pCommand);
     
@@ -571,7 +590,7 @@ class pmScheduler : public THREADING_IMPLEMENTATION_CLASS<scheduler::schedulerEv
 		void SubmitTaskEvent(pmLocalTask* pLocalTask);
 		void PushEvent(const pmProcessingElement* pDevice, const pmSubtaskRange& pRange, bool pIsStealResponse);		// subtask range execution event
 		void StealRequestEvent(const pmProcessingElement* pStealingDevice, pmTask* pTask, double pExecutionRate);
-		void StealProcessEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, bool pMultiAssign);
+		void StealProcessEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, double pStealRoundTripTime, bool pMultiAssign);
 		void StealSuccessEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange);
         void StealFailedEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask);
 		void StealSuccessReturnEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange);
@@ -593,6 +612,7 @@ class pmScheduler : public THREADING_IMPLEMENTATION_CLASS<scheduler::schedulerEv
         void TaskFinishEvent(pmTask* pTask);
         void TaskCompleteEvent(pmLocalTask* pLocalTask);
         void NoReductionRequiredEvent(pmTask* pTask, const pmMachine* pDestMachine);
+        void ReductionParticipationEvent(pmTask* pTask, std::vector<const pmMachine*>&& pDestMachines, communicator::subtaskMemoryReduceMessageType pMessageType);
     
         void CommandCompletionEvent(const pmCommandPtr& pCommand);
         void RangeCancellationEvent(const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange);
@@ -661,7 +681,7 @@ class pmScheduler : public THREADING_IMPLEMENTATION_CLASS<scheduler::schedulerEv
 
 		void StealSubtasks(const pmProcessingElement* pStealingDevice, pmTask* pTask, double pExecutionRate);
 
-		void ServeStealRequest(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, bool pShouldMultiAssign);
+		void ServeStealRequest(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign);
 		void ReceiveFailedStealResponse(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask);
 		void ReceiveStealResponse(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange);
     
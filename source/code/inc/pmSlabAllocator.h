@@ -0,0 +1,115 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_SLAB_ALLOCATOR__
+#define __PM_SLAB_ALLOCATOR__
+
+#include "pmBase.h"
+
+#include <vector>
+#include <memory>
+
+namespace pm
+{
+
+/* Carves fixed size objects out of large chunks. Freed objects go on a free list and are reused by later allocations; chunks
+ * themselves are only released (in bulk) when the slab is destroyed. The slab is not thread safe; users serialize access. */
+class pmSlab : public pmBase
+{
+public:
+    pmSlab(size_t pObjectsPerChunk);
+    ~pmSlab();
+
+    void* Allocate(size_t pSize);
+    void Deallocate(void* pMem, size_t pSize);
+
+private:
+    size_t mObjectsPerChunk;
+    size_t mObjectSize;     // Fixed by the first allocation; allocations of any other size bypass the slab
+    size_t mSlotSize;
+
+    std::vector<void*> mChunks;
+    std::vector<void*> mFreeList;
+
+    char* mNextObject;
+    size_t mObjectsLeftInChunk;
+};
+
+/* Standard allocator drawing from a pmSlab. Every default constructed allocator owns a new slab which is shared by all its copies
+ * (and rebinds), so a node based container using it gets a private slab that lives as long as the container. */
+template<typename T>
+class pmSlabAllocator
+{
+    template<typename U> friend class pmSlabAllocator;
+
+public:
+    typedef T value_type;
+
+    pmSlabAllocator()
+    : mSlab(new pmSlab(SUBTASK_SLAB_CHUNK_OBJECTS))
+    {}
+
+    template<typename U>
+    pmSlabAllocator(const pmSlabAllocator<U>& pAllocator)
+    : mSlab(pAllocator.mSlab)
+    {}
+
+    T* allocate(size_t pCount)
+    {
+        return static_cast<T*>(mSlab->Allocate(pCount * sizeof(T)));
+    }
+
+    void deallocate(T* pMem, size_t pCount)
+    {
+        mSlab->Deallocate(pMem, pCount * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const pmSlabAllocator<U>& pAllocator) const
+    {
+        return (mSlab == pAllocator.mSlab);
+    }
+
+    template<typename U>
+    bool operator!=(const pmSlabAllocator<U>& pAllocator) const
+    {
+        return (mSlab != pAllocator.mSlab);
+    }
+
+private:
+    std::shared_ptr<pmSlab> mSlab;
+};
+
+} // end namespace pm
+
+#endif
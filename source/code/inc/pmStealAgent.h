@@ -117,6 +117,7 @@ public:
 private:
     pmTask* mTask;
     std::vector<stealAgent::stubData> mStubSink;
+    std::vector<ushort> mStubNumaDomains;   // Empty on single domain machines; max ushort for non-CPU stubs
     
 #ifdef ENABLE_DYNAMIC_AGGRESSION
     std::vector<stealAgent::dynamicAggressionStubData> mDynamicAggressionStubSink;
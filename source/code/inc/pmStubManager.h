@@ -72,6 +72,7 @@ class pmStubManager : public pmBase
         const std::vector<std::vector<pmExecutionStub*>>& GetCpuNumaDomains() const;
         const std::vector<pmExecutionStub*>& GetCpuNumaDomain(ushort pDomainId) const;
         ushort GetNumaDomainIdForCpuDevice(uint pIndex) const;
+        uint GetNumaNodeForCpuNumaDomain(ushort pDomainId) const;
 
         void WaitForAllStubsToFinish();
 
@@ -84,6 +85,7 @@ class pmStubManager : public pmBase
 		void CreateExecutionStubs();
 		void DestroyExecutionStubs();
     
+        void DetectCpuTopology();
         void CreateCpuNumaDomains();
 
 		pmStatus CountAndProbeProcessingElements();
@@ -95,6 +97,9 @@ class pmStubManager : public pmBase
 		std::vector<pmExecutionStub*> mStubVector;    
         std::vector<std::vector<pmExecutionStub*>> mCpuNumaDomains;
         std::map<pmExecutionStub*, ushort> mCpuNumaDomainsMap;    // stub versus NUMA domain id
+        std::vector<uint> mCpuNumaDomainNodes;  // NUMA node of each NUMA domain
+        std::vector<size_t> mCpuCoreIds;    // Core to which each CPU stub is bound
+        std::vector<uint> mCpuNumaNodes;    // NUMA node of the core of each CPU stub
 		
 		size_t mProcessingElementsCPU;
 		size_t mProcessingElementsGPU;
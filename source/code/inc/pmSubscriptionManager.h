@@ -38,6 +38,8 @@
 #include "pmResourceLock.h"
 #include "pmCommunicator.h"
 #include "pmRedistributor.h"
+#include "pmFlatMap.h"
+#include "pmSlabAllocator.h"
 
 #include <map>
 #include <vector>
@@ -56,7 +58,7 @@ namespace subscription
 	{
 	};
 
-    typedef std::map<size_t, std::pair<size_t, subscriptionData> > subscriptionRecordType;
+    typedef pmFlatMap<size_t, std::pair<size_t, subscriptionData> > subscriptionRecordType;    // Rebuilt for every subtask; a sorted vector avoids per record node allocations
 
     bool operator==(const subscription::subscriptionRecordType& pRecord1, const subscription::subscriptionRecordType& pRecord2);
     bool operator!=(const subscription::subscriptionRecordType& pRecord1, const subscription::subscriptionRecordType& pRecord2);
@@ -229,10 +231,12 @@ namespace subscription
 class pmSubscriptionManager : public pmBase
 {
     friend class subscription::shadowMemDeallocator;
-    typedef std::map<ulong, subscription::pmSubtask> subtaskMapType;
+
+    /* Every subtask map owns a slab; entries are carved out of it and go back to it (en masse at task end) instead of the heap */
+    typedef std::map<ulong, subscription::pmSubtask, std::less<ulong>, pmSlabAllocator<std::pair<const ulong, subscription::pmSubtask> > > subtaskMapType;
 
 #ifdef SUPPORT_SPLIT_SUBTASKS
-    typedef std::map<std::pair<ulong, pmSplitInfo>, subscription::pmSubtask> splitSubtaskMapType;
+    typedef std::map<std::pair<ulong, pmSplitInfo>, subscription::pmSubtask, std::less<std::pair<ulong, pmSplitInfo> >, pmSlabAllocator<std::pair<const std::pair<ulong, pmSplitInfo>, subscription::pmSubtask> > > splitSubtaskMapType;
 #endif
 
 	public:
@@ -337,6 +341,7 @@ class pmSubscriptionManager : public pmBase
         void InitializeSubtaskShadowMemCompactView(pmExecutionStub* pStub, ulong pSubtaskId, pmSplitInfo* pSplitInfo, uint pMemIndex, void* pShadowMem, void* pMem, size_t pMemLength, size_t pWriteOnlyUnprotectedRanges, uint* pUnprotectedRanges);
 
         void AddSubscriptionRecordToMap(const pmSubscriptionInfo& pSubscriptionInfo, subscription::subscriptionRecordType& pMap);
+        void PlaceAndAdviseSubscriptions(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, const subscription::pmSubtaskAddressSpaceData& pAddressSpaceData);
         void WaitForSubscriptions(subscription::pmSubtask& pSubtask, pmExecutionStub* pStub, pmDeviceType pDeviceType, const std::vector<pmCommandPtr>& pCommandVector);
 
         void CheckAppropriateSubscription(pmAddressSpace* pAddressSpace, pmSubscriptionType pSubscriptionType) const;
@@ -351,6 +356,10 @@ class pmSubscriptionManager : public pmBase
 
         void DestroySubtaskShadowMemInternal(subscription::pmSubtask& pSubtask, pmExecutionStub* pStub, ulong pSubtaskId, pmSplitInfo* pSplitInfo, uint pMemIndex);
 
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+        bool SwapShadowMemPagesIntoAddressSpace(pmAddressSpace* pAddressSpace, char* pShadowMem, size_t pOffset, size_t pLength);
+#endif
+
         void GetNonConsolidatedReadSubscriptionsInternal(subscription::pmSubtask& pSubtask, uint pMemIndex, subscription::subscriptionRecordType::const_iterator& pBegin, subscription::subscriptionRecordType::const_iterator& pEnd);
         void GetNonConsolidatedWriteSubscriptionsInternal(subscription::pmSubtask& pSubtask, uint pMemIndex, subscription::subscriptionRecordType::const_iterator& pBegin, subscription::subscriptionRecordType::const_iterator& pEnd);
 
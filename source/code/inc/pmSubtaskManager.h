@@ -51,6 +51,13 @@ class pmSubtaskRangeCommand;
 class pmProcessingElement;
 class pmMachine;
 
+/* Scheduling state that a subtask manager hands over to the next launch of a persistent task */
+typedef struct pmSchedulingHistory
+{
+    std::map<uint, ulong> deviceExecutionProfile;    // Global Device Index versus Subtasks Executed
+    std::map<uint, std::pair<ulong, std::pair<double, ulong>>> slowStartAllocations;    // Global Device Index versus last allocation size, last allocation exec time (in secs) and freezed allocation size
+} pmSchedulingHistory;
+
 class pmSubtaskManager : public pmBase
 {
 	public:
@@ -79,6 +86,8 @@ class pmSubtaskManager : public pmBase
 		virtual void AssignSubtasksToDevice(const pmProcessingElement* pDevice, ulong& pSubtaskCount, ulong& pStartingSubtask, const pmProcessingElement*& pOriginalAllottee) = 0;
 		virtual void RegisterSubtaskCompletion(const pmProcessingElement* pDevice, ulong pSubtaskCount, ulong pStartingSubtask, pmStatus pExecStatus) = 0;
 
+        virtual void SaveSchedulingHistory(pmSchedulingHistory& pSchedulingHistory);
+
 	protected:
 		pmSubtaskManager(pmLocalTask* pLocalTask);
 
@@ -120,7 +129,10 @@ class pmPushSchedulingManager : public pmSubtaskManager
 		virtual void AssignSubtasksToDevice(const pmProcessingElement* pDevice, ulong& pSubtaskCount, ulong& pStartingSubtask, const pmProcessingElement*& pOriginalAllottee);
 		virtual void RegisterSubtaskCompletion(const pmProcessingElement* pDevice, ulong pSubtaskCount, ulong pStartingSubtask, pmStatus pExecStatus);
     
+        virtual void SaveSchedulingHistory(pmSchedulingHistory& pSchedulingHistory);
+
 	private:
+        void RestoreSchedulingHistory(const pmSchedulingHistory& pSchedulingHistory);
 		void FreezeAllocationSize(const pmProcessingElement* pDevice, ulong pFreezedSize);
 		void UnfreezeAllocationSize(const pmProcessingElement* pDevice);
 		bool IsAllocationSizeFreezed(const pmProcessingElement* pDevice);
@@ -179,6 +191,7 @@ class pmPullSchedulingManager : public pmSingleAssignmentSchedulingManager
     
     private:
         void VaryFixedAllotments(std::vector<pmUnfinishedPartitionPtr>& pVector, uint pMaxPercentVariationFromFixedAllotment);
+        void ResizeAllotmentsFromHistory(std::vector<pmUnfinishedPartitionPtr>& pVector, const std::vector<const pmProcessingElement*>& pDevices, const std::map<uint, ulong>& pDeviceExecutionProfile);
     
     #ifdef SUPPORT_SPLIT_SUBTASKS
         std::vector<pmUnfinishedPartitionPtr> mSplittedGroupAllotmentVaryHelper;
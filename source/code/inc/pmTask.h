@@ -60,6 +60,8 @@ class pmCluster;
 class pmReducer;
 class pmRedistributor;
 class pmAffinityTable;
+class pmPersistentTask;
+struct pmSchedulingHistory;
 
 #ifdef USE_STEAL_AGENT_PER_NODE
     class pmStealAgent;
@@ -197,6 +199,7 @@ class pmTask : public pmBase
         void SetAffinityMappings(std::vector<ulong>&& pLogicalToPhysical, std::vector<ulong>&& pPhysicalToLogical);
         ulong GetPhysicalSubtaskId(ulong pLogicalSubtaskId);
         ulong GetLogicalSubtaskId(ulong pPhysicalSubtaskId);
+        const std::vector<ulong>& GetLogicalToPhysicalSubtaskMappings() const;
 
     private:
 		void BuildTaskInfo();
@@ -207,6 +210,8 @@ class pmTask : public pmBase
     
         void PrepareForStart();
     
+        static RESOURCE_LOCK_IMPLEMENTATION_CLASS& GetAddressSpacesLockingLock();
+
         pmPoolAllocator& GetPoolAllocator(uint pAddressSpaceIndex, size_t pIndividualAllocationSize, size_t pMaxAllocations);
     
 		/* Constant properties -- no updates, locking not required */
@@ -286,7 +291,6 @@ class pmTask : public pmBase
         bool DoesTaskHaveReadWriteAddressSpaceWithNonDisjointSubscriptions() const;
         bool RegisterRedistributionCompletion();    // Returns true when all address spaces finish redistribution
         void ReplaceTaskAddressSpace(uint pAddressSpaceIndex, pmAddressSpace* pNewAddressSpace);
-        const std::vector<ulong>& GetLogicalToPhysicalSubtaskMappings() const;
     
 		uint mAssignedDeviceCount;
         void* mLastReductionScratchBuffer;
@@ -322,16 +326,25 @@ class pmLocalTask : public pmTask
         void RegisterInternalTaskCompletionMessage();
         void UserDeleteTask();
     
+        void SubmitAfter(const std::vector<pmLocalTask*>& pPrerequisiteTasks);
+        void SubmitAfter(const std::vector<pmCommandPtr>& pPrerequisiteCommands);
+        const pmCommandPtr& GetTaskCommand() const;
+    
         void SetPreprocessorTask(pmLocalTask* pLocalTask);
         const pmLocalTask* GetPreprocessorTask() const;
     
         pmAddressSpace* GetAffinityAddressSpace() const;
+        void InheritAffinityMappings(const std::vector<ulong>& pLogicalToPhysicalSubtaskMappings, pmAddressSpace* pAffinityAddressSpace);
+        void RetainAffinityAddressSpace();
+        bool IsAffinityAddressSpaceRetained() const;
+    
+        void SetPersistentTask(pmPersistentTask* pPersistentTask);
+        bool HasInheritedAffinity() const;
+        const pmSchedulingHistory* GetSchedulingHistory() const;
     
         void ComputeAffinityData(pmAddressSpace* pAffinityAddressSpace);
         void StartScheduling();
     
-        void SetTaskCompletionCallback(pmTaskCompletionCallback pCallback);
-    
 		pmStatus GetStatus();
 
         const std::vector<const pmProcessingElement*>& GetAssignedDevices() const;
@@ -364,6 +377,10 @@ class pmLocalTask : public pmTask
     
         pmLocalTask* mPreprocessorTask;
     
+        pmPersistentTask* mPersistentTask;  // Only till this launch of the persistent task completes
+        pmAddressSpace* mAffinityAddressSpace;  // Inherited from an earlier launch of the persistent task
+        bool mAffinityAddressSpaceRetained;
+    
         static ulong& GetSequenceId();   // Task number at the originating host
         static RESOURCE_LOCK_IMPLEMENTATION_CLASS& GetSequenceLock();
 };
@@ -37,6 +37,10 @@
 #include "pmBase.h"
 #include "pmResourceLock.h"
 
+#ifdef DUMP_REMOTE_DATA_CACHE_STATISTICS
+#include "pmRemoteDataCache.h"
+#endif
+
 #include <map>
 
 namespace pm
@@ -44,11 +48,29 @@ namespace pm
 
 class pmTask;
 class pmExecutionStub;
+class pmMachine;
 class pmProcessingElement;
 
 class pmTaskExecStats : public pmBase
 {
 public:
+#ifdef ENABLE_TWO_LEVEL_STEALING
+    typedef pmMachine stealTarget;  // The first level of a steal picks a machine
+#else
+    typedef pmProcessingElement stealTarget;
+#endif
+
+    typedef struct stealTargetStats
+    {
+        uint stealAttempts;
+        uint successfulSteals;
+        double expectedYield;           // subtasks granted per attempt; decays by STEAL_TARGET_YIELD_DECAY
+        uint timedStealResponses;
+        double stealRoundTripTime;      // in secs; accumulated over timedStealResponses
+
+        stealTargetStats();
+    } stealTargetStats;
+
     typedef struct stubStats
     {
     #ifdef SUPPORT_SPLIT_SUBTASKS
@@ -62,8 +84,23 @@ public:
         uint successfulSteals;
         uint failedSteals;
         uint consecutiveFailedSteals;   // number of failed steals after the last successful one
+        double lastStealAttemptTime;    // in secs; zero once the response to the last attempt has arrived
+        uint timedStealResponses;
+        double stealRoundTripTime;      // in secs; accumulated from the attempt to its response over timedStealResponses
+        const stealTarget* lastStealTarget;
+        std::map<const stealTarget*, stealTargetStats> stealTargets;
         
         uint pipelineContinuationAcrossRanges;
+        
+        ulong subtasksPrefetched;
+        ulong prefetchedSubtasksReleased;   // prefetched subtasks which got stolen, negotiated away or cancelled before executing here
+        uint subscriptionStalls;        // number of subtasks which waited on their subscriptions to arrive
+        double subscriptionStallTime;   // in secs
+
+    #ifdef SUPPORT_LAZY_MEMORY
+        ulong lazyFaults;
+        double lazyFaultTime;   // in secs
+    #endif
 
         stubStats();
     } stubStats;
@@ -79,24 +116,43 @@ public:
 
     double GetStubExecutionRate(pmExecutionStub* pStub);
 
+    void SaveExecutionRates(std::map<pmExecutionStub*, std::pair<double, double>>& pExecutionRates);    // Stub versus subtasks executed and execution time (in secs)
+    void SeedExecutionRates(const std::map<pmExecutionStub*, std::pair<double, double>>& pExecutionRates);
+
     uint GetStealAttempts(pmExecutionStub* pStub);
     uint GetSuccessfulStealAttempts(pmExecutionStub* pStub);
     uint GetFailedStealAttempts(pmExecutionStub* pStub);
     uint GetFailedStealAttemptsSinceLastSuccessfulAttempt(pmExecutionStub* pStub);
+    double GetMeanStealRoundTripTime(pmExecutionStub* pStub);  // in secs
+    double GetMeanStealRoundTripTime(pmExecutionStub* pStub, const stealTarget* pTarget);  // in secs; falls back to the stub's mean for untimed targets
+    double GetStealTargetWeight(pmExecutionStub* pStub, const stealTarget* pTarget);    // expected subtasks per sec of steal latency; negative if never attempted
     
-    pmStatus RecordStealAttempt(pmExecutionStub* pStub);    
-    void RecordSuccessfulStealAttempt(pmExecutionStub* pStub);
+    pmStatus RecordStealAttempt(pmExecutionStub* pStub, const stealTarget* pTarget);
+    void RecordSuccessfulStealAttempt(pmExecutionStub* pStub, ulong pStolenSubtasks);
     void RecordFailedStealAttempt(pmExecutionStub* pStub);
     
     void RegisterPipelineContinuationAcrossRanges(pmExecutionStub* pStub);
     uint GetPipelineContinuationAcrossRanges(pmExecutionStub* pStub);
     
+    void RecordSubtasksPrefetched(pmExecutionStub* pStub, ulong pSubtaskCount);
+    void RecordPrefetchedSubtasksReleased(pmExecutionStub* pStub, ulong pSubtaskCount);
+    ulong GetSubtasksPrefetched(pmExecutionStub* pStub);
+    ulong GetPrefetchedSubtasksReleased(pmExecutionStub* pStub);
+    void RecordSubscriptionStall(pmExecutionStub* pStub, double pStallTimeInSecs);
+    double GetSubscriptionStallTime(pmExecutionStub* pStub);
+
+#ifdef SUPPORT_LAZY_MEMORY
+    void RecordLazyFault(pmExecutionStub* pStub, double pFaultTimeInSecs);
+#endif
+    
 #ifdef ENABLE_MEM_PROFILING
     void RecordMemReceiveEvent(size_t pMemSize, bool pIsScattered);    // Scattered + General
     void RecordMemTransferEvent(size_t pMemSize, bool pIsScattered);    // Scattered + General
 #endif
 
 private:
+    void RecordStealResponse(stubStats& pStats, ulong pStolenSubtasks);
+
     pmTask* mTask;
 
     #ifdef ENABLE_MEM_PROFILING
@@ -110,6 +166,10 @@ private:
         ulong mScatteredMemTransferEvents;
     #endif
 
+    #ifdef DUMP_REMOTE_DATA_CACHE_STATISTICS
+        pmRemoteDataCacheStatistics mRemoteDataCacheStatistics;   // Snapshot of the (process wide) cache statistics at task creation
+    #endif
+
     std::map<pmExecutionStub*, stubStats, stubSorter> mStats;
     RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
 };
@@ -37,6 +37,7 @@
 #include "pmBase.h"
 #include "pmSignalWait.h"
 #include "pmSafePriorityQueue.h"
+#include "pmIndexedPriorityQueue.h"
 
 #include THREADING_IMPLEMENTATION_HEADER
 
@@ -49,7 +50,7 @@
 namespace pm
 {
 
-template<typename T, typename P>
+template<typename T, typename P, typename Q>
 void* ThreadLoop(void* pThreadData);
 
 /**
@@ -64,7 +65,7 @@ void* ThreadLoop(void* pThreadData);
  * (on pmThread) which all clients are required to implement. The data passed to
  * SwitchThread will be passed back to ThreadSwitchCallback and it's interpretation is client
  * specific. pmThread executes only one command at a time. The subsequent commands wait until
- * the first one returns.
+ * the first one returns. Commands are queued in Q (pmSafePQ or pmIndexedPQ).
 */
 
 namespace thread
@@ -82,7 +83,7 @@ enum internalMessage
 typedef struct pmBasicThreadEvent : public pmNonCopyable
 {
 public:
-    template<typename T, typename P>
+    template<typename T, typename P, typename Q>
     friend class pmPThread;
 
     bool BlocksSecondaryOperations()
@@ -96,6 +97,12 @@ public:
     {
     }
 
+    // Key under which pmIndexedPQ indexes the event (NULL means not indexed)
+    const void* GetIndexKey() const
+    {
+        return NULL;
+    }
+
 private:
     thread::internalMessage msg;
 } pmBasicThreadEvent;
@@ -116,7 +123,7 @@ typedef struct pmBasicBlockableThreadEvent : public pmBasicThreadEvent
 } pmBasicBlockableThreadEvent;
 
 
-template<typename T, typename P = ushort>
+template<typename T, typename P = ushort, typename Q = pmSafePQ<T, P>>
 class pmThread : public pmBase
 {
 	public:
@@ -131,32 +138,33 @@ class pmThread : public pmBase
 		virtual void SetProcessorAffinity(int pProcesorId) = 0;
 		
         virtual void WaitForQueuedCommands() = 0;
-        virtual void WaitIfCurrentCommandMatches(typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, void* pMatchCriterion) = 0;
+        virtual void WaitIfCurrentCommandMatches(typename Q::matchFuncPtr pMatchFunc, void* pMatchCriterion) = 0;
 
         void UnblockSecondaryCommands();
         void BlockSecondaryCommands();
     
         void CallWhenSecondaryCommandsUnblocked(const std::function<void ()>& pFunc);
 
-        pmStatus DeleteAndGetFirstMatchingCommand(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pCommand, bool pTemporarilyUnblockSecondaryCommands = false);
-        void DeleteAndGetAllMatchingCommands(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pCommands, bool pTemporarilyUnblockSecondaryCommands = false);
-        void DeleteMatchingCommands(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion);
-        bool HasMatchingCommand(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion);
+        /* pIndexKey (if not NULL) restricts matching to commands whose GetIndexKey returns it. Only pmIndexedPQ uses it. */
+        pmStatus DeleteAndGetFirstMatchingCommand(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pCommand, bool pTemporarilyUnblockSecondaryCommands = false, const void* pIndexKey = NULL);
+        void DeleteAndGetAllMatchingCommands(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pCommands, bool pTemporarilyUnblockSecondaryCommands = false, const void* pIndexKey = NULL);
+        void DeleteMatchingCommands(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey = NULL);
+        bool HasMatchingCommand(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey = NULL);
     
 		/* To be implemented by client */
         virtual void ThreadSwitchCallback(std::shared_ptr<T>& pCommand) = 0;
     
-		pmSafePQ<T, P>& GetPriorityQueue() {return this->mSafePQ;}
+		Q& GetPriorityQueue() {return this->mSafePQ;}
 
 	protected:
-		pmSafePQ<T, P> mSafePQ;
+		Q mSafePQ;
 
 	private:
 		virtual void TerminateThread() = 0;
 };
 
-template<typename T, typename P = ushort>
-class pmPThread : public pmThread<T, P>
+template<typename T, typename P = ushort, typename Q = pmSafePQ<T, P>>
+class pmPThread : public pmThread<T, P, Q>
 {
 	public:
 		pmPThread();
@@ -171,9 +179,9 @@ class pmPThread : public pmThread<T, P>
 
         virtual void InterruptThread();
         virtual void WaitForQueuedCommands();
-        virtual void WaitIfCurrentCommandMatches(typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, void* pMatchCriterion);
+        virtual void WaitIfCurrentCommandMatches(typename Q::matchFuncPtr pMatchFunc, void* pMatchCriterion);
     
-        friend void* ThreadLoop<T, P>(void* pThreadData);
+        friend void* ThreadLoop<T, P, Q>(void* pThreadData);
 
 	private:
         virtual void SubmitCommand(const std::shared_ptr<T>& pCommand, P pPriority);
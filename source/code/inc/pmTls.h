@@ -50,6 +50,7 @@ typedef enum pmTlsKey
     TLS_CURRENT_SUBTASK_ID,
     TLS_SPLIT_ID,
     TLS_SPLIT_COUNT,
+    TLS_TRACE_BUFFER,
     TLS_MAX_KEYS
 } pmTlsKey;
     
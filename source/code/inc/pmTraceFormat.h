@@ -0,0 +1,137 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_TRACE_FORMAT__
+#define __PM_TRACE_FORMAT__
+
+#include <stdint.h>
+
+/* On-disk layout of the per host binary trace files written by pmTracer. This header has no other pmlib dependency
+ * so that offline tools (like the pmlib analyzer) can include it directly.
+ *
+ * A trace file is a fileHeader followed by any number of blocks. Every block starts with a blockHeader whose count
+ * is the number of entries that follow. Event names and thread entries always precede the first record that uses them.
+ *
+ *  EVENT_NAMES_BLOCK       count x { uint16_t eventId; uint16_t nameLength; char name[nameLength]; }
+ *  THREADS_BLOCK           count x threadEntry
+ *  RECORDS_BLOCK           count x eventRecord
+ *  DROPPED_RECORDS_BLOCK   count x droppedEntry (written once, at the end of the trace)
+ */
+
+namespace pm
+{
+
+namespace traceFormat
+{
+    const char TRACE_FILE_MAGIC[8] = {'P', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+    const uint32_t TRACE_FILE_VERSION = 1;
+    const int32_t NO_TRACE_DEVICE = -1;
+
+    enum blockType
+    {
+        EVENT_NAMES_BLOCK = 1,
+        THREADS_BLOCK,
+        RECORDS_BLOCK,
+        DROPPED_RECORDS_BLOCK
+    };
+
+    enum eventPhase
+    {
+        PHASE_BEGIN,
+        PHASE_END,
+        PHASE_INSTANT
+    };
+
+    /* Timestamps are CLOCK_MONOTONIC nanoseconds. The header pairs a monotonic reading with the wall clock reading taken
+     * at the same instant (just after the first global barrier) for aligning traces of different hosts. */
+    struct fileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t hostId;
+        uint32_t hostCount;
+        uint32_t recordSize;
+        uint64_t monotonicBaseNs;
+        uint64_t realtimeBaseNs;
+    };
+
+    struct blockHeader
+    {
+        uint32_t type;
+        uint32_t count;
+    };
+
+    struct threadEntry
+    {
+        uint32_t threadIndex;
+        int32_t deviceIndex;    // Global device index for execution stub threads, NO_TRACE_DEVICE for others
+    };
+
+    struct eventRecord
+    {
+        uint64_t timestamp;
+        uint16_t eventId;
+        uint8_t phase;
+        uint8_t reserved;
+        uint32_t threadIndex;
+        uint64_t arg1;
+        uint64_t arg2;
+    };
+
+    struct droppedEntry
+    {
+        uint32_t threadIndex;
+        uint32_t reserved;
+        uint64_t count;
+    };
+
+    /* Tasks are identified in records by their originating host and sequence number packed in one argument */
+    inline uint64_t PackTaskKey(uint32_t pOriginatingHost, uint64_t pSequenceNumber)
+    {
+        return ((uint64_t)pOriginatingHost << 48) | (pSequenceNumber & 0xFFFFFFFFFFFFULL);
+    }
+    
+    inline uint32_t GetTaskKeyHost(uint64_t pTaskKey)
+    {
+        return (uint32_t)(pTaskKey >> 48);
+    }
+
+    inline uint64_t GetTaskKeySequenceNumber(uint64_t pTaskKey)
+    {
+        return (pTaskKey & 0xFFFFFFFFFFFFULL);
+    }
+}
+
+} // end namespace pm
+
+#endif
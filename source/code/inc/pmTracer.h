@@ -0,0 +1,247 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#ifndef __PM_TRACER__
+#define __PM_TRACER__
+
+#include "pmBase.h"
+#include "pmThread.h"
+#include "pmSignalWait.h"
+#include "pmResourceLock.h"
+#include "pmTls.h"
+#include "pmTraceFormat.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <time.h>
+
+namespace pm
+{
+
+class pmTask;
+
+namespace tracer
+{
+    /* Predefined events; ids beyond MAX_TRACE_EVENTS are handed out by pmTracer::InternEvent */
+    enum traceEventType
+    {
+        SUBTASK_EXECUTION,      // arg1: task key, arg2: subtask id
+        SUBTASK_REDUCTION,      // arg1: task key, arg2: subtask id
+        WAIT_ON_NETWORK,        // arg1: task key, arg2: subtask id
+        STEAL_REQUEST,          // arg1: task key, arg2: target host
+        STEAL_SUCCESS_RESPONSE, // arg1: task key, arg2: subtasks stolen
+        STEAL_FAILURE_RESPONSE, // arg1: task key, arg2: stealing host
+        MEMORY_SEND,            // arg1: destination host, arg2: bytes
+        MEMORY_RECEIVE,         // arg1: task key (0 if not task originated), arg2: bytes
+        CLOCK_SYNCHRONIZATION,  // Emitted on every host just after the first global barrier
+        MAX_TRACE_EVENTS
+    };
+
+    enum traceFlushEventIdentifier
+    {
+        FLUSH_TRACE,
+        MAX_TRACE_FLUSH_EVENTS
+    };
+
+    struct traceFlushEvent : public pmBasicThreadEvent
+    {
+        traceFlushEventIdentifier eventId;
+
+        traceFlushEvent(traceFlushEventIdentifier pEventId = MAX_TRACE_FLUSH_EVENTS)
+        : eventId(pEventId)
+        {}
+    };
+}
+
+/* Fixed size ring of trace records with one producer (the owning thread) and one consumer (the flush thread) */
+class pmTraceBuffer
+{
+public:
+    pmTraceBuffer(uint pThreadIndex, int pDeviceIndex);
+
+    inline void Push(ushort pEventId, traceFormat::eventPhase pPhase, ulong pArg1, ulong pArg2)
+    {
+        ulong lHead = mHead.load(std::memory_order_relaxed);
+        if(lHead - mTail.load(std::memory_order_acquire) >= TRACE_BUFFER_RECORDS)
+        {
+            mDroppedRecords.store(mDroppedRecords.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        struct timespec lTime;
+        clock_gettime(CLOCK_MONOTONIC, &lTime);
+
+        traceFormat::eventRecord& lRecord = mRecords[lHead & (TRACE_BUFFER_RECORDS - 1)];
+        lRecord.timestamp = (ulong)lTime.tv_sec * 1000000000 + (ulong)lTime.tv_nsec;
+        lRecord.eventId = pEventId;
+        lRecord.phase = (uint8_t)pPhase;
+        lRecord.reserved = 0;
+        lRecord.threadIndex = mThreadIndex;
+        lRecord.arg1 = pArg1;
+        lRecord.arg2 = pArg2;
+
+        mHead.store(lHead + 1, std::memory_order_release);
+    }
+
+    uint GetThreadIndex() const;
+    int GetDeviceIndex() const;
+    ulong GetDroppedRecords() const;
+
+    ulong Drain(FILE* pFile);   // Called only by the consumer; returns the number of records written
+
+private:
+    uint mThreadIndex;
+    int mDeviceIndex;
+    std::vector<traceFormat::eventRecord> mRecords;
+    std::atomic<ulong> mHead;
+    std::atomic<ulong> mTail;
+    std::atomic<ulong> mDroppedRecords;
+};
+
+/* Always compiled in, runtime switchable tracer. Every thread records into its own ring (found through TLS) without any
+ * locking; a dedicated thread periodically drains the rings into a per host binary file (see pmTraceFormat.h). */
+class pmTracer : public THREADING_IMPLEMENTATION_CLASS<tracer::traceFlushEvent>
+{
+public:
+    static pmTracer* GetTracer();
+    virtual ~pmTracer();
+
+    static inline bool IsEnabled()
+    {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    inline void Record(ushort pEventId, traceFormat::eventPhase pPhase, ulong pArg1 = 0, ulong pArg2 = 0)
+    {
+        pmTraceBuffer* lBuffer = static_cast<pmTraceBuffer*>(TLS_IMPLEMENTATION_CLASS::GetTls()->GetThreadLocalStorage(TLS_TRACE_BUFFER));
+        if(!lBuffer)
+            lBuffer = CreateThreadBuffer();
+        
+        lBuffer->Push(pEventId, pPhase, pArg1, pArg2);
+    }
+
+    static inline void RecordInstant(tracer::traceEventType pEventId, ulong pArg1, ulong pArg2)
+    {
+        if(IsEnabled())
+            GetTracer()->Record(pEventId, traceFormat::PHASE_INSTANT, pArg1, pArg2);
+    }
+
+    static inline void RecordInstant(tracer::traceEventType pEventId, const pmTask* pTask, ulong pArg2)
+    {
+        if(IsEnabled())
+            GetTracer()->Record(pEventId, traceFormat::PHASE_INSTANT, GetTaskKey(pTask), pArg2);
+    }
+
+    ushort InternEvent(const char* pName);
+    
+    static ulong GetTaskKey(const pmTask* pTask);
+
+    void SetEnabled(bool pEnable);
+    void SynchronizeClock();
+    void Finalize();
+
+private:
+    pmTracer();
+
+    virtual void ThreadSwitchCallback(std::shared_ptr<tracer::traceFlushEvent>& pEvent);
+
+    pmTraceBuffer* CreateThreadBuffer();
+    void StartFlushing();
+    void Flush();
+
+    static std::atomic<bool> sEnabled;
+
+    std::vector<std::string> mEventNames;
+    std::map<std::string, ushort> mInternedEvents;
+    std::vector<std::unique_ptr<pmTraceBuffer>> mBuffers;
+
+    FILE* mFile;
+    size_t mWrittenEventNames;
+    size_t mWrittenThreads;
+    ulong mMonotonicBaseNs;
+    ulong mRealtimeBaseNs;
+    bool mClockSynchronized;
+    bool mFlushing;
+    bool mFinalized;
+
+    SIGNAL_WAIT_IMPLEMENTATION_CLASS mSignalWait;
+    RESOURCE_LOCK_IMPLEMENTATION_CLASS mResourceLock;
+};
+
+/* Records begin/end records of an event around a scope, provided tracing was enabled when the scope was entered */
+class pmTraceScope
+{
+public:
+    pmTraceScope(tracer::traceEventType pEventId, ulong pArg1 = 0, ulong pArg2 = 0)
+    : mEventId(pEventId)
+    , mArg1(pArg1)
+    , mArg2(pArg2)
+    , mTracing(pmTracer::IsEnabled())
+    {
+        if(mTracing)
+            pmTracer::GetTracer()->Record(mEventId, traceFormat::PHASE_BEGIN, mArg1, mArg2);
+    }
+
+    pmTraceScope(tracer::traceEventType pEventId, const pmTask* pTask, ulong pArg2)
+    : mEventId(pEventId)
+    , mArg1(0)
+    , mArg2(pArg2)
+    , mTracing(pmTracer::IsEnabled())
+    {
+        if(mTracing)
+        {
+            mArg1 = pmTracer::GetTaskKey(pTask);
+            pmTracer::GetTracer()->Record(mEventId, traceFormat::PHASE_BEGIN, mArg1, mArg2);
+        }
+    }
+    
+    ~pmTraceScope()
+    {
+        if(mTracing)
+            pmTracer::GetTracer()->Record(mEventId, traceFormat::PHASE_END, mArg1, mArg2);
+    }
+
+private:
+    tracer::traceEventType mEventId;
+    ulong mArg1;
+    ulong mArg2;
+    bool mTracing;
+};
+
+} // end namespace pm
+
+#endif
@@ -41,11 +41,41 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <string.h>
 
 namespace pm
 {
 
 class pmMachine;
+
+namespace sentinelCompression
+{
+    /* A sentinel compressed buffer is a bufferHeader followed by frameCount frames. Every frame covers elemCount
+     * elements of the uncompressed data starting at firstElem and is laid out as a frameHeader, runCount run
+     * descriptors and the non-sentinel elements of all runs in order. frameLength (in bytes, including the header
+     * and padding to an eight byte boundary) is the distance to the next frame. */
+    struct bufferHeader
+    {
+        ulong uncompressedCount;
+        ulong frameCount;
+    };
+
+    struct frameHeader
+    {
+        ulong firstElem;
+        ulong elemCount;
+        ulong runCount;
+        ulong frameLength;
+    };
+
+    struct run
+    {
+        ulong offset;   // relative to firstElem of the frame
+        ulong count;
+    };
+}
     
 class pmUtility : public pmBase
 {
@@ -53,6 +83,23 @@ class pmUtility : public pmBase
     typedef std::map<std::string, std::pair<size_t, std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>>> pendingResponsesMapType;
     typedef std::map<ulong, std::pair<size_t, std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>>> multiFileOperationsMapType;
 
+    /* A file exposed as a read only address space. The descriptor is closed when the last reader lets go of it. */
+    typedef struct fileBackedAddressSpace
+    {
+        fileBackedAddressSpace(const char* pPath);
+        ~fileBackedAddressSpace();
+
+        std::string mPath;
+        int mDescriptor;
+        size_t mLength;
+        ulong mLastOffset;      // Last range read (used to predict the next one)
+        ulong mLastLength;
+        long mStride;
+        ulong mReadaheadEnd;    // End of the ranges already advised for readahead
+    } fileBackedAddressSpace;
+
+    typedef std::map<std::pair<uint, ulong>, std::shared_ptr<fileBackedAddressSpace>> fileBackedAddressSpacesMapType;  // Owner host and generation number versus file
+
 public:
     static void MapFileOnAllMachines(const char* pPath);
     static void UnmapFileOnAllMachines(const char* pPath);
@@ -75,6 +122,15 @@ public:
     static void RegisterMultiFileMappingResponse(ulong pMultiFileOperationsId);
     static void RegisterMultiFileUnmappingResponse(ulong pMultiFileOperationsId);
 
+    static size_t OpenFileBackedAddressSpaceOnAllMachines(const char* pPath, ulong pGenerationNumber);
+    static void CloseFileBackedAddressSpaceOnAllMachines(ulong pGenerationNumber);
+
+    static size_t OpenFileBackedAddressSpace(const char* pPath, uint pOwnerHost, ulong pGenerationNumber);
+    static void CloseFileBackedAddressSpace(uint pOwnerHost, ulong pGenerationNumber);
+    static bool IsFileBackedAddressSpace(uint pOwnerHost, ulong pGenerationNumber);
+    static int GetFileBackedAddressSpaceDescriptor(uint pOwnerHost, ulong pGenerationNumber);
+    static bool ReadFileBackedAddressSpace(uint pOwnerHost, ulong pGenerationNumber, void* pAddressSpaceBaseAddr, ulong pOffset, ulong pLength);
+
     static void* OpenLibrary(char* pPath);
     static pmStatus CloseLibrary(void* pLibHandle);
     static void* GetExportedSymbol(void* pLibHandle, const char* pSymbol);
@@ -86,107 +142,174 @@ public:
     static bool IsLazy(pmMemType pMemType);
     static bool IsLazyWriteOnly(pmMemType pMemType);
     static bool IsLazyReadWrite(pmMemType pMemType);
+    static pmMemType GetEagerMemType(pmMemType pMemType);   // Non lazy counterpart of a memory type
 
+    /* Network sentinel compression. The data is compressed in independent frames of SENTINEL_COMPRESSION_CHUNK_SIZE bytes
+     * each (see namespace sentinelCompression), which are built and decoded in parallel. Returns an empty pointer if
+     * compression does not reduce the length. The compressed buffer is sent as a single message and the receiver decodes
+     * it only after all of it has arrived; frames are the unit of parallelism, not of transfer. */
     template<typename T>
-    static std::shared_ptr<T> CompressForSentinel(const T* pMem, T pSentinel, ulong pCount, ulong& pCompressedLength)
+    static std::shared_ptr<char> CompressForSentinel(const T* pMem, T pSentinel, ulong pCount, ulong& pCompressedLength)
     {
-    #ifdef USE_OMP_FOR_REDUCTION
-        std::vector<ulong> lSentinelLocationsVector;
-        lSentinelLocationsVector.reserve(pCount/2);
-    #endif
+        return CompressForSentinelInternal(reinterpret_cast<const char*>(pMem), sizeof(T), pCount, pCompressedLength, [pSentinel] (const char* pElem)
+        {
+            return (*reinterpret_cast<const T*>(pElem) == pSentinel);
+        });
+    }
 
-        std::shared_ptr<T> lMemPtr(new T[pCount]);
-        T* lMem = lMemPtr.get();
+    /* Variant of the above for elements of arbitrary size, with an all zero element as the sentinel */
+    static std::shared_ptr<char> CompressForSentinel(const void* pMem, size_t pElemSize, ulong pCount, ulong& pCompressedLength);
+    static bool IsZeroElement(const void* pElem, size_t pElemSize);
 
-        bool lOngoingSentinels = false;
-        uint lIndex = 0;
+    /* Writes the uncompressed data (with all zero sentinels) of a buffer generated by CompressForSentinel */
+    static void DecompressForSentinel(const void* pCompressedMem, ulong pCompressedLength, size_t pElemSize, void* pMem);
 
-    #ifdef USE_OMP_FOR_REDUCTION
-         if(pMem[0] != pSentinel)
+    /* Locates the frames of a sentinel compressed buffer. Frames are independent of each other and may be decoded in any order. */
+    static void GetSentinelCompressedFrames(const void* pCompressedMem, ulong pCompressedLength, std::vector<const sentinelCompression::frameHeader*>& pFrames);
+
+    /* Calls pFunction(pElemIndex, pRunData, pRunElems) for every run of non-sentinel elements in the frame;
+     * pElemIndex is the index of the run's first element in the uncompressed data */
+    template<typename runFunction>
+    static void ForEachSentinelCompressedRun(const sentinelCompression::frameHeader* pFrame, size_t pElemSize, runFunction pFunction)
+    {
+        const sentinelCompression::run* lRuns = reinterpret_cast<const sentinelCompression::run*>(pFrame + 1);
+        const char* lData = reinterpret_cast<const char*>(lRuns + pFrame->runCount);
+
+        for(ulong i = 0; i < pFrame->runCount; ++i)
         {
-            lSentinelLocationsVector.emplace_back(0);
-            lSentinelLocationsVector.emplace_back(0);
+            pFunction(pFrame->firstElem + lRuns[i].offset, lData, lRuns[i].count);
+            lData += lRuns[i].count * pElemSize;
         }
+    }
 
-        for(uint i = 0; i < pCount; ++i)
+private:
+    template<typename sentinelFunction>
+    static std::shared_ptr<char> CompressForSentinelInternal(const char* pMem, size_t pElemSize, ulong pCount, ulong& pCompressedLength, sentinelFunction pIsSentinel)
+    {
+        using namespace sentinelCompression;
+
+        if(!pCount)
+            return std::shared_ptr<char>();
+
+        ulong lChunkElems = std::max<ulong>(1, SENTINEL_COMPRESSION_CHUNK_SIZE / pElemSize);
+        ulong lFrameCount = (pCount + lChunkElems - 1) / lChunkElems;
+
+        std::vector<ulong> lFrameRuns(lFrameCount, 0);
+        std::vector<ulong> lFrameElems(lFrameCount, 0);
+
+        // First pass counts the runs and non-sentinel elements of every frame
+    #ifdef USE_OMP_FOR_REDUCTION
+        #pragma omp parallel for
+    #endif
+        for(ulong lFrame = 0; lFrame < lFrameCount; ++lFrame)
         {
-            if(pMem[i] == pSentinel)
-            {
-                lOngoingSentinels = true;
-            }
-            else
+            ulong lFirstElem = lFrame * lChunkElems;
+            ulong lLastElem = std::min(pCount, lFirstElem + lChunkElems);
+            
+            ulong lRuns = 0, lElems = 0;
+            bool lOngoingRun = false;
+
+            for(ulong i = lFirstElem; i < lLastElem; ++i)
             {
-                if(lOngoingSentinels)
+                if(pIsSentinel(pMem + i * pElemSize))
+                {
+                    lOngoingRun = false;
+                }
+                else
                 {
-                    lSentinelLocationsVector.emplace_back(lIndex);
-                    lSentinelLocationsVector.emplace_back(i);
-                    
-                    lOngoingSentinels = false;
+                    if(!lOngoingRun)
+                        ++lRuns;
+
+                    ++lElems;
+                    lOngoingRun = true;
                 }
-                
-                lMem[lIndex++] = pMem[i];
             }
+            
+            lFrameRuns[lFrame] = lRuns;
+            lFrameElems[lFrame] = lElems;
         }
-    #else
-        for(uint i = 0; i < pCount; ++i)
+
+        std::vector<ulong> lFrameOffsets(lFrameCount + 1);
+        lFrameOffsets[0] = sizeof(bufferHeader);
+
+        for(ulong lFrame = 0; lFrame < lFrameCount; ++lFrame)
+            lFrameOffsets[lFrame + 1] = lFrameOffsets[lFrame] + GetSentinelCompressedFrameLength(lFrameRuns[lFrame], lFrameElems[lFrame], pElemSize);
+        
+        // The length is kept a multiple of the element size as the data is transferred in units of elements
+        ulong lCompressedLength = ((lFrameOffsets[lFrameCount] + pElemSize - 1) / pElemSize) * pElemSize;
+        if(lCompressedLength >= pCount * pElemSize)
+            return std::shared_ptr<char>();
+        
+        std::shared_ptr<char> lMemPtr(new char[lCompressedLength], std::default_delete<char[]>());
+        char* lMem = lMemPtr.get();
+        
+        bufferHeader* lBufferHeader = reinterpret_cast<bufferHeader*>(lMem);
+        lBufferHeader->uncompressedCount = pCount;
+        lBufferHeader->frameCount = lFrameCount;
+        
+        memset(lMem + lFrameOffsets[lFrameCount], 0, lCompressedLength - lFrameOffsets[lFrameCount]);
+
+        // Second pass writes every frame at its offset
+    #ifdef USE_OMP_FOR_REDUCTION
+        #pragma omp parallel for
+    #endif
+        for(ulong lFrame = 0; lFrame < lFrameCount; ++lFrame)
         {
-            if(pMem[i] == pSentinel)
-            {
-                lOngoingSentinels = true;
-            }
-            else
+            ulong lFirstElem = lFrame * lChunkElems;
+            ulong lLastElem = std::min(pCount, lFirstElem + lChunkElems);
+
+            frameHeader* lFrameHeader = reinterpret_cast<frameHeader*>(lMem + lFrameOffsets[lFrame]);
+            lFrameHeader->firstElem = lFirstElem;
+            lFrameHeader->elemCount = lLastElem - lFirstElem;
+            lFrameHeader->runCount = lFrameRuns[lFrame];
+            lFrameHeader->frameLength = lFrameOffsets[lFrame + 1] - lFrameOffsets[lFrame];
+            
+            run* lRuns = reinterpret_cast<run*>(lFrameHeader + 1);
+            char* lData = reinterpret_cast<char*>(lRuns + lFrameRuns[lFrame]);
+            char* lFrameEnd = lMem + lFrameOffsets[lFrame + 1];
+
+            ulong i = lFirstElem;
+            while(i < lLastElem)
             {
-                if(lOngoingSentinels)
+                if(pIsSentinel(pMem + i * pElemSize))
                 {
-                    if(lIndex + 1 >= pCount)
-                        return std::shared_ptr<T>();
-
-                    lMem[lIndex++] = pSentinel;
-                    *((uint*)(&lMem[lIndex])) = i;
-                    
-                    ++lIndex;
-                    
-                    lOngoingSentinels = false;
+                    ++i;
+                    continue;
                 }
-                
-                if(lIndex >= pCount)
-                    return std::shared_ptr<T>();
 
-                lMem[lIndex++] = pMem[i];
+                ulong lRunEnd = i + 1;
+                while(lRunEnd < lLastElem && !pIsSentinel(pMem + lRunEnd * pElemSize))
+                    ++lRunEnd;
+
+                lRuns->offset = i - lFirstElem;
+                lRuns->count = lRunEnd - i;
+                ++lRuns;
+
+                memcpy(lData, pMem + i * pElemSize, (lRunEnd - i) * pElemSize);
+                lData += (lRunEnd - i) * pElemSize;
+
+                i = lRunEnd;
             }
+            
+            memset(lData, 0, lFrameEnd - lData);
         }
-    #endif
 
-    #ifdef USE_OMP_FOR_REDUCTION
-        uint lFirstSentinelLoc = lIndex;
-        if(lIndex + 1 + lSentinelLocationsVector.size() >= pCount)
-            return std::shared_ptr<T>();
-        
-        for_each(lSentinelLocationsVector, [&] (uint pLocation)
-        {
-            *((uint*)(&lMem[lIndex])) = pLocation;
-            ++lIndex;
-        });
-        
-        *((uint*)(&lMem[lIndex])) = lFirstSentinelLoc;
-        ++lIndex;
-    #endif
-
-        pCompressedLength = lIndex * sizeof(T);
+        pCompressedLength = lCompressedLength;
 
     #ifdef DUMP_DATA_COMPRESSION_STATISTICS
-        pmCompressionDataRecorder::RecordCompressionData(pCount * sizeof(T), pCompressedLength, true);
+        pmCompressionDataRecorder::RecordCompressionData(pCount * pElemSize, pCompressedLength, true);
     #endif
         
         return lMemPtr;
     }
 
-private:
+    static ulong GetSentinelCompressedFrameLength(ulong pRuns, ulong pElems, size_t pElemSize);
     static ulong& GetMultiFileOperationsId();
     static multiFileOperationsMapType& GetMultiFileOperationsMap();
     static pendingResponsesMapType& GetFileMappingPendingResponsesMap();
     static pendingResponsesMapType& GetFileUnmappingPendingResponsesMap();
     static fileMappingsMapType& GetFileMappingsMap();
+    static fileBackedAddressSpacesMapType& GetFileBackedAddressSpacesMap();
     static RESOURCE_LOCK_IMPLEMENTATION_CLASS& GetResourceLock();
 };
 
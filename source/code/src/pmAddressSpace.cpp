@@ -42,6 +42,7 @@
 #include "pmStubManager.h"
 #include "pmUtility.h"
 #include "pmHardware.h"
+#include "pmRemoteDataCache.h"
 
 #if defined(ENABLE_MEM_PROFILING) || defined(DUMP_DATA_TRANSFER_FREQUENCY)
 #include "pmLogger.h"
@@ -72,7 +73,7 @@ void FetchCallback(const pmCommandPtr& pCommand)
 
 
 /* class pmAddressSpace */
-pmAddressSpace::pmAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner)
+pmAddressSpace::pmAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy)
     : mOwner(pOwner?pOwner:PM_LOCAL_MACHINE)
     , mGenerationNumberOnOwner(pGenerationNumberOnOwner)
     , mUserMemHandle(NULL)
@@ -81,17 +82,23 @@ pmAddressSpace::pmAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pG
     , mRequestedRows(std::numeric_limits<size_t>::max())
     , mRequestedCols(std::numeric_limits<size_t>::max())
     , mVMPageCount(0)
+    , mAllocationPolicy(pAllocationPolicy)
     , mAddressSpaceType(ADDRESS_SPACE_LINEAR)
     , mLazy(false)
+    , mFileBacked(false)
     , mMem(NULL)
     , mReadOnlyLazyMapping(NULL)
     , mWaitingTasksLock __LOCK_NAME__("pmAddressSpace::mWaitingTasksLock")
     , mWaitingForOwnershipChange(false)
     , mOwnershipTransferLock __LOCK_NAME__("pmAddressSpace::mOwnershipTransferLock")
-    , mLockingTask(NULL)
+    , mDataGeneration(0)
+    , mWriterDataGeneration(0)
+    , mLockingMemType(MAX_MEM_TYPE)
+    , mLockEpoch(0)
     , mTaskLock __LOCK_NAME__("pmAddressSpace::mTaskLock")
     , mUserDelete(false)
     , mDeleteLock __LOCK_NAME__("pmAddressSpace::mDeleteLock")
+    , mPlacedPagesLock __LOCK_NAME__("pmAddressSpace::mPlacedPagesLock")
 #ifdef ENABLE_MEM_PROFILING
     , mMemReceived(0)
     , mMemTransferred(0)
@@ -103,7 +110,7 @@ pmAddressSpace::pmAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pG
     Init();
 }
     
-pmAddressSpace::pmAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner)
+pmAddressSpace::pmAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy)
     : mOwner(pOwner?pOwner:PM_LOCAL_MACHINE)
     , mGenerationNumberOnOwner(pGenerationNumberOnOwner)
     , mUserMemHandle(NULL)
@@ -112,17 +119,23 @@ pmAddressSpace::pmAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwn
     , mRequestedRows(pRows)
     , mRequestedCols(pCols)
     , mVMPageCount(0)
+    , mAllocationPolicy(pAllocationPolicy)
     , mAddressSpaceType(ADDRESS_SPACE_2D)
     , mLazy(false)
+    , mFileBacked(false)
     , mMem(NULL)
     , mReadOnlyLazyMapping(NULL)
     , mWaitingTasksLock __LOCK_NAME__("pmAddressSpace::mWaitingTasksLock")
     , mWaitingForOwnershipChange(false)
     , mOwnershipTransferLock __LOCK_NAME__("pmAddressSpace::mOwnershipTransferLock")
-    , mLockingTask(NULL)
+    , mDataGeneration(0)
+    , mWriterDataGeneration(0)
+    , mLockingMemType(MAX_MEM_TYPE)
+    , mLockEpoch(0)
     , mTaskLock __LOCK_NAME__("pmAddressSpace::mTaskLock")
     , mUserDelete(false)
     , mDeleteLock __LOCK_NAME__("pmAddressSpace::mDeleteLock")
+    , mPlacedPagesLock __LOCK_NAME__("pmAddressSpace::mPlacedPagesLock")
 #ifdef ENABLE_MEM_PROFILING
     , mMemReceived(0)
     , mMemTransferred(0)
@@ -138,6 +151,9 @@ void pmAddressSpace::Init()
 {
     EXCEPTION_ASSERT(mGenerationNumberOnOwner != 0);
 
+    mFileBacked = pmUtility::IsFileBackedAddressSpace(*mOwner, mGenerationNumberOnOwner);
+    EXCEPTION_ASSERT(!mFileBacked || mAddressSpaceType == ADDRESS_SPACE_LINEAR);
+
 	mMem = MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->AllocateMemory(this, mAllocatedLength, mVMPageCount);
 
     // Auto lock/unlock scope
@@ -203,7 +219,7 @@ pmAddressSpace::~pmAddressSpace()
     {
         FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
 
-        DEBUG_EXCEPTION_ASSERT(!mLockingTask);
+        DEBUG_EXCEPTION_ASSERT(mLockingTasks.empty());
 
     #ifdef SUPPORT_LAZY_MEMORY
         if(mReadOnlyLazyMapping)
@@ -220,15 +236,23 @@ pmAddressSpace::~pmAddressSpace()
     #endif
     }
     
+    pmRemoteDataCache::GetRemoteDataCache()->Invalidate(communicator::memoryIdentifierStruct(*mOwner, mGenerationNumberOnOwner));
+
     DisposeMemory();
+
+    if(mFileBacked && mOwner == PM_LOCAL_MACHINE)
+        pmUtility::CloseFileBackedAddressSpaceOnAllMachines(mGenerationNumberOnOwner);
 }
     
-std::vector<uint> pmAddressSpace::GetMachinesForDistribution(bool pRandomize)
+// pTask must hold a lock on the address space
+std::vector<uint> pmAddressSpace::GetMachinesForDistribution(pmTask* pTask, bool pRandomize)
 {
+    DEBUG_EXCEPTION_ASSERT(IsLockedBy(pTask));
+
     std::map<uint, const pmMachine*> lMachinesMap;
     std::vector<uint> lMachinesVector;
 
-    std::set<const pmMachine*> lMachinesSet = (dynamic_cast<pmLocalTask*>(mLockingTask) ? ((pmLocalTask*)mLockingTask)->GetAssignedMachines() : ((pmRemoteTask*)mLockingTask)->GetAssignedMachines());
+    std::set<const pmMachine*> lMachinesSet = (dynamic_cast<pmLocalTask*>(pTask) ? ((pmLocalTask*)pTask)->GetAssignedMachines() : ((pmRemoteTask*)pTask)->GetAssignedMachines());
 
     lMachinesSet.emplace(mOwner);
     
@@ -259,30 +283,49 @@ std::vector<uint> pmAddressSpace::GetMachinesForDistribution(bool pRandomize)
     return lMachinesVector;
 }
     
-pmAddressSpace* pmAddressSpace::CreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner /* = GetNextGenerationNumber() */)
+pmAddressSpace* pmAddressSpace::CreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner /* = GetNextGenerationNumber() */, const pmMemAllocationPolicy& pAllocationPolicy /* = pmMemAllocationPolicy() */)
+{
+    return new pmAddressSpace(pLength, pOwner, pGenerationNumberOnOwner, pAllocationPolicy);
+}
+
+pmAddressSpace* pmAddressSpace::CreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner /* = GetNextGenerationNumber() */, const pmMemAllocationPolicy& pAllocationPolicy /* = pmMemAllocationPolicy() */)
+{
+    return new pmAddressSpace(pRows, pCols, pOwner, pGenerationNumberOnOwner, pAllocationPolicy);
+}
+
+pmAddressSpace* pmAddressSpace::CreateAddressSpace(size_t pLength, const pmMachine* pOwner, const pmMemAllocationPolicy& pAllocationPolicy)
+{
+    return new pmAddressSpace(pLength, pOwner, GetNextGenerationNumber(), pAllocationPolicy);
+}
+
+pmAddressSpace* pmAddressSpace::CreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, const pmMemAllocationPolicy& pAllocationPolicy)
 {
-    return new pmAddressSpace(pLength, pOwner, pGenerationNumberOnOwner);
+    return new pmAddressSpace(pRows, pCols, pOwner, GetNextGenerationNumber(), pAllocationPolicy);
 }
 
-pmAddressSpace* pmAddressSpace::CreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner /* = GetNextGenerationNumber() */)
+/* The file is opened on all machines before the address space is created, so that every copy of the address space knows it is file backed */
+pmAddressSpace* pmAddressSpace::CreateFileBackedAddressSpace(const char* pPath)
 {
-    return new pmAddressSpace(pRows, pCols, pOwner, pGenerationNumberOnOwner);
+    ulong lGenerationNumber = GetNextGenerationNumber();
+    size_t lLength = pmUtility::OpenFileBackedAddressSpaceOnAllMachines(pPath, lGenerationNumber);
+
+    return new pmAddressSpace(lLength, PM_LOCAL_MACHINE, lGenerationNumber, pmMemAllocationPolicy());
 }
 
-pmAddressSpace* pmAddressSpace::CheckAndCreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner)
+pmAddressSpace* pmAddressSpace::CheckAndCreateAddressSpace(size_t pLength, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy /* = pmMemAllocationPolicy() */)
 {
     pmAddressSpace* lAddressSpace = FindAddressSpace(pOwner, pGenerationNumberOnOwner);
     if(!lAddressSpace)
-        lAddressSpace = CreateAddressSpace(pLength, pOwner, pGenerationNumberOnOwner);
+        lAddressSpace = CreateAddressSpace(pLength, pOwner, pGenerationNumberOnOwner, pAllocationPolicy);
 
     return lAddressSpace;
 }
 
-pmAddressSpace* pmAddressSpace::CheckAndCreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner)
+pmAddressSpace* pmAddressSpace::CheckAndCreateAddressSpace(size_t pRows, size_t pCols, const pmMachine* pOwner, ulong pGenerationNumberOnOwner, const pmMemAllocationPolicy& pAllocationPolicy /* = pmMemAllocationPolicy() */)
 {
     pmAddressSpace* lAddressSpace = FindAddressSpace(pOwner, pGenerationNumberOnOwner);
     if(!lAddressSpace)
-        lAddressSpace = CreateAddressSpace(pRows, pCols, pOwner, pGenerationNumberOnOwner);
+        lAddressSpace = CreateAddressSpace(pRows, pCols, pOwner, pGenerationNumberOnOwner, pAllocationPolicy);
 
     return lAddressSpace;
 }
@@ -330,14 +373,7 @@ void pmAddressSpace::UserDelete()
         mUserDelete = true;
     }
     
-    pmTask* lTask = NULL;    
-    // Auto lock/unlock scope
-    {
-        FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
-        lTask = mLockingTask;
-    }
-
-    if(!lTask)
+    if(!IsLocked())
         delete this;
 }
     
@@ -385,11 +421,62 @@ size_t pmAddressSpace::GetLength() const
 	return mRequestedLength;
 }
 
+const pmMemAllocationPolicy& pmAddressSpace::GetAllocationPolicy() const
+{
+    return mAllocationPolicy;
+}
+
+/* Returns the parts of the page range [pFirstPage, pLastPage] not claimed by any earlier call and claims the whole range.
+ * Placement only affects untouched pages, so each page needs to be bound only once. */
+std::vector<std::pair<size_t, size_t>> pmAddressSpace::ClaimUnplacedPages(size_t pFirstPage, size_t pLastPage)
+{
+    std::vector<std::pair<size_t, size_t>> lUnplacedRanges;
+
+    FINALIZE_RESOURCE_PTR(dPlacedPagesLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mPlacedPagesLock, Lock(), Unlock());
+
+    // Start from the claimed range (if any) which overlaps or adjoins pFirstPage
+    auto lIter = mPlacedPages.upper_bound(pFirstPage);
+    if(lIter != mPlacedPages.begin() && std::prev(lIter)->second + 1 >= pFirstPage)
+        --lIter;
+
+    size_t lMergedFirstPage = pFirstPage, lMergedLastPage = pLastPage;
+    size_t lNextUnclaimedPage = pFirstPage;
+
+    while(lIter != mPlacedPages.end() && lIter->first <= pLastPage + 1)
+    {
+        if(lIter->first > lNextUnclaimedPage)
+            lUnplacedRanges.emplace_back(lNextUnclaimedPage, lIter->first - 1);
+
+        lNextUnclaimedPage = std::max(lNextUnclaimedPage, lIter->second + 1);
+        lMergedFirstPage = std::min(lMergedFirstPage, lIter->first);
+        lMergedLastPage = std::max(lMergedLastPage, lIter->second);
+
+        lIter = mPlacedPages.erase(lIter);
+    }
+
+    if(lNextUnclaimedPage <= pLastPage)
+        lUnplacedRanges.emplace_back(lNextUnclaimedPage, pLastPage);
+
+    mPlacedPages.emplace(lMergedFirstPage, lMergedLastPage);
+
+    return lUnplacedRanges;
+}
+
+networkCompression::codecStatistics& pmAddressSpace::GetNetworkCompressionStatistics()
+{
+    return mNetworkCompressionStatistics;
+}
+
 pmAddressSpaceType pmAddressSpace::GetAddressSpaceType() const
 {
     return mAddressSpaceType;
 }
 
+bool pmAddressSpace::IsFileBacked() const
+{
+    return mFileBacked;
+}
+
 size_t pmAddressSpace::GetRows() const
 {
     return mRequestedRows;
@@ -456,7 +543,7 @@ bool pmAddressSpace::IsWaitingForOwnershipChange()
 
 void pmAddressSpace::ChangeOwnership(std::shared_ptr<std::vector<communicator::ownershipChangeStruct>>& pOwnershipData)
 {
-    EXCEPTION_ASSERT(!GetLockingTask());
+    EXCEPTION_ASSERT(!IsLocked());
 
     // Auto lock/unlock scope
     {
@@ -464,11 +551,21 @@ void pmAddressSpace::ChangeOwnership(std::shared_ptr<std::vector<communicator::o
 
         EXCEPTION_ASSERT(mWaitingForOwnershipChange);
 
-        for_each(*pOwnershipData.get(), [this] (communicator::ownershipChangeStruct& pStruct)
+        pmRemoteDataCache* lRemoteDataCache = pmRemoteDataCache::GetRemoteDataCache();
+        communicator::memoryIdentifierStruct lMemIdentifier(*mOwner, mGenerationNumberOnOwner);
+
+        // Besides the ranges whose ownership moves away from this host, the owner lists all ranges written by the task
+        for_each(*pOwnershipData.get(), [&] (communicator::ownershipChangeStruct& pStruct)
         {
-            TransferOwnershipImmediate(pStruct.offset, pStruct.length, pmMachinePool::GetMachinePool()->GetMachine(pStruct.newOwnerHost));
+            lRemoteDataCache->Invalidate(lMemIdentifier, pStruct.offset, pStruct.length);
+
+            if(!pStruct.notificationOnly)
+                TransferOwnershipImmediate(pStruct.offset, pStruct.length, pmMachinePool::GetMachinePool()->GetMachine(pStruct.newOwnerHost));
         });
 
+        if(mWriterDataGeneration != std::numeric_limits<ulong>::max())
+            mDataGeneration = mWriterDataGeneration + 1;
+
         mWaitingForOwnershipChange = false;
     }
 
@@ -477,7 +574,7 @@ void pmAddressSpace::ChangeOwnership(std::shared_ptr<std::vector<communicator::o
 
 void pmAddressSpace::ChangeOwnership(std::shared_ptr<std::vector<communicator::scatteredOwnershipChangeStruct>>& pScatteredOwnershipData)
 {
-    EXCEPTION_ASSERT(!GetLockingTask());
+    EXCEPTION_ASSERT(!IsLocked());
 
     // Auto lock/unlock scope
     {
@@ -490,35 +587,79 @@ void pmAddressSpace::ChangeOwnership(std::shared_ptr<std::vector<communicator::s
             TransferOwnershipImmediate(pStruct.offset, pStruct.size, pStruct.step, pStruct.count, pmMachinePool::GetMachinePool()->GetMachine(pStruct.newOwnerHost));
         });
 
+        // Scattered writes of other hosts are not listed; all cached data is dropped
+        pmRemoteDataCache::GetRemoteDataCache()->Invalidate(communicator::memoryIdentifierStruct(*mOwner, mGenerationNumberOnOwner));
+
+        if(mWriterDataGeneration != std::numeric_limits<ulong>::max())
+            mDataGeneration = mWriterDataGeneration + 1;
+
         mWaitingForOwnershipChange = false;
     }
 
     ScanLockQueue();
 }
     
+ulong pmAddressSpace::GetDataGeneration()
+{
+	FINALIZE_RESOURCE_PTR(dTransferLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipTransferLock, Lock(), Unlock());
+
+    // Only the owner knows of all writes to the address space
+    return ((mOwner == PM_LOCAL_MACHINE) ? mDataGeneration : std::numeric_limits<ulong>::max());
+}
+
+/* Called on non owner hosts for every remote task using the address space. pDataGeneration is the owner's count of flushed
+ * writable locks when the task was submitted (or ulong max if unknown). A mismatch implies writes this host has not been
+ * notified of (e.g. by tasks not assigned to it or by reductions and redistributions), so all remote data cached for the
+ * address space is dropped.
+ */
+void pmAddressSpace::ValidateRemoteDataCache(ulong pDataGeneration, bool pWritable)
+{
+	FINALIZE_RESOURCE_PTR(dTransferLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipTransferLock, Lock(), Unlock());
+
+    if(mOwner == PM_LOCAL_MACHINE)
+        return;
+
+    if(pDataGeneration != mDataGeneration || pDataGeneration == std::numeric_limits<ulong>::max())
+    {
+        pmRemoteDataCache::GetRemoteDataCache()->Invalidate(communicator::memoryIdentifierStruct(*mOwner, mGenerationNumberOnOwner));
+        mDataGeneration = pDataGeneration;
+    }
+
+    if(pWritable)
+        mWriterDataGeneration = pDataGeneration;
+}
+
 void pmAddressSpace::ScanLockQueue()
 {
     FINALIZE_RESOURCE_PTR(dWaitingTasksLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mWaitingTasksLock, Lock(), Unlock());
 
-    if(mTasksWaitingForLock.empty() || IsWaitingForOwnershipChange() || GetLockingTask())
+    if(mTasksWaitingForLock.empty() || IsWaitingForOwnershipChange())
         return;
 
-    auto lValue = mTasksWaitingForLock.front();  // For now, only one task can acquire lock
+    // Waiters are served in order. All read only tasks at the head of the queue acquire the lock together,
+    // while a writer (or a reader of a different memory type) waits for the current holders to unlock.
+    while(!mTasksWaitingForLock.empty())
+    {
+        auto lValue = mTasksWaitingForLock.front();
+
+        if(!IsLockAvailable(lValue.first.second))
+            break;
 
-    Lock(lValue.first.first, lValue.first.second);
-    lValue.second->MarkExecutionEnd(pmSuccess, lValue.second);
-    
-    mTasksWaitingForLock.pop_front();
+        Lock(lValue.first.first, lValue.first.second);
+        lValue.second->MarkExecutionEnd(pmSuccess, lValue.second);
+        
+        mTasksWaitingForLock.pop_front();
+    }
 }
 
 void pmAddressSpace::EnqueueForLock(pm::pmTask* pTask, pmMemType pMemType, pmCommandPtr& pCountDownCommand)
 {
 	FINALIZE_RESOURCE_PTR(dTransferLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipTransferLock, Lock(), Unlock());
-    
-    if(mWaitingForOwnershipChange || GetLockingTask())
-    {
-        FINALIZE_RESOURCE_PTR(dWaitingTasksLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mWaitingTasksLock, Lock(), Unlock());
+    FINALIZE_RESOURCE_PTR(dWaitingTasksLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mWaitingTasksLock, Lock(), Unlock());
 
+    // A reader joins the current readers only if no one is queued before it (so that waiting writers are not starved)
+    if(mWaitingForOwnershipChange || !mTasksWaitingForLock.empty() || !IsLockAvailable(pMemType))
+    {
         mTasksWaitingForLock.emplace_back(std::make_pair(pTask, pMemType), pCountDownCommand);
     }
     else
@@ -528,15 +669,42 @@ void pmAddressSpace::EnqueueForLock(pm::pmTask* pTask, pmMemType pMemType, pmCom
     }
 }
     
+// Must be called with mTaskLock acquired
+bool pmAddressSpace::IsLockAvailableUnprotected(pmMemType pMemType)
+{
+    if(mLockingTasks.empty())
+        return true;
+
+    // Read only tasks share the lock only with readers of the same memory type (lazy readers also share the read only lazy mapping)
+    return (pmUtility::IsReadOnly(pMemType) && mLockingMemType == pMemType);
+}
+
+bool pmAddressSpace::IsLockAvailable(pmMemType pMemType)
+{
+	FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
+
+    return IsLockAvailableUnprotected(pMemType);
+}
+
 void pmAddressSpace::Lock(pmTask* pTask, pmMemType pMemType)
 {
     // Auto lock/unlock scope
     {
         FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
 
-        EXCEPTION_ASSERT(!mLockingTask && pMemType != MAX_MEM_TYPE);
+        EXCEPTION_ASSERT(pMemType != MAX_MEM_TYPE && IsLockAvailableUnprotected(pMemType));
+
+        bool lJoiningReaders = !mLockingTasks.empty();
+
+        if(!lJoiningReaders)
+            ++mLockEpoch;
 
-        mLockingTask = pTask;
+        mLockingTasks.push_back(pTask);
+        mLockingMemType = pMemType;
+
+        // The first reader has already prepared the directory and lazy mappings for all readers of this memory type
+        if(lJoiningReaders)
+            return;
         
     #ifdef SUPPORT_LAZY_MEMORY
         if((pmUtility::IsWritable(pMemType) || !pmUtility::IsLazy(pMemType)) && mReadOnlyLazyMapping)
@@ -610,9 +778,17 @@ void pmAddressSpace::Unlock(pmTask* pTask)
     {
         FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
 
-        EXCEPTION_ASSERT(mLockingTask == pTask);
+        auto lIter = std::find(mLockingTasks.begin(), mLockingTasks.end(), pTask);
+        EXCEPTION_ASSERT(lIter != mLockingTasks.end());
+
+        mLockingTasks.erase(lIter);
 
-        mLockingTask = NULL;
+        // Other readers still hold the address space; the last one to unlock does the cleanup
+        if(!mLockingTasks.empty())
+            return;
+
+        mLockingMemType = MAX_MEM_TYPE;
+        ++mLockEpoch;
     }
 
     mDirectoryPtr->CancelUnreferencedRequests();
@@ -639,11 +815,54 @@ void pmAddressSpace::Unlock(pmTask* pTask)
     }
 }
     
-pmTask* pmAddressSpace::GetLockingTask()
+// There is no single locking task while read only tasks share the address space. Callers needing one either know their
+// task (and use IsLockedBy) or want the writer (GetExclusiveLockingTask).
+bool pmAddressSpace::IsLocked()
+{
+	FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
+
+    return !mLockingTasks.empty();
+}
+
+/* Remote requests on behalf of read only tasks are shared by all tasks reading the address space and are
+ * therefore not tagged with any of them. Only an exclusive (writing) locker owns the requests it issues.
+ * Untagged requests carry the lock epoch instead, so that their data is not accepted once the epoch is over
+ * (the in-flight requests of the epoch are cancelled when the last locker leaves).
+ */
+pmTask* pmAddressSpace::GetExclusiveLockingTask()
+{
+	FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
+
+    if(mLockingTasks.empty() || pmUtility::IsReadOnly(mLockingMemType))
+        return NULL;
+
+    return mLockingTasks.front();
+}
+
+ulong pmAddressSpace::GetLockEpoch()
+{
+	FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
+
+    return mLockEpoch;
+}
+
+bool pmAddressSpace::IsLockedBy(pmTask* pTask)
+{
+	FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
+
+    return (std::find(mLockingTasks.begin(), mLockingTasks.end(), pTask) != mLockingTasks.end());
+}
+
+// Data requested by a task is accepted only while the task holds the lock. Untagged data is accepted within the lock epoch it
+// was requested in, unless a writer holds the lock.
+bool pmAddressSpace::IsReceivedDataAcceptable(pmTask* pRequestingTask, ulong pLockEpoch)
 {
 	FINALIZE_RESOURCE_PTR(dTaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mTaskLock, Lock(), Unlock());
 
-    return mLockingTask;
+    if(pRequestingTask)
+        return (std::find(mLockingTasks.begin(), mLockingTasks.end(), pRequestingTask) != mLockingTasks.end());
+
+    return (pLockEpoch == mLockEpoch && (mLockingTasks.empty() || pmUtility::IsReadOnly(mLockingMemType)));
 }
 
 void pmAddressSpace::SetRangeOwner(const vmRangeOwner& pRangeOwner, ulong pOffset, ulong pLength)
@@ -670,23 +889,21 @@ void pmAddressSpace::TransferOwnershipImmediate(ulong pOffset, ulong pSize, ulon
     SetRangeOwner(vmRangeOwner(pNewOwnerHost, pOffset, communicator::memoryIdentifierStruct(*(mOwner), mGenerationNumberOnOwner)), pOffset, pSize, pStep, pCount);
 }
 
-void pmAddressSpace::CopyOrUpdateReceivedMemory(pmTask* pRequestingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource)
+void pmAddressSpace::CopyOrUpdateReceivedMemory(pmTask* pRequestingTask, ulong pLockEpoch, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource)
 {
     EXCEPTION_ASSERT(pLength);
 
-    pmTask* lLockingTask = GetLockingTask();
-    if(lLockingTask != pRequestingTask)
+    if(!IsReceivedDataAcceptable(pRequestingTask, pLockEpoch))
         return;
 
     mDirectoryPtr->CopyOrUpdateReceivedMemory(this, GetMem(), pRequestingTask, pOffset, pLength, pDataSource);
 }
 
-void pmAddressSpace::UpdateReceivedMemory(pmTask* pRequestingTask, ulong pOffset, ulong pLength, ulong pStep, ulong pCount)
+void pmAddressSpace::UpdateReceivedMemory(pmTask* pRequestingTask, ulong pLockEpoch, ulong pOffset, ulong pLength, ulong pStep, ulong pCount)
 {
     EXCEPTION_ASSERT(pLength && pStep && pCount);
 
-    pmTask* lLockingTask = GetLockingTask();
-    if(lLockingTask != pRequestingTask)
+    if(!IsReceivedDataAcceptable(pRequestingTask, pLockEpoch))
         return;
     
     mDirectoryPtr->UpdateReceivedMemory(this, GetMem(), pRequestingTask, pOffset, pLength, pStep, pCount);
@@ -702,11 +919,6 @@ void* pmAddressSpace::GetReadOnlyLazyMemoryMapping()
 
     return mReadOnlyLazyMapping;
 }
-
-uint pmAddressSpace::GetLazyForwardPrefetchPageCount()
-{
-    return LAZY_FORWARD_PREFETCH_PAGE_COUNT;
-}
 #endif
 
 void pmAddressSpace::GetPageAlignedAddresses(size_t& pOffset, size_t& pLength)
@@ -730,7 +942,7 @@ void pmAddressSpace::GetPageAlignedAddresses(size_t& pOffset, size_t& pLength)
 
 void pmAddressSpace::TransferOwnershipPostTaskCompletion(const vmRangeOwner& pRangeOwner, ulong pOffset, ulong pLength)
 {
-    DEBUG_EXCEPTION_ASSERT(!GetLockingTask()->IsReadOnly(this));
+    DEBUG_EXCEPTION_ASSERT(GetExclusiveLockingTask());
     
 	FINALIZE_RESOURCE_PTR(dTransferLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipTransferLock, Lock(), Unlock());
 
@@ -739,7 +951,7 @@ void pmAddressSpace::TransferOwnershipPostTaskCompletion(const vmRangeOwner& pRa
 
 void pmAddressSpace::TransferOwnershipPostTaskCompletion(const vmRangeOwner& pRangeOwner, ulong pOffset, ulong pSize, ulong pStep, ulong pCount)
 {
-    DEBUG_EXCEPTION_ASSERT(!GetLockingTask()->IsReadOnly(this));
+    DEBUG_EXCEPTION_ASSERT(GetExclusiveLockingTask());
 
     FINALIZE_RESOURCE_PTR(dTransferLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipTransferLock, Lock(), Unlock());
 
@@ -748,7 +960,7 @@ void pmAddressSpace::TransferOwnershipPostTaskCompletion(const vmRangeOwner& pRa
 
 void pmAddressSpace::FlushOwnerships()
 {
-    pmTask* lTask = GetLockingTask();
+    pmTask* lTask = GetExclusiveLockingTask();
 
 #ifdef ENABLE_TASK_PROFILING
     pmRecordProfileEventAutoPtr lRecordProfileEventAutoPtr(lTask->GetTaskProfiler(), taskProfiler::FLUSH_MEMORY_OWNERSHIPS);
@@ -773,6 +985,11 @@ void pmAddressSpace::FlushOwnerships()
     EXCEPTION_ASSERT(mOwnershipTransferVector.empty() || mScatteredOwnershipTransferVector.empty());
     EXCEPTION_ASSERT(((!lTask->GetCallbackUnit()->GetDataReductionCB()) && (!lTask->GetCallbackUnit()->GetDataRedistributionCB())) || (mOwnershipTransferVector.empty() && mScatteredOwnershipTransferVector.empty()));
 
+    if(mOwner == PM_LOCAL_MACHINE)
+        ++mDataGeneration;
+
+    InvalidateRemoteDataCacheForWrites(lTask);
+
     bool lOwnershipTransferRequired = ((mOwner == PM_LOCAL_MACHINE) && (!lTask->GetCallbackUnit()->GetDataReductionCB()) && (!lTask->GetCallbackUnit()->GetDataRedistributionCB()));
     pmOwnershipTransferMap lOwnershipTransferMap;
     pmScatteredOwnershipTransferMap lScatteredOwnershipTransferMap;
@@ -810,6 +1027,20 @@ void pmAddressSpace::FlushOwnerships()
             SetRangeOwner(pTransferData.rangeOwner, pTransferData.offset, pTransferData.length);
         });
 
+        // Every host is also told of all ranges written, so that it can drop its cached copies of them
+        if(!mOwnershipTransferVector.empty())
+        {
+            std::vector<std::pair<ulong, ulong>> lWrittenRanges = GetCoalescedWrittenRanges();
+
+            for_each(lOwnershipTransferMap, [&] (pmOwnershipTransferMap::value_type& pMapPair)
+            {
+                for_each(lWrittenRanges, [&] (const std::pair<ulong, ulong>& pRange)
+                {
+                    pMapPair.second->emplace_back(pRange.first, pRange.second, *PM_LOCAL_MACHINE, true);
+                });
+            });
+        }
+
         for_each(mScatteredOwnershipTransferVector, [&] (const pmScatteredMemTransferData& pScatteredTransferData)
         {
             pmScatteredMemOwnership lScatteredOwnerships;
@@ -853,6 +1084,66 @@ void pmAddressSpace::FlushOwnerships()
     mScatteredOwnershipTransferVector.clear();
 }
     
+// Must be called with mOwnershipTransferLock acquired. Returns offset and length of the maximal ranges covered by mOwnershipTransferVector.
+std::vector<std::pair<ulong, ulong>> pmAddressSpace::GetCoalescedWrittenRanges()
+{
+    std::map<ulong, ulong> lRangesMap;  // offset versus end offset
+
+    for_each(mOwnershipTransferVector, [&] (const pmMemTransferData& pTransferData)
+    {
+        ulong lEndOffset = pTransferData.offset + pTransferData.length;
+        std::map<ulong, ulong>::iterator lIter = lRangesMap.upper_bound(pTransferData.offset);
+        
+        if(lIter != lRangesMap.begin() && std::prev(lIter)->second >= pTransferData.offset)
+            --lIter;
+        else
+            lIter = lRangesMap.emplace(pTransferData.offset, lEndOffset).first;
+
+        lIter->second = std::max(lIter->second, lEndOffset);
+        
+        std::map<ulong, ulong>::iterator lNextIter = std::next(lIter);
+        while(lNextIter != lRangesMap.end() && lNextIter->first <= lIter->second)
+        {
+            lIter->second = std::max(lIter->second, lNextIter->second);
+            lRangesMap.erase(lNextIter++);
+        }
+    });
+
+    std::vector<std::pair<ulong, ulong>> lRanges;
+    lRanges.reserve(lRangesMap.size());
+
+    for_each(lRangesMap, [&] (const std::pair<ulong, ulong>& pPair)
+    {
+        lRanges.emplace_back(pPair.first, pPair.second - pPair.first);
+    });
+    
+    return lRanges;
+}
+
+// Must be called with mOwnershipTransferLock acquired. Drops this host's cached remote copies of data written by pTask.
+void pmAddressSpace::InvalidateRemoteDataCacheForWrites(pmTask* pTask)
+{
+    pmRemoteDataCache* lRemoteDataCache = pmRemoteDataCache::GetRemoteDataCache();
+    communicator::memoryIdentifierStruct lMemIdentifier(*mOwner, mGenerationNumberOnOwner);
+
+    if(pTask->GetCallbackUnit()->GetDataReductionCB() || pTask->GetCallbackUnit()->GetDataRedistributionCB())
+    {
+        lRemoteDataCache->Invalidate(lMemIdentifier);
+        return;
+    }
+
+    std::vector<std::pair<ulong, ulong>> lWrittenRanges = GetCoalescedWrittenRanges();
+    for_each(lWrittenRanges, [&] (const std::pair<ulong, ulong>& pRange)
+    {
+        lRemoteDataCache->Invalidate(lMemIdentifier, pRange.first, pRange.second);
+    });
+
+    for_each(mScatteredOwnershipTransferVector, [&] (const pmScatteredMemTransferData& pScatteredTransferData)
+    {
+        lRemoteDataCache->Invalidate(lMemIdentifier, pScatteredTransferData.offset, (pScatteredTransferData.count - 1) * pScatteredTransferData.step + pScatteredTransferData.size);
+    });
+}
+
 pmScatteredTransferMapType pmAddressSpace::SetupRemoteRegionsForFetching(const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo, ulong pPriority, std::set<pmCommandPtr>& pCommandsAlreadyIssuedSet)
 {
     return mDirectoryPtr->SetupRemoteRegionsForFetching(pScatteredSubscriptionInfo, GetMem(), pPriority, pCommandsAlreadyIssuedSet);
@@ -887,7 +1178,7 @@ void pmAddressSpace::FetchCompletionCallback(const pmCommandPtr& pCommand)
 void pmAddressSpace::FetchAsync(ushort pPriority, pmCommandPtr pCommand)
 {
     std::vector<pmCommandPtr> lVector;
-    MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->FetchMemoryRegion(this, pPriority, 0, GetLength(), lVector);
+    MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->FetchMemoryRegions(this, pPriority, std::vector<pmSubscriptionInfo>(1, pmSubscriptionInfo(0, GetLength())), lVector);
 
     if(lVector.size())
     {
@@ -903,6 +1194,11 @@ void pmAddressSpace::FetchAsync(ushort pPriority, pmCommandPtr pCommand)
 }
 
 void pmAddressSpace::FetchRange(ushort pPriority, ulong pOffset, ulong pLength)
+{
+    FetchRanges(pPriority, std::vector<pmSubscriptionInfo>(1, pmSubscriptionInfo(pOffset, pLength)));
+}
+
+void pmAddressSpace::FetchRanges(ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges)
 {
 #ifdef ENABLE_MEM_PROFILING
     TIMER_IMPLEMENTATION_CLASS lTimer;
@@ -910,7 +1206,7 @@ void pmAddressSpace::FetchRange(ushort pPriority, ulong pOffset, ulong pLength)
 #endif
 
     std::vector<pmCommandPtr> lVector;
-    MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->FetchMemoryRegion(this, pPriority, pOffset, pLength, lVector);
+    MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->FetchMemoryRegions(this, pPriority, pRanges, lVector);
     
     std::vector<pmCommandPtr>::const_iterator lIter = lVector.begin(), lEndIter = lVector.end();
     for(; lIter != lEndIter; ++lIter)
@@ -926,6 +1222,15 @@ void pmAddressSpace::FetchRange(ushort pPriority, ulong pOffset, ulong pLength)
 #endif
 }
 
+/* Issues the fetch and returns without waiting. The returned command finishes when every range is locally available. */
+pmCommandPtr pmAddressSpace::FetchRangesAsync(ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges)
+{
+    std::vector<pmCommandPtr> lVector;
+    MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->FetchMemoryRegions(this, pPriority, pRanges, lVector);
+
+    return pmAccumulatorCommand::CreateSharedPtr(lVector);
+}
+
 /* This method does not acquire mOwnershipLock (directly calls GetOwnersInternal instead of GetOwners).
  It is only meant to be called by preprocessor task as it does not actually fetch data on user task's
  address spaces, but just determines its current ownership.
@@ -1126,6 +1431,23 @@ pmAddressSpace* pmUserMemHandle::GetAddressSpace()
     return mAddressSpace;
 }
 
+
+/* class pmUserFetchHandle */
+pmUserFetchHandle::pmUserFetchHandle(const pmCommandPtr& pCommand)
+    : mCommand(pCommand)
+{
+}
+
+bool pmUserFetchHandle::IsComplete()
+{
+    return (mCommand->GetStatus() != pmStatusUnavailable);
+}
+
+void pmUserFetchHandle::Wait()
+{
+    mCommand->WaitForFinish();
+}
+
 };
 
 
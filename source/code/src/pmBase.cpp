@@ -44,7 +44,6 @@ namespace pm
 
 pmBase::pmBase()
 {
-	srand((int)time(NULL));
 }
 
 pmBase::~pmBase()
@@ -87,7 +86,20 @@ void pmBase::DeallocateMemory(void* pPtr)
 
 uint pmBase::GetRandomInt(uint pMaxLimit)
 {
-	return rand() % pMaxLimit;
+	return std::uniform_int_distribution<uint>(0, pMaxLimit - 1)(GetRandomGenerator());
+}
+
+double pmBase::GetRandomDouble(double pMaxLimit)
+{
+	return std::uniform_real_distribution<double>(0, pMaxLimit)(GetRandomGenerator());
+}
+
+std::mt19937& pmBase::GetRandomGenerator()
+{
+    // Unlike srand/rand, this is neither reseeded by every caller nor contended across threads
+    thread_local std::mt19937 sGenerator(std::random_device{}());
+
+    return sGenerator;
 }
 
 ulong pmBase::GetIntegralCurrentTimeInSecs()
@@ -216,17 +216,26 @@ remoteTaskAssignPacked::remoteTaskAssignPacked(pmLocalTask* pLocalTask)
         for_each(pLocalTask->GetTaskMemVector(), [&] (const pmTaskMemory& pTaskMemory)
         {
             const pmAddressSpace* lAddressSpace = pTaskMemory.addressSpace;
+            const pmMemAllocationPolicy& lAllocationPolicy = lAddressSpace->GetAllocationPolicy();
+
+            ushort lFlags = (pTaskMemory.disjointReadWritesAcrossSubtasks ? TASK_MEM_DISJOINT_READ_WRITES_FLAG_VAL : 0);
+            lFlags |= ((lAllocationPolicy.placement << TASK_MEM_PLACEMENT_POLICY_SHIFT) & TASK_MEM_PLACEMENT_POLICY_MASK);
+            lFlags |= ((lAllocationPolicy.pageSize << TASK_MEM_PAGE_SIZE_SHIFT) & TASK_MEM_PAGE_SIZE_MASK);
+            lFlags |= ((lAllocationPolicy.compression << TASK_MEM_NETWORK_COMPRESSION_SHIFT) & TASK_MEM_NETWORK_COMPRESSION_MASK);
+        
+            if(lAllocationPolicy.adviseAccessPattern)
+                lFlags |= TASK_MEM_ADVISE_ACCESS_PATTERN_FLAG_VAL;
             
             pmAddressSpaceType lAddressSpaceType = lAddressSpace->GetAddressSpaceType();
             DEBUG_EXCEPTION_ASSERT(lAddressSpaceType == ADDRESS_SPACE_LINEAR || lAddressSpaceType == ADDRESS_SPACE_2D);
 
             if(lAddressSpaceType == ADDRESS_SPACE_LINEAR)
             {
-                taskMem.emplace_back(memoryIdentifierStruct(*(lAddressSpace->GetMemOwnerHost()), lAddressSpace->GetGenerationNumber()), lAddressSpace->GetLength(), pLocalTask->GetMemType(lAddressSpace), pTaskMemory.subscriptionVisibilityType, (ushort)pTaskMemory.disjointReadWritesAcrossSubtasks);
+                taskMem.emplace_back(memoryIdentifierStruct(*(lAddressSpace->GetMemOwnerHost()), lAddressSpace->GetGenerationNumber()), lAddressSpace->GetLength(), pLocalTask->GetMemType(lAddressSpace), pTaskMemory.subscriptionVisibilityType, lFlags, pTaskMemory.addressSpace->GetDataGeneration());
             }
             else
             {
-                taskMem.emplace_back(memoryIdentifierStruct(*(lAddressSpace->GetMemOwnerHost()), lAddressSpace->GetGenerationNumber()), lAddressSpace->GetRows(), lAddressSpace->GetCols(), pLocalTask->GetMemType(lAddressSpace), pTaskMemory.subscriptionVisibilityType, (ushort)pTaskMemory.disjointReadWritesAcrossSubtasks);
+                taskMem.emplace_back(memoryIdentifierStruct(*(lAddressSpace->GetMemOwnerHost()), lAddressSpace->GetGenerationNumber()), lAddressSpace->GetRows(), lAddressSpace->GetCols(), pLocalTask->GetMemType(lAddressSpace), pTaskMemory.subscriptionVisibilityType, lFlags, pTaskMemory.addressSpace->GetDataGeneration());
             }
         });
     }
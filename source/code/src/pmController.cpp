@@ -52,6 +52,8 @@
 #include "pmReducer.h"
 #include "pmOpenCLManager.h"
 #include "pmPreprocessorTask.h"
+#include "pmPersistentTask.h"
+#include "pmTracer.h"
 
 namespace pm
 {
@@ -69,6 +71,7 @@ pmController::pmController()
     NETWORK_IMPLEMENTATION_CLASS::GetNetwork();
     pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool();
     TLS_IMPLEMENTATION_CLASS::GetTls();
+    pmTracer::GetTracer();
     pmDispatcherGPU::GetDispatcherGPU();
     pmStubManager::GetStubManager();
     pmCommunicator::GetCommunicator();
@@ -96,6 +99,8 @@ pmController* pmController::GetController()
         NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GlobalBarrier();
         lFirstCall = false;
 
+        pmTracer::GetTracer()->SynchronizeClock();
+
         pmPreprocessorTask::GetPreprocessorTask();
     }
 
@@ -110,6 +115,8 @@ void pmController::DestroyController()
     pmStubManager::GetStubManager()->WaitForAllStubsToFinish();
     
     pmAddressSpace::DeleteAllLocalAddressSpaces();
+    
+    pmTracer::GetTracer()->Finalize();
 }
 
 void pmController::FinalizeController()
@@ -187,24 +194,46 @@ void pmController::RegisterCallbacks_Public(const char* pKey, pmCallbacks pCallb
     NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GlobalBarrier();
 }
 
+void pmController::SetEventTracing_Public(bool pEnable)
+{
+    pmTracer::GetTracer()->SetEnabled(pEnable);
+}
+
 void pmController::ReleaseCallbacks_Public(pmCallbackHandle pCallbackHandle)
 {
 	delete static_cast<pmCallbackUnit*>(pCallbackHandle);
 }
 
-void pmController::CreateMemory_Public(size_t pLength, pmMemHandle* pMem)
+void pmController::CreateMemory_Public(size_t pLength, pmMemHandle* pMem, const pmMemAllocationPolicy& pAllocationPolicy)
 {
 	*pMem = NULL;
 
-    pmAddressSpace* lAddressSpace = pmAddressSpace::CreateAddressSpace(pLength, PM_LOCAL_MACHINE);
+    if(pAllocationPolicy.placement >= MAX_MEM_PLACEMENT_POLICY || pAllocationPolicy.pageSize >= MAX_MEM_PAGE_SIZE || pAllocationPolicy.compression >= MAX_NETWORK_COMPRESSION)
+        PMTHROW(pmFatalErrorException());
+
+    pmAddressSpace* lAddressSpace = pmAddressSpace::CreateAddressSpace(pLength, PM_LOCAL_MACHINE, pAllocationPolicy);
     *pMem = new pmUserMemHandle(lAddressSpace);
 }
 
-void pmController::CreateMemory2D_Public(size_t pRows, size_t pCols, pmMemHandle* pMem)
+void pmController::CreateMemory2D_Public(size_t pRows, size_t pCols, pmMemHandle* pMem, const pmMemAllocationPolicy& pAllocationPolicy)
 {
 	*pMem = NULL;
 
-    pmAddressSpace* lAddressSpace = pmAddressSpace::CreateAddressSpace(pRows, pCols, PM_LOCAL_MACHINE);
+    if(pAllocationPolicy.placement >= MAX_MEM_PLACEMENT_POLICY || pAllocationPolicy.pageSize >= MAX_MEM_PAGE_SIZE || pAllocationPolicy.compression >= MAX_NETWORK_COMPRESSION)
+        PMTHROW(pmFatalErrorException());
+
+    pmAddressSpace* lAddressSpace = pmAddressSpace::CreateAddressSpace(pRows, pCols, PM_LOCAL_MACHINE, pAllocationPolicy);
+    *pMem = new pmUserMemHandle(lAddressSpace);
+}
+
+void pmController::CreateFileBackedMemory_Public(const char* pPath, pmMemHandle* pMem)
+{
+	*pMem = NULL;
+
+    if(!pPath)
+        PMTHROW(pmFatalErrorException());
+
+    pmAddressSpace* lAddressSpace = pmAddressSpace::CreateFileBackedAddressSpace(pPath);
     *pMem = new pmUserMemHandle(lAddressSpace);
 }
 
@@ -238,6 +267,58 @@ void pmController::FetchMemoryRange_Public(pmMemHandle pMem, size_t pOffset, siz
     
     lAddressSpace->FetchRange(MAX_PRIORITY_LEVEL, pOffset, pLength);
 }
+
+/* Issues a batched fetch; it is blocking if pFetchHandle is NULL, otherwise a fetch handle is returned in it */
+void pmController::FetchMemoryRanges_Public(pmMemHandle pMem, const pmSubscriptionInfo* pRanges, uint pRangeCount, pmFetchHandle* pFetchHandle)
+{
+    if(!pMem || (pRangeCount && !pRanges))
+        PMTHROW(pmFatalErrorException());
+
+	pmAddressSpace* lAddressSpace = (reinterpret_cast<pmUserMemHandle*>(pMem))->GetAddressSpace();
+    size_t lAddressSpaceLength = lAddressSpace->GetLength();
+
+    std::vector<pmSubscriptionInfo> lRanges;
+    lRanges.reserve(pRangeCount);
+
+    for(uint i = 0; i < pRangeCount; ++i)
+    {
+        if(pRanges[i].offset > lAddressSpaceLength || pRanges[i].length > lAddressSpaceLength - pRanges[i].offset)
+            PMTHROW(pmFatalErrorException());
+
+        if(pRanges[i].length)
+            lRanges.push_back(pRanges[i]);
+    }
+
+    if(pFetchHandle)
+        *pFetchHandle = new pmUserFetchHandle(lAddressSpace->FetchRangesAsync(MAX_PRIORITY_LEVEL, lRanges));
+    else
+        lAddressSpace->FetchRanges(MAX_PRIORITY_LEVEL, lRanges);
+}
+
+void pmController::TestFetch_Public(pmFetchHandle pFetchHandle, bool* pComplete)
+{
+    if(!pFetchHandle || !pComplete)
+        PMTHROW(pmFatalErrorException());
+
+    *pComplete = (static_cast<pmUserFetchHandle*>(pFetchHandle))->IsComplete();
+}
+
+void pmController::WaitForFetch_Public(pmFetchHandle pFetchHandle)
+{
+    if(!pFetchHandle)
+        PMTHROW(pmFatalErrorException());
+
+    (static_cast<pmUserFetchHandle*>(pFetchHandle))->Wait();
+}
+
+void pmController::ReleaseFetch_Public(pmFetchHandle pFetchHandle)
+{
+    if(!pFetchHandle)
+        PMTHROW(pmFatalErrorException());
+
+    WaitForFetch_Public(pFetchHandle);
+    delete (static_cast<pmUserFetchHandle*>(pFetchHandle));
+}
     
 void pmController::GetRawMemPtr_Public(pmMemHandle pMem, void** pPtr)
 {
@@ -248,13 +329,31 @@ void pmController::GetRawMemPtr_Public(pmMemHandle pMem, void** pPtr)
     *pPtr = lAddressSpace->GetMem();
 }
 
-void pmController::SubmitTask_Public(pmTaskDetails pTaskDetails, pmTaskHandle* pTaskHandle, const std::set<const pmMachine*>& pRestrictToMachinesSet /* = std::set<const pmMachine*>() */)
+void pmController::ValidateTaskDetails(const pmTaskDetails& pTaskDetails)
 {
-	*pTaskHandle = NULL;
+    if(pTaskDetails.taskMemCount > MAX_MEM_SECTIONS_PER_TASK || (pTaskDetails.taskMemCount && !pTaskDetails.taskMem))
+        PMTHROW(pmFatalErrorException());
 
-    if(pTaskDetails.taskMemCount > MAX_MEM_SECTIONS_PER_TASK)
+    if(pTaskDetails.policy != SLOW_START && pTaskDetails.policy != RANDOM_STEAL && pTaskDetails.policy != RANDOM_STEAL_WITH_AFFINITY && pTaskDetails.policy != EQUAL_STATIC && pTaskDetails.policy != PROPORTIONAL_STATIC && pTaskDetails.policy != NODE_EQUAL_STATIC)
         PMTHROW(pmFatalErrorException());
 
+    for(size_t i = 0; i < pTaskDetails.taskMemCount; ++i)
+    {
+        const pmTaskMem& lTaskMem = pTaskDetails.taskMem[i];
+
+        if(!lTaskMem.memHandle || !(reinterpret_cast<pmUserMemHandle*>(lTaskMem.memHandle))->GetAddressSpace() || lTaskMem.memType == MAX_MEM_TYPE)
+            PMTHROW(pmFatalErrorException());
+
+        // File backed address spaces are read locally on every machine, so they can never be written
+        if((reinterpret_cast<pmUserMemHandle*>(lTaskMem.memHandle))->GetAddressSpace()->IsFileBacked() && !pmUtility::IsReadOnly(lTaskMem.memType))
+            PMTHROW(pmFatalErrorException());
+    }
+}
+
+pmLocalTask* pmController::CreateLocalTask(pmTaskDetails& pTaskDetails, const std::set<const pmMachine*>& pRestrictToMachinesSet)
+{
+    ValidateTaskDetails(pTaskDetails);
+
 	pmCallbackUnit* lCallbackUnit = static_cast<pmCallbackUnit*>(pTaskDetails.callbackHandle);
 
 	if(pTaskDetails.taskConfLength == 0)
@@ -273,8 +372,6 @@ void pmController::SubmitTask_Public(pmTaskDetails pTaskDetails, pmTaskHandle* p
             lModel = scheduler::STATIC_PROPORTIONAL;
         else if(pTaskDetails.policy == NODE_EQUAL_STATIC)
             lModel = scheduler::STATIC_EQUAL_NODE;
-        else
-            PMTHROW(pmFatalErrorException());
     }
 
     ushort lTaskFlags = 0;
@@ -306,17 +403,162 @@ void pmController::SubmitTask_Public(pmTaskDetails pTaskDetails, pmTaskHandle* p
     for(size_t i = 0; i < pTaskDetails.taskMemCount; ++i)
     {
         pmAddressSpace* lAddressSpace = (reinterpret_cast<pmUserMemHandle*>(pTaskDetails.taskMem[i].memHandle))->GetAddressSpace();
-        if(!lAddressSpace || pTaskDetails.taskMem[i].memType == MAX_MEM_TYPE)
-            PMTHROW(pmFatalErrorException());
         
         pmTaskMem& pTaskMem = pTaskDetails.taskMem[i];
         lTaskMemVector.emplace_back(lAddressSpace, pTaskMem.memType, pTaskMem.subscriptionVisibilityType, pTaskMem.disjointReadWritesAcrossSubtasks);
     }
     
-	*pTaskHandle = new pmLocalTask(pTaskDetails.taskConf, pTaskDetails.taskConfLength, pTaskDetails.taskId, std::move(lTaskMemVector), pTaskDetails.subtaskCount, lCallbackUnit, pTaskDetails.timeOutInSecs, PM_LOCAL_MACHINE, PM_GLOBAL_CLUSTER, pTaskDetails.priority, lModel, lTaskFlags, pTaskDetails.affinityCriterion, pRestrictToMachinesSet);
+	return new pmLocalTask(pTaskDetails.taskConf, pTaskDetails.taskConfLength, pTaskDetails.taskId, std::move(lTaskMemVector), pTaskDetails.subtaskCount, lCallbackUnit, pTaskDetails.timeOutInSecs, PM_LOCAL_MACHINE, PM_GLOBAL_CLUSTER, pTaskDetails.priority, lModel, lTaskFlags, pTaskDetails.affinityCriterion, pRestrictToMachinesSet);
+}
+
+void pmController::SubmitTask_Public(pmTaskDetails pTaskDetails, pmTaskHandle* pTaskHandle, const std::set<const pmMachine*>& pRestrictToMachinesSet /* = std::set<const pmMachine*>() */)
+{
+	*pTaskHandle = NULL;
+
+    pmLocalTask* lLocalTask = CreateLocalTask(pTaskDetails, pRestrictToMachinesSet);
+    *pTaskHandle = lLocalTask;
+
+    pmTaskManager::GetTaskManager()->SubmitTask(lLocalTask);
+    lLocalTask->LockAddressSpaces();
+}
+
+void pmController::SubmitTaskGraph_Public(pmTaskDetails* pTaskDetails, uint pTaskCount, const pmTaskDependency* pDependencies, uint pDependencyCount, pmTaskHandle* pTaskHandles)
+{
+    if(!pTaskDetails || !pTaskCount || !pTaskHandles || (pDependencyCount && !pDependencies))
+        PMTHROW(pmFatalErrorException());
+
+    // Validate the whole graph before creating any task, so that a bad entry does not leave half a graph submitted
+    for(uint i = 0; i < pTaskCount; ++i)
+    {
+        pTaskHandles[i] = NULL;
+        ValidateTaskDetails(pTaskDetails[i]);
+    }
+
+    std::vector<std::set<uint>> lPrerequisites(pTaskCount);
+
+    for(uint i = 0; i < pDependencyCount; ++i)
+    {
+        if(pDependencies[i].dependent >= pTaskCount || pDependencies[i].prerequisite >= pDependencies[i].dependent)
+            PMTHROW(pmFatalErrorException());
+
+        lPrerequisites[pDependencies[i].dependent].insert(pDependencies[i].prerequisite);
+    }
+
+    // Address space derived dependencies (read after write, write after read and write after write)
+    std::map<pmAddressSpace*, std::pair<uint, std::vector<uint>>> lAccessMap;   // Address space vs. (last writer, readers since the last writer)
+
+    for(uint i = 0; i < pTaskCount; ++i)
+    {
+        for(uint j = 0; j < pTaskDetails[i].taskMemCount; ++j)
+        {
+            const pmTaskMem& lTaskMem = pTaskDetails[i].taskMem[j];
+            pmAddressSpace* lAddressSpace = (reinterpret_cast<pmUserMemHandle*>(lTaskMem.memHandle))->GetAddressSpace();
+
+            auto lIter = lAccessMap.find(lAddressSpace);
+            if(lIter == lAccessMap.end())
+                lIter = lAccessMap.emplace(lAddressSpace, std::make_pair(std::numeric_limits<uint>::max(), std::vector<uint>())).first;
+
+            auto& lAccess = lIter->second;
+
+            if(lAccess.first != std::numeric_limits<uint>::max() && lAccess.first != i)
+                lPrerequisites[i].insert(lAccess.first);
+
+            if(pmUtility::IsWritable(lTaskMem.memType))
+            {
+                for_each(lAccess.second, [&] (uint pReader)
+                {
+                    if(pReader != i)
+                        lPrerequisites[i].insert(pReader);
+                });
+
+                lAccess.first = i;
+                lAccess.second.clear();
+            }
+            else
+            {
+                lAccess.second.push_back(i);
+            }
+        }
+    }
+    
+    std::vector<pmLocalTask*> lTasks;
+    lTasks.reserve(pTaskCount);
+
+    for(uint i = 0; i < pTaskCount; ++i)
+    {
+        lTasks.push_back(CreateLocalTask(pTaskDetails[i], std::set<const pmMachine*>()));
+        pTaskHandles[i] = lTasks.back();
+    }
+
+    for(uint i = 0; i < pTaskCount; ++i)
+    {
+        std::vector<pmLocalTask*> lPrerequisiteTasks;
+        lPrerequisiteTasks.reserve(lPrerequisites[i].size());
+
+        for_each(lPrerequisites[i], [&] (uint pPrerequisite)
+        {
+            lPrerequisiteTasks.push_back(lTasks[pPrerequisite]);
+        });
+
+        lTasks[i]->SubmitAfter(lPrerequisiteTasks);
+    }
+}
+
+void pmController::SubmitTaskAfter_Public(pmTaskDetails pTaskDetails, const pmTaskHandle* pPrerequisiteTasks, uint pPrerequisiteCount, pmTaskHandle* pTaskHandle)
+{
+	*pTaskHandle = NULL;
+
+    if(pPrerequisiteCount && !pPrerequisiteTasks)
+        PMTHROW(pmFatalErrorException());
+    
+    std::vector<pmLocalTask*> lPrerequisiteTasks;
+    lPrerequisiteTasks.reserve(pPrerequisiteCount);
+
+    for(uint i = 0; i < pPrerequisiteCount; ++i)
+    {
+        if(!pPrerequisiteTasks[i])
+            PMTHROW(pmFatalErrorException());
+
+        lPrerequisiteTasks.push_back(static_cast<pmLocalTask*>(pPrerequisiteTasks[i]));
+    }
+    
+    pmLocalTask* lLocalTask = CreateLocalTask(pTaskDetails, std::set<const pmMachine*>());
+    *pTaskHandle = lLocalTask;
+
+    lLocalTask->SubmitAfter(lPrerequisiteTasks);
+}
+
+void pmController::CreatePersistentTask_Public(pmTaskDetails pTaskDetails, pmPersistentTaskHandle* pPersistentTaskHandle)
+{
+	*pPersistentTaskHandle = NULL;
+
+    ValidateTaskDetails(pTaskDetails);
+    *pPersistentTaskHandle = new pmPersistentTask(pTaskDetails);
+}
 
-    pmTaskManager::GetTaskManager()->SubmitTask(static_cast<pmLocalTask*>(*pTaskHandle));
-    static_cast<pmLocalTask*>(*pTaskHandle)->LockAddressSpaces();
+/* Every launch is an ordinary local task which starts after the previous launch of the same persistent task has finished */
+void pmController::LaunchPersistentTask_Public(pmPersistentTaskHandle pPersistentTaskHandle, pmTaskMem* pTaskMem, void* pTaskConf, pmTaskHandle* pTaskHandle)
+{
+	*pTaskHandle = NULL;
+
+    if(!pPersistentTaskHandle)
+        PMTHROW(pmFatalErrorException());
+
+    pmPersistentTask* lPersistentTask = static_cast<pmPersistentTask*>(pPersistentTaskHandle);
+    pmTaskDetails lTaskDetails = lPersistentTask->PrepareLaunch(pTaskMem, pTaskConf);
+
+    pmLocalTask* lLocalTask = CreateLocalTask(lTaskDetails, std::set<const pmMachine*>());
+    *pTaskHandle = lLocalTask;
+
+    lLocalTask->SubmitAfter(lPersistentTask->RegisterLaunch(lLocalTask));
+}
+
+void pmController::ReleasePersistentTask_Public(pmPersistentTaskHandle pPersistentTaskHandle)
+{
+    if(!pPersistentTaskHandle)
+        PMTHROW(pmFatalErrorException());
+
+    static_cast<pmPersistentTask*>(pPersistentTaskHandle)->UserDelete();
 }
 
 void pmController::WaitForTaskCompletion_Public(pmTaskHandle pTaskHandle)
@@ -434,7 +676,47 @@ void pmController::pmReduceSubtasks_Public(pmTaskHandle pTaskHandle, pmDeviceHan
     if(!pTaskHandle || !pDevice1Handle || !pDevice2Handle || pReductionOperation >= MAX_REDUCTION_OP_TYPES || pReductionDataType >= MAX_REDUCTION_DATA_TYPES)
         PMTHROW(pmFatalErrorException());
 
-    (static_cast<pmTask*>(pTaskHandle))->GetReducer()->ReduceSubtasks(static_cast<pmExecutionStub*>(pDevice1Handle), pSubtask1Id, pSplitInfo1, static_cast<pmExecutionStub*>(pDevice2Handle), pSubtask2Id, pSplitInfo2, pReductionOperation, pReductionDataType);
+    pmTask* lTask = static_cast<pmTask*>(pTaskHandle);
+
+    // The reduction callback gets physical subtask ids; subscriptions are kept against logical ones
+    lTask->GetReducer()->ReduceSubtasks(static_cast<pmExecutionStub*>(pDevice1Handle), lTask->GetLogicalSubtaskId(pSubtask1Id), pSplitInfo1, static_cast<pmExecutionStub*>(pDevice2Handle), lTask->GetLogicalSubtaskId(pSubtask2Id), pSplitInfo2, pReductionOperation, pReductionDataType);
+}
+
+void pmController::pmReduceSubtasks_Public(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handle, ulong pSubtask1Id, pmSplitInfo* pSplitInfo1, pmDeviceHandle pDevice2Handle, ulong pSubtask2Id, pmSplitInfo* pSplitInfo2, pmReductionOpHandle pReductionOpHandle)
+{
+    if(!pTaskHandle || !pDevice1Handle || !pDevice2Handle || !pReductionOpHandle)
+        PMTHROW(pmFatalErrorException());
+
+    const reducer::userReductionOperation* lUserOperation = static_cast<const reducer::userReductionOperation*>(pReductionOpHandle);
+
+    pmTask* lTask = static_cast<pmTask*>(pTaskHandle);
+
+    lTask->GetReducer()->ReduceSubtasks(static_cast<pmExecutionStub*>(pDevice1Handle), lTask->GetLogicalSubtaskId(pSubtask1Id), pSplitInfo1, static_cast<pmExecutionStub*>(pDevice2Handle), lTask->GetLogicalSubtaskId(pSubtask2Id), pSplitInfo2, lUserOperation->operation);
+}
+
+/* Registeration is collective. Operators are numbered in the order of registeration, which must hence be the same on all machines. */
+void pmController::RegisterReductionOperation_Public(const char* pKey, const pmReductionOperation& pOperation, pmReductionOpHandle* pReductionOpHandle)
+{
+    *pReductionOpHandle = NULL;
+
+	if(strlen(pKey) >= MAX_CB_KEY_LEN)
+		PMTHROW(pmMaxKeyLengthExceeded);
+
+    const reducer::userReductionOperation* lUserOperation = pmReducer::RegisterUserReductionOperation(pKey, pOperation);
+
+    NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->RegisterUserReductionOperation(lUserOperation->slot, lUserOperation->operation);
+
+    *pReductionOpHandle = const_cast<reducer::userReductionOperation*>(lUserOperation);
+
+    NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GlobalBarrier();
+}
+
+pmDataReductionCallback pmController::GetSubtaskReductionCallback_Public(pmReductionOpHandle pReductionOpHandle)
+{
+    if(!pReductionOpHandle)
+        PMTHROW(pmFatalErrorException());
+
+    return pmReducer::GetUserReductionCallback(static_cast<const reducer::userReductionOperation*>(pReductionOpHandle)->slot);
 }
 
 void pmController::MapFile_Public(const char* pPath)
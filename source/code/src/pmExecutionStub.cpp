@@ -48,6 +48,7 @@
 #include "pmReducer.h"
 #include "pmRedistributor.h"
 #include "pmAffinityTable.h"
+#include "pmTracer.h"
 
 #ifdef USE_STEAL_AGENT_PER_NODE
     #include "pmStealAgent.h"
@@ -57,6 +58,7 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <functional>
 
@@ -318,7 +320,7 @@ void pmExecutionStub::CancelAllSubtasksInternal(pmTask* pTask, bool pTaskListeni
     ushort lPriority = pTask->GetPriority();
 
     // Delete all subtask exec commands for the task pTask
-    DeleteMatchingCommands(lPriority, execEventMatchFunc, pTask);
+    DeleteMatchingCommands(lPriority, execEventMatchFunc, pTask, pTask);
     
     if(pTaskListeningOnCancellation)
         pTask->RegisterStubCancellationMessage();
@@ -329,7 +331,7 @@ void pmExecutionStub::CancelSubtaskRangeInternal(const pmSubtaskRange& pRange)
     ushort lPriority = pRange.task->GetPriority();
     
     std::vector<std::shared_ptr<stubEvent>> lTaskEvents;
-    DeleteAndGetAllMatchingCommands(lPriority, execEventRangeMatchFunc, &pRange, lTaskEvents);
+    DeleteAndGetAllMatchingCommands(lPriority, execEventRangeMatchFunc, &pRange, lTaskEvents, false, pRange.task);
 
 #if _DEBUG
     // Entire range should be cancelled
@@ -383,7 +385,7 @@ void pmExecutionStub::SplitSubtaskCheckEvent(pmTask* pTask)
     
 void pmExecutionStub::RemoveSplitSubtaskCheckEvent(pmTask* pTask)
 {
-    DeleteMatchingCommands(pTask->GetPriority(), splitSubtaskCheckEventMatchFunc, pTask);
+    DeleteMatchingCommands(pTask->GetPriority(), splitSubtaskCheckEventMatchFunc, pTask, pTask);
     WaitIfCurrentCommandMatches(splitSubtaskCheckEventMatchFunc, pTask);
 }
 #endif
@@ -528,7 +530,7 @@ void pmExecutionStub::NegotiateRange(const pmProcessingElement* pRequestingDevic
                         bool lNegotiationStatus = false;
                         
                         std::vector<std::shared_ptr<stubEvent>> lTaskEventVector;
-                        DeleteAndGetAllMatchingCommands(lPriority, execEventRangeMatchFunc, &pRange, lTaskEventVector);
+                        DeleteAndGetAllMatchingCommands(lPriority, execEventRangeMatchFunc, &pRange, lTaskEventVector, false, pRange.task);
                         if(!lTaskEventVector.empty())
                         {
                             // In Push model, there could be multiple assigned ranges but an assigned range should not get broken down into multiple entries.
@@ -652,7 +654,7 @@ void pmExecutionStub::NegotiateRange(const pmProcessingElement* pRequestingDevic
         bool lCurrentTransferred = false;
     
         std::vector<std::shared_ptr<stubEvent>> lTaskEventVector;
-        DeleteAndGetAllMatchingCommands(lPriority, execEventRangeMatchFunc, &pRange, lTaskEventVector);
+        DeleteAndGetAllMatchingCommands(lPriority, execEventRangeMatchFunc, &pRange, lTaskEventVector, false, pRange.task);
 
         FINALIZE_RESOURCE_PTR(dCurrentSubtaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCurrentSubtaskRangeLock, Lock(), Unlock());
     
@@ -758,7 +760,7 @@ void pmExecutionStub::NegotiateRange(const pmProcessingElement* pRequestingDevic
 }
 
 // This method must be called with mCurrentSubtaskRangeLock acquired
-ulong pmExecutionStub::GetStealCount(pmTask* pTask, const pmProcessingElement* pRequestingDevice, ulong pAvailableSubtasks, double pLocalExecutionRate, double pRequestingDeviceExecutionRate)
+ulong pmExecutionStub::GetStealCount(pmTask* pTask, const pmProcessingElement* pRequestingDevice, ulong pAvailableSubtasks, double pLocalExecutionRate, double pRequestingDeviceExecutionRate, double pStealRoundTripTime)
 {
     ulong lStealCount = 0;
 
@@ -806,6 +808,16 @@ ulong pmExecutionStub::GetStealCount(pmTask* pTask, const pmProcessingElement* p
                 #endif
                         ++lStealCount;
                 }
+
+                // A stealer granted less than what it executes in one steal round trip idles before its next steal
+                // returns. Grant at least that much, as long as the victim keeps half of its subtasks.
+                if(lStealCount && pStealRoundTripTime > (double)0)
+                {
+                    ulong lRoundTripSubtasks = (ulong)std::ceil(pStealRoundTripTime * pRequestingDeviceExecutionRate);
+
+                    if(lRoundTripSubtasks > lStealCount)
+                        lStealCount = std::max(lStealCount, std::min(lRoundTripSubtasks, pAvailableSubtasks / 2));
+                }
             }
         }
     }
@@ -830,7 +842,7 @@ ulong pmExecutionStub::GetStealCount(pmTask* pTask, const pmProcessingElement* p
     return lStealCount;
 }
 
-void pmExecutionStub::StealSubtasks(pmTask* pTask, const pmProcessingElement* pRequestingDevice, double pRequestingDeviceExecutionRate, bool pShouldMultiAssign)
+void pmExecutionStub::StealSubtasks(pmTask* pTask, const pmProcessingElement* pRequestingDevice, double pRequestingDeviceExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign)
 {
     bool lStealSuccess = false;
     ushort lPriority = pTask->GetPriority();
@@ -840,7 +852,7 @@ void pmExecutionStub::StealSubtasks(pmTask* pTask, const pmProcessingElement* pR
     // There could be multiple SUBTASK_EXEC events for the task in the stub's queue but we steal only
     // from the last entry. In case, there is no such entry, we multi-assign.
     std::shared_ptr<stubEvent> lTaskEvent;
-    bool lFound = (DeleteAndGetFirstMatchingCommand(lPriority, execEventMatchFunc, pTask, lTaskEvent) == pmSuccess);
+    bool lFound = (DeleteAndGetFirstMatchingCommand(lPriority, execEventMatchFunc, pTask, lTaskEvent, false, pTask) == pmSuccess);
     
     FINALIZE_RESOURCE_PTR(dCurrentSubtaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCurrentSubtaskRangeLock, Lock(), Unlock());
 
@@ -854,7 +866,7 @@ void pmExecutionStub::StealSubtasks(pmTask* pTask, const pmProcessingElement* pR
         if(!pTask->IsMultiAssignEnabled() || lExecEvent.range.originalAllottee == NULL)
         {
             ulong lAvailableSubtasks = ((lExecEvent.rangeExecutedOnce) ? (lExecEvent.range.endSubtask - lExecEvent.lastExecutedSubtaskId) : (lExecEvent.range.endSubtask - lExecEvent.range.startSubtask + 1));
-            ulong lStealCount = GetStealCount(pTask, pRequestingDevice, lAvailableSubtasks, lLocalRate, pRequestingDeviceExecutionRate);
+            ulong lStealCount = GetStealCount(pTask, pRequestingDevice, lAvailableSubtasks, lLocalRate, pRequestingDeviceExecutionRate, pStealRoundTripTime);
             
             if(lStealCount)
             {
@@ -981,7 +993,7 @@ void pmExecutionStub::StealSubtasks(pmTask* pTask, const pmProcessingElement* pR
         EXCEPTION_ASSERT(!mCurrentSubtaskRangeStats->splitData.valid);
     #endif
         
-        ulong lStealCount = GetStealCount(pTask, pRequestingDevice, lPendingExecutions, lLocalRate, pRequestingDeviceExecutionRate);
+        ulong lStealCount = GetStealCount(pTask, pRequestingDevice, lPendingExecutions, lLocalRate, pRequestingDeviceExecutionRate, pStealRoundTripTime);
         
         if(lStealCount)
         {
@@ -1874,7 +1886,7 @@ void pmExecutionStub::SendSplitAcknowledgement(const pmSubtaskRange& pRange, con
         pmScheduler::GetScheduler()->SendAcknowledgement(GetProcessingElement(), pRange, pExecStatus, std::move(lOwnershipVector), std::move(lAddressSpaceIndexVector), pTotalSplitCount);
 
     // A steal request is generated only if there is no more pending subtask in the stub queue
-	if(pmScheduler::SchedulingModelSupportsStealing(pRange.task->GetSchedulingModel()) && !HasMatchingCommand(pRange.task->GetPriority(), execEventMatchFunc, pRange.task))
+	if(pmScheduler::SchedulingModelSupportsStealing(pRange.task->GetSchedulingModel()) && !HasMatchingCommand(pRange.task->GetPriority(), execEventMatchFunc, pRange.task, pRange.task))
         IssueStealRequestIfRequired(pRange.task);
 }
 
@@ -2159,6 +2171,13 @@ bool pmExecutionStub::RequiresPrematureExit()
     return mCurrentSubtaskRangeStats->prematureTermination;
 }
 
+pmTask* pmExecutionStub::GetCurrentTask()
+{
+    FINALIZE_RESOURCE_PTR(dCurrentSubtaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCurrentSubtaskRangeLock, Lock(), Unlock());
+
+    return (mCurrentSubtaskRangeStats ? mCurrentSubtaskRangeStats->task : NULL);
+}
+
 bool pmExecutionStub::IsHighPriorityEventWaiting(ushort pPriority)
 {
 	return GetPriorityQueue().IsHighPriorityElementPresent(pPriority);
@@ -2174,9 +2193,9 @@ ulong pmExecutionStub::ExecuteWrapper(const pmSubtaskRange& pCurrentRange, const
     ulong lEndSubtask = std::numeric_limits<ulong>::max();
     ulong lCleanupEndSubtask = lEndSubtask;
 
-    ulong* lPrefetchSubtaskIdPtr = NULL;
+    const pmSubtaskRange* lPrefetchRangePtr = NULL;
 #ifdef SUPPORT_COMPUTE_COMMUNICATION_OVERLAP
-    ulong lPrefetchSubtaskId = std::numeric_limits<ulong>::max();
+    pmSubtaskRange lPrefetchRange(pCurrentRange.task, NULL, std::numeric_limits<ulong>::max(), std::numeric_limits<ulong>::max());
 #endif
     
     const pmSubtaskRange& lParentRange = pEvent.range;
@@ -2356,12 +2375,14 @@ ulong pmExecutionStub::ExecuteWrapper(const pmSubtaskRange& pCurrentRange, const
         #ifdef SUPPORT_COMPUTE_COMMUNICATION_OVERLAP
             if(pCurrentRange.task->ShouldOverlapComputeCommunication() && lSubtaskId != lParentRange.endSubtask)
             {
-                lPrefetchSubtaskIdPtr = &lPrefetchSubtaskId;
-                lPrefetchSubtaskId = lSubtaskId + 1;
+                // Subtasks after the current one, which are still queued on this stub, may be prefetched
+                lPrefetchRangePtr = &lPrefetchRange;
+                lPrefetchRange.startSubtask = lSubtaskId + 1;
+                lPrefetchRange.endSubtask = lParentRange.endSubtask;
             }
             else
             {
-                lPrefetchSubtaskIdPtr = NULL;
+                lPrefetchRangePtr = NULL;
             }
         #endif
             
@@ -2370,7 +2391,7 @@ ulong pmExecutionStub::ExecuteWrapper(const pmSubtaskRange& pCurrentRange, const
         #ifdef BREAK_PIPELINE_ON_RESOURCE_EXHAUSTION
             try
             {
-                Execute(pCurrentRange.task, lSubtaskId, pIsMultiAssign, lPrefetchSubtaskIdPtr, NULL);
+                Execute(pCurrentRange.task, lSubtaskId, pIsMultiAssign, lPrefetchRangePtr, NULL);
             }
             catch(pmOutOfMemoryException&)
             {
@@ -2404,7 +2425,7 @@ ulong pmExecutionStub::ExecuteWrapper(const pmSubtaskRange& pCurrentRange, const
             {
                 try
                 {
-                    Execute(pCurrentRange.task, lSubtaskId, pIsMultiAssign, lPrefetchSubtaskIdPtr, NULL);
+                    Execute(pCurrentRange.task, lSubtaskId, pIsMultiAssign, lPrefetchRangePtr, NULL);
                     break;
                 }
                 catch(pmOutOfMemoryException&)
@@ -2435,7 +2456,7 @@ ulong pmExecutionStub::ExecuteWrapper(const pmSubtaskRange& pCurrentRange, const
             BlockSecondaryCommands();
 
             std::shared_ptr<stubEvent> lNextTaskEvent;
-            bool lFound = (DeleteAndGetFirstMatchingCommand(lParentRange.task->GetPriority(), execEventMatchFunc, lParentRange.task, lNextTaskEvent, true) == pmSuccess);
+            bool lFound = (DeleteAndGetFirstMatchingCommand(lParentRange.task->GetPriority(), execEventMatchFunc, lParentRange.task, lNextTaskEvent, true, lParentRange.task) == pmSuccess);
 
             if(lFound)
             {
@@ -2475,15 +2496,23 @@ void pmExecutionStub::CommonPreExecuteOnCPU(pmTask* pTask, ulong pSubtaskId, boo
     
     if(pPrefetch)
     {
-#ifndef BLOCK_PREFETCH_OF_ANTICIPATED_SUBTASKS
     #ifdef SUPPORT_SPLIT_SUBTASKS
         if(!pSplitInfo || pSplitInfo->splitId == 0)
     #endif
         {
             lSubscriptionManager.FindSubtaskMemDependencies(this, pSubtaskId, NULL);
             lSubscriptionManager.FetchSubtaskSubscriptions(this, pSubtaskId, NULL, GetType(), pPrefetch);
+
+            // Shadow memory of write only address spaces has no initial contents, so it need not wait for the fetch to complete
+            if(GetType() == CPU)
+            {
+                for_each_with_index(pTask->GetAddressSpaces(), [&] (const pmAddressSpace* pAddressSpace, size_t pAddressSpaceIndex)
+                {
+                    if(pTask->IsWriteOnly(pAddressSpace) && pTask->DoSubtasksNeedShadowMemory(pAddressSpace) && !lSubscriptionManager.GetSubtaskShadowMem(this, pSubtaskId, NULL, (uint)pAddressSpaceIndex))
+                        lSubscriptionManager.CreateSubtaskShadowMem(this, pSubtaskId, NULL, (uint)pAddressSpaceIndex);
+                });
+            }
         }
-#endif
     }
     else
     {
@@ -2495,7 +2524,11 @@ void pmExecutionStub::CommonPreExecuteOnCPU(pmTask* pTask, ulong pSubtaskId, boo
             if(pTask->IsWritable(pAddressSpace))
             {
                 if(pTask->DoSubtasksNeedShadowMemory(pAddressSpace) || (pTask->IsMultiAssignEnabled() && pIsMultiAssign))
-                    lSubscriptionManager.CreateSubtaskShadowMem(this, pSubtaskId, pSplitInfo, (uint)pAddressSpaceIndex);
+                {
+                    // The shadow memory may have already been created while prefetching the subtask
+                    if(!lSubscriptionManager.GetSubtaskShadowMem(this, pSubtaskId, pSplitInfo, (uint)pAddressSpaceIndex))
+                        lSubscriptionManager.CreateSubtaskShadowMem(this, pSubtaskId, pSplitInfo, (uint)pAddressSpaceIndex);
+                }
             }
         });
 
@@ -2548,6 +2581,8 @@ void pmExecutionStub::DoSubtaskReduction(pmTask* pTask, ulong pSubtaskId1, pmSpl
     pmEventTimelineAutoPtr lEventTimelineAutoPtr(pTask, mEventTimelineAutoPtr.get(), pSubtaskId1, pSplitInfo1, GetProcessingElement()->GetGlobalDeviceIndex(), lStream.str().c_str());
 #endif
 
+    pmTraceScope lTraceScope(tracer::SUBTASK_REDUCTION, pTask, pSubtaskId1);
+
     TLS_IMPLEMENTATION_CLASS::GetTls()->SetThreadLocalStorage(TLS_CURRENT_SUBTASK_ID, &pSubtaskId1);
 	pmStatus lStatus = pTask->GetCallbackUnit()->GetDataReductionCB()->Invoke(pTask, this, pSubtaskId1, pSplitInfo1, true, pStub2, pSubtaskId2, pSplitInfo2, true);
     TLS_IMPLEMENTATION_CLASS::GetTls()->SetThreadLocalStorage(TLS_CURRENT_SUBTASK_ID, NULL);
@@ -2626,7 +2661,7 @@ void pmExecutionStub::SetOpenCLDevice(void* pOpenCLDevice)
 }
 #endif
 
-void pmExecutionStub::WaitForNetworkFetch(const std::vector<pmCommandPtr>& pNetworkCommands)
+void pmExecutionStub::WaitForNetworkFetch(const std::vector<pmCommandPtr>& pNetworkCommands, bool pLazyFault /* = false */)
 {
     if(pNetworkCommands.empty())
         return;
@@ -2662,9 +2697,22 @@ void pmExecutionStub::WaitForNetworkFetch(const std::vector<pmCommandPtr>& pNetw
 #endif
     
 #ifdef DUMP_EVENT_TIMELINE
-    pmEventTimelineAutoPtr lEventTimelineAutoPtr(lTask, mEventTimelineAutoPtr.get(), lSubtaskId, *lSplitDataPtr.get(), GetProcessingElement()->GetGlobalDeviceIndex(), "WaitOnNetwork");
+    std::unique_ptr<pmEventTimelineAutoPtr> lEventTimelineAutoPtr(pLazyFault ? NULL : new pmEventTimelineAutoPtr(lTask, mEventTimelineAutoPtr.get(), lSubtaskId, *lSplitDataPtr.get(), GetProcessingElement()->GetGlobalDeviceIndex(), "WaitOnNetwork"));
 #endif
 
+    pmTask* lTracedTask = NULL;
+    ulong lTracedSubtaskId = 0;
+
+    if(pmTracer::IsEnabled())
+    {
+        FINALIZE_RESOURCE_PTR(dCurrentSubtaskLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCurrentSubtaskRangeLock, Lock(), Unlock());
+
+        lTracedTask = mCurrentSubtaskRangeStats->task;
+        lTracedSubtaskId = mCurrentSubtaskRangeStats->currentSubtaskId;
+    }
+
+    pmTraceScope lTraceScope(tracer::WAIT_ON_NETWORK, lTracedTask, lTracedSubtaskId);
+
     pmCommandPtr lAccumulatorCommand = pmAccumulatorCommand::CreateSharedPtr(pNetworkCommands);
 
     guarded_ptr<RESOURCE_LOCK_IMPLEMENTATION_CLASS, pmCommandPtr> lGuardedPtr(&mCurrentSubtaskRangeLock, &(mCurrentSubtaskRangeStats->accumulatorCommandPtr), &lAccumulatorCommand);
@@ -2718,6 +2766,9 @@ void pmExecutionStub::currentSubtaskRangeStats::ResetEndSubtaskId(ulong pEndSubt
 pmStubCPU::pmStubCPU(size_t pCoreId, uint pDeviceIndexOnMachine)
 	: pmExecutionStub(pDeviceIndexOnMachine)
     , mCoreId(pCoreId)
+    , mPrefetchTaskOriginatingHost(NULL)
+    , mPrefetchTaskSequenceNumber(0)
+    , mPrefetchedUptoSubtask(0)
 {
 }
 
@@ -2729,6 +2780,10 @@ void pmStubCPU::BindToProcessingElement()
 {
 #ifdef BIND_PROCESSING_ELEMENTS_TO_CPU_CORES
 	 SetProcessorAffinity((int)mCoreId);
+#else
+    static const char* lVal = getenv("PMLIB_BIND_CPU_STUBS_TO_CORES");
+    if(lVal && atoi(lVal) != 0)
+        SetProcessorAffinity((int)mCoreId);
 #endif
 }
 
@@ -2759,12 +2814,115 @@ ulong pmStubCPU::FindCollectivelyExecutableSubtaskRangeEnd(const pmSubtaskRange&
     return pSubtaskRange.startSubtask;
 }
 
-void pmStubCPU::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ulong* pPreftechSubtaskIdPtr, pmSplitInfo* pSplitInfo /* = NULL */)
+ulong pmStubCPU::GetSubtaskPrefetchDepth()
+{
+    static ulong lDepth = [] ()
+    {
+        ulong lValue = DEFAULT_CPU_SUBTASK_PREFETCH_DEPTH;
+
+        const char* lVal = getenv("PMLIB_CPU_SUBTASK_PREFETCH_DEPTH");
+        if(lVal && *lVal)
+            lValue = (ulong)atoi(lVal);
+        
+        return lValue;
+    }();
+    
+    return lDepth;
+}
+
+/* Keeps up to GetSubtaskPrefetchDepth() subtasks after the executing one fetched (and their write only shadow memory created).
+ * As the window slides by one subtask per execution, normally only its last subtask is newly prefetched.
+ */
+void pmStubCPU::PrefetchSubtasks(const pmSubtaskRange& pPrefetchRange, bool pIsMultiAssign)
+{
+    ulong lDepth = GetSubtaskPrefetchDepth();
+    if(!lDepth || pPrefetchRange.startSubtask > pPrefetchRange.endSubtask)
+        return;
+
+    ulong lStartSubtask = pPrefetchRange.startSubtask;
+    ulong lEndSubtask = std::min(pPrefetchRange.endSubtask, pPrefetchRange.startSubtask + lDepth - 1);
+
+    bool lSameTask = IsPrefetchTask(pPrefetchRange.task);
+
+    if(lSameTask && mPrefetchedUptoSubtask >= lStartSubtask && mPrefetchedUptoSubtask <= lEndSubtask)
+        lStartSubtask = mPrefetchedUptoSubtask + 1;
+
+    // Subtasks prefetched for an earlier task are released by that task's subscription manager when it finishes
+    if(!lSameTask)
+        mPrefetchedSubtasks.clear();
+
+    for(ulong lSubtaskId = lStartSubtask; lSubtaskId <= lEndSubtask; ++lSubtaskId)
+    {
+        CommonPreExecuteOnCPU(pPrefetchRange.task, lSubtaskId, pIsMultiAssign, true, NULL);
+        mPrefetchedSubtasks.insert(lSubtaskId);
+    }
+    
+    if(lStartSubtask <= lEndSubtask)
+        pPrefetchRange.task->GetTaskExecStats().RecordSubtasksPrefetched(this, lEndSubtask - lStartSubtask + 1);
+
+    mPrefetchTaskOriginatingHost = pPrefetchRange.task->GetOriginatingHost();
+    mPrefetchTaskSequenceNumber = pPrefetchRange.task->GetSequenceNumber();
+    mPrefetchedUptoSubtask = lEndSubtask;
+}
+
+bool pmStubCPU::IsPrefetchTask(pmTask* pTask) const
 {
+    return (mPrefetchTaskOriginatingHost == pTask->GetOriginatingHost() && mPrefetchTaskSequenceNumber == pTask->GetSequenceNumber());
+}
+
+/* Drops the subscriptions and shadow memory of prefetched subtasks in [pFirstSubtaskId, pLastSubtaskId] which this stub is not going to execute.
+ * A released subtask that still comes back to this stub (e.g. as a multi assign) is simply fetched again.
+ */
+void pmStubCPU::ReleasePrefetchedSubtasks(pmTask* pTask, ulong pFirstSubtaskId, ulong pLastSubtaskId)
+{
+    if(!IsPrefetchTask(pTask) || pFirstSubtaskId > pLastSubtaskId)
+        return;
+
+    auto lBeginIter = mPrefetchedSubtasks.lower_bound(pFirstSubtaskId);
+    auto lEndIter = mPrefetchedSubtasks.upper_bound(pLastSubtaskId);
+    
+    if(lBeginIter == lEndIter)
+        return;
+
+    pmSubscriptionManager& lSubscriptionManager = pTask->GetSubscriptionManager();
+
+    std::for_each(lBeginIter, lEndIter, [&] (ulong pSubtaskId)
+    {
+        if(!lSubscriptionManager.HasSubtask(this, pSubtaskId, NULL))
+            return;
+
+        for_each_with_index(pTask->GetAddressSpaces(), [&] (const pmAddressSpace* pAddressSpace, size_t pAddressSpaceIndex)
+        {
+            if(lSubscriptionManager.GetSubtaskShadowMem(this, pSubtaskId, NULL, (uint)pAddressSpaceIndex))
+                lSubscriptionManager.DestroySubtaskShadowMem(this, pSubtaskId, NULL, (uint)pAddressSpaceIndex);
+        });
+
+        lSubscriptionManager.EraseSubtask(this, pSubtaskId, NULL);
+    });
+
+    pTask->GetTaskExecStats().RecordPrefetchedSubtasksReleased(this, (ulong)std::distance(lBeginIter, lEndIter));
+
+    mPrefetchedSubtasks.erase(lBeginIter, lEndIter);
+    
+    // Let the prefetch window fetch the released subtasks again, if they ever come back to this stub
+    if(pFirstSubtaskId <= mPrefetchedUptoSubtask && mPrefetchedUptoSubtask <= pLastSubtaskId)
+        mPrefetchedUptoSubtask = (pFirstSubtaskId ? pFirstSubtaskId - 1 : 0);
+}
+
+void pmStubCPU::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, const pmSubtaskRange* pPrefetchRange, pmSplitInfo* pSplitInfo /* = NULL */)
+{
+    if(!pSplitInfo && IsPrefetchTask(pTask))
+    {
+        mPrefetchedSubtasks.erase(pSubtaskId);
+
+        // The prefetch window never crosses the end of the queued range, so subtasks prefetched beyond it have been stolen from its tail
+        ReleasePrefetchedSubtasks(pTask, (pPrefetchRange ? pPrefetchRange->endSubtask : pSubtaskId) + 1, std::numeric_limits<ulong>::max());
+    }
+
 	CommonPreExecuteOnCPU(pTask, pSubtaskId, pIsMultiAssign, false, pSplitInfo);
 
-    if(pPreftechSubtaskIdPtr)
-        CommonPreExecuteOnCPU(pTask, *pPreftechSubtaskIdPtr, pIsMultiAssign, true, NULL);
+    if(pPrefetchRange)
+        PrefetchSubtasks(*pPrefetchRange, pIsMultiAssign);
     
     // Unless required for an address space, no shadow memory is created. In case user has asked for Compact subscription view, we need to create shadow mem
     pmSubscriptionManager& lSubscriptionManager = pTask->GetSubscriptionManager();
@@ -2783,6 +2941,8 @@ void pmStubCPU::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ul
     pmEventTimelineAutoPtr lEventTimelineAutoPtr(pTask, mEventTimelineAutoPtr.get(), pSubtaskId, pSplitInfo, GetProcessingElement()->GetGlobalDeviceIndex(), "SubtaskExecution");
 #endif
 
+    pmTraceScope lTraceScope(tracer::SUBTASK_EXECUTION, pTask, pSubtaskId);
+
 	INVOKE_SAFE_THROW_ON_FAILURE(pmSubtaskCB, pTask->GetCallbackUnit()->GetSubtaskCB(), Invoke, this, pTask, pSplitInfo, pIsMultiAssign, pTask->GetTaskInfo(), lSubtaskInfo);
 }
 
@@ -2790,8 +2950,18 @@ void pmStubCPU::WaitForSubtaskExecutionToFinish(pmTask* pTask, ulong pSubtaskId,
 {
 }
     
+/* Prefetched subtasks of the range which did not get executed here (stolen, negotiated away or cancelled) are released. Prefetched
+ * subtasks beyond the range are still queued on this stub (those stolen from the queue are released by the next Execute).
+ */
 void pmStubCPU::CleanupPostSubtaskRangeExecution(pmTask* pTask, ulong pStartSubtaskId, ulong pEndSubtaskId, ulong pCleanupEndSubtaskId, pmSplitInfo* pSplitInfo)
 {
+    DEBUG_EXCEPTION_ASSERT(pCleanupEndSubtaskId >= pEndSubtaskId);
+
+    if(pSplitInfo)
+        return;
+
+    if(pEndSubtaskId != std::numeric_limits<ulong>::max())
+        ReleasePrefetchedSubtasks(pTask, pEndSubtaskId + 1, pCleanupEndSubtaskId);
 }
     
 // This method must be called with mCurrentSubtaskRangeLock (of pmExecutionStub) acquired
@@ -3260,7 +3430,7 @@ ulong pmStubCUDA::FindCollectivelyExecutableSubtaskRangeEnd(const pmSubtaskRange
 #endif
 }
 
-void pmStubCUDA::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, ulong* pPreftechSubtaskIdPtr, pmSplitInfo* pSplitInfo /* = NULL */)
+void pmStubCUDA::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, const pmSubtaskRange* pPrefetchRange, pmSplitInfo* pSplitInfo /* = NULL */)
 {
 #ifdef PRE_DETERMINE_MAX_COLLECTIVELY_EXECUTABLE_CUDA_SUBTASKS
 #else
@@ -3271,8 +3441,10 @@ void pmStubCUDA::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, u
 
 	CommonPreExecuteOnCPU(pTask, pSubtaskId, pIsMultiAssign, false, pSplitInfo);
 
-    if(pPreftechSubtaskIdPtr)
-        CommonPreExecuteOnCPU(pTask, *pPreftechSubtaskIdPtr, pIsMultiAssign, true, NULL);
+#ifndef BLOCK_PREFETCH_OF_ANTICIPATED_SUBTASKS
+    if(pPrefetchRange)
+        CommonPreExecuteOnCPU(pTask, pPrefetchRange->startSubtask, pIsMultiAssign, true, NULL);
+#endif
 
     // Unless required for an address space, no shadow memory is created. In case user has asked for Compact subscription view and task has redistribution, we need to create shadow mem
     if(pTask->GetCallbackUnit()->GetDataRedistributionCB())
@@ -3310,6 +3482,8 @@ void pmStubCUDA::Execute(pmTask* pTask, ulong pSubtaskId, bool pIsMultiAssign, u
     pmEventTimelineAutoPtr lEventTimelineAutoPtr(pTask, mEventTimelineAutoPtr.get(), pSubtaskId, pSplitInfo, GetProcessingElement()->GetGlobalDeviceIndex(), "SubtaskExecution");
 #endif
 
+    pmTraceScope lTraceScope(tracer::SUBTASK_EXECUTION, pTask, pSubtaskId);
+
     pmReductionDataType lReductionDataType = MAX_REDUCTION_DATA_TYPES;
     size_t lCompressedLength = 0;
 
@@ -4171,6 +4345,26 @@ bool execStub::stubEvent::BlocksSecondaryOperations()
     return (eventId == SUBTASK_EXEC);
 }
 
+// Every event matched by execEventMatchFunc, execEventRangeMatchFunc or splitSubtaskCheckEventMatchFunc must be indexed by its task
+const void* execStub::stubEvent::GetIndexKey() const
+{
+    switch(eventId)
+    {
+        case SUBTASK_EXEC:
+            return static_cast<const subtaskExecEvent*>(this)->range.task;
+
+    #ifdef SUPPORT_SPLIT_SUBTASKS
+        case SPLIT_SUBTASK_CHECK:
+            return static_cast<const splitSubtaskCheckEvent*>(this)->task;
+    #endif
+
+        default:
+            return NULL;
+    }
+    
+    return NULL;
+}
+
 
 /* struct subtaskExecEvent */
 #ifdef USE_STEAL_AGENT_PER_NODE
@@ -0,0 +1,181 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmFlatMap.h"
+
+namespace pm
+{
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::iterator pmFlatMap<keyType, valueType>::begin()
+{
+    return mElements.begin();
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::iterator pmFlatMap<keyType, valueType>::end()
+{
+    return mElements.end();
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::const_iterator pmFlatMap<keyType, valueType>::begin() const
+{
+    return mElements.begin();
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::const_iterator pmFlatMap<keyType, valueType>::end() const
+{
+    return mElements.end();
+}
+
+template<typename keyType, typename valueType>
+bool pmFlatMap<keyType, valueType>::empty() const
+{
+    return mElements.empty();
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::size_type pmFlatMap<keyType, valueType>::size() const
+{
+    return mElements.size();
+}
+
+template<typename keyType, typename valueType>
+void pmFlatMap<keyType, valueType>::clear()
+{
+    mElements.clear();
+}
+
+template<typename keyType, typename valueType>
+void pmFlatMap<keyType, valueType>::reserve(size_type pCount)
+{
+    mElements.reserve(pCount);
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::iterator pmFlatMap<keyType, valueType>::find(const keyType& pKey)
+{
+    iterator lIter = lower_bound(pKey);
+
+    if(lIter != mElements.end() && !(pKey < lIter->first))
+        return lIter;
+
+    return mElements.end();
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::const_iterator pmFlatMap<keyType, valueType>::find(const keyType& pKey) const
+{
+    const_iterator lIter = lower_bound(pKey);
+
+    if(lIter != mElements.end() && !(pKey < lIter->first))
+        return lIter;
+
+    return mElements.end();
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::iterator pmFlatMap<keyType, valueType>::lower_bound(const keyType& pKey)
+{
+    return std::lower_bound(mElements.begin(), mElements.end(), pKey, [] (const value_type& pElem, const keyType& pSearchKey)
+    {
+        return (pElem.first < pSearchKey);
+    });
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::const_iterator pmFlatMap<keyType, valueType>::lower_bound(const keyType& pKey) const
+{
+    return std::lower_bound(mElements.begin(), mElements.end(), pKey, [] (const value_type& pElem, const keyType& pSearchKey)
+    {
+        return (pElem.first < pSearchKey);
+    });
+}
+
+template<typename keyType, typename valueType>
+valueType& pmFlatMap<keyType, valueType>::operator[](const keyType& pKey)
+{
+    // Fast path for keys arriving in increasing order
+    if(mElements.empty() || mElements.back().first < pKey)
+    {
+        mElements.emplace_back(pKey, valueType());
+        return mElements.back().second;
+    }
+
+    iterator lIter = lower_bound(pKey);
+    if(pKey < lIter->first)
+        lIter = mElements.emplace(lIter, pKey, valueType());
+
+    return lIter->second;
+}
+
+template<typename keyType, typename valueType>
+template<typename inputIterator>
+void pmFlatMap<keyType, valueType>::insert(inputIterator pFirst, inputIterator pLast)
+{
+    size_type lExistingCount = mElements.size();
+
+    mElements.insert(mElements.end(), pFirst, pLast);
+
+    iterator lMiddleIter = mElements.begin() + lExistingCount;
+    if(!std::is_sorted(lMiddleIter, mElements.end(), KeyLess))
+        std::stable_sort(lMiddleIter, mElements.end(), KeyLess);
+
+    if(lExistingCount && lMiddleIter != mElements.end() && !KeyLess(*(lMiddleIter - 1), *lMiddleIter))
+        std::inplace_merge(mElements.begin(), lMiddleIter, mElements.end(), KeyLess);
+
+    // Stability of the sort and merge keeps the existing (or first inserted) element foremost among equal keys
+    mElements.erase(std::unique(mElements.begin(), mElements.end(), KeyEqual), mElements.end());
+}
+
+template<typename keyType, typename valueType>
+typename pmFlatMap<keyType, valueType>::iterator pmFlatMap<keyType, valueType>::erase(iterator pIter)
+{
+    return mElements.erase(pIter);
+}
+
+template<typename keyType, typename valueType>
+bool pmFlatMap<keyType, valueType>::KeyLess(const value_type& pElem1, const value_type& pElem2)
+{
+    return (pElem1.first < pElem2.first);
+}
+
+template<typename keyType, typename valueType>
+bool pmFlatMap<keyType, valueType>::KeyEqual(const value_type& pElem1, const value_type& pElem2)
+{
+    return !(pElem1.first < pElem2.first) && !(pElem2.first < pElem1.first);
+}
+
+}
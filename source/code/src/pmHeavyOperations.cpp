@@ -44,9 +44,16 @@
 #include "pmTask.h"
 #include "pmTaskManager.h"
 #include "pmCallbackUnit.h"
+#include "pmReducer.h"
+#include "pmNetworkCompression.h"
+#include "pmTracer.h"
 
 #include <memory>
 
+#ifdef DUMP_HEAVY_OPERATIONS_STATS
+#include <sstream>
+#endif
+
 namespace pm
 {
     
@@ -82,6 +89,11 @@ void __dump_mem_transfer(const pmAddressSpace* addressSpace, const memoryIdentif
 #define MEM_FORWARD_DUMP(addressSpace, identifier, receiverOffset, offset, length, step, count, host, newHost, newIdentifier, newOffset)
 #endif
 
+static inline ulong GetAddressSpaceAffinityKey(uint pMemOwnerHost, ulong pGenerationNumber)
+{
+    return (((ulong)pMemOwnerHost << 48) ^ pGenerationNumber);
+}
+
 void HeavyOperationsCommandCompletionCallback(const pmCommandPtr& pCommand)
 {
 	pmHeavyOperationsThreadPool* lHeavyOperationsThreadPool = pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool();
@@ -101,11 +113,12 @@ void MemoryMetaDataReceiveCommandCompletionCallback(const pmCommandPtr& pCommand
     memoryReceiveStruct* lReceiveStruct = (memoryReceiveStruct*)(lCommunicatorCommand->GetData());
     pmAddressSpace* lAddressSpace = pmAddressSpace::FindAddressSpace(pmMachinePool::GetMachinePool()->GetMachine(lReceiveStruct->memOwnerHost), lReceiveStruct->generationNumber);
 
+    communicator::communicatorCommandTags lTag = (communicator::communicatorCommandTags)lReceiveStruct->mpiTag;
+    const pmMachine* lSendingMachine = pmMachinePool::GetMachinePool()->GetMachine(lReceiveStruct->senderHost);
+    finalize_ptr<memoryReceiveStruct> lMemoryReceiveData(new memoryReceiveStruct(*lReceiveStruct));
+
     if(lAddressSpace)		// If memory still exists
     {
-        communicator::communicatorCommandTags lTag = (communicator::communicatorCommandTags)lReceiveStruct->mpiTag;
-        const pmMachine* lSendingMachine = pmMachinePool::GetMachinePool()->GetMachine(lReceiveStruct->senderHost);
-        
         pmTask* lRequestingTask = NULL;
         if(lReceiveStruct->isTaskOriginated)
         {
@@ -113,17 +126,33 @@ void MemoryMetaDataReceiveCommandCompletionCallback(const pmCommandPtr& pCommand
             lRequestingTask = pmTaskManager::GetTaskManager()->FindTaskNoThrow(lOriginatingHost, lReceiveStruct->sequenceNumber);
         }
 
-        if(!lReceiveStruct->isTaskOriginated || (lRequestingTask && lAddressSpace->GetLockingTask() == lRequestingTask))
+        if(!lReceiveStruct->isTaskOriginated || (lRequestingTask && lAddressSpace->IsLockedBy(lRequestingTask)))
         {
             char* lBaseAddr = (char*)(lAddressSpace->GetMem()) + lReceiveStruct->offset;
 
-            finalize_ptr<memoryReceiveStruct> lMemoryReceiveData(new memoryReceiveStruct(*lReceiveStruct));
-
             pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<memoryReceiveStruct>::CreateSharedPtr(lCommunicatorCommand->GetPriority(), RECEIVE, lTag, lSendingMachine, BYTE, lMemoryReceiveData, 1, HeavyOperationsCommandCompletionCallback, static_cast<void*>(lBaseAddr));
 
+            if(lReceiveStruct->codec != networkCompression::CODEC_NONE)
+                lCommand->HoldExternalDataForLifetimeOfCommand(std::shared_ptr<char>(new char[lReceiveStruct->compressedLength], std::default_delete<char[]>()));
+
             pmCommunicator::GetCommunicator()->ReceiveMemory(lCommand, false);
+            return;
         }
     }
+
+    /* The memory (or the task that requested it) is gone. The data is still received (and discarded) as large transfers do not
+     * complete on the sender until a matching receive is posted here (and the sender waits for all its sends to finish at shutdown).
+     */
+    size_t lDiscardLength = lReceiveStruct->compressedLength;
+    if(lReceiveStruct->codec == networkCompression::CODEC_NONE)
+        lDiscardLength = ((lReceiveStruct->transferType == TRANSFER_GENERAL) ? lReceiveStruct->length : lReceiveStruct->count * lReceiveStruct->step);
+
+    std::shared_ptr<char> lDiscardMem(new char[lDiscardLength], std::default_delete<char[]>());
+
+    pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<memoryReceiveStruct>::CreateSharedPtr(lCommunicatorCommand->GetPriority(), RECEIVE, lTag, lSendingMachine, BYTE, lMemoryReceiveData, 1, NULL, static_cast<void*>(lDiscardMem.get()));
+    lCommand->HoldExternalDataForLifetimeOfCommand(lDiscardMem);
+
+    pmCommunicator::GetCommunicator()->ReceiveMemory(lCommand, false);
 }
     
 pmCommandCompletionCallbackType pmHeavyOperationsThreadPool::GetHeavyOperationsCommandCompletionCallback()
@@ -133,12 +162,28 @@ pmCommandCompletionCallbackType pmHeavyOperationsThreadPool::GetHeavyOperationsC
 
 pmHeavyOperationsThreadPool* pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()
 {
-	static pmHeavyOperationsThreadPool lHeavyOperationsThreadPool(1);   //std::max<size_t>(1, pmStubManager::GetStubManager()->GetProcessingElementsCPU() / 2))
+	static pmHeavyOperationsThreadPool lHeavyOperationsThreadPool([] () -> size_t
+    {
+        size_t lThreadCount = DEFAULT_HEAVY_OPERATIONS_THREADS;
+
+        const char* lVal = getenv("PMLIB_HEAVY_OPERATIONS_THREADS");
+        if(lVal)
+        {
+            size_t lValue = (size_t)atoi(lVal);
+
+            if(lValue != 0)
+                lThreadCount = lValue;
+        }
+
+        return lThreadCount;
+    }());
+
     return &lHeavyOperationsThreadPool;
 }
 
 pmHeavyOperationsThreadPool::pmHeavyOperationsThreadPool(size_t pThreadCount)
-    : mCurrentThread(0)
+    : mOutstandingEvents(pThreadCount, 0)
+    , mCurrentThread(0)
     , mResourceLock __LOCK_NAME__("pmHeavyOperationsThreadPool::mResourceLock")
 {
     EXCEPTION_ASSERT(pThreadCount != 0);
@@ -156,6 +201,10 @@ pmHeavyOperationsThreadPool::pmHeavyOperationsThreadPool(size_t pThreadCount)
 
 pmHeavyOperationsThreadPool::~pmHeavyOperationsThreadPool()
 {
+#ifdef DUMP_HEAVY_OPERATIONS_STATS
+    DumpThreadStatistics();
+#endif
+
     mThreadVector.clear();
 
 	NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->UnregisterTransferDataType(MEMORY_IDENTIFIER_STRUCT);
@@ -211,45 +260,85 @@ void pmHeavyOperationsThreadPool::DestroyPersistentCommunicationCommands()
 
 void pmHeavyOperationsThreadPool::QueueNetworkRequest(pmCommunicatorCommandPtr& pCommand, heavyOperations::networkRequestType pType)
 {
-    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new networkRequestEvent(NETWORK_REQUEST_EVENT, pCommand, pType)), pCommand->GetPriority());
+    // Requests to/from a peer are kept in order as MPI matches messages in the order they are posted
+    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new networkRequestEvent(NETWORK_REQUEST_EVENT, pCommand, pType)), pCommand->GetPriority(), ORDERED_BY_PEER, reinterpret_cast<ulong>(pCommand->GetDestination()));
 }
 
 void pmHeavyOperationsThreadPool::PackAndSendData(const pmCommunicatorCommandPtr& pCommand)
 {
-    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new packEvent(PACK_DATA, pCommand)), pCommand->GetPriority());
+    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new packEvent(PACK_DATA, pCommand)), pCommand->GetPriority(), ORDERED_BY_PEER, reinterpret_cast<ulong>(pCommand->GetDestination()));
 }
     
-void pmHeavyOperationsThreadPool::ReduceRequestEvent(pmExecutionStub* pReducingStub, pmTask* pTask, const pmMachine* pDestMachine, ulong pSubtaskId, pmSplitInfo* pSplitInfo)
+void pmHeavyOperationsThreadPool::ReduceRequestEvent(pmExecutionStub* pReducingStub, pmTask* pTask, const pmMachine* pDestMachine, ulong pSubtaskId, pmSplitInfo* pSplitInfo, const reducer::reductionSegment& pSegment /* = reducer::reductionSegment() */)
 {
     pmSplitData lSplitData(pSplitInfo);
 
-	SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new subtaskReduceEvent(SUBTASK_REDUCE, pTask, pDestMachine, pReducingStub, pSubtaskId, lSplitData)), pTask->GetPriority());
+	SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new subtaskReduceEvent(SUBTASK_REDUCE, pTask, pDestMachine, pReducingStub, pSubtaskId, lSplitData, pSegment)), pTask->GetPriority());
 }
     
-void pmHeavyOperationsThreadPool::UnpackDataEvent(finalize_ptr<char, deleteArrayDeallocator<char>>&& pPackedData, int pPackedLength, ushort pPriority)
+void pmHeavyOperationsThreadPool::UnpackDataEvent(finalize_ptr<char, deleteArrayDeallocator<char>>&& pPackedData, int pPackedLength, uint pSourceHost, ushort pPriority)
 {
-    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new unpackEvent(UNPACK_DATA, std::move(pPackedData), pPackedLength)), pPriority);
+    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new unpackEvent(UNPACK_DATA, std::move(pPackedData), pPackedLength)), pPriority, ORDERED_BY_SOURCE_HOST, pSourceHost);
 }
     
 void pmHeavyOperationsThreadPool::MemTransferEvent(memoryIdentifierStruct& pSrcMemIdentifier, memoryIdentifierStruct& pDestMemIdentifier, memoryTransferType pTransferType, ulong pOffset, ulong pLength, ulong pStep, ulong pCount, const pmMachine* pDestMachine, ulong pReceiverOffset, bool pIsForwarded, ushort pPriority, bool pIsTaskOriginated, uint pTaskOriginatingHost, ulong pTaskSequenceNumber)
 {
-    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new memTransferEvent(MEM_TRANSFER, pSrcMemIdentifier, pDestMemIdentifier, pTransferType, pOffset, pLength, pStep, pCount, pDestMachine, pReceiverOffset, pPriority, pIsForwarded, pIsTaskOriginated, pTaskOriginatingHost, pTaskSequenceNumber)), pPriority);
+    SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new memTransferEvent(MEM_TRANSFER, pSrcMemIdentifier, pDestMemIdentifier, pTransferType, pOffset, pLength, pStep, pCount, pDestMachine, pReceiverOffset, pPriority, pIsForwarded, pIsTaskOriginated, pTaskOriginatingHost, pTaskSequenceNumber)), pPriority, ADDRESS_SPACE_LOCALITY, GetAddressSpaceAffinityKey(pSrcMemIdentifier.memOwnerHost, pSrcMemIdentifier.generationNumber));
 }
 
 void pmHeavyOperationsThreadPool::CommandCompletionEvent(pmCommandPtr pCommand)
 {
-	SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new commandCompletionEvent(COMMAND_COMPLETION, pCommand)), pCommand->GetPriority());
+    dispatchAffinityType lAffinityType = NO_DISPATCH_AFFINITY;
+    ulong lAffinityKey = 0;
+
+	pmCommunicatorCommandPtr lCommunicatorCommand = std::dynamic_pointer_cast<pmCommunicatorCommandBase>(pCommand);
+    if(lCommunicatorCommand && lCommunicatorCommand->GetType() == RECEIVE)
+    {
+        switch(lCommunicatorCommand->GetTag())
+        {
+            case MEMORY_TRANSFER_REQUEST_TAG:
+            case SCATTERED_MEMORY_TRANSFER_REQUEST_COMBINED_TAG:
+            case MEMORY_RECEIVE_TAG:
+                break;
+
+            case FILE_OPERATIONS_TAG:
+                lAffinityType = ORDERED_FILE_OPERATIONS;
+                break;
+
+            default:
+            {
+                const memoryReceiveStruct* lReceiveStruct = static_cast<const memoryReceiveStruct*>(lCommunicatorCommand->GetData());
+                if(lReceiveStruct)
+                {
+                    lAffinityType = ADDRESS_SPACE_LOCALITY;
+                    lAffinityKey = GetAddressSpaceAffinityKey(lReceiveStruct->memOwnerHost, lReceiveStruct->generationNumber);
+                }
+
+                break;
+            }
+        }
+    }
+
+	SubmitToThreadPool(std::shared_ptr<heavyOperationsEvent>(new commandCompletionEvent(COMMAND_COMPLETION, pCommand)), pCommand->GetPriority(), lAffinityType, lAffinityKey);
 }
     
 void pmHeavyOperationsThreadPool::CancelMemoryTransferEvents(pmAddressSpace* pAddressSpace)
 {
     size_t lPoolSize = mThreadVector.size();
 
-    std::vector<std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>> lSignalWaitArray(lPoolSize, std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>(new SIGNAL_WAIT_IMPLEMENTATION_CLASS(true)));
-	SubmitToAllThreadsInPool(std::shared_ptr<heavyOperationsEvent>(new memTransferCancelEvent(MEM_TRANSFER_CANCEL, pAddressSpace, lSignalWaitArray[0].get())), MAX_CONTROL_PRIORITY);
+    std::vector<std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS>> lSignalWaitArray;
+    lSignalWaitArray.reserve(lPoolSize);
+
+    for(size_t i = 0; i < lPoolSize; ++i)
+        lSignalWaitArray.emplace_back(new SIGNAL_WAIT_IMPLEMENTATION_CLASS(true));
+
+	SubmitToAllThreadsInPool(std::shared_ptr<heavyOperationsEvent>(new memTransferCancelEvent(MEM_TRANSFER_CANCEL, pAddressSpace, lSignalWaitArray)), MAX_CONTROL_PRIORITY);
     
     for(size_t i = 0; i < lPoolSize; ++i)
         lSignalWaitArray[i]->Wait();
+
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    mLocalityMap.erase(GetAddressSpaceAffinityKey((uint)(*pAddressSpace->GetMemOwnerHost()), pAddressSpace->GetGenerationNumber()));
 }
     
 void pmHeavyOperationsThreadPool::CancelTaskSpecificMemoryTransferEvents(pmTask* pTask)
@@ -257,29 +346,187 @@ void pmHeavyOperationsThreadPool::CancelTaskSpecificMemoryTransferEvents(pmTask*
 	SubmitToAllThreadsInPool(std::shared_ptr<heavyOperationsEvent>(new taskMemTransferCancelEvent(TASK_MEM_TRANSFER_CANCEL, pTask)), MAX_CONTROL_PRIORITY);
 }
 
-void pmHeavyOperationsThreadPool::SubmitToThreadPool(const std::shared_ptr<heavyOperationsEvent>& pEvent, ushort pPriority)
+size_t pmHeavyOperationsThreadPool::GetThreadCount() const
 {
-    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    return mThreadVector.size();
+}
+
+heavyOperationsThreadStats pmHeavyOperationsThreadPool::GetThreadStatistics(size_t pThreadIndex) const
+{
+    EXCEPTION_ASSERT(pThreadIndex < mThreadVector.size());
 
-    mThreadVector[mCurrentThread]->SwitchThread(pEvent, pPriority);
+    return mThreadVector[pThreadIndex]->GetStatistics();
+}
+
+/* This method must be called with mResourceLock acquired */
+size_t pmHeavyOperationsThreadPool::GetLeastLoadedThread()
+{
+    size_t lThreadCount = mThreadVector.size();
+    size_t lSelectedThread = mCurrentThread;
+
+    for(size_t i = 1; i < lThreadCount; ++i)
+    {
+        size_t lIndex = (mCurrentThread + i) % lThreadCount;
+        
+        if(mOutstandingEvents[lIndex] < mOutstandingEvents[lSelectedThread])
+            lSelectedThread = lIndex;
+    }
 
     ++mCurrentThread;
-    if(mCurrentThread == mThreadVector.size())
+    if(mCurrentThread == lThreadCount)
         mCurrentThread = 0;
+    
+    return lSelectedThread;
+}
+
+/* Events are routed in this order of preference -
+ 1. Events with an ordered key go to the thread already holding outstanding events with the same key (to preserve execution order)
+ 2. Events with address space locality go to the thread that last served the address space, unless its backlog exceeds the least loaded thread's by HEAVY_OPERATIONS_LOCALITY_SLACK
+ 3. All other events go to the thread with least outstanding events */
+void pmHeavyOperationsThreadPool::SubmitToThreadPool(const std::shared_ptr<heavyOperationsEvent>& pEvent, ushort pPriority, dispatchAffinityType pAffinityType /* = NO_DISPATCH_AFFINITY */, ulong pAffinityKey /* = 0 */)
+{
+    pEvent->affinityType = pAffinityType;
+    pEvent->affinityKey = pAffinityKey;
+
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    size_t lThreadIndex = 0;
+    bool lAffinityHonoured = false;
+
+    if(mThreadVector.size() > 1)
+    {
+        switch(pAffinityType)
+        {
+            case ORDERED_BY_PEER:
+            case ORDERED_BY_SOURCE_HOST:
+            case ORDERED_FILE_OPERATIONS:
+            {
+                auto lKey = std::make_pair(pAffinityType, pAffinityKey);
+                auto lIter = mOrderedDispatchMap.find(lKey);
+
+                if(lIter == mOrderedDispatchMap.end())
+                {
+                    lThreadIndex = GetLeastLoadedThread();
+                    mOrderedDispatchMap.emplace(lKey, std::make_pair(lThreadIndex, (uint)1));
+                }
+                else
+                {
+                    lThreadIndex = lIter->second.first;
+                    ++lIter->second.second;
+                    lAffinityHonoured = true;
+                }
+
+                break;
+            }
+                
+            case ADDRESS_SPACE_LOCALITY:
+            {
+                lThreadIndex = GetLeastLoadedThread();
+
+                auto lIter = mLocalityMap.find(pAffinityKey);
+                if(lIter == mLocalityMap.end())
+                {
+                    mLocalityMap.emplace(pAffinityKey, lThreadIndex);
+                }
+                else if(mOutstandingEvents[lIter->second] <= mOutstandingEvents[lThreadIndex] + HEAVY_OPERATIONS_LOCALITY_SLACK)
+                {
+                    lAffinityHonoured = (lIter->second != lThreadIndex || mOutstandingEvents[lIter->second] != mOutstandingEvents[lThreadIndex]);
+                    lThreadIndex = lIter->second;
+                }
+                else
+                {
+                    lIter->second = lThreadIndex;
+                }
+                
+                break;
+            }
+
+            default:
+                lThreadIndex = GetLeastLoadedThread();
+        }
+    }
+
+    ++mOutstandingEvents[lThreadIndex];
+    mThreadVector[lThreadIndex]->RecordDispatch(pAffinityType, lAffinityHonoured, mOutstandingEvents[lThreadIndex]);
+
+    mThreadVector[lThreadIndex]->SwitchThread(pEvent, pPriority);
 }
 
-void pmHeavyOperationsThreadPool::SubmitToAllThreadsInPool(const std::shared_ptr<heavyOperationsEvent>& pEvent, ushort pPriority) const
+void pmHeavyOperationsThreadPool::SubmitToAllThreadsInPool(const std::shared_ptr<heavyOperationsEvent>& pEvent, ushort pPriority)
 {
-    for_each(mThreadVector, [&] (const std::unique_ptr<pmHeavyOperationsThread>& pThread)
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    for_each_with_index(mThreadVector, [&] (const std::unique_ptr<pmHeavyOperationsThread>& pThread, size_t pIndex)
     {
+        ++mOutstandingEvents[pIndex];
         pThread->SwitchThread(pEvent, pPriority);
     });
 }
 
+/* Called by a pool thread for events it has finished processing or has discarded from its queue */
+void pmHeavyOperationsThreadPool::EventsRetired(size_t pThreadIndex, const heavyOperationsEvent& pEvent, size_t pCount /* = 1 */)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    DEBUG_EXCEPTION_ASSERT(mOutstandingEvents[pThreadIndex] >= pCount);
+    mOutstandingEvents[pThreadIndex] -= (uint)pCount;
+    
+    if(mOutstandingEvents.size() > 1)
+    {
+        switch(pEvent.affinityType)
+        {
+            case ORDERED_BY_PEER:
+            case ORDERED_BY_SOURCE_HOST:
+            case ORDERED_FILE_OPERATIONS:
+            {
+                auto lIter = mOrderedDispatchMap.find(std::make_pair(pEvent.affinityType, pEvent.affinityKey));
+                
+                EXCEPTION_ASSERT(lIter != mOrderedDispatchMap.end() && lIter->second.first == pThreadIndex && lIter->second.second >= pCount);
+
+                lIter->second.second -= (uint)pCount;
+                if(lIter->second.second == 0)
+                    mOrderedDispatchMap.erase(lIter);
+
+                break;
+            }
+                
+            default:
+                break;
+        }
+    }
+}
+
+#ifdef DUMP_HEAVY_OPERATIONS_STATS
+void pmHeavyOperationsThreadPool::DumpThreadStatistics() const
+{
+    const char* lEventNames[MAX_HEAVY_OPERATIONS_EVENT] = {"Network Request", "Pack", "Unpack", "Subtask Reduce", "Mem Transfer", "Mem Transfer Cancel", "Task Mem Transfer Cancel", "Command Completion"};
+
+    std::stringstream lStream;
+    lStream << "Heavy Operations Stats [Host " << pmGetHostId() << "] ............ " << std::endl;
+
+    for(size_t i = 0; i < mThreadVector.size(); ++i)
+    {
+        heavyOperationsThreadStats lStats = mThreadVector[i]->GetStatistics();
+
+        lStream << "Thread " << i << " => Busy Time: " << lStats.busyTime << " secs; Max Outstanding Events: " << lStats.maxOutstandingEvents;
+        lStream << "; Dispatches (Ordered/Locality/Load Balanced): " << lStats.orderedDispatches << "/" << lStats.localityDispatches << "/" << lStats.loadBalancedDispatches << std::endl;
+        
+        lStream << "    Events Processed =>";
+        for(size_t j = 0; j < MAX_HEAVY_OPERATIONS_EVENT; ++j)
+            lStream << " " << lEventNames[j] << ": " << lStats.eventsProcessed[j] << ";";
+
+        lStream << std::endl;
+    }
+
+    pmLogger::GetLogger()->LogDeferred(pmLogger::DEBUG_INTERNAL, pmLogger::INFORMATION, lStream.str().c_str());
+}
+#endif
+
 
 /* class pmHeavyOperationsThread */
 pmHeavyOperationsThread::pmHeavyOperationsThread(size_t pThreadIndex)
     : mThreadIndex(pThreadIndex)
+    , mStatsLock __LOCK_NAME__("pmHeavyOperationsThread::mStatsLock")
 {
 }
     
@@ -287,8 +534,31 @@ pmHeavyOperationsThread::~pmHeavyOperationsThread()
 {
 }
 
+heavyOperationsThreadStats pmHeavyOperationsThread::GetStatistics()
+{
+    FINALIZE_RESOURCE_PTR(dStatsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mStatsLock, Lock(), Unlock());
+
+    return mStats;
+}
+
+void pmHeavyOperationsThread::RecordDispatch(dispatchAffinityType pAffinityType, bool pAffinityHonoured, uint pOutstandingEvents)
+{
+    FINALIZE_RESOURCE_PTR(dStatsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mStatsLock, Lock(), Unlock());
+
+    if(!pAffinityHonoured)
+        ++mStats.loadBalancedDispatches;
+    else if(pAffinityType == ADDRESS_SPACE_LOCALITY)
+        ++mStats.localityDispatches;
+    else
+        ++mStats.orderedDispatches;
+
+    mStats.maxOutstandingEvents = std::max(mStats.maxOutstandingEvents, pOutstandingEvents);
+}
+
 void pmHeavyOperationsThread::ThreadSwitchCallback(std::shared_ptr<heavyOperationsEvent>& pEvent)
 {
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
     try
 	{
 		ProcessEvent(*pEvent);
@@ -297,6 +567,16 @@ void pmHeavyOperationsThread::ThreadSwitchCallback(std::shared_ptr<heavyOperatio
 	{
 		pmLogger::GetLogger()->Log(pmLogger::MINIMAL, pmLogger::WARNING, "Exception generated from heavy operations thread");
 	}
+    
+    // Scope for stats lock
+    {
+        FINALIZE_RESOURCE_PTR(dStatsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mStatsLock, Lock(), Unlock());
+
+        ++mStats.eventsProcessed[pEvent->eventId];
+        mStats.busyTime += pmBase::GetCurrentTimeInSecs() - lStartTime;
+    }
+    
+    pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()->EventsRetired(mThreadIndex, *pEvent);
 }
 
 void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
@@ -368,10 +648,8 @@ void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
 
             bool lOptimalSendDone = false;
 
-        #ifdef SUPPORT_LAZY_MEMORY
-        #else
-            // Check if reduction data can be transferred without mpi packing
-            if(!lHasScratchBuffers && lReducibleAddressSpaces == 1 && NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->IsImplicitlyReducible(lEventDetails.task))
+            // Check if reduction data can be transferred without mpi packing (lazy shadow memory may have protected pages, which only execution stubs can fault in)
+            if(!lHasScratchBuffers && lReducibleAddressSpaces == 1 && !lEventDetails.task->IsLazy(lAddressSpace) && NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->IsImplicitlyReducible(lEventDetails.task))
             {
                 void* lShadowMem = lSubscriptionManager.GetSubtaskShadowMem(lEventDetails.reducingStub, lEventDetails.subtaskId, lSplitInfoAutoPtr.get(), (uint)lAddressSpaceIndex);
                 ulong lOffset = 0, lLength = 0;
@@ -403,18 +681,46 @@ void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
                     lLength = (uint)lBeginIter->second.first;
                 }
                 
-                pmReductionOpType lOpType;
-                pmReductionDataType lDataType;
+                pmDataReductionCallback lReductionCallback = lEventDetails.task->GetCallbackUnit()->GetDataReductionCB()->GetCallback();
+                const reducer::userReductionOperation* lUserOperation = pmReducer::FindUserReductionOperation(lReductionCallback);
+
+                pmReductionOpType lOpType = MAX_REDUCTION_OP_TYPES;
+                pmReductionDataType lDataType = MAX_REDUCTION_DATA_TYPES;
                 
-                findReductionOpAndDataType(lEventDetails.task->GetCallbackUnit()->GetDataReductionCB()->GetCallback(), lOpType, lDataType);
+                if(!lUserOperation)
+                    findReductionOpAndDataType(lReductionCallback, lOpType, lDataType);
+
+                // Ring and recursive halving topologies send only a segment of the reduced subscription
+                size_t lElemSize = (lUserOperation ? lUserOperation->operation.elemSize : getReductionDataTypeSize(lDataType));
+                ulong lFirstElem = 0, lElems = 0;
+
+                EXCEPTION_ASSERT(lLength % lElemSize == 0);
+                lEventDetails.segment.GetElementRange(lLength / lElemSize, lFirstElem, lElems);
 
-                char* lTargetMem = (static_cast<char*>(lShadowMem) + lOffset);
+                ulong lSegmentOffset = lFirstElem * lElemSize;
+                lLength = lElems * lElemSize;
+
+                char* lTargetMem = (static_cast<char*>(lShadowMem) + lOffset + lSegmentOffset);
                 
                 ulong lCompressedLength = 0;
                 std::shared_ptr<void> lCompressedMem;
 
             #ifndef TURN_OFF_NETWORK_SENTINEL_COMPRESSION
-                // Scope for task profiling
+                // Sentinels are not reduced at the receiver, which is only correct if the sentinel (zero) is the identity of the operation
+                if(lUserOperation)
+                {
+                    if(lUserOperation->operation.zeroIdentity)
+                    {
+                    #ifdef ENABLE_TASK_PROFILING
+                        #ifdef DUMP_DATA_COMPRESSION_STATISTICS
+                            pmRecordProfileEventAutoPtr lRecordProfileEventAutoPtr(lEventDetails.task->GetTaskProfiler(), taskProfiler::NETWORK_DATA_COMPRESSION);
+                        #endif
+                    #endif
+
+                        lCompressedMem = pmUtility::CompressForSentinel(lTargetMem, lUserOperation->operation.elemSize, lLength / lUserOperation->operation.elemSize, lCompressedLength);
+                    }
+                }
+                else if(lOpType == REDUCE_ADD || lOpType == REDUCE_BITWISE_OR || lOpType == REDUCE_BITWISE_XOR)
                 {
                 #ifdef ENABLE_TASK_PROFILING
                     #ifdef DUMP_DATA_COMPRESSION_STATISTICS
@@ -466,7 +772,7 @@ void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
                 }
             #endif
 
-                finalize_ptr<subtaskMemoryReduceStruct> lData(new subtaskMemoryReduceStruct(*lEventDetails.task->GetOriginatingHost(), lEventDetails.task->GetSequenceNumber(), lEventDetails.subtaskId, lOffset, (lCompressedMem.get() ? lCompressedLength : lLength), std::numeric_limits<int>::max(), *PM_LOCAL_MACHINE, (lCompressedMem.get() != NULL)));
+                finalize_ptr<subtaskMemoryReduceStruct> lData(new subtaskMemoryReduceStruct(*lEventDetails.task->GetOriginatingHost(), lEventDetails.task->GetSequenceNumber(), lEventDetails.subtaskId, lSegmentOffset, (lCompressedMem.get() ? lCompressedLength : lLength), std::numeric_limits<int>::max(), *PM_LOCAL_MACHINE, (lCompressedMem.get() != NULL), lLength, lEventDetails.segment.step, (lEventDetails.segment.gather ? GATHER_SEGMENT : REDUCE_SEGMENT)));
                 pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<subtaskMemoryReduceStruct>::CreateSharedPtr(lEventDetails.task->GetPriority(), SEND, SUBTASK_MEMORY_REDUCE_TAG, lEventDetails.machine, SUBTASK_MEMORY_REDUCE_STRUCT, lData, 1, NULL, (lCompressedMem.get() ? lCompressedMem.get() : lTargetMem));
                 
                 if(lCompressedMem.get())
@@ -476,11 +782,12 @@ void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
 
                 lOptimalSendDone = true;
             }
-        #endif
             
             // Send reduction data as MPI_PACKED
             if(!lOptimalSendDone)
             {
+                EXCEPTION_ASSERT(lEventDetails.segment.count == 1 && !lEventDetails.segment.gather);    // Only binomial tree reductions are packed
+
                 finalize_ptr<subtaskReducePacked> lPackedData(new subtaskReducePacked(lEventDetails.reducingStub, lEventDetails.task, lEventDetails.subtaskId, lSplitInfoAutoPtr.get()));
             
                 pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<subtaskReducePacked>::CreateSharedPtr(lEventDetails.task->GetPriority(), SEND, SUBTASK_REDUCE_TAG, lEventDetails.machine, SUBTASK_REDUCE_PACKED, lPackedData, 1, NULL, lEventDetails.task);
@@ -547,7 +854,7 @@ void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
              The only requirement here is that when a pmAddressSpace is being deleted, it should not be currently being processed.
              This is ensured by issuing a dummy MEM_TRANSFER_CANCEL event. */
 
-            lEventDetails.signalWaitArray[mThreadIndex].Signal();
+            lEventDetails.signalWaitArray[mThreadIndex]->Signal();
             
             break;
         }
@@ -555,7 +862,13 @@ void pmHeavyOperationsThread::ProcessEvent(heavyOperationsEvent& pEvent)
         case TASK_MEM_TRANSFER_CANCEL:
         {
             taskMemTransferCancelEvent& lEventDetails = static_cast<taskMemTransferCancelEvent&>(pEvent);
-            DeleteMatchingCommands(lEventDetails.task->GetPriority(), taskMemTransferEventsMatchFunc, lEventDetails.task);
+
+            std::vector<std::shared_ptr<heavyOperationsEvent>> lDeletedEvents;
+            DeleteAndGetAllMatchingCommands(lEventDetails.task->GetPriority(), taskMemTransferEventsMatchFunc, lEventDetails.task, lDeletedEvents);
+
+            // Deleted events are MEM_TRANSFER events which are never dispatched by an ordered key
+            if(!lDeletedEvents.empty())
+                pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()->EventsRetired(mThreadIndex, *lDeletedEvents.front(), lDeletedEvents.size());
 
             break;
         }
@@ -599,7 +912,7 @@ void pmHeavyOperationsThread::ServeGeneralMemoryRequest(pmAddressSpace* pSrcAddr
                 });
 
                 if(!pIsTaskOriginated || pRequestingTask)
-                    lDestAddressSpace->CopyOrUpdateReceivedMemory(pRequestingTask, pReceiverOffset + lInternalOffset - pOffset, pLength, &lFunc);
+                    lDestAddressSpace->CopyOrUpdateReceivedMemory(pRequestingTask, pTaskSequenceNumber, pReceiverOffset + lInternalOffset - pOffset, pLength, &lFunc);
             #endif
             }
             else
@@ -625,8 +938,20 @@ void pmHeavyOperationsThread::ServeGeneralMemoryRequest(pmAddressSpace* pSrcAddr
                     finalize_ptr<memoryReceiveStruct> lHelperData(new memoryReceiveStruct(pDestMemIdentifier.memOwnerHost, pDestMemIdentifier.generationNumber, pReceiverOffset + lInternalOffset - pOffset, lStepLength, pIsTaskOriginated, pTaskOriginatingHost, pTaskSequenceNumber, std::numeric_limits<int>::max(), pmGetHostId()));
 
                     MEM_TRANSFER_DUMP(pSrcAddressSpace, pDestMemIdentifier, pReceiverOffset + lInternalOffset - pOffset, lInternalOffset, lStepLength, 0, 0, (uint)(*pRequestingMachine))
+                    pmTracer::RecordInstant(tracer::MEMORY_SEND, (uint)(*pRequestingMachine), lStepLength);
 
-                    pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<memoryReceiveStruct>::CreateSharedPtr(pPriority, SEND, MEMORY_RECEIVE_TAG, pRequestingMachine, MEMORY_RECEIVE_STRUCT, lHelperData, 1, NULL, static_cast<void*>(static_cast<char*>(lOwnerAddressSpace->GetMem()) + lInternalOffset));
+                    char* lSrcMem = static_cast<char*>(lOwnerAddressSpace->GetMem()) + lInternalOffset;
+
+                    networkCompression::codecType lCodec = networkCompression::CODEC_NONE;
+                    std::shared_ptr<char> lCompressedMem = pmNetworkCompressor::GetNetworkCompressor()->Compress(pSrcAddressSpace, lSrcMem, lStepLength, lStepLength, 1, lHelperData->compressedLength, lCodec);
+                    lHelperData->codec = lCodec;
+
+                    pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<memoryReceiveStruct>::CreateSharedPtr(pPriority, SEND, MEMORY_RECEIVE_TAG, pRequestingMachine, MEMORY_RECEIVE_STRUCT, lHelperData, 1, NULL, static_cast<void*>(lSrcMem));
+
+                    if(lCompressedMem.get())
+                        lCommand->HoldExternalDataForLifetimeOfCommand(lCompressedMem);
+                    else
+                        lCommand->HoldExternalDataForLifetimeOfCommand(MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->HoldMemory(lOwnerAddressSpace));
 
                     pmCommunicator::GetCommunicator()->SendMemory(lCommand, false);
 
@@ -694,8 +1019,20 @@ void pmHeavyOperationsThread::ServeScatteredMemoryRequest(pmAddressSpace* pSrcAd
                     finalize_ptr<memoryReceiveStruct> lHelperData(new memoryReceiveStruct(pDestMemIdentifier.memOwnerHost, pDestMemIdentifier.generationNumber, lReceiverOffset + lInternalStepOffset, lStepScatteredInfo.size, lStepScatteredInfo.step, lStepCounts, pIsTaskOriginated, pTaskOriginatingHost, pTaskSequenceNumber, std::numeric_limits<int>::max(), pmGetHostId()));
                 
                     MEM_TRANSFER_DUMP(pSrcAddressSpace, pDestMemIdentifier, lReceiverOffset + lInternalStepOffset, lStepScatteredInfo.offset, lStepScatteredInfo.size, lStepScatteredInfo.step, lStepScatteredInfo.count, (uint)(*pRequestingMachine))
+                    pmTracer::RecordInstant(tracer::MEMORY_SEND, (uint)(*pRequestingMachine), lStepScatteredInfo.size * lStepCounts);
+
+                    char* lSrcMem = lBeginAddr + lRangeOwner.hostOffset + lInternalStepOffset;
+
+                    networkCompression::codecType lCodec = networkCompression::CODEC_NONE;
+                    std::shared_ptr<char> lCompressedMem = pmNetworkCompressor::GetNetworkCompressor()->Compress(pSrcAddressSpace, lSrcMem, lStepScatteredInfo.size, lStepScatteredInfo.step, lStepCounts, lHelperData->compressedLength, lCodec);
+                    lHelperData->codec = lCodec;
+
+                    pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<memoryReceiveStruct>::CreateSharedPtr(pPriority, SEND, MEMORY_RECEIVE_TAG, pRequestingMachine, MEMORY_RECEIVE_STRUCT, lHelperData, 1, NULL, static_cast<void*>(lSrcMem));
 
-                    pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<memoryReceiveStruct>::CreateSharedPtr(pPriority, SEND, MEMORY_RECEIVE_TAG, pRequestingMachine, MEMORY_RECEIVE_STRUCT, lHelperData, 1, NULL, static_cast<void*>(lBeginAddr + lRangeOwner.hostOffset + lInternalStepOffset));
+                    if(lCompressedMem.get())
+                        lCommand->HoldExternalDataForLifetimeOfCommand(lCompressedMem);
+                    else
+                        lCommand->HoldExternalDataForLifetimeOfCommand(MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->HoldMemory(lOwnerAddressSpace));
 
                     pmCommunicator::GetCommunicator()->SendMemory(lCommand, false);
                     
@@ -826,6 +1163,20 @@ void pmHeavyOperationsThread::HandleCommandCompletion(pmCommandPtr& pCommand)
                             break;
                         }
 
+                        case OPEN_FILE_BACKED_ADDRESS_SPACE:
+                        {
+                            pmUtility::OpenFileBackedAddressSpace((char*)(lData->fileName), lData->sourceHost, lData->generationNumber);
+                            pmUtility::SendFileMappingAcknowledgement((char*)(lData->fileName), pmMachinePool::GetMachinePool()->GetMachine(lData->sourceHost));
+
+                            break;
+                        }
+
+                        case CLOSE_FILE_BACKED_ADDRESS_SPACE:
+                        {
+                            pmUtility::CloseFileBackedAddressSpace(lData->sourceHost, lData->generationNumber);
+                            break;
+                        }
+
                         default:
                             PMTHROW(pmFatalErrorException());
                     }
@@ -856,6 +1207,17 @@ void pmHeavyOperationsThread::HandleCommandCompletion(pmCommandPtr& pCommand)
                     
                         if(lAddressSpace)		// If memory still exists
                         {
+                            bool lGeneralTransfer = (lReceiveStruct->transferType == TRANSFER_GENERAL);
+                            pmNetworkCompressor* lNetworkCompressor = pmNetworkCompressor::GetNetworkCompressor();
+
+                            if(lReceiveStruct->codec != networkCompression::CODEC_NONE)
+                            {
+                                char* lMem = static_cast<char*>(lAddressSpace->GetMem()) + lReceiveStruct->offset;
+                                lNetworkCompressor->Decompress((networkCompression::codecType)lReceiveStruct->codec, static_cast<const char*>(lCommunicatorCommand->GetExternalData()), lReceiveStruct->compressedLength, lMem, lReceiveStruct->length, (lGeneralTransfer ? lReceiveStruct->length : lReceiveStruct->step), (lGeneralTransfer ? 1 : lReceiveStruct->count));
+                            }
+
+                            pmTracer::RecordInstant(tracer::MEMORY_RECEIVE, (lReceiveStruct->isTaskOriginated ? traceFormat::PackTaskKey(lReceiveStruct->originatingHost, lReceiveStruct->sequenceNumber) : 0), lReceiveStruct->length * (lGeneralTransfer ? 1 : lReceiveStruct->count));
+
                             pmTask* lRequestingTask = NULL;
                             if(lReceiveStruct->isTaskOriginated)
                             {
@@ -875,7 +1237,8 @@ void pmHeavyOperationsThread::HandleCommandCompletion(pmCommandPtr& pCommand)
                                 }
                             #endif
 
-                                lAddressSpace->CopyOrUpdateReceivedMemory(lRequestingTask, lReceiveStruct->offset, lReceiveStruct->length, NULL);
+                                if(!lReceiveStruct->isTaskOriginated || lRequestingTask)
+                                    lAddressSpace->CopyOrUpdateReceivedMemory(lRequestingTask, lReceiveStruct->sequenceNumber, lReceiveStruct->offset, lReceiveStruct->length, NULL);
                             }
                             else    // TRANSFER_SCATTERED
                             {
@@ -891,7 +1254,8 @@ void pmHeavyOperationsThread::HandleCommandCompletion(pmCommandPtr& pCommand)
                                 }
                             #endif
 
-                                lAddressSpace->UpdateReceivedMemory(lRequestingTask, lReceiveStruct->offset, lReceiveStruct->length, lReceiveStruct->step, lReceiveStruct->count);
+                                if(!lReceiveStruct->isTaskOriginated || lRequestingTask)
+                                    lAddressSpace->UpdateReceivedMemory(lRequestingTask, lReceiveStruct->sequenceNumber, lReceiveStruct->offset, lReceiveStruct->length, lReceiveStruct->step, lReceiveStruct->count);
                             }
                         }
 
@@ -0,0 +1,607 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+namespace pm
+{
+
+/* class pmIndexedPQ<T> */
+template<typename T, typename P>
+pmIndexedPQ<T, P>::pmIndexedPQ(void* pEventNotificationIdentifier)
+    : mEventNotificationIdentifier(pEventNotificationIdentifier)
+    , mRingBuffers(new ringBuffer[EVENT_QUEUE_RING_PRIORITY_LEVELS])
+    , mItemCount(0)
+    , mFreeNodes(NULL)
+    , mSecondaryOperationsBlocked(false)
+    , mResourceLock __LOCK_NAME__("pmIndexedPQ::mResourceLock")
+    , mSecondaryOperationsWait(false)
+{
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::InsertItem(const std::shared_ptr<T>& pItem, P pPriority)
+{
+    pItem->EventNotification(mEventNotificationIdentifier, true);
+
+    if(pPriority < EVENT_QUEUE_RING_PRIORITY_LEVELS && mRingBuffers[pPriority].Push(pItem))
+        return;
+
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    // Items already in the ring buffers were submitted earlier and must stay ahead
+    DrainRingBuffers();
+    AddNode(pItem, pPriority);
+}
+
+template<typename T, typename P>
+pmStatus pmIndexedPQ<T, P>::GetTopItem(std::shared_ptr<T>& pItem)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    DrainRingBuffers();
+
+	typename priorityQueueType::iterator lIter = GetTopLevel();
+	if(lIter == mQueue.end())
+		return pmOk;
+
+    DEBUG_EXCEPTION_ASSERT(!mSecondaryOperationsBlocked);
+
+    queueNode* lNode = lIter->second.nodes.oldest;
+	pItem = std::move(lNode->item);
+    RemoveNode(lIter, lNode);
+
+    DEBUG_EXCEPTION_ASSERT(!mCurrentItem.get());
+    mCurrentItem = pItem;
+    
+    mSecondaryOperationsBlocked = pItem->BlocksSecondaryOperations();
+
+    pItem->EventNotification(mEventNotificationIdentifier, false);
+	return pmSuccess;
+}
+    
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::MarkProcessingFinished()
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    
+    DEBUG_EXCEPTION_ASSERT(mCurrentItem.get());
+    mCurrentItem.reset();
+    
+    if(mSecondaryOperationsBlocked)
+    {
+        mSecondaryOperationsWait.Signal();
+        mSecondaryOperationsBlocked = false;
+    }
+
+    if(mCurrentSignalWait.get())
+    {
+        mCurrentSignalWait->Signal();
+        mCurrentSignalWait.reset();
+    }
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::UnblockSecondaryOperations()
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    
+    EXCEPTION_ASSERT(mSecondaryOperationsBlocked);
+    
+    mSecondaryOperationsBlocked = false;
+    mSecondaryOperationsWait.Signal();
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::BlockSecondaryOperations()
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    
+    EXCEPTION_ASSERT(!mSecondaryOperationsBlocked);
+    
+    mSecondaryOperationsBlocked = true;
+}
+    
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::CallWhenSecondaryOperationsUnblocked(const std::function<void ()>& pFunc)
+{
+    while(1)
+    {
+        // Auto lock/unlock scope
+        {
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+            if(!mSecondaryOperationsBlocked)
+            {
+                pFunc();
+                return;
+            }
+        }
+    
+        mSecondaryOperationsWait.Wait();
+    }
+}
+
+template<typename T, typename P>
+bool pmIndexedPQ<T, P>::IsHighPriorityElementPresent(P pPriority)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    DrainRingBuffers();
+
+	typename priorityQueueType::iterator lIter = GetTopLevel();
+	if(lIter == mQueue.end())
+		return false;
+
+	return (lIter->first < pPriority);
+}
+
+template<typename T, typename P>
+bool pmIndexedPQ<T, P>::IsEmpty()
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    DrainRingBuffers();
+
+	return (mItemCount == 0);
+}
+
+template<typename T, typename P>
+uint pmIndexedPQ<T, P>::GetSize()
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    DrainRingBuffers();
+
+	return mItemCount;
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::WaitIfMatchingItemBeingProcessed(matchFuncPtr pMatchFunc, void* pMatchCriterion)
+{
+    while(1)
+    {
+        std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS> lSignalWaitPtr;
+
+        // Auto lock/unlock scope
+        {
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+            
+            if(mCurrentItem.get() && pMatchFunc(*mCurrentItem, pMatchCriterion))
+            {
+                if(!mCurrentSignalWait.get())
+                    mCurrentSignalWait.reset(new SIGNAL_WAIT_IMPLEMENTATION_CLASS(true));
+                
+                lSignalWaitPtr = mCurrentSignalWait;
+            }
+            else
+            {
+                return;
+            }
+        }
+    
+        if(lSignalWaitPtr.get())
+            lSignalWaitPtr->Wait();
+    }
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::WaitForCurrentItem()
+{
+    std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS> lSignalWaitPtr;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+        if(mCurrentItem.get())
+        {
+            if(!mCurrentSignalWait.get())
+                mCurrentSignalWait.reset(new SIGNAL_WAIT_IMPLEMENTATION_CLASS(true));
+            
+            lSignalWaitPtr = mCurrentSignalWait;
+        }
+        else
+        {
+            return;
+        }
+    }
+
+    if(lSignalWaitPtr.get())
+        lSignalWaitPtr->Wait();
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey /* = NULL */)
+{
+    while(1)
+    {
+        // Auto lock/unlock scope
+        {
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+            if(!mSecondaryOperationsBlocked)
+            {
+                DrainRingBuffers();
+
+                typename priorityQueueType::iterator lIter = mQueue.find(pPriority);
+                if(lIter == mQueue.end())
+                    return;
+
+                queueNode* lNode = FindMatchingNode(lIter->second, pMatchFunc, pMatchCriterion, pIndexKey, NULL);
+                while(lNode)
+                {
+                    queueNode* lNextNode = FindMatchingNode(lIter->second, pMatchFunc, pMatchCriterion, pIndexKey, lNode);
+
+                    lNode->item->EventNotification(mEventNotificationIdentifier, false);
+                    RemoveNode(lIter, lNode);
+
+                    lNode = lNextNode;
+                }
+
+                return;
+            }
+        }
+
+        mSecondaryOperationsWait.Wait();
+    }
+}
+
+template<typename T, typename P>
+bool pmIndexedPQ<T, P>::HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey /* = NULL */)
+{
+    while(1)
+    {
+        // Auto lock/unlock scope
+        {
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+            if(!mSecondaryOperationsBlocked)
+            {
+                DrainRingBuffers();
+
+                typename priorityQueueType::iterator lIter = mQueue.find(pPriority);
+                if(lIter == mQueue.end())
+                    return false;
+
+                return (FindMatchingNode(lIter->second, pMatchFunc, pMatchCriterion, pIndexKey, NULL) != NULL);
+            }
+        }
+
+        mSecondaryOperationsWait.Wait();
+    }
+
+    return false;
+}
+
+template<typename T, typename P>
+pmStatus pmIndexedPQ<T, P>::DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pItem, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey /* = NULL */)
+{
+    while(1)
+    {
+        // Auto lock/unlock scope
+        {
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+        
+            EXCEPTION_ASSERT(!pTemporarilyUnblockSecondaryOperations || mSecondaryOperationsBlocked);
+
+            if(!mSecondaryOperationsBlocked || pTemporarilyUnblockSecondaryOperations)
+            {
+                DrainRingBuffers();
+
+                typename priorityQueueType::iterator lIter = mQueue.find(pPriority);
+                if(lIter == mQueue.end())
+                    return pmOk;
+
+                queueNode* lNode = FindMatchingNode(lIter->second, pMatchFunc, pMatchCriterion, pIndexKey, NULL);
+                if(!lNode)
+                    return pmOk;
+
+                pItem = lNode->item;
+                pItem->EventNotification(mEventNotificationIdentifier, false);
+                RemoveNode(lIter, lNode);
+
+                return pmSuccess;
+            }
+        }
+
+        mSecondaryOperationsWait.Wait();
+    }
+
+	return pmOk;
+}
+
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::DeleteAndGetAllMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pItems, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey /* = NULL */)
+{
+    while(1)
+    {
+        // Auto lock/unlock scope
+        {
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+            EXCEPTION_ASSERT(!pTemporarilyUnblockSecondaryOperations || mSecondaryOperationsBlocked);
+
+            if(!mSecondaryOperationsBlocked || pTemporarilyUnblockSecondaryOperations)
+            {
+                DrainRingBuffers();
+
+                typename priorityQueueType::iterator lIter = mQueue.find(pPriority);
+                if(lIter == mQueue.end())
+                    return;
+
+                queueNode* lNode = FindMatchingNode(lIter->second, pMatchFunc, pMatchCriterion, pIndexKey, NULL);
+                while(lNode)
+                {
+                    queueNode* lNextNode = FindMatchingNode(lIter->second, pMatchFunc, pMatchCriterion, pIndexKey, lNode);
+
+                    lNode->item->EventNotification(mEventNotificationIdentifier, false);
+                    pItems.emplace_back(std::move(lNode->item));
+                    RemoveNode(lIter, lNode);
+                    
+                    lNode = lNextNode;
+                }
+                
+                return;
+            }
+        }
+
+        mSecondaryOperationsWait.Wait();
+    }
+}
+
+/* Must be called with mResourceLock acquired */
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::DrainRingBuffers()
+{
+    std::shared_ptr<T> lItem;
+
+    for(uint i = 0; i < EVENT_QUEUE_RING_PRIORITY_LEVELS; ++i)
+    {
+        while(mRingBuffers[i].Pop(lItem))
+            AddNode(std::move(lItem), (P)i);
+    }
+}
+
+/* Must be called with mResourceLock acquired */
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::AddNode(std::shared_ptr<T> pItem, P pPriority)
+{
+	typename priorityQueueType::iterator lIter = mQueue.find(pPriority);
+    if(lIter == mQueue.end())
+        lIter = mQueue.emplace(pPriority, priorityLevel()).first;
+
+    priorityLevel& lLevel = lIter->second;
+
+    queueNode* lNode = AllocateNode();
+    lNode->indexKey = pItem->GetIndexKey();
+    lNode->item = std::move(pItem);
+
+    lNode->older = lLevel.nodes.newest;
+    lNode->newer = NULL;
+
+    if(lLevel.nodes.newest)
+        lLevel.nodes.newest->newer = lNode;
+    else
+        lLevel.nodes.oldest = lNode;
+
+    lLevel.nodes.newest = lNode;
+
+    lNode->olderWithKey = lNode->newerWithKey = NULL;
+
+    if(lNode->indexKey)
+    {
+        nodeList& lKeyList = lLevel.index[lNode->indexKey];
+
+        lNode->olderWithKey = lKeyList.newest;
+
+        if(lKeyList.newest)
+            lKeyList.newest->newerWithKey = lNode;
+        else
+            lKeyList.oldest = lNode;
+        
+        lKeyList.newest = lNode;
+    }
+
+    ++mItemCount;
+}
+
+/* Must be called with mResourceLock acquired */
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::RemoveNode(typename priorityQueueType::iterator pLevelIter, queueNode* pNode)
+{
+    priorityLevel& lLevel = pLevelIter->second;
+
+    (pNode->older ? pNode->older->newer : lLevel.nodes.oldest) = pNode->newer;
+    (pNode->newer ? pNode->newer->older : lLevel.nodes.newest) = pNode->older;
+
+    if(pNode->indexKey)
+    {
+        typename std::unordered_map<const void*, nodeList>::iterator lKeyIter = lLevel.index.find(pNode->indexKey);
+        DEBUG_EXCEPTION_ASSERT(lKeyIter != lLevel.index.end());
+
+        nodeList& lKeyList = lKeyIter->second;
+
+        (pNode->olderWithKey ? pNode->olderWithKey->newerWithKey : lKeyList.oldest) = pNode->newerWithKey;
+        (pNode->newerWithKey ? pNode->newerWithKey->olderWithKey : lKeyList.newest) = pNode->olderWithKey;
+        
+        if(!lKeyList.oldest)
+            lLevel.index.erase(lKeyIter);
+    }
+    
+    // Levels with ring buffers are retained as they are expected to be reused
+    if(!lLevel.nodes.oldest && !(pLevelIter->first < EVENT_QUEUE_RING_PRIORITY_LEVELS))
+        mQueue.erase(pLevelIter);
+
+    FreeNode(pNode);
+    --mItemCount;
+}
+
+/* Returns the newest matching node older than pNewerNode (or the newest matching node if pNewerNode is NULL).
+ * Like pmSafePQ, matching items are visited newest first. Must be called with mResourceLock acquired. */
+template<typename T, typename P>
+typename pmIndexedPQ<T, P>::queueNode* pmIndexedPQ<T, P>::FindMatchingNode(priorityLevel& pLevel, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey, queueNode* pNewerNode)
+{
+    if(pIndexKey)
+    {
+        queueNode* lNode = NULL;
+
+        if(pNewerNode)
+        {
+            lNode = pNewerNode->olderWithKey;
+        }
+        else
+        {
+            typename std::unordered_map<const void*, nodeList>::iterator lKeyIter = pLevel.index.find(pIndexKey);
+            if(lKeyIter == pLevel.index.end())
+                return NULL;
+            
+            lNode = lKeyIter->second.newest;
+        }
+
+        for(; lNode; lNode = lNode->olderWithKey)
+        {
+            if(pMatchFunc(*lNode->item.get(), pMatchCriterion))
+                return lNode;
+        }
+    }
+    else
+    {
+        for(queueNode* lNode = (pNewerNode ? pNewerNode->older : pLevel.nodes.newest); lNode; lNode = lNode->older)
+        {
+            if(pMatchFunc(*lNode->item.get(), pMatchCriterion))
+                return lNode;
+        }
+    }
+
+    return NULL;
+}
+
+/* Must be called with mResourceLock acquired */
+template<typename T, typename P>
+typename pmIndexedPQ<T, P>::priorityQueueType::iterator pmIndexedPQ<T, P>::GetTopLevel()
+{
+    typename priorityQueueType::iterator lIter = mQueue.begin(), lEndIter = mQueue.end();
+    
+    while(lIter != lEndIter && !lIter->second.nodes.oldest)
+        ++lIter;
+
+    return lIter;
+}
+
+/* Must be called with mResourceLock acquired */
+template<typename T, typename P>
+typename pmIndexedPQ<T, P>::queueNode* pmIndexedPQ<T, P>::AllocateNode()
+{
+    if(!mFreeNodes)
+    {
+        queueNode* lChunk = new queueNode[EVENT_QUEUE_NODE_CHUNK_SIZE];
+        mNodeChunks.emplace_back(lChunk);
+        
+        for(uint i = 0; i < EVENT_QUEUE_NODE_CHUNK_SIZE; ++i)
+            FreeNode(&lChunk[i]);
+    }
+    
+    queueNode* lNode = mFreeNodes;
+    mFreeNodes = lNode->newer;
+
+    return lNode;
+}
+
+/* Must be called with mResourceLock acquired */
+template<typename T, typename P>
+void pmIndexedPQ<T, P>::FreeNode(queueNode* pNode)
+{
+    pNode->item.reset();
+    pNode->newer = mFreeNodes;
+
+    mFreeNodes = pNode;
+}
+
+
+/* class pmIndexedPQ<T>::ringBuffer */
+template<typename T, typename P>
+pmIndexedPQ<T, P>::ringBuffer::ringBuffer()
+    : mEnqueuePosition(0)
+    , mDequeuePosition(0)
+{
+    for(ulong i = 0; i < EVENT_QUEUE_RING_CAPACITY; ++i)
+        mCells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template<typename T, typename P>
+bool pmIndexedPQ<T, P>::ringBuffer::Push(const std::shared_ptr<T>& pItem)
+{
+    ulong lPosition = mEnqueuePosition.load(std::memory_order_relaxed);
+    ringCell* lCell = NULL;
+    
+    while(1)
+    {
+        lCell = &mCells[lPosition & (EVENT_QUEUE_RING_CAPACITY - 1)];
+
+        long lDiff = (long)lCell->sequence.load(std::memory_order_acquire) - (long)lPosition;
+        if(lDiff == 0)
+        {
+            if(mEnqueuePosition.compare_exchange_weak(lPosition, lPosition + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if(lDiff < 0)
+        {
+            return false;   // full
+        }
+        else
+        {
+            lPosition = mEnqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    
+    lCell->item = pItem;
+    lCell->sequence.store(lPosition + 1, std::memory_order_release);
+
+    return true;
+}
+
+template<typename T, typename P>
+bool pmIndexedPQ<T, P>::ringBuffer::Pop(std::shared_ptr<T>& pItem)
+{
+    ringCell& lCell = mCells[mDequeuePosition & (EVENT_QUEUE_RING_CAPACITY - 1)];
+
+    // An item whose submission is still in progress is picked up by a later drain
+    if(lCell.sequence.load(std::memory_order_acquire) != mDequeuePosition + 1)
+        return false;
+    
+    pItem = std::move(lCell.item);
+    lCell.sequence.store(mDequeuePosition + EVENT_QUEUE_RING_CAPACITY, std::memory_order_release);
+    ++mDequeuePosition;
+
+    return true;
+}
+
+}
@@ -34,6 +34,8 @@
 #include "pmMemoryDirectory.h"
 #include "pmHardware.h"
 #include "pmTask.h"
+#include "pmRemoteDataCache.h"
+#include "pmUtility.h"
 
 namespace pm
 {
@@ -46,19 +48,109 @@ pmMemoryDirectory::pmMemoryDirectory(const communicator::memoryIdentifierStruct&
 
 
 /* class pmMemoryDirectoryLinear */
-pmMemoryDirectoryLinear::pmMemoryDirectoryLinear(ulong pAddressSpaceLength, const communicator::memoryIdentifierStruct& pMemoryIdentifierStruct)
+pmMemoryDirectoryLinear::pmMemoryDirectoryLinear(ulong pAddressSpaceLength, const communicator::memoryIdentifierStruct& pMemoryIdentifierStruct, uint pShardCount /* = 0 */)
     : pmMemoryDirectory(pMemoryIdentifierStruct)
     , mAddressSpaceLength(pAddressSpaceLength)
-{}
+    , mShardLength(0)
+{
+    EXCEPTION_ASSERT(mAddressSpaceLength);
+
+    if(!pShardCount)
+        pShardCount = GetDefaultShardCount(mAddressSpaceLength);
+
+    mShardLength = (mAddressSpaceLength + pShardCount - 1) / pShardCount;
+    
+    uint lShardCount = (uint)((mAddressSpaceLength + mShardLength - 1) / mShardLength);  // Rounding may leave fewer shards than requested
+    std::vector<ownershipShard>(lShardCount).swap(mShards);
+
+    for(uint i = 0; i < lShardCount; ++i)
+    {
+        mShards[i].offset = i * mShardLength;
+        mShards[i].length = std::min(mShardLength, mAddressSpaceLength - mShards[i].offset);
+    }
+}
+
+uint pmMemoryDirectoryLinear::GetDefaultShardCount(ulong pAddressSpaceLength)
+{
+    // Address spaces are created concurrently; the initialization of a function local static is thread safe
+    static const uint sShardCountOverride = [] () -> uint
+    {
+        const char* lVal = getenv("PMLIB_MEMORY_DIRECTORY_SHARDS");
+        return ((lVal && *lVal) ? (uint)atoi(lVal) : 0);
+    }();
+
+    if(sShardCountOverride)
+        return std::min<ulong>(sShardCountOverride, pAddressSpaceLength);
+
+    // Shards are whole multiples of the minimum shard length (and hence of the page size)
+    ulong lShardLength = (pAddressSpaceLength + MAX_MEMORY_DIRECTORY_SHARDS - 1) / MAX_MEMORY_DIRECTORY_SHARDS;
+    lShardLength = ((lShardLength + MIN_MEMORY_DIRECTORY_SHARD_LENGTH - 1) / MIN_MEMORY_DIRECTORY_SHARD_LENGTH) * MIN_MEMORY_DIRECTORY_SHARD_LENGTH;
+    
+    return (uint)((pAddressSpaceLength + lShardLength - 1) / lShardLength);
+}
+
+uint pmMemoryDirectoryLinear::GetShardCount() const
+{
+    return (uint)mShards.size();
+}
+
+uint pmMemoryDirectoryLinear::GetShardIndex(ulong pOffset) const
+{
+    DEBUG_EXCEPTION_ASSERT(pOffset < mAddressSpaceLength);
+
+    return (uint)(pOffset / mShardLength);
+}
+
+template<typename functor_type>
+void pmMemoryDirectoryLinear::ForEachShardPiece(ulong pOffset, ulong pLength, const functor_type& pFunctor)
+{
+    if(!pLength)
+        return;
+
+    ulong lLastAddr = pOffset + pLength - 1;
+    
+    for(uint i = GetShardIndex(pOffset), lLastShard = GetShardIndex(lLastAddr); i <= lLastShard; ++i)
+    {
+        ownershipShard& lShard = mShards[i];
+
+        ulong lPieceOffset = std::max(pOffset, lShard.offset);
+        ulong lPieceLastAddr = std::min(lLastAddr, lShard.offset + lShard.length - 1);
+        
+        pFunctor(lShard, lPieceOffset, lPieceLastAddr - lPieceOffset + 1);
+    }
+}
+
+pmMemoryDirectoryLinear::shardLockScope::shardLockScope(pmMemoryDirectoryLinear* pDirectory, ulong pOffset, ulong pLength, bool pWriteLock)
+    : mDirectory(pDirectory)
+    , mFirstShard(pLength ? pDirectory->GetShardIndex(pOffset) : 1)
+    , mLastShard(pLength ? pDirectory->GetShardIndex(pOffset + pLength - 1) : 0)
+{
+    for(uint i = mFirstShard; i <= mLastShard; ++i)
+    {
+        if(pWriteLock)
+            mDirectory->mShards[i].lock.WriteLock();
+        else
+            mDirectory->mShards[i].lock.ReadLock();
+    }
+}
+
+pmMemoryDirectoryLinear::shardLockScope::~shardLockScope()
+{
+    for(uint i = mLastShard + 1; i > mFirstShard; --i)
+        mDirectory->mShards[i - 1].lock.Unlock();
+}
 
 void pmMemoryDirectoryLinear::Reset(const pmMachine* pOwner)
 {
-	mOwnershipMap.emplace(std::piecewise_construct, std::forward_as_tuple(0), std::forward_as_tuple(std::piecewise_construct, std::forward_as_tuple(mAddressSpaceLength), std::forward_as_tuple(pOwner, 0, mMemoryIdentifierStruct)));
+    for_each(mShards, [&] (ownershipShard& pShard)
+    {
+        pShard.ownershipMap.emplace(std::piecewise_construct, std::forward_as_tuple(pShard.offset), std::forward_as_tuple(std::piecewise_construct, std::forward_as_tuple(pShard.length), std::forward_as_tuple(pOwner, pShard.offset, mMemoryIdentifierStruct)));
+    });
 }
     
 void pmMemoryDirectoryLinear::SetRangeOwner(const vmRangeOwner& pRangeOwner, ulong pOffset, ulong pLength)
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    shardLockScope lShardLockScope(this, pOffset, pLength, true);
     
     SetRangeOwnerInternal(pRangeOwner, pOffset, pLength);
 }
@@ -67,7 +159,7 @@ void pmMemoryDirectoryLinear::SetRangeOwner(const vmRangeOwner& pRangeOwner, ulo
 {
     vmRangeOwner lRangeOwner(pRangeOwner);
 
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    shardLockScope lShardLockScope(this, pOffset, pCount ? ((pCount - 1) * pStep + pLength) : 0, true);
 
     for(ulong i = 0; i < pCount; ++i)
     {
@@ -76,8 +168,20 @@ void pmMemoryDirectoryLinear::SetRangeOwner(const vmRangeOwner& pRangeOwner, ulo
     }
 }
 
-// Must be called with mOwnershipLock acquired
+// Must be called with the shards spanning the range write locked
 void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ulong pOffset, ulong pLength)
+{
+    ForEachShardPiece(pOffset, pLength, [&] (ownershipShard& pShard, ulong pPieceOffset, ulong pPieceLength)
+    {
+        vmRangeOwner lRangeOwner(pRangeOwner);
+        lRangeOwner.hostOffset += (pPieceOffset - pOffset);
+
+        SetRangeOwnerInShard(pShard, lRangeOwner, pPieceOffset, pPieceLength);
+    });
+}
+
+// Must be called with pShard write locked
+void pmMemoryDirectoryLinear::SetRangeOwnerInShard(ownershipShard& pShard, vmRangeOwner pRangeOwner, ulong pOffset, ulong pLength)
 {
 #ifdef _DEBUG
 #if 0
@@ -97,8 +201,8 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
 	pmMemOwnership::iterator* lStartIterAddr = &lStartIter;
 	pmMemOwnership::iterator* lEndIterAddr = &lEndIter;
 
-	FIND_FLOOR_ELEM(pmMemOwnership, mOwnershipMap, pOffset, lStartIterAddr);
-	FIND_FLOOR_ELEM(pmMemOwnership, mOwnershipMap, lLastAddr, lEndIterAddr);
+	FIND_FLOOR_ELEM(pmMemOwnership, pShard.ownershipMap, pOffset, lStartIterAddr);
+	FIND_FLOOR_ELEM(pmMemOwnership, pShard.ownershipMap, lLastAddr, lEndIterAddr);
 
 	if(!lStartIterAddr || !lEndIterAddr)
 		PMTHROW(pmFatalErrorException());
@@ -116,8 +220,8 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
 	size_t lEndLength = lEndIter->second.first;
 	vmRangeOwner lEndOwner = lEndIter->second.second;
 
-	mOwnershipMap.erase(lStartIter, lEndIter);
-    mOwnershipMap.erase(lEndIter);
+	pShard.ownershipMap.erase(lStartIter, lEndIter);
+    pShard.ownershipMap.erase(lEndIter);
 
 	if(lStartOffset < pOffset)
 	{
@@ -128,7 +232,7 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
         }
 		else
         {
-			mOwnershipMap.insert(std::make_pair(lStartOffset, std::make_pair(pOffset-lStartOffset, lStartOwner)));
+			pShard.ownershipMap.insert(std::make_pair(lStartOffset, std::make_pair(pOffset-lStartOffset, lStartOwner)));
         }
 	}
     else
@@ -139,10 +243,10 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
         pmMemOwnership::iterator lPrevIter;
         pmMemOwnership::iterator* lPrevIterAddr = &lPrevIter;
 
-        if(pOffset)
+        if(pOffset > pShard.offset)
         {
             size_t lPrevAddr = pOffset - 1;
-            FIND_FLOOR_ELEM(pmMemOwnership, mOwnershipMap, lPrevAddr, lPrevIterAddr);
+            FIND_FLOOR_ELEM(pmMemOwnership, pShard.ownershipMap, lPrevAddr, lPrevIterAddr);
             if(lPrevIterAddr)
             {
                 size_t lPrevOffset = lPrevIter->first;
@@ -154,7 +258,7 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
                     pRangeOwner.hostOffset -= (lStartOffset - lPrevOffset);
                     pOffset = lPrevOffset;		// Combine with previous range                
 
-                    mOwnershipMap.erase(lPrevIter);
+                    pShard.ownershipMap.erase(lPrevIter);
                 }
             }
         }
@@ -170,7 +274,7 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
         {
             vmRangeOwner lEndRangeOwner = lEndOwner;
             lEndRangeOwner.hostOffset += (lLastAddr - lEndOffset + 1);
-			mOwnershipMap.insert(std::make_pair(lLastAddr + 1, std::make_pair(lEndOffset + lEndLength - 1 - lLastAddr, lEndRangeOwner)));
+			pShard.ownershipMap.insert(std::make_pair(lLastAddr + 1, std::make_pair(lEndOffset + lEndLength - 1 - lLastAddr, lEndRangeOwner)));
         }
 	}
     else
@@ -181,10 +285,10 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
         pmMemOwnership::iterator lNextIter;
         pmMemOwnership::iterator* lNextIterAddr = &lNextIter;
     
-        if(lLastAddr + 1 < mAddressSpaceLength)
+        if(lLastAddr + 1 < pShard.offset + pShard.length)
         {
             size_t lNextAddr = lLastAddr + 1;
-            FIND_FLOOR_ELEM(pmMemOwnership, mOwnershipMap, lNextAddr, lNextIterAddr);
+            FIND_FLOOR_ELEM(pmMemOwnership, pShard.ownershipMap, lNextAddr, lNextIterAddr);
             if(lNextIterAddr)
             {
                 size_t lNextOffset = lNextIter->first;
@@ -195,21 +299,49 @@ void pmMemoryDirectoryLinear::SetRangeOwnerInternal(vmRangeOwner pRangeOwner, ul
                 {
                     lLastAddr = lNextOffset + lNextLength - 1;	// Combine with following range
 
-                    mOwnershipMap.erase(lNextIter);
+                    pShard.ownershipMap.erase(lNextIter);
                 }
             }
         }
     }
 
-	mOwnershipMap.insert(std::make_pair(pOffset, std::make_pair(lLastAddr - pOffset + 1, pRangeOwner)));
+	pShard.ownershipMap.insert(std::make_pair(pOffset, std::make_pair(lLastAddr - pOffset + 1, pRangeOwner)));
 
 #ifdef _DEBUG
-    SanitizeOwnerships();
+    SanitizeOwnerships(pShard);
 #endif
 }
 
-// Must be called with mOwnershipLock acquired
+// Must be called with the shards spanning the range locked
 void pmMemoryDirectoryLinear::GetOwnersInternal(ulong pOffset, ulong pLength, pmMemOwnership& pOwnerships)
+{
+    ForEachShardPiece(pOffset, pLength, [&] (ownershipShard& pShard, ulong pPieceOffset, ulong pPieceLength)
+    {
+        GetOwnersInShard(pShard, pPieceOffset, pPieceLength, pOwnerships);
+
+        if(pPieceOffset == pOffset)
+            return;
+
+        // An interval split by the shard boundary is listed whole, so that it is fetched (or served) in one transfer
+        auto lIter = pOwnerships.find(pPieceOffset);
+        DEBUG_EXCEPTION_ASSERT(lIter != pOwnerships.end() && lIter != pOwnerships.begin());
+
+        auto lPrevIter = lIter;
+        --lPrevIter;
+
+        const vmRangeOwner& lPrevOwner = lPrevIter->second.second;
+        const vmRangeOwner& lOwner = lIter->second.second;
+
+        if(lPrevIter->first + lPrevIter->second.first == pPieceOffset && lPrevOwner.host == lOwner.host && lPrevOwner.memIdentifier == lOwner.memIdentifier && lPrevOwner.hostOffset + lPrevIter->second.first == lOwner.hostOffset)
+        {
+            lPrevIter->second.first += lIter->second.first;
+            pOwnerships.erase(lIter);
+        }
+    });
+}
+
+// Must be called with pShard locked
+void pmMemoryDirectoryLinear::GetOwnersInShard(ownershipShard& pShard, ulong pOffset, ulong pLength, pmMemOwnership& pOwnerships)
 {
 	ulong lLastAddr = pOffset + pLength - 1;
 
@@ -217,8 +349,8 @@ void pmMemoryDirectoryLinear::GetOwnersInternal(ulong pOffset, ulong pLength, pm
 	pmMemOwnership::iterator* lStartIterAddr = &lStartIter;
 	pmMemOwnership::iterator* lEndIterAddr = &lEndIter;
 
-	FIND_FLOOR_ELEM(pmMemOwnership, mOwnershipMap, pOffset, lStartIterAddr);
-	FIND_FLOOR_ELEM(pmMemOwnership, mOwnershipMap, lLastAddr, lEndIterAddr);
+	FIND_FLOOR_ELEM(pmMemOwnership, pShard.ownershipMap, pOffset, lStartIterAddr);
+	FIND_FLOOR_ELEM(pmMemOwnership, pShard.ownershipMap, lLastAddr, lEndIterAddr);
 
 	if(!lStartIterAddr || !lEndIterAddr)
 		PMTHROW(pmFatalErrorException());
@@ -263,14 +395,14 @@ void pmMemoryDirectoryLinear::GetOwnersInternal(ulong pOffset, ulong pLength, pm
 
 void pmMemoryDirectoryLinear::GetOwners(ulong pOffset, ulong pLength, pmMemOwnership& pOwnerships)
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, ReadLock(), Unlock());
+    shardLockScope lShardLockScope(this, pOffset, pLength, false);
 
     GetOwnersInternal(pOffset, pLength, pOwnerships);
 }
 
 void pmMemoryDirectoryLinear::GetOwners(ulong pOffset, ulong pLength, ulong pStep, ulong pCount, pmScatteredMemOwnership& pScatteredOwnerships)
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, ReadLock(), Unlock());
+    shardLockScope lShardLockScope(this, pOffset, pCount ? ((pCount - 1) * pStep + pLength) : 0, false);
 
     pmMemOwnership lOwnerships;
     for(ulong i = 0; i < pCount; ++i)
@@ -305,26 +437,66 @@ void pmMemoryDirectoryLinear::GetOwnersUnprotected(ulong pOffset, ulong pLength,
     
 void pmMemoryDirectoryLinear::Clear()
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    shardLockScope lShardLockScope(this, 0, mAddressSpaceLength, true);
     
-    mOwnershipMap.clear();
+    for_each(mShards, [] (ownershipShard& pShard)
+    {
+        pShard.ownershipMap.clear();
+    });
 }
 
 bool pmMemoryDirectoryLinear::IsEmpty()
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, ReadLock(), Unlock());
+    shardLockScope lShardLockScope(this, 0, mAddressSpaceLength, false);
 
-    return mOwnershipMap.empty();
+    return std::all_of(mShards.begin(), mShards.end(), [] (const ownershipShard& pShard)
+    {
+        return pShard.ownershipMap.empty();
+    });
 }
     
 void pmMemoryDirectoryLinear::CloneFrom(pmMemoryDirectory* pDirectory)
 {
     EXCEPTION_ASSERT(dynamic_cast<pmMemoryDirectoryLinear*>(pDirectory) != NULL);
 
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
-    FINALIZE_RESOURCE_PTR(dSrcDirectoryOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &pDirectory->mOwnershipLock, ReadLock(), Unlock());
+    pmMemoryDirectoryLinear* lSrcDirectory = static_cast<pmMemoryDirectoryLinear*>(pDirectory);
+    EXCEPTION_ASSERT(lSrcDirectory->mAddressSpaceLength == mAddressSpaceLength);
+
+    shardLockScope lShardLockScope(this, 0, mAddressSpaceLength, true);
+    shardLockScope lSrcShardLockScope(lSrcDirectory, 0, lSrcDirectory->mAddressSpaceLength, false);
     
-    mOwnershipMap = static_cast<pmMemoryDirectoryLinear*>(pDirectory)->mOwnershipMap;
+    if(lSrcDirectory->mShardLength == mShardLength)
+    {
+        multi_for_each(mShards, lSrcDirectory->mShards, [] (ownershipShard& pShard, ownershipShard& pSrcShard)
+        {
+            pShard.ownershipMap = pSrcShard.ownershipMap;
+        });
+
+        return;
+    }
+
+    // The directories are sharded differently; the source's intervals are re-split at this directory's shard boundaries
+    for_each(mShards, [] (ownershipShard& pShard)
+    {
+        pShard.ownershipMap.clear();
+    });
+
+    for_each(lSrcDirectory->mShards, [&] (const ownershipShard& pSrcShard)
+    {
+        for_each(pSrcShard.ownershipMap, [&] (const pmMemOwnership::value_type& pPair)
+        {
+            ulong lOffset = pPair.first;
+            ulong lLength = pPair.second.first;
+
+            ForEachShardPiece(lOffset, lLength, [&] (ownershipShard& pShard, ulong pPieceOffset, ulong pPieceLength)
+            {
+                vmRangeOwner lRangeOwner(pPair.second.second);
+                lRangeOwner.hostOffset += (pPieceOffset - lOffset);
+
+                pShard.ownershipMap.emplace(std::piecewise_construct, std::forward_as_tuple(pPieceOffset), std::forward_as_tuple(pPieceLength, lRangeOwner));
+            });
+        });
+    });
 }
 
 
@@ -345,12 +517,12 @@ void pmMemoryDirectoryLinear::CheckMergability(const pmMemOwnership::const_itera
         std::cout << "<<< ERROR >>> Host " << pmGetHostId() << " Mergable Ranges Found (" << lOffset1 << ", " << lLength1 << ") - (" << lOffset2 << ", " << lLength2 << ") map to (" << lRangeOwner1.hostOffset << ", " << lLength1 << ") - (" << lRangeOwner2.hostOffset << ", " << lLength2 << ") on host " << (uint)(*lRangeOwner1.host) << std::endl;
 }
     
-void pmMemoryDirectoryLinear::SanitizeOwnerships() const
+void pmMemoryDirectoryLinear::SanitizeOwnerships(const ownershipShard& pShard) const
 {
-    if(mOwnershipMap.size() == 1)
+    if(pShard.ownershipMap.size() == 1)
         return;
     
-    pmMemOwnership::const_iterator lIter, lBegin = mOwnershipMap.begin(), lEnd = mOwnershipMap.end(), lPenultimate = lEnd;
+    pmMemOwnership::const_iterator lIter, lBegin = pShard.ownershipMap.begin(), lEnd = pShard.ownershipMap.end(), lPenultimate = lEnd;
     --lPenultimate;
     
     for(lIter = lBegin; lIter != lPenultimate; ++lIter)
@@ -365,16 +537,49 @@ void pmMemoryDirectoryLinear::SanitizeOwnerships() const
 void pmMemoryDirectoryLinear::PrintOwnerships() const
 {
     std::cout << "Host " << pmGetHostId() << " Ownership Dump " << std::endl;
-    pmMemOwnership::const_iterator lIter, lBegin = mOwnershipMap.begin(), lEnd = mOwnershipMap.end();
-    for(lIter = lBegin; lIter != lEnd; ++lIter)
-        std::cout << "Range (" << lIter->first << " , " << lIter->second.first << ") is owned by host " << (uint)(*(lIter->second.second.host)) << " (" << lIter->second.second.hostOffset << ", " << lIter->second.first << ")" << std::endl;
+    for_each(mShards, [] (const ownershipShard& pShard)
+    {
+        pmMemOwnership::const_iterator lIter, lBegin = pShard.ownershipMap.begin(), lEnd = pShard.ownershipMap.end();
+        for(lIter = lBegin; lIter != lEnd; ++lIter)
+            std::cout << "Range (" << lIter->first << " , " << lIter->second.first << ") is owned by host " << (uint)(*(lIter->second.second.host)) << " (" << lIter->second.second.hostOffset << ", " << lIter->second.first << ")" << std::endl;
+    });
         
     std::cout << std::endl;
 }
 #endif
     
+// Must be called with the shards spanning the range write locked
+template<typename consumer_type>
+void pmMemoryDirectoryLinear::FindRegionsNotInFlight(void* pMem, size_t pOffset, size_t pLength, consumer_type& pRegionsToBeFetched, std::vector<pmCommandPtr>& pCommandVector)
+{
+    if(GetShardPieceCount(pOffset, pLength) == 1)
+    {
+        FindRegionsNotInFlightInShard(mShards[GetShardIndex(pOffset)].inFlightMap, pMem, pOffset, pLength, pRegionsToBeFetched, pCommandVector);
+        return;
+    }
+
+    std::vector<std::pair<ulong, ulong>> lRegions;   // Start address and last address, in increasing order
+
+    ForEachShardPiece(pOffset, pLength, [&] (ownershipShard& pShard, ulong pPieceOffset, ulong pPieceLength)
+    {
+        FindRegionsNotInFlightInShard(pShard.inFlightMap, pMem, pPieceOffset, pPieceLength, lRegions, pCommandVector);
+    });
+
+    // Regions split by shard boundaries are rejoined
+    auto lIter = lRegions.begin(), lEndIter = lRegions.end();
+    while(lIter != lEndIter)
+    {
+        std::pair<ulong, ulong> lRegion = *lIter;
+
+        for(++lIter; lIter != lEndIter && lIter->first == lRegion.second + 1; ++lIter)
+            lRegion.second = lIter->second;
+
+        pRegionsToBeFetched.emplace_back(lRegion.first, lRegion.second);
+    }
+}
+
 template<typename consumer_type>
-void pmMemoryDirectoryLinear::FindRegionsNotInFlight(pmInFlightRegions& pInFlightMap, void* pMem, size_t pOffset, size_t pLength, consumer_type& pRegionsToBeFetched, std::vector<pmCommandPtr>& pCommandVector)
+void pmMemoryDirectoryLinear::FindRegionsNotInFlightInShard(pmInFlightRegions& pInFlightMap, void* pMem, size_t pOffset, size_t pLength, consumer_type& pRegionsToBeFetched, std::vector<pmCommandPtr>& pCommandVector)
 {
     DEBUG_EXCEPTION_ASSERT(pLength);
 
@@ -470,6 +675,20 @@ void pmMemoryDirectoryLinear::FindRegionsNotInFlight(pmInFlightRegions& pInFligh
     }
 }
 
+uint pmMemoryDirectoryLinear::GetShardPieceCount(ulong pOffset, ulong pLength) const
+{
+    return GetShardIndex(pOffset + pLength - 1) - GetShardIndex(pOffset) + 1;
+}
+
+// Must be called with the shards spanning the range write locked. Every shard records its piece of the region against pCommand.
+void pmMemoryDirectoryLinear::AddInFlightRegion(void* pMem, ulong pOffset, ulong pLength, pmCommandPtr& pCommand)
+{
+    ForEachShardPiece(pOffset, pLength, [&] (ownershipShard& pShard, ulong pPieceOffset, ulong pPieceLength)
+    {
+        pShard.inFlightMap.emplace(std::piecewise_construct, std::forward_as_tuple((char*)pMem + pPieceOffset), std::forward_as_tuple(pPieceLength, regionFetchData(pCommand)));
+    });
+}
+
 pmScatteredTransferMapType pmMemoryDirectoryLinear::SetupRemoteRegionsForFetching(const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo, void* pAddressSpaceBaseAddr, ulong pPriority, std::set<pmCommandPtr>& pCommandsAlreadyIssuedSet)
 {
 	pmScatteredSubscriptionFilter lBlocksFilter(pScatteredSubscriptionInfo);
@@ -477,13 +696,16 @@ pmScatteredTransferMapType pmMemoryDirectoryLinear::SetupRemoteRegionsForFetchin
     
     pmScatteredTransferMapType lMachineVersusTupleVectorMap;
 
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    // Read only file backed data is read locally instead of being fetched from the owner
+    bool lFileBacked = pmUtility::IsFileBackedAddressSpace(mMemoryIdentifierStruct.memOwnerHost, mMemoryIdentifierStruct.generationNumber);
+
+    shardLockScope lShardLockScope(this, pScatteredSubscriptionInfo.offset, (pScatteredSubscriptionInfo.count - 1) * pScatteredSubscriptionInfo.step + pScatteredSubscriptionInfo.size, true);
     
     const auto& lBlocks = lBlocksFilter.FilterBlocks([&] (size_t pRow)
     {
         std::vector<pmCommandPtr> lInnerCommandVector;
 
-        FindRegionsNotInFlight(mInFlightLinearMap, pAddressSpaceBaseAddr, pScatteredSubscriptionInfo.offset + pRow * pScatteredSubscriptionInfo.step, pScatteredSubscriptionInfo.size, lLocalFilter, lInnerCommandVector);
+        FindRegionsNotInFlight(pAddressSpaceBaseAddr, pScatteredSubscriptionInfo.offset + pRow * pScatteredSubscriptionInfo.step, pScatteredSubscriptionInfo.size, lLocalFilter, lInnerCommandVector);
 
         // If the range is already in one or more scattered flights, then multiple general entries are put into inFlightMap
         // Having a set ensures that a command is inserted and subsequently waited upon only once
@@ -496,14 +718,31 @@ pmScatteredTransferMapType pmMemoryDirectoryLinear::SetupRemoteRegionsForFetchin
         {
             EXCEPTION_ASSERT(pPair.first.size && pPair.first.step && pPair.first.count);
 
-            pmCommandPtr lCommand = pmCountDownCommand::CreateSharedPtr(pPair.first.count, pPriority, communicator::RECEIVE, 0);	// Dummy command just to allow threads to wait on it
+            if(lFileBacked)
+            {
+                for(size_t i = 0; i < pPair.first.count; ++i)
+                {
+                    ulong lOffset = pPair.first.offset + i * pPair.first.step;
+
+                    if(!pmUtility::ReadFileBackedAddressSpace(mMemoryIdentifierStruct.memOwnerHost, mMemoryIdentifierStruct.generationNumber, pAddressSpaceBaseAddr, lOffset, pPair.first.size))
+                        PMTHROW(pmFatalErrorException());
+
+                    AcquireOwnershipImmediateInternal(lOffset, pPair.first.size);
+                }
+
+                return;
+            }
+
+            // Rows may cross shards; the command counts down once per shard piece received
+            size_t lPieces = 0;
+            for(size_t i = 0; i < pPair.first.count; ++i)
+                lPieces += GetShardPieceCount(pPair.first.offset + i * pPair.first.step, pPair.first.size);
+
+            pmCommandPtr lCommand = pmCountDownCommand::CreateSharedPtr(lPieces, pPriority, communicator::RECEIVE, 0);	// Dummy command just to allow threads to wait on it
             lCommand->MarkExecutionStart();
 
             for(size_t i = 0; i < pPair.first.count; ++i)
-            {
-                char* lAddr = (char*)pAddressSpaceBaseAddr + pPair.first.offset + i * pPair.first.step;
-                mInFlightLinearMap.emplace(std::piecewise_construct, std::forward_as_tuple(lAddr), std::forward_as_tuple(pPair.first.size, regionFetchData(lCommand)));
-            }
+                AddInFlightRegion(pAddressSpaceBaseAddr, pPair.first.offset + i * pPair.first.step, pPair.first.size, lCommand);
             
             lMachineVersusTupleVectorMap[pMapKeyValue.first].emplace_back(pPair.first, pPair.second, lCommand);
         });
@@ -517,7 +756,7 @@ pmRemoteRegionsInfoMapType pmMemoryDirectoryLinear::GetRemoteRegionsInfo(const p
 	pmScatteredSubscriptionFilter lBlocksFilter(pScatteredSubscriptionInfo);
     pmScatteredSubscriptionFilterHelper lLocalFilter(lBlocksFilter, pAddressSpaceBaseAddr, *this, true);
     
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, ReadLock(), Unlock());
+    shardLockScope lShardLockScope(this, pScatteredSubscriptionInfo.offset, (pScatteredSubscriptionInfo.count - 1) * pScatteredSubscriptionInfo.step + pScatteredSubscriptionInfo.size, false);
     
     const auto& lBlocks = lBlocksFilter.FilterBlocks([&] (size_t pRow)
     {
@@ -534,9 +773,12 @@ pmLinearTransferVectorType pmMemoryDirectoryLinear::SetupRemoteRegionsForFetchin
     std::vector<std::pair<ulong, ulong>> lRegionsToBeFetched;	// Start address and last address of sub ranges to be fetched
     pmLinearTransferVectorType lTupleVector;
 
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    pmRemoteDataCache* lRemoteDataCache = pmRemoteDataCache::GetRemoteDataCache();
+    std::vector<std::pair<ulong, ulong>> lServedRanges, lRemoteRanges;   // Offset and length of ranges served by the remote data cache and those still to be fetched
+
+    shardLockScope lShardLockScope(this, pSubscriptionInfo.offset, pSubscriptionInfo.length, true);
     
-    FindRegionsNotInFlight(mInFlightLinearMap, pAddressSpaceBaseAddr, pSubscriptionInfo.offset, pSubscriptionInfo.length, lRegionsToBeFetched, pCommandVector);
+    FindRegionsNotInFlight(pAddressSpaceBaseAddr, pSubscriptionInfo.offset, pSubscriptionInfo.length, lRegionsToBeFetched, pCommandVector);
 
     for_each(lRegionsToBeFetched, [&] (const std::pair<ulong, ulong>& pPair)
     {
@@ -554,13 +796,40 @@ pmLinearTransferVectorType pmMemoryDirectoryLinear::SetupRemoteRegionsForFetchin
 
                 if(lRangeOwner.host != PM_LOCAL_MACHINE)
                 {
-                    char* lAddr = (char*)pAddressSpaceBaseAddr + pInnerPair.first;
+                    lRemoteRanges.clear();
+
+                    if(pmUtility::ReadFileBackedAddressSpace(mMemoryIdentifierStruct.memOwnerHost, mMemoryIdentifierStruct.generationNumber, pAddressSpaceBaseAddr, pInnerPair.first, pInnerPair.second.first))
+                    {
+                        // Read only file backed data is read locally instead of being fetched from the owner
+                        AcquireOwnershipImmediateInternal(pInnerPair.first, pInnerPair.second.first);
+                    }
+                    else if(lRemoteDataCache->IsEnabled())
+                    {
+                        lServedRanges.clear();
+                        lRemoteDataCache->Serve(mMemoryIdentifierStruct, pAddressSpaceBaseAddr, pInnerPair.first, pInnerPair.second.first, lServedRanges, lRemoteRanges);
+
+                        for_each(lServedRanges, [&] (const std::pair<ulong, ulong>& pServedRange)
+                        {
+                            AcquireOwnershipImmediateInternal(pServedRange.first, pServedRange.second);
+                        });
+                    }
+                    else
+                    {
+                        lRemoteRanges.emplace_back(pInnerPair.first, pInnerPair.second.first);
+                    }
+
+                    for_each(lRemoteRanges, [&] (const std::pair<ulong, ulong>& pRemoteRange)
+                    {
+                        // The range may cross shards; the command counts down once per shard piece received
+                        pmCommandPtr lCommand = pmCountDownCommand::CreateSharedPtr(GetShardPieceCount(pRemoteRange.first, pRemoteRange.second), pPriority, communicator::RECEIVE, 0);	// Dummy command just to allow threads to wait on it
+                        lCommand->MarkExecutionStart();
 
-                    pmCommandPtr lCommand = pmCommand::CreateSharedPtr(pPriority, communicator::RECEIVE, 0);	// Dummy command just to allow threads to wait on it
-                    lCommand->MarkExecutionStart();
+                        vmRangeOwner lPieceOwner(lRangeOwner);
+                        lPieceOwner.hostOffset += (pRemoteRange.first - pInnerPair.first);
 
-                    mInFlightLinearMap.emplace(std::piecewise_construct, std::forward_as_tuple(lAddr), std::forward_as_tuple(pInnerPair.second.first, regionFetchData(lCommand)));
-                    lTupleVector.emplace_back(pmSubscriptionInfo(pInnerPair.first, pInnerPair.second.first), lRangeOwner, lCommand);
+                        AddInFlightRegion(pAddressSpaceBaseAddr, pRemoteRange.first, pRemoteRange.second, lCommand);
+                        lTupleVector.emplace_back(pmSubscriptionInfo(pRemoteRange.first, pRemoteRange.second), lPieceOwner, lCommand);
+                    });
                 }
             });
         }
@@ -571,39 +840,44 @@ pmLinearTransferVectorType pmMemoryDirectoryLinear::SetupRemoteRegionsForFetchin
     
 void pmMemoryDirectoryLinear::CancelUnreferencedRequests()
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    shardLockScope lShardLockScope(this, 0, mAddressSpaceLength, true);
 
     // During scattered transfers, a single command is replicated as general fetch commands and multiple entries are
-    // made into the inFlightMap. This increases the use_count of the shared ptr. Here, it is important to find out
+    // made into the inFlightMap (of one or more shards). This increases the use_count of the shared ptr. Here, it is important to find out
     // the use_count that is external to inFlightMap. To compute the external use_count, the following map is used.
-    std::map<pmCommandPtr, std::vector<pmInFlightRegions::iterator>> lInFlightUseCountMap;
+    std::map<pmCommandPtr, std::vector<std::pair<pmInFlightRegions*, pmInFlightRegions::iterator>>> lInFlightUseCountMap;
     
-    auto lIter = mInFlightLinearMap.begin(), lEnd = mInFlightLinearMap.end();
-    while(lIter != lEnd)
+    for_each(mShards, [&] (ownershipShard& pShard)
     {
-        if(lIter->second.second.receiveCommand.unique())
-        {
-            mInFlightLinearMap.erase(lIter++);
-        }
-        else
+        pmInFlightRegions& lInFlightMap = pShard.inFlightMap;
+
+        auto lIter = lInFlightMap.begin(), lEnd = lInFlightMap.end();
+        while(lIter != lEnd)
         {
-            decltype(lInFlightUseCountMap)::iterator lUseCountIter = lInFlightUseCountMap.find(lIter->second.second.receiveCommand);
-            if(lUseCountIter == lInFlightUseCountMap.end())
-                lUseCountIter = lInFlightUseCountMap.emplace(std::piecewise_construct, std::forward_as_tuple(lIter->second.second.receiveCommand), std::forward_as_tuple()).first;
-            
-            lUseCountIter->second.push_back(lIter);
-            
-            ++lIter;
+            if(lIter->second.second.receiveCommand.unique())
+            {
+                lInFlightMap.erase(lIter++);
+            }
+            else
+            {
+                decltype(lInFlightUseCountMap)::iterator lUseCountIter = lInFlightUseCountMap.find(lIter->second.second.receiveCommand);
+                if(lUseCountIter == lInFlightUseCountMap.end())
+                    lUseCountIter = lInFlightUseCountMap.emplace(std::piecewise_construct, std::forward_as_tuple(lIter->second.second.receiveCommand), std::forward_as_tuple()).first;
+                
+                lUseCountIter->second.emplace_back(&lInFlightMap, lIter);
+                
+                ++lIter;
+            }
         }
-    }
+    });
     
     for_each(lInFlightUseCountMap, [&] (const decltype(lInFlightUseCountMap)::value_type& pPair)
     {
         if((ulong)pPair.first.use_count() == (ulong)pPair.second.size() + 1) // Plus 1 for lInFlightUseCountMap
         {
-            for_each(pPair.second, [&] (const pmInFlightRegions::iterator& pIter)
+            for_each(pPair.second, [&] (const std::pair<pmInFlightRegions*, pmInFlightRegions::iterator>& pMapIterPair)
             {
-                mInFlightLinearMap.erase(pIter);
+                pMapIterPair.first->erase(pMapIterPair.second);
             });
         }
     });
@@ -611,9 +885,9 @@ void pmMemoryDirectoryLinear::CancelUnreferencedRequests()
 
 void pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemory(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource)
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    shardLockScope lShardLockScope(this, pOffset, pLength, true);
 
-    if(CopyOrUpdateReceivedMemoryInternal(pAddressSpace, pAddressSpaceBaseAddr, mInFlightLinearMap, pLockingTask, pOffset, pLength, pDataSource))
+    if(CopyOrUpdateReceivedMemoryInternal(pAddressSpace, pAddressSpaceBaseAddr, pLockingTask, pOffset, pLength, pDataSource))
     {
     #ifdef ENABLE_TASK_PROFILING
         if(pLockingTask)
@@ -624,11 +898,11 @@ void pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemory(pmAddressSpace* pAddres
 
 void pmMemoryDirectoryLinear::UpdateReceivedMemory(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, ulong pStep, ulong pCount)
 {
-    FINALIZE_RESOURCE_PTR(dOwnershipLock, RW_RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mOwnershipLock, WriteLock(), Unlock());
+    shardLockScope lShardLockScope(this, pOffset, pCount ? ((pCount - 1) * pStep + pLength) : 0, true);
 
     bool lComplete = true;
     for(ulong i = 0; i < pCount; ++i)
-        lComplete &= CopyOrUpdateReceivedMemoryInternal(pAddressSpace, pAddressSpaceBaseAddr, mInFlightLinearMap, pLockingTask, pOffset + i * pStep, pLength);
+        lComplete &= CopyOrUpdateReceivedMemoryInternal(pAddressSpace, pAddressSpaceBaseAddr, pLockingTask, pOffset + i * pStep, pLength);
 
 #ifdef ENABLE_TASK_PROFILING
     if(lComplete && pLockingTask)
@@ -636,22 +910,39 @@ void pmMemoryDirectoryLinear::UpdateReceivedMemory(pmAddressSpace* pAddressSpace
 #endif
 }
     
-// Must be called with WriteLock on address space directory acquired
+// Must be called with the shards spanning the range write locked
 void pmMemoryDirectoryLinear::AcquireOwnershipImmediateInternal(ulong pOffset, ulong pLength)
 {
     SetRangeOwnerInternal(vmRangeOwner(PM_LOCAL_MACHINE, pOffset, mMemoryIdentifierStruct), pOffset, pLength);
 }
 
-// Must be called with WriteLock on address space directory acquired
-bool pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemoryInternal(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmInFlightRegions& pInFlightMap, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource /* = NULL */)
+// Must be called with the shards spanning the range write locked
+bool pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemoryInternal(pmAddressSpace* pAddressSpace, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource /* = NULL */)
 {
+    bool lTransferCommandComplete = false;
+
+    // A received range crossing shards completes the in flight piece (and counts down the command) of each of them
+    ForEachShardPiece(pOffset, pLength, [&] (ownershipShard& pShard, ulong pPieceOffset, ulong pPieceLength)
+    {
+        if(CopyOrUpdateReceivedMemoryInShard(pShard, pAddressSpaceBaseAddr, pLockingTask, pPieceOffset, pPieceLength, pDataSource))
+            lTransferCommandComplete = true;
+    });
+
+    return lTransferCommandComplete;
+}
+
+// Must be called with pShard write locked
+bool pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemoryInShard(ownershipShard& pShard, void* pAddressSpaceBaseAddr, pmTask* pLockingTask, ulong pOffset, ulong pLength, std::function<void (char*, ulong)>* pDataSource)
+{
+    pmInFlightRegions& lInFlightMap = pShard.inFlightMap;
+
     void* lDestMem = pAddressSpaceBaseAddr;
     char* lAddr = (char*)lDestMem + pOffset;
     
     bool lTransferCommandComplete = false;
     
-    pmInFlightRegions::iterator lIter = pInFlightMap.find(lAddr);
-    if((lIter != pInFlightMap.end()) && (lIter->second.first == pLength))
+    pmInFlightRegions::iterator lIter = lInFlightMap.find(lAddr);
+    if((lIter != lInFlightMap.end()) && (lIter->second.first == pLength))
     {
         std::pair<size_t, regionFetchData>& lPair = lIter->second;
         
@@ -661,6 +952,10 @@ bool pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemoryInternal(pmAddressSpace*
         regionFetchData& lData = lPair.second;
         AcquireOwnershipImmediateInternal(pOffset, lPair.first);
 
+        // Data received outside exclusive (writable) locks is read only and is retained for later tasks
+        if(!pLockingTask)
+            pmRemoteDataCache::GetRemoteDataCache()->Insert(mMemoryIdentifierStruct, lAddr, pOffset, lPair.first);
+
         pmCountDownCommand* lCountDownCommand = dynamic_cast<pmCountDownCommand*>(lData.receiveCommand.get());
         if(!lCountDownCommand || lCountDownCommand->GetOutstandingCount() == 1)
             lTransferCommandComplete = true;
@@ -668,13 +963,13 @@ bool pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemoryInternal(pmAddressSpace*
         pmCommandPtr lCommandPtr = std::static_pointer_cast<pmCommand>(lData.receiveCommand);
         lData.receiveCommand->MarkExecutionEnd(pmSuccess, lCommandPtr);
 
-        pInFlightMap.erase(lIter);
+        lInFlightMap.erase(lIter);
     }
     else
     {
         pmInFlightRegions::iterator lBaseIter;
         pmInFlightRegions::iterator* lBaseIterAddr = &lBaseIter;
-        FIND_FLOOR_ELEM(pmInFlightRegions, pInFlightMap, lAddr, lBaseIterAddr);
+        FIND_FLOOR_ELEM(pmInFlightRegions, lInFlightMap, lAddr, lBaseIterAddr);
         
         if(!lBaseIterAddr)
             PMTHROW(pmFatalErrorException());
@@ -715,10 +1010,13 @@ bool pmMemoryDirectoryLinear::CopyOrUpdateReceivedMemoryInternal(pmAddressSpace*
             size_t lOffset = lStartAddr - reinterpret_cast<size_t>(lDestMem);
             AcquireOwnershipImmediateInternal(lOffset, lPair.first);
 
+            if(!pLockingTask)
+                pmRemoteDataCache::GetRemoteDataCache()->Insert(mMemoryIdentifierStruct, reinterpret_cast<void*>(lStartAddr), lOffset, lPair.first);
+
             pmCommandPtr lCommandPtr = std::static_pointer_cast<pmCommand>(lData.receiveCommand);
             lData.receiveCommand->MarkExecutionEnd(pmSuccess, lCommandPtr);
 
-            pInFlightMap.erase(lBaseIter);
+            lInFlightMap.erase(lBaseIter);
         }
         else
         {            
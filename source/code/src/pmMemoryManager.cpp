@@ -39,8 +39,11 @@
 #include "pmTaskProfiler.h"
 #include "pmTask.h"
 #include "pmTls.h"
+#include "pmStubManager.h"
+#include "pmUtility.h"
 
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
@@ -48,8 +51,36 @@
 #include <fcntl.h>
 
 #include <string.h>
+#include <unistd.h>
 #include <sstream>
 #include <limits>
+#include <algorithm>
+
+/* Memory policies of mbind (numaif.h is not required as the system call is made directly) */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT 0
+#endif
+
+#ifndef MPOL_F_ADDR
+#define MPOL_F_ADDR (1 << 1)
+#endif
+
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+
+/* Linux 5.7 onwards; older kernels reject the flag (see ProbeShadowMemRemap) and shadow memory is then committed by copying */
+#ifndef MREMAP_DONTUNMAP
+#define MREMAP_DONTUNMAP 4
+#endif
 
 namespace pm
 {
@@ -83,10 +114,33 @@ pmLinuxMemoryManager::pmLinuxMemoryManager()
     , mTotalAllocationTime(0)
     , mTrackLock __LOCK_NAME__("pmLinuxMemoryManager::mTrackLock")
 #endif
+#ifdef SUPPORT_LAZY_MEMORY
+    , mLazyMemoryEnabled(true)
+    , mLazyFaultHistoryLock __LOCK_NAME__("pmLinuxMemoryManager::mLazyFaultHistoryLock")
+#endif
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+    , mShadowMemRemapEnabled(true)
+    , mCheckOutMappingsLock __LOCK_NAME__("pmLinuxMemoryManager::mCheckOutMappingsLock")
+#endif
 {
 	InstallSegFaultHandler();
 
 	mPageSize = ::getpagesize();
+
+#ifdef SUPPORT_LAZY_MEMORY
+    const char* lLazyVal = getenv("PMLIB_LAZY_MEMORY");
+    if(lLazyVal && *lLazyVal)
+        mLazyMemoryEnabled = (atoi(lLazyVal) != 0);
+#endif
+
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+    const char* lVal = getenv("PMLIB_SHADOW_MEM_REMAP");
+    if(lVal && *lVal)
+        mShadowMemRemapEnabled = (atoi(lVal) != 0);
+
+    if(mShadowMemRemapEnabled)
+        mShadowMemRemapEnabled = ProbeShadowMemRemap();
+#endif
 }
 
 pmLinuxMemoryManager::~pmLinuxMemoryManager()
@@ -114,6 +168,46 @@ pmMemoryManager* pmLinuxMemoryManager::GetMemoryManager()
 }
 
 #ifdef SUPPORT_LAZY_MEMORY
+/* Lazy address spaces are backed by a shared memory object, so that a second (protected) view of the memory can be mapped.
+ * Anonymous memory files need no name in /dev/shm (which other processes may clash with or leak on a crash); POSIX shared
+ * memory is only used on kernels without them. */
+int pmLinuxMemoryManager::CreateSharedMemory(const char* pName, size_t pLength)
+{
+    int lSharedMemDescriptor = -1;
+
+#ifdef MFD_CLOEXEC
+    lSharedMemDescriptor = memfd_create(pName + 1, MFD_CLOEXEC);  // Skip the leading slash of the POSIX name
+#endif
+
+    if(lSharedMemDescriptor == -1)
+    {
+        lSharedMemDescriptor = shm_open(pName, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if(lSharedMemDescriptor == -1)
+        {
+            shm_unlink(pName);
+            lSharedMemDescriptor = shm_open(pName, O_RDWR | O_CREAT | O_EXCL, 0600);
+        }
+
+        if(lSharedMemDescriptor == -1)
+            PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::SHM_OPEN_FAILED));
+
+        sharedMemAutoPtr lSharedMemAutoPtr(pName);
+    }
+
+    if(ftruncate(lSharedMemDescriptor, pLength) != 0)
+    {
+        close(lSharedMemDescriptor);
+        PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::FTRUNCATE_FAILED));
+    }
+
+    return lSharedMemDescriptor;
+}
+
+bool pmLinuxMemoryManager::SupportsLazyAccess(pmAddressSpace* pAddressSpace)
+{
+    return (GetAddressSpaceSpecifics(pAddressSpace).mSharedMemDescriptor != -1);
+}
+
 void* pmLinuxMemoryManager::CreateMemoryMapping(int pSharedMemDescriptor, size_t pLength, bool pReadAllowed, bool pWriteAllowed)
 {
     if(pSharedMemDescriptor == -1)
@@ -165,7 +259,7 @@ void pmLinuxMemoryManager::DeleteReadOnlyMemoryMapping(void* pReadOnlyMemoryMapp
 }
 #endif
 
-void* pmLinuxMemoryManager::AllocatePageAlignedMemoryInternal(pmAddressSpace* pAddressSpace, size_t& pLength, size_t& pPageCount, int& pSharedMemDescriptor)
+void* pmLinuxMemoryManager::AllocatePageAlignedMemoryInternal(pmAddressSpace* pAddressSpace, size_t& pLength, size_t& pPageCount, int& pSharedMemDescriptor, size_t& pMappedLength)
 {
 #ifdef TRACK_MEMORY_ALLOCATIONS
     double lTrackTime = GetCurrentTimeInSecs();
@@ -176,33 +270,55 @@ void* pmLinuxMemoryManager::AllocatePageAlignedMemoryInternal(pmAddressSpace* pA
 
 	pLength = FindAllocationSize(pLength, pPageCount);
     pSharedMemDescriptor = -1;
+    pMappedLength = 0;
     
 	void* lPtr = NULL;
 
+    if(pAddressSpace && pAddressSpace->IsFileBacked() && pAddressSpace->GetMemOwnerHost() == PM_LOCAL_MACHINE)
+    {
+        // The owner maps the file privately and read only; file pages are read in as they are touched (and such an address space is never accessed lazily)
+        lPtr = mmap(NULL, pLength, PROT_READ, MAP_PRIVATE, pmUtility::GetFileBackedAddressSpaceDescriptor(*PM_LOCAL_MACHINE, pAddressSpace->GetGenerationNumber()), 0);
+        if(lPtr == MAP_FAILED)
+            PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MMAP_FAILED));
+
+        pMappedLength = pLength;
+    }
+    else
 #ifdef SUPPORT_LAZY_MEMORY
-    if(pAddressSpace)
+    if(pAddressSpace && mLazyMemoryEnabled)
     {
-        const char* lSharedMemName = pAddressSpace->GetName();
+        int lSharedMemDescriptor = CreateSharedMemory(pAddressSpace->GetName(), pLength);
 
-        int lSharedMemDescriptor = shm_open(lSharedMemName, O_RDWR | O_CREAT | O_EXCL, 0600);
-        if(lSharedMemDescriptor == -1)
+        try
         {
-            shm_unlink(lSharedMemName);
-            lSharedMemDescriptor = shm_open(lSharedMemName, O_RDWR | O_CREAT | O_EXCL, 0600);
+            lPtr = CreateMemoryMapping(lSharedMemDescriptor, pLength, true, true);
+        }
+        catch(...)
+        {
+            close(lSharedMemDescriptor);
+            throw;
         }
 
-        if(lSharedMemDescriptor == -1)
-            PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::SHM_OPEN_FAILED));
-
-        sharedMemAutoPtr lSharedMemAutoPtr(lSharedMemName);
-        if(ftruncate(lSharedMemDescriptor, pLength) != 0)
-            PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::FTRUNCATE_FAILED));
-
-        lPtr = CreateMemoryMapping(lSharedMemDescriptor, pLength, true, true);
         pSharedMemDescriptor = lSharedMemDescriptor;
+
+        // Shared memory objects are not backed by the hugetlb pool; only placement and huge page advice apply
+        ApplyAllocationPolicy(lPtr, pLength, pAddressSpace->GetAllocationPolicy());
     }
     else
 #endif
+    if(pAddressSpace && (pAddressSpace->GetAllocationPolicy().placement != PLACEMENT_DEFAULT || pAddressSpace->GetAllocationPolicy().pageSize != PAGES_DEFAULT))
+    {
+        // Heap memory may already be resident (and placed) from earlier allocations, so a fresh private mapping is created
+        lPtr = AllocatePrivateMapping(pLength, pAddressSpace->GetAllocationPolicy(), pMappedLength);
+    }
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+    else if(mShadowMemRemapEnabled && pLength >= MIN_REMAPPED_SHADOW_MEM_LENGTH)
+    {
+        // Pages can only be swapped between private mappings (heap pages belong to the allocator)
+        lPtr = AllocatePrivateMapping(pLength, pmMemAllocationPolicy(), pMappedLength);
+    }
+#endif
+    else
     {
         size_t lPageSize = GetVirtualMemoryPageSize();
         void** lRef = (void**)(&lPtr);
@@ -225,14 +341,246 @@ void* pmLinuxMemoryManager::AllocatePageAlignedMemoryInternal(pmAddressSpace* pA
     return lPtr;
 }
     
-void pmLinuxMemoryManager::CreateAddressSpaceSpecifics(pmAddressSpace* pAddressSpace, int pSharedMemDescriptor)
+void* pmLinuxMemoryManager::AllocatePrivateMapping(size_t pLength, const pmMemAllocationPolicy& pAllocationPolicy, size_t& pMappedLength)
+{
+    void* lPtr = MAP_FAILED;
+
+    if(pAllocationPolicy.pageSize == PAGES_EXPLICIT_HUGE)
+    {
+        size_t lHugeLength = ((pLength + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+
+        lPtr = mmap(NULL, lHugeLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(lPtr != MAP_FAILED)
+            pMappedLength = lHugeLength;
+    }
+    
+    if(lPtr == MAP_FAILED)
+    {
+        if(pAllocationPolicy.pageSize == PAGES_DEFAULT)
+        {
+            lPtr = mmap(NULL, pLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(lPtr == MAP_FAILED)
+                PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MMAP_FAILED));
+
+            pMappedLength = pLength;
+        }
+        else
+        {
+            // Over allocate by a huge page and trim the unaligned head and tail, so that the kernel can back the mapping by huge pages
+            size_t lOverAllocatedLength = pLength + HUGE_PAGE_SIZE;
+
+            char* lMem = static_cast<char*>(mmap(NULL, lOverAllocatedLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if((void*)lMem == MAP_FAILED)
+                PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MMAP_FAILED));
+            
+            char* lAlignedMem = reinterpret_cast<char*>(((reinterpret_cast<size_t>(lMem) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE);
+            size_t lHeadLength = (size_t)(lAlignedMem - lMem);
+            size_t lTailLength = lOverAllocatedLength - lHeadLength - pLength;
+            
+            if(lHeadLength && munmap(lMem, lHeadLength) != 0)
+                PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MUNMAP_FAILED));
+
+            if(lTailLength && munmap(lAlignedMem + pLength, lTailLength) != 0)
+                PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MUNMAP_FAILED));
+
+            lPtr = lAlignedMem;
+            pMappedLength = pLength;
+        }
+    }
+    
+    ApplyAllocationPolicy(lPtr, pMappedLength, pAllocationPolicy);
+
+    return lPtr;
+}
+
+/* Placement and advice are hints; failures (e.g. kernels without NUMA or THP support) are ignored */
+void pmLinuxMemoryManager::ApplyAllocationPolicy(void* pMem, size_t pLength, const pmMemAllocationPolicy& pAllocationPolicy)
+{
+#ifdef MADV_HUGEPAGE
+    if(pAllocationPolicy.pageSize != PAGES_DEFAULT)
+        madvise(pMem, pLength, MADV_HUGEPAGE);
+#endif
+
+    if(pAllocationPolicy.placement == PLACEMENT_INTERLEAVED)
+    {
+        pmStubManager* lStubManager = pmStubManager::GetStubManager();
+        ushort lDomainsCount = lStubManager->GetCpuNumaDomainsCount();
+
+        if(lDomainsCount > 1)
+        {
+            std::vector<uint> lNodes;
+            lNodes.reserve(lDomainsCount);
+            
+            for(ushort i = 0; i < lDomainsCount; ++i)
+                lNodes.push_back(lStubManager->GetNumaNodeForCpuNumaDomain(i));
+
+            BindMemoryToNumaNodes(pMem, pLength, MPOL_INTERLEAVE, lNodes);
+        }
+    }
+    
+    // PLACEMENT_FIRST_TOUCH pages are left untouched here and are bound to subscribing stubs' nodes in PlaceMemoryRegion
+}
+
+void pmLinuxMemoryManager::BindMemoryToNumaNodes(void* pMem, size_t pLength, int pMode, const std::vector<uint>& pNodes)
+{
+    const size_t lBitsPerWord = 8 * sizeof(unsigned long);
+    
+    uint lMaxNode = *std::max_element(pNodes.begin(), pNodes.end());
+    std::vector<unsigned long> lNodeMask((lMaxNode / lBitsPerWord) + 1, 0);
+
+    for_each(pNodes, [&] (uint pNode)
+    {
+        lNodeMask[pNode / lBitsPerWord] |= (1UL << (pNode % lBitsPerWord));
+    });
+
+    // The kernel considers one bit less than maxnode
+    syscall(SYS_mbind, pMem, pLength, pMode, &lNodeMask[0], (unsigned long)(lNodeMask.size() * lBitsPerWord + 1), 0);
+}
+
+void pmLinuxMemoryManager::PlaceMemoryRegion(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength, const pmExecutionStub* pStub)
+{
+    if(pAddressSpace->GetAllocationPolicy().placement != PLACEMENT_FIRST_TOUCH || pStub->GetType() != CPU || !pLength)
+        return;
+
+    pmStubManager* lStubManager = pmStubManager::GetStubManager();
+    if(lStubManager->GetCpuNumaDomainsCount() < 2)
+        return;
+
+    // Binding without moving pages only affects pages not yet touched; the range is widened to whole pages. Pages
+    // bound earlier are skipped, so that every mbind call (and the VMA split it causes) covers fresh pages only.
+    size_t lPageSize = GetVirtualMemoryPageSize();
+    char* lMem = static_cast<char*>(pAddressSpace->GetMem());
+
+    std::vector<std::pair<size_t, size_t>> lUnplacedRanges = pAddressSpace->ClaimUnplacedPages(pOffset / lPageSize, (pOffset + pLength - 1) / lPageSize);
+    if(lUnplacedRanges.empty())
+        return;
+
+    std::vector<uint> lNodes(1, lStubManager->GetNumaNodeForCpuNumaDomain(lStubManager->GetNumaDomainIdForCpuDevice(pStub->GetProcessingElement()->GetDeviceIndexInMachine())));
+
+    for_each(lUnplacedRanges, [&] (const std::pair<size_t, size_t>& pRange)
+    {
+        BindMemoryToNumaNodes(lMem + pRange.first * lPageSize, (pRange.second - pRange.first + 1) * lPageSize, MPOL_PREFERRED, lNodes);
+    });
+}
+
+void pmLinuxMemoryManager::AdviseMemoryRegion(pmAddressSpace* pAddressSpace, size_t pOffset, size_t pLength, bool pSequential)
+{
+    if(!pAddressSpace->GetAllocationPolicy().adviseAccessPattern || pLength < MIN_ADVISED_SUBSCRIPTION_LENGTH)
+        return;
+
+    size_t lPageSize = GetVirtualMemoryPageSize();
+    size_t lStartAddr = reinterpret_cast<size_t>(pAddressSpace->GetMem()) + pOffset;
+    size_t lEndAddr = lStartAddr + pLength;
+
+    lStartAddr = (lStartAddr / lPageSize) * lPageSize;
+
+    if(pSequential)
+        madvise(reinterpret_cast<void*>(lStartAddr), lEndAddr - lStartAddr, MADV_SEQUENTIAL);
+
+    madvise(reinterpret_cast<void*>(lStartAddr), lEndAddr - lStartAddr, MADV_WILLNEED);
+}
+    
+bool pmLinuxMemoryManager::SwapPagesIntoAddressSpace(pmAddressSpace* pAddressSpace, size_t pOffset, void* pMem, size_t pLength)
+{
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+    char* lMem = static_cast<char*>(pAddressSpace->GetMem()) + pOffset;
+
+    DEBUG_EXCEPTION_ASSERT(pLength && (reinterpret_cast<size_t>(lMem) % mPageSize) == 0 && (reinterpret_cast<size_t>(pMem) % mPageSize) == 0 && (pLength % mPageSize) == 0);
+
+    if(!mShadowMemRemapEnabled || !IsPrivatelyMappedCheckOutMemory(pMem, pLength))
+        return false;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dAddressSpaceSpecificsMapLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mAddressSpaceSpecificsMapLock, Lock(), Unlock());
+        
+        auto lIter = mAddressSpaceSpecificsMap.find(pAddressSpace);
+        if(lIter == mAddressSpaceSpecificsMap.end())
+            PMTHROW(pmFatalErrorException());
+
+        // Shared memory objects and huge (or interleaved) mappings must retain their own pages
+        const pmMemAllocationPolicy& lPolicy = pAddressSpace->GetAllocationPolicy();
+        if(lIter->second.mSharedMemDescriptor != -1 || !lIter->second.mMappedLength || lPolicy.pageSize != PAGES_DEFAULT || lPolicy.placement == PLACEMENT_INTERLEAVED)
+            return false;
+
+        if(lIter->second.mSwappedRegions >= MAX_SHADOW_MEM_REMAPS_PER_ADDRESS_SPACE)
+            return false;
+
+        ++lIter->second.mSwappedRegions;
+    }
+
+    // The moved pages carry the checked out memory's node policy; the address space's (e.g. from PlaceMemoryRegion) is re-applied to them
+    int lPolicyMode = MPOL_DEFAULT;
+    unsigned long lPolicyNodeMask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {0};
+    bool lHasPolicy = (syscall(SYS_get_mempolicy, &lPolicyMode, lPolicyNodeMask, (unsigned long)MAX_NUMA_NODES, lMem, MPOL_F_ADDR) == 0 && lPolicyMode != MPOL_DEFAULT);
+
+    /* A single move replaces the address space's pages (which are freed) with the checked out ones. The kernel does this under the
+     * process's mapping lock; so a concurrent reader of the range faults (and waits) or sees either the old or the new data but never
+     * an empty window. The checked out memory stays mapped (MREMAP_DONTUNMAP), gets fresh pages when next touched and can still be
+     * pooled. This fails (changing neither) if the checked out memory spans multiple mappings, e.g. after an earlier partial swap. */
+    if(mremap(pMem, pLength, pLength, MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP, lMem) == MAP_FAILED)
+    {
+        FINALIZE_RESOURCE_PTR(dAddressSpaceSpecificsMapLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mAddressSpaceSpecificsMapLock, Lock(), Unlock());
+        --mAddressSpaceSpecificsMap[pAddressSpace].mSwappedRegions;
+
+        return false;
+    }
+
+    // Placement is a hint (as in BindMemoryToNumaNodes); pages touched on another node are moved to the bound one
+    if(lHasPolicy)
+        syscall(SYS_mbind, lMem, pLength, lPolicyMode, lPolicyNodeMask, (unsigned long)MAX_NUMA_NODES + 1, MPOL_MF_MOVE);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+/* Checks once that the kernel supports moving pages while retaining the source mapping (as SwapPagesIntoAddressSpace does) */
+bool pmLinuxMemoryManager::ProbeShadowMemRemap()
+{
+    char* lMem = static_cast<char*>(mmap(NULL, 2 * mPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if((void*)lMem == MAP_FAILED)
+        return false;
+
+    bool lSupported = (mremap(lMem, mPageSize, mPageSize, MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP, lMem + mPageSize) != MAP_FAILED);
+
+    if(munmap(lMem, 2 * mPageSize) != 0)
+        PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MUNMAP_FAILED));
+
+    return lSupported;
+}
+
+bool pmLinuxMemoryManager::IsPrivatelyMappedCheckOutMemory(void* pMem, size_t pLength)
+{
+    FINALIZE_RESOURCE_PTR(dCheckOutMappingsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCheckOutMappingsLock, Lock(), Unlock());
+
+    // Pooled shadow memory lies within a larger checked out mapping
+    auto lIter = mCheckOutMappings.upper_bound(pMem);
+    if(lIter == mCheckOutMappings.begin())
+        return false;
+
+    --lIter;
+    
+    return (reinterpret_cast<size_t>(pMem) + pLength <= reinterpret_cast<size_t>(lIter->first) + lIter->second);
+}
+#endif
+
+void pmLinuxMemoryManager::CreateAddressSpaceSpecifics(pmAddressSpace* pAddressSpace, void* pMem, size_t pLength, int pSharedMemDescriptor, size_t pMappedLength)
 {
     FINALIZE_RESOURCE_PTR(dAddressSpaceSpecificsMapLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mAddressSpaceSpecificsMapLock, Lock(), Unlock());
 
     if(mAddressSpaceSpecificsMap.find(pAddressSpace) != mAddressSpaceSpecificsMap.end())
         PMTHROW(pmFatalErrorException());
     
-    mAddressSpaceSpecificsMap[pAddressSpace].mSharedMemDescriptor = pSharedMemDescriptor;
+    linuxMemManager::addressSpaceSpecifics& lSpecifics = mAddressSpaceSpecificsMap[pAddressSpace];
+    lSpecifics.mSharedMemDescriptor = pSharedMemDescriptor;
+    lSpecifics.mMappedLength = pMappedLength;
+    lSpecifics.mMemoryHold.reset(pMem, [this, pLength, pSharedMemDescriptor, pMappedLength] (void* pMem)
+    {
+        ReleaseAddressSpaceMemory(pMem, pLength, pSharedMemDescriptor, pMappedLength);
+    });
 }
 
 linuxMemManager::addressSpaceSpecifics& pmLinuxMemoryManager::GetAddressSpaceSpecifics(pmAddressSpace* pAddressSpace)
@@ -248,8 +596,9 @@ linuxMemManager::addressSpaceSpecifics& pmLinuxMemoryManager::GetAddressSpaceSpe
 void* pmLinuxMemoryManager::AllocateMemory(pmAddressSpace* pAddressSpace, size_t& pLength, size_t& pPageCount)
 {
     int lSharedMemDescriptor = -1;
+    size_t lMappedLength = 0;
 
-    void* lPtr = AllocatePageAlignedMemoryInternal(pAddressSpace, pLength, pPageCount, lSharedMemDescriptor);
+    void* lPtr = AllocatePageAlignedMemoryInternal(pAddressSpace, pLength, pPageCount, lSharedMemDescriptor, lMappedLength);
     
 #ifdef TRACK_MEMORY_ALLOCATIONS
     // Auto lock/unlock scope
@@ -261,7 +610,16 @@ void* pmLinuxMemoryManager::AllocateMemory(pmAddressSpace* pAddressSpace, size_t
 #endif
 
     if(pAddressSpace)
-        CreateAddressSpaceSpecifics(pAddressSpace, lSharedMemDescriptor);
+    {
+        CreateAddressSpaceSpecifics(pAddressSpace, lPtr, pLength, lSharedMemDescriptor, lMappedLength);
+    }
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+    else if(lMappedLength)
+    {
+        FINALIZE_RESOURCE_PTR(dCheckOutMappingsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCheckOutMappingsLock, Lock(), Unlock());
+        mCheckOutMappings[lPtr] = lMappedLength;
+    }
+#endif
 
     return lPtr;
 }
@@ -287,21 +645,22 @@ void* pmLinuxMemoryManager::CreateCheckOutMemory(size_t pLength)
 
 void pmLinuxMemoryManager::DeallocateMemory(pmAddressSpace* pAddressSpace)
 {
+    std::shared_ptr<void> lMemoryHold;
+
     // Auto lock/unlock scope
     {
         FINALIZE_RESOURCE_PTR(dAddressSpaceSpecificsMapLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mAddressSpaceSpecificsMapLock, Lock(), Unlock());
     
-        if(mAddressSpaceSpecificsMap.find(pAddressSpace) == mAddressSpaceSpecificsMap.end())
+        auto lIter = mAddressSpaceSpecificsMap.find(pAddressSpace);
+        if(lIter == mAddressSpaceSpecificsMap.end())
             PMTHROW(pmFatalErrorException());
     
-        mAddressSpaceSpecificsMap.erase(pAddressSpace);
+        lMemoryHold = std::move(lIter->second.mMemoryHold);
+        mAddressSpaceSpecificsMap.erase(lIter);
     }
 
-    #ifdef SUPPORT_LAZY_MEMORY
-        DeleteMemoryMapping(pAddressSpace->GetMem(), pAddressSpace->GetAllocatedLength());
-    #else
-        ::free(pAddressSpace->GetMem());
-    #endif
+    // The memory is released here unless sends out of it are still in flight (in which case the last of them releases it)
+    lMemoryHold.reset();
 
 #ifdef TRACK_MEMORY_ALLOCATIONS
     // Auto lock/unlock scope
@@ -312,8 +671,59 @@ void pmLinuxMemoryManager::DeallocateMemory(pmAddressSpace* pAddressSpace)
 #endif
 }
 
+/* Runs when the last holder of the memory goes away (possibly while destroying a network command), so failures are not thrown */
+void pmLinuxMemoryManager::ReleaseAddressSpaceMemory(void* pMem, size_t pLength, int pSharedMemDescriptor, size_t pMappedLength)
+{
+    if(pSharedMemDescriptor != -1)
+    {
+        munmap(pMem, pLength);
+        close(pSharedMemDescriptor);
+    }
+    else if(pMappedLength)
+    {
+        munmap(pMem, pMappedLength);
+    }
+    else
+    {
+        ::free(pMem);
+    }
+}
+
+std::shared_ptr<void> pmLinuxMemoryManager::HoldMemory(pmAddressSpace* pAddressSpace)
+{
+    FINALIZE_RESOURCE_PTR(dAddressSpaceSpecificsMapLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mAddressSpaceSpecificsMapLock, Lock(), Unlock());
+
+    auto lIter = mAddressSpaceSpecificsMap.find(pAddressSpace);
+    if(lIter == mAddressSpaceSpecificsMap.end())
+        PMTHROW(pmFatalErrorException());
+
+    return lIter->second.mMemoryHold;
+}
+
 void pmLinuxMemoryManager::DeallocateMemory(void* pMem)
 {
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+    size_t lMappedLength = 0;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dCheckOutMappingsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mCheckOutMappingsLock, Lock(), Unlock());
+
+        auto lIter = mCheckOutMappings.find(pMem);
+        if(lIter != mCheckOutMappings.end())
+        {
+            lMappedLength = lIter->second;
+            mCheckOutMappings.erase(lIter);
+        }
+    }
+
+    if(lMappedLength)
+    {
+        if(munmap(pMem, lMappedLength) != 0)
+            PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MUNMAP_FAILED));
+    }
+    else
+#endif
 	::free(pMem);
 
 #ifdef TRACK_MEMORY_ALLOCATIONS
@@ -560,15 +970,122 @@ void pmLinuxMemoryManager::FetchMemoryRegion(pmAddressSpace* pAddressSpace, usho
     }
 }
 
+/* Fetches several ranges together. The remote pieces of all ranges are grouped by their owner, so that each owner
+ * receives a single combined request instead of one request per piece. Overlapping ranges piggy back on in-flight pieces. */
+void pmLinuxMemoryManager::FetchMemoryRegions(pmAddressSpace* pAddressSpace, ushort pPriority, const std::vector<pmSubscriptionInfo>& pRanges, std::vector<pmCommandPtr>& pCommandVector)
+{
+    pmScatteredTransferMapType lMachineVersusTupleVectorMap;
+
+    if(pAddressSpace->GetAddressSpaceType() == ADDRESS_SPACE_2D)
+    {
+        ulong lAddressSpaceCols = pAddressSpace->GetCols();
+        std::set<pmCommandPtr> lCommandsAlreadyIssuedSet;
+
+        for_each(pRanges, [&] (const pmSubscriptionInfo& pRange)
+        {
+            EXCEPTION_ASSERT(pRange.length);
+
+            size_t lOffset = ((ulong)(pRange.offset / lAddressSpaceCols)) * lAddressSpaceCols;    // Floor offset to a multiple of lAddressSpaceCols
+            size_t lLength = ((ulong)((pRange.length + lAddressSpaceCols - 1) / lAddressSpaceCols)) * lAddressSpaceCols;    // Ceil length to a multiple of lAddressSpaceCols
+
+            EXCEPTION_ASSERT(lLength <= lAddressSpaceCols * pAddressSpace->GetRows());
+
+            pmScatteredTransferMapType lRangeMap = pAddressSpace->SetupRemoteRegionsForFetching(pmScatteredSubscriptionInfo(lOffset, lAddressSpaceCols, lAddressSpaceCols, lLength / lAddressSpaceCols), pPriority, lCommandsAlreadyIssuedSet);
+
+            for_each(lRangeMap, [&] (pmScatteredTransferMapType::value_type& pMapKeyValue)
+            {
+                auto& lVector = lMachineVersusTupleVectorMap[pMapKeyValue.first];
+                std::move(pMapKeyValue.second.begin(), pMapKeyValue.second.end(), std::back_inserter(lVector));
+            });
+        });
+
+        FetchCoalescedMemoryRegions(pPriority, pAddressSpace, communicator::TRANSFER_SCATTERED, lMachineVersusTupleVectorMap, pCommandVector);
+
+        pCommandVector.insert(pCommandVector.end(), lCommandsAlreadyIssuedSet.begin(), lCommandsAlreadyIssuedSet.end());
+    }
+    else
+    {
+        for_each(pRanges, [&] (const pmSubscriptionInfo& pRange)
+        {
+            EXCEPTION_ASSERT(pRange.length);
+
+            pmLinearTransferVectorType lTupleVector = pAddressSpace->SetupRemoteRegionsForFetching(pRange, pPriority, pCommandVector);
+
+            // A linear piece travels as a single row scattered block, which is what the combined request carries
+            for_each(lTupleVector, [&] (std::tuple<pmSubscriptionInfo, vmRangeOwner, pmCommandPtr>& pTuple)
+            {
+                const pmSubscriptionInfo& lInfo = std::get<0>(pTuple);
+                const vmRangeOwner& lRangeOwner = std::get<1>(pTuple);
+
+                lMachineVersusTupleVectorMap[lRangeOwner.host].emplace_back(pmScatteredSubscriptionInfo(lInfo.offset, lInfo.length, lInfo.length, 1), lRangeOwner, std::move(std::get<2>(pTuple)));
+            });
+        });
+
+        FetchCoalescedMemoryRegions(pPriority, pAddressSpace, communicator::TRANSFER_GENERAL, lMachineVersusTupleVectorMap, pCommandVector);
+    }
+}
+
+/* Sends one request per owner (and owner side address space). Owners with a single piece get the plain request of
+ * type pSingleTransferType; the others get a combined request, split only when it exceeds what the packed count can hold. */
+void pmLinuxMemoryManager::FetchCoalescedMemoryRegions(ushort pPriority, pmAddressSpace* pAddressSpace, communicator::memoryTransferType pSingleTransferType, pmScatteredTransferMapType& pMachineVersusTupleVectorMap, std::vector<pmCommandPtr>& pCommandVector)
+{
+    typedef std::tuple<pmScatteredSubscriptionInfo, vmRangeOwner, pmCommandPtr> tupleType;
+
+    void* lMem = pAddressSpace->GetMem();
+    const size_t lMaxCombinedRequests = std::numeric_limits<ushort>::max();
+
+    for_each(pMachineVersusTupleVectorMap, [&] (pmScatteredTransferMapType::value_type& pMapKeyValue)
+    {
+        std::vector<tupleType>& lVector = pMapKeyValue.second;
+
+        auto lGroupBegin = lVector.begin(), lEndIter = lVector.end();
+        while(lGroupBegin != lEndIter)
+        {
+            const communicator::memoryIdentifierStruct lMemIdentifier = std::get<1>(*lGroupBegin).memIdentifier;
+
+            auto lGroupEnd = std::stable_partition(lGroupBegin, lEndIter, [&] (const tupleType& pTuple)
+            {
+                return (std::get<1>(pTuple).memIdentifier == lMemIdentifier);
+            });
+
+            for(auto lIter = lGroupBegin; lIter != lGroupEnd; )
+            {
+                size_t lCount = std::min<size_t>(lMaxCombinedRequests, std::distance(lIter, lGroupEnd));
+
+                if(lCount == 1)
+                {
+                    const pmScatteredSubscriptionInfo& lInfo = std::get<0>(*lIter);
+
+                    if(pSingleTransferType == communicator::TRANSFER_GENERAL)
+                        FetchNonOverlappingMemoryRegion(pPriority, pAddressSpace, lMem, communicator::TRANSFER_GENERAL, lInfo.offset, lInfo.size, 0, 0, std::get<1>(*lIter), std::get<2>(*lIter));
+                    else
+                        FetchNonOverlappingMemoryRegion(pPriority, pAddressSpace, lMem, communicator::TRANSFER_SCATTERED, lInfo.offset, lInfo.size, lInfo.step, lInfo.count, std::get<1>(*lIter), std::get<2>(*lIter));
+
+                    pCommandVector.emplace_back(std::move(std::get<2>(*lIter)));
+                }
+                else
+                {
+                    std::vector<tupleType> lBatch(std::make_move_iterator(lIter), std::make_move_iterator(lIter + lCount));
+                    FetchNonOverlappingScatteredMemoryRegions(pPriority, pAddressSpace, lMem, lBatch, pCommandVector);
+                }
+                
+                lIter += lCount;
+            }
+
+            lGroupBegin = lGroupEnd;
+        }
+    });
+}
+
 // This method must be called with mInFlightLock on mInFlightMap of the address space acquired
 void pmLinuxMemoryManager::FetchNonOverlappingMemoryRegion(ushort pPriority, pmAddressSpace* pAddressSpace, void* pMem, communicator::memoryTransferType pTransferType, size_t pOffset, size_t pLength, size_t pStep, size_t pCount, const vmRangeOwner& pRangeOwner, const pmCommandPtr& pCommand)
 {
     using namespace linuxMemManager;
 
-    pmTask* lLockingTask = pAddressSpace->GetLockingTask();
+    pmTask* lLockingTask = pAddressSpace->GetExclusiveLockingTask();   // Requests of read only tasks are shared amongst all readers and are not tied to any task
     
     uint lOriginatingHost = lLockingTask ? (uint)(*(lLockingTask->GetOriginatingHost())) : std::numeric_limits<uint>::max();
-    ulong lSequenceNumber = lLockingTask ? lLockingTask->GetSequenceNumber() : std::numeric_limits<ulong>::max();
+    ulong lSequenceNumber = lLockingTask ? lLockingTask->GetSequenceNumber() : pAddressSpace->GetLockEpoch();
 
 	finalize_ptr<communicator::memoryTransferRequest> lData(new communicator::memoryTransferRequest(pRangeOwner.memIdentifier, communicator::memoryIdentifierStruct(*pAddressSpace->GetMemOwnerHost(), pAddressSpace->GetGenerationNumber()), pTransferType, pOffset, pRangeOwner.hostOffset, pLength, pStep, pCount, *PM_LOCAL_MACHINE, 0, (ushort)(lLockingTask != NULL), lOriginatingHost, lSequenceNumber, pPriority));
     
@@ -576,7 +1093,7 @@ void pmLinuxMemoryManager::FetchNonOverlappingMemoryRegion(ushort pPriority, pmA
 
 #ifdef ENABLE_TASK_PROFILING
     if(lLockingTask)
-        pAddressSpace->GetLockingTask()->GetTaskProfiler()->RecordProfileEvent(lLockingTask->IsReadOnly(pAddressSpace) ? taskProfiler::INPUT_MEMORY_TRANSFER : taskProfiler::OUTPUT_MEMORY_TRANSFER, true);
+        lLockingTask->GetTaskProfiler()->RecordProfileEvent(lLockingTask->IsReadOnly(pAddressSpace) ? taskProfiler::INPUT_MEMORY_TRANSFER : taskProfiler::OUTPUT_MEMORY_TRANSFER, true);
 #endif
     
     MEM_REQ_DUMP(pAddressSpace, pMem, pOffset, pRangeOwner.hostOffset, pLength, pStep, pCount, (uint)(*pRangeOwner.host));
@@ -587,10 +1104,10 @@ void pmLinuxMemoryManager::FetchNonOverlappingMemoryRegion(ushort pPriority, pmA
 // This method must be called with mInFlightLock on mInFlightMap of the address space acquired
 void pmLinuxMemoryManager::FetchNonOverlappingScatteredMemoryRegions(ushort pPriority, pmAddressSpace* pAddressSpace, void* pMem, std::vector<std::tuple<pmScatteredSubscriptionInfo, vmRangeOwner, pmCommandPtr>>& pVector, std::vector<pmCommandPtr>& pCommandVector)
 {
-    pmTask* lLockingTask = pAddressSpace->GetLockingTask();
+    pmTask* lLockingTask = pAddressSpace->GetExclusiveLockingTask();   // Requests of read only tasks are shared amongst all readers and are not tied to any task
     
     uint lOriginatingHost = lLockingTask ? (uint)(*(lLockingTask->GetOriginatingHost())) : std::numeric_limits<uint>::max();
-    ulong lSequenceNumber = lLockingTask ? lLockingTask->GetSequenceNumber() : std::numeric_limits<ulong>::max();
+    ulong lSequenceNumber = lLockingTask ? lLockingTask->GetSequenceNumber() : pAddressSpace->GetLockEpoch();
     
     finalize_ptr<std::vector<communicator::scatteredMemoryTransferRequestCombinedStruct>> lAutoPtr(new std::vector<communicator::scatteredMemoryTransferRequestCombinedStruct>());
     std::vector<communicator::scatteredMemoryTransferRequestCombinedStruct>* lVector = lAutoPtr.get_ptr();
@@ -608,7 +1125,7 @@ void pmLinuxMemoryManager::FetchNonOverlappingScatteredMemoryRegions(ushort pPri
     
     #ifdef ENABLE_TASK_PROFILING
         if(lLockingTask)
-            pAddressSpace->GetLockingTask()->GetTaskProfiler()->RecordProfileEvent(lLockingTask->IsReadOnly(pAddressSpace) ? taskProfiler::INPUT_MEMORY_TRANSFER : taskProfiler::OUTPUT_MEMORY_TRANSFER, true);
+            lLockingTask->GetTaskProfiler()->RecordProfileEvent(lLockingTask->IsReadOnly(pAddressSpace) ? taskProfiler::INPUT_MEMORY_TRANSFER : taskProfiler::OUTPUT_MEMORY_TRANSFER, true);
     #endif
      
         pCommandVector.emplace_back(lCommandPtr);
@@ -643,52 +1160,114 @@ void pmLinuxMemoryManager::SetLazyProtection(void* pAddr, size_t pLength, bool p
         PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::MEM_PROT_RW_FAILED));
 }
 
-void pmLinuxMemoryManager::LoadLazyMemoryPage(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, void* pLazyMemAddr, uint pForwardPrefetchPageCount)
+/* Adapts the stub's prefetch window to its recent faults on the address space. Faults landing within (or just past) the last window are
+ * sequential and faults repeating the last distance are strided; both double the window, while any other (random) fault halves it.
+ * The faulting page and the predicted pages are added to pRanges (as byte ranges) in the order they are expected to be accessed. */
+void pmLinuxMemoryManager::PredictLazyMemoryPages(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, size_t pPage, size_t pPageCount, std::vector<pmSubscriptionInfo>& pRanges)
 {
-	size_t lPageSize = GetVirtualMemoryPageSize();
-    size_t lBytesToBeFetched = (1 + pForwardPrefetchPageCount) * lPageSize;
+    linuxMemManager::lazyFaultHistory* lHistory = NULL;
 
-	size_t lStartAddr = reinterpret_cast<size_t>(pAddressSpace->GetMem());
-	size_t lLength = pAddressSpace->GetLength();
-	size_t lLastAddr = lStartAddr + lLength;
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dLazyFaultHistoryLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mLazyFaultHistoryLock, Lock(), Unlock());
+        lHistory = &mLazyFaultHistoryMap[pStub];
+    }
 
-	size_t lMemAddr = reinterpret_cast<size_t>(pLazyMemAddr);
-	size_t lPageAddr = GET_VM_PAGE_START_ADDRESS(lMemAddr, lPageSize);
+    long lDelta = (long)pPage - (long)lHistory->mLastPage;
+    bool lStrided = false;
 
-	size_t lOffset = lPageAddr - lStartAddr;
-	size_t lLeftoverLength = lLastAddr - lPageAddr;
+    if(lHistory->mAddressSpace != pAddressSpace)
+    {
+        lHistory->mAddressSpace = pAddressSpace;
+        lHistory->mStride = 0;
+        lHistory->mPrefetchPages = LAZY_FORWARD_PREFETCH_PAGE_COUNT;
+    }
+    else if(lDelta > 0 && (size_t)lDelta <= lHistory->mPrefetchPages + 1)
+    {
+        lHistory->mPrefetchPages = std::min<size_t>(std::max<size_t>(2 * lHistory->mPrefetchPages, 1), LAZY_MAX_PREFETCH_PAGE_COUNT);
+    }
+    else if(lDelta != 0 && lDelta == lHistory->mStride)
+    {
+        lHistory->mPrefetchPages = std::min<size_t>(std::max<size_t>(2 * lHistory->mPrefetchPages, 1), LAZY_MAX_PREFETCH_PAGE_COUNT);
+        lStrided = true;
+    }
+    else if(lDelta != 0)
+    {
+        lHistory->mPrefetchPages /= 2;
+    }
 
-	if(lLeftoverLength > lBytesToBeFetched)
-		lLeftoverLength = lBytesToBeFetched;
+    if(lDelta != 0)
+        lHistory->mStride = lDelta;
 
-    pmTask* lLockingTask = pAddressSpace->GetLockingTask();
-    ushort lPriority = (lLockingTask ? lLockingTask->GetPriority() : MAX_CONTROL_PRIORITY);
-    
-    if(!pAddressSpace->IsRegionLocallyOwned(lOffset, ((lLeftoverLength > lPageSize) ? lPageSize : lLeftoverLength)))
+    lHistory->mLastPage = pPage;
+
+    size_t lPageSize = GetVirtualMemoryPageSize();
+
+    if(lStrided)
     {
-        // We want to fetch lazy memory page and prefetch pages collectively. But we do want this thread to resume execution as soon as
-        // lazy memory page is fetched without waiting for prefetch pages to come. To do this, we make two FetchMemory requests - first with
-        // lazy memory page and prefetch pages and second with lazy memory page only. The in-flight memory system will piggy back second
-        // request onto the first one. The current thread only waits on commands returned by second FetchMemory statement.
-        std::vector<pmCommandPtr> lCommandVector;
-        if(pForwardPrefetchPageCount)
-            FetchMemoryRegion(pAddressSpace, lPriority, lOffset, lLeftoverLength, lCommandVector);
+        pRanges.emplace_back(pPage * lPageSize, lPageSize);
 
-        lCommandVector.clear();
-        FetchMemoryRegion(pAddressSpace, lPriority, lOffset, ((lLeftoverLength > lPageSize) ? lPageSize : lLeftoverLength), lCommandVector);
+        long lPage = (long)pPage;
+        for(size_t i = 0; i < lHistory->mPrefetchPages; ++i)
+        {
+            lPage += lHistory->mStride;
+            if(lPage < 0 || (size_t)lPage >= pPageCount)
+                break;
 
-        pStub->WaitForNetworkFetch(lCommandVector);
+            pRanges.emplace_back((size_t)lPage * lPageSize, lPageSize);
+        }
+    }
+    else
+    {
+        // Contiguous pages are requested together, so that the memory directory issues a single transfer per owner
+        pRanges.emplace_back(pPage * lPageSize, (std::min(pPage + 1 + lHistory->mPrefetchPages, pPageCount) - pPage) * lPageSize);
     }
 }
 
 void pmLinuxMemoryManager::LoadLazyMemoryPage(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, void* pLazyMemAddr)
 {
-    LoadLazyMemoryPage(pStub, pAddressSpace, pLazyMemAddr, pAddressSpace->GetLazyForwardPrefetchPageCount());
+	size_t lPageSize = GetVirtualMemoryPageSize();
+	size_t lStartAddr = reinterpret_cast<size_t>(pAddressSpace->GetMem());
+	size_t lLength = pAddressSpace->GetLength();
+    size_t lPageCount = (lLength + lPageSize - 1) / lPageSize;
+
+	size_t lPageAddr = GET_VM_PAGE_START_ADDRESS(reinterpret_cast<size_t>(pLazyMemAddr), lPageSize);
+	size_t lOffset = lPageAddr - lStartAddr;
+    size_t lPageLength = std::min(lPageSize, lLength - lOffset);
+
+    std::vector<pmSubscriptionInfo> lRanges;
+    PredictLazyMemoryPages(pStub, pAddressSpace, lOffset / lPageSize, lPageCount, lRanges);
+
+    // The last page may be partial
+    for_each(lRanges, [&] (pmSubscriptionInfo& pRange)
+    {
+        if(pRange.offset + pRange.length > lLength)
+            pRange.length = lLength - pRange.offset;
+    });
+
+    // Read only tasks may share the address space; the fetch is issued at the priority of the faulting stub's task
+    pmTask* lTask = pStub->GetCurrentTask();
+    ushort lPriority = (lTask ? lTask->GetPriority() : MAX_CONTROL_PRIORITY);
+
+    // The faulting page and predicted pages are fetched collectively, but this thread resumes as soon as the faulting page
+    // arrives. For this, the faulting page alone is requested again after the collective request; the in-flight memory
+    // system piggy backs it onto the first request and the current thread only waits on the commands of the second one.
+    // Pages already local or in flight (possibly requested by another stub) are skipped by the memory directory.
+    std::vector<pmCommandPtr> lCommandVector;
+    FetchMemoryRegions(pAddressSpace, lPriority, lRanges, lCommandVector);
+
+    if(!pAddressSpace->IsRegionLocallyOwned(lOffset, lPageLength))
+    {
+        lCommandVector.clear();
+        FetchMemoryRegion(pAddressSpace, lPriority, lOffset, lPageLength, lCommandVector);
+
+        pStub->WaitForNetworkFetch(lCommandVector, true);
+    }
 }
 
 void pmLinuxMemoryManager::CopyLazyInputMemPage(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, void* pFaultAddr)
 {
-    DEBUG_EXCEPTION_ASSERT(!pAddressSpace->GetLockingTask()->IsWritable(pAddressSpace) && pAddressSpace->GetLockingTask()->IsLazy(pAddressSpace));
+    DEBUG_EXCEPTION_ASSERT(pStub->GetCurrentTask() && !pStub->GetCurrentTask()->IsWritable(pAddressSpace) && pStub->GetCurrentTask()->IsLazy(pAddressSpace));
 
 	size_t lPageSize = GetVirtualMemoryPageSize();
 	size_t lMemAddr = reinterpret_cast<size_t>(pFaultAddr);
@@ -699,12 +1278,21 @@ void pmLinuxMemoryManager::CopyLazyInputMemPage(pmExecutionStub* pStub, pmAddres
     void* lSrcAddr = reinterpret_cast<void*>(reinterpret_cast<size_t>(pAddressSpace->GetMem()) + lOffset);
 
     LoadLazyMemoryPage(pStub, pAddressSpace, lSrcAddr);
-    SetLazyProtection(lDestAddr, lPageSize, true, true);    // we may actually not allow writes here at all and abort if a write access is done to RO memory
+
+    // Pages following the faulting one, which are already local, are unprotected along with it to save their faults
+    size_t lUnprotectLength = lPageSize;
+    size_t lLength = pAddressSpace->GetLength();
+    size_t lRunLength = std::min(LAZY_FORWARD_PREFETCH_PAGE_COUNT * lPageSize, (lOffset + lPageSize < lLength) ? (lLength - lOffset - lPageSize) : 0);
+
+    if(lRunLength && pAddressSpace->IsRegionLocallyOwned(lOffset + lPageSize, lRunLength))
+        lUnprotectLength += GET_VM_PAGE_START_ADDRESS(lRunLength, lPageSize);
+
+    SetLazyProtection(lDestAddr, lUnprotectLength, true, true);    // we may actually not allow writes here at all and abort if a write access is done to RO memory
 }
 
 void pmLinuxMemoryManager::CopyShadowMemPage(pmExecutionStub* pStub, ulong pSubtaskId, pmSplitInfo* pSplitInfo, pmAddressSpace* pAddressSpace, pmTask* pTask, size_t pShadowMemOffset, void* pShadowMemBaseAddr, void* pFaultAddr)
 {
-    DEBUG_EXCEPTION_ASSERT(!pAddressSpace->GetLockingTask()->IsReadOnly(pAddressSpace) && pAddressSpace->GetLockingTask()->IsLazyReadWrite(pAddressSpace));
+    DEBUG_EXCEPTION_ASSERT(!pTask->IsReadOnly(pAddressSpace) && pTask->IsLazyReadWrite(pAddressSpace));
 
 	size_t lPageSize = GetVirtualMemoryPageSize();
 	size_t lMemAddr = reinterpret_cast<size_t>(pFaultAddr);
@@ -771,31 +1359,35 @@ void pmLinuxMemoryManager::InstallSegFaultHandler()
 	lSigAction.sa_sigaction = SegFaultHandler;
 
 #ifdef MACOS
-	if(sigaction(SIGBUS, &lSigAction, NULL) != 0)
+	if(sigaction(SIGBUS, &lSigAction, &mPreviousSegFaultAction) != 0)
 		PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::SEGFAULT_HANDLER_INSTALL_FAILED));
 #else
-	if(sigaction(SIGSEGV, &lSigAction, NULL) != 0)
+	if(sigaction(SIGSEGV, &lSigAction, &mPreviousSegFaultAction) != 0)
 		PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::SEGFAULT_HANDLER_INSTALL_FAILED));
 #endif
 }
 
 void pmLinuxMemoryManager::UninstallSegFaultHandler()
 {
-	struct sigaction lSigAction;
-
-	lSigAction.sa_flags = SA_SIGINFO;
-	sigemptyset(&lSigAction.sa_mask);
-	lSigAction.sa_handler = SIG_DFL;
-
 #ifdef MACOS
-	if(sigaction(SIGBUS, &lSigAction, NULL) != 0)
+	if(sigaction(SIGBUS, &mPreviousSegFaultAction, NULL) != 0)
 		PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::SEGFAULT_HANDLER_UNINSTALL_FAILED));
 #else
-	if(sigaction(SIGSEGV, &lSigAction, NULL) != 0)
+	if(sigaction(SIGSEGV, &mPreviousSegFaultAction, NULL) != 0)
 		PMTHROW(pmVirtualMemoryException(pmVirtualMemoryException::SEGFAULT_HANDLER_UNINSTALL_FAILED));
 #endif
 }
 
+/* Faults not caused by lazy memory are genuine. The previous handler (or the default action) is restored, so that the faulting instruction,
+ * when re-executed on return, reports the fault at its origin instead of inside this handler. */
+void PassOnSegFault(int pSignalNum)
+{
+    pmLinuxMemoryManager* lMemoryManager = dynamic_cast<pmLinuxMemoryManager*>(MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager());
+
+    if(sigaction(pSignalNum, &lMemoryManager->mPreviousSegFaultAction, NULL) != 0)
+        abort();
+}
+
 void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext)
 {
     ACCUMULATION_TIMER(Timer_ACC, "SegFaultHandler");
@@ -804,7 +1396,10 @@ void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext)
     pmExecutionStub* lStub = static_cast<pmExecutionStub*>(lPair.first);
     void* lSubtaskPtr = lPair.second;
     if(!lStub || !lSubtaskPtr)
-        abort();
+    {
+        PassOnSegFault(pSignalNum);
+        return;
+    }
 
     pmSubtaskTerminationCheckPointAutoPtr lSubtaskTerminationCheckPointAutoPtr(lStub);
 
@@ -817,6 +1412,7 @@ void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext)
         void* lShadowMemBaseAddr = NULL;
 
         pmLinuxMemoryManager* lMemoryManager = dynamic_cast<pmLinuxMemoryManager*>(MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager());
+        double lFaultStartTime = pmBase::GetCurrentTimeInSecs();
 
     #ifdef TRACK_MEMORY_ALLOCATIONS
         // Auto lock/unlock scope
@@ -830,7 +1426,12 @@ void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext)
         pmAddressSpace* lAddressSpace = pmAddressSpace::FindAddressSpaceContainingLazyAddress((void*)(pSigInfo->si_addr));
         if(lAddressSpace)
         {
+            // The address space may be shared by several read only tasks; the fault is charged to the faulting stub's
+            pmTask* lTask = lStub->GetCurrentTask();
+            EXCEPTION_ASSERT(lTask);
+
             lMemoryManager->CopyLazyInputMemPage(lStub, lAddressSpace, (void*)(pSigInfo->si_addr));
+            lTask->GetTaskExecStats().RecordLazyFault(lStub, pmBase::GetCurrentTimeInSecs() - lFaultStartTime);
         }
         else    /* Check if the address belongs to a lazy read write/write only memory */
         {
@@ -869,10 +1470,12 @@ void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext)
                     lTask->GetSubscriptionManager().AddWriteOnlyLazyUnprotection(lStub, lSubtaskId, lSplitInfoPtr, lAddressSpaceIndex, lMemOffset / lPageSize);
                     lTask->GetSubscriptionManager().InitializeWriteOnlyLazyMemory(lStub, lSubtaskId, lSplitInfoPtr, lAddressSpaceIndex, lTask, lAddressSpace, lOffset, reinterpret_cast<void*>(lPageAddr), lPageSize);
                 }
+
+                lTask->GetTaskExecStats().RecordLazyFault(lStub, pmBase::GetCurrentTimeInSecs() - lFaultStartTime);
             }
             else
             {
-                abort();
+                PassOnSegFault(pSignalNum);
             }
         }
     }
@@ -883,13 +1486,27 @@ void SegFaultHandler(int pSignalNum, siginfo_t* pSigInfo, void* pContext)
     {
         abort();
     }
+#else
+    PassOnSegFault(pSignalNum);
 #endif
 }
 
 linuxMemManager::addressSpaceSpecifics::addressSpaceSpecifics()
     : mSharedMemDescriptor(-1)
+    , mMappedLength(0)
+    , mSwappedRegions(0)
 {
 }
+
+#ifdef SUPPORT_LAZY_MEMORY
+linuxMemManager::lazyFaultHistory::lazyFaultHistory()
+    : mAddressSpace(NULL)
+    , mLastPage(0)
+    , mStride(0)
+    , mPrefetchPages(LAZY_FORWARD_PREFETCH_PAGE_COUNT)
+{
+}
+#endif
     
 /* pmLinuxMemoryManager::sharedMemAutoPtr */
 pmLinuxMemoryManager::sharedMemAutoPtr::sharedMemAutoPtr(const char* pSharedMemName)
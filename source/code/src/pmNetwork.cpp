@@ -44,6 +44,14 @@
 #include "pmLogger.h"
 #include "pmTask.h"
 #include "pmTaskManager.h"
+#include "pmReducer.h"
+#include "pmNetworkCompression.h"
+
+#include <algorithm>
+
+#ifdef DUMP_NETWORK_STATS
+#include <sstream>
+#endif
 
 namespace pm
 {
@@ -54,6 +62,7 @@ using namespace communicator;
 pmCluster* PM_GLOBAL_CLUSTER = NULL;
 
 const uint MIN_SEND_REQUESTS_TO_TRIGGER_CLEANUP = 256;
+const double MAX_SEND_COMPLETION_WAIT_AT_TERMINATION = 2.0;    // in secs
 
 //#define ENABLE_MPI_DEBUG_HOOK
 
@@ -161,10 +170,19 @@ pmMPI::pmMPI()
     : pmNetwork()
     , mTotalHosts(0)
     , mHostId(0)
+    , mWaitingOnProgressRequests(false)
     , mDummyRequestInitiated(false)
+    , mDummyRequestActive(false)
     , mPersistentDummyRecvRequest(MPI_REQUEST_NULL)
+    , mProgressWakeups(0)
+    , mProgressCompletions(0)
+    , mDummyOnlyWakeups(0)
+    , mMaxCompletionsPerWakeup(0)
     , mResourceLock __LOCK_NAME__("pmMPI::mResourceLock")
     , mDataTypesResourceLock __LOCK_NAME__("pmMPI::mDataTypesResourceLock")
+    , mUserReductionDataTypes(MAX_USER_REDUCTION_OPERATIONS, MPI_DATATYPE_NULL)
+    , mUserReductionOperations(MAX_USER_REDUCTION_OPERATIONS, MPI_OP_NULL)
+    , mUserReductionOperationDefinitions(MAX_USER_REDUCTION_OPERATIONS)
 	, mThreadTerminationFlag(false)
     , mReceiveThread(NULL)
 {
@@ -294,6 +312,15 @@ pmMPI::~pmMPI()
     mSubCommunicators.clear();
 #endif
 
+    for(size_t i = 0; i < MAX_USER_REDUCTION_OPERATIONS; ++i)
+    {
+        if(mUserReductionOperations[i] != MPI_OP_NULL)
+            MPI_CALL("MPI_Op_free", MPI_Op_free(&mUserReductionOperations[i]));
+
+        if(mUserReductionDataTypes[i] != MPI_DATATYPE_NULL)
+            MPI_CALL("MPI_Type_free", MPI_Type_free(&mUserReductionDataTypes[i]));
+    }
+
     if( MPI_CALL("MPI_Finalize", (MPI_Finalize() != MPI_SUCCESS)) )
         PMTHROW(pmNetworkException(pmNetworkException::FINALIZE_ERROR));
 
@@ -1290,6 +1317,24 @@ void pmMPI::SendNonBlocking(pmCommunicatorCommandPtr& pCommand)
 		SendNonBlockingInternal(pCommand, (void*)((char*)lData + lBlocks *MPI_TRANSFER_MAX_LIMIT), (uint)lLastBlockLength);
 }
 
+/* Runs on network thread (with mResourceLock acquired) when the data message of a memory transfer completes on the sender.
+ * The command is timed from the post of the send to its completion, which includes the receiver's posting of the matching receive.
+ */
+static void MemorySendCommandCompletionCallback(const pmCommandPtr& pCommand)
+{
+    if(pCommand->GetStatus() != pmSuccess)
+        return;
+
+    pmCommunicatorCommandPtr lCommunicatorCommand = std::dynamic_pointer_cast<pmCommunicatorCommandBase>(pCommand);
+    const memoryReceiveStruct* lData = static_cast<const memoryReceiveStruct*>(lCommunicatorCommand->GetData());
+
+    ulong lLength = lData->compressedLength;
+    if(lData->codec == networkCompression::CODEC_NONE)
+        lLength = lData->length * ((lData->transferType == TRANSFER_GENERAL) ? 1 : lData->count);
+
+    pmNetworkCompressor::GetNetworkCompressor()->RecordTransfer(lLength, pCommand->GetExecutionTimeInSecs());
+}
+
 void pmMPI::SendMemory(pmCommunicatorCommandPtr& pCommand)
 {
     memoryReceiveStruct* lData = (memoryReceiveStruct*)(pCommand->GetData());
@@ -1312,6 +1357,17 @@ void pmMPI::SendMemory(pmCommunicatorCommandPtr& pCommand)
     SendNonBlockingInternal(pCommand, lData, 1);
     
     lClonePtr->SetTag((communicator::communicatorCommandTags)lData->mpiTag);
+    lClonePtr->SetCommandCompletionCallback(MemorySendCommandCompletionCallback);
+    lClonePtr->MarkExecutionStart();
+
+    // Compressed memory (see pmNetworkCompressor) is held as the command's external data and sent as bytes
+    if(lData->codec != networkCompression::CODEC_NONE)
+    {
+        EXCEPTION_ASSERT(lClonePtr->GetExternalData() && lData->compressedLength <= (ulong)__MAX_SIGNED(int));
+
+        SendNonBlockingInternal(lClonePtr, const_cast<void*>(lClonePtr->GetExternalData()), (int)lData->compressedLength, MPI_BYTE);
+        return;
+    }
 
     int lRows = ((lData->transferType == TRANSFER_GENERAL) ? 1 : (int)lData->count);
     int lCols = ((lData->transferType == TRANSFER_GENERAL) ? (int)lData->length : (int)lData->step);
@@ -1340,6 +1396,22 @@ void pmMPI::ReceiveMemory(pmCommunicatorCommandPtr& pCommand)
 
     pCommand->MarkExecutionStart();
 
+    // Compressed memory is received in the command's external data and decompressed by the heavy operations thread
+    if(lData->codec != networkCompression::CODEC_NONE)
+    {
+        EXCEPTION_ASSERT(pCommand->GetExternalData() && lData->compressedLength <= (ulong)__MAX_SIGNED(int));
+
+        void* lCompressedMem = const_cast<void*>(pCommand->GetExternalData());
+        
+    #ifdef PROCESS_METADATA_RECEIVE_IN_NETWORK_THREAD
+        ReceiveNonBlockingInternalForMemoryReceive(pCommand, lCompressedMem, (int)lData->compressedLength, MPI_BYTE);
+    #else
+        ReceiveNonBlockingInternal(pCommand, lCompressedMem, (int)lData->compressedLength, MPI_BYTE);
+    #endif
+        
+        return;
+    }
+
     int lRows = ((lData->transferType == TRANSFER_GENERAL) ? 1 : (int)lData->count);
     int lCols = ((lData->transferType == TRANSFER_GENERAL) ? (int)lData->length : (int)lData->step);
 
@@ -1360,11 +1432,63 @@ bool pmMPI::IsImplicitlyReducible(pmTask* pTask) const
     return (GetReducibleDataTypeAndSize(pTask, lSize) != MPI_DATATYPE_NULL && GetReductionMpiOperation(pTask) != MPI_OP_NULL);
 }
 
+void pmMPI::RegisterUserReductionOperation(uint pSlot, const pmReductionOperation& pOperation)
+{
+    EXCEPTION_ASSERT(pSlot < MAX_USER_REDUCTION_OPERATIONS && mUserReductionDataTypes[pSlot] == MPI_DATATYPE_NULL);
+
+	bool lError = false;
+	MPI_Datatype lNewType = MPI_DATATYPE_NULL;
+    MPI_Op lNewOp = MPI_OP_NULL;
+
+	if( (MPI_CALL("MPI_Type_contiguous", (MPI_Type_contiguous((int)pOperation.elemSize, MPI_BYTE, &lNewType) != MPI_SUCCESS))) || (MPI_CALL("MPI_Type_commit", (MPI_Type_commit(&lNewType) != MPI_SUCCESS))) )
+		lError = true;
+
+    if(!lError && MPI_CALL("MPI_Op_create", (MPI_Op_create(UserReductionMpiOperation, (pOperation.commutative ? 1 : 0), &lNewOp) != MPI_SUCCESS)))
+        lError = true;
+
+	if(lError || lNewType == MPI_DATATYPE_NULL || lNewOp == MPI_OP_NULL)
+		PMTHROW(pmNetworkException(pmNetworkException::DATA_TYPE_REGISTRATION));
+
+    mUserReductionOperationDefinitions[pSlot] = pOperation;
+    mUserReductionOperations[pSlot] = lNewOp;
+    mUserReductionDataTypes[pSlot] = lNewType;
+}
+
+/* MPI computes pInOutVec = pInVec op pInOutVec, while user reduction functions compute pInOut = pInOut op pIn */
+void pmMPI::UserReductionMpiOperation(void* pInVec, void* pInOutVec, int* pLength, MPI_Datatype* pDataType)
+{
+    pmMPI* lNetwork = static_cast<pmMPI*>(NETWORK_IMPLEMENTATION_CLASS::GetNetwork());
+
+    auto lIter = std::find(lNetwork->mUserReductionDataTypes.begin(), lNetwork->mUserReductionDataTypes.end(), *pDataType);
+    EXCEPTION_ASSERT(lIter != lNetwork->mUserReductionDataTypes.end());
+
+    const pmReductionOperation& lOperation = lNetwork->mUserReductionOperationDefinitions[lIter - lNetwork->mUserReductionDataTypes.begin()];
+
+    if(lOperation.commutative)
+    {
+        lOperation.function(pInOutVec, pInVec, (ulong)(*pLength));
+    }
+    else
+    {
+        size_t lBytes = (size_t)(*pLength) * lOperation.elemSize;
+        std::unique_ptr<char[]> lTempPtr(new char[lBytes]);
+
+        memcpy(lTempPtr.get(), pInVec, lBytes);
+        lOperation.function(lTempPtr.get(), pInOutVec, (ulong)(*pLength));
+        memcpy(pInOutVec, lTempPtr.get(), lBytes);
+    }
+}
+
 MPI_Datatype pmMPI::GetReducibleDataTypeAndSize(pmTask* pTask, size_t& pSize) const
 {
     const pmDataReductionCallback lDataReductionCallback = pTask->GetCallbackUnit()->GetDataReductionCB()->GetCallback();
     
-    if(reductionDataTypeMatches<REDUCE_INTS>(lDataReductionCallback))
+    if(const reducer::userReductionOperation* lUserOperation = pmReducer::FindUserReductionOperation(lDataReductionCallback))
+    {
+        pSize = lUserOperation->operation.elemSize;
+        return mUserReductionDataTypes[lUserOperation->slot];
+    }
+    else if(reductionDataTypeMatches<REDUCE_INTS>(lDataReductionCallback))
     {
         pSize = sizeof(int);
         return MPI_INT;
@@ -1402,7 +1526,11 @@ MPI_Op pmMPI::GetReductionMpiOperation(pmTask* pTask) const
 {
     const pmDataReductionCallback lDataReductionCallback = pTask->GetCallbackUnit()->GetDataReductionCB()->GetCallback();
     
-    if(reductionOperationMatches<REDUCE_ADD>(lDataReductionCallback))
+    if(const reducer::userReductionOperation* lUserOperation = pmReducer::FindUserReductionOperation(lDataReductionCallback))
+    {
+        return mUserReductionOperations[lUserOperation->slot];
+    }
+    else if(reductionOperationMatches<REDUCE_ADD>(lDataReductionCallback))
     {
         return MPI_SUM;
     }
@@ -1511,9 +1639,7 @@ void pmMPI::SendReduce(pmCommunicatorCommandPtr& pCommand)
 
     FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
     
-    EXCEPTION_ASSERT(mNonBlockingRequestMap.find(lRequest) == mNonBlockingRequestMap.end());
-
-    mNonBlockingRequestMap.emplace(lRequest, pCommand);
+    AddProgressRequest(lRequest, pCommand);
     
     mRequestCountMap.emplace(std::piecewise_construct, std::forward_as_tuple(pCommand), std::forward_as_tuple(1));
 
@@ -1575,9 +1701,7 @@ void pmMPI::ReceiveReduce(pmCommunicatorCommandPtr& pCommand)
 
     FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
     
-    EXCEPTION_ASSERT(mNonBlockingRequestMap.find(lRequest) == mNonBlockingRequestMap.end());
-
-    mNonBlockingRequestMap.emplace(lRequest, pCommand);
+    AddProgressRequest(lRequest, pCommand);
     
     mRequestCountMap.emplace(std::piecewise_construct, std::forward_as_tuple(pCommand), std::forward_as_tuple(1));
 
@@ -1711,13 +1835,11 @@ void pmMPI::SendNonBlockingInternal(pmCommunicatorCommandPtr& pCommand, void* pD
 
     decltype(mRequestCountMap)::iterator lIter = mRequestCountMap.find(pCommand);
 
-    // Not all send requests need to break the MPI_Waitany loop in network thread by completing a dummy command.
-    // Only commands having the user callback registered need to be added to MPI_Waitany array.
+    // Not all send requests need to break the MPI_Waitsome loop in network thread by completing a dummy command.
+    // Only commands having the user callback registered need to be added to MPI_Waitsome array.
     if(pCommand->GetCommandCompletionCallback() || lIter != mRequestCountMap.end())
     {
-        DEBUG_EXCEPTION_ASSERT(mNonBlockingRequestMap.find(lRequest) == mNonBlockingRequestMap.end());
-
-        mNonBlockingRequestMap.emplace(lRequest, pCommand);
+        AddProgressRequest(lRequest, pCommand);
         
         if(lIter == mRequestCountMap.end())
             lIter = mRequestCountMap.emplace(std::piecewise_construct, std::forward_as_tuple(pCommand), std::forward_as_tuple(1)).first;
@@ -1730,7 +1852,8 @@ void pmMPI::SendNonBlockingInternal(pmCommunicatorCommandPtr& pCommand, void* pD
     }
     else
     {
-        mOngoingSendRequests.emplace_back(lRequest, pCommand);
+        mOngoingSendRequests.emplace_back(lRequest);
+        mOngoingSendCommands.emplace_back(pCommand);
     }
 }
 
@@ -1761,9 +1884,7 @@ void pmMPI::ReceiveNonBlockingInternal(pmCommunicatorCommandPtr& pCommand, void*
 
 	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
     
-    EXCEPTION_ASSERT(mNonBlockingRequestMap.find(lRequest) == mNonBlockingRequestMap.end());
-
-	mNonBlockingRequestMap.emplace(lRequest, pCommand);
+    AddProgressRequest(lRequest, pCommand);
 	
     decltype(mRequestCountMap)::iterator lIter = mRequestCountMap.find(pCommand);
 	if(lIter == mRequestCountMap.end())
@@ -1791,10 +1912,9 @@ void pmMPI::ReceiveNonBlockingInternalForMemoryReceive(pmCommunicatorCommandPtr&
 
     EXCEPTION_ASSERT(lRequest != MPI_REQUEST_NULL);
 
-    EXCEPTION_ASSERT(mNonBlockingRequestMap.find(lRequest) == mNonBlockingRequestMap.end());
     EXCEPTION_ASSERT(mRequestCountMap.find(pCommand) == mRequestCountMap.end());
 
-	mNonBlockingRequestMap.emplace(lRequest, pCommand);
+    AddProgressRequest(lRequest, pCommand);
     mRequestCountMap.emplace(std::piecewise_construct, std::forward_as_tuple(pCommand), std::forward_as_tuple(1));
 }
     
@@ -1875,9 +1995,29 @@ void pmMPI::TerminatePersistentCommand(pmCommunicatorCommandPtr& pCommand)
     }
 
     DEBUG_EXCEPTION_ASSERT(lRequest != MPI_REQUEST_NULL);
-    
-    mNonBlockingRequestMap.erase(lRequest);
-    
+
+    auto lPendingIter = std::find_if(mPendingProgressRequests.begin(), mPendingProgressRequests.end(), [&] (const std::pair<MPI_Request, pmCommunicatorCommandPtr>& pPair)
+    {
+        return (pPair.first == lRequest);
+    });
+
+    // A request in mProgressRequests can not be touched while the network thread waits on it. It is removed
+    // and freed by that thread, which is woken up through the dummy request.
+    if(mWaitingOnProgressRequests && lPendingIter == mPendingProgressRequests.end() && std::find(mProgressRequests.begin(), mProgressRequests.end(), lRequest) != mProgressRequests.end())
+    {
+        mTerminatedProgressRequests.emplace_back(lRequest, pCommand);
+        CancelDummyRequest();
+
+        return;
+    }
+
+    RemoveProgressRequest(lRequest);
+    FreePersistentRequest(lRequest, pCommand);
+}
+
+/* Must be called with mResourceLock acquired */
+void pmMPI::FreePersistentRequest(MPI_Request pRequest, const pmCommunicatorCommandPtr& pCommand)
+{
     decltype(mRequestCountMap)::iterator lRequestCountIter = mRequestCountMap.find(pCommand);
     if(lRequestCountIter != mRequestCountMap.end())
     {
@@ -1885,13 +2025,27 @@ void pmMPI::TerminatePersistentCommand(pmCommunicatorCommandPtr& pCommand)
         
         DEBUG_EXCEPTION_ASSERT(lRequestCountIter->second == 0);
 
-        mRequestCountMap.erase(pCommand);
+        mRequestCountMap.erase(lRequestCountIter);
     }
 
-	if( MPI_CALL("MPI_Request_free", (MPI_Request_free(&lRequest) != MPI_SUCCESS)) )
+	if( MPI_CALL("MPI_Request_free", (MPI_Request_free(&pRequest) != MPI_SUCCESS)) )
 		PMTHROW(pmNetworkException(pmNetworkException::REQUEST_FREE_ERROR));
 }
 
+/* Must be called with mResourceLock acquired and only when the network thread is not waiting on mProgressRequests */
+void pmMPI::FreeTerminatedProgressRequests()
+{
+    DEBUG_EXCEPTION_ASSERT(!mWaitingOnProgressRequests);
+
+    for_each(mTerminatedProgressRequests, [&] (std::pair<MPI_Request, pmCommunicatorCommandPtr>& pPair)
+    {
+        RemoveProgressRequest(pPair.first);
+        FreePersistentRequest(pPair.first, pPair.second);
+    });
+
+    mTerminatedProgressRequests.clear();
+}
+
 MPI_Request pmMPI::GetPersistentSendRequest(pmCommunicatorCommandPtr& pCommand)
 {
     FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
@@ -2220,6 +2374,7 @@ void pmMPI::RegisterTransferDataType(communicatorDataTypes pDataType)
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.subscriptionVisibility, lSubscriptionVisibilityMPI, MPI_UNSIGNED_SHORT, 4, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.flags, lFlagsMPI, MPI_UNSIGNED_SHORT, 5, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.addressSpaceType, lAddressSpaceTypeMPI, MPI_UNSIGNED_SHORT, 6, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.dataGeneration, lDataGenerationMPI, MPI_UNSIGNED_LONG, 7, 1);
 
             break;
         }
@@ -2272,6 +2427,7 @@ void pmMPI::RegisterTransferDataType(communicatorDataTypes pDataType)
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.offset, lOffsetMPI, MPI_UNSIGNED_LONG, 0, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.length, lLengthMPI, MPI_UNSIGNED_LONG, 1, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.newOwnerHost, lNewOwnerHostMPI, MPI_UNSIGNED, 2, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.notificationOnly, lNotificationOnlyMPI, MPI_UNSIGNED, 3, 1);
 
 			break;
 		}
@@ -2334,14 +2490,16 @@ void pmMPI::RegisterTransferDataType(communicatorDataTypes pDataType)
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.originatingHost, lOriginatingHostMPI, MPI_UNSIGNED, 1, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.sequenceNumber, lSequenceNumberMPI, MPI_UNSIGNED_LONG, 2, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.stealingDeviceExecutionRate, lStealingDeviceExecutionRateMPI, MPI_DOUBLE, 3, 1);
-			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.shouldMultiAssign, lShouldMultiAssignMPI, MPI_UNSIGNED_SHORT, 4, 1);
+			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.stealRoundTripTime, lStealRoundTripTimeMPI, MPI_DOUBLE, 4, 1);
+			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.shouldMultiAssign, lShouldMultiAssignMPI, MPI_UNSIGNED_SHORT, 5, 1);
         #else
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.stealingDeviceGlobalIndex, lStealingDeviceGlobalIndexMPI, MPI_UNSIGNED, 0, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.targetDeviceGlobalIndex, lTargetDeviceGlobalIndexMPI, MPI_UNSIGNED, 1, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.originatingHost, lOriginatingHostMPI, MPI_UNSIGNED, 2, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.sequenceNumber, lSequenceNumberMPI, MPI_UNSIGNED_LONG, 3, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.stealingDeviceExecutionRate, lStealingDeviceExecutionRateMPI, MPI_DOUBLE, 4, 1);
-			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.shouldMultiAssign, lShouldMultiAssignMPI, MPI_UNSIGNED_SHORT, 5, 1);
+			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.stealRoundTripTime, lStealRoundTripTimeMPI, MPI_DOUBLE, 5, 1);
+			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.shouldMultiAssign, lShouldMultiAssignMPI, MPI_UNSIGNED_SHORT, 6, 1);
         #endif
 
 			break;
@@ -2426,6 +2584,9 @@ void pmMPI::RegisterTransferDataType(communicatorDataTypes pDataType)
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.mpiTag, lMpiTagMPI, MPI_INT, 5, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.senderHost, lSenderHostMPI, MPI_UNSIGNED, 6, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.compressed, lCompressedMPI, MPI_UNSIGNED_SHORT, 7, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.segmentLength, lSegmentLengthMPI, MPI_UNSIGNED_LONG, 8, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.reductionStep, lReductionStepMPI, MPI_UNSIGNED, 9, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.messageType, lMessageTypeMPI, MPI_UNSIGNED_SHORT, 10, 1);
 
 			break;
 		}
@@ -2445,6 +2606,8 @@ void pmMPI::RegisterTransferDataType(communicatorDataTypes pDataType)
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.sequenceNumber, lSequenceNumberMPI, MPI_UNSIGNED_LONG, 9, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.mpiTag, lMpiTagMPI, MPI_INT, 10, 1);
             REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.senderHost, lSenderHostMPI, MPI_UNSIGNED, 11, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.codec, lCodecMPI, MPI_UNSIGNED_SHORT, 12, 1);
+            REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.compressedLength, lCompressedLengthMPI, MPI_UNSIGNED_LONG, 13, 1);
 
 			break;
 		}
@@ -2510,6 +2673,7 @@ void pmMPI::RegisterTransferDataType(communicatorDataTypes pDataType)
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.fileName, lFileNameMPI, MPI_CHAR, 0, MAX_FILE_SIZE_LEN);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.fileOp, lFileOpMPI, MPI_UNSIGNED_SHORT, 1, 1);
 			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.sourceHost, lSourceHostMPI, MPI_UNSIGNED, 2, 1);
+			REGISTER_MPI_DATA_TYPE_HELPER(lDataMPI, lData.generationNumber, lGenerationNumberMPI, MPI_UNSIGNED_LONG, 3, 1);
 
 			break;        
         }
@@ -2627,10 +2791,9 @@ void pmMPI::CommandComplete(pmCommunicatorCommandPtr& pCommand, pmStatus pStatus
         }
 
         DEBUG_EXCEPTION_ASSERT(lRequest != MPI_REQUEST_NULL);
-        DEBUG_EXCEPTION_ASSERT(mNonBlockingRequestMap.find(lRequest) == mNonBlockingRequestMap.end());
         DEBUG_EXCEPTION_ASSERT(mRequestCountMap.find(pCommand) == mRequestCountMap.end());
         
-        mNonBlockingRequestMap.emplace(lRequest, pCommand);
+        AddProgressRequest(lRequest, pCommand);
         mRequestCountMap.emplace(pCommand, 1);
     }
 }
@@ -2640,18 +2803,22 @@ void pmMPI::SetupDummyRequest()
 {
 	if(mPersistentDummyRecvRequest == MPI_REQUEST_NULL)
 	{
-        EXCEPTION_ASSERT(!mDummyRequestInitiated);
+        EXCEPTION_ASSERT(!mDummyRequestInitiated && !mDummyRequestActive);
 
         if( MPI_CALL("MPI_Recv_init", (MPI_Recv_init(NULL, 0, MPI_BYTE, mHostId, PM_MPI_DUMMY_TAG, MPI_COMM_WORLD, &mPersistentDummyRecvRequest) != MPI_SUCCESS)) )
             PMTHROW(pmNetworkException(pmNetworkException::DUMMY_REQUEST_CREATION_ERROR));
     }
 
-    if(!mDummyRequestInitiated)
+    // If a cancellation message has been sent but MPI_Waitsome has not consumed it yet, the
+    // dummy request is still active and must not be restarted. The pending message wakes up
+    // the network thread anyway.
+    if(!mDummyRequestActive)
     {
 		if( MPI_CALL("MPI_Start", (MPI_Start(&mPersistentDummyRecvRequest) != MPI_SUCCESS)) )
 			PMTHROW(pmNetworkException(pmNetworkException::DUMMY_REQUEST_CREATION_ERROR));
         
         mDummyRequestInitiated = true;
+        mDummyRequestActive = true;
 	}
 
     DEBUG_EXCEPTION_ASSERT(mPersistentDummyRecvRequest != MPI_REQUEST_NULL);
@@ -2672,6 +2839,151 @@ void pmMPI::CancelDummyRequest()
 	}
 }
 
+/* Must be called with mResourceLock acquired. The request is moved to mProgressRequests
+ * by the network thread before it next enters MPI_Waitsome.
+ */
+void pmMPI::AddProgressRequest(MPI_Request pRequest, pmCommunicatorCommandPtr& pCommand)
+{
+    DEBUG_EXCEPTION_ASSERT(pRequest != MPI_REQUEST_NULL);
+
+    mPendingProgressRequests.emplace_back(pRequest, pCommand);
+}
+
+/* Must be called with mResourceLock acquired and only when the network thread is not waiting on mProgressRequests */
+void pmMPI::RemoveProgressRequest(MPI_Request pRequest)
+{
+    auto lPendingIter = std::find_if(mPendingProgressRequests.begin(), mPendingProgressRequests.end(), [&] (const std::pair<MPI_Request, pmCommunicatorCommandPtr>& pPair)
+    {
+        return (pPair.first == pRequest);
+    });
+
+    if(lPendingIter != mPendingProgressRequests.end())
+    {
+        mPendingProgressRequests.erase(lPendingIter);
+        return;
+    }
+
+    // Slot 0 belongs to the dummy request
+    for(size_t i = 1, lCount = mProgressRequests.size(); i < lCount; ++i)
+    {
+        if(mProgressRequests[i] == pRequest)
+        {
+            mProgressRequests[i] = mProgressRequests.back();
+            mProgressCommands[i] = std::move(mProgressCommands.back());
+
+            mProgressRequests.pop_back();
+            mProgressCommands.pop_back();
+
+            return;
+        }
+    }
+}
+
+/* Must be called with mResourceLock acquired (on network thread only) */
+void pmMPI::MergePendingProgressRequests()
+{
+    DEBUG_EXCEPTION_ASSERT(mPersistentDummyRecvRequest != MPI_REQUEST_NULL);
+
+    if(mProgressRequests.empty())
+    {
+        mProgressRequests.emplace_back(mPersistentDummyRecvRequest);
+        mProgressCommands.emplace_back();
+    }
+
+    DEBUG_EXCEPTION_ASSERT(mProgressRequests[0] == mPersistentDummyRecvRequest);
+
+    for_each(mPendingProgressRequests, [&] (std::pair<MPI_Request, pmCommunicatorCommandPtr>& pPair)
+    {
+        mProgressRequests.emplace_back(pPair.first);
+        mProgressCommands.emplace_back(std::move(pPair.second));
+    });
+
+    mPendingProgressRequests.clear();
+}
+
+/* Must be called with mResourceLock acquired (on network thread only). The first pCompletedCount
+ * entries of mCompletedProgressIndices are the slots reported complete by MPI_Waitsome.
+ */
+void pmMPI::ProcessCompletedProgressRequests(int pCompletedCount)
+{
+    std::vector<pmCommunicatorCommandPtr> lCompletedCommands;
+    lCompletedCommands.reserve(pCompletedCount);
+    
+    std::vector<int>::iterator lBegin = mCompletedProgressIndices.begin(), lEnd = lBegin + pCompletedCount;
+    std::sort(lBegin, lEnd);
+
+    uint lCompletions = 0;
+
+    for(std::vector<int>::iterator lIter = lBegin; lIter != lEnd; ++lIter)
+    {
+        if(*lIter == 0)     // Dummy Request
+        {
+            mDummyRequestActive = false;
+            continue;
+        }
+
+        // A terminated persistent request is not completed; its slot is still removed below and it is freed afterwards
+        MPI_Request lRequest = mProgressRequests[*lIter];
+        if(lRequest != MPI_REQUEST_NULL && std::find_if(mTerminatedProgressRequests.begin(), mTerminatedProgressRequests.end(), [&] (const std::pair<MPI_Request, pmCommunicatorCommandPtr>& pPair) {return (pPair.first == lRequest);}) != mTerminatedProgressRequests.end())
+            continue;
+
+        ++lCompletions;
+
+        pmCommunicatorCommandPtr& lCommand = mProgressCommands[*lIter];
+        
+        typename decltype(mRequestCountMap)::iterator lRequestCountIter = mRequestCountMap.find(lCommand);
+        EXCEPTION_ASSERT(lRequestCountIter != mRequestCountMap.end());
+        
+        --lRequestCountIter->second;
+
+        if(lRequestCountIter->second == 0)
+        {
+            mRequestCountMap.erase(lRequestCountIter);
+            lCompletedCommands.emplace_back(lCommand);
+        }
+    }
+
+    // Remove completed slots in decreasing order so that the slot swapped in from the back is never a completed one
+    for(std::vector<int>::reverse_iterator lIter(lEnd), lREnd(lBegin); lIter != lREnd && *lIter != 0; ++lIter)
+    {
+        mProgressRequests[*lIter] = mProgressRequests.back();
+        mProgressCommands[*lIter] = std::move(mProgressCommands.back());
+
+        mProgressRequests.pop_back();
+        mProgressCommands.pop_back();
+    }
+
+    ++mProgressWakeups;
+    mProgressCompletions += lCompletions;
+
+    if(!lCompletions)
+        ++mDummyOnlyWakeups;
+
+    if(lCompletions > mMaxCompletionsPerWakeup)
+        mMaxCompletionsPerWakeup = lCompletions;
+
+    for_each(lCompletedCommands, [&] (pmCommunicatorCommandPtr& pCommand)
+    {
+        ushort lCommandType = pCommand->GetType();
+        EXCEPTION_ASSERT(lCommandType == SEND || lCommandType == BROADCAST || lCommandType == RECEIVE);
+
+        CommandComplete(pCommand, pmSuccess);
+    });
+}
+
+#ifdef DUMP_NETWORK_STATS
+/* Must be called with mResourceLock acquired */
+void pmMPI::DumpProgressStatistics()
+{
+    std::stringstream lStream;
+    lStream << std::endl << "Network Progress Stats [Host " << mHostId << "] ............ " << std::endl;
+    lStream << "Wakeups = " << mProgressWakeups << "; Completions = " << mProgressCompletions << "; Dummy only wakeups = " << mDummyOnlyWakeups;
+    lStream << "; Completions per wakeup = " << (mProgressWakeups ? ((double)mProgressCompletions / mProgressWakeups) : 0.0) << "; Max completions per wakeup = " << mMaxCompletionsPerWakeup << std::endl;
+
+    pmLogger::GetLogger()->LogDeferred(pmLogger::DEBUG_INTERNAL, pmLogger::INFORMATION, lStream.str().c_str());
+}
+#endif
+
 void pmMPI::StopThreadExecution()
 {
 	// Auto lock/unlock scope
@@ -2694,7 +3006,30 @@ void pmMPI::StopThreadExecution()
 
     FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
 
+    // A posted memory receive has its send already issued, which completes on the sender only after the data is drained here
+    auto lDrainMemoryReceive = [] (MPI_Request& pRequest, const pmCommunicatorCommandPtr& pCommand)
+    {
+        if(pCommand.get() && pCommand->GetType() == RECEIVE && !pCommand->IsPersistent() && pCommand->GetTag() > MAX_COMMUNICATOR_COMMAND_TAGS)
+        {
+            if( MPI_CALL("MPI_Wait", (MPI_Wait(&pRequest, MPI_STATUS_IGNORE) != MPI_SUCCESS)) )
+                PMTHROW(pmNetworkException(pmNetworkException::WAIT_ERROR));
+        }
+    };
+
+    for(size_t i = 1, lCount = mProgressRequests.size(); i < lCount; ++i)     // Slot 0 belongs to the dummy request
+        lDrainMemoryReceive(mProgressRequests[i], mProgressCommands[i]);
+
+    for_each(mPendingProgressRequests, [&] (std::pair<MPI_Request, pmCommunicatorCommandPtr>& pPair)
+    {
+        lDrainMemoryReceive(pPair.first, pPair.second);
+    });
+
+    FreeTerminatedProgressRequests();
     CleanupFinishedSendRequests(true);
+
+#ifdef DUMP_NETWORK_STATS
+    DumpProgressStatistics();
+#endif
 }
 
 /* Must be called with mResourceLock acquired */
@@ -2702,21 +3037,53 @@ void pmMPI::CleanupFinishedSendRequests(bool pTerminating)
 {
     ACCUMULATION_TIMER(CleanupFinishedSendRequests, "CleanupFinishedSendRequests");
 
-    if(!pTerminating && mOngoingSendRequests.size() < MIN_SEND_REQUESTS_TO_TRIGGER_CLEANUP)
+    if(mOngoingSendRequests.empty() || (!pTerminating && mOngoingSendRequests.size() < MIN_SEND_REQUESTS_TO_TRIGGER_CLEANUP))
         return;
 
-    mOngoingSendRequests.remove_if([&] (typename decltype(mOngoingSendRequests)::value_type& pPair)
+    // Large sends complete only after the receivers drain them, which may take several more progress calls at termination
+    double lStartTime = pmBase::GetCurrentTimeInSecs();
+
+    do
     {
-        int lFlag = 0;
-        
-        // MPI_Test/MPI_Wait also free the MPI_Request. There is no need for an explicit MPI_Request_free.
-        if( MPI_CALL("MPI_Test", MPI_Test(&pPair.first, &lFlag, MPI_STATUS_IGNORE) != MPI_SUCCESS) )
+        int lRequestCount = (int)mOngoingSendRequests.size();
+        int lCompletedCount = 0;
+        std::vector<int> lCompletedIndices(lRequestCount);
+
+        // MPI_Testsome also frees the completed MPI_Requests. There is no need for an explicit MPI_Request_free.
+        if( MPI_CALL("MPI_Testsome", (MPI_Testsome(lRequestCount, &mOngoingSendRequests[0], &lCompletedCount, &lCompletedIndices[0], MPI_STATUSES_IGNORE) != MPI_SUCCESS)) )
             PMTHROW(pmNetworkException(pmNetworkException::TEST_ERROR));
+
+        if(lCompletedCount != MPI_UNDEFINED && lCompletedCount)
+        {
+            std::sort(lCompletedIndices.begin(), lCompletedIndices.begin() + lCompletedCount);
+
+            for(int i = lCompletedCount - 1; i >= 0; --i)
+            {
+                int lIndex = lCompletedIndices[i];
+
+                mOngoingSendRequests[lIndex] = mOngoingSendRequests.back();
+                mOngoingSendCommands[lIndex] = std::move(mOngoingSendCommands.back());
+
+                mOngoingSendRequests.pop_back();
+                mOngoingSendCommands.pop_back();
+            }
+        }
+    } while(pTerminating && !mOngoingSendRequests.empty() && pmBase::GetCurrentTimeInSecs() - lStartTime < MAX_SEND_COMPLETION_WAIT_AT_TERMINATION);
+
+    /* A receiver that has already shut down never posts receives for memory whose metadata reached it late. Such sends are
+     * abandoned. Their commands (and the buffers they hold) stay alive till this object goes away, as MPI may still access them.
+     */
+    if(pTerminating && !mOngoingSendRequests.empty())
+    {
+        pmLogger::GetLogger()->Log(pmLogger::MINIMAL, pmLogger::WARNING, "Abandoning sends not received by their destinations at termination");
+
+        for_each(mOngoingSendRequests, [] (MPI_Request& pRequest)
+        {
+            MPI_CALL("MPI_Request_free", MPI_Request_free(&pRequest));
+        });
         
-        return (lFlag != 0);
-    });
-    
-    EXCEPTION_ASSERT(!pTerminating || mOngoingSendRequests.empty());
+        mOngoingSendRequests.clear();
+    }
 }
 
 void pmMPI::ThreadSwitchCallback(std::shared_ptr<networkEvent>& pCommand)
@@ -2728,9 +3095,6 @@ void pmMPI::ThreadSwitchCallback(std::shared_ptr<networkEvent>& pCommand)
 	{
 		try
 		{
-            size_t lRequestCount = 0;
-            std::vector<MPI_Request> lRequestVector, lRequestVectorCopy;
-
 			// Auto lock/unlock scope
 			{
 				FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
@@ -2744,33 +3108,27 @@ void pmMPI::ThreadSwitchCallback(std::shared_ptr<networkEvent>& pCommand)
                 }
 
 				SetupDummyRequest();
+                MergePendingProgressRequests();
 
-                lRequestCount = mNonBlockingRequestMap.size();
-				++lRequestCount; // Adding one for dummy request
-                
-                lRequestVector.reserve(lRequestCount);
-                lRequestVectorCopy.reserve(lRequestCount);
-                
-                DEBUG_EXCEPTION_ASSERT(mPersistentDummyRecvRequest != MPI_REQUEST_NULL);
-                lRequestVector.emplace_back(mPersistentDummyRecvRequest);
-                lRequestVectorCopy.emplace_back(mPersistentDummyRecvRequest);
-                
-                for_each(mNonBlockingRequestMap, [&] (typename decltype(mNonBlockingRequestMap)::value_type& pPair)
-                {
-                    EXCEPTION_ASSERT(pPair.first && pPair.first != MPI_REQUEST_NULL);
-                    lRequestVector.emplace_back(pPair.first);
-                    lRequestVectorCopy.emplace_back(pPair.first);
-                });
+                mWaitingOnProgressRequests = true;
             }
 
-			int lFinishingRequestIndex = 0;
-			MPI_Status lFinishingRequestStatus;
+            // mProgressRequests is only modified by this thread, so it is safe to wait on it without the lock.
+            // Requests issued (or terminated) by other threads meanwhile are queued in mPendingProgressRequests
+            // (or mTerminatedProgressRequests) and the dummy request is completed to make this thread pick them up.
+            int lRequestCount = (int)mProgressRequests.size();
+			int lCompletedCount = 0;
+
+            if(mCompletedProgressIndices.size() < (size_t)lRequestCount)
+                mCompletedProgressIndices.resize(lRequestCount);
           
             // MPI_Test/MPI_Wait also free the MPI_Request. There is no need for an explicit MPI_Request_free.
-			if( MPI_CALL("MPI_Waitany", (MPI_Waitany((int)lRequestCount, &lRequestVectorCopy[0], &lFinishingRequestIndex, &lFinishingRequestStatus) != MPI_SUCCESS)) )
+			if( MPI_CALL("MPI_Waitsome", (MPI_Waitsome(lRequestCount, &mProgressRequests[0], &lCompletedCount, &mCompletedProgressIndices[0], MPI_STATUSES_IGNORE) != MPI_SUCCESS)) )
 				PMTHROW(pmNetworkException(pmNetworkException::WAIT_ERROR));
             
             FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+            mWaitingOnProgressRequests = false;
             
             if(mThreadTerminationFlag)
             {
@@ -2778,30 +3136,10 @@ void pmMPI::ThreadSwitchCallback(std::shared_ptr<networkEvent>& pCommand)
                 return;
             }
 
-			if(lFinishingRequestIndex != 0)		// Not Dummy Request
-			{
-                typename decltype(mNonBlockingRequestMap)::iterator lFinishingIter = mNonBlockingRequestMap.find(lRequestVector[lFinishingRequestIndex]);
-                EXCEPTION_ASSERT(lFinishingIter != mNonBlockingRequestMap.end());
-                    
-				pmCommunicatorCommandPtr lCommand = lFinishingIter->second;
-
-                typename decltype(mRequestCountMap)::iterator lRequestCountIter = mRequestCountMap.find(lCommand);
-                EXCEPTION_ASSERT(lRequestCountIter != mRequestCountMap.end());
-
-                --lRequestCountIter->second;
-                
-                mNonBlockingRequestMap.erase(lFinishingIter);
-
-				if(lRequestCountIter->second == 0)
-				{
-					mRequestCountMap.erase(lRequestCountIter);
+            EXCEPTION_ASSERT(lCompletedCount != MPI_UNDEFINED);
 
-					ushort lCommandType = lCommand->GetType();
-                    EXCEPTION_ASSERT(lCommandType == SEND || lCommandType == BROADCAST || lCommandType == RECEIVE);
-
-                    CommandComplete(lCommand, pmSuccess);
-				}
-			}
+            ProcessCompletedProgressRequests(lCompletedCount);
+            FreeTerminatedProgressRequests();
 		}
 		catch(pmException& e)
 		{
@@ -3017,7 +3355,7 @@ void pmMPI::pmUnknownLengthReceiveThread::ThreadSwitchCallback(std::shared_ptr<n
 			if( MPI_CALL("MPI_Recv", (MPI_Recv(lPackedData.get_ptr(), lLength, MPI_PACKED, lProbeStatus.MPI_SOURCE, (int)(UNKNOWN_LENGTH_TAG), MPI_COMM_WORLD, &lRecvStatus) != MPI_SUCCESS)) )
 				PMTHROW(pmNetworkException(pmNetworkException::RECEIVE_ERROR));
 
-            pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()->UnpackDataEvent(std::move(lPackedData), lLength, MAX_CONTROL_PRIORITY);
+            pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()->UnpackDataEvent(std::move(lPackedData), lLength, (uint)lProbeStatus.MPI_SOURCE, MAX_CONTROL_PRIORITY);
 		}
 		catch(pmException& e)
 		{
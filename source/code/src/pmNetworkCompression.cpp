@@ -0,0 +1,775 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmNetworkCompression.h"
+#include "pmAddressSpace.h"
+#include "pmUtility.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+namespace pm
+{
+
+using namespace networkCompression;
+
+namespace networkCompression
+{
+
+/* LZ4 block format constants */
+const ulong LZ_MIN_MATCH = 4;
+const ulong LZ_LAST_LITERALS = 5;     // The last five bytes of a block are always literals
+const ulong LZ_MATCH_FIND_LIMIT = 12; // No match starts in the last twelve bytes of a block
+const ulong LZ_MAX_OFFSET = 65535;
+const uint LZ_HASH_BITS = 14;
+
+inline uint Read32(const unsigned char* pMem)
+{
+    uint lValue;
+    memcpy(&lValue, pMem, sizeof(uint));
+
+    return lValue;
+}
+
+inline uint HashSequence(uint pSequence)
+{
+    return ((pSequence * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+/* Writes the extension bytes of a literal or match length whose token nibble is saturated */
+inline unsigned char* WriteLength(unsigned char* pDest, ulong pLength)
+{
+    while(pLength >= 255)
+    {
+        *pDest++ = 255;
+        pLength -= 255;
+    }
+    
+    *pDest++ = (unsigned char)pLength;
+    
+    return pDest;
+}
+
+inline ulong ReadLength(const unsigned char*& pSrc, const unsigned char* pSrcEnd)
+{
+    ulong lLength = 0;
+    unsigned char lByte = 0;
+
+    do
+    {
+        EXCEPTION_ASSERT(pSrc < pSrcEnd);
+
+        lByte = *pSrc++;
+        lLength += lByte;
+    } while(lByte == 255);
+    
+    return lLength;
+}
+
+inline double GetSpeed(ulong pLength, double pTimeInSecs)
+{
+    return (double)pLength / std::max(pTimeInSecs, 1e-9);
+}
+
+inline void AddSample(double& pAverage, double pSample, ulong pSamples)
+{
+    pAverage = (pSamples ? (pAverage + pSample) / 2 : pSample);
+}
+
+pmNetworkCompression GetCompressionForCodec(codecType pCodec)
+{
+    switch(pCodec)
+    {
+        case CODEC_NONE:
+            return COMPRESSION_NONE;
+
+        case CODEC_FAST:
+            return COMPRESSION_FAST;
+
+        case CODEC_SHUFFLE_DELTA_32:
+            return COMPRESSION_SHUFFLE_DELTA_32;
+
+        case CODEC_SHUFFLE_DELTA_64:
+            return COMPRESSION_SHUFFLE_DELTA_64;
+
+        case CODEC_SENTINEL:
+            return COMPRESSION_SENTINEL;
+
+        default:
+            PMTHROW(pmFatalErrorException());
+    }
+
+    return COMPRESSION_NONE;
+}
+
+codecType GetCodecForCompression(pmNetworkCompression pCompression)
+{
+    for(int i = CODEC_NONE; i < MAX_CODECS; ++i)
+    {
+        if(GetCompressionForCodec((codecType)i) == pCompression)
+            return (codecType)i;
+    }
+    
+    PMTHROW(pmFatalErrorException());
+
+    return CODEC_NONE;
+}
+
+codecStatistics::codecStatistics()
+    : transfers(0)
+    , lock __LOCK_NAME__("codecStatistics::lock")
+{
+    for(int i = 0; i < MAX_CODECS; ++i)
+    {
+        ratio[i] = 1;
+        compressionSpeed[i] = 0;
+        decompressionSpeed[i] = 0;
+        samples[i] = 0;
+    }
+}
+
+}
+
+
+/* class pmFastCodec */
+/* A compressed buffer is the block count, the compressed length of every block and the blocks back to back. A block whose
+ * compressed length equals its uncompressed length is stored as is. */
+std::shared_ptr<char> pmFastCodec::Compress(const char* pMem, ulong pLength, ulong& pCompressedLength) const
+{
+    ulong lBlockCount = (pLength + NETWORK_COMPRESSION_BLOCK_SIZE - 1) / NETWORK_COMPRESSION_BLOCK_SIZE;
+    if(!lBlockCount)
+        return std::shared_ptr<char>();
+
+    std::unique_ptr<char[]> lScratch(new char[pLength]);
+    std::vector<ulong> lBlockLengths(lBlockCount);
+
+#ifdef USE_OMP_FOR_REDUCTION
+    #pragma omp parallel for
+#endif
+    for(long i = 0; i < (long)lBlockCount; ++i)
+    {
+        ulong lOffset = i * NETWORK_COMPRESSION_BLOCK_SIZE;
+        ulong lLength = std::min<ulong>(NETWORK_COMPRESSION_BLOCK_SIZE, pLength - lOffset);
+
+        // The block is stored as is unless it compresses
+        ulong lCompressedLength = EncodeBlock(pMem + lOffset, lLength, lScratch.get() + lOffset, lLength - 1);
+
+        if(!lCompressedLength)
+        {
+            memcpy(lScratch.get() + lOffset, pMem + lOffset, lLength);
+            lCompressedLength = lLength;
+        }
+
+        lBlockLengths[i] = lCompressedLength;
+    }
+
+    std::vector<ulong> lBlockOffsets(lBlockCount + 1);
+    lBlockOffsets[0] = sizeof(ulong) * (lBlockCount + 1);
+
+    for(ulong i = 0; i < lBlockCount; ++i)
+        lBlockOffsets[i + 1] = lBlockOffsets[i] + lBlockLengths[i];
+    
+    if(lBlockOffsets[lBlockCount] >= pLength)
+        return std::shared_ptr<char>();
+
+    pCompressedLength = lBlockOffsets[lBlockCount];
+
+    std::shared_ptr<char> lCompressedPtr(new char[pCompressedLength], std::default_delete<char[]>());
+    char* lCompressedMem = lCompressedPtr.get();
+    
+    memcpy(lCompressedMem, &lBlockCount, sizeof(ulong));
+    memcpy(lCompressedMem + sizeof(ulong), &lBlockLengths[0], sizeof(ulong) * lBlockCount);
+
+#ifdef USE_OMP_FOR_REDUCTION
+    #pragma omp parallel for
+#endif
+    for(long i = 0; i < (long)lBlockCount; ++i)
+        memcpy(lCompressedMem + lBlockOffsets[i], lScratch.get() + i * NETWORK_COMPRESSION_BLOCK_SIZE, lBlockLengths[i]);
+
+#ifdef DUMP_DATA_COMPRESSION_STATISTICS
+    pmCompressionDataRecorder::RecordCompressionData(pLength, pCompressedLength, true);
+#endif
+
+    return lCompressedPtr;
+}
+
+void pmFastCodec::Decompress(const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength) const
+{
+    ulong lBlockCount = 0;
+
+    EXCEPTION_ASSERT(pCompressedLength >= sizeof(ulong));
+    memcpy(&lBlockCount, pCompressedMem, sizeof(ulong));
+
+    EXCEPTION_ASSERT(lBlockCount == (pLength + NETWORK_COMPRESSION_BLOCK_SIZE - 1) / NETWORK_COMPRESSION_BLOCK_SIZE);
+    EXCEPTION_ASSERT(pCompressedLength >= sizeof(ulong) * (lBlockCount + 1));
+
+    std::vector<ulong> lBlockLengths(lBlockCount);
+    memcpy(&lBlockLengths[0], pCompressedMem + sizeof(ulong), sizeof(ulong) * lBlockCount);
+
+    std::vector<ulong> lBlockOffsets(lBlockCount + 1);
+    lBlockOffsets[0] = sizeof(ulong) * (lBlockCount + 1);
+
+    for(ulong i = 0; i < lBlockCount; ++i)
+        lBlockOffsets[i + 1] = lBlockOffsets[i] + lBlockLengths[i];
+
+    EXCEPTION_ASSERT(lBlockOffsets[lBlockCount] == pCompressedLength);
+
+#ifdef USE_OMP_FOR_REDUCTION
+    #pragma omp parallel for
+#endif
+    for(long i = 0; i < (long)lBlockCount; ++i)
+    {
+        ulong lOffset = i * NETWORK_COMPRESSION_BLOCK_SIZE;
+        ulong lLength = std::min<ulong>(NETWORK_COMPRESSION_BLOCK_SIZE, pLength - lOffset);
+
+        if(lBlockLengths[i] == lLength)
+            memcpy(pMem + lOffset, pCompressedMem + lBlockOffsets[i], lLength);
+        else
+            DecodeBlock(pCompressedMem + lBlockOffsets[i], lBlockLengths[i], pMem + lOffset, lLength);
+    }
+}
+
+ulong pmFastCodec::EncodeBlock(const char* pSrc, ulong pLength, char* pDest, ulong pDestCapacity) const
+{
+    return CompressBlock(pSrc, pLength, pDest, pDestCapacity);
+}
+
+void pmFastCodec::DecodeBlock(const char* pSrc, ulong pCompressedLength, char* pDest, ulong pLength) const
+{
+    DecompressBlock(pSrc, pCompressedLength, pDest, pLength);
+}
+
+/* Greedy single probe hash table match finder. The step grows while no match is found, so that incompressible data is skipped quickly. */
+ulong pmFastCodec::CompressBlock(const char* pSrc, ulong pLength, char* pDest, ulong pDestCapacity)
+{
+    const unsigned char* lSrc = reinterpret_cast<const unsigned char*>(pSrc);
+    unsigned char* lDest = reinterpret_cast<unsigned char*>(pDest);
+    unsigned char* lDestEnd = lDest + pDestCapacity;
+
+    ulong lAnchor = 0;
+
+    if(pLength > LZ_MATCH_FIND_LIMIT)
+    {
+        std::vector<uint> lHashTable(1 << LZ_HASH_BITS, 0);
+
+        ulong lMatchFindLimit = pLength - LZ_MATCH_FIND_LIMIT;
+        ulong lMatchLimit = pLength - LZ_LAST_LITERALS;
+        ulong i = 0;
+
+        while(i <= lMatchFindLimit)
+        {
+            uint lSequence = Read32(lSrc + i);
+            uint& lHashEntry = lHashTable[HashSequence(lSequence)];
+            ulong lCandidate = lHashEntry;
+
+            lHashEntry = (uint)i;
+
+            if(lCandidate >= i || i - lCandidate > LZ_MAX_OFFSET || Read32(lSrc + lCandidate) != lSequence)
+            {
+                i += 1 + ((i - lAnchor) >> 6);
+                continue;
+            }
+
+            ulong lMatchEnd = i + LZ_MIN_MATCH;
+            ulong lCandidateEnd = lCandidate + LZ_MIN_MATCH;
+
+            while(lMatchEnd < lMatchLimit && lSrc[lMatchEnd] == lSrc[lCandidateEnd])
+            {
+                ++lMatchEnd;
+                ++lCandidateEnd;
+            }
+            
+            while(i > lAnchor && lCandidate > 0 && lSrc[i - 1] == lSrc[lCandidate - 1])
+            {
+                --i;
+                --lCandidate;
+            }
+
+            ulong lLiterals = i - lAnchor;
+            ulong lMatchLength = lMatchEnd - i - LZ_MIN_MATCH;
+
+            if(lDest + 1 + lLiterals + (lLiterals / 255) + 1 + 2 + (lMatchLength / 255) + 1 > lDestEnd)
+                return 0;
+
+            unsigned char* lToken = lDest++;
+
+            if(lLiterals >= 15)
+            {
+                *lToken = (15 << 4);
+                lDest = WriteLength(lDest, lLiterals - 15);
+            }
+            else
+            {
+                *lToken = (unsigned char)(lLiterals << 4);
+            }
+            
+            memcpy(lDest, lSrc + lAnchor, lLiterals);
+            lDest += lLiterals;
+
+            ulong lOffset = i - lCandidate;
+            *lDest++ = (unsigned char)(lOffset & 0xff);
+            *lDest++ = (unsigned char)(lOffset >> 8);
+            
+            if(lMatchLength >= 15)
+            {
+                *lToken |= 15;
+                lDest = WriteLength(lDest, lMatchLength - 15);
+            }
+            else
+            {
+                *lToken |= (unsigned char)lMatchLength;
+            }
+
+            lAnchor = i = lMatchEnd;
+            
+            if(i <= lMatchFindLimit)
+                lHashTable[HashSequence(Read32(lSrc + i - 2))] = (uint)(i - 2);
+        }
+    }
+
+    ulong lLiterals = pLength - lAnchor;
+    if(lDest + 1 + lLiterals + (lLiterals / 255) + 1 > lDestEnd)
+        return 0;
+
+    if(lLiterals >= 15)
+    {
+        *lDest++ = (15 << 4);
+        lDest = WriteLength(lDest, lLiterals - 15);
+    }
+    else
+    {
+        *lDest++ = (unsigned char)(lLiterals << 4);
+    }
+    
+    memcpy(lDest, lSrc + lAnchor, lLiterals);
+    lDest += lLiterals;
+    
+    return (lDest - reinterpret_cast<unsigned char*>(pDest));
+}
+
+void pmFastCodec::DecompressBlock(const char* pSrc, ulong pCompressedLength, char* pDest, ulong pLength)
+{
+    const unsigned char* lSrc = reinterpret_cast<const unsigned char*>(pSrc);
+    const unsigned char* lSrcEnd = lSrc + pCompressedLength;
+    unsigned char* lDestBegin = reinterpret_cast<unsigned char*>(pDest);
+    unsigned char* lDest = lDestBegin;
+    unsigned char* lDestEnd = lDest + pLength;
+
+    while(lSrc < lSrcEnd)
+    {
+        unsigned char lToken = *lSrc++;
+
+        ulong lLiterals = (lToken >> 4);
+        if(lLiterals == 15)
+            lLiterals += ReadLength(lSrc, lSrcEnd);
+
+        EXCEPTION_ASSERT(lSrc + lLiterals <= lSrcEnd && lDest + lLiterals <= lDestEnd);
+
+        memcpy(lDest, lSrc, lLiterals);
+        lSrc += lLiterals;
+        lDest += lLiterals;
+        
+        if(lSrc == lSrcEnd)
+            break;  // The last sequence has no match
+
+        EXCEPTION_ASSERT(lSrc + 2 <= lSrcEnd);
+
+        ulong lOffset = lSrc[0] | (lSrc[1] << 8);
+        lSrc += 2;
+
+        ulong lMatchLength = (lToken & 15);
+        if(lMatchLength == 15)
+            lMatchLength += ReadLength(lSrc, lSrcEnd);
+
+        lMatchLength += LZ_MIN_MATCH;
+
+        EXCEPTION_ASSERT(lOffset && lOffset <= (ulong)(lDest - lDestBegin) && lDest + lMatchLength <= lDestEnd);
+
+        const unsigned char* lMatch = lDest - lOffset;
+
+        if(lOffset >= lMatchLength)
+        {
+            memcpy(lDest, lMatch, lMatchLength);
+            lDest += lMatchLength;
+        }
+        else
+        {
+            // Overlapping match repeats the last lOffset bytes
+            for(ulong i = 0; i < lMatchLength; ++i)
+                *lDest++ = *lMatch++;
+        }
+    }
+    
+    EXCEPTION_ASSERT(lDest == lDestEnd);
+}
+
+
+/* class pmShuffleDeltaCodec */
+pmShuffleDeltaCodec::pmShuffleDeltaCodec(size_t pElemSize)
+    : mElemSize(pElemSize)
+{}
+
+ulong pmShuffleDeltaCodec::EncodeBlock(const char* pSrc, ulong pLength, char* pDest, ulong pDestCapacity) const
+{
+    const unsigned char* lSrc = reinterpret_cast<const unsigned char*>(pSrc);
+    ulong lElems = pLength / mElemSize;
+    ulong lTailOffset = lElems * mElemSize;
+
+    std::unique_ptr<unsigned char[]> lShuffledPtr(new unsigned char[pLength]);
+    unsigned char* lShuffled = lShuffledPtr.get();
+    
+    for(size_t lByte = 0; lByte < mElemSize; ++lByte)
+    {
+        unsigned char* lPlane = lShuffled + lByte * lElems;
+        unsigned char lPrevious = 0;
+
+        for(ulong i = 0; i < lElems; ++i)
+        {
+            unsigned char lValue = lSrc[i * mElemSize + lByte];
+
+            lPlane[i] = (unsigned char)(lValue - lPrevious);
+            lPrevious = lValue;
+        }
+    }
+
+    memcpy(lShuffled + lTailOffset, lSrc + lTailOffset, pLength - lTailOffset);
+
+    return CompressBlock(reinterpret_cast<const char*>(lShuffled), pLength, pDest, pDestCapacity);
+}
+
+void pmShuffleDeltaCodec::DecodeBlock(const char* pSrc, ulong pCompressedLength, char* pDest, ulong pLength) const
+{
+    unsigned char* lDest = reinterpret_cast<unsigned char*>(pDest);
+    ulong lElems = pLength / mElemSize;
+    ulong lTailOffset = lElems * mElemSize;
+
+    std::unique_ptr<unsigned char[]> lShuffledPtr(new unsigned char[pLength]);
+    unsigned char* lShuffled = lShuffledPtr.get();
+
+    DecompressBlock(pSrc, pCompressedLength, reinterpret_cast<char*>(lShuffled), pLength);
+
+    for(size_t lByte = 0; lByte < mElemSize; ++lByte)
+    {
+        const unsigned char* lPlane = lShuffled + lByte * lElems;
+        unsigned char lValue = 0;
+
+        for(ulong i = 0; i < lElems; ++i)
+        {
+            lValue = (unsigned char)(lValue + lPlane[i]);
+            lDest[i * mElemSize + lByte] = lValue;
+        }
+    }
+
+    memcpy(lDest + lTailOffset, lShuffled + lTailOffset, pLength - lTailOffset);
+}
+
+
+/* class pmSentinelCodec */
+/* Trailing bytes that do not make up an element follow the sentinel compressed data as is */
+std::shared_ptr<char> pmSentinelCodec::Compress(const char* pMem, ulong pLength, ulong& pCompressedLength) const
+{
+    ulong lElems = pLength / sizeof(uint);
+    ulong lTail = pLength - lElems * sizeof(uint);
+
+    if(!lElems)
+        return std::shared_ptr<char>();
+
+    ulong lCompressedLength = 0;
+    std::shared_ptr<char> lCompressedPtr = pmUtility::CompressForSentinel<uint>(reinterpret_cast<const uint*>(pMem), 0, lElems, lCompressedLength);
+    
+    if(!lCompressedPtr.get() || lCompressedLength + lTail >= pLength)
+        return std::shared_ptr<char>();
+
+    if(lTail)
+    {
+        std::shared_ptr<char> lPtr(new char[lCompressedLength + lTail], std::default_delete<char[]>());
+
+        memcpy(lPtr.get(), lCompressedPtr.get(), lCompressedLength);
+        memcpy(lPtr.get() + lCompressedLength, pMem + lElems * sizeof(uint), lTail);
+
+        lCompressedPtr = lPtr;
+    }
+    
+    pCompressedLength = lCompressedLength + lTail;
+
+    return lCompressedPtr;
+}
+
+void pmSentinelCodec::Decompress(const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength) const
+{
+    ulong lElems = pLength / sizeof(uint);
+    ulong lTail = pLength - lElems * sizeof(uint);
+
+    EXCEPTION_ASSERT(pCompressedLength > lTail);
+
+    pmUtility::DecompressForSentinel(pCompressedMem, pCompressedLength - lTail, sizeof(uint), pMem);
+    memcpy(pMem + lElems * sizeof(uint), pCompressedMem + pCompressedLength - lTail, lTail);
+}
+
+
+/* class pmNetworkCompressor */
+pmNetworkCompressor* pmNetworkCompressor::GetNetworkCompressor()
+{
+    static pmNetworkCompressor lNetworkCompressor;
+    return &lNetworkCompressor;
+}
+
+pmNetworkCompressor::pmNetworkCompressor()
+    : mDefaultCompression(COMPRESSION_NONE)
+    , mFixedBandwidth(false)
+    , mBandwidth((double)DEFAULT_NETWORK_BANDWIDTH * 1024 * 1024)
+    , mResourceLock __LOCK_NAME__("pmNetworkCompressor::mResourceLock")
+{
+    mCodecs[CODEC_FAST].reset(new pmFastCodec());
+    mCodecs[CODEC_SHUFFLE_DELTA_32].reset(new pmShuffleDeltaCodec(4));
+    mCodecs[CODEC_SHUFFLE_DELTA_64].reset(new pmShuffleDeltaCodec(8));
+    mCodecs[CODEC_SENTINEL].reset(new pmSentinelCodec());
+
+    const char* lVal = getenv("PMLIB_NETWORK_COMPRESSION");
+    if(lVal && *lVal)
+    {
+        if(!strcmp(lVal, "adaptive"))
+        {
+            mDefaultCompression = COMPRESSION_ADAPTIVE;
+        }
+        else
+        {
+            for(int i = CODEC_NONE; i < MAX_CODECS; ++i)
+            {
+                if(!strcmp(lVal, GetCodecName((codecType)i)))
+                    mDefaultCompression = GetCompressionForCodec((codecType)i);
+            }
+        }
+    }
+
+    lVal = getenv("PMLIB_NETWORK_BANDWIDTH");
+    if(lVal && *lVal)
+    {
+        double lBandwidth = atof(lVal);
+        
+        if(lBandwidth > 0)
+        {
+            mBandwidth = lBandwidth * 1024 * 1024;
+            mFixedBandwidth = true;
+        }
+    }
+}
+
+const char* pmNetworkCompressor::GetCodecName(codecType pCodec)
+{
+    switch(pCodec)
+    {
+        case CODEC_NONE:
+            return "none";
+
+        case CODEC_FAST:
+            return "fast";
+
+        case CODEC_SHUFFLE_DELTA_32:
+            return "shuffle32";
+
+        case CODEC_SHUFFLE_DELTA_64:
+            return "shuffle64";
+
+        case CODEC_SENTINEL:
+            return "sentinel";
+
+        default:
+            PMTHROW(pmFatalErrorException());
+    }
+
+    return NULL;
+}
+
+pmNetworkCompression pmNetworkCompressor::GetCompression(const pmAddressSpace* pAddressSpace) const
+{
+    pmNetworkCompression lCompression = pAddressSpace->GetAllocationPolicy().compression;
+
+    return ((lCompression == COMPRESSION_DEFAULT) ? mDefaultCompression : lCompression);
+}
+
+std::shared_ptr<char> pmNetworkCompressor::Compress(pmAddressSpace* pAddressSpace, const char* pMem, ulong pLength, ulong pStep, ulong pCount, ulong& pCompressedLength, codecType& pCodec)
+{
+    pCodec = CODEC_NONE;
+
+    ulong lLength = pLength * pCount;
+    if(lLength < NETWORK_COMPRESSION_MIN_LENGTH)
+        return std::shared_ptr<char>();
+
+    pmNetworkCompression lCompression = GetCompression(pAddressSpace);
+    if(lCompression == COMPRESSION_NONE)
+        return std::shared_ptr<char>();
+
+    // Scattered rows are compressed together
+    std::unique_ptr<char[]> lGatheredMem;
+    if(pCount > 1 && pStep != pLength)
+    {
+        lGatheredMem.reset(new char[lLength]);
+
+        for(ulong i = 0; i < pCount; ++i)
+            memcpy(lGatheredMem.get() + i * pLength, pMem + i * pStep, pLength);
+
+        pMem = lGatheredMem.get();
+    }
+
+    codecType lCodec = ((lCompression == COMPRESSION_ADAPTIVE) ? SelectAdaptiveCodec(pAddressSpace, pMem, lLength) : GetCodecForCompression(lCompression));
+    if(lCodec == CODEC_NONE)
+        return std::shared_ptr<char>();
+
+    std::shared_ptr<char> lCompressedPtr = mCodecs[lCodec]->Compress(pMem, lLength, pCompressedLength);
+
+    if(lCompression == COMPRESSION_ADAPTIVE)
+    {
+        codecStatistics& lStatistics = pAddressSpace->GetNetworkCompressionStatistics();
+
+        FINALIZE_RESOURCE_PTR(dStatisticsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &lStatistics.lock, Lock(), Unlock());
+        AddSample(lStatistics.ratio[lCodec], (lCompressedPtr.get() ? (double)pCompressedLength / lLength : 1.0), lStatistics.samples[lCodec]);
+    }
+
+    if(lCompressedPtr.get())
+        pCodec = lCodec;
+
+    return lCompressedPtr;
+}
+
+void pmNetworkCompressor::Decompress(codecType pCodec, const char* pCompressedMem, ulong pCompressedLength, char* pMem, ulong pLength, ulong pStep, ulong pCount)
+{
+    EXCEPTION_ASSERT(pCodec > CODEC_NONE && pCodec < MAX_CODECS);
+
+    ulong lLength = pLength * pCount;
+
+    if(pCount > 1 && pStep != pLength)
+    {
+        std::unique_ptr<char[]> lGatheredMem(new char[lLength]);
+
+        mCodecs[pCodec]->Decompress(pCompressedMem, pCompressedLength, lGatheredMem.get(), lLength);
+
+        for(ulong i = 0; i < pCount; ++i)
+            memcpy(pMem + i * pStep, lGatheredMem.get() + i * pLength, pLength);
+    }
+    else
+    {
+        mCodecs[pCodec]->Decompress(pCompressedMem, pCompressedLength, pMem, lLength);
+    }
+}
+
+/* Every NETWORK_COMPRESSION_PROBE_INTERVAL transfers, all codecs are measured on a prefix of the data. The codec with the
+ * least expected time to compress, transfer and decompress is chosen (or none if sending uncompressed data is faster). */
+codecType pmNetworkCompressor::SelectAdaptiveCodec(pmAddressSpace* pAddressSpace, const char* pMem, ulong pLength)
+{
+    codecStatistics& lStatistics = pAddressSpace->GetNetworkCompressionStatistics();
+
+    bool lProbe = false;
+
+    {
+        FINALIZE_RESOURCE_PTR(dStatisticsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &lStatistics.lock, Lock(), Unlock());
+        lProbe = ((lStatistics.transfers++ % NETWORK_COMPRESSION_PROBE_INTERVAL) == 0);
+    }
+    
+    if(lProbe)
+    {
+        for(int i = CODEC_NONE + 1; i < MAX_CODECS; ++i)
+            Probe(lStatistics, (codecType)i, pMem, std::min<ulong>(pLength, NETWORK_COMPRESSION_PROBE_LENGTH));
+    }
+
+    double lBandwidth = GetBandwidth();
+
+    FINALIZE_RESOURCE_PTR(dStatisticsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &lStatistics.lock, Lock(), Unlock());
+
+    codecType lBestCodec = CODEC_NONE;
+    double lBestTime = (double)pLength / lBandwidth;
+
+    for(int i = CODEC_NONE + 1; i < MAX_CODECS; ++i)
+    {
+        if(!lStatistics.samples[i] || lStatistics.ratio[i] >= 1.0)
+            continue;
+
+        double lTime = (double)pLength / lStatistics.compressionSpeed[i] + (double)pLength * lStatistics.ratio[i] / lBandwidth + (double)pLength / lStatistics.decompressionSpeed[i];
+
+        if(lTime < lBestTime)
+        {
+            lBestTime = lTime;
+            lBestCodec = (codecType)i;
+        }
+    }
+
+    return lBestCodec;
+}
+
+void pmNetworkCompressor::Probe(codecStatistics& pStatistics, codecType pCodec, const char* pMem, ulong pLength)
+{
+    ulong lCompressedLength = 0;
+
+    double lStartTime = GetCurrentTimeInSecs();
+    std::shared_ptr<char> lCompressedPtr = mCodecs[pCodec]->Compress(pMem, pLength, lCompressedLength);
+    double lCompressionTime = GetCurrentTimeInSecs() - lStartTime;
+    
+    double lDecompressionTime = 0;
+    if(lCompressedPtr.get())
+    {
+        std::unique_ptr<char[]> lDecompressedMem(new char[pLength]);
+
+        lStartTime = GetCurrentTimeInSecs();
+        mCodecs[pCodec]->Decompress(lCompressedPtr.get(), lCompressedLength, lDecompressedMem.get(), pLength);
+        lDecompressionTime = GetCurrentTimeInSecs() - lStartTime;
+    }
+
+    FINALIZE_RESOURCE_PTR(dStatisticsLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &pStatistics.lock, Lock(), Unlock());
+
+    ulong& lSamples = pStatistics.samples[pCodec];
+
+    AddSample(pStatistics.ratio[pCodec], (lCompressedPtr.get() ? (double)lCompressedLength / pLength : 1.0), lSamples);
+    AddSample(pStatistics.compressionSpeed[pCodec], GetSpeed(pLength, lCompressionTime), lSamples);
+    AddSample(pStatistics.decompressionSpeed[pCodec], GetSpeed(pLength, lDecompressionTime), lSamples);
+    
+    ++lSamples;
+}
+
+void pmNetworkCompressor::RecordTransfer(ulong pLength, double pTimeInSecs)
+{
+    if(mFixedBandwidth || pLength < NETWORK_COMPRESSION_MIN_LENGTH || pTimeInSecs <= 0)
+        return;
+
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    AddSample(mBandwidth, GetSpeed(pLength, pTimeInSecs), 1);
+}
+
+double pmNetworkCompressor::GetBandwidth()
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+    return mBandwidth;
+}
+
+} // end namespace pm
@@ -0,0 +1,207 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmPersistentTask.h"
+#include "pmTask.h"
+#include "pmAddressSpace.h"
+#include "pmTaskExecStats.h"
+
+#include <string.h>
+
+namespace pm
+{
+
+using namespace scheduler;
+
+pmPersistentTask::pmPersistentTask(const pmTaskDetails& pTaskDetails)
+    : mTaskDetails(pTaskDetails)
+    , mPendingLaunches(0)
+    , mUserDelete(false)
+    , mHasSchedulingHistory(false)
+    , mAffinityAddressSpace(NULL)
+    , mResourceLock __LOCK_NAME__("pmPersistentTask::mResourceLock")
+{
+    if(mTaskDetails.taskConfLength && mTaskDetails.taskConf)
+        mTaskConf.assign(static_cast<char*>(mTaskDetails.taskConf), static_cast<char*>(mTaskDetails.taskConf) + mTaskDetails.taskConfLength);
+    else
+        mTaskDetails.taskConfLength = 0;
+
+    mTaskMem.assign(mTaskDetails.taskMem, mTaskDetails.taskMem + mTaskDetails.taskMemCount);
+    mAddressSpaceLengths.reserve(mTaskMem.size());
+
+    for_each(mTaskMem, [&] (const pmTaskMem& pTaskMem)
+    {
+        mAddressSpaceLengths.push_back((reinterpret_cast<pmUserMemHandle*>(pTaskMem.memHandle))->GetAddressSpace()->GetLength());
+    });
+}
+
+pmPersistentTask::~pmPersistentTask()
+{
+    if(mAffinityAddressSpace)
+    {
+        EXCEPTION_ASSERT(pmReleaseMemory(mAffinityAddressSpace->GetUserMemHandle()) == pmSuccess);
+    }
+}
+
+/* Returns the task details for the next launch. A non NULL pTaskMem replaces the address spaces (which must be of the same
+ * memory types and lengths as the ones they replace) and a non NULL pTaskConf replaces the task configuration.
+ */
+pmTaskDetails pmPersistentTask::PrepareLaunch(pmTaskMem* pTaskMem, void* pTaskConf)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    if(mUserDelete)
+        PMTHROW(pmFatalErrorException());
+
+    if(pTaskMem)
+    {
+        for(size_t i = 0; i < mTaskMem.size(); ++i)
+        {
+            pmUserMemHandle* lUserMemHandle = reinterpret_cast<pmUserMemHandle*>(pTaskMem[i].memHandle);
+
+            if(!lUserMemHandle || !lUserMemHandle->GetAddressSpace() || pTaskMem[i].memType != mTaskMem[i].memType || lUserMemHandle->GetAddressSpace()->GetLength() != mAddressSpaceLengths[i])
+                PMTHROW(pmFatalErrorException());
+        }
+
+        std::copy(pTaskMem, pTaskMem + mTaskMem.size(), mTaskMem.begin());
+    }
+
+    if(pTaskConf && !mTaskConf.empty())
+        PMLIB_MEMCPY(&mTaskConf[0], pTaskConf, mTaskConf.size(), std::string("pmPersistentTask::PrepareLaunch"));
+
+    pmTaskDetails lTaskDetails(mTaskDetails);
+    lTaskDetails.taskConf = (mTaskConf.empty() ? NULL : &mTaskConf[0]);
+    lTaskDetails.taskMem = (mTaskMem.empty() ? NULL : &mTaskMem[0]);
+
+    return lTaskDetails;
+}
+
+// Returns the commands the new launch must wait for (i.e. the previous launch, if any)
+std::vector<pmCommandPtr> pmPersistentTask::RegisterLaunch(pmLocalTask* pLocalTask)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    pLocalTask->SetPersistentTask(this);
+    ++mPendingLaunches;
+
+    std::vector<pmCommandPtr> lPrerequisiteCommands;
+    if(mLastLaunchCommand.get())
+        lPrerequisiteCommands.push_back(mLastLaunchCommand);
+
+    mLastLaunchCommand = pLocalTask->GetTaskCommand();
+
+    return lPrerequisiteCommands;
+}
+
+// Called when a launch starts scheduling; all earlier launches have finished by then
+void pmPersistentTask::SeedLaunch(pmLocalTask* pLocalTask)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    pLocalTask->GetTaskExecStats().SeedExecutionRates(mExecutionRates);
+
+    if(mAffinityAddressSpace && pLocalTask->GetSchedulingModel() == PULL_WITH_AFFINITY)
+        pLocalTask->InheritAffinityMappings(mLogicalToPhysicalSubtaskMappings, mAffinityAddressSpace);
+}
+
+// Called before the launch's task command ends. State of failed launches is not carried forward.
+void pmPersistentTask::RecordLaunchCompletion(pmLocalTask* pLocalTask, pmStatus pStatus)
+{
+    bool lDelete = false;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+        if(pStatus == pmSuccess)
+        {
+            pmSubtaskManager* lSubtaskManager = pLocalTask->GetSubtaskManager();
+
+            if(lSubtaskManager)
+            {
+                mSchedulingHistory = pmSchedulingHistory();
+                lSubtaskManager->SaveSchedulingHistory(mSchedulingHistory);
+                mHasSchedulingHistory = true;
+            }
+
+            mExecutionRates.clear();
+            pLocalTask->GetTaskExecStats().SaveExecutionRates(mExecutionRates);
+
+            if(!mAffinityAddressSpace && pLocalTask->GetSchedulingModel() == PULL_WITH_AFFINITY && pLocalTask->GetPreprocessorTask() && !pLocalTask->GetLogicalToPhysicalSubtaskMappings().empty())
+            {
+                mAffinityAddressSpace = pLocalTask->GetAffinityAddressSpace();
+                mLogicalToPhysicalSubtaskMappings = pLocalTask->GetLogicalToPhysicalSubtaskMappings();
+
+                pLocalTask->RetainAffinityAddressSpace();
+            }
+        }
+
+        --mPendingLaunches;
+        lDelete = (mUserDelete && !mPendingLaunches);
+    }
+
+    if(lDelete)
+        delete this;
+}
+
+const pmSchedulingHistory* pmPersistentTask::GetSchedulingHistory() const
+{
+    return (mHasSchedulingHistory ? &mSchedulingHistory : NULL);
+}
+
+bool pmPersistentTask::HasAffinityMappings() const
+{
+    return (mAffinityAddressSpace != NULL);
+}
+
+// The object is destroyed once the launches in flight have finished
+void pmPersistentTask::UserDelete()
+{
+    bool lDelete = false;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+        if(mUserDelete)
+            PMTHROW(pmFatalErrorException());
+
+        mUserDelete = true;
+        lDelete = !mPendingLaunches;
+    }
+
+    if(lDelete)
+        delete this;
+}
+
+} // end namespace pm
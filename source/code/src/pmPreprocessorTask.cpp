@@ -317,14 +317,9 @@ pmStatus preprocessorTask_taskCompletionCallback(pmTaskInfo pTaskInfo)
     pmLocalTask* lPreprocessorTask = static_cast<pmLocalTask*>(pTaskInfo.taskHandle);
     pmLocalTask* lUserTask = static_cast<pmLocalTask*>(pmTaskManager::GetTaskManager()->FindTask(pmMachinePool::GetMachinePool()->GetMachine(lTaskConf->originatingHost), lTaskConf->sequenceNumber));
 
-    lUserTask->SetPreprocessorTask(lPreprocessorTask);
+    lUserTask->SetPreprocessorTask(lPreprocessorTask);   // Destroyed when the user task ends (pmPreprocessorTask::DestroyPreprocessorTask)
 
-    const pmTaskCompletionCB* lUserTaskCompletionCB = lUserTask->GetCallbackUnit()->GetTaskCompletionCB();
-    pmTaskCompletionCallback lOrgUserCallback = (lUserTaskCompletionCB ? lUserTaskCompletionCB->GetCallback() : NULL);
-    lUserTask->SetTaskCompletionCallback(userTask_auxillaryTaskCompletionCallback);
-    const_cast<pmTaskCompletionCB*>(lUserTask->GetCallbackUnit()->GetTaskCompletionCB())->SetUserData(reinterpret_cast<void*>(lOrgUserCallback));
-    
-    // Consume data computed by pre-processor task and delete preprocessor task's address spaces
+    // Consume data computed by pre-processor task
     const std::vector<pmTaskMemory>& lPreprocessorTaskMemVector = lPreprocessorTask->GetTaskMemVector();
 
     switch(lTaskConf->taskType)
@@ -353,23 +348,22 @@ pmStatus preprocessorTask_taskCompletionCallback(pmTaskInfo pTaskInfo)
     return pmSuccess;
 }
     
-pmStatus userTask_auxillaryTaskCompletionCallback(pmTaskInfo pTaskInfo)
+/* The user task's callback unit may be shared by other tasks running concurrently (e.g. those of a task graph); so, instead of
+ * overriding the unit's task completion callback, the user task calls this on its own completion */
+void pmPreprocessorTask::DestroyPreprocessorTask(pmLocalTask* pUserTask)
 {
-    pmLocalTask* lUserTask = static_cast<pmLocalTask*>(pTaskInfo.taskHandle);
-    const pmLocalTask* lPreprocessorTask = lUserTask->GetPreprocessorTask();
-
-    // Reset the original task callback
-    lUserTask->SetTaskCompletionCallback(reinterpret_cast<pmTaskCompletionCallback>(lUserTask->GetCallbackUnit()->GetTaskCompletionCB()->GetUserData()));
+    const pmLocalTask* lPreprocessorTask = pUserTask->GetPreprocessorTask();
+    DEBUG_EXCEPTION_ASSERT(lPreprocessorTask);
 
-    // Destroy preprocessorTask
+    // Destroy preprocessorTask (the affinity address space lives on if a persistent task has retained it)
     const std::vector<pmTaskMemory>& lPreprocessorTaskMemVector = lPreprocessorTask->GetTaskMemVector();
     pmAddressSpace* lAddressSpace = lPreprocessorTaskMemVector[lPreprocessorTaskMemVector.size() - 1].addressSpace;
 
-    EXCEPTION_ASSERT(pmReleaseMemory(lAddressSpace->GetUserMemHandle()) == pmSuccess);
+    if(!pUserTask->IsAffinityAddressSpaceRetained())
+    {
+        EXCEPTION_ASSERT(pmReleaseMemory(lAddressSpace->GetUserMemHandle()) == pmSuccess);
+    }
     EXCEPTION_ASSERT(pmReleaseTask((pmTaskHandle)(lPreprocessorTask)) == pmSuccess);
-
-    // Call the original user task completion callback
-    return lUserTask->GetCallbackUnit()->GetTaskCompletionCB()->Invoke(lUserTask);
 }
     
 pmPreprocessorTask::pmPreprocessorTask()
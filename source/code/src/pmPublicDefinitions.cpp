@@ -533,12 +533,22 @@ pmStatus pmReleaseCallbacks(pmCallbackHandle pCallbackHandle)
 
 pmStatus pmCreateMemory(size_t pLength, pmMemHandle* pMemHandle)
 {
-	SAFE_EXECUTE_ON_CONTROLLER(CreateMemory_Public, pLength, pMemHandle);
+	SAFE_EXECUTE_ON_CONTROLLER(CreateMemory_Public, pLength, pMemHandle, pmMemAllocationPolicy());
 }
 
 pmStatus pmCreateMemory2D(size_t pRows, size_t pCols, pmMemHandle* pMemHandle)
 {
-	SAFE_EXECUTE_ON_CONTROLLER(CreateMemory2D_Public, pRows, pCols, pMemHandle);
+	SAFE_EXECUTE_ON_CONTROLLER(CreateMemory2D_Public, pRows, pCols, pMemHandle, pmMemAllocationPolicy());
+}
+
+pmStatus pmCreateMemory(size_t pLength, pmMemHandle* pMemHandle, const pmMemAllocationPolicy& pAllocationPolicy)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(CreateMemory_Public, pLength, pMemHandle, pAllocationPolicy);
+}
+
+pmStatus pmCreateMemory2D(size_t pRows, size_t pCols, pmMemHandle* pMemHandle, const pmMemAllocationPolicy& pAllocationPolicy)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(CreateMemory2D_Public, pRows, pCols, pMemHandle, pAllocationPolicy);
 }
 
 pmStatus pmReleaseMemory(pmMemHandle pMem)
@@ -556,6 +566,38 @@ pmStatus pmFetchMemoryRange(pmMemHandle pMem, size_t pOffset, size_t pLength)
     SAFE_EXECUTE_ON_CONTROLLER(FetchMemoryRange_Public, pMem, pOffset, pLength);
 }
     
+pmStatus pmFetchMemoryRanges(pmMemHandle pMem, const pmSubscriptionInfo* pRanges, uint pRangeCount)
+{
+    SAFE_EXECUTE_ON_CONTROLLER(FetchMemoryRanges_Public, pMem, pRanges, pRangeCount, NULL);
+}
+
+pmStatus pmFetchMemoryRangeAsync(pmMemHandle pMem, size_t pOffset, size_t pLength, pmFetchHandle* pFetchHandle)
+{
+    pmSubscriptionInfo lRange(pOffset, pLength);
+
+    SAFE_EXECUTE_ON_CONTROLLER(FetchMemoryRanges_Public, pMem, &lRange, 1, pFetchHandle);
+}
+
+pmStatus pmFetchMemoryRangesAsync(pmMemHandle pMem, const pmSubscriptionInfo* pRanges, uint pRangeCount, pmFetchHandle* pFetchHandle)
+{
+    SAFE_EXECUTE_ON_CONTROLLER(FetchMemoryRanges_Public, pMem, pRanges, pRangeCount, pFetchHandle);
+}
+
+pmStatus pmTestFetch(pmFetchHandle pFetchHandle, bool* pComplete)
+{
+    SAFE_EXECUTE_ON_CONTROLLER(TestFetch_Public, pFetchHandle, pComplete);
+}
+
+pmStatus pmWaitForFetch(pmFetchHandle pFetchHandle)
+{
+    SAFE_EXECUTE_ON_CONTROLLER(WaitForFetch_Public, pFetchHandle);
+}
+
+pmStatus pmReleaseFetch(pmFetchHandle pFetchHandle)
+{
+    SAFE_EXECUTE_ON_CONTROLLER(ReleaseFetch_Public, pFetchHandle);
+}
+
 pmStatus pmGetRawMemPtr(pmMemHandle pMem, void** pPtr)
 {
     SAFE_EXECUTE_ON_CONTROLLER(GetRawMemPtr_Public, pMem, pPtr);
@@ -644,6 +686,43 @@ pmStatus pmSubmitTask(pmTaskDetails pTaskDetails, pmTaskHandle* pTaskHandle)
 	SAFE_EXECUTE_ON_CONTROLLER(SubmitTask_Public, pTaskDetails, pTaskHandle);
 }
 
+pmTaskDependency::pmTaskDependency()
+    : prerequisite(0)
+    , dependent(0)
+{
+}
+
+pmTaskDependency::pmTaskDependency(uint pPrerequisite, uint pDependent)
+    : prerequisite(pPrerequisite)
+    , dependent(pDependent)
+{
+}
+
+pmStatus pmSubmitTaskGraph(pmTaskDetails* pTaskDetails, uint pTaskCount, const pmTaskDependency* pDependencies, uint pDependencyCount, pmTaskHandle* pTaskHandles)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(SubmitTaskGraph_Public, pTaskDetails, pTaskCount, pDependencies, pDependencyCount, pTaskHandles);
+}
+
+pmStatus pmSubmitTaskAfter(pmTaskDetails pTaskDetails, const pmTaskHandle* pPrerequisiteTasks, uint pPrerequisiteCount, pmTaskHandle* pTaskHandle)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(SubmitTaskAfter_Public, pTaskDetails, pPrerequisiteTasks, pPrerequisiteCount, pTaskHandle);
+}
+
+pmStatus pmCreatePersistentTask(pmTaskDetails pTaskDetails, pmPersistentTaskHandle* pPersistentTaskHandle)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(CreatePersistentTask_Public, pTaskDetails, pPersistentTaskHandle);
+}
+
+pmStatus pmLaunchPersistentTask(pmPersistentTaskHandle pPersistentTaskHandle, pmTaskMem* pTaskMem, void* pTaskConf, pmTaskHandle* pTaskHandle)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(LaunchPersistentTask_Public, pPersistentTaskHandle, pTaskMem, pTaskConf, pTaskHandle);
+}
+
+pmStatus pmReleasePersistentTask(pmPersistentTaskHandle pPersistentTaskHandle)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(ReleasePersistentTask_Public, pPersistentTaskHandle);
+}
+
 pmStatus pmReleaseTask(pmTaskHandle pTaskHandle)
 {
 	SAFE_EXECUTE_ON_CONTROLLER(ReleaseTask_Public, pTaskHandle);
@@ -748,6 +827,34 @@ pmScatteredSubscriptionInfo::pmScatteredSubscriptionInfo(size_t pOffset, size_t
     , count(pCount)
 {}
 
+pmMemAllocationPolicy::pmMemAllocationPolicy()
+    : placement(PLACEMENT_DEFAULT)
+    , pageSize(PAGES_DEFAULT)
+    , adviseAccessPattern(false)
+    , compression(COMPRESSION_DEFAULT)
+{}
+
+pmMemAllocationPolicy::pmMemAllocationPolicy(pmMemPlacementPolicy pPlacement, pmMemPageSize pPageSize)
+    : placement(pPlacement)
+    , pageSize(pPageSize)
+    , adviseAccessPattern(false)
+    , compression(COMPRESSION_DEFAULT)
+{}
+
+pmMemAllocationPolicy::pmMemAllocationPolicy(pmMemPlacementPolicy pPlacement, pmMemPageSize pPageSize, bool pAdviseAccessPattern)
+    : placement(pPlacement)
+    , pageSize(pPageSize)
+    , adviseAccessPattern(pAdviseAccessPattern)
+    , compression(COMPRESSION_DEFAULT)
+{}
+
+pmMemAllocationPolicy::pmMemAllocationPolicy(pmMemPlacementPolicy pPlacement, pmMemPageSize pPageSize, bool pAdviseAccessPattern, pmNetworkCompression pCompression)
+    : placement(pPlacement)
+    , pageSize(pPageSize)
+    , adviseAccessPattern(pAdviseAccessPattern)
+    , compression(pCompression)
+{}
+
 template<pmReductionOpType pOperation>
 pmDataReductionCallback pmGetSubtaskReductionCallbackInner(pmReductionDataType pDataType)
 {
@@ -817,6 +924,47 @@ pmDataReductionCallback pmGetSubtaskReductionCallbackImpl(pmReductionOpType pOpe
     return NULL;
 }
 
+pmDataReductionCallback pmGetSubtaskReductionCallbackImpl(pmReductionOpHandle pReductionOpHandle)
+{
+    try
+    {
+		pmController* lController = pmController::GetController();
+		if(!lController)
+			return NULL;
+    
+        return lController->GetSubtaskReductionCallback_Public(pReductionOpHandle);
+    }
+    catch(pmException& e)
+    {
+        pmStatus lStatus = e.GetStatusCode();
+        pmLogger::GetLogger()->Log(pmLogger::MINIMAL, pmLogger::ERROR, pmErrorMessages[lStatus]);
+    }
+    
+    return NULL;
+}
+
+pmReductionOperation::pmReductionOperation()
+    : elemSize(0)
+    , function(NULL)
+    , commutative(true)
+    , zeroIdentity(false)
+{}
+
+pmReductionOperation::pmReductionOperation(size_t pElemSize, pmReductionFunction pFunction, bool pCommutative /* = true */, bool pZeroIdentity /* = false */)
+    : elemSize(pElemSize)
+    , function(pFunction)
+    , commutative(pCommutative)
+    , zeroIdentity(pZeroIdentity)
+{}
+
+pmStatus pmRegisterReductionOperation(const char* pKey, pmReductionOperation pOperation, pmReductionOpHandle* pReductionOpHandle)
+{
+    if(!pOperation.elemSize || !pOperation.function)
+        return pmInvalidCallbacks;
+
+	SAFE_EXECUTE_ON_CONTROLLER(RegisterReductionOperation_Public, pKey, pOperation, pReductionOpHandle);
+}
+
 pmStatus pmSubscribeToMemory(pmTaskHandle pTaskHandle, pmDeviceHandle pDeviceHandle, unsigned long pSubtaskId, pmSplitInfo& pSplitInfo, uint pMemIndex, pmSubscriptionType pSubscriptionType, const pmSubscriptionInfo& pSubscriptionInfo)
 {
     pmSplitInfo* lSplitInfo = ((pSplitInfo.splitCount == 0) ? NULL : &pSplitInfo);
@@ -846,6 +994,14 @@ pmStatus pmReduceSubtasks(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handl
     SAFE_EXECUTE_ON_CONTROLLER(pmReduceSubtasks_Public, pTaskHandle, pDevice1Handle, pSubtask1Id, lSplitInfo1, pDevice2Handle, pSubtask2Id, lSplitInfo2, pOperation, pDataType);
 }
 
+pmStatus pmReduceSubtasks(pmTaskHandle pTaskHandle, pmDeviceHandle pDevice1Handle, unsigned long pSubtask1Id, pmSplitInfo& pSplitInfo1, pmDeviceHandle pDevice2Handle, unsigned long pSubtask2Id, pmSplitInfo& pSplitInfo2, pmReductionOpHandle pReductionOpHandle)
+{
+    pmSplitInfo* lSplitInfo1 = ((pSplitInfo1.splitCount == 0) ? NULL : &pSplitInfo1);
+    pmSplitInfo* lSplitInfo2 = ((pSplitInfo2.splitCount == 0) ? NULL : &pSplitInfo2);
+
+    SAFE_EXECUTE_ON_CONTROLLER(pmReduceSubtasks_Public, pTaskHandle, pDevice1Handle, pSubtask1Id, lSplitInfo1, pDevice2Handle, pSubtask2Id, lSplitInfo2, pReductionOpHandle);
+}
+
 void* pmGetMappedFile(const char* pPath)
 {
 	try
@@ -884,4 +1040,14 @@ pmStatus pmUnmapFiles(const char* const* pPaths, uint pFileCount)
 	SAFE_EXECUTE_ON_CONTROLLER(UnmapFiles_Public, pPaths, pFileCount);
 }
 
+pmStatus pmCreateFileBackedMemory(const char* pPath, pmMemHandle* pMemHandle)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(CreateFileBackedMemory_Public, pPath, pMemHandle);
+}
+
+pmStatus pmSetEventTracing(bool pEnable)
+{
+	SAFE_EXECUTE_ON_CONTROLLER(SetEventTracing_Public, pEnable);
+}
+
 } // end namespace pm
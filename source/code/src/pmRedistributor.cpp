@@ -218,18 +218,18 @@ void pmRedistributor::CreateRedistributedAddressSpace(ulong pGenerationNumber /*
     if(lAddressSpace->GetAddressSpaceType() == ADDRESS_SPACE_LINEAR)
     {
         if(mTask->GetOriginatingHost() == PM_LOCAL_MACHINE)
-            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetLength(), PM_LOCAL_MACHINE);
+            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetLength(), PM_LOCAL_MACHINE, lAddressSpace->GetAllocationPolicy());
         else
-            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetLength(), lAddressSpace->GetMemOwnerHost(), pGenerationNumber);
+            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetLength(), lAddressSpace->GetMemOwnerHost(), pGenerationNumber, lAddressSpace->GetAllocationPolicy());
     }
     else
     {
         DEBUG_EXCEPTION_ASSERT(lAddressSpace->GetAddressSpaceType() == ADDRESS_SPACE_2D);
 
         if(mTask->GetOriginatingHost() == PM_LOCAL_MACHINE)
-            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetRows(), lAddressSpace->GetCols(), PM_LOCAL_MACHINE);
+            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetRows(), lAddressSpace->GetCols(), PM_LOCAL_MACHINE, lAddressSpace->GetAllocationPolicy());
         else
-            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetRows(), lAddressSpace->GetCols(), lAddressSpace->GetMemOwnerHost(), pGenerationNumber);
+            mRedistributedAddressSpace = pmAddressSpace::CreateAddressSpace(lAddressSpace->GetRows(), lAddressSpace->GetCols(), lAddressSpace->GetMemOwnerHost(), pGenerationNumber, lAddressSpace->GetAllocationPolicy());
     }
 
     pmCommandPtr lCountDownCommand = pmCountDownCommand::CreateSharedPtr(1, mTask->GetPriority(), 0, NULL);
@@ -42,8 +42,15 @@
 #include "pmTaskManager.h"
 #include "pmCallbackUnit.h"
 #include "pmHeavyOperations.h"
+#include "pmReductionKernels.h"
+#include "pmUtility.h"
+#include "pmNetwork.h"
+#include "pmScheduler.h"
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string.h>
 
 namespace pm
 {
@@ -66,6 +73,55 @@ struct reductionDataHolder
     pmExecutionStub* mStub;
 };
 
+namespace reducer
+{
+
+typedef userReductionOperation userReductionOperationsArray[MAX_USER_REDUCTION_OPERATIONS];
+
+STATIC_ACCESSOR_GLOBAL(userReductionOperationsArray, , GetUserReductionOperations)
+STATIC_ACCESSOR_GLOBAL(std::atomic<uint>, (0), GetUserReductionOperationCount)
+STATIC_ACCESSOR_GLOBAL(RESOURCE_LOCK_IMPLEMENTATION_CLASS, __STATIC_LOCK_NAME__("reducer::mUserReductionOperationsLock"), GetUserReductionOperationsLock)
+
+/* Every user reduction operator gets a distinct reduction callback (a template instantiation per slot). This allows
+ * the rest of the library to identify the operator from the task's reduction callback, just like for inbuilt ones.
+ */
+template<uint pSlot>
+pmStatus pmReduceSubtasksUser(pmTaskInfo pTaskInfo, pmDeviceInfo pDevice1Info, pmSubtaskInfo pSubtask1Info, pmDeviceInfo pDevice2Info, pmSubtaskInfo pSubtask2Info)
+{
+    return pmReduceSubtasks(pTaskInfo.taskHandle, pDevice1Info.deviceHandle, pSubtask1Info.subtaskId, pSubtask1Info.splitInfo, pDevice2Info.deviceHandle, pSubtask2Info.subtaskId, pSubtask2Info.splitInfo, (pmReductionOpHandle)(&GetUserReductionOperations()[pSlot]));
+}
+
+template<uint pSlots>
+struct userReductionCallbackTable
+{
+    static void Populate(pmDataReductionCallback* pTable)
+    {
+        pTable[pSlots - 1] = pmReduceSubtasksUser<pSlots - 1>;
+        userReductionCallbackTable<pSlots - 1>::Populate(pTable);
+    }
+};
+
+template<>
+struct userReductionCallbackTable<0>
+{
+    static void Populate(pmDataReductionCallback* pTable)
+    {}
+};
+
+struct userReductionCallbacks
+{
+    pmDataReductionCallback callbacks[MAX_USER_REDUCTION_OPERATIONS];
+
+    userReductionCallbacks()
+    {
+        userReductionCallbackTable<MAX_USER_REDUCTION_OPERATIONS>::Populate(callbacks);
+    }
+};
+
+STATIC_ACCESSOR_GLOBAL(userReductionCallbacks, , GetUserReductionCallbacks)
+
+}
+
 void PostMpiReduceCommandCompletionCallback(const pmCommandPtr& pCommand)
 {
     pmCommunicatorCommandPtr lCommunicatorCommand = std::dynamic_pointer_cast<pmCommunicatorCommandBase>(pCommand);
@@ -99,6 +155,13 @@ pmReducer::pmReducer(pmTask* pTask)
 	, mSendToMachine(NULL)
     , mTask(pTask)
     , mReductionTerminated(false)
+    , mTopology(BINOMIAL_TREE)
+    , mPendingParticipations(0)
+    , mParticipationAnnounced(false)
+    , mScheduleBuilt(false)
+    , mCurrentStep(0)
+    , mCurrentStepSent(false)
+    , mScheduledReceives(0)
     , mResourceLock __LOCK_NAME__("pmReducer::mResourceLock")
 {
 	PopulateExternalMachineList();
@@ -122,6 +185,17 @@ void pmReducer::PopulateExternalMachineList()
     lIter = std::find(lMachinesVector.begin(), lMachinesVector.end(), PM_LOCAL_MACHINE);
 	uint lLocalMachineIndex = (uint)(lIter - lMachinesVector.begin());
 
+    mTopology = SelectTopology((uint)lMachinesVector.size());
+
+    if(mTopology != BINOMIAL_TREE)
+    {
+        mMachines = lMachinesVector;
+        mParticipation.resize(mMachines.size(), communicator::MAX_SUBTASK_MEMORY_REDUCE_MESSAGE_TYPES);
+        mPendingParticipations = (uint)mMachines.size();
+    }
+
+    // Binomial tree data is populated even for other topologies, as these fall back to it when some machine needs packed reduction
+
 	mExternalReductionsRequired = GetMaxPossibleExternalReductionReceives((uint)(lMachines.size()) - lLocalMachineIndex);
 
 	if(lLocalMachineIndex != 0)
@@ -179,15 +253,270 @@ ulong pmReducer::GetMaxPossibleExternalReductionReceives(uint pFollowingMachineC
 	return lMaxReceives;
 }
 
+/* Segmented topologies move O(n) data through every machine rather than O(n log p) through the originating host. They are only
+ * worthwhile for large reductions and need the data to be sent without packing. A commutative operation is also required,
+ * as different segments are reduced in different machine orders. PMLIB_REDUCTION_TOPOLOGY (tree, ring or halving) overrides
+ * the automatic choice and must be set identically on all machines.
+ */
+reductionTopology pmReducer::SelectTopology(uint pMachineCount)
+{
+#ifdef USE_MPI_REDUCE
+    return BINOMIAL_TREE;
+#else
+    static reductionTopology sTopologyOverride = [] ()
+    {
+        const char* lVal = getenv("PMLIB_REDUCTION_TOPOLOGY");
+        if(lVal && *lVal)
+        {
+            for(int i = BINOMIAL_TREE; i < MAX_REDUCTION_TOPOLOGIES; ++i)
+            {
+                if(!strcmp(lVal, GetTopologyName((reductionTopology)i)))
+                    return (reductionTopology)i;
+            }
+        }
+        
+        return MAX_REDUCTION_TOPOLOGIES;
+    }();
+
+    if(pMachineCount < 2)
+        return BINOMIAL_TREE;
+
+    const pmAddressSpace* lAddressSpace = NULL;
+    size_t lReducibleAddressSpaces = 0;
+    
+    filtered_for_each(mTask->GetAddressSpaces(), [&] (const pmAddressSpace* pAddressSpace) {return (mTask->IsWritable(pAddressSpace) && mTask->IsReducible(pAddressSpace));},
+    [&] (const pmAddressSpace* pAddressSpace)
+    {
+        lAddressSpace = pAddressSpace;
+        ++lReducibleAddressSpaces;
+    });
+    
+    if(lReducibleAddressSpaces != 1 || mTask->IsLazy(lAddressSpace) || !NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->IsImplicitlyReducible(mTask))
+        return BINOMIAL_TREE;
+    
+    const userReductionOperation* lUserOperation = FindUserReductionOperation(mTask->GetCallbackUnit()->GetDataReductionCB()->GetCallback());
+    if(lUserOperation && !lUserOperation->operation.commutative)
+        return BINOMIAL_TREE;
+    
+    if(sTopologyOverride != MAX_REDUCTION_TOPOLOGIES)
+        return sTopologyOverride;
+
+    ulong lLength = lAddressSpace->GetLength();
+
+    if(pMachineCount < 3 || lLength < SEGMENTED_REDUCTION_MIN_LENGTH)
+        return BINOMIAL_TREE;
+    
+    // Recursive halving needs log(p) steps against p - 1 for the ring, but sends extra data when p is not a power of two
+    if((pMachineCount & (pMachineCount - 1)) == 0 || lLength < RING_REDUCTION_MIN_LENGTH)
+        return RECURSIVE_HALVING;
+    
+    return RING;
+#endif
+}
+
+const char* pmReducer::GetTopologyName(reductionTopology pTopology)
+{
+    switch(pTopology)
+    {
+        case BINOMIAL_TREE:
+            return "tree";
+            
+        case RING:
+            return "ring";
+            
+        case RECURSIVE_HALVING:
+            return "halving";
+            
+        default:
+            PMTHROW(pmFatalErrorException());
+    }
+    
+    return NULL;
+}
+
 void pmReducer::PrepareForExternalReceive(communicator::subtaskMemoryReduceStruct& pStruct)
 {
     FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
 
-    mSubtaskMemoryReduceStructVector.emplace_back(pStruct);
+    if(pStruct.messageType == communicator::REDUCE_SEGMENT || pStruct.messageType == communicator::GATHER_SEGMENT)
+        mSubtaskMemoryReduceStructVector.emplace_back(pStruct);
+    else
+        RegisterParticipationInternal(pmMachinePool::GetMachinePool()->GetMachine(pStruct.senderHost), (communicator::subtaskMemoryReduceMessageType)pStruct.messageType);
     
     CheckReductionFinishInternal();
 }
 
+/* This function must be called with mResourceLock acquired */
+void pmReducer::RegisterParticipationInternal(const pmMachine* pMachine, communicator::subtaskMemoryReduceMessageType pMessageType)
+{
+    std::vector<const pmMachine*>::iterator lIter = std::find(mMachines.begin(), mMachines.end(), pMachine);
+    
+    EXCEPTION_ASSERT(lIter != mMachines.end() && mPendingParticipations);
+    
+    ushort& lParticipation = mParticipation[lIter - mMachines.begin()];
+
+    EXCEPTION_ASSERT(lParticipation == communicator::MAX_SUBTASK_MEMORY_REDUCE_MESSAGE_TYPES);
+
+    lParticipation = (ushort)pMessageType;
+    --mPendingParticipations;
+}
+
+/* This function must be called with mResourceLock acquired */
+void pmReducer::BuildTopologyScheduleInternal()
+{
+    mScheduleBuilt = true;
+
+    std::vector<const pmMachine*> lParticipants;
+    bool lPackedDataFound = false;
+    
+    for_each_with_index(mParticipation, [&] (ushort pParticipation, size_t pIndex)
+    {
+        if(pParticipation == communicator::PARTICIPATION_WITH_PACKED_DATA)
+            lPackedDataFound = true;
+
+        if(pParticipation != communicator::PARTICIPATION_WITHOUT_DATA)
+            lParticipants.push_back(mMachines[pIndex]);
+    });
+    
+    // The originating host gathers the reduced segments and must hold data itself (as it must for the binomial tree)
+    if(lPackedDataFound || lParticipants.empty() || lParticipants[0] != mTask->GetOriginatingHost())
+    {
+        FallbackToBinomialTreeInternal();
+        return;
+    }
+    
+    std::vector<const pmMachine*>::iterator lIter = std::find(lParticipants.begin(), lParticipants.end(), PM_LOCAL_MACHINE);
+    if(lIter == lParticipants.end())
+        return;
+    
+    uint lRank = (uint)(lIter - lParticipants.begin());
+
+    if(mTopology == RING)
+        BuildRingSchedule(lParticipants, lRank);
+    else
+        BuildRecursiveHalvingSchedule(lParticipants, lRank);
+}
+
+/* In step s, rank r reduces segment (r - s) into its successor. After p - 1 steps, rank r holds the fully reduced segment (r + 1). */
+void pmReducer::BuildRingSchedule(const std::vector<const pmMachine*>& pParticipants, uint pRank)
+{
+    uint lCount = (uint)pParticipants.size();
+    
+    for(uint lStepId = 0; lStepId < lCount - 1; ++lStepId)
+    {
+        uint lSegment = (pRank + lCount - lStepId) % lCount;
+
+        reductionStep lStep;
+        lStep.sendToMachine = pParticipants[(pRank + 1) % lCount];
+        lStep.segment = reductionSegment(lStepId, lSegment, lSegment + 1, lCount, false);
+        lStep.receives = 1;
+
+        mSchedule.push_back(lStep);
+    }
+    
+    reductionStep lGatherStep;
+    
+    if(pRank)
+    {
+        uint lSegment = (pRank + 1) % lCount;
+
+        lGatherStep.sendToMachine = pParticipants[0];
+        lGatherStep.segment = reductionSegment(lCount - 1, lSegment, lSegment + 1, lCount, true);
+    }
+    else
+    {
+        lGatherStep.receives = lCount - 1;
+    }
+
+    mSchedule.push_back(lGatherStep);
+}
+
+/* Step 0 folds the ranks in excess of the largest power of two (q) into their even neighbours. In every later step, a rank
+ * exchanges half of its range of segments with the rank whose (renumbered) id differs in one bit. After log(q) steps, every
+ * remaining rank holds one fully reduced segment (out of q).
+ */
+void pmReducer::BuildRecursiveHalvingSchedule(const std::vector<const pmMachine*>& pParticipants, uint pRank)
+{
+    uint lCount = (uint)pParticipants.size();
+    uint lPowerOfTwo = 1;
+    
+    while(2 * lPowerOfTwo <= lCount)
+        lPowerOfTwo *= 2;
+    
+    uint lExtraRanks = lCount - lPowerOfTwo;
+    uint lNewRank = pRank - lExtraRanks;
+
+    reductionStep lFoldStep;
+
+    if(pRank < 2 * lExtraRanks)
+    {
+        if(pRank & 0x1)
+        {
+            lFoldStep.sendToMachine = pParticipants[pRank - 1];
+            lFoldStep.segment = reductionSegment(0, 0, lPowerOfTwo, lPowerOfTwo, false);
+            
+            mSchedule.push_back(lFoldStep);
+            return;
+        }
+
+        lFoldStep.receives = 1;
+        lNewRank = pRank / 2;
+    }
+    
+    mSchedule.push_back(lFoldStep);
+    
+    uint lBegin = 0, lEnd = lPowerOfTwo, lStepId = 1;
+
+    for(uint lDistance = lPowerOfTwo / 2; lDistance; lDistance /= 2, ++lStepId)
+    {
+        uint lPartnerNewRank = (lNewRank ^ lDistance);
+        uint lPartner = ((lPartnerNewRank < lExtraRanks) ? (2 * lPartnerNewRank) : (lPartnerNewRank + lExtraRanks));
+        uint lMid = lBegin + (lEnd - lBegin) / 2;
+
+        reductionStep lStep;
+        lStep.sendToMachine = pParticipants[lPartner];
+        lStep.receives = 1;
+        
+        if(lNewRank & lDistance)
+        {
+            lStep.segment = reductionSegment(lStepId, lBegin, lMid, lPowerOfTwo, false);
+            lBegin = lMid;
+        }
+        else
+        {
+            lStep.segment = reductionSegment(lStepId, lMid, lEnd, lPowerOfTwo, false);
+            lEnd = lMid;
+        }
+        
+        mSchedule.push_back(lStep);
+    }
+    
+    reductionStep lGatherStep;
+    
+    if(pRank)
+    {
+        lGatherStep.sendToMachine = pParticipants[0];
+        lGatherStep.segment = reductionSegment(lStepId, lBegin, lEnd, lPowerOfTwo, true);
+    }
+    else
+    {
+        lGatherStep.receives = lPowerOfTwo - 1;
+    }
+
+    mSchedule.push_back(lGatherStep);
+}
+
+/* This function must be called with mResourceLock acquired */
+void pmReducer::FallbackToBinomialTreeInternal()
+{
+    mTopology = BINOMIAL_TREE;
+    
+    if(mTask->GetSubtasksExecuted())
+        CheckReductionFinishInternal();
+    else
+        SignalSendToMachineAboutNoLocalReductionInternal();
+}
+
 void pmReducer::AddSubtask(pmExecutionStub* pStub, ulong pSubtaskId, pmSplitInfo* pSplitInfo)
 {
 	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
@@ -236,14 +565,27 @@ void pmReducer::PerformDirectExternalReductions()
 {
     FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
 
-    EXCEPTION_ASSERT(mExternalReductionsRequired);
+    EXCEPTION_ASSERT(mTopology != BINOMIAL_TREE || mExternalReductionsRequired);
+
+    // Segmented topologies only receive the segments of the current step
+    std::vector<communicator::subtaskMemoryReduceStruct>::iterator lStructIter = mSubtaskMemoryReduceStructVector.end();
+
+    if(mTopology == BINOMIAL_TREE)
+    {
+        if(!mSubtaskMemoryReduceStructVector.empty())
+            --lStructIter;
+    }
+    else
+    {
+        lStructIter = std::find_if(mSubtaskMemoryReduceStructVector.begin(), mSubtaskMemoryReduceStructVector.end(), [&] (const communicator::subtaskMemoryReduceStruct& pStruct) {return (pStruct.reductionStep == mCurrentStep);});
+    }
 
-    if(mSubtaskMemoryReduceStructVector.empty())
+    if(lStructIter == mSubtaskMemoryReduceStructVector.end())
         return;
 
     DEBUG_EXCEPTION_ASSERT(mTask->HasSubtaskExecutionFinished());
 
-    communicator::subtaskMemoryReduceStruct& lSubtaskMemoryReduceStruct = mSubtaskMemoryReduceStructVector.back();
+    communicator::subtaskMemoryReduceStruct& lSubtaskMemoryReduceStruct = *lStructIter;
     
     pmSubscriptionManager& lSubscriptionManager = mTask->GetSubscriptionManager();
     bool lHasScratchBuffers = lSubscriptionManager.HasScratchBuffers(mLastSubtask.stub, mLastSubtask.subtaskId, mLastSubtask.splitInfo.get_ptr());
@@ -306,7 +648,7 @@ void pmReducer::PerformDirectExternalReductions()
     lCommand->HoldExternalDataForLifetimeOfCommand(lDataPtr);
 #endif
 
-    mSubtaskMemoryReduceStructVector.resize(mSubtaskMemoryReduceStructVector.size() - 1);
+    mSubtaskMemoryReduceStructVector.erase(lStructIter);
 
     pmCommunicator::GetCommunicator()->ReceiveReduce(lCommand);
 }
@@ -314,6 +656,12 @@ void pmReducer::PerformDirectExternalReductions()
 /* This function must be called with mResourceLock acquired */
 void pmReducer::CheckReductionFinishInternal()
 {
+    if(mTopology != BINOMIAL_TREE)
+    {
+        CheckTopologyReductionProgressInternal();
+        return;
+    }
+
     ulong lSubtasksSplitted = 0;
     ulong lSplitCount = mTask->GetTotalSplitCount(lSubtasksSplitted);
     ulong lExtraReductionsForSplits = lSplitCount - lSubtasksSplitted;
@@ -347,6 +695,105 @@ void pmReducer::CheckReductionFinishInternal()
     }
 }
     
+/* A machine announces its participation once its local reductions are over (or it is known to have no data). Then, it steps
+ * through its schedule; a step's segment is sent only after the segments received in all earlier steps have been reduced.
+ * This function must be called with mResourceLock acquired.
+ */
+void pmReducer::CheckTopologyReductionProgressInternal()
+{
+    if(!mTask->HasSubtaskExecutionFinished())
+        return;
+
+    ulong lSubtasksSplitted = 0;
+    ulong lSplitCount = mTask->GetTotalSplitCount(lSubtasksSplitted);
+    ulong lExtraReductionsForSplits = lSplitCount - lSubtasksSplitted;
+    ulong lSubtasksExecuted = mTask->GetSubtasksExecuted();
+    ulong lInternalReductionsCount = lExtraReductionsForSplits + lSubtasksExecuted - 1;
+
+    bool lLocalReductionsDone = (lSubtasksExecuted && mReduceState && mReductionsDone >= lInternalReductionsCount);
+
+    if(!mParticipationAnnounced)
+    {
+        if(lSubtasksExecuted && !lLocalReductionsDone)
+            return;
+
+        mParticipationAnnounced = true;
+
+        communicator::subtaskMemoryReduceMessageType lMessageType = communicator::PARTICIPATION_WITHOUT_DATA;
+        if(lSubtasksExecuted)
+        {
+            bool lHasScratchBuffers = mTask->GetSubscriptionManager().HasScratchBuffers(mLastSubtask.stub, mLastSubtask.subtaskId, mLastSubtask.splitInfo.get_ptr());
+
+            lMessageType = (lHasScratchBuffers ? communicator::PARTICIPATION_WITH_PACKED_DATA : communicator::PARTICIPATION_WITH_DATA);
+        }
+        
+        std::vector<const pmMachine*> lOtherMachines;
+        std::copy_if(mMachines.begin(), mMachines.end(), std::back_inserter(lOtherMachines), [] (const pmMachine* pMachine) {return (pMachine != PM_LOCAL_MACHINE);});
+        
+        pmScheduler::GetScheduler()->ReductionParticipationEvent(mTask, std::move(lOtherMachines), lMessageType);
+
+        RegisterParticipationInternal(PM_LOCAL_MACHINE, lMessageType);
+    }
+    
+    if(mPendingParticipations)
+        return;
+    
+    if(!mScheduleBuilt)
+    {
+        BuildTopologyScheduleInternal();
+
+        if(mTopology == BINOMIAL_TREE)
+            return;
+    }
+    
+    if(!lSubtasksExecuted)
+    {
+        mReductionTerminated = true;
+        return;
+    }
+
+    ulong lExternalReductionsDone = mReductionsDone - lInternalReductionsCount;
+
+    while(mCurrentStep < mSchedule.size())
+    {
+        const reductionStep& lStep = mSchedule[mCurrentStep];
+
+        if(!mCurrentStepSent)
+        {
+            mCurrentStepSent = true;
+            mScheduledReceives += lStep.receives;
+
+            if(lStep.sendToMachine)
+            {
+                EXCEPTION_ASSERT(lStep.sendToMachine != PM_LOCAL_MACHINE);
+
+                pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()->ReduceRequestEvent(mLastSubtask.stub, mTask, lStep.sendToMachine, mLastSubtask.subtaskId, mLastSubtask.splitInfo.get_ptr(), lStep.segment);
+            }
+        }
+        
+        if(lExternalReductionsDone < mScheduledReceives)
+        {
+            size_t lArrivedReceives = std::count_if(mSubtaskMemoryReduceStructVector.begin(), mSubtaskMemoryReduceStructVector.end(), [&] (const communicator::subtaskMemoryReduceStruct& pStruct) {return (pStruct.reductionStep == mCurrentStep);});
+
+            for(size_t i = 0; i < lArrivedReceives; ++i)
+                mLastSubtask.stub->AddPlaceHolderEventForDirectExternalReduction(mTask);
+
+            return;
+        }
+        
+        ++mCurrentStep;
+        mCurrentStepSent = false;
+    }
+    
+    if(!mReductionTerminated)
+    {
+        mReductionTerminated = true;
+
+        if(mTask->GetOriginatingHost() == PM_LOCAL_MACHINE)
+            AddReductionFinishEvent();
+    }
+}
+
 /* This function must be called with mResourceLock acquired */
 void pmReducer::AddReductionFinishEvent()
 {
@@ -374,6 +821,9 @@ void pmReducer::SignalSendToMachineAboutNoLocalReduction()
 /* This function must be called with mResourceLock acquired */
 void pmReducer::SignalSendToMachineAboutNoLocalReductionInternal()
 {
+    if(mTopology != BINOMIAL_TREE)     // Segmented topologies exchange participation instead
+        return;
+
     if(mSendToMachine && !mExternalReductionsRequired)
     {
         if(!mReductionTerminated)
@@ -399,30 +849,16 @@ void pmReducer::RegisterNoReductionReqdResponse()
 
     --mExternalReductionsRequired;
 
+    // Machines falling back to binomial tree (from another topology) before this one may already be sending these
+    if(mTopology != BINOMIAL_TREE)
+        return;
+
     if(mTask->GetSubtasksExecuted())
         CheckReductionFinishInternal();
     else
         SignalSendToMachineAboutNoLocalReductionInternal();
 }
 
-template<typename datatype>
-struct getBitwiseOperatableType
-{
-    typedef datatype type;
-};
-    
-template<>
-struct getBitwiseOperatableType<float>
-{
-    typedef uint type;
-};
-    
-template<>
-struct getBitwiseOperatableType<double>
-{
-    typedef ulong type;
-};
-
 void pmReducer::ReduceExternalMemory(pmExecutionStub* pStub, const pmCommandPtr& pCommand)
 {
     pmCommunicatorCommandPtr lCommunicatorCommand = std::dynamic_pointer_cast<pmCommunicatorCommandBase>(pCommand);
@@ -485,6 +921,11 @@ void pmReducer::ReduceExternalMemory(pmExecutionStub* pStub, const pmCommandPtr&
         lLength = (uint)lBeginIter->second.first;
     }
 
+    EXCEPTION_ASSERT(lReceiveStruct->offset + lReceiveStruct->segmentLength <= lLength);
+
+    lOffset += lReceiveStruct->offset;
+    lLength = lReceiveStruct->segmentLength;
+
 #if 0
     if(lCompressed)
         std::cout << "Received " << lReceiveStruct->length << " bytes instead of " << lLength << " (" << (double)(lReceiveStruct->length * 100) / lLength << "%)" << std::endl;
@@ -492,28 +933,61 @@ void pmReducer::ReduceExternalMemory(pmExecutionStub* pStub, const pmCommandPtr&
     
     void* lMem = (static_cast<char*>(lShadowMem) + lOffset);
 
-    pmReductionOpType lOpType;
-    pmReductionDataType lDataType;
-    
-    findReductionOpAndDataType(mTask->GetCallbackUnit()->GetDataReductionCB()->GetCallback(), lOpType, lDataType);
-    
-    if(!lCompressed)
+    pmDataReductionCallback lCallback = mTask->GetCallbackUnit()->GetDataReductionCB()->GetCallback();
+    const userReductionOperation* lUserOperation = FindUserReductionOperation(lCallback);
+
+    pmReductionOpType lOpType = MAX_REDUCTION_OP_TYPES;
+    pmReductionDataType lDataType = MAX_REDUCTION_DATA_TYPES;
+
+    if(!lUserOperation)
+        findReductionOpAndDataType(lCallback, lOpType, lDataType);
+
+    if(lReceiveStruct->messageType == communicator::GATHER_SEGMENT)
     {
-        switch(lDataType)
+        if(lCompressed)
         {
-            case REDUCE_INTS:
-            {
-                ReduceMemories<int>((int*)lMem, (int*)lDataHolder->mPtr, lLength / sizeof(int), lOpType);
-                break;
-            }
-                
-            case REDUCE_UNSIGNED_INTS:
-            {
-                ReduceMemories<uint>((uint*)lMem, (uint*)lDataHolder->mPtr, lLength / sizeof(uint), lOpType);
-                break;
-            }
-                
-            case REDUCE_LONGS:
+            // Compression leaves out zeros, which are the identity of the operation; so a gathered segment is just decompressed
+            pmUtility::DecompressForSentinel(lDataHolder->mPtr, lReceiveStruct->length, (lUserOperation ? lUserOperation->operation.elemSize : getReductionDataTypeSize(lDataType)), lMem);
+        }
+        else
+        {
+            PMLIB_MEMCPY(lMem, lDataHolder->mPtr, lLength, std::string("pmReducer::ReduceExternalMemory"));
+        }
+
+        RegisterExternalReductionFinish();
+        return;
+    }
+
+    if(lUserOperation)
+    {
+        const pmReductionOperation& lOperation = lUserOperation->operation;
+
+        if(lCompressed)
+            ReduceMemoriesCompressed(lMem, lDataHolder->mPtr, lReceiveStruct->length, lOperation);
+        else
+            ReduceMemories(lMem, lDataHolder->mPtr, lLength / lOperation.elemSize, lOperation);
+
+        RegisterExternalReductionFinish();
+        return;
+    }
+
+    if(!lCompressed)
+    {
+        switch(lDataType)
+        {
+            case REDUCE_INTS:
+            {
+                ReduceMemories<int>((int*)lMem, (int*)lDataHolder->mPtr, lLength / sizeof(int), lOpType);
+                break;
+            }
+                
+            case REDUCE_UNSIGNED_INTS:
+            {
+                ReduceMemories<uint>((uint*)lMem, (uint*)lDataHolder->mPtr, lLength / sizeof(uint), lOpType);
+                break;
+            }
+                
+            case REDUCE_LONGS:
             {
                 ReduceMemories<long>((long*)lMem, (long*)lDataHolder->mPtr, lLength / sizeof(long), lOpType);
                 break;
@@ -547,37 +1021,37 @@ void pmReducer::ReduceExternalMemory(pmExecutionStub* pStub, const pmCommandPtr&
         {
             case REDUCE_INTS:
             {
-                ReduceMemoriesCompressed<int>((int*)lMem, (int*)lDataHolder->mPtr, lReceiveStruct->length / sizeof(int), lOpType, 0);
+                ReduceMemoriesCompressed<int>((int*)lMem, lDataHolder->mPtr, lReceiveStruct->length, lOpType);
                 break;
             }
                 
             case REDUCE_UNSIGNED_INTS:
             {
-                ReduceMemoriesCompressed<uint>((uint*)lMem, (uint*)lDataHolder->mPtr, lReceiveStruct->length / sizeof(uint), lOpType, 0);
+                ReduceMemoriesCompressed<uint>((uint*)lMem, lDataHolder->mPtr, lReceiveStruct->length, lOpType);
                 break;
             }
                 
             case REDUCE_LONGS:
             {
-                ReduceMemoriesCompressed<long>((long*)lMem, (long*)lDataHolder->mPtr, lReceiveStruct->length / sizeof(long), lOpType, 0);
+                ReduceMemoriesCompressed<long>((long*)lMem, lDataHolder->mPtr, lReceiveStruct->length, lOpType);
                 break;
             }
                 
             case REDUCE_UNSIGNED_LONGS:
             {
-                ReduceMemoriesCompressed<ulong>((ulong*)lMem, (ulong*)lDataHolder->mPtr, lReceiveStruct->length / sizeof(ulong), lOpType, 0);
+                ReduceMemoriesCompressed<ulong>((ulong*)lMem, lDataHolder->mPtr, lReceiveStruct->length, lOpType);
                 break;
             }
                 
             case REDUCE_FLOATS:
             {
-                ReduceMemoriesCompressed<float>((float*)lMem, (float*)lDataHolder->mPtr, lReceiveStruct->length / sizeof(float), lOpType, 0);
+                ReduceMemoriesCompressed<float>((float*)lMem, lDataHolder->mPtr, lReceiveStruct->length, lOpType);
                 break;
             }
                 
             case REDUCE_DOUBLES:
             {
-                ReduceMemoriesCompressed<double>((double*)lMem, (double*)lDataHolder->mPtr, lReceiveStruct->length / sizeof(double), lOpType, 0);
+                ReduceMemoriesCompressed<double>((double*)lMem, lDataHolder->mPtr, lReceiveStruct->length, lOpType);
                 break;
             }
                 
@@ -592,490 +1066,53 @@ void pmReducer::ReduceExternalMemory(pmExecutionStub* pStub, const pmCommandPtr&
 template<typename datatype>
 void pmReducer::ReduceMemories(datatype* pShadowMem1, datatype* pShadowMem2, size_t pDataCount, pmReductionOpType pReductionType)
 {
-    switch(pReductionType)
+#ifdef USE_OMP_FOR_REDUCTION
+    const size_t lChunkElems = REDUCTION_KERNEL_CHUNK_SIZE / sizeof(datatype);
+    const size_t lChunks = (pDataCount + lChunkElems - 1) / lChunkElems;
+
+    if(lChunks > 1)
     {
-        case REDUCE_ADD:
+        #pragma omp parallel for
+        for(size_t i = 0; i < lChunks; ++i)
         {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] += pShadowMem2[i];
-            
-            break;
-        }
-            
-        case REDUCE_MIN:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = std::min(pShadowMem1[i], pShadowMem2[i]);
-            
-            break;
+            size_t lStartElem = i * lChunkElems;
+            pmReductionKernels::Reduce(pShadowMem1 + lStartElem, pShadowMem2 + lStartElem, std::min(lChunkElems, pDataCount - lStartElem), pReductionType);
         }
         
-        case REDUCE_MAX:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = std::max(pShadowMem1[i], pShadowMem2[i]);
-            
-            break;
-        }
-        
-        case REDUCE_PRODUCT:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] *= pShadowMem2[i];
-            
-            break;
-        }
-        
-        case REDUCE_LOGICAL_AND:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = (pShadowMem1[i] && pShadowMem2[i]);
-            
-            break;
-        }
-        
-        case REDUCE_BITWISE_AND:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[i]) & (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-            
-            break;
-        }
-        
-        case REDUCE_LOGICAL_OR:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = (pShadowMem1[i] || pShadowMem2[i]);
-            
-            break;
-        }
-        
-        case REDUCE_BITWISE_OR:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[i]) | (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-            
-            break;
-        }
-        
-        case REDUCE_LOGICAL_XOR:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = (pShadowMem1[i] != pShadowMem2[i]);
-            
-            break;
-        }
-
-        case REDUCE_BITWISE_XOR:
-        {
-        #ifdef USE_OMP_FOR_REDUCTION
-            #pragma omp parallel for
-        #endif
-            for(size_t i = 0; i < pDataCount; ++i)
-                pShadowMem1[i] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[i]) ^ (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-            
-            break;
-        }
-
-        default:
-            PMTHROW(pmFatalErrorException());
+        return;
     }
+#endif
+
+    pmReductionKernels::Reduce(pShadowMem1, pShadowMem2, pDataCount, pReductionType);
 }
 
-#ifdef USE_OMP_FOR_REDUCTION
+/* Non-sentinel data is reduced a run at a time. Every run is contiguous in both the compressed buffer and the shadow memory,
+ * so the vectorized kernels apply to it as they do to uncompressed data. Frames of the compressed buffer are independent
+ * and are reduced in parallel.
+ */
 template<typename datatype>
-void pmReducer::ReduceMemoriesCompressed(datatype* pShadowMem1, datatype* pShadowMem2, size_t pDataCount, pmReductionOpType pReductionType, datatype pSentinel)
+void pmReducer::ReduceMemoriesCompressed(datatype* pShadowMem1, const void* pCompressedMem, ulong pCompressedLength, pmReductionOpType pReductionType)
 {
-    uint lFirstSentinelIndex = *((uint*)(&pShadowMem2[pDataCount - 1]));
-    uint lSentinelCount = (pDataCount - 1 - lFirstSentinelIndex) / 2;
-
-    EXCEPTION_ASSERT(lFirstSentinelIndex);
-    EXCEPTION_ASSERT(lSentinelCount);
-    EXCEPTION_ASSERT((pDataCount - 1 - lFirstSentinelIndex) % 2 == 0);
+    std::vector<const sentinelCompression::frameHeader*> lFrames;
+    pmUtility::GetSentinelCompressedFrames(pCompressedMem, pCompressedLength, lFrames);
     
-    #pragma omp parallel for
-    for(uint sentinelId = 0; sentinelId < lSentinelCount; ++sentinelId)
-    {
-        uint lBeginIndex = *((uint*)(&pShadowMem2[lFirstSentinelIndex + 2 * sentinelId]));
-        uint lEndIndex = (sentinelId == lSentinelCount - 1) ? lFirstSentinelIndex - 1 : *((uint*)(&pShadowMem2[lFirstSentinelIndex + 2 * sentinelId + 2]));
-        
-        uint index = *((uint*)(&pShadowMem2[lFirstSentinelIndex + 2 * sentinelId + 1]));
-
-        switch(pReductionType)
-        {
-            case REDUCE_ADD:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
+    long lFrameCount = (long)lFrames.size();
 
-                    pShadowMem1[index] += pShadowMem2[i];
-                }
-                
-                break;
-            }
-                
-            case REDUCE_MIN:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = std::min(pShadowMem1[index], pShadowMem2[i]);
-                }
-                
-                break;
-            }
-            
-            case REDUCE_MAX:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = std::max(pShadowMem1[index], pShadowMem2[i]);
-                }
-                
-                break;
-            }
-            
-            case REDUCE_PRODUCT:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] *= pShadowMem2[i];
-                }
-                
-                break;
-            }
-            
-            case REDUCE_LOGICAL_AND:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = (pShadowMem1[index] && pShadowMem2[i]);
-                }
-                
-                break;
-            }
-            
-            case REDUCE_BITWISE_AND:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[index]) & (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-                }
-                
-                break;
-            }
-            
-            case REDUCE_LOGICAL_OR:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = (pShadowMem1[index] || pShadowMem2[i]);
-                }
-                
-                break;
-            }
-            
-            case REDUCE_BITWISE_OR:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[index]) | (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-                }
-                
-                break;
-            }
-            
-            case REDUCE_LOGICAL_XOR:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = (pShadowMem1[index] != pShadowMem2[i]);
-                }
-                
-                break;
-            }
-
-            case REDUCE_BITWISE_XOR:
-            {
-                for(uint i = lBeginIndex; i < lEndIndex; ++i, ++index)
-                {
-                    if(pShadowMem2[i] == pSentinel)
-                    {
-                        ++i;
-                        index = *((uint*)(&pShadowMem2[i++]));
-                    }
-
-                    pShadowMem1[index] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[index]) ^ (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-                }
-                
-                break;
-            }
-
-            default:
-                PMTHROW(pmFatalErrorException());
-        }
-    }
-}
-#else
-template<typename datatype>
-void pmReducer::ReduceMemoriesCompressed(datatype* pShadowMem1, datatype* pShadowMem2, size_t pDataCount, pmReductionOpType pReductionType, datatype pSentinel)
-{
-    size_t index = 0;
-
-    switch(pReductionType)
+#ifdef USE_OMP_FOR_REDUCTION
+    #pragma omp parallel for
+#endif
+    for(long i = 0; i < lFrameCount; ++i)
     {
-        case REDUCE_ADD:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] += pShadowMem2[i];
-            }
-            
-            break;
-        }
-            
-        case REDUCE_MIN:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = std::min(pShadowMem1[index], pShadowMem2[i]);
-            }
-            
-            break;
-        }
-        
-        case REDUCE_MAX:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = std::max(pShadowMem1[index], pShadowMem2[i]);
-            }
-            
-            break;
-        }
-        
-        case REDUCE_PRODUCT:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] *= pShadowMem2[i];
-            }
-            
-            break;
-        }
-        
-        case REDUCE_LOGICAL_AND:
+        pmUtility::ForEachSentinelCompressedRun(lFrames[i], sizeof(datatype), [&] (ulong pElemIndex, const char* pData, ulong pElems)
         {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = (pShadowMem1[index] && pShadowMem2[i]);
-            }
-            
-            break;
-        }
-        
-        case REDUCE_BITWISE_AND:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[index]) & (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-            }
-            
-            break;
-        }
-        
-        case REDUCE_LOGICAL_OR:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = (pShadowMem1[index] || pShadowMem2[i]);
-            }
-            
-            break;
-        }
-        
-        case REDUCE_BITWISE_OR:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[index]) | (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-            }
-            
-            break;
-        }
-        
-        case REDUCE_LOGICAL_XOR:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = (pShadowMem1[index] != pShadowMem2[i]);
-            }
-            
-            break;
-        }
-
-        case REDUCE_BITWISE_XOR:
-        {
-            for(size_t i = 0; i < pDataCount; ++i, ++index)
-            {
-                if(pShadowMem2[i] == pSentinel)
-                {
-                    ++i;
-                    index = (size_t)pShadowMem2[i++];
-                }
-
-                pShadowMem1[index] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(pShadowMem1[index]) ^ (typename getBitwiseOperatableType<datatype>::type)(pShadowMem2[i]));
-            }
-            
-            break;
-        }
-
-        default:
-            PMTHROW(pmFatalErrorException());
+            pmReductionKernels::Reduce(pShadowMem1 + pElemIndex, reinterpret_cast<const datatype*>(pData), pElems, pReductionType);
+        });
     }
 }
-#endif
     
-template<typename datatype>
-void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, pmReductionOpType pReductionType)
+template<typename reductionFunction>
+void pmReducer::ReduceSubtaskAddressSpaces(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, size_t pElemSize, reductionFunction pFunction)
 {
-    size_t lDataSize = sizeof(datatype);
-    
-    DEBUG_EXCEPTION_ASSERT(MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->GetVirtualMemoryPageSize() % lDataSize == 0);
-
     pmSubscriptionManager& lSubscriptionManager = mTask->GetSubscriptionManager();
     
     filtered_for_each_with_index(mTask->GetAddressSpaces(), [&] (const pmAddressSpace* pAddressSpace) {return (mTask->IsWritable(pAddressSpace) && mTask->IsReducible(pAddressSpace));},
@@ -1083,203 +1120,25 @@ void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSpl
     {
         uint lAddressSpaceIndex = (uint)pAddressSpaceIndex;
 
-        datatype* lShadowMem1 = (datatype*)lSubscriptionManager.GetSubtaskShadowMem(pStub1, pSubtaskId1, pSplitInfo1, lAddressSpaceIndex);
-        datatype* lShadowMem2 = (datatype*)lSubscriptionManager.GetSubtaskShadowMem(pStub2, pSubtaskId2, pSplitInfo2, lAddressSpaceIndex);
+        char* lShadowMem1 = (char*)lSubscriptionManager.GetSubtaskShadowMem(pStub1, pSubtaskId1, pSplitInfo1, lAddressSpaceIndex);
+        char* lShadowMem2 = (char*)lSubscriptionManager.GetSubtaskShadowMem(pStub2, pSubtaskId2, pSplitInfo2, lAddressSpaceIndex);
 
     #ifdef SUPPORT_LAZY_MEMORY
         if(mTask->IsLazyWriteOnly(pAddressSpace))
         {
             size_t lPageSize = MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->GetVirtualMemoryPageSize();
 
+            EXCEPTION_ASSERT(lPageSize % pElemSize == 0);
+
             const std::map<size_t, size_t>& lMap = lSubscriptionManager.GetWriteOnlyLazyUnprotectedPageRanges(pStub2, pSubtaskId2, pSplitInfo2, lAddressSpaceIndex);
             
-            std::map<size_t, size_t>::const_iterator lIter = lMap.begin(), lEndIter = lMap.end();
-            
-            switch(pReductionType)
+            for_each(lMap, [&] (const std::pair<size_t, size_t>& pPageRange)
             {
-                case REDUCE_ADD:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] += lArray2[i];
-                    }
-                    
-                    break;
-                }
-                    
-                case REDUCE_MIN:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = std::min(lArray1[i], lArray2[i]);
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_MAX:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = std::max(lArray1[i], lArray2[i]);
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_PRODUCT:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] *= lArray2[i];
-                    }
-                    
-                    break;
-                }
+                size_t lDataCount = (pPageRange.second * lPageSize) / pElemSize;
+                size_t lStartOffset = pPageRange.first * lPageSize;
 
-                case REDUCE_LOGICAL_AND:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = (lArray1[i] && lArray2[i]);
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_BITWISE_AND:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(lArray1[i]) & (typename getBitwiseOperatableType<datatype>::type)(lArray2[i]));
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_LOGICAL_OR:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = (lArray1[i] || lArray2[i]);
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_BOTWISE_OR:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(lArray1[i]) | (typename getBitwiseOperatableType<datatype>::type)(lArray2[i]));
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_LOGICAL_XOR:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = (lArray1[i] != lArray2[i]);
-                    }
-                    
-                    break;
-                }
-
-                case REDUCE_BITWISE_XOR:
-                {
-                    for(; lIter != lEndIter; ++lIter)
-                    {
-                        size_t lStartPage = lIter->first;
-                        size_t lPageCount = lIter->second;
-                        
-                        size_t lDataCount = (lPageCount * lPageSize) / lDataSize;
-                        datatype* lArray1 = lShadowMem1 + ((lStartPage * lPageSize) / lDataSize);
-                        datatype* lArray2 = lShadowMem2 + ((lStartPage * lPageSize) / lDataSize);
-                        
-                        for(size_t i = 0; i < lDataCount; ++i)
-                            lArray1[i] = (datatype)((typename getBitwiseOperatableType<datatype>::type)(lArray1[i]) ^ (typename getBitwiseOperatableType<datatype>::type)(lArray2[i]));
-                    }
-                    
-                    break;
-                }
-
-                default:
-                    PMTHROW(pmFatalErrorException());
-            }
+                pFunction(lShadowMem1 + lStartOffset, lShadowMem2 + lStartOffset, lDataCount);
+            });
         }
         else
     #endif
@@ -1289,13 +1148,24 @@ void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSpl
             
             EXCEPTION_ASSERT(lUnifiedSubscriptionInfo1.length == lUnifiedSubscriptionInfo2.length);
             
-            size_t lDataCount = lUnifiedSubscriptionInfo1.length / lDataSize;
+            size_t lDataCount = lUnifiedSubscriptionInfo1.length / pElemSize;
 
-            ReduceMemories(lShadowMem1, lShadowMem2, lDataCount, pReductionType);
+            pFunction(lShadowMem1, lShadowMem2, lDataCount);
         }
     });
 }
 
+template<typename datatype>
+void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, pmReductionOpType pReductionType)
+{
+    DEBUG_EXCEPTION_ASSERT(MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->GetVirtualMemoryPageSize() % sizeof(datatype) == 0);
+
+    ReduceSubtaskAddressSpaces(pStub1, pSubtaskId1, pSplitInfo1, pStub2, pSubtaskId2, pSplitInfo2, sizeof(datatype), [&] (void* pMem1, void* pMem2, size_t pDataCount)
+    {
+        ReduceMemories((datatype*)pMem1, (datatype*)pMem2, pDataCount, pReductionType);
+    });
+}
+
 void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, pmReductionOpType pReductionOperation, pmReductionDataType pReductionDataType)
 {
     switch(pReductionDataType)
@@ -1323,5 +1193,111 @@ void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSpl
     }
 }
 
+void pmReducer::ReduceSubtasks(pmExecutionStub* pStub1, ulong pSubtaskId1, pmSplitInfo* pSplitInfo1, pmExecutionStub* pStub2, ulong pSubtaskId2, pmSplitInfo* pSplitInfo2, const pmReductionOperation& pOperation)
+{
+    ReduceSubtaskAddressSpaces(pStub1, pSubtaskId1, pSplitInfo1, pStub2, pSubtaskId2, pSplitInfo2, pOperation.elemSize, [&] (void* pMem1, void* pMem2, size_t pDataCount)
+    {
+        ReduceMemories(pMem1, pMem2, pDataCount, pOperation);
+    });
+}
+
+void pmReducer::ReduceMemories(void* pShadowMem1, void* pShadowMem2, size_t pDataCount, const pmReductionOperation& pOperation)
+{
+    char* lMem1 = static_cast<char*>(pShadowMem1);
+    const char* lMem2 = static_cast<const char*>(pShadowMem2);
+
+#ifdef USE_OMP_FOR_REDUCTION
+    const size_t lChunkElems = std::max<size_t>(1, REDUCTION_KERNEL_CHUNK_SIZE / pOperation.elemSize);
+    const size_t lChunks = (pDataCount + lChunkElems - 1) / lChunkElems;
+
+    if(lChunks > 1)
+    {
+        #pragma omp parallel for
+        for(size_t i = 0; i < lChunks; ++i)
+        {
+            size_t lStartElem = i * lChunkElems;
+            pOperation.function(lMem1 + lStartElem * pOperation.elemSize, lMem2 + lStartElem * pOperation.elemSize, std::min(lChunkElems, pDataCount - lStartElem));
+        }
+        
+        return;
+    }
+#endif
+
+    pOperation.function(lMem1, lMem2, pDataCount);
+}
+
+/* Compressed data of user reduction operators follows the format of pmUtility::CompressForSentinel (with an all zero
+ * element as the sentinel). Such data is only sent for operators which declare zero as their identity.
+ */
+void pmReducer::ReduceMemoriesCompressed(void* pShadowMem1, const void* pCompressedMem, ulong pCompressedLength, const pmReductionOperation& pOperation)
+{
+    size_t lElemSize = pOperation.elemSize;
+    char* lMem1 = static_cast<char*>(pShadowMem1);
+
+    std::vector<const sentinelCompression::frameHeader*> lFrames;
+    pmUtility::GetSentinelCompressedFrames(pCompressedMem, pCompressedLength, lFrames);
+    
+    long lFrameCount = (long)lFrames.size();
+
+#ifdef USE_OMP_FOR_REDUCTION
+    #pragma omp parallel for
+#endif
+    for(long i = 0; i < lFrameCount; ++i)
+    {
+        pmUtility::ForEachSentinelCompressedRun(lFrames[i], lElemSize, [&] (ulong pElemIndex, const char* pData, ulong pElems)
+        {
+            pOperation.function(lMem1 + pElemIndex * lElemSize, pData, pElems);
+        });
+    }
+}
+
+const userReductionOperation* pmReducer::RegisterUserReductionOperation(const char* pKey, const pmReductionOperation& pOperation)
+{
+	FINALIZE_RESOURCE(dResourceLock, GetUserReductionOperationsLock().Lock(), GetUserReductionOperationsLock().Unlock());
+
+    uint lCount = GetUserReductionOperationCount().load();
+    userReductionOperationsArray& lOperations = GetUserReductionOperations();
+
+    std::string lKey(pKey);
+    for(uint i = 0; i < lCount; ++i)
+    {
+        if(lOperations[i].key == lKey)
+            PMTHROW(pmInvalidKeyException());
+    }
+    
+    if(lCount == MAX_USER_REDUCTION_OPERATIONS)
+        PMTHROW(pmBeyondComputationalLimitsException(pmBeyondComputationalLimitsException::MAX_USER_REDUCTION_OPERATIONS_REACHED));
+
+    userReductionOperation& lOperation = lOperations[lCount];
+    lOperation.key = lKey;
+    lOperation.operation = pOperation;
+    lOperation.slot = lCount;
+    
+    GetUserReductionOperationCount().store(lCount + 1);
+    
+    return &lOperation;
+}
+
+const userReductionOperation* pmReducer::FindUserReductionOperation(pmDataReductionCallback pCallback)
+{
+    uint lCount = GetUserReductionOperationCount().load();
+    const pmDataReductionCallback* lCallbacks = GetUserReductionCallbacks().callbacks;
+
+    for(uint i = 0; i < lCount; ++i)
+    {
+        if(lCallbacks[i] == pCallback)
+            return &GetUserReductionOperations()[i];
+    }
+    
+    return NULL;
+}
+
+pmDataReductionCallback pmReducer::GetUserReductionCallback(uint pSlot)
+{
+    EXCEPTION_ASSERT(pSlot < GetUserReductionOperationCount().load());
+
+    return GetUserReductionCallbacks().callbacks[pSlot];
+}
+
 }
 
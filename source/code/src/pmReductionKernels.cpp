@@ -0,0 +1,382 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmReductionKernels.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace pm
+{
+
+namespace reductionKernels
+{
+
+/* Bitwise operations on floating point data operate on the values converted to integers (not on their bit patterns) */
+template<typename datatype>
+struct bitwiseOperatableType
+{
+    typedef datatype type;
+};
+
+template<>
+struct bitwiseOperatableType<float>
+{
+    typedef uint type;
+};
+
+template<>
+struct bitwiseOperatableType<double>
+{
+    typedef ulong type;
+};
+
+template<typename datatype, size_t pBytes>
+struct simdTypes
+{
+    typedef datatype vector __attribute__((vector_size(pBytes)));
+    typedef typename bitwiseOperatableType<datatype>::type bitwiseVector __attribute__((vector_size(pBytes)));
+};
+
+template<pmReductionOpType pReductionType, typename datatype>
+inline __attribute__((always_inline)) datatype ApplyScalar(datatype pVal1, datatype pVal2)
+{
+    typedef typename bitwiseOperatableType<datatype>::type bitwiseType;
+
+    switch(pReductionType)
+    {
+        case REDUCE_ADD:
+            return pVal1 + pVal2;
+
+        case REDUCE_MIN:
+            return ((pVal2 < pVal1) ? pVal2 : pVal1);
+
+        case REDUCE_MAX:
+            return ((pVal1 < pVal2) ? pVal2 : pVal1);
+
+        case REDUCE_PRODUCT:
+            return pVal1 * pVal2;
+
+        case REDUCE_LOGICAL_AND:
+            return (datatype)(pVal1 && pVal2);
+
+        case REDUCE_BITWISE_AND:
+            return (datatype)((bitwiseType)pVal1 & (bitwiseType)pVal2);
+
+        case REDUCE_LOGICAL_OR:
+            return (datatype)(pVal1 || pVal2);
+
+        case REDUCE_BITWISE_OR:
+            return (datatype)((bitwiseType)pVal1 | (bitwiseType)pVal2);
+
+        case REDUCE_LOGICAL_XOR:
+            return (datatype)(pVal1 != pVal2);
+
+        case REDUCE_BITWISE_XOR:
+            return (datatype)((bitwiseType)pVal1 ^ (bitwiseType)pVal2);
+
+        default:
+            return pVal1;
+    }
+}
+
+/* Vector comparisons yield lanes of all ones (-1) or zero; negating these gives the 1/0 results of the scalar logical operators */
+template<pmReductionOpType pReductionType, typename vector, typename bitwiseVector>
+inline __attribute__((always_inline)) void ApplyVector(vector& pVal1, const vector& pVal2)
+{
+    switch(pReductionType)
+    {
+        case REDUCE_ADD:
+            pVal1 += pVal2;
+            break;
+
+        case REDUCE_MIN:
+            pVal1 = ((pVal2 < pVal1) ? pVal2 : pVal1);
+            break;
+
+        case REDUCE_MAX:
+            pVal1 = ((pVal1 < pVal2) ? pVal2 : pVal1);
+            break;
+
+        case REDUCE_PRODUCT:
+            pVal1 *= pVal2;
+            break;
+
+        case REDUCE_LOGICAL_AND:
+            pVal1 = __builtin_convertvector(-((pVal1 != 0) & (pVal2 != 0)), vector);
+            break;
+
+        case REDUCE_BITWISE_AND:
+            pVal1 = __builtin_convertvector(__builtin_convertvector(pVal1, bitwiseVector) & __builtin_convertvector(pVal2, bitwiseVector), vector);
+            break;
+
+        case REDUCE_LOGICAL_OR:
+            pVal1 = __builtin_convertvector(-((pVal1 != 0) | (pVal2 != 0)), vector);
+            break;
+
+        case REDUCE_BITWISE_OR:
+            pVal1 = __builtin_convertvector(__builtin_convertvector(pVal1, bitwiseVector) | __builtin_convertvector(pVal2, bitwiseVector), vector);
+            break;
+
+        case REDUCE_LOGICAL_XOR:
+            pVal1 = __builtin_convertvector(-(pVal1 != pVal2), vector);
+            break;
+
+        case REDUCE_BITWISE_XOR:
+            pVal1 = __builtin_convertvector(__builtin_convertvector(pVal1, bitwiseVector) ^ __builtin_convertvector(pVal2, bitwiseVector), vector);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Two vectors are processed per iteration to hide the latency of the dependent load/op/store chains. Loads and stores are
+ * unaligned as shadow memories and received buffers only guarantee the alignment of their element type.
+ */
+template<pmReductionOpType pReductionType, typename datatype, size_t pBytes>
+inline __attribute__((always_inline)) void ReduceVectorized(datatype* __restrict__ pDest, const datatype* __restrict__ pSrc, size_t pCount)
+{
+    typedef typename simdTypes<datatype, pBytes>::vector vector;
+    typedef typename simdTypes<datatype, pBytes>::bitwiseVector bitwiseVector;
+
+    const size_t lLanes = pBytes / sizeof(datatype);
+    size_t i = 0;
+
+    for(; i + 2 * lLanes <= pCount; i += 2 * lLanes)
+    {
+        vector lDest1, lDest2, lSrc1, lSrc2;
+
+        memcpy(&lDest1, pDest + i, pBytes);
+        memcpy(&lDest2, pDest + i + lLanes, pBytes);
+        memcpy(&lSrc1, pSrc + i, pBytes);
+        memcpy(&lSrc2, pSrc + i + lLanes, pBytes);
+
+        ApplyVector<pReductionType, vector, bitwiseVector>(lDest1, lSrc1);
+        ApplyVector<pReductionType, vector, bitwiseVector>(lDest2, lSrc2);
+
+        memcpy(pDest + i, &lDest1, pBytes);
+        memcpy(pDest + i + lLanes, &lDest2, pBytes);
+    }
+
+    for(; i + lLanes <= pCount; i += lLanes)
+    {
+        vector lDest, lSrc;
+
+        memcpy(&lDest, pDest + i, pBytes);
+        memcpy(&lSrc, pSrc + i, pBytes);
+
+        ApplyVector<pReductionType, vector, bitwiseVector>(lDest, lSrc);
+
+        memcpy(pDest + i, &lDest, pBytes);
+    }
+
+    for(; i < pCount; ++i)
+        pDest[i] = ApplyScalar<pReductionType>(pDest[i], pSrc[i]);
+}
+
+template<pmReductionOpType pReductionType, typename datatype>
+void ReduceGeneric(datatype* __restrict__ pDest, const datatype* __restrict__ pSrc, size_t pCount)
+{
+    for(size_t i = 0; i < pCount; ++i)
+        pDest[i] = ApplyScalar<pReductionType>(pDest[i], pSrc[i]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+template<pmReductionOpType pReductionType, typename datatype>
+__attribute__((target("sse2"))) void ReduceSse2(datatype* pDest, const datatype* pSrc, size_t pCount)
+{
+    ReduceVectorized<pReductionType, datatype, 16>(pDest, pSrc, pCount);
+}
+
+template<pmReductionOpType pReductionType, typename datatype>
+__attribute__((target("avx2"))) void ReduceAvx2(datatype* pDest, const datatype* pSrc, size_t pCount)
+{
+    ReduceVectorized<pReductionType, datatype, 32>(pDest, pSrc, pCount);
+}
+
+template<pmReductionOpType pReductionType, typename datatype>
+__attribute__((target("avx512f,avx512dq"))) void ReduceAvx512(datatype* pDest, const datatype* pSrc, size_t pCount)
+{
+    ReduceVectorized<pReductionType, datatype, 64>(pDest, pSrc, pCount);
+}
+#endif
+
+template<pmReductionOpType pReductionType, typename datatype>
+void Reduce(pmReductionKernels::instructionSet pInstructionSet, datatype* pDest, const datatype* pSrc, size_t pCount)
+{
+    switch(pInstructionSet)
+    {
+    #if defined(__x86_64__) || defined(__i386__)
+        case pmReductionKernels::AVX512_ISA:
+            ReduceAvx512<pReductionType>(pDest, pSrc, pCount);
+            break;
+
+        case pmReductionKernels::AVX2_ISA:
+            ReduceAvx2<pReductionType>(pDest, pSrc, pCount);
+            break;
+
+        case pmReductionKernels::SSE2_ISA:
+            ReduceSse2<pReductionType>(pDest, pSrc, pCount);
+            break;
+    #endif
+
+        default:
+            ReduceGeneric<pReductionType>(pDest, pSrc, pCount);
+    }
+}
+
+} // end namespace reductionKernels
+
+using namespace reductionKernels;
+
+template<typename datatype>
+void pmReductionKernels::Reduce(datatype* pDest, const datatype* pSrc, size_t pCount, pmReductionOpType pReductionType)
+{
+    instructionSet lInstructionSet = GetInstructionSet();
+
+    switch(pReductionType)
+    {
+        case REDUCE_ADD:
+            reductionKernels::Reduce<REDUCE_ADD>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_MIN:
+            reductionKernels::Reduce<REDUCE_MIN>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_MAX:
+            reductionKernels::Reduce<REDUCE_MAX>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_PRODUCT:
+            reductionKernels::Reduce<REDUCE_PRODUCT>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_LOGICAL_AND:
+            reductionKernels::Reduce<REDUCE_LOGICAL_AND>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_BITWISE_AND:
+            reductionKernels::Reduce<REDUCE_BITWISE_AND>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_LOGICAL_OR:
+            reductionKernels::Reduce<REDUCE_LOGICAL_OR>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_BITWISE_OR:
+            reductionKernels::Reduce<REDUCE_BITWISE_OR>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_LOGICAL_XOR:
+            reductionKernels::Reduce<REDUCE_LOGICAL_XOR>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        case REDUCE_BITWISE_XOR:
+            reductionKernels::Reduce<REDUCE_BITWISE_XOR>(lInstructionSet, pDest, pSrc, pCount);
+            break;
+
+        default:
+            PMTHROW(pmFatalErrorException());
+    }
+}
+
+pmReductionKernels::instructionSet pmReductionKernels::GetInstructionSet()
+{
+    static instructionSet lInstructionSet = [] ()
+    {
+        instructionSet lSupported = GetSupportedInstructionSet();
+
+        const char* lVal = getenv("PMLIB_REDUCTION_ISA");
+        if(lVal && *lVal)
+        {
+            for(int i = GENERIC_ISA; i < MAX_INSTRUCTION_SETS; ++i)
+            {
+                if(!strcmp(lVal, GetInstructionSetName((instructionSet)i)))
+                    return std::min(lSupported, (instructionSet)i);
+            }
+        }
+        
+        return lSupported;
+    }();
+    
+    return lInstructionSet;
+}
+
+const char* pmReductionKernels::GetInstructionSetName(instructionSet pInstructionSet)
+{
+    switch(pInstructionSet)
+    {
+        case SSE2_ISA:
+            return "sse2";
+
+        case AVX2_ISA:
+            return "avx2";
+
+        case AVX512_ISA:
+            return "avx512";
+
+        default:
+            return "generic";
+    }
+}
+
+pmReductionKernels::instructionSet pmReductionKernels::GetSupportedInstructionSet()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+        return AVX512_ISA;
+
+    if(__builtin_cpu_supports("avx2"))
+        return AVX2_ISA;
+
+    if(__builtin_cpu_supports("sse2"))
+        return SSE2_ISA;
+#endif
+
+    return GENERIC_ISA;
+}
+
+template void pmReductionKernels::Reduce<int>(int*, const int*, size_t, pmReductionOpType);
+template void pmReductionKernels::Reduce<uint>(uint*, const uint*, size_t, pmReductionOpType);
+template void pmReductionKernels::Reduce<long>(long*, const long*, size_t, pmReductionOpType);
+template void pmReductionKernels::Reduce<ulong>(ulong*, const ulong*, size_t, pmReductionOpType);
+template void pmReductionKernels::Reduce<float>(float*, const float*, size_t, pmReductionOpType);
+template void pmReductionKernels::Reduce<double>(double*, const double*, size_t, pmReductionOpType);
+
+} // end namespace pm
+
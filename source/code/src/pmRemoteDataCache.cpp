@@ -0,0 +1,234 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmRemoteDataCache.h"
+
+#include <string.h>
+
+namespace pm
+{
+
+using namespace communicator;
+
+/* struct pmRemoteDataCacheEvictor */
+// Called with the cache's resource lock acquired
+void pmRemoteDataCacheEvictor::operator() (const std::shared_ptr<pmRemoteDataCacheValue>& pValue)
+{
+    mCache->RecordRemoval(*pValue.get());
+}
+
+
+/* class pmRemoteDataCache */
+pmRemoteDataCache* pmRemoteDataCache::GetRemoteDataCache()
+{
+    static pmRemoteDataCache lRemoteDataCache;
+    return &lRemoteDataCache;
+}
+
+pmRemoteDataCache::pmRemoteDataCache()
+    : mCapacity(REMOTE_DATA_CACHE_SIZE)
+    , mOccupancy(0)
+    , mCache(pmRemoteDataCacheEvictor(this))
+    , mResourceLock __LOCK_NAME__("pmRemoteDataCache::mResourceLock")
+{
+    const char* lVal = getenv("PMLIB_REMOTE_DATA_CACHE_SIZE");
+    if(lVal && *lVal)
+        mCapacity = (size_t)atol(lVal) * 1024 * 1024;
+}
+
+pmRemoteDataCache::~pmRemoteDataCache()
+{
+}
+
+bool pmRemoteDataCache::IsEnabled() const
+{
+    return (mCapacity != 0);
+}
+
+std::pair<uint, ulong> pmRemoteDataCache::GetIndexKey(const memoryIdentifierStruct& pMemIdentifier)
+{
+    return std::make_pair(pMemIdentifier.memOwnerHost, pMemIdentifier.generationNumber);
+}
+
+/* Any cached data overlapping the new region is stale or duplicate and is replaced. Regions larger than the cache are not cached. */
+void pmRemoteDataCache::Insert(const memoryIdentifierStruct& pMemIdentifier, const void* pData, ulong pOffset, ulong pLength)
+{
+    if(!pLength || pLength > mCapacity)
+        return;
+
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    InvalidateInternal(pMemIdentifier, pOffset, pLength);
+
+    while(mOccupancy + pLength > mCapacity && mCache.Purge())
+        ++mStatistics.evictions;
+
+    if(mOccupancy + pLength > mCapacity)
+        return;
+
+    pmRemoteDataCacheKey lKey(pMemIdentifier, pOffset);
+    std::shared_ptr<pmRemoteDataCacheValue> lValue(new pmRemoteDataCacheValue(lKey, pData, pLength));
+
+    mCache.Insert(lKey, lValue);
+
+    mIndex[GetIndexKey(pMemIdentifier)][pOffset] = pLength;
+    mOccupancy += pLength;
+}
+
+/* Copies the cached parts of the range [pOffset, pOffset + pLength) into the address space. The ranges copied and the ones
+ * still to be fetched (as offset, length pairs) are appended to pServedRanges and pMissedRanges respectively.
+ */
+void pmRemoteDataCache::Serve(const memoryIdentifierStruct& pMemIdentifier, void* pAddressSpaceBaseAddr, ulong pOffset, ulong pLength, std::vector<std::pair<ulong, ulong>>& pServedRanges, std::vector<std::pair<ulong, ulong>>& pMissedRanges)
+{
+    size_t lServedCount = pServedRanges.size();
+    size_t lMissedCount = pMissedRanges.size();
+
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    ulong lCurrentOffset = pOffset;
+    ulong lEndOffset = pOffset + pLength;
+
+    indexType::iterator lIndexIter = mIndex.find(GetIndexKey(pMemIdentifier));
+    if(lIndexIter != mIndex.end())
+    {
+        std::map<ulong, ulong>& lRegions = lIndexIter->second;
+        
+        auto lIter = lRegions.upper_bound(pOffset), lEndIter = lRegions.end();
+        if(lIter != lRegions.begin())
+            --lIter;
+
+        for(; lIter != lEndIter && lIter->first < lEndOffset; ++lIter)
+        {
+            ulong lRegionEndOffset = lIter->first + lIter->second;
+
+            if(lRegionEndOffset <= lCurrentOffset)
+                continue;
+            
+            if(lIter->first > lCurrentOffset)
+            {
+                pMissedRanges.emplace_back(lCurrentOffset, lIter->first - lCurrentOffset);
+                lCurrentOffset = lIter->first;
+            }
+            
+            ulong lCopyEndOffset = std::min(lRegionEndOffset, lEndOffset);
+
+            std::shared_ptr<pmRemoteDataCacheValue> lValue = mCache.Get(pmRemoteDataCacheKey(pMemIdentifier, lIter->first));
+            EXCEPTION_ASSERT(lValue.get());
+
+            PMLIB_MEMCPY((char*)pAddressSpaceBaseAddr + lCurrentOffset, &lValue->data[lCurrentOffset - lIter->first], lCopyEndOffset - lCurrentOffset, std::string("pmRemoteDataCache::Serve"));
+
+            pServedRanges.emplace_back(lCurrentOffset, lCopyEndOffset - lCurrentOffset);
+            lCurrentOffset = lCopyEndOffset;
+        }
+    }
+    
+    if(lCurrentOffset < lEndOffset)
+        pMissedRanges.emplace_back(lCurrentOffset, lEndOffset - lCurrentOffset);
+
+    for(size_t i = lServedCount; i < pServedRanges.size(); ++i)
+    {
+        ++mStatistics.hits;
+        mStatistics.hitBytes += pServedRanges[i].second;
+    }
+
+    for(size_t i = lMissedCount; i < pMissedRanges.size(); ++i)
+    {
+        ++mStatistics.misses;
+        mStatistics.missBytes += pMissedRanges[i].second;
+    }
+}
+
+void pmRemoteDataCache::Invalidate(const memoryIdentifierStruct& pMemIdentifier)
+{
+    Invalidate(pMemIdentifier, 0, std::numeric_limits<ulong>::max());
+}
+
+void pmRemoteDataCache::Invalidate(const memoryIdentifierStruct& pMemIdentifier, ulong pOffset, ulong pLength)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    mStatistics.invalidations += InvalidateInternal(pMemIdentifier, pOffset, pLength);
+}
+
+// Must be called with mResourceLock acquired; returns the number of entries removed
+ulong pmRemoteDataCache::InvalidateInternal(const memoryIdentifierStruct& pMemIdentifier, ulong pOffset, ulong pLength)
+{
+    indexType::iterator lIndexIter = mIndex.find(GetIndexKey(pMemIdentifier));
+    if(lIndexIter == mIndex.end() || !pLength)
+        return 0;
+
+    std::map<ulong, ulong>& lRegions = lIndexIter->second;
+    ulong lEndOffset = (pLength > std::numeric_limits<ulong>::max() - pOffset) ? std::numeric_limits<ulong>::max() : (pOffset + pLength);
+
+    auto lIter = lRegions.upper_bound(pOffset), lEndIter = lRegions.end();
+    if(lIter != lRegions.begin())
+        --lIter;
+
+    std::vector<ulong> lOverlappingOffsets;
+    for(; lIter != lEndIter && lIter->first < lEndOffset; ++lIter)
+    {
+        if(lIter->first + lIter->second > pOffset)
+            lOverlappingOffsets.push_back(lIter->first);
+    }
+
+    // Removal of the keys updates mIndex (see RecordRemoval)
+    for_each(lOverlappingOffsets, [&] (ulong pRegionOffset)
+    {
+        mCache.RemoveKey(pmRemoteDataCacheKey(pMemIdentifier, pRegionOffset));
+    });
+    
+    return (ulong)lOverlappingOffsets.size();
+}
+
+// Called (through the evictor) with mResourceLock acquired, whenever an entry leaves the cache
+void pmRemoteDataCache::RecordRemoval(const pmRemoteDataCacheValue& pValue)
+{
+    indexType::iterator lIndexIter = mIndex.find(GetIndexKey(pValue.key.memIdentifier));
+    EXCEPTION_ASSERT(lIndexIter != mIndex.end());
+    
+    lIndexIter->second.erase(pValue.key.offset);
+
+    if(lIndexIter->second.empty())
+        mIndex.erase(lIndexIter);
+
+    mOccupancy -= pValue.data.size();
+}
+
+pmRemoteDataCacheStatistics pmRemoteDataCache::GetStatistics()
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    return mStatistics;
+}
+
+} // end namespace pm
@@ -230,7 +230,7 @@ void pmSafePQ<T, P>::WaitForCurrentItem()
 }
 
 template<typename T, typename P>
-void pmSafePQ<T, P>::DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion)
+void pmSafePQ<T, P>::DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey /* = NULL */)
 {
     while(1)
     {
@@ -272,7 +272,7 @@ void pmSafePQ<T, P>::DeleteMatchingItems(P pPriority, matchFuncPtr pMatchFunc, c
 }
 
 template<typename T, typename P>
-bool pmSafePQ<T, P>::HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion)
+bool pmSafePQ<T, P>::HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey /* = NULL */)
 {
     while(1)
     {
@@ -308,7 +308,7 @@ bool pmSafePQ<T, P>::HasMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const
 }
 
 template<typename T, typename P>
-pmStatus pmSafePQ<T, P>::DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pItem, bool pTemporarilyUnblockSecondaryOperations)
+pmStatus pmSafePQ<T, P>::DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pItem, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey /* = NULL */)
 {
     while(1)
     {
@@ -358,7 +358,7 @@ pmStatus pmSafePQ<T, P>::DeleteAndGetFirstMatchingItem(P pPriority, matchFuncPtr
 }
 
 template<typename T, typename P>
-void pmSafePQ<T, P>::DeleteAndGetAllMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pItems, bool pTemporarilyUnblockSecondaryOperations)
+void pmSafePQ<T, P>::DeleteAndGetAllMatchingItems(P pPriority, matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pItems, bool pTemporarilyUnblockSecondaryOperations, const void* pIndexKey /* = NULL */)
 {
     while(1)
     {
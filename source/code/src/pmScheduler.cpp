@@ -50,6 +50,7 @@
 #include "pmHeavyOperations.h"
 #include "pmUtility.h"
 #include "pmPreprocessorTask.h"
+#include "pmTracer.h"
 
 #ifdef USE_STEAL_AGENT_PER_NODE
     #include "pmStealAgent.h"
@@ -350,7 +351,7 @@ void pmScheduler::StealRequestEvent(const pmProcessingElement* pStealingDevice,
 	SwitchThread(std::shared_ptr<schedulerEvent>(new stealRequestEvent(STEAL_REQUEST_STEALER, pStealingDevice, pTask, pExecutionRate)), pTask->GetPriority());
 }
 
-void pmScheduler::StealProcessEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, bool pShouldMultiAssign)
+void pmScheduler::StealProcessEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign)
 {
     if(!pmTaskManager::GetTaskManager()->DoesTaskHavePendingSubtasks(pTask))
         return;
@@ -359,7 +360,7 @@ void pmScheduler::StealProcessEvent(const pmProcessingElement* pStealingDevice,
     pTask->GetTaskProfiler()->RecordProfileEvent(taskProfiler::SUBTASK_STEAL_SERVE, true);
 #endif
     
-	SwitchThread(std::shared_ptr<schedulerEvent>(new stealProcessEvent(STEAL_PROCESS_TARGET, pStealingDevice, pTargetDevice, pTask, pExecutionRate, pShouldMultiAssign)), pTask->GetPriority());
+	SwitchThread(std::shared_ptr<schedulerEvent>(new stealProcessEvent(STEAL_PROCESS_TARGET, pStealingDevice, pTargetDevice, pTask, pExecutionRate, pStealRoundTripTime, pShouldMultiAssign)), pTask->GetPriority());
 }
 
 void pmScheduler::StealSuccessEvent(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange)
@@ -478,6 +479,11 @@ void pmScheduler::NoReductionRequiredEvent(pmTask* pTask, const pmMachine* pDest
     SwitchThread(std::shared_ptr<schedulerEvent>(new noReductionRequiredEvent(NO_REDUCTION_REQD, pTask, pDestMachine)), pTask->GetPriority());
 }
 
+void pmScheduler::ReductionParticipationEvent(pmTask* pTask, std::vector<const pmMachine*>&& pDestMachines, communicator::subtaskMemoryReduceMessageType pMessageType)
+{
+    SwitchThread(std::shared_ptr<schedulerEvent>(new reductionParticipationEvent(REDUCTION_PARTICIPATION, pTask, std::move(pDestMachines), pMessageType)), pTask->GetPriority());
+}
+
 void pmScheduler::CommandCompletionEvent(const pmCommandPtr& pCommand)
 {
 	SwitchThread(std::shared_ptr<schedulerEvent>(new commandCompletionEvent(COMMAND_COMPLETION, pCommand)), pCommand->GetPriority());
@@ -611,7 +617,7 @@ void pmScheduler::ProcessEvent(schedulerEvent& pEvent)
             stealProcessEvent& lEventDetails = static_cast<stealProcessEvent&>(pEvent);
 
             if(pmTaskManager::GetTaskManager()->DoesTaskHavePendingSubtasks(lEventDetails.task))
-                ServeStealRequest(lEventDetails.stealingDevice, lEventDetails.targetDevice, lEventDetails.task, lEventDetails.stealingDeviceExecutionRate, lEventDetails.shouldMultiAssign);
+                ServeStealRequest(lEventDetails.stealingDevice, lEventDetails.targetDevice, lEventDetails.task, lEventDetails.stealingDeviceExecutionRate, lEventDetails.stealRoundTripTime, lEventDetails.shouldMultiAssign);
             
             break;
         }
@@ -823,6 +829,24 @@ void pmScheduler::ProcessEvent(schedulerEvent& pEvent)
             
             pmCommunicator::GetCommunicator()->Send(lCommand, false);
             
+            break;
+        }
+
+        case REDUCTION_PARTICIPATION:
+        {
+            reductionParticipationEvent& lEventDetails = static_cast<reductionParticipationEvent&>(pEvent);
+            
+            for_each(lEventDetails.machines, [&] (const pmMachine* pMachine)
+            {
+                EXCEPTION_ASSERT(pMachine != PM_LOCAL_MACHINE);
+
+                finalize_ptr<subtaskMemoryReduceStruct> lData(new subtaskMemoryReduceStruct(*lEventDetails.task->GetOriginatingHost(), lEventDetails.task->GetSequenceNumber(), std::numeric_limits<ulong>::max(), 0, 0, 0, *PM_LOCAL_MACHINE, false, 0, 0, lEventDetails.messageType));
+                
+                pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<subtaskMemoryReduceStruct>::CreateSharedPtr(lEventDetails.task->GetPriority(), SEND, SUBTASK_MEMORY_REDUCE_TAG, pMachine, SUBTASK_MEMORY_REDUCE_STRUCT, lData, 1);
+                
+                pmCommunicator::GetCommunicator()->Send(lCommand, false);
+            });
+            
             break;
         }
 
@@ -1345,7 +1369,7 @@ pmStatus pmScheduler::StartLocalTaskExecution(pmLocalTask* pLocalTask)
      must also be sent in task definition */
 	AssignTaskToMachines(pLocalTask, lMachines);
 
-    if(pLocalTask->GetSchedulingModel() == scheduler::PULL_WITH_AFFINITY && pLocalTask->GetCallbackUnit()->GetDataDistributionCB() && !pLocalTask->HasReadOnlyLazyAddressSpace())
+    if(pLocalTask->GetSchedulingModel() == scheduler::PULL_WITH_AFFINITY && pLocalTask->GetCallbackUnit()->GetDataDistributionCB() && !pLocalTask->HasReadOnlyLazyAddressSpace() && !pLocalTask->HasInheritedAffinity())
         pmPreprocessorTask::GetPreprocessorTask()->DeduceAffinity(pLocalTask, pLocalTask->GetAffinityCriterion());
     else
         pLocalTask->StartScheduling();
@@ -1391,21 +1415,48 @@ const pmProcessingElement* pmScheduler::RandomlySelectStealTarget(const pmProces
     // consecutive lTargets/2 requests or if this device is too agressive like GPUs
     pShouldMultiAssign = ((lConsecutiveFailures >= lTargets/2) || (pStealingDevice->GetType() != CPU));
 
-	lTaskExecStats.RecordStealAttempt(lStub);
-
 #ifdef ENABLE_TWO_LEVEL_STEALING
 #ifdef USE_STEAL_AGENT_PER_NODE
     // Keep a higher bias towards local node if there is anything stealable. In this case, the remote node gets skipped.
     // In 25% cases, a local steal is attempted before a remote steal.
-    
-    srand((uint)time(NULL));
-
-    if((rand() % 4) == 0 && pTask->GetStealAgent()->HasAnotherStubToStealFrom(pStealingDevice->GetLocalExecutionStub(), pShouldMultiAssign))
+    if(pmBase::GetRandomInt(4) == 0 && pTask->GetStealAgent()->HasAnotherStubToStealFrom(pStealingDevice->GetLocalExecutionStub(), pShouldMultiAssign))
+    {
+        lTaskExecStats.RecordStealAttempt(lStub, PM_LOCAL_MACHINE);
         return PM_LOCAL_MACHINE;
+    }
 #endif
 #endif
 
-    return lStealList[lAttempts % lTargets];
+    // Targets never attempted are tried first, in the (randomized) order of the steal list. Thereafter, a target is picked
+    // with probability proportional to the subtasks it is expected to yield per sec of steal latency.
+    const pmTaskExecStats::stealTarget* lTarget = NULL;
+
+    std::vector<double> lCumulativeWeights;
+    lCumulativeWeights.reserve(lTargets);
+
+    double lTotalWeight = 0;
+    for(const auto& lStealTarget: lStealList)
+    {
+        double lWeight = lTaskExecStats.GetStealTargetWeight(lStub, lStealTarget);
+        if(lWeight < 0)
+        {
+            lTarget = lStealTarget;
+            break;
+        }
+
+        lTotalWeight += lWeight;
+        lCumulativeWeights.emplace_back(lTotalWeight);
+    }
+
+    if(!lTarget)
+    {
+        size_t lIndex = std::upper_bound(lCumulativeWeights.begin(), lCumulativeWeights.end(), pmBase::GetRandomDouble(lTotalWeight)) - lCumulativeWeights.begin();
+        lTarget = lStealList[std::min(lIndex, lTargets - 1)];
+    }
+
+	lTaskExecStats.RecordStealAttempt(lStub, lTarget);
+
+    return lTarget;
 }
 
 void pmScheduler::StealSubtasks(const pmProcessingElement* pStealingDevice, pmTask* pTask, double pExecutionRate)
@@ -1418,16 +1469,19 @@ void pmScheduler::StealSubtasks(const pmProcessingElement* pStealingDevice, pmTa
     if(lTargetMachine)
     {
         STEAL_REQUEST_DUMP((uint)(*(pStealingDevice->GetMachine())), (uint)(*lTargetMachine), pStealingDevice->GetGlobalDeviceIndex(), std::numeric_limits<uint>::max(), pExecutionRate);
+        pmTracer::RecordInstant(tracer::STEAL_REQUEST, pTask, (uint)(*lTargetMachine));
 
 		if(lTargetMachine == PM_LOCAL_MACHINE)
 		{
-            StealProcessEvent(pStealingDevice, NULL, pTask, pExecutionRate, lShouldMultiAssign);
+            StealProcessEvent(pStealingDevice, NULL, pTask, pExecutionRate, pTask->GetTaskExecStats().GetMeanStealRoundTripTime(pStealingDevice->GetLocalExecutionStub(), lTargetMachine), lShouldMultiAssign);
 		}
 		else
 		{
 			const pmMachine* lOriginatingHost = pTask->GetOriginatingHost();
 
-			finalize_ptr<stealRequestStruct> lStealRequestData(new stealRequestStruct(pStealingDevice->GetGlobalDeviceIndex(), *lOriginatingHost, pTask->GetSequenceNumber(), pExecutionRate, lShouldMultiAssign));
+            double lStealRoundTripTime = pTask->GetTaskExecStats().GetMeanStealRoundTripTime(pStealingDevice->GetLocalExecutionStub(), lTargetMachine);
+
+			finalize_ptr<stealRequestStruct> lStealRequestData(new stealRequestStruct(pStealingDevice->GetGlobalDeviceIndex(), *lOriginatingHost, pTask->GetSequenceNumber(), pExecutionRate, lStealRoundTripTime, lShouldMultiAssign));
 
 			pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<stealRequestStruct>::CreateSharedPtr(pTask->GetPriority(), SEND, STEAL_REQUEST_TAG, lTargetMachine, STEAL_REQUEST_STRUCT, lStealRequestData, 1);
 
@@ -1442,6 +1496,7 @@ void pmScheduler::StealSubtasks(const pmProcessingElement* pStealingDevice, pmTa
 	if(lTargetDevice)
 	{
         STEAL_REQUEST_DUMP((uint)(*(pStealingDevice->GetMachine())), (uint)(*(lTargetDevice->GetMachine())), pStealingDevice->GetGlobalDeviceIndex(), lTargetDevice->GetGlobalDeviceIndex(), pExecutionRate);
+        pmTracer::RecordInstant(tracer::STEAL_REQUEST, pTask, (uint)(*(lTargetDevice->GetMachine())));
     
 		const pmMachine* lTargetMachine = lTargetDevice->GetMachine();
 
@@ -1450,13 +1505,15 @@ void pmScheduler::StealSubtasks(const pmProcessingElement* pStealingDevice, pmTa
             if(lTargetDevice == pStealingDevice)
                 StealFailedReturnEvent(pStealingDevice, lTargetDevice, pTask);
             else
-                StealProcessEvent(pStealingDevice, lTargetDevice, pTask, pExecutionRate, lShouldMultiAssign);
+                StealProcessEvent(pStealingDevice, lTargetDevice, pTask, pExecutionRate, pTask->GetTaskExecStats().GetMeanStealRoundTripTime(pStealingDevice->GetLocalExecutionStub(), lTargetDevice), lShouldMultiAssign);
 		}
 		else
 		{
 			const pmMachine* lOriginatingHost = pTask->GetOriginatingHost();
 
-			finalize_ptr<stealRequestStruct> lStealRequestData(new stealRequestStruct(pStealingDevice->GetGlobalDeviceIndex(), lTargetDevice->GetGlobalDeviceIndex(), *lOriginatingHost, pTask->GetSequenceNumber(), pExecutionRate, lShouldMultiAssign));
+            double lStealRoundTripTime = pTask->GetTaskExecStats().GetMeanStealRoundTripTime(pStealingDevice->GetLocalExecutionStub(), lTargetDevice);
+
+			finalize_ptr<stealRequestStruct> lStealRequestData(new stealRequestStruct(pStealingDevice->GetGlobalDeviceIndex(), lTargetDevice->GetGlobalDeviceIndex(), *lOriginatingHost, pTask->GetSequenceNumber(), pExecutionRate, lStealRoundTripTime, lShouldMultiAssign));
 
 			pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<stealRequestStruct>::CreateSharedPtr(pTask->GetPriority(), SEND, STEAL_REQUEST_TAG, lTargetMachine, STEAL_REQUEST_STRUCT, lStealRequestData, 1);
 
@@ -1466,7 +1523,7 @@ void pmScheduler::StealSubtasks(const pmProcessingElement* pStealingDevice, pmTa
 #endif
 }
 
-void pmScheduler::ServeStealRequest(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, bool pShouldMultiAssign)
+void pmScheduler::ServeStealRequest(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask, double pExecutionRate, double pStealRoundTripTime, bool pShouldMultiAssign)
 {
 #ifdef ENABLE_TWO_LEVEL_STEALING
     EXCEPTION_ASSERT(!pTargetDevice);
@@ -1475,12 +1532,13 @@ void pmScheduler::ServeStealRequest(const pmProcessingElement* pStealingDevice,
 #endif
 
     if(pTargetDevice)
-        pTargetDevice->GetLocalExecutionStub()->StealSubtasks(pTask, pStealingDevice, pExecutionRate, pShouldMultiAssign);
+        pTargetDevice->GetLocalExecutionStub()->StealSubtasks(pTask, pStealingDevice, pExecutionRate, pStealRoundTripTime, pShouldMultiAssign);
 }
 
 void pmScheduler::SendStealResponse(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange)
 {
     STEAL_RESPONSE_DUMP((uint)(*(pStealingDevice->GetMachine())), (uint)(*(pTargetDevice->GetMachine())), pStealingDevice->GetGlobalDeviceIndex(), pTargetDevice->GetGlobalDeviceIndex(), pRange.task->GetTaskExecStats().GetStubExecutionRate(pmStubManager::GetStubManager()->GetStub(pTargetDevice)), pRange.endSubtask - pRange.startSubtask + 1);
+    pmTracer::RecordInstant(tracer::STEAL_SUCCESS_RESPONSE, pRange.task, pRange.endSubtask - pRange.startSubtask + 1);
 
 	const pmMachine* lMachine = pStealingDevice->GetMachine();
 	if(lMachine == PM_LOCAL_MACHINE)
@@ -1531,7 +1589,7 @@ void pmScheduler::SendStealResponse(pmTask* pTask, const pmProcessingElement* pS
 void pmScheduler::ReceiveStealResponse(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, const pmSubtaskRange& pRange)
 {
 	pmTaskExecStats& lTaskExecStats = pRange.task->GetTaskExecStats();
-	lTaskExecStats.RecordSuccessfulStealAttempt(pmStubManager::GetStubManager()->GetStub(pStealingDevice));
+	lTaskExecStats.RecordSuccessfulStealAttempt(pmStubManager::GetStubManager()->GetStub(pStealingDevice), pRange.endSubtask - pRange.startSubtask + 1);
 
 	PushEvent(pStealingDevice, pRange, true);
 }
@@ -1539,8 +1597,14 @@ void pmScheduler::ReceiveStealResponse(const pmProcessingElement* pStealingDevic
 #ifdef USE_AFFINITY_IN_STEAL
 void pmScheduler::ReceiveStealResponse(pmTask* pTask, const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, std::vector<ulong>&& pDiscontiguousStealData)
 {
+    EXCEPTION_ASSERT(pDiscontiguousStealData.size() % 2 == 0);
+
+    ulong lStolenSubtasks = 0;
+    for(size_t i = 0, lCount = pDiscontiguousStealData.size(); i < lCount; i += 2)
+        lStolenSubtasks += pDiscontiguousStealData[i + 1] - pDiscontiguousStealData[i] + 1;
+
 	pmTaskExecStats& lTaskExecStats = pTask->GetTaskExecStats();
-	lTaskExecStats.RecordSuccessfulStealAttempt(pmStubManager::GetStubManager()->GetStub(pStealingDevice));
+	lTaskExecStats.RecordSuccessfulStealAttempt(pmStubManager::GetStubManager()->GetStub(pStealingDevice), lStolenSubtasks);
     
     PushEvent(pTask, pStealingDevice, std::move(pDiscontiguousStealData));
 }
@@ -1549,6 +1613,7 @@ void pmScheduler::ReceiveStealResponse(pmTask* pTask, const pmProcessingElement*
 void pmScheduler::SendFailedStealResponse(const pmProcessingElement* pStealingDevice, const pmProcessingElement* pTargetDevice, pmTask* pTask)
 {
     STEAL_RESPONSE_DUMP((uint)(*(pStealingDevice->GetMachine())), (uint)(*(pTargetDevice->GetMachine())), pStealingDevice->GetGlobalDeviceIndex(), pTargetDevice->GetGlobalDeviceIndex(), pTask->GetTaskExecStats().GetStubExecutionRate(pmStubManager::GetStubManager()->GetStub(pTargetDevice)), 0);
+    pmTracer::RecordInstant(tracer::STEAL_FAILURE_RESPONSE, pTask, (uint)(*(pStealingDevice->GetMachine())));
 
 	const pmMachine* lMachine = pStealingDevice->GetMachine();
 	if(lMachine == PM_LOCAL_MACHINE)
@@ -1750,9 +1815,7 @@ const pmProcessingElement* pmScheduler::RandomlySelectSecondLevelStealTarget(con
         return NULL;
     }
 
-    std::srand((unsigned int)time(NULL));
-
-    return lLocalDevices[std::rand() % lLocalDevices.size()];
+    return lLocalDevices[pmBase::GetRandomInt((uint)lLocalDevices.size())];
 #endif
 }
 #endif
@@ -1760,7 +1823,7 @@ const pmProcessingElement* pmScheduler::RandomlySelectSecondLevelStealTarget(con
 void pmScheduler::ClearPendingTaskCommands(pmTask* pTask)
 {
     pmHeavyOperationsThreadPool::GetHeavyOperationsThreadPool()->CancelTaskSpecificMemoryTransferEvents(pTask);
-    DeleteMatchingCommands(pTask->GetPriority(), taskClearMatchFunc, pTask);
+    DeleteMatchingCommands(pTask->GetPriority(), taskClearMatchFunc, pTask, pTask);
 }
     
 void pmScheduler::WaitForAllCommandsToFinish()
@@ -2045,7 +2108,7 @@ void pmScheduler::HandleCommandCompletion(const pmCommandPtr& pCommand)
                     if(pmTaskManager::GetTaskManager()->DoesTaskHavePendingSubtasks(lOriginatingHost, lData->sequenceNumber))
                     {
                         pmTask* lTask = pmTaskManager::GetTaskManager()->FindTask(lOriginatingHost, lData->sequenceNumber);
-                        StealProcessEvent(lStealingDevice, lTargetDevice, lTask, lData->stealingDeviceExecutionRate, (bool)lData->shouldMultiAssign);
+                        StealProcessEvent(lStealingDevice, lTargetDevice, lTask, lData->stealingDeviceExecutionRate, lData->stealRoundTripTime, (bool)lData->shouldMultiAssign);
                     }
                     
 					break;
@@ -2256,6 +2319,49 @@ void pmScheduler::HandleCommandCompletion(const pmCommandPtr& pCommand)
 	}
 }
     
+/* struct schedulerEvent */
+// Every event that taskClearMatchFunc can match must be indexed by its task
+const void* scheduler::schedulerEvent::GetIndexKey() const
+{
+    switch(eventId)
+    {
+        case SUBTASK_EXECUTION:
+            return static_cast<const subtaskExecEvent*>(this)->range.task;
+
+        case STEAL_REQUEST_STEALER:
+            return static_cast<const stealRequestEvent*>(this)->task;
+
+        case STEAL_PROCESS_TARGET:
+            return static_cast<const stealProcessEvent*>(this)->task;
+
+        case STEAL_SUCCESS_TARGET:
+            return static_cast<const stealSuccessTargetEvent*>(this)->range.task;
+
+        case STEAL_FAIL_TARGET:
+            return static_cast<const stealFailTargetEvent*>(this)->task;
+
+        case STEAL_SUCCESS_STEALER:
+            return static_cast<const stealSuccessStealerEvent*>(this)->range.task;
+
+        case STEAL_FAIL_STEALER:
+            return static_cast<const stealFailStealerEvent*>(this)->task;
+
+        case SUBTASK_RANGE_CANCEL:
+            return static_cast<const subtaskRangeCancelEvent*>(this)->range.task;
+
+        case RANGE_NEGOTIATION_EVENT:
+            return static_cast<const rangeNegotiationEvent*>(this)->range.task;
+
+        case RANGE_NEGOTIATION_SUCCESS_EVENT:
+            return static_cast<const rangeNegotiationSuccessEvent*>(this)->negotiatedRange.task;
+
+        default:
+            return NULL;
+    }
+
+    return NULL;
+}
+
 bool taskClearMatchFunc(const schedulerEvent& pEvent, const void* pCriterion)
 {
     switch(pEvent.eventId)
@@ -0,0 +1,103 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmSlabAllocator.h"
+
+#include <cstddef>
+
+namespace pm
+{
+
+pmSlab::pmSlab(size_t pObjectsPerChunk)
+    : mObjectsPerChunk(pObjectsPerChunk)
+    , mObjectSize(0)
+    , mSlotSize(0)
+    , mNextObject(NULL)
+    , mObjectsLeftInChunk(0)
+{
+    if(!mObjectsPerChunk)
+        PMTHROW(pmFatalErrorException());
+}
+
+pmSlab::~pmSlab()
+{
+    for_each(mChunks, [] (void* pChunk)
+    {
+        pmBase::DeallocateMemory(pChunk);
+    });
+}
+
+void* pmSlab::Allocate(size_t pSize)
+{
+    if(!mObjectSize)
+    {
+        mObjectSize = pSize;
+        mSlotSize = ((pSize + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)) * sizeof(std::max_align_t);   // Keeps every object in the chunk aligned
+    }
+    else if(pSize != mObjectSize)
+    {
+        return pmBase::AllocateMemory(pSize);
+    }
+
+    if(!mFreeList.empty())
+    {
+        void* lMem = mFreeList.back();
+        mFreeList.pop_back();
+
+        return lMem;
+    }
+
+    if(!mObjectsLeftInChunk)
+    {
+        mNextObject = static_cast<char*>(pmBase::AllocateMemory(mObjectsPerChunk * mSlotSize));
+        mChunks.push_back(mNextObject);
+        mObjectsLeftInChunk = mObjectsPerChunk;
+    }
+
+    void* lMem = mNextObject;
+
+    mNextObject += mSlotSize;
+    --mObjectsLeftInChunk;
+
+    return lMem;
+}
+
+void pmSlab::Deallocate(void* pMem, size_t pSize)
+{
+    if(pSize != mObjectSize)
+        pmBase::DeallocateMemory(pMem);
+    else
+        mFreeList.push_back(pMem);
+}
+
+}
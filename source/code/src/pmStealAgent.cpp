@@ -55,6 +55,17 @@ pmStealAgent::pmStealAgent(pmTask* pTask)
 #endif
 {
     DEBUG_EXCEPTION_ASSERT(pmScheduler::SchedulingModelSupportsStealing(mTask->GetSchedulingModel()));
+
+    pmStubManager* lStubManager = pmStubManager::GetStubManager();
+
+    if(lStubManager->GetCpuNumaDomainsCount() > 1)
+    {
+        size_t lCpuStubs = lStubManager->GetProcessingElementsCPU();
+
+        mStubNumaDomains.resize(lStubManager->GetStubCount(), std::numeric_limits<ushort>::max());
+        for(size_t i = 0; i < lCpuStubs; ++i)
+            mStubNumaDomains[i] = lStubManager->GetNumaDomainIdForCpuDevice((uint)i);
+    }
 }
 
 void pmStealAgent::RegisterPendingSubtasks(pmExecutionStub* pStub, ulong pPendingSubtasks)
@@ -115,28 +126,72 @@ void pmStealAgent::SetStubMultiAssignment(pmExecutionStub* pStub, bool pCanMulti
 }
 
 // This method operates without lock, so may work with stale data. But that is fine here.
+// Stealable subtasks of a victim are scaled by the ratio of the mean execution rate of the stubs
+// to its own (if known), so that the victim with the most remaining work in time is picked.
+// For local CPU stealers on machines with multiple NUMA domains, CPU victims in other domains
+// have their stealable subtasks discounted by CROSS_NUMA_DOMAIN_STEAL_PENALTY.
 pmExecutionStub* pmStealAgent::GetStubWithMaxStealLikelihood(bool pConsiderMultiAssign, pmExecutionStub* pIgnoreStub /* = NULL */)
 {
     size_t lIgnoreStubIndex = pIgnoreStub ? pIgnoreStub->GetProcessingElement()->GetDeviceIndexInMachine() : 0;
+    ushort lStealerDomain = ((pIgnoreStub && !mStubNumaDomains.empty()) ? mStubNumaDomains[lIgnoreStubIndex] : std::numeric_limits<ushort>::max());
+
+    pmStubManager* lStubManager = pmStubManager::GetStubManager();
+    pmTaskExecStats& lTaskExecStats = mTask->GetTaskExecStats();
 
-    std::map<ulong, size_t> lSubtasksMap;   // subtasks versus stub
-    for_each_with_index(mStubSink, [&] (stubData& pData, size_t pStubIndex)
+    std::vector<double> lStubRates(mStubSink.size(), 0);
+    double lRateSum = 0;
+    size_t lRatedStubs = 0;
+
+    for_each_with_index(lStubRates, [&] (double& pRate, size_t pStubIndex)
     {
-        if(pData.subtasksPendingInStubQueue && (!pIgnoreStub || lIgnoreStubIndex != pStubIndex))
-            lSubtasksMap.emplace(pData.subtasksPendingInStubQueue, pStubIndex);
+        pRate = lTaskExecStats.GetStubExecutionRate(lStubManager->GetStub((uint)pStubIndex));
+        
+        if(pRate > 0)
+        {
+            lRateSum += pRate;
+            ++lRatedStubs;
+        }
     });
-
-    if(!lSubtasksMap.empty())
-        return pmStubManager::GetStubManager()->GetStub((uint)lSubtasksMap.rbegin()->second);
     
-    for_each_with_index(mStubSink, [&] (stubData& pData, size_t pStubIndex)
+    double lMeanRate = (lRatedStubs ? (lRateSum / lRatedStubs) : 0);
+
+    auto lFindVictim = [&] (bool pPipelinedSubtasks) -> pmExecutionStub*
     {
-        if(pData.subtasksPendingInPipeline && (!pIgnoreStub || lIgnoreStubIndex != pStubIndex))
-            lSubtasksMap.emplace(pData.subtasksPendingInPipeline, pStubIndex);
-    });
+        double lMaxSubtasks = 0;
+        size_t lVictimIndex = 0;
+
+        for_each_with_index(mStubSink, [&] (stubData& pData, size_t pStubIndex)
+        {
+            ulong lSubtasks = (pPipelinedSubtasks ? pData.subtasksPendingInPipeline : pData.subtasksPendingInStubQueue);
+
+            if(lSubtasks && (!pIgnoreStub || lIgnoreStubIndex != pStubIndex))
+            {
+                double lEffectiveSubtasks = (double)lSubtasks;
+                
+                if(lStubRates[pStubIndex] > 0)
+                    lEffectiveSubtasks *= (lMeanRate / lStubRates[pStubIndex]);
+
+                if(lStealerDomain != std::numeric_limits<ushort>::max() && mStubNumaDomains[pStubIndex] != std::numeric_limits<ushort>::max() && mStubNumaDomains[pStubIndex] != lStealerDomain)
+                    lEffectiveSubtasks /= CROSS_NUMA_DOMAIN_STEAL_PENALTY;
+                
+                if(lEffectiveSubtasks > lMaxSubtasks)
+                {
+                    lMaxSubtasks = lEffectiveSubtasks;
+                    lVictimIndex = pStubIndex;
+                }
+            }
+        });
+        
+        return ((lMaxSubtasks > 0) ? pmStubManager::GetStubManager()->GetStub((uint)lVictimIndex) : NULL);
+    };
 
-    if(!lSubtasksMap.empty())
-        return pmStubManager::GetStubManager()->GetStub((uint)lSubtasksMap.rbegin()->second);
+    pmExecutionStub* lVictim = lFindVictim(false);
+    if(lVictim)
+        return lVictim;
+    
+    lVictim = lFindVictim(true);
+    if(lVictim)
+        return lVictim;
 
     if(pConsiderMultiAssign)
     {
@@ -159,10 +214,10 @@ pmExecutionStub* pmStealAgent::GetStubWithMaxStealLikelihood(bool pConsiderMulti
         });
 
         if(!lPreferredMultiAssigningStubs.empty())
-            return pmStubManager::GetStubManager()->GetStub((uint)lPreferredMultiAssigningStubs[rand() % lPreferredMultiAssigningStubs.size()]);
+            return pmStubManager::GetStubManager()->GetStub((uint)lPreferredMultiAssigningStubs[GetRandomInt((uint)lPreferredMultiAssigningStubs.size())]);
 
         if(!lMultiAssigningStubs.empty())
-            return pmStubManager::GetStubManager()->GetStub((uint)lMultiAssigningStubs[rand() % lMultiAssigningStubs.size()]);
+            return pmStubManager::GetStubManager()->GetStub((uint)lMultiAssigningStubs[GetRandomInt((uint)lMultiAssigningStubs.size())]);
     }
         
     return NULL;
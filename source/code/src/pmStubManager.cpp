@@ -41,6 +41,13 @@
 #include <string>
 #endif
 
+#ifdef LINUX
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <sched.h>
+#endif
+
 #include SYSTEM_CONFIGURATION_HEADER	// For sysconf function
 
 namespace pm
@@ -55,10 +62,7 @@ pmStubManager* pmStubManager::GetStubManager()
 pmStubManager::pmStubManager()
 {
 	CreateExecutionStubs();
-    
-#ifdef SUPPORT_SPLIT_SUBTASKS
     CreateCpuNumaDomains();
-#endif
 }
 
 pmStubManager::~pmStubManager()
@@ -195,8 +199,10 @@ void pmStubManager::CreateExecutionStubs()
     size_t lPhysicalMemory = sysconf(_SC_PHYS_PAGES) * ::getpagesize();
 #endif
     
+    DetectCpuTopology();
+
 	for(size_t i = 0; i < mProcessingElementsCPU; ++i)
-		mStubVector.push_back(new pmStubCPU(i, (uint)(mStubVector.size())));
+		mStubVector.push_back(new pmStubCPU(mCpuCoreIds[i], (uint)(mStubVector.size())));
 
 	mProcessingElementsGPU = pmDispatcherGPU::GetDispatcherGPU()->ProbeProcessingElementsAndCreateStubs(mStubVector);
 
@@ -210,14 +216,142 @@ void pmStubManager::CreateExecutionStubs()
     }
 }
 
+#ifdef LINUX
+/* Parses sysfs cpu lists of the form "0-3,8,10-11" */
+static void ParseSysfsCpuList(const std::string& pCpuList, std::vector<uint>& pCpus)
+{
+    std::stringstream lStream(pCpuList);
+    std::string lRange;
+
+    while(std::getline(lStream, lRange, ','))
+    {
+        if(lRange.empty() || !isdigit(lRange[0]))
+            continue;
+
+        size_t lDashPos = lRange.find('-');
+        uint lFirst = (uint)atoi(lRange.c_str());
+        uint lLast = ((lDashPos == std::string::npos) ? lFirst : (uint)atoi(lRange.c_str() + lDashPos + 1));
+
+        for(uint i = lFirst; i <= lLast; ++i)
+            pCpus.push_back(i);
+    }
+}
+
+static bool ReadSysfsCpuList(const std::string& pFile, std::vector<uint>& pCpus)
+{
+    std::ifstream lStream(pFile.c_str());
+    std::string lCpuList;
+
+    if(!lStream.good() || !std::getline(lStream, lCpuList))
+        return false;
+    
+    ParseSysfsCpuList(lCpuList, pCpus);
+
+    return true;
+}
+#endif
+
+/* Determines the core each CPU stub runs on and the NUMA node of that core. Cores the process is allowed to run on
+ are picked one hyperthread per physical core first (as CPU stubs are created per physical core). Without sysfs (or on
+ other platforms), stub i is given core i and all stubs are placed in NUMA node 0. */
+void pmStubManager::DetectCpuTopology()
+{
+    mCpuCoreIds.clear();
+    mCpuNumaNodes.clear();
+
+#ifdef LINUX
+    std::vector<uint> lAllowedCpus;
+
+    cpu_set_t lAffinitySet;
+    CPU_ZERO(&lAffinitySet);
+
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &lAffinitySet) == 0)
+    {
+        for(uint i = 0; i < CPU_SETSIZE; ++i)
+        {
+            if(CPU_ISSET(i, &lAffinitySet))
+                lAllowedCpus.push_back(i);
+        }
+    }
+
+    std::vector<uint> lPrimaryCpus, lSecondaryCpus;
+    for_each(lAllowedCpus, [&] (uint pCpu)
+    {
+        std::stringstream lFile;
+        lFile << "/sys/devices/system/cpu/cpu" << pCpu << "/topology/thread_siblings_list";
+
+        std::vector<uint> lSiblings;
+        ReadSysfsCpuList(lFile.str(), lSiblings);
+
+        auto lFirstAllowedSibling = std::find_if(lSiblings.begin(), lSiblings.end(), [&] (uint pSibling) {return CPU_ISSET(pSibling, &lAffinitySet);});
+        
+        if(lFirstAllowedSibling == lSiblings.end() || *lFirstAllowedSibling == pCpu)
+            lPrimaryCpus.push_back(pCpu);
+        else
+            lSecondaryCpus.push_back(pCpu);
+    });
+    
+    std::map<uint, uint> lCpuNodeMap;  // cpu versus NUMA node
+    DIR* lDir = opendir("/sys/devices/system/node");
+    if(lDir)
+    {
+        struct dirent* lEntry = NULL;
+        while((lEntry = readdir(lDir)) != NULL)
+        {
+            if(strncmp(lEntry->d_name, "node", 4) || !isdigit(lEntry->d_name[4]))
+                continue;
+
+            uint lNode = (uint)atoi(lEntry->d_name + 4);
+
+            std::vector<uint> lNodeCpus;
+            ReadSysfsCpuList(std::string("/sys/devices/system/node/") + lEntry->d_name + "/cpulist", lNodeCpus);
+            
+            for_each(lNodeCpus, [&] (uint pCpu)
+            {
+                lCpuNodeMap[pCpu] = lNode;
+            });
+        }
+
+        closedir(lDir);
+    }
+
+    lPrimaryCpus.insert(lPrimaryCpus.end(), lSecondaryCpus.begin(), lSecondaryCpus.end());
+
+    for(size_t i = 0; i < mProcessingElementsCPU && i < lPrimaryCpus.size(); ++i)
+    {
+        auto lIter = lCpuNodeMap.find(lPrimaryCpus[i]);
+
+        mCpuCoreIds.push_back(lPrimaryCpus[i]);
+        mCpuNumaNodes.push_back((lIter == lCpuNodeMap.end()) ? 0 : lIter->second);
+    }
+#endif
+
+    for(size_t i = mCpuCoreIds.size(); i < mProcessingElementsCPU; ++i)
+    {
+        mCpuCoreIds.push_back(i);
+        mCpuNumaNodes.push_back(0);
+    }
+}
+
+/* One domain is created per NUMA node hosting at least one CPU stub. Domain ids are contiguous and follow node order. */
 void pmStubManager::CreateCpuNumaDomains()
 {
-    // Put all CPU devices in the same NUMA domain for now
-    mCpuNumaDomains.emplace_back(mStubVector.begin(), mStubVector.begin() + mProcessingElementsCPU);
+    std::map<uint, std::vector<pmExecutionStub*>> lNodeStubsMap;    // NUMA node versus CPU stubs
     
-    std::for_each(mStubVector.begin(), mStubVector.begin() + mProcessingElementsCPU, [&] (pmExecutionStub* pStub)
+    for(size_t i = 0; i < mProcessingElementsCPU; ++i)
+        lNodeStubsMap[mCpuNumaNodes[i]].push_back(mStubVector[i]);
+
+    for_each(lNodeStubsMap, [&] (std::pair<const uint, std::vector<pmExecutionStub*>>& pPair)
     {
-        mCpuNumaDomainsMap.emplace(pStub, 0);
+        ushort lDomainId = (ushort)mCpuNumaDomains.size();
+
+        for_each(pPair.second, [&] (pmExecutionStub* pStub)
+        {
+            mCpuNumaDomainsMap.emplace(pStub, lDomainId);
+        });
+        
+        mCpuNumaDomains.emplace_back(std::move(pPair.second));
+        mCpuNumaDomainNodes.push_back(pPair.first);
     });
 }
 
@@ -243,6 +377,13 @@ ushort pmStubManager::GetNumaDomainIdForCpuDevice(uint pIndex) const
     return mCpuNumaDomainsMap.find(GetCpuStub(pIndex))->second;
 }
 
+uint pmStubManager::GetNumaNodeForCpuNumaDomain(ushort pDomainId) const
+{
+    DEBUG_EXCEPTION_ASSERT(pDomainId < mCpuNumaDomainNodes.size());
+
+    return mCpuNumaDomainNodes[(size_t)pDomainId];
+}
+
 #ifdef SUPPORT_CUDA
 void pmStubManager::FreeGpuResources()
 {
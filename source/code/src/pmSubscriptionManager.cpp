@@ -546,8 +546,22 @@ void pmSubscriptionManager::InsertScatteredSubscriptionsToSubtaskMapsInternal(su
         return true;
     };
     
+    auto lRecordCountLambda = [] (const std::vector<pmScatteredSubscriptionInfo>& pVector) -> size_t
+    {
+        size_t lCount = 0;
+        
+        for_each(pVector, [&] (const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo)
+        {
+            lCount += pScatteredSubscriptionInfo.count;
+        });
+        
+        return lCount;
+    };
+
     auto lExhaustiveLambda = [&] (subscriptionRecordType& pMap, const std::vector<pmScatteredSubscriptionInfo>& pVector)
     {
+        pMap.reserve(pMap.size() + lRecordCountLambda(pVector));   // Upper bound; overlapping records coalesce
+
         for_each(pVector, [&] (const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo)
         {
             for(size_t i = 0; i < pScatteredSubscriptionInfo.count; ++i)
@@ -591,6 +605,10 @@ void pmSubscriptionManager::InsertScatteredSubscriptionsToSubtaskMapsInternal(su
         bg::model::box<bg::model::point<ulong, 2, bg::cs::cartesian>> lBox(bg::model::point<ulong, 2, bg::cs::cartesian>(0, 0), bg::model::point<ulong, 2, bg::cs::cartesian>(std::numeric_limits<ulong>::max(), std::numeric_limits<ulong>::max()));
         lRtree.query(bgi::intersects(lBox), std::back_inserter(lResolvedSubscriptions));
 
+        // The rtree yields boxes in no particular order; gather all records and insert them into the map in one sorted batch
+        std::vector<subscriptionRecordType::value_type> lRecords;
+        lRecords.reserve(lRecordCountLambda(pVector));
+
         unsigned long lStep = pVector.begin()->step;
         for_each(lResolvedSubscriptions, [&] (const bg::model::box<bg::model::point<unsigned long, 2, bg::cs::cartesian>>& pBox)
         {
@@ -600,8 +618,11 @@ void pmSubscriptionManager::InsertScatteredSubscriptionsToSubtaskMapsInternal(su
             pmScatteredSubscriptionInfo lScatteredSubscription(lPoint1.get<1>() * lStep + lPoint1.get<0>(), lPoint2.get<0>() - lPoint1.get<0>() + 1, lStep, lPoint2.get<1>() - lPoint1.get<1>() + 1);
             
             for(size_t i = 0; i < lScatteredSubscription.count; ++i)
-                pMap[lScatteredSubscription.offset + i * lScatteredSubscription.step].first = lScatteredSubscription.size;
+                lRecords.emplace_back(lScatteredSubscription.offset + i * lScatteredSubscription.step, std::make_pair(lScatteredSubscription.size, subscriptionData()));
         });
+
+        DEBUG_EXCEPTION_ASSERT(pMap.empty());
+        pMap.insert(lRecords.begin(), lRecords.end());
     };
     
     multi_for_each(mTask->GetAddressSpaces(), pSubtask.mAddressSpacesData, [&] (pmAddressSpace* pAddressSpace, pmSubtaskAddressSpaceData& pAddressSpaceData)
@@ -1528,7 +1549,7 @@ void pmSubscriptionManager::InitializeSubtaskShadowMemNaturalView(pmExecutionStu
             }
         }
     }
-    else if(!lIsLazyMem && pStub->GetType() == CPU)     // no need to copy for GPU; it will be copied to GPU memory directly and after kernel executes results will be put inside shadow memory
+    else if(!lIsLazyMem && pStub->GetType() == CPU && !mTask->IsWriteOnly(lAddressSpace))     // no need to copy for GPU; it will be copied to GPU memory directly and after kernel executes results will be put inside shadow memory
     {
         subscription::subscriptionRecordType::const_iterator lBeginIter, lEndIter;
         GetNonConsolidatedReadSubscriptions(pStub, pSubtaskId, pSplitInfo, pMemIndex, lBeginIter, lEndIter);
@@ -1617,7 +1638,7 @@ void pmSubscriptionManager::InitializeSubtaskShadowMemCompactView(pmExecutionStu
             }
         }
     }
-    else if(!lIsLazyMem && pStub->GetType() == CPU)     // no need to copy for GPU; it will be copied to GPU memory directly and after kernel executes results will be put inside shadow memory
+    else if(!lIsLazyMem && pStub->GetType() == CPU && !mTask->IsWriteOnly(lAddressSpace))     // no need to copy for GPU; it will be copied to GPU memory directly and after kernel executes results will be put inside shadow memory
     {
         subscription::subscriptionRecordType::const_iterator lIter, lBeginIter, lEndIter;
         GetNonConsolidatedReadSubscriptions(pStub, pSubtaskId, pSplitInfo, pMemIndex, lBeginIter, lEndIter);
@@ -1724,8 +1745,20 @@ void pmSubscriptionManager::CommitSubtaskShadowMem(pmExecutionStub* pStub, ulong
     {
         const pmSubscriptionInfo& lUnifiedSubscriptionInfo = GetUnifiedReadWriteSubscriptionInternal(pStub, lSubtask, pMemIndex);
         
+    #ifdef SUPPORT_SHADOW_MEM_REMAP
+        // Shadow memory is page aligned; so its pages line up with those of the address space only if the subscription is page aligned too
+        bool lSwappable = ((lUnifiedSubscriptionInfo.offset % MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->GetVirtualMemoryPageSize()) == 0);
+    #endif
+
         for(lIter = lBeginIter; lIter != lEndIter; ++lIter)
+        {
+        #ifdef SUPPORT_SHADOW_MEM_REMAP
+            if(lSwappable && SwapShadowMemPagesIntoAddressSpace(lAddressSpace, lShadowMem + (lIter->first - lUnifiedSubscriptionInfo.offset), lIter->first, lIter->second.first))
+                continue;
+        #endif
+
             PMLIB_MEMCPY(lMem + lIter->first, lShadowMem + (lIter->first - lUnifiedSubscriptionInfo.offset), lIter->second.first, std::string("pmSubscriptionManager::CommitSubtaskShadowMem1"));
+        }
     }
     else    // SUBSCRIPTION_COMPACT
     {
@@ -1741,6 +1774,33 @@ void pmSubscriptionManager::CommitSubtaskShadowMem(pmExecutionStub* pStub, ulong
     DestroySubtaskShadowMemInternal(lSubtask, pStub, pSubtaskId, pSplitInfo, pMemIndex);
 }
     
+#ifdef SUPPORT_SHADOW_MEM_REMAP
+/* Swaps the whole pages of a committed write subscription into the address space and copies the partial pages at its ends.
+ * The shadow memory's pages are taken over by the address space; the shadow memory is not read again before being overwritten or released. */
+bool pmSubscriptionManager::SwapShadowMemPagesIntoAddressSpace(pmAddressSpace* pAddressSpace, char* pShadowMem, size_t pOffset, size_t pLength)
+{
+    size_t lPageSize = MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->GetVirtualMemoryPageSize();
+    size_t lFirstPageOffset = ((pOffset + lPageSize - 1) / lPageSize) * lPageSize;
+    size_t lLastPageOffset = ((pOffset + pLength) / lPageSize) * lPageSize;
+
+    if(lLastPageOffset <= lFirstPageOffset || lLastPageOffset - lFirstPageOffset < MIN_REMAPPED_SHADOW_MEM_LENGTH)
+        return false;
+
+    if(!MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->SwapPagesIntoAddressSpace(pAddressSpace, lFirstPageOffset, pShadowMem + (lFirstPageOffset - pOffset), lLastPageOffset - lFirstPageOffset))
+        return false;
+
+    char* lMem = static_cast<char*>(pAddressSpace->GetMem());
+
+    if(lFirstPageOffset != pOffset)
+        PMLIB_MEMCPY(lMem + pOffset, pShadowMem, lFirstPageOffset - pOffset, std::string("pmSubscriptionManager::SwapShadowMemPagesIntoAddressSpace1"));
+
+    if(lLastPageOffset != pOffset + pLength)
+        PMLIB_MEMCPY(lMem + lLastPageOffset, pShadowMem + (lLastPageOffset - pOffset), pOffset + pLength - lLastPageOffset, std::string("pmSubscriptionManager::SwapShadowMemPagesIntoAddressSpace2"));
+
+    return true;
+}
+#endif
+
 #ifdef SUPPORT_LAZY_MEMORY
 pmAddressSpace* pmSubscriptionManager::FindAddressSpaceContainingShadowAddr(void* pAddr, size_t& pShadowMemOffset, void*& pShadowMemBaseAddr, pmTask*& pTask)
 {
@@ -1799,6 +1859,9 @@ void pmSubscriptionManager::FetchSubtaskSubscriptions(pmExecutionStub* pStub, ul
 
     multi_for_each(mTask->GetAddressSpaces(), lSubtask.mAddressSpacesData, [&] (pmAddressSpace* pAddressSpace, pmSubtaskAddressSpaceData& pAddressSpaceData)
     {
+        if(pDeviceType == CPU)
+            PlaceAndAdviseSubscriptions(pStub, pAddressSpace, pAddressSpaceData);
+
         if(!mTask->IsLazy(pAddressSpace) || pDeviceType != CPU)
         {
         #if 0
@@ -1832,8 +1895,13 @@ void pmSubscriptionManager::FetchSubtaskSubscriptions(pmExecutionStub* pStub, ul
 
     if(!pPrefetch)
     {
+        double lStallStartTime = (lCommandVector.empty() ? 0 : pmBase::GetCurrentTimeInSecs());
+
         WaitForSubscriptions(lSubtask, pStub, pDeviceType, lCommandVector);
 
+        if(!lCommandVector.empty())
+            mTask->GetTaskExecStats().RecordSubscriptionStall(pStub, pmBase::GetCurrentTimeInSecs() - lStallStartTime);
+
     #ifdef ENABLE_DYNAMIC_AGGRESSION
         if(pmScheduler::SchedulingModelSupportsStealing(mTask->GetSchedulingModel()))
             mTask->GetStealAgent()->RecordSubtaskSubscriptionFetchTime(pStub, pmBase::GetCurrentTimeInSecs() - lFetchStartTime);
@@ -1841,6 +1909,59 @@ void pmSubscriptionManager::FetchSubtaskSubscriptions(pmExecutionStub* pStub, ul
     }
 }
     
+/* Must be called with mSubtaskMapVector stub's lock acquired. Must precede the fetch of subscriptions, as placement only affects untouched pages */
+void pmSubscriptionManager::PlaceAndAdviseSubscriptions(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, const pmSubtaskAddressSpaceData& pAddressSpaceData)
+{
+    const pmMemAllocationPolicy& lAllocationPolicy = pAddressSpace->GetAllocationPolicy();
+
+    if(lAllocationPolicy.placement != PLACEMENT_FIRST_TOUCH && !lAllocationPolicy.adviseAccessPattern)
+        return;
+
+    pmMemoryManager* lMemoryManager = MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager();
+
+    if(lAllocationPolicy.placement == PLACEMENT_FIRST_TOUCH)
+    {
+        // Overlapping and adjacent subscriptions are placed together
+        std::vector<std::pair<ulong, ulong>> lRanges;   // offset versus end offset
+        lRanges.reserve(pAddressSpaceData.mReadSubscriptionInfoVector.size() + pAddressSpaceData.mWriteSubscriptionInfoVector.size());
+
+        auto lAddRange = [&] (const pmSubscriptionInfo& pSubscriptionInfo)
+        {
+            if(pSubscriptionInfo.length)
+                lRanges.emplace_back(pSubscriptionInfo.offset, pSubscriptionInfo.offset + pSubscriptionInfo.length);
+        };
+
+        for_each(pAddressSpaceData.mReadSubscriptionInfoVector, lAddRange);
+        for_each(pAddressSpaceData.mWriteSubscriptionInfoVector, lAddRange);
+        
+        std::sort(lRanges.begin(), lRanges.end());
+
+        for(size_t i = 0, lCount = lRanges.size(); i < lCount; )
+        {
+            ulong lStart = lRanges[i].first, lEnd = lRanges[i].second;
+
+            for(++i; i < lCount && lRanges[i].first <= lEnd; ++i)
+                lEnd = std::max(lEnd, lRanges[i].second);
+
+            lMemoryManager->PlaceMemoryRegion(pAddressSpace, lStart, lEnd - lStart, pStub);
+        }
+    }
+
+    if(lAllocationPolicy.adviseAccessPattern)
+    {
+        for_each(pAddressSpaceData.mReadSubscriptionInfoVector, [&] (const pmSubscriptionInfo& pSubscriptionInfo)
+        {
+            lMemoryManager->AdviseMemoryRegion(pAddressSpace, pSubscriptionInfo.offset, pSubscriptionInfo.length, true);
+        });
+
+        for_each(pAddressSpaceData.mScatteredReadSubscriptionInfoVector, [&] (const pmScatteredSubscriptionInfo& pScatteredSubscriptionInfo)
+        {
+            if(pScatteredSubscriptionInfo.count)
+                lMemoryManager->AdviseMemoryRegion(pAddressSpace, pScatteredSubscriptionInfo.offset, (pScatteredSubscriptionInfo.count - 1) * pScatteredSubscriptionInfo.step + pScatteredSubscriptionInfo.size, false);
+        });
+    }
+}
+
 /* Must be called with mSubtaskMapVector stub's lock acquired */
 void pmSubscriptionManager::WaitForSubscriptions(pmSubtask& pSubtask, pmExecutionStub* pStub, pmDeviceType pDeviceType, const std::vector<pmCommandPtr>& pCommandVector)
 {
@@ -2315,12 +2436,23 @@ void shadowMemDeallocator::operator()(void* pMem)
     if(pMem)
     {
     #ifdef SUPPORT_LAZY_MEMORY
+        size_t lLazyLength = 0;
+
         // Auto lock/unlock scope
         {
             FINALIZE_RESOURCE(dShadowMemLock, pmSubscriptionManager::GetShadowMemLock().Lock(), pmSubscriptionManager::GetShadowMemLock().Unlock());
 
-            pmSubscriptionManager::GetShadowMemMap().erase(pMem);
+            auto lIter = pmSubscriptionManager::GetShadowMemMap().find(pMem);
+            if(lIter != pmSubscriptionManager::GetShadowMemMap().end())
+            {
+                lLazyLength = lIter->second.subscriptionInfo.length;
+                pmSubscriptionManager::GetShadowMemMap().erase(lIter);
+            }
         }
+
+        // Pages never touched (e.g. of a prefetched subtask that got stolen) are still protected and must not reach the allocator so
+        if(lLazyLength)
+            MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->SetLazyProtection(pMem, lLazyLength, true, true);
     #endif
 
         if(mExplicitAllocation)
@@ -145,6 +145,12 @@ void pmSubtaskManager::UpdateExecutionProfile(const pmProcessingElement* pDevice
     mOrderedDevices.erase(pDevice);
     mOrderedDevices.insert(pDevice);    
 }
+
+// This method must only be called after the task has finished
+void pmSubtaskManager::SaveSchedulingHistory(pmSchedulingHistory& pSchedulingHistory)
+{
+    pSchedulingHistory.deviceExecutionProfile = mDeviceExecutionProfile;
+}
     
 #ifdef DUMP_SUBTASK_EXECUTION_PROFILE
 void pmSubtaskManager::PrintExecutionProfile()
@@ -250,6 +256,11 @@ pmPushSchedulingManager::pmPushSchedulingManager(pmLocalTask* pLocalTask)
             EXCEPTION_ASSERT(lIter != lEndIter);
         }
     }
+
+    // A relaunched persistent task resumes slow start from the allocation sizes reached by its previous launch
+    const pmSchedulingHistory* lSchedulingHistory = mLocalTask->GetSchedulingHistory();
+    if(lSchedulingHistory)
+        RestoreSchedulingHistory(*lSchedulingHistory);
 }
 
 pmPushSchedulingManager::~pmPushSchedulingManager()
@@ -458,6 +469,36 @@ pmSubtaskManager::pmUnfinishedPartitionPtr pmPushSchedulingManager::FetchNewSubP
     return lNewPartitionPtr;
 }
 
+void pmPushSchedulingManager::SaveSchedulingHistory(pmSchedulingHistory& pSchedulingHistory)
+{
+	FINALIZE_RESOURCE_PTR(dResource, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    pmSubtaskManager::SaveSchedulingHistory(pSchedulingHistory);
+
+    for_each(mAllottedUnassignedPartition, [&] (const decltype(mAllottedUnassignedPartition)::value_type& pPair)
+    {
+        const std::pair<double, ulong>& lExecTimeStats = mExecTimeStats[pPair.first];
+
+        if(pPair.second.second)
+            pSchedulingHistory.slowStartAllocations.emplace(pPair.first->GetGlobalDeviceIndex(), std::make_pair(pPair.second.second, lExecTimeStats));
+    });
+}
+
+// Must be called from the constructor after all devices are allotted their partitions
+void pmPushSchedulingManager::RestoreSchedulingHistory(const pmSchedulingHistory& pSchedulingHistory)
+{
+    for_each(mAllottedUnassignedPartition, [&] (decltype(mAllottedUnassignedPartition)::value_type& pPair)
+    {
+        auto lIter = pSchedulingHistory.slowStartAllocations.find(pPair.first->GetGlobalDeviceIndex());
+
+        if(lIter != pSchedulingHistory.slowStartAllocations.end())
+        {
+            pPair.second.second = lIter->second.first;
+            mExecTimeStats[pPair.first] = lIter->second.second;
+        }
+    });
+}
+
 void pmPushSchedulingManager::FreezeAllocationSize(const pmProcessingElement* pDevice, ulong pFreezedSize)
 {
 	mExecTimeStats[pDevice].second = pFreezedSize;
@@ -898,6 +939,16 @@ pmPullSchedulingManager::pmPullSchedulingManager(pmLocalTask* pLocalTask, uint p
         std::move(pPair.second.begin(), pPair.second.end(), std::back_inserter(lReorderedDevices));
     });
 
+    // A relaunched persistent task allots subtasks in proportion to what each device executed in the previous launch
+    const pmSchedulingHistory* lSchedulingHistory = mLocalTask->GetSchedulingHistory();
+    if(lSchedulingHistory && mLocalTask->GetSchedulingModel() == scheduler::PULL && !pMaxPercentVariationFromFixedAllotment)
+    {
+    #ifdef SUPPORT_SPLIT_SUBTASKS
+        if(!mUseSplits)
+    #endif
+            ResizeAllotmentsFromHistory(lSubtaskPartitions, lReorderedDevices, lSchedulingHistory->deviceExecutionProfile);
+    }
+
 #ifdef SUPPORT_SPLIT_SUBTASKS
     if(mUseSplits)
     {
@@ -1011,6 +1062,56 @@ void pmPullSchedulingManager::VaryFixedAllotments(std::vector<pmUnfinishedPartit
     (*(pVector.rbegin()))->lastSubtaskIndex = lSubtaskCount - 1;
 }
     
+/* Rebuilds the partitions (one per device of pDevices, in that order) in proportion to the subtasks executed by the devices earlier.
+ * Every partition retains atleast one subtask. Nothing is changed if none of the devices has any history.
+ */
+void pmPullSchedulingManager::ResizeAllotmentsFromHistory(std::vector<pmUnfinishedPartitionPtr>& pVector, const std::vector<const pmProcessingElement*>& pDevices, const std::map<uint, ulong>& pDeviceExecutionProfile)
+{
+    ulong lSubtaskCount = mLocalTask->GetSubtaskCount();
+    ulong lPartitionCount = pVector.size();
+
+    EXCEPTION_ASSERT(pDevices.size() == lPartitionCount && lSubtaskCount >= lPartitionCount);
+
+    std::vector<ulong> lWeights;
+    lWeights.reserve(lPartitionCount);
+
+    ulong lTotalWeight = 0;
+    for_each(pDevices, [&] (const pmProcessingElement* pDevice)
+    {
+        auto lIter = pDeviceExecutionProfile.find(pDevice->GetGlobalDeviceIndex());
+        lWeights.push_back((lIter == pDeviceExecutionProfile.end()) ? 0 : lIter->second);
+        lTotalWeight += lWeights.back();
+    });
+
+    if(!lTotalWeight)
+        return;
+
+    ulong lDistributableSubtasks = lSubtaskCount - lPartitionCount;
+    ulong lDistributedSubtasks = 0;
+
+    std::vector<ulong> lCounts(lPartitionCount, 1);
+    for(ulong i = 0; i < lPartitionCount; ++i)
+    {
+        ulong lShare = std::min<ulong>((ulong)((double)lDistributableSubtasks * lWeights[i] / lTotalWeight), lDistributableSubtasks - lDistributedSubtasks);
+
+        lCounts[i] += lShare;
+        lDistributedSubtasks += lShare;
+    }
+
+    // Subtasks lost in rounding are handed out one each from the front, as is done for leftover subtasks of equal partitions
+    for(ulong i = 0; lDistributedSubtasks < lDistributableSubtasks; i = (i + 1) % lPartitionCount, ++lDistributedSubtasks)
+        ++lCounts[i];
+
+    ulong lFirstSubtask = 0;
+    for(ulong i = 0; i < lPartitionCount; ++i)
+    {
+        pVector[i].reset(new pmSubtaskManager::pmUnfinishedPartition(lFirstSubtask, lFirstSubtask + lCounts[i] - 1));
+        lFirstSubtask += lCounts[i];
+    }
+
+    EXCEPTION_ASSERT(lFirstSubtask == lSubtaskCount);
+}
+
 std::map<uint, std::pair<ulong, ulong>> pmPullSchedulingManager::ComputeMachineVersusInitialSubtaskCountMap(std::vector<ulong>& pLogicalSubtaskIds)
 {
     pLogicalSubtaskIds.reserve(mLocalTask->GetSubtaskCount());
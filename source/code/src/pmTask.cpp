@@ -51,6 +51,7 @@
 #include "pmUtility.h"
 #include "pmAffinityTable.h"
 #include "pmPreprocessorTask.h"
+#include "pmPersistentTask.h"
 
 #ifdef USE_STEAL_AGENT_PER_NODE
 #include "pmStealAgent.h"
@@ -65,6 +66,7 @@ namespace pm
 
 STATIC_ACCESSOR_INIT(ulong, pmLocalTask, GetSequenceId, 0)
 STATIC_ACCESSOR_ARG(RESOURCE_LOCK_IMPLEMENTATION_CLASS, __STATIC_LOCK_NAME__("pmLocalTask::mSequenceLock"), pmLocalTask, GetSequenceLock)
+STATIC_ACCESSOR_ARG(RESOURCE_LOCK_IMPLEMENTATION_CLASS, __STATIC_LOCK_NAME__("pmTask::mAddressSpacesLockingLock"), pmTask, GetAddressSpacesLockingLock)
     
 #define SAFE_GET_DEVICE_POOL(x) { x = pmDevicePool::GetDevicePool(); if(!x) PMTHROW(pmFatalErrorException()); }
 
@@ -74,6 +76,14 @@ void AddressSpacesLockCallback(const pmCommandPtr& pCountDownCommand)
     
     lTask->PrepareForStart();
 }
+
+void PrerequisiteTasksCompletionCallback(const pmCommandPtr& pAccumulatorCommand)
+{
+    pmLocalTask* lLocalTask = const_cast<pmLocalTask*>(static_cast<const pmLocalTask*>(pAccumulatorCommand->GetUserIdentifier()));
+
+    pmTaskManager::GetTaskManager()->SubmitTask(lLocalTask);
+    lLocalTask->LockAddressSpaces();
+}
     
 /* class pmTask */
 pmTask::pmTask(void* pTaskConf, uint pTaskConfLength, ulong pTaskId, std::vector<pmTaskMemory>&& pTaskMemVector, ulong pSubtaskCount, const pmCallbackUnit* pCallbackUnit, uint pAssignedDeviceCount, const pmMachine* pOriginatingHost, const pmCluster* pCluster, ushort pPriority, scheduler::schedulingModel pSchedulingModel, ushort pTaskFlags, pmAffinityCriterion pAffinityCriterion)
@@ -128,10 +138,16 @@ pmTask::pmTask(void* pTaskConf, uint pTaskConfLength, ulong pTaskId, std::vector
 
     mAddressSpaces.reserve(mTaskMemVector.size());
 
-    for_each_with_index(mTaskMemVector, [this] (const pmTaskMemory& pTaskMem, size_t pMemIndex)
+    for_each_with_index(mTaskMemVector, [this] (pmTaskMemory& pTaskMem, size_t pMemIndex)
     {
         pmAddressSpace* lAddressSpace = pTaskMem.addressSpace;
 
+    #ifdef SUPPORT_LAZY_MEMORY
+        // Address spaces can not be mapped lazily when lazy memory is disabled at runtime; such address spaces are accessed eagerly
+        if(pmUtility::IsLazy(pTaskMem.memType) && !MEMORY_MANAGER_IMPLEMENTATION_CLASS::GetMemoryManager()->SupportsLazyAccess(lAddressSpace))
+            pTaskMem.memType = pmUtility::GetEagerMemType(pTaskMem.memType);
+    #endif
+
         mAddressSpaces.push_back(lAddressSpace);
         mAddressSpaceTaskMemIndexMap[lAddressSpace] = pMemIndex;
 
@@ -184,6 +200,11 @@ void pmTask::LockAddressSpaces()
         pmCommandPtr lCountDownCommand = pmCountDownCommand::CreateSharedPtr(mTaskMemVector.size(), GetPriority(), 0, AddressSpacesLockCallback, this);
         lCountDownCommand->MarkExecutionStart();
 
+        /* Tasks of a task graph are started from the completion of their prerequisites and may reach here concurrently.
+         * All address spaces of a task are queued atomically, so that two tasks never wait on each other's locks.
+         */
+        FINALIZE_RESOURCE(dLockingLock, GetAddressSpacesLockingLock().Lock(), GetAddressSpacesLockingLock().Unlock());
+
         for_each(mTaskMemVector, [this, &lCountDownCommand] (const pmTaskMemory& pTaskMem)
         {
             pmAddressSpace* lAddressSpace = pTaskMem.addressSpace;
@@ -414,10 +435,7 @@ pmTaskExecStats& pmTask::GetTaskExecStats()
 template<typename T>
 void pmTask::RandomizeData(T& pData)
 {
-    std::random_device lRandomDevice;
-    std::mt19937 lGenerator(lRandomDevice());
-    
-	std::shuffle(pData.begin(), pData.end(), lGenerator);
+	std::shuffle(pData.begin(), pData.end(), GetRandomGenerator());
 }
 
 #ifdef ENABLE_TWO_LEVEL_STEALING
@@ -1025,6 +1043,9 @@ pmLocalTask::pmLocalTask(void* pTaskConf, uint pTaskConfLength, ulong pTaskId, s
     , mLocalStubsFreeOfShadowMemCommits(false)
     , mCompletionLock __LOCK_NAME__("pmLocalTask::mCompletionLock")
     , mPreprocessorTask(NULL)
+    , mPersistentTask(NULL)
+    , mAffinityAddressSpace(NULL)
+    , mAffinityAddressSpaceRetained(false)
 {
     ulong lCurrentTime = GetIntegralCurrentTimeInSecs();
     ulong lTaskTimeOutTriggerTime = lCurrentTime + pTaskTimeOutInSecs;
@@ -1127,6 +1148,33 @@ void pmLocalTask::UserDeleteTask()
     TerminateTask();
 }
     
+/* The task is submitted (and its address spaces locked) once all prerequisite tasks have finished, irrespective of their exit status.
+ * Prerequisites that have already finished are not waited upon; with none pending, the task is submitted right away.
+ */
+void pmLocalTask::SubmitAfter(const std::vector<pmLocalTask*>& pPrerequisiteTasks)
+{
+    std::vector<pmCommandPtr> lCommands;
+    lCommands.reserve(pPrerequisiteTasks.size());
+
+    for_each(pPrerequisiteTasks, [&lCommands] (pmLocalTask* pLocalTask)
+    {
+        lCommands.push_back(pLocalTask->mTaskCommand);
+    });
+
+    SubmitAfter(lCommands);
+}
+
+// The commands remain valid even if the tasks owning them have been released
+void pmLocalTask::SubmitAfter(const std::vector<pmCommandPtr>& pPrerequisiteCommands)
+{
+    pmAccumulatorCommand::CreateSharedPtr(pPrerequisiteCommands, PrerequisiteTasksCompletionCallback, this);
+}
+
+const pmCommandPtr& pmLocalTask::GetTaskCommand() const
+{
+    return mTaskCommand;
+}
+    
 void pmLocalTask::SetPreprocessorTask(pmLocalTask* pLocalTask)
 {
     EXCEPTION_ASSERT(!mPreprocessorTask);
@@ -1142,12 +1190,56 @@ const pmLocalTask* pmLocalTask::GetPreprocessorTask() const
 pmAddressSpace* pmLocalTask::GetAffinityAddressSpace() const
 {
     if(!mPreprocessorTask)
-        return NULL;
+        return mAffinityAddressSpace;
     
     const std::vector<pmTaskMemory>& lPreprocessorTaskMemVector = mPreprocessorTask->GetTaskMemVector();
     return lPreprocessorTaskMemVector[lPreprocessorTaskMemVector.size() - 1].addressSpace;
 }
     
+void pmLocalTask::InheritAffinityMappings(const std::vector<ulong>& pLogicalToPhysicalSubtaskMappings, pmAddressSpace* pAffinityAddressSpace)
+{
+    ulong lSubtaskCount = GetSubtaskCount();
+    EXCEPTION_ASSERT(!mPreprocessorTask && pLogicalToPhysicalSubtaskMappings.size() == lSubtaskCount);
+
+    std::vector<ulong> lLogicalToPhysicalSubtaskMappings(pLogicalToPhysicalSubtaskMappings);
+    std::vector<ulong> lPhysicalToLogicalSubtaskMappings(lSubtaskCount);
+
+    for(ulong i = 0; i < lSubtaskCount; ++i)
+        lPhysicalToLogicalSubtaskMappings[lLogicalToPhysicalSubtaskMappings[i]] = i;
+
+    SetAffinityMappings(std::move(lLogicalToPhysicalSubtaskMappings), std::move(lPhysicalToLogicalSubtaskMappings));
+
+    mAffinityAddressSpace = pAffinityAddressSpace;
+}
+
+// The affinity address space computed by the preprocessor task is handed over to the persistent task (instead of being released with the preprocessor task)
+void pmLocalTask::RetainAffinityAddressSpace()
+{
+    mAffinityAddressSpaceRetained = true;
+}
+
+bool pmLocalTask::IsAffinityAddressSpaceRetained() const
+{
+    return mAffinityAddressSpaceRetained;
+}
+
+void pmLocalTask::SetPersistentTask(pmPersistentTask* pPersistentTask)
+{
+    EXCEPTION_ASSERT(!mPersistentTask);
+
+    mPersistentTask = pPersistentTask;
+}
+
+bool pmLocalTask::HasInheritedAffinity() const
+{
+    return (mPersistentTask && mPersistentTask->HasAffinityMappings());
+}
+
+const pmSchedulingHistory* pmLocalTask::GetSchedulingHistory() const
+{
+    return (mPersistentTask ? mPersistentTask->GetSchedulingHistory() : NULL);
+}
+
 void pmLocalTask::ComputeAffinityData(pmAddressSpace* pAffinityAddressSpace)
 {
     std::vector<const pmMachine*> lMachinesVector;
@@ -1161,15 +1253,13 @@ void pmLocalTask::ComputeAffinityData(pmAddressSpace* pAffinityAddressSpace)
 
 void pmLocalTask::StartScheduling()
 {
+    if(mPersistentTask)
+        mPersistentTask->SeedLaunch(this);
+
     InitializeSubtaskManager(GetSchedulingModel());
     pmScheduler::GetScheduler()->AssignSubtasksToDevices(this);
 }
 
-void pmLocalTask::SetTaskCompletionCallback(pmTaskCompletionCallback pCallback)
-{
-    (const_cast<pmCallbackUnit*>(GetCallbackUnit()))->SetTaskCompletionCB(new pmTaskCompletionCB(pCallback));
-}
-    
 void pmLocalTask::SaveFinalReducedOutput(pmExecutionStub* pStub, pmAddressSpace* pAddressSpace, ulong pSubtaskId, pmSplitInfo* pSplitInfo)
 {
     DEBUG_EXCEPTION_ASSERT(DoSubtasksNeedShadowMemory(pAddressSpace));
@@ -1232,7 +1322,9 @@ pmStatus pmLocalTask::InitializeSubtaskManager(scheduler::schedulingModel pSched
 
             if(pSchedulingModel == scheduler::PULL_WITH_AFFINITY)
             {
-                mAffinityTable->CreateSubtaskMappings();
+                // A relaunched persistent task inherits the mappings (there is no affinity table)
+                if(mAffinityTable.get_ptr())
+                    mAffinityTable->CreateSubtaskMappings();
 
                 const std::vector<ulong>& lLogicalToPhysicalSubtaskMappings = GetLogicalToPhysicalSubtaskMappings();
                 
@@ -1304,11 +1396,22 @@ void pmLocalTask::MarkTaskStart()
 
 void pmLocalTask::MarkTaskEnd(pmStatus pStatus)
 {
-	mTaskCommand->MarkExecutionEnd(pStatus, mTaskCommand);
+    // The next launch of a persistent task starts when the task command ends; so, this launch is recorded first
+    if(mPersistentTask)
+    {
+        mPersistentTask->RecordLaunchCompletion(this, pStatus);
+        mPersistentTask = NULL;
+    }
 
+    if(mPreprocessorTask)
+        pmPreprocessorTask::DestroyPreprocessorTask(this);
+
+    // The completion callback runs before the task command ends, i.e. before the user (or a dependent task of a task graph) may release this task
     const pmTaskCompletionCB* lTaskCompletionCB = GetCallbackUnit()->GetTaskCompletionCB();
     if(lTaskCompletionCB)
         lTaskCompletionCB->Invoke(this);
+
+	mTaskCommand->MarkExecutionEnd(pStatus, mTaskCommand);
 }
 
 pmStatus pmLocalTask::GetStatus()
@@ -55,6 +55,9 @@ pmTaskExecStats::pmTaskExecStats(pmTask* pTask)
     , mScatteredMemTransferred(0)
     , mScatteredMemReceiveEvents(0)
     , mScatteredMemTransferEvents(0)
+#endif
+#ifdef DUMP_REMOTE_DATA_CACHE_STATISTICS
+    , mRemoteDataCacheStatistics(pmRemoteDataCache::GetRemoteDataCache()->GetStatistics())
 #endif
     , mResourceLock __LOCK_NAME__("pmTaskExecStats::mResourceLock")
 {
@@ -73,12 +76,31 @@ pmTaskExecStats::~pmTaskExecStats()
     lStream << "Total Memory Transfers - Received = " << mMemReceived << " bytes; Receive Events = " << mMemReceiveEvents << "; Sent = " << mMemTransferred << " bytes; Send Events = " << mMemTransferEvents << std::endl;
     lStream << "Scattered Memory Transfers - Received = " << mScatteredMemReceived << " bytes; Receive Events = " << mScatteredMemReceiveEvents << "; Sent = " << mScatteredMemTransferred << " bytes; Send Events = " << mScatteredMemTransferEvents << std::endl;
 #endif
+
+#ifdef DUMP_REMOTE_DATA_CACHE_STATISTICS
+    pmRemoteDataCacheStatistics lCacheStats = pmRemoteDataCache::GetRemoteDataCache()->GetStatistics();
+    lStream << "Remote Data Cache - Hits = " << lCacheStats.hits - mRemoteDataCacheStatistics.hits << " (" << lCacheStats.hitBytes - mRemoteDataCacheStatistics.hitBytes << " bytes); Misses = " << lCacheStats.misses - mRemoteDataCacheStatistics.misses << " (" << lCacheStats.missBytes - mRemoteDataCacheStatistics.missBytes << " bytes); Evictions = " << lCacheStats.evictions - mRemoteDataCacheStatistics.evictions << "; Invalidations = " << lCacheStats.invalidations - mRemoteDataCacheStatistics.invalidations << std::endl;
+#endif
     
 	auto lIter = mStats.begin(), lEndIter = mStats.end();
     for(; lIter != lEndIter; ++lIter)
     {
         const pmProcessingElement* lDevice = lIter->first->GetProcessingElement();
-        lStream << "Device " << lDevice->GetGlobalDeviceIndex() << " - Subtask execution rate = " << GetStubExecutionRate(lIter->first) << "; Steal attemps = " << GetStealAttempts(lIter->first) << "; Successful steals = " << GetSuccessfulStealAttempts(lIter->first) << "; Failed steals = " << GetFailedStealAttempts(lIter->first) << "; Pipelines across ranges = " << GetPipelineContinuationAcrossRanges(lIter->first) << std::endl;
+        lStream << "Device " << lDevice->GetGlobalDeviceIndex() << " - Subtask execution rate = " << GetStubExecutionRate(lIter->first) << "; Steal attemps = " << GetStealAttempts(lIter->first) << "; Successful steals = " << GetSuccessfulStealAttempts(lIter->first) << "; Failed steals = " << GetFailedStealAttempts(lIter->first) << "; Mean steal round trip = " << GetMeanStealRoundTripTime(lIter->first) << " secs; Pipelines across ranges = " << GetPipelineContinuationAcrossRanges(lIter->first) << "; Prefetched subtasks = " << lIter->second.subtasksPrefetched << " (" << lIter->second.prefetchedSubtasksReleased << " released unexecuted)" << "; Subscription stalls = " << lIter->second.subscriptionStalls << " (" << lIter->second.subscriptionStallTime << " secs)";
+    #ifdef SUPPORT_LAZY_MEMORY
+        lStream << "; Lazy faults = " << lIter->second.lazyFaults << " (" << lIter->second.lazyFaultTime << " secs)";
+    #endif
+        lStream << std::endl;
+
+        for_each(lIter->second.stealTargets, [&] (const std::pair<const stealTarget* const, stealTargetStats>& pPair)
+        {
+        #ifdef ENABLE_TWO_LEVEL_STEALING
+            lStream << "    Steal target machine " << (uint)(*pPair.first);
+        #else
+            lStream << "    Steal target device " << pPair.first->GetGlobalDeviceIndex();
+        #endif
+            lStream << " - Attempts = " << pPair.second.stealAttempts << "; Successful = " << pPair.second.successfulSteals << "; Expected yield = " << pPair.second.expectedYield << " subtasks; Mean round trip = " << (pPair.second.timedStealResponses ? (pPair.second.stealRoundTripTime / pPair.second.timedStealResponses) : (double)0) << " secs" << std::endl;
+        });
     }
 
     pmLogger::GetLogger()->LogDeferred(pmLogger::DEBUG_INTERNAL, pmLogger::INFORMATION, lStream.str().c_str());
@@ -110,6 +132,38 @@ double pmTaskExecStats::GetStubExecutionRate(pmExecutionStub* pStub)
 	return (double)(mStats[pStub].subtasksExecuted)/(double)(mStats[pStub].executionTime);
 }
 
+void pmTaskExecStats::SaveExecutionRates(std::map<pmExecutionStub*, std::pair<double, double>>& pExecutionRates)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    for_each(mStats, [&] (const decltype(mStats)::value_type& pPair)
+    {
+        if(pPair.second.executionTime != (double)0)
+            pExecutionRates.emplace(pPair.first, std::make_pair((double)pPair.second.subtasksExecuted, pPair.second.executionTime));
+    });
+}
+
+/* Execution rates of an earlier execution are folded in as if those subtasks were executed in this task.
+ * Steal decisions made before a stub finishes its first subtask then work with a known rate.
+ */
+void pmTaskExecStats::SeedExecutionRates(const std::map<pmExecutionStub*, std::pair<double, double>>& pExecutionRates)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    for_each(pExecutionRates, [&] (const std::pair<pmExecutionStub*, std::pair<double, double>>& pPair)
+    {
+        stubStats& lStats = mStats[pPair.first];
+
+    #ifdef SUPPORT_SPLIT_SUBTASKS
+        lStats.subtasksExecuted += pPair.second.first;
+    #else
+        lStats.subtasksExecuted += (ulong)pPair.second.first;
+    #endif
+
+        lStats.executionTime += pPair.second.second;
+    });
+}
+
 uint pmTaskExecStats::GetStealAttempts(pmExecutionStub* pStub)
 {
 	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
@@ -117,11 +171,17 @@ uint pmTaskExecStats::GetStealAttempts(pmExecutionStub* pStub)
 	return mStats[pStub].stealAttempts;
 }
 
-pmStatus pmTaskExecStats::RecordStealAttempt(pmExecutionStub* pStub)
+pmStatus pmTaskExecStats::RecordStealAttempt(pmExecutionStub* pStub, const stealTarget* pTarget)
 {
 	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
 
-    ++(mStats[pStub].stealAttempts);
+    stubStats& lStats = mStats[pStub];
+
+    ++(lStats.stealAttempts);
+    ++(lStats.stealTargets[pTarget].stealAttempts);
+
+    lStats.lastStealAttemptTime = pmBase::GetCurrentTimeInSecs();
+    lStats.lastStealTarget = pTarget;
 
 	return pmSuccess;
 }
@@ -147,12 +207,14 @@ uint pmTaskExecStats::GetFailedStealAttemptsSinceLastSuccessfulAttempt(pmExecuti
     return mStats[pStub].consecutiveFailedSteals;
 }
 
-void pmTaskExecStats::RecordSuccessfulStealAttempt(pmExecutionStub* pStub)
+void pmTaskExecStats::RecordSuccessfulStealAttempt(pmExecutionStub* pStub, ulong pStolenSubtasks)
 {
 	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
 
     mStats[pStub].consecutiveFailedSteals = 0;
     ++(mStats[pStub].successfulSteals);
+
+    RecordStealResponse(mStats[pStub], pStolenSubtasks);
 }
     
 void pmTaskExecStats::RecordFailedStealAttempt(pmExecutionStub* pStub)
@@ -161,6 +223,78 @@ void pmTaskExecStats::RecordFailedStealAttempt(pmExecutionStub* pStub)
 
     ++(mStats[pStub].consecutiveFailedSteals);
     ++(mStats[pStub].failedSteals);
+
+    RecordStealResponse(mStats[pStub], 0);
+}
+
+/* Must be called with mResourceLock acquired. A response is timed against (and credited to the target of) the latest
+ * attempt of the stub; responses of attempts overtaken by a newer one (and attempts which found no target) are not. */
+void pmTaskExecStats::RecordStealResponse(stubStats& pStats, ulong pStolenSubtasks)
+{
+    if(pStats.lastStealAttemptTime == (double)0)
+        return;
+
+    double lRoundTripTime = pmBase::GetCurrentTimeInSecs() - pStats.lastStealAttemptTime;
+
+    pStats.stealRoundTripTime += lRoundTripTime;
+    pStats.lastStealAttemptTime = 0;
+    ++(pStats.timedStealResponses);
+
+    stealTargetStats& lTargetStats = pStats.stealTargets[pStats.lastStealTarget];
+
+    lTargetStats.stealRoundTripTime += lRoundTripTime;
+    ++(lTargetStats.timedStealResponses);
+
+    if(pStolenSubtasks)
+        ++(lTargetStats.successfulSteals);
+
+    if(lTargetStats.expectedYield < 0)
+        lTargetStats.expectedYield = (double)pStolenSubtasks;
+    else
+        lTargetStats.expectedYield += STEAL_TARGET_YIELD_DECAY * ((double)pStolenSubtasks - lTargetStats.expectedYield);
+}
+
+double pmTaskExecStats::GetMeanStealRoundTripTime(pmExecutionStub* pStub)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    const stubStats& lStats = mStats[pStub];
+
+    return (lStats.timedStealResponses ? (lStats.stealRoundTripTime / lStats.timedStealResponses) : (double)0);
+}
+
+double pmTaskExecStats::GetMeanStealRoundTripTime(pmExecutionStub* pStub, const stealTarget* pTarget)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    const stubStats& lStats = mStats[pStub];
+
+    auto lIter = lStats.stealTargets.find(pTarget);
+    if(lIter != lStats.stealTargets.end() && lIter->second.timedStealResponses)
+        return (lIter->second.stealRoundTripTime / lIter->second.timedStealResponses);
+
+    return (lStats.timedStealResponses ? (lStats.stealRoundTripTime / lStats.timedStealResponses) : (double)0);
+}
+
+/* A victim grants a share of its remaining subtasks in proportion to the stealer's execution rate relative to its own.
+ * So, the yield of recent steals from a target reflects both its remaining work and its rate. Dividing it by the round
+ * trip to the target favours targets which keep the stealer busy for longer per unit of time spent waiting on them. */
+double pmTaskExecStats::GetStealTargetWeight(pmExecutionStub* pStub, const stealTarget* pTarget)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    const stubStats& lStats = mStats[pStub];
+
+    auto lIter = lStats.stealTargets.find(pTarget);
+    if(lIter == lStats.stealTargets.end() || !lIter->second.stealAttempts)
+        return -1;
+    
+    const stealTargetStats& lTargetStats = lIter->second;
+    double lYield = std::max(lTargetStats.expectedYield, MIN_STEAL_TARGET_YIELD);
+
+    double lRoundTripTime = (lTargetStats.timedStealResponses ? (lTargetStats.stealRoundTripTime / lTargetStats.timedStealResponses) : (lStats.timedStealResponses ? (lStats.stealRoundTripTime / lStats.timedStealResponses) : (double)0));
+
+    return ((lRoundTripTime > (double)0) ? (lYield / lRoundTripTime) : lYield);
 }
     
 void pmTaskExecStats::RegisterPipelineContinuationAcrossRanges(pmExecutionStub* pStub)
@@ -177,6 +311,59 @@ uint pmTaskExecStats::GetPipelineContinuationAcrossRanges(pmExecutionStub* pStub
     return mStats[pStub].pipelineContinuationAcrossRanges;
 }
 
+void pmTaskExecStats::RecordSubtasksPrefetched(pmExecutionStub* pStub, ulong pSubtaskCount)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    mStats[pStub].subtasksPrefetched += pSubtaskCount;
+}
+
+void pmTaskExecStats::RecordPrefetchedSubtasksReleased(pmExecutionStub* pStub, ulong pSubtaskCount)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    mStats[pStub].prefetchedSubtasksReleased += pSubtaskCount;
+}
+
+ulong pmTaskExecStats::GetSubtasksPrefetched(pmExecutionStub* pStub)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    return mStats[pStub].subtasksPrefetched;
+}
+
+ulong pmTaskExecStats::GetPrefetchedSubtasksReleased(pmExecutionStub* pStub)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    return mStats[pStub].prefetchedSubtasksReleased;
+}
+
+void pmTaskExecStats::RecordSubscriptionStall(pmExecutionStub* pStub, double pStallTimeInSecs)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    ++(mStats[pStub].subscriptionStalls);
+    mStats[pStub].subscriptionStallTime += pStallTimeInSecs;
+}
+
+#ifdef SUPPORT_LAZY_MEMORY
+void pmTaskExecStats::RecordLazyFault(pmExecutionStub* pStub, double pFaultTimeInSecs)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    ++(mStats[pStub].lazyFaults);
+    mStats[pStub].lazyFaultTime += pFaultTimeInSecs;
+}
+#endif
+
+double pmTaskExecStats::GetSubscriptionStallTime(pmExecutionStub* pStub)
+{
+	FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    return mStats[pStub].subscriptionStallTime;
+}
+
 #ifdef ENABLE_MEM_PROFILING
 void pmTaskExecStats::RecordMemReceiveEvent(size_t pMemSize, bool pIsScattered)
 {
@@ -215,7 +402,28 @@ pmTaskExecStats::stubStats::stubStats()
     , successfulSteals(0)
     , failedSteals(0)
     , consecutiveFailedSteals(0)
+    , lastStealAttemptTime(0)
+    , timedStealResponses(0)
+    , stealRoundTripTime(0)
+    , lastStealTarget(NULL)
     , pipelineContinuationAcrossRanges(0)
+    , subtasksPrefetched(0)
+    , prefetchedSubtasksReleased(0)
+    , subscriptionStalls(0)
+    , subscriptionStallTime(0)
+#ifdef SUPPORT_LAZY_MEMORY
+    , lazyFaults(0)
+    , lazyFaultTime(0)
+#endif
+{
+}
+
+pmTaskExecStats::stealTargetStats::stealTargetStats()
+    : stealAttempts(0)
+    , successfulSteals(0)
+    , expectedYield(-1)
+    , timedStealResponses(0)
+    , stealRoundTripTime(0)
 {
 }
 
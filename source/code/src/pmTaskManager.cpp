@@ -39,6 +39,7 @@
 #include "pmCallbackUnit.h"
 #include "pmDevicePool.h"
 #include "pmAddressSpace.h"
+#include "pmUtility.h"
 
 namespace pm
 {
@@ -93,12 +94,16 @@ pmRemoteTask* pmTaskManager::CreateRemoteTask(communicator::remoteTaskAssignPack
         
         EXCEPTION_ASSERT(lTaskMemStruct.addressSpaceType == ADDRESS_SPACE_LINEAR || lTaskMemStruct.addressSpaceType == ADDRESS_SPACE_2D);
 
+        pmMemAllocationPolicy lAllocationPolicy((pmMemPlacementPolicy)((lTaskMemStruct.flags & TASK_MEM_PLACEMENT_POLICY_MASK) >> TASK_MEM_PLACEMENT_POLICY_SHIFT), (pmMemPageSize)((lTaskMemStruct.flags & TASK_MEM_PAGE_SIZE_MASK) >> TASK_MEM_PAGE_SIZE_SHIFT), (bool)(lTaskMemStruct.flags & TASK_MEM_ADVISE_ACCESS_PATTERN_FLAG_VAL), (pmNetworkCompression)((lTaskMemStruct.flags & TASK_MEM_NETWORK_COMPRESSION_MASK) >> TASK_MEM_NETWORK_COMPRESSION_SHIFT));
+
         if(lTaskMemStruct.addressSpaceType == ADDRESS_SPACE_LINEAR)
-            lAddressSpace = pmAddressSpace::CheckAndCreateAddressSpace(lTaskMemStruct.memLength, lOwnerHost, lTaskMemStruct.memIdentifier.generationNumber);
+            lAddressSpace = pmAddressSpace::CheckAndCreateAddressSpace(lTaskMemStruct.memLength, lOwnerHost, lTaskMemStruct.memIdentifier.generationNumber, lAllocationPolicy);
         else
-            lAddressSpace = pmAddressSpace::CheckAndCreateAddressSpace(lTaskMemStruct.memLength, lTaskMemStruct.cols, lOwnerHost, lTaskMemStruct.memIdentifier.generationNumber);
+            lAddressSpace = pmAddressSpace::CheckAndCreateAddressSpace(lTaskMemStruct.memLength, lTaskMemStruct.cols, lOwnerHost, lTaskMemStruct.memIdentifier.generationNumber, lAllocationPolicy);
         
-        lTaskMemVector.emplace_back(lAddressSpace, (pmMemType)(lTaskMemStruct.memType), (pmSubscriptionVisibilityType)(lTaskMemStruct.subscriptionVisibility), (bool)lTaskMemStruct.flags);
+        lAddressSpace->ValidateRemoteDataCache(lTaskMemStruct.dataGeneration, pmUtility::IsWritable((pmMemType)(lTaskMemStruct.memType)));
+
+        lTaskMemVector.emplace_back(lAddressSpace, (pmMemType)(lTaskMemStruct.memType), (pmSubscriptionVisibilityType)(lTaskMemStruct.subscriptionVisibility), (bool)(lTaskMemStruct.flags & TASK_MEM_DISJOINT_READ_WRITES_FLAG_VAL));
     }
 
     std::vector<const pmProcessingElement*> lDevices;
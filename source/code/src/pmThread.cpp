@@ -39,26 +39,26 @@ namespace pm
 {
 
 /* pmPThread Class */
-template<typename T, typename P>
-pmPThread<T, P>::pmPThread()
+template<typename T, typename P, typename Q>
+pmPThread<T, P, Q>::pmPThread()
     : mSignalWait(false)
     , mReverseSignalWait(false)
 {
     mThreadStartSignalWaitPtr.reset(new SIGNAL_WAIT_IMPLEMENTATION_CLASS(true));
 
-	THROW_ON_NON_ZERO_RET_VAL( pthread_create(&mThread, NULL, ThreadLoop<T, P>, this), pmThreadFailureException, pmThreadFailureException::THREAD_CREATE_ERROR );
+	THROW_ON_NON_ZERO_RET_VAL( pthread_create(&mThread, NULL, ThreadLoop<T, P, Q>, this), pmThreadFailureException, pmThreadFailureException::THREAD_CREATE_ERROR );
     
     mThreadStartSignalWaitPtr->Wait();
 }
 
-template<typename T, typename P>
-pmPThread<T, P>::~pmPThread()
+template<typename T, typename P, typename Q>
+pmPThread<T, P, Q>::~pmPThread()
 {
 	TerminateThread();
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::TerminateThread()
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::TerminateThread()
 {
     std::shared_ptr<T> lSharedPtr(new T());
     lSharedPtr->msg = thread::TERMINATE;
@@ -68,16 +68,16 @@ void pmPThread<T, P>::TerminateThread()
 	THROW_ON_NON_ZERO_RET_VAL( pthread_join(mThread, NULL), pmThreadFailureException, pmThreadFailureException::THREAD_JOIN_ERROR );
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::SwitchThread(const std::shared_ptr<T>& pCommand, P pPriority)
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::SwitchThread(const std::shared_ptr<T>& pCommand, P pPriority)
 {
     pCommand->msg = thread::DISPATCH_COMMAND;
 
 	SubmitCommand(pCommand, pPriority);
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::ThreadCommandLoop()
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::ThreadCommandLoop()
 {
     mThreadStartSignalWaitPtr->Signal();
 
@@ -121,8 +121,8 @@ void pmPThread<T, P>::ThreadCommandLoop()
     mThreadStartSignalWaitPtr.reset();
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::InterruptThread()
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::InterruptThread()
 {
     if(mThread == pthread_self())
         PMTHROW(pmFatalErrorException());
@@ -134,14 +134,14 @@ void pmPThread<T, P>::InterruptThread()
 #endif
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::WaitIfCurrentCommandMatches(typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, void* pMatchCriterion)
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::WaitIfCurrentCommandMatches(typename Q::matchFuncPtr pMatchFunc, void* pMatchCriterion)
 {
     this->mSafePQ.WaitIfMatchingItemBeingProcessed(pMatchFunc, pMatchCriterion);
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::WaitForQueuedCommands()
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::WaitForQueuedCommands()
 {
     while(!this->mSafePQ.IsEmpty())
         mReverseSignalWait.Wait();
@@ -149,57 +149,57 @@ void pmPThread<T, P>::WaitForQueuedCommands()
     this->mSafePQ.WaitForCurrentItem();
 }
 
-template<typename T, typename P>
-void pmPThread<T, P>::SubmitCommand(const std::shared_ptr<T>& pInternalCommand, P pPriority)
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::SubmitCommand(const std::shared_ptr<T>& pInternalCommand, P pPriority)
 {
 	this->mSafePQ.InsertItem(pInternalCommand, pPriority);
     mSignalWait.Signal();
 }
 
-template<typename T, typename P>
-pmStatus pmThread<T, P>::DeleteAndGetFirstMatchingCommand(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pCommand, bool pTemporarilyUnblockSecondaryCommands /* = false */)
+template<typename T, typename P, typename Q>
+pmStatus pmThread<T, P, Q>::DeleteAndGetFirstMatchingCommand(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::shared_ptr<T>& pCommand, bool pTemporarilyUnblockSecondaryCommands /* = false */, const void* pIndexKey /* = NULL */)
 {
-	return this->mSafePQ.DeleteAndGetFirstMatchingItem(pPriority, pMatchFunc, pMatchCriterion, pCommand, pTemporarilyUnblockSecondaryCommands);
+	return this->mSafePQ.DeleteAndGetFirstMatchingItem(pPriority, pMatchFunc, pMatchCriterion, pCommand, pTemporarilyUnblockSecondaryCommands, pIndexKey);
 }
 
-template<typename T, typename P>
-void pmThread<T, P>::DeleteAndGetAllMatchingCommands(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pCommands, bool pTemporarilyUnblockSecondaryCommands /* = false */)
+template<typename T, typename P, typename Q>
+void pmThread<T, P, Q>::DeleteAndGetAllMatchingCommands(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, std::vector<std::shared_ptr<T>>& pCommands, bool pTemporarilyUnblockSecondaryCommands /* = false */, const void* pIndexKey /* = NULL */)
 {
-	this->mSafePQ.DeleteAndGetAllMatchingItems(pPriority, pMatchFunc, pMatchCriterion, pCommands, pTemporarilyUnblockSecondaryCommands);
+	this->mSafePQ.DeleteAndGetAllMatchingItems(pPriority, pMatchFunc, pMatchCriterion, pCommands, pTemporarilyUnblockSecondaryCommands, pIndexKey);
 }
 
-template<typename T, typename P>
-void pmThread<T, P>::DeleteMatchingCommands(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion)
+template<typename T, typename P, typename Q>
+void pmThread<T, P, Q>::DeleteMatchingCommands(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey /* = NULL */)
 {
-	this->mSafePQ.DeleteMatchingItems(pPriority, pMatchFunc, pMatchCriterion);
+	this->mSafePQ.DeleteMatchingItems(pPriority, pMatchFunc, pMatchCriterion, pIndexKey);
 }
 
-template<typename T, typename P>
-bool pmThread<T, P>::HasMatchingCommand(P pPriority, typename pmSafePQ<T, P>::matchFuncPtr pMatchFunc, const void* pMatchCriterion)
+template<typename T, typename P, typename Q>
+bool pmThread<T, P, Q>::HasMatchingCommand(P pPriority, typename Q::matchFuncPtr pMatchFunc, const void* pMatchCriterion, const void* pIndexKey /* = NULL */)
 {
-	return this->mSafePQ.HasMatchingItem(pPriority, pMatchFunc, pMatchCriterion);
+	return this->mSafePQ.HasMatchingItem(pPriority, pMatchFunc, pMatchCriterion, pIndexKey);
 }
 
-template<typename T, typename P>
-void pmThread<T, P>::UnblockSecondaryCommands()
+template<typename T, typename P, typename Q>
+void pmThread<T, P, Q>::UnblockSecondaryCommands()
 {
     this->mSafePQ.UnblockSecondaryOperations();
 }
 
-template<typename T, typename P>
-void pmThread<T, P>::BlockSecondaryCommands()
+template<typename T, typename P, typename Q>
+void pmThread<T, P, Q>::BlockSecondaryCommands()
 {
     this->mSafePQ.BlockSecondaryOperations();
 }
 
-template<typename T, typename P>
-void pmThread<T, P>::CallWhenSecondaryCommandsUnblocked(const std::function<void ()>& pFunc)
+template<typename T, typename P, typename Q>
+void pmThread<T, P, Q>::CallWhenSecondaryCommandsUnblocked(const std::function<void ()>& pFunc)
 {
     this->mSafePQ.CallWhenSecondaryOperationsUnblocked(pFunc);
 }
     
-template<typename T, typename P>
-void pmPThread<T, P>::SetProcessorAffinity(int pProcessorId)
+template<typename T, typename P, typename Q>
+void pmPThread<T, P, Q>::SetProcessorAffinity(int pProcessorId)
 {
 #ifdef LINUX
 	pthread_t lThread = pthread_self();
@@ -218,10 +218,10 @@ void pmPThread<T, P>::SetProcessorAffinity(int pProcessorId)
 #endif
 }
 
-template<typename T, typename P>
+template<typename T, typename P, typename Q>
 void* ThreadLoop(void* pThreadData)
 {
-	pmPThread<T, P>* lObjectPtr = (pmPThread<T, P>*)pThreadData;
+	pmPThread<T, P, Q>* lObjectPtr = (pmPThread<T, P, Q>*)pThreadData;
 	lObjectPtr->ThreadCommandLoop();
 
 	return NULL;
@@ -0,0 +1,402 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+#include "pmTracer.h"
+#include "pmNetwork.h"
+#include "pmExecutionStub.h"
+#include "pmHardware.h"
+#include "pmTask.h"
+
+#include <string.h>
+#include <sstream>
+#include <limits>
+
+namespace pm
+{
+
+using namespace tracer;
+
+static const char* traceEventName[] =
+{
+    (char*)"SubtaskExecution",
+    (char*)"SubtaskReduction",
+    (char*)"WaitOnNetwork",
+    (char*)"StealRequest",
+    (char*)"StealSuccessResponse",
+    (char*)"StealFailureResponse",
+    (char*)"MemorySend",
+    (char*)"MemoryReceive",
+    (char*)"ClockSynchronization"
+};
+
+std::atomic<bool> pmTracer::sEnabled(false);
+
+ulong __get_clock_ns(clockid_t pClock)
+{
+    struct timespec lTime;
+    clock_gettime(pClock, &lTime);
+    
+    return (ulong)lTime.tv_sec * 1000000000 + (ulong)lTime.tv_nsec;
+}
+
+    
+/* class pmTraceBuffer */
+pmTraceBuffer::pmTraceBuffer(uint pThreadIndex, int pDeviceIndex)
+    : mThreadIndex(pThreadIndex)
+    , mDeviceIndex(pDeviceIndex)
+    , mRecords(TRACE_BUFFER_RECORDS)
+    , mHead(0)
+    , mTail(0)
+    , mDroppedRecords(0)
+{
+}
+
+uint pmTraceBuffer::GetThreadIndex() const
+{
+    return mThreadIndex;
+}
+
+int pmTraceBuffer::GetDeviceIndex() const
+{
+    return mDeviceIndex;
+}
+
+ulong pmTraceBuffer::GetDroppedRecords() const
+{
+    return mDroppedRecords.load(std::memory_order_relaxed);
+}
+
+ulong pmTraceBuffer::Drain(FILE* pFile)
+{
+    ulong lTail = mTail.load(std::memory_order_relaxed);
+    ulong lCount = mHead.load(std::memory_order_acquire) - lTail;
+    
+    if(!lCount)
+        return 0;
+
+    traceFormat::blockHeader lBlockHeader = {traceFormat::RECORDS_BLOCK, (uint32_t)lCount};
+    fwrite(&lBlockHeader, sizeof(lBlockHeader), 1, pFile);
+    
+    // The ring may wrap around; the records are written in at most two pieces
+    ulong lStart = (lTail & (TRACE_BUFFER_RECORDS - 1));
+    ulong lFirstPiece = std::min<ulong>(lCount, TRACE_BUFFER_RECORDS - lStart);
+
+    fwrite(&mRecords[lStart], sizeof(traceFormat::eventRecord), lFirstPiece, pFile);
+    
+    if(lFirstPiece != lCount)
+        fwrite(&mRecords[0], sizeof(traceFormat::eventRecord), lCount - lFirstPiece, pFile);
+    
+    mTail.store(lTail + lCount, std::memory_order_release);
+    
+    return lCount;
+}
+
+
+/* class pmTracer */
+pmTracer* pmTracer::GetTracer()
+{
+    static pmTracer lTracer;
+    return &lTracer;
+}
+
+pmTracer::pmTracer()
+    : mFile(NULL)
+    , mWrittenEventNames(0)
+    , mWrittenThreads(0)
+    , mMonotonicBaseNs(0)
+    , mRealtimeBaseNs(0)
+    , mClockSynchronized(false)
+    , mFlushing(false)
+    , mFinalized(false)
+    , mSignalWait(false)
+    , mResourceLock __LOCK_NAME__("pmTracer::mResourceLock")
+{
+    for(uint i = 0; i < MAX_TRACE_EVENTS; ++i)
+    {
+        mEventNames.push_back(traceEventName[i]);
+        mInternedEvents[traceEventName[i]] = (ushort)i;
+    }
+
+    static const char* lTraceVal = getenv("PMLIB_TRACE");
+    if(lTraceVal && atoi(lTraceVal) != 0)
+        sEnabled.store(true);
+}
+    
+pmTracer::~pmTracer()
+{
+#ifdef DUMP_THREADS
+	pmLogger::GetLogger()->Log(pmLogger::MINIMAL, pmLogger::INFORMATION, "Shutting down tracer thread");
+#endif
+}
+
+ushort pmTracer::InternEvent(const char* pName)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    std::map<std::string, ushort>::iterator lIter = mInternedEvents.find(pName);
+    if(lIter != mInternedEvents.end())
+        return lIter->second;
+    
+    if(mEventNames.size() > std::numeric_limits<ushort>::max())
+        PMTHROW(pmFatalErrorException());
+
+    ushort lEventId = (ushort)mEventNames.size();
+
+    mEventNames.push_back(pName);
+    mInternedEvents[pName] = lEventId;
+    
+    return lEventId;
+}
+
+ulong pmTracer::GetTaskKey(const pmTask* pTask)
+{
+    if(!pTask)
+        return 0;
+
+    return traceFormat::PackTaskKey((uint)(*pTask->GetOriginatingHost()), pTask->GetSequenceNumber());
+}
+
+void pmTracer::SetEnabled(bool pEnable)
+{
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    if(mFinalized)
+        return;
+
+    sEnabled.store(pEnable);
+
+    if(pEnable)
+    {
+        if(mClockSynchronized)
+            StartFlushing();
+    }
+    else
+    {
+        mSignalWait.Signal();   // Flush what has been recorded so far
+    }
+}
+
+/* Called on all hosts right after the first global barrier. Records in different host files are aligned on this instant. */
+void pmTracer::SynchronizeClock()
+{
+    RecordInstant(CLOCK_SYNCHRONIZATION, (ulong)0, 0);   // Records are appended outside mResourceLock (a thread's first record acquires it)
+
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    mMonotonicBaseNs = __get_clock_ns(CLOCK_MONOTONIC);
+    mRealtimeBaseNs = __get_clock_ns(CLOCK_REALTIME);
+    mClockSynchronized = true;
+    
+    if(IsEnabled())
+        StartFlushing();
+}
+
+void pmTracer::Finalize()
+{
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+        sEnabled.store(false);
+        mFinalized = true;
+        mSignalWait.Signal();
+    }
+
+    WaitForQueuedCommands();
+    
+    if(mFile)
+    {
+        Flush();
+
+        FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+        std::vector<traceFormat::droppedEntry> lDroppedEntries;
+        for_each(mBuffers, [&] (const std::unique_ptr<pmTraceBuffer>& pBuffer)
+        {
+            if(pBuffer->GetDroppedRecords())
+            {
+                traceFormat::droppedEntry lEntry = {pBuffer->GetThreadIndex(), 0, pBuffer->GetDroppedRecords()};
+                lDroppedEntries.push_back(lEntry);
+            }
+        });
+        
+        traceFormat::blockHeader lBlockHeader = {traceFormat::DROPPED_RECORDS_BLOCK, (uint32_t)lDroppedEntries.size()};
+        fwrite(&lBlockHeader, sizeof(lBlockHeader), 1, mFile);
+
+        if(!lDroppedEntries.empty())
+            fwrite(&lDroppedEntries[0], sizeof(traceFormat::droppedEntry), lDroppedEntries.size(), mFile);
+
+        fclose(mFile);
+        mFile = NULL;
+    }
+}
+
+/* Must be called with mResourceLock acquired */
+void pmTracer::StartFlushing()
+{
+    if(mFlushing)
+        return;
+    
+    mFlushing = true;
+    SwitchThread(std::shared_ptr<traceFlushEvent>(new traceFlushEvent(FLUSH_TRACE)), 0);
+}
+
+pmTraceBuffer* pmTracer::CreateThreadBuffer()
+{
+    int lDeviceIndex = traceFormat::NO_TRACE_DEVICE;
+
+    pmExecutionStub* lStub = static_cast<pmExecutionStub*>(TLS_IMPLEMENTATION_CLASS::GetTls()->GetThreadLocalStorage(TLS_EXEC_STUB));
+    if(lStub)
+        lDeviceIndex = (int)lStub->GetProcessingElement()->GetGlobalDeviceIndex();
+
+    FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+    mBuffers.emplace_back(new pmTraceBuffer((uint)mBuffers.size(), lDeviceIndex));
+    pmTraceBuffer* lBuffer = mBuffers.back().get();
+
+    TLS_IMPLEMENTATION_CLASS::GetTls()->SetThreadLocalStorage(TLS_TRACE_BUFFER, lBuffer);
+
+    return lBuffer;
+}
+
+/* Only called on the tracer thread (or by Finalize once the tracer thread is idle) */
+void pmTracer::Flush()
+{
+    std::vector<pmTraceBuffer*> lBuffers;
+    std::vector<std::string> lNewEventNames;
+    std::vector<traceFormat::threadEntry> lNewThreads;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+        
+        if(!mFile)
+        {
+            static const char* lTraceDir = getenv("PMLIB_TRACE_DIR");
+
+            std::stringstream lStream;
+            lStream << (lTraceDir ? lTraceDir : ".") << "/pmlib_trace_" << NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetHostId() << ".bin";
+            
+            mFile = fopen(lStream.str().c_str(), "wb");
+            if(!mFile)
+                PMTHROW(pmFatalErrorException());
+
+            traceFormat::fileHeader lHeader;
+            memcpy(lHeader.magic, traceFormat::TRACE_FILE_MAGIC, sizeof(lHeader.magic));
+            lHeader.version = traceFormat::TRACE_FILE_VERSION;
+            lHeader.hostId = NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetHostId();
+            lHeader.hostCount = NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetTotalHostCount();
+            lHeader.recordSize = sizeof(traceFormat::eventRecord);
+            lHeader.monotonicBaseNs = mMonotonicBaseNs;
+            lHeader.realtimeBaseNs = mRealtimeBaseNs;
+
+            fwrite(&lHeader, sizeof(lHeader), 1, mFile);
+        }
+        
+        lNewEventNames.assign(mEventNames.begin() + mWrittenEventNames, mEventNames.end());
+        mWrittenEventNames = mEventNames.size();
+        
+        for(size_t i = mWrittenThreads; i < mBuffers.size(); ++i)
+        {
+            traceFormat::threadEntry lEntry = {mBuffers[i]->GetThreadIndex(), mBuffers[i]->GetDeviceIndex()};
+            lNewThreads.push_back(lEntry);
+        }
+
+        mWrittenThreads = mBuffers.size();
+
+        lBuffers.reserve(mBuffers.size());
+        for_each(mBuffers, [&] (const std::unique_ptr<pmTraceBuffer>& pBuffer)
+        {
+            lBuffers.push_back(pBuffer.get());
+        });
+    }
+    
+    if(!lNewEventNames.empty())
+    {
+        traceFormat::blockHeader lBlockHeader = {traceFormat::EVENT_NAMES_BLOCK, (uint32_t)lNewEventNames.size()};
+        fwrite(&lBlockHeader, sizeof(lBlockHeader), 1, mFile);
+        
+        uint16_t lEventId = (uint16_t)(mWrittenEventNames - lNewEventNames.size());
+        for_each(lNewEventNames, [&] (const std::string& pName)
+        {
+            uint16_t lLength = (uint16_t)pName.length();
+
+            fwrite(&lEventId, sizeof(lEventId), 1, mFile);
+            fwrite(&lLength, sizeof(lLength), 1, mFile);
+            fwrite(pName.c_str(), 1, lLength, mFile);
+
+            ++lEventId;
+        });
+    }
+
+    if(!lNewThreads.empty())
+    {
+        traceFormat::blockHeader lBlockHeader = {traceFormat::THREADS_BLOCK, (uint32_t)lNewThreads.size()};
+        fwrite(&lBlockHeader, sizeof(lBlockHeader), 1, mFile);
+        fwrite(&lNewThreads[0], sizeof(traceFormat::threadEntry), lNewThreads.size(), mFile);
+    }
+    
+    for_each(lBuffers, [&] (pmTraceBuffer* pBuffer)
+    {
+        pBuffer->Drain(mFile);
+    });
+
+    fflush(mFile);
+}
+
+void pmTracer::ThreadSwitchCallback(std::shared_ptr<traceFlushEvent>& pEvent)
+{
+    switch(pEvent->eventId)
+    {
+        case FLUSH_TRACE:
+        {
+            mSignalWait.WaitWithTimeOut(GetIntegralCurrentTimeInSecs() + TRACE_FLUSH_INTERVAL);
+
+            Flush();
+            
+            FINALIZE_RESOURCE_PTR(dResourceLock, RESOURCE_LOCK_IMPLEMENTATION_CLASS, &mResourceLock, Lock(), Unlock());
+
+            if(IsEnabled() && !mFinalized)
+                SwitchThread(pEvent, 0);
+            else
+                mFlushing = false;
+
+            break;
+        }
+            
+        default:
+            PMTHROW(pmFatalErrorException());
+    }
+}
+
+} // end namespace pm
@@ -43,6 +43,7 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <fcntl.h>
+#include <errno.h>
 
 #include <dlfcn.h>	// For dlopen/dlclose/dlsym
 
@@ -52,6 +53,7 @@ namespace pm
 STATIC_ACCESSOR(ulong, pmUtility, GetMultiFileOperationsId)
 STATIC_ACCESSOR(pmUtility::multiFileOperationsMapType, pmUtility, GetMultiFileOperationsMap)
 STATIC_ACCESSOR(pmUtility::fileMappingsMapType, pmUtility, GetFileMappingsMap)
+STATIC_ACCESSOR(pmUtility::fileBackedAddressSpacesMapType, pmUtility, GetFileBackedAddressSpacesMap)
 STATIC_ACCESSOR(pmUtility::pendingResponsesMapType, pmUtility, GetFileMappingPendingResponsesMap)
 STATIC_ACCESSOR(pmUtility::pendingResponsesMapType, pmUtility, GetFileUnmappingPendingResponsesMap)
 STATIC_ACCESSOR_ARG(RESOURCE_LOCK_IMPLEMENTATION_CLASS, __STATIC_LOCK_NAME__("pmUtility::ResourceLock"), pmUtility, GetResourceLock)
@@ -435,6 +437,232 @@ void pmUtility::UnmapFile(const char* pPath)
     lFileMappings.erase(lStr);
 }
 
+/* Unlike pmMapFile, nothing is mapped here; machines other than the owner read only the ranges their subtasks fetch */
+size_t pmUtility::OpenFileBackedAddressSpaceOnAllMachines(const char* pPath, ulong pGenerationNumber)
+{
+    EXCEPTION_ASSERT(strlen(pPath) <= MAX_FILE_SIZE_LEN - 1);
+
+    uint lCount = NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetTotalHostCount();
+    uint lLocalHost = NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetHostId();
+
+    size_t lLength = OpenFileBackedAddressSpace(pPath, lLocalHost, pGenerationNumber);
+
+    std::shared_ptr<SIGNAL_WAIT_IMPLEMENTATION_CLASS> lSignalWaitSharedPtr;
+    
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+        std::string lStr(pPath);
+        pendingResponsesMapType& lPendingResponses = GetFileMappingPendingResponsesMap();
+        if(lPendingResponses.find(lStr) != lPendingResponses.end())
+            PMTHROW(pmFatalErrorException());
+        
+        lSignalWaitSharedPtr.reset(new SIGNAL_WAIT_IMPLEMENTATION_CLASS(true));
+        lPendingResponses[lStr] = std::make_pair(lCount, lSignalWaitSharedPtr);
+    }
+
+    RegisterFileMappingResponse(pPath);
+
+    for(uint i = 0; i < lCount; ++i)
+    {
+        const pmMachine* lMachine = pmMachinePool::GetMachinePool()->GetMachine(i);
+    
+        if(lMachine != PM_LOCAL_MACHINE)
+        {
+            finalize_ptr<communicator::fileOperationsStruct> lFileOperationsData(new communicator::fileOperationsStruct(pPath, communicator::OPEN_FILE_BACKED_ADDRESS_SPACE, lLocalHost, pGenerationNumber));
+
+            pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<communicator::fileOperationsStruct>::CreateSharedPtr(MAX_CONTROL_PRIORITY, communicator::SEND, communicator::FILE_OPERATIONS_TAG, lMachine, communicator::FILE_OPERATIONS_STRUCT, lFileOperationsData, 1);
+
+            pmCommunicator::GetCommunicator()->Send(lCommand, false);
+        }
+    }
+    
+    lSignalWaitSharedPtr->Wait();
+    
+    return lLength;
+}
+
+/* Called when the owner destroys the address space (i.e. after the last task using it), so no acknowledgements are awaited */
+void pmUtility::CloseFileBackedAddressSpaceOnAllMachines(ulong pGenerationNumber)
+{
+    uint lCount = NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetTotalHostCount();
+    uint lLocalHost = NETWORK_IMPLEMENTATION_CLASS::GetNetwork()->GetHostId();
+
+    std::string lPath;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+        fileBackedAddressSpacesMapType& lFileBackedAddressSpaces = GetFileBackedAddressSpacesMap();
+
+        auto lIter = lFileBackedAddressSpaces.find(std::make_pair(lLocalHost, pGenerationNumber));
+        if(lIter == lFileBackedAddressSpaces.end())
+            PMTHROW(pmFatalErrorException());
+
+        lPath = lIter->second->mPath;
+        lFileBackedAddressSpaces.erase(lIter);
+    }
+
+    for(uint i = 0; i < lCount; ++i)
+    {
+        const pmMachine* lMachine = pmMachinePool::GetMachinePool()->GetMachine(i);
+    
+        if(lMachine != PM_LOCAL_MACHINE)
+        {
+            finalize_ptr<communicator::fileOperationsStruct> lFileOperationsData(new communicator::fileOperationsStruct(lPath.c_str(), communicator::CLOSE_FILE_BACKED_ADDRESS_SPACE, lLocalHost, pGenerationNumber));
+
+            pmCommunicatorCommandPtr lCommand = pmCommunicatorCommand<communicator::fileOperationsStruct>::CreateSharedPtr(MAX_CONTROL_PRIORITY, communicator::SEND, communicator::FILE_OPERATIONS_TAG, lMachine, communicator::FILE_OPERATIONS_STRUCT, lFileOperationsData, 1);
+
+            pmCommunicator::GetCommunicator()->Send(lCommand, false);
+        }
+    }
+}
+
+size_t pmUtility::OpenFileBackedAddressSpace(const char* pPath, uint pOwnerHost, ulong pGenerationNumber)
+{
+    std::shared_ptr<fileBackedAddressSpace> lFile(new fileBackedAddressSpace(pPath));
+
+    FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+    fileBackedAddressSpacesMapType& lFileBackedAddressSpaces = GetFileBackedAddressSpacesMap();
+    if(!lFileBackedAddressSpaces.emplace(std::make_pair(pOwnerHost, pGenerationNumber), lFile).second)
+        PMTHROW(pmFatalErrorException());
+
+    return lFile->mLength;
+}
+
+void pmUtility::CloseFileBackedAddressSpace(uint pOwnerHost, ulong pGenerationNumber)
+{
+    FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+    GetFileBackedAddressSpacesMap().erase(std::make_pair(pOwnerHost, pGenerationNumber));
+}
+
+bool pmUtility::IsFileBackedAddressSpace(uint pOwnerHost, ulong pGenerationNumber)
+{
+    FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+    fileBackedAddressSpacesMapType& lFileBackedAddressSpaces = GetFileBackedAddressSpacesMap();
+
+    return (lFileBackedAddressSpaces.find(std::make_pair(pOwnerHost, pGenerationNumber)) != lFileBackedAddressSpaces.end());
+}
+
+int pmUtility::GetFileBackedAddressSpaceDescriptor(uint pOwnerHost, ulong pGenerationNumber)
+{
+    FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+    fileBackedAddressSpacesMapType& lFileBackedAddressSpaces = GetFileBackedAddressSpacesMap();
+
+    auto lIter = lFileBackedAddressSpaces.find(std::make_pair(pOwnerHost, pGenerationNumber));
+    if(lIter == lFileBackedAddressSpaces.end())
+        PMTHROW(pmFatalErrorException());
+
+    return lIter->second->mDescriptor;
+}
+
+/* Reads a range of a file backed address space into its memory. Returns false if the address space is not file backed (or has been closed).
+ * Reads a constant distance apart (consecutive subtasks or a fixed stride) have the following ranges advised to the kernel for readahead.
+ * The pages read are then dropped from page cache, as the address space holds its own copy of them. */
+bool pmUtility::ReadFileBackedAddressSpace(uint pOwnerHost, ulong pGenerationNumber, void* pAddressSpaceBaseAddr, ulong pOffset, ulong pLength)
+{
+    static const char* lVal = getenv("PMLIB_FILE_BACKED_KEEP_PAGE_CACHE");
+    static bool lKeepPageCache = (lVal && atoi(lVal) != 0);
+
+    std::shared_ptr<fileBackedAddressSpace> lFile;
+    ulong lReadaheadOffset = 0, lReadaheadLength = 0;
+
+    // Auto lock/unlock scope
+    {
+        FINALIZE_RESOURCE(dResourceLock, GetResourceLock().Lock(), GetResourceLock().Unlock());
+
+        fileBackedAddressSpacesMapType& lFileBackedAddressSpaces = GetFileBackedAddressSpacesMap();
+
+        auto lIter = lFileBackedAddressSpaces.find(std::make_pair(pOwnerHost, pGenerationNumber));
+        if(lIter == lFileBackedAddressSpaces.end())
+            return false;
+
+        lFile = lIter->second;
+        EXCEPTION_ASSERT(pOffset + pLength <= lFile->mLength);
+
+        if(pOffset < lFile->mLastOffset)
+            lFile->mReadaheadEnd = 0;
+
+        long lStride = (long)pOffset - (long)lFile->mLastOffset;
+        bool lSequential = (lFile->mLastLength && pOffset == lFile->mLastOffset + lFile->mLastLength);
+
+        if(lSequential || (lStride > 0 && lStride == lFile->mStride))
+        {
+            ulong lStep = (lSequential ? pLength : (ulong)lStride);
+            ulong lStart = std::max<ulong>(pOffset + lStep, lFile->mReadaheadEnd);
+            ulong lEnd = std::min<ulong>(pOffset + lStep * FILE_BACKED_READAHEAD_RANGES + pLength, lFile->mLength);
+
+            if(lStart < lEnd)
+            {
+                lReadaheadOffset = lStart;
+                lReadaheadLength = lEnd - lStart;
+                lFile->mReadaheadEnd = lEnd;
+            }
+        }
+
+        lFile->mStride = lStride;
+        lFile->mLastOffset = pOffset;
+        lFile->mLastLength = pLength;
+    }
+
+    if(lReadaheadLength)
+        posix_fadvise(lFile->mDescriptor, (off_t)lReadaheadOffset, (off_t)lReadaheadLength, POSIX_FADV_WILLNEED);
+
+    char* lMem = static_cast<char*>(pAddressSpaceBaseAddr) + pOffset;
+    ulong lRead = 0;
+
+    while(lRead < pLength)
+    {
+        ssize_t lBytes = pread(lFile->mDescriptor, lMem + lRead, pLength - lRead, (off_t)(pOffset + lRead));
+
+        if(lBytes < 0 && errno == EINTR)
+            continue;
+
+        if(lBytes <= 0)
+            PMTHROW(pmFatalErrorException());
+
+        lRead += (ulong)lBytes;
+    }
+
+    if(!lKeepPageCache)
+        posix_fadvise(lFile->mDescriptor, (off_t)pOffset, (off_t)pLength, POSIX_FADV_DONTNEED);
+
+    return true;
+}
+
+pmUtility::fileBackedAddressSpace::fileBackedAddressSpace(const char* pPath)
+    : mPath(pPath)
+    , mDescriptor(-1)
+    , mLength(0)
+    , mLastOffset(0)
+    , mLastLength(0)
+    , mStride(0)
+    , mReadaheadEnd(0)
+{
+    struct stat lStatBuf;
+
+    if(((mDescriptor = open(pPath, O_RDONLY)) < 0) || (fstat(mDescriptor, &lStatBuf) < 0) || !lStatBuf.st_size)
+    {
+        if(mDescriptor >= 0)
+            close(mDescriptor);
+
+        PMTHROW(pmFatalErrorException());
+    }
+
+    mLength = lStatBuf.st_size;
+}
+
+pmUtility::fileBackedAddressSpace::~fileBackedAddressSpace()
+{
+    close(mDescriptor);
+}
+
 void* pmUtility::OpenLibrary(char* pPath)
 {
 	return dlopen(pPath, RTLD_LAZY | RTLD_LOCAL);
@@ -506,6 +734,105 @@ bool pmUtility::IsLazyReadWrite(pmMemType pMemType)
     return (pMemType == READ_WRITE_LAZY);
 }
 
+pmMemType pmUtility::GetEagerMemType(pmMemType pMemType)
+{
+    switch(pMemType)
+    {
+        case READ_ONLY_LAZY:
+            return READ_ONLY;
+
+        case READ_WRITE_LAZY:
+            return READ_WRITE;
+
+        case WRITE_ONLY_LAZY:
+            return WRITE_ONLY;
+
+        default:
+            return pMemType;
+    }
+}
+
+bool pmUtility::IsZeroElement(const void* pElem, size_t pElemSize)
+{
+    const char* lElem = static_cast<const char*>(pElem);
+
+    for(size_t i = 0; i < pElemSize; ++i)
+    {
+        if(lElem[i])
+            return false;
+    }
+    
+    return true;
+}
+
+std::shared_ptr<char> pmUtility::CompressForSentinel(const void* pMem, size_t pElemSize, ulong pCount, ulong& pCompressedLength)
+{
+    return CompressForSentinelInternal(static_cast<const char*>(pMem), pElemSize, pCount, pCompressedLength, [pElemSize] (const char* pElem)
+    {
+        return IsZeroElement(pElem, pElemSize);
+    });
+}
+
+ulong pmUtility::GetSentinelCompressedFrameLength(ulong pRuns, ulong pElems, size_t pElemSize)
+{
+    ulong lLength = sizeof(sentinelCompression::frameHeader) + pRuns * sizeof(sentinelCompression::run) + pElems * pElemSize;
+
+    return ((lLength + sizeof(ulong) - 1) / sizeof(ulong)) * sizeof(ulong);
+}
+
+void pmUtility::GetSentinelCompressedFrames(const void* pCompressedMem, ulong pCompressedLength, std::vector<const sentinelCompression::frameHeader*>& pFrames)
+{
+    using namespace sentinelCompression;
+
+    EXCEPTION_ASSERT(pCompressedLength >= sizeof(bufferHeader));
+
+    const char* lMem = static_cast<const char*>(pCompressedMem);
+    const bufferHeader* lBufferHeader = reinterpret_cast<const bufferHeader*>(lMem);
+
+    pFrames.clear();
+    pFrames.reserve(lBufferHeader->frameCount);
+    
+    ulong lOffset = sizeof(bufferHeader);
+    for(ulong i = 0; i < lBufferHeader->frameCount; ++i)
+    {
+        const frameHeader* lFrameHeader = reinterpret_cast<const frameHeader*>(lMem + lOffset);
+
+        EXCEPTION_ASSERT(lOffset + sizeof(frameHeader) <= pCompressedLength && lOffset + lFrameHeader->frameLength <= pCompressedLength);
+        EXCEPTION_ASSERT(lFrameHeader->firstElem + lFrameHeader->elemCount <= lBufferHeader->uncompressedCount);
+
+        pFrames.push_back(lFrameHeader);
+        lOffset += lFrameHeader->frameLength;
+    }
+}
+
+void pmUtility::DecompressForSentinel(const void* pCompressedMem, ulong pCompressedLength, size_t pElemSize, void* pMem)
+{
+    std::vector<const sentinelCompression::frameHeader*> lFrames;
+    GetSentinelCompressedFrames(pCompressedMem, pCompressedLength, lFrames);
+    
+    char* lMem = static_cast<char*>(pMem);
+    long lFrameCount = (long)lFrames.size();
+
+#ifdef USE_OMP_FOR_REDUCTION
+    #pragma omp parallel for
+#endif
+    for(long i = 0; i < lFrameCount; ++i)
+    {
+        const sentinelCompression::frameHeader* lFrame = lFrames[i];
+        ulong lNextElem = lFrame->firstElem;
+
+        ForEachSentinelCompressedRun(lFrame, pElemSize, [&] (ulong pElemIndex, const char* pData, ulong pElems)
+        {
+            memset(lMem + lNextElem * pElemSize, 0, (pElemIndex - lNextElem) * pElemSize);
+            memcpy(lMem + pElemIndex * pElemSize, pData, pElems * pElemSize);
+
+            lNextElem = pElemIndex + pElems;
+        });
+        
+        memset(lMem + lNextElem * pElemSize, 0, (lFrame->firstElem + lFrame->elemCount - lNextElem) * pElemSize);
+    }
+}
+
 } // end namespace pm
 
 
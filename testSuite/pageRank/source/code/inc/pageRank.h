@@ -64,7 +64,7 @@ typedef struct pageRankTaskConf
 #ifdef BUILD_CUDA
 #include <cuda.h>
 pmStatus pageRank_cudaLaunchFunc(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo, void* pCudaStream);
-int singleGpuPageRank(pageRankTaskConf& pTaskConf, unsigned int* pWebDump, void* pOutputMem);
+int singleGpuPageRank(pageRankTaskConf& pTaskConf, int pIterations, unsigned int* pWebDump, void* pOutputMem);
 #endif
 
 enum memIndex
@@ -234,12 +234,12 @@ void initializePageRankArray(PAGE_RANK_DATA_TYPE* pPageRankArray, PAGE_RANK_DATA
 		pPageRankArray[i] = pVal;
 }
 
-void serialPageRank(unsigned int* pWebDump)
+void serialPageRank(unsigned int* pWebDump, int pIterations)
 {
 	PAGE_RANK_DATA_TYPE* lGlobalPageRankArray = NULL;
 	PAGE_RANK_DATA_TYPE* lLocalPageRankArray = NULL;
 
-	for(int i = 0; i < PAGE_RANK_ITERATIONS; ++i)
+	for(int i = 0; i < pIterations; ++i)
 	{
 		if(i != 0)
         {
@@ -247,7 +247,7 @@ void serialPageRank(unsigned int* pWebDump)
 			lLocalPageRankArray = lGlobalPageRankArray;
         }
 
-        if(i == PAGE_RANK_ITERATIONS - 1)
+        if(i == pIterations - 1)
             lGlobalPageRankArray = gSerialOutput;
         else
             lGlobalPageRankArray = new PAGE_RANK_DATA_TYPE[gTotalWebPages];
@@ -311,7 +311,7 @@ void** LoadMappedFiles(pageRankTaskConf* pTaskConf, ulong pSubtaskId)
     unsigned int lWebPages = (unsigned int)((pTaskConf->totalWebPages < ((pSubtaskId + 1) * pTaskConf->webPagesPerSubtask)) ? (pTaskConf->totalWebPages - (pSubtaskId * pTaskConf->webPagesPerSubtask)) : pTaskConf->webPagesPerSubtask);
     
     unsigned int lWebFiles = ((lWebPages / pTaskConf->webPagesPerFile) + ((lWebPages % pTaskConf->webPagesPerFile) ? 1 : 0));
-    unsigned int lFirstWebFile = (unsigned int)pSubtaskId * lWebFiles;
+    unsigned int lFirstWebFile = (unsigned int)pSubtaskId * (pTaskConf->webPagesPerSubtask / pTaskConf->webPagesPerFile);    // The last subtask may have fewer files
     unsigned int lLastWebFile = lFirstWebFile + lWebFiles;
     
     void** lWebFilePtrs = new void*[lWebFiles];
@@ -347,7 +347,7 @@ pmStatus pageRank_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskI
 
     unsigned int lWebPages = (unsigned int)((lTaskConf->totalWebPages < ((lSubtaskId + 1) * lTaskConf->webPagesPerSubtask)) ? (lTaskConf->totalWebPages - (lSubtaskId * lTaskConf->webPagesPerSubtask)) : lTaskConf->webPagesPerSubtask);
     unsigned int lWebFiles = ((lWebPages / lTaskConf->webPagesPerFile) + ((lWebPages % lTaskConf->webPagesPerFile) ? 1 : 0));
-    unsigned int lFirstWebFile = (unsigned int)pSubtaskInfo.subtaskId * lWebFiles;
+    unsigned int lFirstWebFile = (unsigned int)pSubtaskInfo.subtaskId * (lTaskConf->webPagesPerSubtask / lTaskConf->webPagesPerFile);
 
     unsigned int lTotalFiles = (lTaskConf->totalWebPages / lTaskConf->webPagesPerFile) + ((lTaskConf->totalWebPages % lTaskConf->webPagesPerFile) ? 1 : 0);
     for(unsigned int i = 0; i < lWebFiles; ++i)
@@ -379,7 +379,11 @@ pmStatus pageRank_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskI
     
 #define READ_NON_COMMON_ARGS \
 	char* lBasePath = DEFAULT_BASE_PATH; \
-	FETCH_STR_ARG(lBasePath, pCommonArgs, argc, argv);
+	int lIterations = PAGE_RANK_ITERATIONS; \
+	int lPersistent = 1; \
+	FETCH_STR_ARG(lBasePath, pCommonArgs, argc, argv); \
+	FETCH_INT_ARG(lIterations, pCommonArgs + 1, argc, argv); \
+	FETCH_INT_ARG(lPersistent, pCommonArgs + 2, argc, argv);
 
 // Returns execution time on success; 0 on error
 double DoSerialProcess(int argc, char** argv, int pCommonArgs)
@@ -398,7 +402,7 @@ double DoSerialProcess(int argc, char** argv, int pCommonArgs)
     if((gTotalWebPages % gWebPagesPerFile) != 0)
         readWebPagesFile(lBasePath, gTotalWebPages, gMaxOutlinksPerWebPage, gWebPagesPerFile, i*gWebPagesPerFile, gTotalWebPages - i*gWebPagesPerFile, lWebDump + (i * gWebPagesPerFile * (gMaxOutlinksPerWebPage + 1)));
 
-	serialPageRank(lWebDump);
+	serialPageRank(lWebDump, lIterations);
 
     delete[] lWebDump;
 
@@ -433,7 +437,7 @@ double DoSingleGpuProcess(int argc, char** argv, int pCommonArgs)
     
 	double lStartTime = getCurrentTimeInSecs();
 
-	if(singleGpuPageRank(lTaskConf, lWebDump, gParallelOutput) != 0)
+	if(singleGpuPageRank(lTaskConf, lIterations, lWebDump, gParallelOutput) != 0)
         return 0;
 
 	double lEndTime = getCurrentTimeInSecs();
@@ -446,7 +450,10 @@ double DoSingleGpuProcess(int argc, char** argv, int pCommonArgs)
 #endif
 }
 
-bool ParallelPageRankIteration(pmMemHandle pInputMemHandle, pmMemHandle pOutputMemHandle, pageRankTaskConf* pTaskConf, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy)
+/* Every iteration passes both address spaces (the first one does not subscribe to its input), so that all iterations can be
+ * launches of one persistent task. The persistent task is created by the first iteration, if pPersistentTaskHandle is not NULL.
+ */
+bool ParallelPageRankIteration(pmMemHandle pInputMemHandle, pmMemHandle pOutputMemHandle, pageRankTaskConf* pTaskConf, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy, pmPersistentTaskHandle* pPersistentTaskHandle)
 {
     pTaskConf->webPagesPerSubtask = getWebPagesPerSubtask(pmGetHostCount() * 4);    // Assuming 5 devices per host
     unsigned long lSubtasks = (gTotalWebPages / pTaskConf->webPagesPerSubtask) + ((gTotalWebPages % pTaskConf->webPagesPerSubtask) ? 1 : 0);
@@ -455,18 +462,26 @@ bool ParallelPageRankIteration(pmMemHandle pInputMemHandle, pmMemHandle pOutputM
 
     CREATE_TASK(lSubtasks, pCallbackHandle, pSchedulingPolicy)
 
-    if(pInputMemHandle)
-        lTaskMem[INPUT_MEM_INDEX] = {pInputMemHandle,  READ_ONLY, SUBSCRIPTION_NATURAL};
-    
+    lTaskMem[INPUT_MEM_INDEX] = {pInputMemHandle,  READ_ONLY, SUBSCRIPTION_NATURAL};
     lTaskMem[OUTPUT_MEM_INDEX] = {pOutputMemHandle, WRITE_ONLY, SUBSCRIPTION_NATURAL};
 
-    lTaskDetails.taskMemCount = (pInputMemHandle ? MAX_MEM_INDICES : 1);
+    lTaskDetails.taskMemCount = MAX_MEM_INDICES;
     lTaskDetails.taskMem = (pmTaskMem*)(lTaskMem);
     
 	lTaskDetails.taskConf = (void*)(pTaskConf);
 	lTaskDetails.taskConfLength = sizeof(pageRankTaskConf);
 
-	SAFE_PM_EXEC( pmSubmitTask(lTaskDetails, &lTaskHandle) );
+    if(pPersistentTaskHandle)
+    {
+        if(!(*pPersistentTaskHandle))
+            SAFE_PM_EXEC( pmCreatePersistentTask(lTaskDetails, pPersistentTaskHandle) );
+
+        SAFE_PM_EXEC( pmLaunchPersistentTask(*pPersistentTaskHandle, lTaskMem, pTaskConf, &lTaskHandle) );
+    }
+    else
+    {
+        SAFE_PM_EXEC( pmSubmitTask(lTaskDetails, &lTaskHandle) );
+    }
 	
     if(pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
     {
@@ -496,9 +511,10 @@ double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandl
     pmMemHandle lInputMemHandle = NULL, lOutputMemHandle = NULL;
 
     CREATE_MEM(lMemSize, lOutputMemHandle);
-    
-    if(PAGE_RANK_ITERATIONS > 1)
-        CREATE_MEM(lMemSize, lInputMemHandle);
+    CREATE_MEM(lMemSize, lInputMemHandle);
+
+    // Later iterations reuse the scheduling state (and affinity mappings) learnt by the earlier ones
+    pmPersistentTaskHandle lPersistentTaskHandle = NULL;
 
     pageRankTaskConf lTaskConf;
 	lTaskConf.totalWebPages = gTotalWebPages;
@@ -508,15 +524,23 @@ double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandl
     lTaskConf.initialPageRank = INITIAL_PAGE_RANK;
     strcpy(lTaskConf.basePath, lBasePath);
 
-    for(int i = 0; i < PAGE_RANK_ITERATIONS; ++i)
+    for(int i = 0; i < lIterations; ++i)
     {
 		if(i != 0)
             std::swap(lInputMemHandle, lOutputMemHandle);
     
         lTaskConf.iteration = i;
-        if(!ParallelPageRankIteration(((i == 0) ? NULL : lInputMemHandle), lOutputMemHandle, &lTaskConf, pCallbackHandle[0], pSchedulingPolicy))
+        if(!ParallelPageRankIteration(lInputMemHandle, lOutputMemHandle, &lTaskConf, pCallbackHandle[0], pSchedulingPolicy, (lPersistent ? &lPersistentTaskHandle : NULL)))
+        {
+            if(lPersistentTaskHandle)
+                pmReleasePersistentTask(lPersistentTaskHandle);
+
 			return (double)-1.0;
+        }
     }
+
+    if(lPersistentTaskHandle)
+        SAFE_PM_EXEC( pmReleasePersistentTask(lPersistentTaskHandle) );
     
     unMapAllFiles(lBasePath);
 
@@ -531,9 +555,7 @@ double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandl
         memcpy(gParallelOutput, lRawOutputPtr, lMemSize);
     }
 
-    if(lInputMemHandle)
-        pmReleaseMemory(lInputMemHandle);
-
+    pmReleaseMemory(lInputMemHandle);
 	pmReleaseMemory(lOutputMemHandle);
 
 	return (lEndTime - lStartTime);
@@ -573,6 +595,12 @@ int DoInit(int argc, char** argv, int pCommonArgs)
         exit(1);
     }
 
+    if(lIterations < 1)
+    {
+        std::cout << "Invalid iteration count" << std::endl;
+        exit(1);
+    }
+
     readWebMetaData(lBasePath);
 
 	gSerialOutput = new PAGE_RANK_DATA_TYPE[gTotalWebPages];
@@ -606,7 +634,9 @@ int DoCompare(int argc, char** argv, int pCommonArgs)
 }
 
 /**	Non-common args
- *	1. Matrix Dimension
+ *	1. Web dump path
+ *	2. Iterations
+ *	3. Launch the iterations as one persistent task (1) or submit a task per iteration (0)
  */
 int main(int argc, char** argv)
 {
@@ -125,7 +125,7 @@ pmStatus pageRank_cudaLaunchFunc(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo,
     
     unsigned int lWebPages = (unsigned int)((lTaskConf->totalWebPages < ((lSubtaskId + 1) * lTaskConf->webPagesPerSubtask)) ? (lTaskConf->totalWebPages - (lSubtaskId * lTaskConf->webPagesPerSubtask)) : lTaskConf->webPagesPerSubtask);
     unsigned int lWebFiles = ((lWebPages / lTaskConf->webPagesPerFile) + ((lWebPages % lTaskConf->webPagesPerFile) ? 1 : 0));
-    unsigned int lFirstWebFile = (unsigned int)pSubtaskInfo.subtaskId * lWebFiles;
+    unsigned int lFirstWebFile = (unsigned int)pSubtaskInfo.subtaskId * (lTaskConf->webPagesPerSubtask / lTaskConf->webPagesPerFile);
 
     unsigned int* lWebDump = (unsigned int*)(pSubtaskInfo.gpuContext.reservedGlobalMem);
     unsigned int* lWebDumpPtr = lWebDump;
@@ -164,7 +164,7 @@ pmStatus pageRank_cudaLaunchFunc(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo,
 }
     
 // Returns 0 on success, non-zero on failure
-int singleGpuPageRank(pageRankTaskConf& pTaskConf, unsigned int* pWebDump, void* pOutputMem)
+int singleGpuPageRank(pageRankTaskConf& pTaskConf, int pIterations, unsigned int* pWebDump, void* pOutputMem)
 {
     unsigned int* lWebDumpCudaPtr = NULL;
     PAGE_RANK_DATA_TYPE* lLocalArrayCudaPtr = NULL;
@@ -180,7 +180,7 @@ int singleGpuPageRank(pageRankTaskConf& pTaskConf, unsigned int* pWebDump, void*
     dim3 gridConf(lCudaLaunchConf.blocksX, 1, 1);
     dim3 blockConf(lCudaLaunchConf.threadsX, 1, 1);
 
-    for(unsigned int i = 0; i < PAGE_RANK_ITERATIONS; ++i)
+    for(int i = 0; i < pIterations; ++i)
     {
 		if(i > 1)
             CUDA_ERROR_CHECK("cudaFree", cudaFree(lLocalArrayCudaPtr));
@@ -33,6 +33,7 @@
 
 #include <time.h>
 #include <string.h>
+#include <vector>
 
 #include "commonAPI.h"
 #include "prefixSum.h"
@@ -196,19 +197,23 @@ void PopulateAuxMem(pmMemHandle pSrcMemHandle, pmMemHandle pAuxMemHandle, unsign
     
     char* lDestPtr = (char*)lRawAuxPtr;
 
+    // Fetch the last element of every subtask in one batch
+    std::vector<pmSubscriptionInfo> lRanges;
+
     unsigned int lSrcStep = ELEMS_PER_SUBTASK * sizeof(PREFIX_SUM_DATA_TYPE);
     for(unsigned int i = (lSrcStep - sizeof(PREFIX_SUM_DATA_TYPE)); i < lSrcSize; i += lSrcStep)
-    {
-        SAFE_PM_EXEC( pmFetchMemoryRange(pSrcMemHandle, i, sizeof(PREFIX_SUM_DATA_TYPE)) );
-        memcpy((void*)lDestPtr, (void*)((char*)lRawSrcPtr + i), sizeof(PREFIX_SUM_DATA_TYPE));
-        lDestPtr += sizeof(PREFIX_SUM_DATA_TYPE);
-    }
+        lRanges.push_back(pmSubscriptionInfo(i, sizeof(PREFIX_SUM_DATA_TYPE)));
     
     if(pSrcArrayLength % ELEMS_PER_SUBTASK != 0)
+        lRanges.push_back(pmSubscriptionInfo((pSrcArrayLength - 1) * sizeof(PREFIX_SUM_DATA_TYPE), sizeof(PREFIX_SUM_DATA_TYPE)));
+
+    if(!lRanges.empty())
+        SAFE_PM_EXEC( pmFetchMemoryRanges(pSrcMemHandle, &lRanges[0], (uint)lRanges.size()) );
+
+    for(size_t i = 0; i < lRanges.size(); ++i)
     {
-        unsigned int lOffset = (pSrcArrayLength - 1) * sizeof(PREFIX_SUM_DATA_TYPE);
-        SAFE_PM_EXEC( pmFetchMemoryRange(pSrcMemHandle, lOffset, sizeof(PREFIX_SUM_DATA_TYPE)) );
-        memcpy((void*)lDestPtr, (void*)((char*)lRawSrcPtr + lOffset), sizeof(PREFIX_SUM_DATA_TYPE));
+        memcpy((void*)lDestPtr, (void*)((char*)lRawSrcPtr + lRanges[i].offset), sizeof(PREFIX_SUM_DATA_TYPE));
+        lDestPtr += sizeof(PREFIX_SUM_DATA_TYPE);
     }
 
     serialPrefixSum((PREFIX_SUM_DATA_TYPE*)lRawAuxPtr, (PREFIX_SUM_DATA_TYPE*)lRawAuxPtr, pAuxArrayLength);
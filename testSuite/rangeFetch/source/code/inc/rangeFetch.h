@@ -0,0 +1,66 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+namespace rangeFetch
+{
+
+#define DEFAULT_POW_BYTES 24
+#define DEFAULT_SUBTASK_COUNT 16
+#define DEFAULT_RANGE_COUNT 2000
+#define DEFAULT_FETCH_MODE MAX_FETCH_MODES
+
+#define MAX_RANGE_LENGTH 16384
+
+using namespace pm;
+
+enum memIndex
+{
+    OUTPUT_MEM_INDEX = 0,
+    MAX_MEM_INDICES
+};
+
+enum fetchMode
+{
+    FETCH_RANGE_BY_RANGE = 0,           // pmFetchMemoryRange once per range
+    FETCH_RANGES,                       // pmFetchMemoryRanges
+    FETCH_RANGES_ASYNC,                 // pmFetchMemoryRangesAsync, polled with pmTestFetch and waited upon with pmWaitForFetch
+    FETCH_RANGES_ASYNC_EARLY_RELEASE,   // pmFetchMemoryRangesAsync released before completion and followed by pmFetchMemoryRanges
+    MAX_FETCH_MODES                     // All of the above in turn
+};
+
+typedef struct rangeFetchTaskConf
+{
+    size_t memLength;
+} rangeFetchTaskConf;
+
+}
@@ -0,0 +1,398 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/* Exercises the range fetch API. Subtasks spread over all hosts write an address space, after which the submitting host fetches
+ * a few thousand pseudo random (possibly overlapping) ranges of it with pmFetchMemoryRange, pmFetchMemoryRanges or
+ * pmFetchMemoryRangesAsync. The asynchronous fetch is either polled with pmTestFetch and waited upon with pmWaitForFetch, or
+ * released with pmReleaseFetch before it completes, in which case a blocking fetch of the same ranges must find the data.
+ * Every fetch mode runs on a freshly written address space and is checked against the serially computed bytes of the ranges.
+ */
+
+#include <string.h>
+#include <vector>
+
+#include "commonAPI.h"
+#include "rangeFetch.h"
+
+namespace rangeFetch
+{
+
+unsigned char* gSerialOutput;
+unsigned char* gParallelOutput;
+
+unsigned char getByteValue(size_t pOffset)
+{
+    return (unsigned char)((pOffset ^ (pOffset >> 8) ^ (pOffset >> 16)) * 31 + 7);
+}
+
+// The same ranges are generated on every call
+void getRanges(size_t pMemLength, int pRangeCount, std::vector<pmSubscriptionInfo>& pRanges)
+{
+    unsigned long long lSeed = 1;
+
+    pRanges.clear();
+    pRanges.reserve(pRangeCount);
+
+    for(int i = 0; i < pRangeCount; ++i)
+    {
+        lSeed = lSeed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t lOffset = (size_t)(lSeed >> 33) % pMemLength;
+
+        lSeed = lSeed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t lLength = std::min<size_t>(1 + (size_t)(lSeed >> 33) % MAX_RANGE_LENGTH, pMemLength - lOffset);
+
+        pRanges.push_back(pmSubscriptionInfo(lOffset, lLength));
+    }
+}
+
+void getSubtaskBlock(size_t pMemLength, unsigned long pSubtaskCount, unsigned long pSubtaskId, size_t& pOffset, size_t& pLength)
+{
+    size_t lBlockLength = pMemLength / pSubtaskCount;
+
+    pOffset = pSubtaskId * lBlockLength;
+    pLength = ((pSubtaskId == pSubtaskCount - 1) ? (pMemLength - pOffset) : lBlockLength);
+}
+
+void serialRangeFetch(unsigned char* pOutput, size_t pMemLength, const std::vector<pmSubscriptionInfo>& pRanges)
+{
+    memset(pOutput, 0, pMemLength);
+
+    for(size_t i = 0; i < pRanges.size(); ++i)
+    {
+        for(size_t j = pRanges[i].offset; j < pRanges[i].offset + pRanges[i].length; ++j)
+            pOutput[j] = getByteValue(j);
+    }
+}
+
+pmStatus rangeFetchDataDistribution(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    rangeFetchTaskConf* lTaskConf = (rangeFetchTaskConf*)(pTaskInfo.taskConf);
+
+    size_t lOffset, lLength;
+    getSubtaskBlock(lTaskConf->memLength, pTaskInfo.subtaskCount, pSubtaskInfo.subtaskId, lOffset, lLength);
+
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, OUTPUT_MEM_INDEX, WRITE_SUBSCRIPTION, pmSubscriptionInfo(lOffset, lLength));
+
+    return pmSuccess;
+}
+
+pmStatus rangeFetch_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    rangeFetchTaskConf* lTaskConf = (rangeFetchTaskConf*)(pTaskInfo.taskConf);
+
+    size_t lOffset, lLength;
+    getSubtaskBlock(lTaskConf->memLength, pTaskInfo.subtaskCount, pSubtaskInfo.subtaskId, lOffset, lLength);
+
+    unsigned char* lOutput = (unsigned char*)pSubtaskInfo.memInfo[OUTPUT_MEM_INDEX].ptr;
+    for(size_t i = 0; i < lLength; ++i)
+        lOutput[i] = getByteValue(lOffset + i);
+
+    return pmSuccess;
+}
+
+bool parallelWrite(size_t pMemLength, unsigned long pSubtaskCount, pmMemHandle pOutputMemHandle, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy)
+{
+    CREATE_TASK(pSubtaskCount, pCallbackHandle, pSchedulingPolicy)
+
+    pmTaskMem lTaskMem[MAX_MEM_INDICES];
+    lTaskMem[OUTPUT_MEM_INDEX] = {pOutputMemHandle, WRITE_ONLY, SUBSCRIPTION_NATURAL};
+
+    lTaskDetails.taskMem = (pmTaskMem*)lTaskMem;
+    lTaskDetails.taskMemCount = MAX_MEM_INDICES;
+
+    rangeFetchTaskConf lTaskConf;
+    lTaskConf.memLength = pMemLength;
+
+    lTaskDetails.taskConf = (void*)(&lTaskConf);
+    lTaskDetails.taskConfLength = sizeof(lTaskConf);
+
+    SAFE_PM_EXEC( pmSubmitTask(lTaskDetails, &lTaskHandle) );
+    
+    if(pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
+    {
+        pmReleaseTask(lTaskHandle);
+        return false;
+    }
+    
+    pmReleaseTask(lTaskHandle);
+
+    return true;
+}
+
+// Returns false if the fetch API reports an error
+bool parallelFetch(pmMemHandle pMemHandle, std::vector<pmSubscriptionInfo>& pRanges, fetchMode pFetchMode)
+{
+    switch(pFetchMode)
+    {
+        case FETCH_RANGE_BY_RANGE:
+        {
+            for(size_t i = 0; i < pRanges.size(); ++i)
+            {
+                if(pmFetchMemoryRange(pMemHandle, pRanges[i].offset, pRanges[i].length) != pmSuccess)
+                    return false;
+            }
+
+            return true;
+        }
+
+        case FETCH_RANGES:
+            return (pmFetchMemoryRanges(pMemHandle, &pRanges[0], (uint)pRanges.size()) == pmSuccess);
+
+        case FETCH_RANGES_ASYNC:
+        {
+            pmFetchHandle lFetchHandle;
+            bool lComplete = false;
+
+            if(pmFetchMemoryRangesAsync(pMemHandle, &pRanges[0], (uint)pRanges.size(), &lFetchHandle) != pmSuccess)
+                return false;
+
+            // The fetch may or may not be complete yet
+            bool lStatus = (pmTestFetch(lFetchHandle, &lComplete) == pmSuccess && pmWaitForFetch(lFetchHandle) == pmSuccess);
+
+            // ... but must be once waited upon
+            lStatus = (lStatus && pmTestFetch(lFetchHandle, &lComplete) == pmSuccess && lComplete);
+            if(!lStatus)
+                std::cout << "Asynchronous fetch not complete after pmWaitForFetch" << std::endl;
+
+            return ((pmReleaseFetch(lFetchHandle) == pmSuccess) && lStatus);
+        }
+
+        case FETCH_RANGES_ASYNC_EARLY_RELEASE:
+        {
+            pmFetchHandle lFetchHandle;
+
+            if(pmFetchMemoryRangesAsync(pMemHandle, &pRanges[0], (uint)pRanges.size(), &lFetchHandle) != pmSuccess)
+                return false;
+
+            // The released fetch still completes; the blocking one waits for the ranges it finds in flight
+            if(pmReleaseFetch(lFetchHandle) != pmSuccess)
+                return false;
+
+            return (pmFetchMemoryRanges(pMemHandle, &pRanges[0], (uint)pRanges.size()) == pmSuccess);
+        }
+
+        default:
+            exit(1);
+    }
+}
+
+// Returns the fetch time; -1 on error or if a fetched range differs from the one fetched in the first mode
+double parallelRangeFetch(size_t pMemLength, unsigned long pSubtaskCount, int pRangeCount, fetchMode pFetchMode, bool pFirstMode, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy, bool pFetchBack)
+{
+    pmMemHandle lOutputMemHandle;
+    CREATE_MEM(pMemLength, lOutputMemHandle);
+
+    if(!parallelWrite(pMemLength, pSubtaskCount, lOutputMemHandle, pCallbackHandle, pSchedulingPolicy))
+    {
+        pmReleaseMemory(lOutputMemHandle);
+        return (double)-1.0;
+    }
+
+    std::vector<pmSubscriptionInfo> lRanges;
+    getRanges(pMemLength, pRangeCount, lRanges);
+
+    double lStartTime = getCurrentTimeInSecs();
+
+    if(!parallelFetch(lOutputMemHandle, lRanges, pFetchMode))
+    {
+        std::cout << "Fetch mode " << pFetchMode << " failed" << std::endl;
+        pmReleaseMemory(lOutputMemHandle);
+
+        return (double)-1.0;
+    }
+
+    double lTime = getCurrentTimeInSecs() - lStartTime;
+
+    if(pFetchBack)
+    {
+        pmRawMemPtr lRawOutputPtr;
+        pmGetRawMemPtr(lOutputMemHandle, &lRawOutputPtr);
+
+        if(pFirstMode)
+            memset(gParallelOutput, 0, pMemLength);
+
+        for(size_t i = 0; i < lRanges.size(); ++i)
+        {
+            unsigned char* lSrc = (unsigned char*)lRawOutputPtr + lRanges[i].offset;
+            unsigned char* lDest = gParallelOutput + lRanges[i].offset;
+
+            if(!pFirstMode && memcmp(lDest, lSrc, lRanges[i].length))
+            {
+                std::cout << "Fetch mode " << pFetchMode << " mismatches range " << i << " fetched by the first mode" << std::endl;
+                pmReleaseMemory(lOutputMemHandle);
+
+                return (double)-1.0;
+            }
+
+            memcpy(lDest, lSrc, lRanges[i].length);
+        }
+    }
+
+    pmReleaseMemory(lOutputMemHandle);
+
+    return lTime;
+}
+
+#define READ_NON_COMMON_ARGS \
+    int lPowBytes = DEFAULT_POW_BYTES; \
+    int lSubtaskCount = DEFAULT_SUBTASK_COUNT; \
+    int lRangeCount = DEFAULT_RANGE_COUNT; \
+    int lFetchMode = DEFAULT_FETCH_MODE; \
+    FETCH_INT_ARG(lPowBytes, pCommonArgs, argc, argv); \
+    FETCH_INT_ARG(lSubtaskCount, pCommonArgs + 1, argc, argv); \
+    FETCH_INT_ARG(lRangeCount, pCommonArgs + 2, argc, argv); \
+    FETCH_INT_ARG(lFetchMode, pCommonArgs + 3, argc, argv); \
+    size_t lMemLength = ((size_t)1 << lPowBytes);
+
+// Returns execution time on success; 0 on error
+double DoSerialProcess(int argc, char** argv, int pCommonArgs)
+{
+    READ_NON_COMMON_ARGS
+
+    std::vector<pmSubscriptionInfo> lRanges;
+    getRanges(lMemLength, lRangeCount, lRanges);
+
+    double lStartTime = getCurrentTimeInSecs();
+
+    serialRangeFetch(gSerialOutput, lMemLength, lRanges);
+
+    double lEndTime = getCurrentTimeInSecs();
+
+    return (lEndTime - lStartTime);
+}
+
+// Returns execution time on success; 0 on error
+double DoSingleGpuProcess(int argc, char** argv, int pCommonArgs)
+{
+    return 0;
+}
+
+// Returns execution time on success; 0 on error
+double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandle* pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy, bool pFetchBack)
+{
+    READ_NON_COMMON_ARGS
+
+    double lTime = 0;
+    bool lFirstMode = true;
+
+    for(int lMode = 0; lMode < MAX_FETCH_MODES; ++lMode)
+    {
+        if(lFetchMode != lMode && lFetchMode != MAX_FETCH_MODES)
+            continue;
+
+        double lModeTime = parallelRangeFetch(lMemLength, (unsigned long)lSubtaskCount, lRangeCount, (fetchMode)lMode, lFirstMode, pCallbackHandle[0], pSchedulingPolicy, pFetchBack);
+
+        if(lModeTime < 0)
+            return lModeTime;
+
+        std::cout << "Fetch mode " << lMode << " fetched " << lRangeCount << " ranges in " << lModeTime << " secs" << std::endl;
+
+        lTime += lModeTime;
+        lFirstMode = false;
+    }
+
+    return lTime;
+}
+
+pmCallbacks DoSetDefaultCallbacks()
+{
+    pmCallbacks lCallbacks;
+
+    lCallbacks.dataDistribution = rangeFetchDataDistribution;
+    lCallbacks.deviceSelection = NULL;
+    lCallbacks.subtask_cpu = rangeFetch_cpu;
+
+    return lCallbacks;
+}
+
+// Returns 0 on success; non-zero on failure
+int DoInit(int argc, char** argv, int pCommonArgs)
+{
+    READ_NON_COMMON_ARGS
+
+    if(lPowBytes < 1 || lSubtaskCount < 1 || lRangeCount < 1 || lFetchMode < 0 || lFetchMode > MAX_FETCH_MODES)
+    {
+        std::cout << "Invalid memory size, subtask count, range count or fetch mode" << std::endl;
+        exit(1);
+    }
+
+    gSerialOutput = new unsigned char[lMemLength];
+    gParallelOutput = new unsigned char[lMemLength];
+
+    return 0;
+}
+
+// Returns 0 on success; non-zero on failure
+int DoDestroy()
+{
+    delete[] gSerialOutput;
+    delete[] gParallelOutput;
+
+    return 0;
+}
+
+// Returns 0 if serial and parallel executions have produced same result; non-zero otherwise
+int DoCompare(int argc, char** argv, int pCommonArgs)
+{
+    READ_NON_COMMON_ARGS
+
+    for(size_t i = 0; i < lMemLength; ++i)
+    {
+        if(gSerialOutput[i] != gParallelOutput[i])
+        {
+            std::cout << "Mismatch index " << i << " Serial Value = " << (uint)gSerialOutput[i] << " Parallel Value = " << (uint)gParallelOutput[i] << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**    Non-common args
+ *    1. log 2 (address space size in bytes)
+ *    2. no. of subtasks writing the address space
+ *    3. no. of ranges fetched
+ *    4. fetch mode (fetchMode; MAX_FETCH_MODES runs all of them in turn)
+ */
+int main(int argc, char** argv)
+{
+    callbackStruct lStruct[1] = { {DoSetDefaultCallbacks, "RANGEFETCH"} };
+
+    commonStart(argc, argv, DoInit, DoSerialProcess, DoSingleGpuProcess, DoParallelProcess, DoCompare, DoDestroy, lStruct, 1);
+
+    commonFinish();
+
+    return 0;
+}
+
+}
@@ -0,0 +1,350 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/* Measures the throughput of pmlib's inbuilt subtask reductions. Every subtask produces a full length vector which is then reduced
+ * (within and across hosts) using pmGetSubtaskReductionCallbackImpl for the chosen operation. PMLIB_REDUCTION_ISA may be set to
+ * compare the reduction kernels compiled for different instruction sets. Operation USER_REDUCTION_OP runs the same addition as
+ * a user defined reduction operator.
+ */
+
+#include <string.h>
+
+#include "commonAPI.h"
+#include "reductionBandwidth.h"
+
+namespace reductionBandwidth
+{
+
+REDUCTION_DATA_TYPE* gSerialOutput;
+REDUCTION_DATA_TYPE* gParallelOutput;
+
+void userReduceAdd(void* pInOut, const void* pIn, unsigned long pCount)
+{
+    REDUCTION_DATA_TYPE* lInOut = (REDUCTION_DATA_TYPE*)pInOut;
+    const REDUCTION_DATA_TYPE* lIn = (const REDUCTION_DATA_TYPE*)pIn;
+
+    for(unsigned long i = 0; i < pCount; ++i)
+        lInOut[i] += lIn[i];
+}
+
+pmReductionOpType getElementwiseOp(int pReductionOp)
+{
+    return ((pReductionOp == USER_REDUCTION_OP) ? REDUCE_ADD : (pmReductionOpType)pReductionOp);
+}
+
+/* Small values (including sentinel zeros) keep products and sums deterministic irrespective of reduction order.
+ * Logical xor is only associative over zero/one inputs. */
+REDUCTION_DATA_TYPE getElemValue(unsigned long pSubtaskId, size_t pElemIndex, pmReductionOpType pReductionOp)
+{
+    unsigned int lHash = (unsigned int)(((pSubtaskId + 1) * 2654435761u) ^ (pElemIndex * 40503u));
+    lHash ^= (lHash >> 15);
+
+    return (REDUCTION_DATA_TYPE)((pReductionOp == REDUCE_LOGICAL_XOR) ? (lHash & 0x1) : (lHash & 0x7));
+}
+
+void fillSubtaskVector(REDUCTION_DATA_TYPE* pVector, size_t pElemCount, unsigned long pSubtaskId, pmReductionOpType pReductionOp)
+{
+    for(size_t i = 0; i < pElemCount; ++i)
+        pVector[i] = getElemValue(pSubtaskId, i, pReductionOp);
+}
+
+REDUCTION_DATA_TYPE serialReduceElems(REDUCTION_DATA_TYPE pVal1, REDUCTION_DATA_TYPE pVal2, pmReductionOpType pReductionOp)
+{
+    switch(pReductionOp)
+    {
+        case REDUCE_ADD:
+            return pVal1 + pVal2;
+
+        case REDUCE_MIN:
+            return std::min(pVal1, pVal2);
+
+        case REDUCE_MAX:
+            return std::max(pVal1, pVal2);
+
+        case REDUCE_PRODUCT:
+            return pVal1 * pVal2;
+
+        case REDUCE_LOGICAL_AND:
+            return (pVal1 && pVal2);
+
+        case REDUCE_BITWISE_AND:
+            return (pVal1 & pVal2);
+
+        case REDUCE_LOGICAL_OR:
+            return (pVal1 || pVal2);
+
+        case REDUCE_BITWISE_OR:
+            return (pVal1 | pVal2);
+
+        case REDUCE_LOGICAL_XOR:
+            return (pVal1 != pVal2);
+
+        case REDUCE_BITWISE_XOR:
+            return (pVal1 ^ pVal2);
+
+        default:
+            exit(1);
+    }
+}
+
+void serialReductionBandwidth(REDUCTION_DATA_TYPE* pOutput, size_t pElemCount, unsigned long pSubtaskCount, pmReductionOpType pReductionOp)
+{
+    REDUCTION_DATA_TYPE* lVector = new REDUCTION_DATA_TYPE[pElemCount];
+
+    fillSubtaskVector(pOutput, pElemCount, 0, pReductionOp);
+
+    for(unsigned long lSubtask = 1; lSubtask < pSubtaskCount; ++lSubtask)
+    {
+        fillSubtaskVector(lVector, pElemCount, lSubtask, pReductionOp);
+
+        for(size_t i = 0; i < pElemCount; ++i)
+            pOutput[i] = serialReduceElems(pOutput[i], lVector[i], pReductionOp);
+    }
+
+    delete[] lVector;
+}
+
+pmStatus reductionBandwidthDataDistribution(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+	reductionBandwidthTaskConf* lTaskConf = (reductionBandwidthTaskConf*)(pTaskInfo.taskConf);
+
+	// Subscribe to entire output vector
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, OUTPUT_MEM_INDEX, WRITE_SUBSCRIPTION, pmSubscriptionInfo(0, lTaskConf->elemCount * sizeof(REDUCTION_DATA_TYPE)));
+
+	return pmSuccess;
+}
+
+pmStatus reductionBandwidth_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+	reductionBandwidthTaskConf* lTaskConf = (reductionBandwidthTaskConf*)(pTaskInfo.taskConf);
+
+    fillSubtaskVector((REDUCTION_DATA_TYPE*)pSubtaskInfo.memInfo[OUTPUT_MEM_INDEX].ptr, lTaskConf->elemCount, pSubtaskInfo.subtaskId, lTaskConf->reductionOp);
+
+	return pmSuccess;
+}
+
+double parallelReductionBandwidth(size_t pElemCount, unsigned long pSubtaskCount, pmReductionOpType pReductionOp, pmMemHandle pOutputMemHandle, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy)
+{
+	CREATE_TASK(pSubtaskCount, pCallbackHandle, pSchedulingPolicy)
+
+    pmTaskMem lTaskMem[MAX_MEM_INDICES];
+    lTaskMem[OUTPUT_MEM_INDEX] = {pOutputMemHandle, WRITE_ONLY, SUBSCRIPTION_NATURAL};
+
+    lTaskDetails.taskMem = (pmTaskMem*)lTaskMem;
+    lTaskDetails.taskMemCount = MAX_MEM_INDICES;
+
+	reductionBandwidthTaskConf lTaskConf;
+	lTaskConf.elemCount = pElemCount;
+    lTaskConf.reductionOp = pReductionOp;
+
+	lTaskDetails.taskConf = (void*)(&lTaskConf);
+	lTaskDetails.taskConfLength = sizeof(lTaskConf);
+
+	double lStartTime = getCurrentTimeInSecs();
+
+	SAFE_PM_EXEC( pmSubmitTask(lTaskDetails, &lTaskHandle) );
+	
+    if(pmWaitForTaskCompletion(lTaskHandle) != pmSuccess)
+    {
+        FREE_TASK_AND_RESOURCES
+        return (double)-1.0;
+    }
+    
+	double lEndTime = getCurrentTimeInSecs();
+
+    pmReleaseTask(lTaskHandle);
+
+    return (lEndTime - lStartTime);
+}
+
+#define READ_NON_COMMON_ARGS \
+    int lPowElems = DEFAULT_POW_ELEMS; \
+    int lSubtaskCount = DEFAULT_SUBTASK_COUNT; \
+    int lReductionOp = DEFAULT_REDUCTION_OP; \
+    FETCH_INT_ARG(lPowElems, pCommonArgs, argc, argv); \
+    FETCH_INT_ARG(lSubtaskCount, pCommonArgs + 1, argc, argv); \
+    FETCH_INT_ARG(lReductionOp, pCommonArgs + 2, argc, argv); \
+    size_t lElemCount = ((size_t)1 << lPowElems);
+
+// Returns execution time on success; 0 on error
+double DoSerialProcess(int argc, char** argv, int pCommonArgs)
+{
+	READ_NON_COMMON_ARGS
+
+	double lStartTime = getCurrentTimeInSecs();
+
+	serialReductionBandwidth(gSerialOutput, lElemCount, (unsigned long)lSubtaskCount, getElementwiseOp(lReductionOp));
+
+	double lEndTime = getCurrentTimeInSecs();
+
+	return (lEndTime - lStartTime);
+}
+
+// Returns execution time on success; 0 on error
+double DoSingleGpuProcess(int argc, char** argv, int pCommonArgs)
+{
+    return 0;
+}
+
+// Returns execution time on success; 0 on error
+double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandle* pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy, bool pFetchBack)
+{
+	READ_NON_COMMON_ARGS
+
+	// Output Mem contains the reduced vector
+	// Number of subtasks is user specified; each one contributes a full vector to the reduction
+	pmMemHandle lOutputMemHandle;
+    size_t lMemSize = lElemCount * sizeof(REDUCTION_DATA_TYPE);
+
+	CREATE_MEM(lMemSize, lOutputMemHandle);
+
+    double lTime = parallelReductionBandwidth(lElemCount, (unsigned long)lSubtaskCount, getElementwiseOp(lReductionOp), lOutputMemHandle, pCallbackHandle[lReductionOp], pSchedulingPolicy);
+
+    if(lTime > 0)
+        std::cout << "Reduced " << (lSubtaskCount - 1) * lMemSize << " bytes at " << ((lSubtaskCount - 1) * lMemSize) / (lTime * 1024 * 1024 * 1024) << " GB/s" << std::endl;
+
+    if(lTime != -1.0 && pFetchBack)
+    {
+        SAFE_PM_EXEC( pmFetchMemory(lOutputMemHandle) );
+
+        pmRawMemPtr lRawOutputPtr;
+        pmGetRawMemPtr(lOutputMemHandle, &lRawOutputPtr);
+
+        memcpy(gParallelOutput, lRawOutputPtr, lMemSize);
+    }
+
+    pmReleaseMemory(lOutputMemHandle);
+
+	return lTime;
+}
+
+template<pmReductionOpType pReductionOp>
+pmCallbacks DoSetDefaultCallbacks()
+{
+	pmCallbacks lCallbacks;
+
+	lCallbacks.dataDistribution = reductionBandwidthDataDistribution;
+	lCallbacks.deviceSelection = NULL;
+	lCallbacks.subtask_cpu = reductionBandwidth_cpu;
+    lCallbacks.dataReduction = pmGetSubtaskReductionCallbackImpl(pReductionOp, REDUCTION_PM_DATA_TYPE);
+
+	return lCallbacks;
+}
+
+pmCallbacks DoSetUserCallbacks()
+{
+	pmCallbacks lCallbacks;
+    pmReductionOpHandle lReductionOpHandle;
+
+    SAFE_PM_EXEC( pmRegisterReductionOperation("REDUCTIONBANDWIDTH_USER_ADD", pmReductionOperation(sizeof(REDUCTION_DATA_TYPE), userReduceAdd, true, true), &lReductionOpHandle) );
+
+	lCallbacks.dataDistribution = reductionBandwidthDataDistribution;
+	lCallbacks.deviceSelection = NULL;
+	lCallbacks.subtask_cpu = reductionBandwidth_cpu;
+    lCallbacks.dataReduction = pmGetSubtaskReductionCallbackImpl(lReductionOpHandle);
+
+	return lCallbacks;
+}
+
+// Returns 0 on success; non-zero on failure
+int DoInit(int argc, char** argv, int pCommonArgs)
+{
+	READ_NON_COMMON_ARGS
+
+    if(lSubtaskCount < 1 || lReductionOp < 0 || lReductionOp > USER_REDUCTION_OP)
+    {
+        std::cout << "Invalid subtask count or reduction operation" << std::endl;
+        exit(1);
+    }
+
+	gSerialOutput = new REDUCTION_DATA_TYPE[lElemCount];
+	gParallelOutput = new REDUCTION_DATA_TYPE[lElemCount];
+
+	return 0;
+}
+
+// Returns 0 on success; non-zero on failure
+int DoDestroy()
+{
+	delete[] gSerialOutput;
+	delete[] gParallelOutput;
+
+	return 0;
+}
+
+// Returns 0 if serial and parallel executions have produced same result; non-zero otherwise
+int DoCompare(int argc, char** argv, int pCommonArgs)
+{
+	READ_NON_COMMON_ARGS
+
+	for(size_t i = 0; i < lElemCount; ++i)
+	{
+		if(gSerialOutput[i] != gParallelOutput[i])
+		{
+			std::cout << "Mismatch index " << i << " Serial Value = " << gSerialOutput[i] << " Parallel Value = " << gParallelOutput[i] << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**	Non-common args
+ *	1. log 2 (no. of elements in the reduced vector)
+ *	2. no. of subtasks (vectors reduced)
+ *	3. reduction operation (pmReductionOpType or USER_REDUCTION_OP)
+ */
+int main(int argc, char** argv)
+{
+    callbackStruct lStruct[USER_REDUCTION_OP + 1] = {
+        {DoSetDefaultCallbacks<REDUCE_ADD>, "REDUCTIONBANDWIDTH_ADD"},
+        {DoSetDefaultCallbacks<REDUCE_MIN>, "REDUCTIONBANDWIDTH_MIN"},
+        {DoSetDefaultCallbacks<REDUCE_MAX>, "REDUCTIONBANDWIDTH_MAX"},
+        {DoSetDefaultCallbacks<REDUCE_PRODUCT>, "REDUCTIONBANDWIDTH_PRODUCT"},
+        {DoSetDefaultCallbacks<REDUCE_LOGICAL_AND>, "REDUCTIONBANDWIDTH_LOGICAL_AND"},
+        {DoSetDefaultCallbacks<REDUCE_BITWISE_AND>, "REDUCTIONBANDWIDTH_BITWISE_AND"},
+        {DoSetDefaultCallbacks<REDUCE_LOGICAL_OR>, "REDUCTIONBANDWIDTH_LOGICAL_OR"},
+        {DoSetDefaultCallbacks<REDUCE_BITWISE_OR>, "REDUCTIONBANDWIDTH_BITWISE_OR"},
+        {DoSetDefaultCallbacks<REDUCE_LOGICAL_XOR>, "REDUCTIONBANDWIDTH_LOGICAL_XOR"},
+        {DoSetDefaultCallbacks<REDUCE_BITWISE_XOR>, "REDUCTIONBANDWIDTH_BITWISE_XOR"},
+        {DoSetUserCallbacks, "REDUCTIONBANDWIDTH_USER_ADD"}
+    };
+
+	commonStart(argc, argv, DoInit, DoSerialProcess, DoSingleGpuProcess, DoParallelProcess, DoCompare, DoDestroy, lStruct, USER_REDUCTION_OP + 1);
+
+	commonFinish();
+
+	return 0;
+}
+
+}
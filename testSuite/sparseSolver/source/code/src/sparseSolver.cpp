@@ -355,7 +355,8 @@ double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandl
 
     pmTaskMem lTaskMem[MAX_MEM_INDICES];
     lTaskMem[INPUT_MATRIX1_MEM_INDEX] = {lInputMem1, READ_ONLY, SUBSCRIPTION_OPTIMAL};
-    lTaskMem[INPUT_MATRIX2_MEM_INDEX] = {lInputMem2, READ_ONLY, SUBSCRIPTION_OPTIMAL};
+    // Subtasks only touch the rows of the second matrix that match their non zero columns, so it may be demand paged
+    lTaskMem[INPUT_MATRIX2_MEM_INDEX] = {lInputMem2, (isLazyMemEnabled() ? READ_ONLY_LAZY : READ_ONLY), SUBSCRIPTION_OPTIMAL};
     lTaskMem[INPUT_ROW_INDICES1_MEM_INDEX] = {lInputMemRowIndices1, READ_ONLY, SUBSCRIPTION_OPTIMAL};
     lTaskMem[INPUT_COL_INDICES1_MEM_INDEX] = {lInputMemColIndices1, READ_ONLY, SUBSCRIPTION_OPTIMAL};
     lTaskMem[INPUT_MEM_NNZ1_INDEX] = {lInputMemNnz1, READ_ONLY, SUBSCRIPTION_OPTIMAL};
@@ -0,0 +1,84 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+namespace taskGraph
+{
+
+#define DEFAULT_SUBTASK_COUNT 8
+#define DEFAULT_SUBTASK_WORK 200000
+#define DEFAULT_SUBMISSION_MODE MAX_SUBMISSION_MODES
+
+#define MAX_PREREQUISITES 2
+
+using namespace pm;
+
+/* Two graphs are submitted together - a chain (0 -> 1 -> 2 -> 3) and a diamond (4 -> 5, 4 -> 6, 5 -> 7, 6 -> 7) */
+enum graphTask
+{
+    CHAIN_TASK_0 = 0,
+    CHAIN_TASK_1,
+    CHAIN_TASK_2,
+    CHAIN_TASK_3,
+    DIAMOND_TOP,
+    DIAMOND_LEFT,
+    DIAMOND_RIGHT,
+    DIAMOND_BOTTOM,
+    TASK_COUNT
+};
+
+enum submissionMode
+{
+    GRAPH_DERIVED_DEPENDENCIES = 0,     // pmSubmitTaskGraph; every task reads the outputs of its prerequisites
+    GRAPH_EXPLICIT_DEPENDENCIES,        // pmSubmitTaskGraph; tasks share no address space and dependencies are explicit
+    SUBMIT_AFTER,                       // pmSubmitTaskAfter; tasks share no address space
+    MAX_SUBMISSION_MODES                // All of the above in turn
+};
+
+/* Written by every subtask into its task's output address space. Ticks come from a per host counter and order
+ * the subtasks executed on a host. */
+typedef struct subtaskRecord
+{
+    unsigned int host;
+    unsigned long startTick;
+    unsigned long endTick;
+    unsigned long value;
+} subtaskRecord;
+
+typedef struct taskGraphTaskConf
+{
+    unsigned int taskIndex;
+    unsigned int inputCount;    // Prerequisites whose outputs are read (address spaces 0 to inputCount - 1)
+    unsigned long work;
+} taskGraphTaskConf;
+
+}
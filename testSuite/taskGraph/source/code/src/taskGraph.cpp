@@ -0,0 +1,404 @@
+
+/*
+ * Copyright (c) 2016, Tarun Beri, Sorav Bansal, Subodh Kumar
+ * Copyright (c) 2016 Indian Institute of Technology Delhi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. Any redistribution or
+ * modification must retain this copyright notice and appropriately
+ * highlight the credits.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * More information about the authors is available at their websites -
+ * Prof. Subodh Kumar - http://www.cse.iitd.ernet.in/~subodh/
+ * Prof. Sorav Bansal - http://www.cse.iitd.ernet.in/~sbansal/
+ * Tarun Beri - http://www.cse.iitd.ernet.in/~tarun
+ *
+ * All bug reports and enhancement requests can be sent to the following
+ * email addresses -
+ * onlinetarun@gmail.com
+ * sbansal@cse.iitd.ac.in
+ * subodh@cse.iitd.ac.in
+ */
+
+/* Checks the ordering of tasks submitted with pmSubmitTaskGraph and pmSubmitTaskAfter. A chain and a diamond of tasks are
+ * submitted together without waiting in between. Every subtask records the host it ran on and the ticks of a per host counter
+ * at its start and end. Once all tasks finish, no subtask of a task may have started on any host before a subtask of one of
+ * its prerequisites finished there. In GRAPH_DERIVED_DEPENDENCIES mode the dependencies come from the address spaces (every
+ * task reads the outputs of its prerequisites, whose values are checked); in the other modes the tasks share no address space
+ * and only the explicit dependencies order them.
+ */
+
+#include <string.h>
+#include <atomic>
+#include <vector>
+
+#include "commonAPI.h"
+#include "taskGraph.h"
+
+namespace taskGraph
+{
+
+const unsigned int gDependencies[][2] = {
+    {CHAIN_TASK_0, CHAIN_TASK_1}, {CHAIN_TASK_1, CHAIN_TASK_2}, {CHAIN_TASK_2, CHAIN_TASK_3},
+    {DIAMOND_TOP, DIAMOND_LEFT}, {DIAMOND_TOP, DIAMOND_RIGHT}, {DIAMOND_LEFT, DIAMOND_BOTTOM}, {DIAMOND_RIGHT, DIAMOND_BOTTOM}
+};
+
+const unsigned int gDependencyCount = sizeof(gDependencies) / sizeof(gDependencies[0]);
+
+std::atomic<unsigned long> gTick(0);
+
+unsigned long* gSerialOutput;
+unsigned long* gParallelOutput;
+
+unsigned long getTaskValue(unsigned int pTaskIndex)
+{
+    return (unsigned long)pTaskIndex + 1;
+}
+
+std::vector<unsigned int> getPrerequisites(unsigned int pTaskIndex)
+{
+    std::vector<unsigned int> lPrerequisites;
+
+    for(unsigned int i = 0; i < gDependencyCount; ++i)
+    {
+        if(gDependencies[i][1] == pTaskIndex)
+            lPrerequisites.push_back(gDependencies[i][0]);
+    }
+
+    return lPrerequisites;
+}
+
+void serialTaskGraph(unsigned long* pOutput, unsigned long pSubtaskCount)
+{
+    for(unsigned int i = 0; i < TASK_COUNT; ++i)
+    {
+        for(unsigned long j = 0; j < pSubtaskCount; ++j)
+            pOutput[i * pSubtaskCount + j] = getTaskValue(i);
+    }
+}
+
+pmStatus taskGraphDataDistribution(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    taskGraphTaskConf* lTaskConf = (taskGraphTaskConf*)(pTaskInfo.taskConf);
+    pmSubscriptionInfo lSubscriptionInfo(pSubtaskInfo.subtaskId * sizeof(subtaskRecord), sizeof(subtaskRecord));
+
+    for(unsigned int i = 0; i < lTaskConf->inputCount; ++i)
+        pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, i, READ_SUBSCRIPTION, lSubscriptionInfo);
+
+    pmSubscribeToMemory(pTaskInfo.taskHandle, pDeviceInfo.deviceHandle, pSubtaskInfo.subtaskId, pSubtaskInfo.splitInfo, lTaskConf->inputCount, WRITE_SUBSCRIPTION, lSubscriptionInfo);
+
+    return pmSuccess;
+}
+
+pmStatus taskGraph_cpu(pmTaskInfo pTaskInfo, pmDeviceInfo pDeviceInfo, pmSubtaskInfo pSubtaskInfo)
+{
+    taskGraphTaskConf* lTaskConf = (taskGraphTaskConf*)(pTaskInfo.taskConf);
+    subtaskRecord* lRecord = (subtaskRecord*)pSubtaskInfo.memInfo[lTaskConf->inputCount].ptr;
+
+    lRecord->host = pDeviceInfo.host;
+    lRecord->startTick = ++gTick;
+    lRecord->value = getTaskValue(lTaskConf->taskIndex);
+
+    // The prerequisites (in the order of gDependencies) must have written their records
+    std::vector<unsigned int> lPrerequisites = getPrerequisites(lTaskConf->taskIndex);
+    for(unsigned int i = 0; i < lTaskConf->inputCount; ++i)
+    {
+        if(((subtaskRecord*)pSubtaskInfo.memInfo[i].ptr)->value != getTaskValue(lPrerequisites[i]))
+            lRecord->value = 0;
+    }
+
+    // Keeps the subtask busy long enough for unordered tasks to overlap
+    volatile unsigned long lSum = 0;
+    for(unsigned long i = 0; i < lTaskConf->work; ++i)
+        lSum += i;
+
+    lRecord->endTick = ++gTick;
+
+    return pmSuccess;
+}
+
+// Returns false if a subtask of a task started on some host before a subtask of one of its prerequisites finished there
+bool checkOrdering(const std::vector<subtaskRecord>* pRecords, unsigned long pSubtaskCount)
+{
+    for(unsigned int i = 0; i < gDependencyCount; ++i)
+    {
+        const std::vector<subtaskRecord>& lPrerequisite = pRecords[gDependencies[i][0]];
+        const std::vector<subtaskRecord>& lDependent = pRecords[gDependencies[i][1]];
+
+        for(unsigned long j = 0; j < pSubtaskCount; ++j)
+        {
+            for(unsigned long k = 0; k < pSubtaskCount; ++k)
+            {
+                if(lPrerequisite[j].host == lDependent[k].host && lDependent[k].startTick < lPrerequisite[j].endTick)
+                {
+                    std::cout << "Subtask " << k << " of task " << gDependencies[i][1] << " started on host " << lDependent[k].host << " before subtask " << j << " of its prerequisite task " << gDependencies[i][0] << " finished" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+pmTaskDetails getTaskDetails(unsigned long pSubtaskCount, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy)
+{
+    CREATE_TASK(pSubtaskCount, pCallbackHandle, pSchedulingPolicy)
+
+    return lTaskDetails;
+}
+
+// Returns the time taken by the tasks; -1 if any of them fails or violates the ordering
+double parallelTaskGraph(unsigned long pSubtaskCount, unsigned long pWork, submissionMode pSubmissionMode, pmCallbackHandle pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy, bool pFetchBack)
+{
+    pmMemHandle lOutputMemHandles[TASK_COUNT];
+    pmTaskMem lTaskMem[TASK_COUNT][MAX_PREREQUISITES + 1];
+    taskGraphTaskConf lTaskConf[TASK_COUNT];
+    pmTaskDetails lTaskDetails[TASK_COUNT];
+    pmTaskHandle lTaskHandles[TASK_COUNT];
+
+    for(unsigned int i = 0; i < TASK_COUNT; ++i)
+        CREATE_MEM(pSubtaskCount * sizeof(subtaskRecord), lOutputMemHandles[i]);
+
+    for(unsigned int i = 0; i < TASK_COUNT; ++i)
+    {
+        lTaskConf[i].taskIndex = i;
+        lTaskConf[i].inputCount = 0;
+        lTaskConf[i].work = pWork;
+
+        if(pSubmissionMode == GRAPH_DERIVED_DEPENDENCIES)
+        {
+            std::vector<unsigned int> lPrerequisites = getPrerequisites(i);
+
+            for(size_t j = 0; j < lPrerequisites.size(); ++j)
+                lTaskMem[i][lTaskConf[i].inputCount++] = pmTaskMem(lOutputMemHandles[lPrerequisites[j]], READ_ONLY, SUBSCRIPTION_NATURAL);
+        }
+
+        lTaskMem[i][lTaskConf[i].inputCount] = pmTaskMem(lOutputMemHandles[i], WRITE_ONLY, SUBSCRIPTION_NATURAL);
+
+        lTaskDetails[i] = getTaskDetails(pSubtaskCount, pCallbackHandle, pSchedulingPolicy);
+        lTaskDetails[i].taskMem = lTaskMem[i];
+        lTaskDetails[i].taskMemCount = lTaskConf[i].inputCount + 1;
+        lTaskDetails[i].taskConf = (void*)(&lTaskConf[i]);
+        lTaskDetails[i].taskConfLength = sizeof(taskGraphTaskConf);
+    }
+
+    double lStartTime = getCurrentTimeInSecs();
+
+    switch(pSubmissionMode)
+    {
+        case GRAPH_DERIVED_DEPENDENCIES:
+            SAFE_PM_EXEC( pmSubmitTaskGraph(lTaskDetails, TASK_COUNT, NULL, 0, lTaskHandles) );
+            break;
+
+        case GRAPH_EXPLICIT_DEPENDENCIES:
+        {
+            std::vector<pmTaskDependency> lDependencies;
+
+            for(unsigned int i = 0; i < gDependencyCount; ++i)
+                lDependencies.push_back(pmTaskDependency(gDependencies[i][0], gDependencies[i][1]));
+
+            SAFE_PM_EXEC( pmSubmitTaskGraph(lTaskDetails, TASK_COUNT, &lDependencies[0], (uint)lDependencies.size(), lTaskHandles) );
+            break;
+        }
+
+        case SUBMIT_AFTER:
+        {
+            for(unsigned int i = 0; i < TASK_COUNT; ++i)
+            {
+                std::vector<unsigned int> lPrerequisites = getPrerequisites(i);
+                std::vector<pmTaskHandle> lPrerequisiteHandles;
+
+                for(size_t j = 0; j < lPrerequisites.size(); ++j)
+                    lPrerequisiteHandles.push_back(lTaskHandles[lPrerequisites[j]]);
+
+                SAFE_PM_EXEC( pmSubmitTaskAfter(lTaskDetails[i], (lPrerequisiteHandles.empty() ? NULL : &lPrerequisiteHandles[0]), (uint)lPrerequisiteHandles.size(), &lTaskHandles[i]) );
+            }
+
+            break;
+        }
+
+        default:
+            exit(1);
+    }
+
+    bool lFailed = false;
+    for(unsigned int i = 0; i < TASK_COUNT; ++i)
+    {
+        if(pmWaitForTaskCompletion(lTaskHandles[i]) != pmSuccess)
+            lFailed = true;
+    }
+
+    double lEndTime = getCurrentTimeInSecs();
+
+    for(unsigned int i = 0; i < TASK_COUNT; ++i)
+        pmReleaseTask(lTaskHandles[i]);
+
+    std::vector<subtaskRecord> lRecords[TASK_COUNT];
+
+    for(unsigned int i = 0; i < TASK_COUNT && !lFailed; ++i)
+    {
+        SAFE_PM_EXEC( pmFetchMemory(lOutputMemHandles[i]) );
+
+        pmRawMemPtr lRawOutputPtr;
+        pmGetRawMemPtr(lOutputMemHandles[i], &lRawOutputPtr);
+
+        lRecords[i].assign((subtaskRecord*)lRawOutputPtr, (subtaskRecord*)lRawOutputPtr + pSubtaskCount);
+    }
+
+    for(unsigned int i = 0; i < TASK_COUNT; ++i)
+        pmReleaseMemory(lOutputMemHandles[i]);
+
+    if(lFailed || !checkOrdering(lRecords, pSubtaskCount))
+        return (double)-1.0;
+
+    if(pFetchBack)
+    {
+        for(unsigned int i = 0; i < TASK_COUNT; ++i)
+        {
+            for(unsigned long j = 0; j < pSubtaskCount; ++j)
+                gParallelOutput[i * pSubtaskCount + j] = lRecords[i][j].value;
+        }
+    }
+
+    return (lEndTime - lStartTime);
+}
+
+#define READ_NON_COMMON_ARGS \
+    int lSubtaskCount = DEFAULT_SUBTASK_COUNT; \
+    int lWork = DEFAULT_SUBTASK_WORK; \
+    int lSubmissionMode = DEFAULT_SUBMISSION_MODE; \
+    FETCH_INT_ARG(lSubtaskCount, pCommonArgs, argc, argv); \
+    FETCH_INT_ARG(lWork, pCommonArgs + 1, argc, argv); \
+    FETCH_INT_ARG(lSubmissionMode, pCommonArgs + 2, argc, argv);
+
+// Returns execution time on success; 0 on error
+double DoSerialProcess(int argc, char** argv, int pCommonArgs)
+{
+    READ_NON_COMMON_ARGS
+
+    double lStartTime = getCurrentTimeInSecs();
+
+    serialTaskGraph(gSerialOutput, (unsigned long)lSubtaskCount);
+
+    double lEndTime = getCurrentTimeInSecs();
+
+    return (lEndTime - lStartTime);
+}
+
+// Returns execution time on success; 0 on error
+double DoSingleGpuProcess(int argc, char** argv, int pCommonArgs)
+{
+    return 0;
+}
+
+// Returns execution time on success; 0 on error
+double DoParallelProcess(int argc, char** argv, int pCommonArgs, pmCallbackHandle* pCallbackHandle, pmSchedulingPolicy pSchedulingPolicy, bool pFetchBack)
+{
+    READ_NON_COMMON_ARGS
+
+    double lTime = 0;
+
+    for(int lMode = 0; lMode < MAX_SUBMISSION_MODES; ++lMode)
+    {
+        if(lSubmissionMode != lMode && lSubmissionMode != MAX_SUBMISSION_MODES)
+            continue;
+
+        double lModeTime = parallelTaskGraph((unsigned long)lSubtaskCount, (unsigned long)lWork, (submissionMode)lMode, pCallbackHandle[0], pSchedulingPolicy, pFetchBack);
+
+        if(lModeTime < 0)
+        {
+            std::cout << "Submission mode " << lMode << " failed" << std::endl;
+            return lModeTime;
+        }
+
+        std::cout << "Submission mode " << lMode << " ran " << TASK_COUNT << " tasks in " << lModeTime << " secs" << std::endl;
+
+        lTime += lModeTime;
+    }
+
+    return lTime;
+}
+
+pmCallbacks DoSetDefaultCallbacks()
+{
+    pmCallbacks lCallbacks;
+
+    lCallbacks.dataDistribution = taskGraphDataDistribution;
+    lCallbacks.deviceSelection = NULL;
+    lCallbacks.subtask_cpu = taskGraph_cpu;
+
+    return lCallbacks;
+}
+
+// Returns 0 on success; non-zero on failure
+int DoInit(int argc, char** argv, int pCommonArgs)
+{
+    READ_NON_COMMON_ARGS
+
+    if(lSubtaskCount < 1 || lWork < 0 || lSubmissionMode < 0 || lSubmissionMode > MAX_SUBMISSION_MODES)
+    {
+        std::cout << "Invalid subtask count, subtask work or submission mode" << std::endl;
+        exit(1);
+    }
+
+    gSerialOutput = new unsigned long[TASK_COUNT * lSubtaskCount];
+    gParallelOutput = new unsigned long[TASK_COUNT * lSubtaskCount];
+
+    return 0;
+}
+
+// Returns 0 on success; non-zero on failure
+int DoDestroy()
+{
+    delete[] gSerialOutput;
+    delete[] gParallelOutput;
+
+    return 0;
+}
+
+// Returns 0 if serial and parallel executions have produced same result; non-zero otherwise
+int DoCompare(int argc, char** argv, int pCommonArgs)
+{
+    READ_NON_COMMON_ARGS
+
+    for(size_t i = 0; i < (size_t)(TASK_COUNT * lSubtaskCount); ++i)
+    {
+        if(gSerialOutput[i] != gParallelOutput[i])
+        {
+            std::cout << "Mismatch index " << i << " Serial Value = " << gSerialOutput[i] << " Parallel Value = " << gParallelOutput[i] << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**	Non-common args
+ *	1. no. of subtasks per task
+ *	2. busy loop iterations per subtask
+ *	3. submission mode (submissionMode; MAX_SUBMISSION_MODES runs all of them in turn)
+ */
+int main(int argc, char** argv)
+{
+    callbackStruct lStruct[1] = { {DoSetDefaultCallbacks, "TASKGRAPH"} };
+
+    commonStart(argc, argv, DoInit, DoSerialProcess, DoSingleGpuProcess, DoParallelProcess, DoCompare, DoDestroy, lStruct, 1);
+
+    commonFinish();
+
+    return 0;
+}
+
+}